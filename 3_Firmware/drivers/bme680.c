@@ -2,23 +2,287 @@
  * bme680.c — BME680 Driver Implementation
  *
  * NOTE: The BME680 is a complex sensor with a multi-step measurement
- * process. For the real hardware, consider using Bosch's official
- * BSEC library (bme68x) which handles the complex compensation
- * algorithms. This driver provides the interface and baseline tracking.
+ * process. Compensation below is the integer variant from the Bosch
+ * datasheet; the gas resistance is enough for a ratio against the
+ * baseline. For absolute air-quality figures (IAQ), Bosch's BSEC
+ * library is still the reference.
  */
 
 #include "bme680.h"
-#include "../hal/hal_i2c.h"
+#include "../src/hal_i2c.h"
+#include <string.h>
 
-/* Baseline values (set during init, updated periodically) */
-static float gas_baseline_ohm = 50000.0f;      /* Typical clean air value */
-static float pressure_baseline_hpa = 1013.25f; /* Standard atmosphere */
+/* BME680 register addresses (key ones) */
+#define BME680_REG_CHIP_ID 0xD0
+#define BME680_REG_CTRL_HUM 0x72
+#define BME680_REG_CTRL_GAS 0x71
+#define BME680_REG_GAS_WAIT 0x64
+#define BME680_REG_RES_HEAT 0x5A
+#define BME680_REG_COEFF1 0x8A      /* 23 bytes                */
+#define BME680_REG_COEFF2 0xE1      /* 14 bytes                */
+#define BME680_REG_COEFF3 0x00      /* 5 bytes                 */
+#define BME680_CHIP_ID_VALUE 0x61
+
+#define BME680_NEW_DATA 0x80
+#define BME680_GAS_VALID 0x20
+#define BME680_HEAT_STAB 0x10
+#define BME680_RUN_GAS 0x10
+#define BME680_OSRS_H 0x01        /* osrs_h ×1             */
+
+/* -----------------------------------------------------------------------
+ * Compensation (integer, datasheet section 3.3)
+ * ----------------------------------------------------------------------- */
+
+/* Returns t_fine; *temp_cc in 0.01 °C */
+static int32_t comp_temp(const bme680_t *d, uint32_t adc, int32_t *temp_cc) {
+  int32_t var1 = ((int32_t)adc >> 3) - ((int32_t)d->par_t1 << 1);
+  int32_t var2 = (var1 * (int32_t)d->par_t2) >> 11;
+  int32_t var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
+  var3 = (var3 * ((int32_t)d->par_t3 << 4)) >> 14;
+  int32_t t_fine = var2 + var3;
+  *temp_cc = (t_fine * 5 + 128) >> 8;
+  return t_fine;
+}
+
+/* Pa */
+static int32_t comp_pressure(const bme680_t *d, uint32_t adc,
+                             int32_t t_fine) {
+  int32_t var1 = (t_fine >> 1) - 64000;
+  int32_t var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)d->par_p6) >> 2;
+  var2 = var2 + ((var1 * (int32_t)d->par_p5) << 1);
+  var2 = (var2 >> 2) + ((int32_t)d->par_p4 << 16);
+  var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)d->par_p3 << 5)) >>
+          3) +
+         (((int32_t)d->par_p2 * var1) >> 1);
+  var1 = var1 >> 18;
+  var1 = ((32768 + var1) * (int32_t)d->par_p1) >> 15;
+  if (var1 == 0)
+    return 0; /* Blank calibration */
+
+  int32_t p = 1048576 - (int32_t)adc;
+  p = (int32_t)((uint32_t)(p - (var2 >> 12)) * 3125u);
+  if (p >= (1 << 30))
+    p = (p / var1) << 1;
+  else
+    p = (p << 1) / var1;
+  var1 = ((int32_t)d->par_p9 * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+  var2 = ((p >> 2) * (int32_t)d->par_p8) >> 13;
+  int32_t var3 = ((p >> 8) * (p >> 8) * (p >> 8) * (int32_t)d->par_p10) >> 17;
+  return p + ((var1 + var2 + var3 + ((int32_t)d->par_p7 << 7)) >> 4);
+}
+
+/* 0.001 %RH */
+static int32_t comp_humidity(const bme680_t *d, uint16_t adc,
+                             int32_t t_fine) {
+  int32_t ts = (t_fine * 5 + 128) >> 8;
+  int32_t var1 = (int32_t)adc - (int32_t)d->par_h1 * 16 -
+                 (((ts * (int32_t)d->par_h3) / 100) >> 1);
+  int32_t var2 =
+      ((int32_t)d->par_h2 *
+       ((ts * (int32_t)d->par_h4) / 100 +
+        (((ts * ((ts * (int32_t)d->par_h5) / 100)) >> 6) / 100) +
+        (1 << 14))) >>
+      10;
+  int32_t var3 = var1 * var2;
+  int32_t var4 = ((int32_t)d->par_h6 << 7);
+  var4 = (var4 + (ts * (int32_t)d->par_h7) / 100) >> 4;
+  int32_t var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+  int32_t var6 = (var4 * var5) >> 1;
+  int32_t h = (((var3 + var6) >> 10) * 1000) >> 12;
+  if (h > 100000)
+    h = 100000;
+  if (h < 0)
+    h = 0;
+  return h;
+}
+
+/* Ω */
+static uint32_t comp_gas(const bme680_t *d, uint16_t adc, uint8_t range) {
+  static const uint32_t k1[16] = {
+      2147483647u, 2147483647u, 2147483647u, 2147483647u,
+      2147483647u, 2126008810u, 2147483647u, 2130303777u,
+      2147483647u, 2147483647u, 2143188679u, 2136746228u,
+      2147483647u, 2126008810u, 2147483647u, 2147483647u};
+  static const uint32_t k2[16] = {
+      4096000000u, 2048000000u, 1024000000u, 512000000u,
+      255744255u,  127110228u,  64000000u,   32258064u,
+      16016016u,   8000000u,    4000000u,    2000000u,
+      1000000u,    500000u,     250000u,     125000u};
+  int64_t var1 =
+      ((int64_t)(1340 + 5 * (int64_t)d->range_sw_err) * (int64_t)k1[range]) >>
+      16;
+  int64_t var2 = ((int64_t)adc << 15) - 16777216 + var1;
+  int64_t var3 = ((int64_t)k2[range] * var1) >> 9;
+  if (var2 == 0)
+    return 0;
+  return (uint32_t)((var3 + (var2 >> 1)) / var2);
+}
+
+/* res_heat_0 for the target heater temperature at `amb_c` */
+static uint8_t heater_code(const bme680_t *d, int32_t target_c,
+                           int32_t amb_c) {
+  int32_t var1 = ((amb_c * d->par_g3) / 1000) * 256;
+  int32_t var2 = (d->par_g1 + 784) *
+                 (((((d->par_g2 + 154009) * target_c * 5) / 100) + 3276800) /
+                  10);
+  int32_t var3 = var1 + (var2 / 2);
+  int32_t var4 = var3 / (d->res_heat_range + 4);
+  int32_t var5 = 131 * d->res_heat_val + 65536;
+  int32_t res_x100 = ((var4 / var5) - 250) * 34;
+  return (uint8_t)((res_x100 + 50) / 100);
+}
+
+/* gas_wait_0: 6-bit count × 4^factor ms */
+static uint8_t wait_code(uint16_t ms) {
+  if (ms >= 0xFC0)
+    return 0xFF;
+  uint8_t factor = 0;
+  while (ms > 0x3F) {
+    ms /= 4;
+    factor++;
+  }
+  return (uint8_t)(ms + factor * 64);
+}
+
+/* -----------------------------------------------------------------------
+ * Staged access (both modes)
+ * ----------------------------------------------------------------------- */
+static hal_status_t write_reg(const bme680_t *d, uint8_t reg, uint8_t val) {
+  uint8_t buf[2] = {reg, val};
+  return hal_i2c_write(I2C_BUS_DEFAULT, d->addr, buf, 2);
+}
+
+hal_status_t bme680_begin(bme680_t *d, uint8_t addr) {
+  memset(d, 0, sizeof(bme680_t));
+  d->addr = addr;
+
+  uint8_t id = 0;
+  hal_status_t st =
+      hal_i2c_read_reg(I2C_BUS_DEFAULT, addr, BME680_REG_CHIP_ID, &id, 1);
+  if (st != HAL_OK)
+    return st;
+  if (id != BME680_CHIP_ID_VALUE)
+    return HAL_ERROR;
+
+  uint8_t c1[23], c2[14], c3[5];
+  if ((st = hal_i2c_read_reg(I2C_BUS_DEFAULT, addr, BME680_REG_COEFF1, c1,
+                             sizeof(c1))) != HAL_OK ||
+      (st = hal_i2c_read_reg(I2C_BUS_DEFAULT, addr, BME680_REG_COEFF2, c2,
+                             sizeof(c2))) != HAL_OK ||
+      (st = hal_i2c_read_reg(I2C_BUS_DEFAULT, addr, BME680_REG_COEFF3, c3,
+                             sizeof(c3))) != HAL_OK)
+    return st;
+
+  /* c1 starts at 0x8A, c2 at 0xE1, c3 at 0x00 */
+  d->par_t2 = (int16_t)(c1[1] << 8 | c1[0]);
+  d->par_t3 = (int8_t)c1[2];
+  d->par_p1 = (uint16_t)(c1[5] << 8 | c1[4]);
+  d->par_p2 = (int16_t)(c1[7] << 8 | c1[6]);
+  d->par_p3 = (int8_t)c1[8];
+  d->par_p4 = (int16_t)(c1[11] << 8 | c1[10]);
+  d->par_p5 = (int16_t)(c1[13] << 8 | c1[12]);
+  d->par_p7 = (int8_t)c1[14];
+  d->par_p6 = (int8_t)c1[15];
+  d->par_p8 = (int16_t)(c1[19] << 8 | c1[18]);
+  d->par_p9 = (int16_t)(c1[21] << 8 | c1[20]);
+  d->par_p10 = c1[22];
+  d->par_h2 = (uint16_t)(c2[0] << 4 | c2[1] >> 4);
+  d->par_h1 = (uint16_t)(c2[2] << 4 | (c2[1] & 0x0F));
+  d->par_h3 = (int8_t)c2[3];
+  d->par_h4 = (int8_t)c2[4];
+  d->par_h5 = (int8_t)c2[5];
+  d->par_h6 = c2[6];
+  d->par_h7 = (int8_t)c2[7];
+  d->par_t1 = (uint16_t)(c2[9] << 8 | c2[8]);
+  d->par_g2 = (int16_t)(c2[11] << 8 | c2[10]);
+  d->par_g1 = (int8_t)c2[12];
+  d->par_g3 = (int8_t)c2[13];
+  d->res_heat_val = (int8_t)c3[0];
+  d->res_heat_range = (uint8_t)((c3[2] & 0x30) >> 4);
+  d->range_sw_err = (int8_t)((int8_t)c3[4] >> 4);
+
+  /* Heater profile 0; ambient assumed 25 °C until the first reading */
+  if ((st = write_reg(d, BME680_REG_CTRL_HUM, BME680_OSRS_H)) != HAL_OK ||
+      (st = write_reg(d, BME680_REG_RES_HEAT,
+                      heater_code(d, BME680_HEATER_TEMP_C, 25))) != HAL_OK ||
+      (st = write_reg(d, BME680_REG_GAS_WAIT, wait_code(BME680_HEATER_MS))) !=
+          HAL_OK ||
+      (st = write_reg(d, BME680_REG_CTRL_GAS, BME680_RUN_GAS)) != HAL_OK)
+    return st;
+  return write_reg(d, BME680_REG_CTRL_MEAS, BME680_CTRL_MEAS_SLEEP);
+}
+
+hal_status_t bme680_start(bme680_t *d) {
+  return write_reg(d, BME680_REG_CTRL_MEAS, BME680_CTRL_MEAS_FORCED);
+}
+
+void bme680_dev_reset_baseline(bme680_t *d) {
+  d->baseline_n = 0;
+  d->gas_sum = 0.0f;
+  d->pressure_sum = 0.0f;
+}
+
+hal_status_t bme680_collect(bme680_t *d, bme680_reading_t *r) {
+  uint8_t b[BME680_DATA_LEN];
+  hal_status_t st = hal_i2c_read_reg(I2C_BUS_DEFAULT, d->addr,
+                                     BME680_REG_DATA, b, sizeof(b));
+  if (st != HAL_OK)
+    return st;
+  return bme680_decode(d, b, r);
+}
+
+hal_status_t bme680_decode(bme680_t *d, const uint8_t *b,
+                           bme680_reading_t *r) {
+  if (!(b[0] & BME680_NEW_DATA))
+    return HAL_BUSY;
+
+  uint32_t p_adc = (uint32_t)b[2] << 12 | (uint32_t)b[3] << 4 | b[4] >> 4;
+  uint32_t t_adc = (uint32_t)b[5] << 12 | (uint32_t)b[6] << 4 | b[7] >> 4;
+  uint16_t h_adc = (uint16_t)(b[8] << 8 | b[9]);
+  uint16_t g_adc = (uint16_t)(b[13] << 2 | b[14] >> 6);
+
+  int32_t temp_cc;
+  int32_t t_fine = comp_temp(d, t_adc, &temp_cc);
+  r->temperature_c = (float)temp_cc * 0.01f;
+  r->pressure_hpa = (float)comp_pressure(d, p_adc, t_fine) * 0.01f;
+  r->humidity_pct = (float)comp_humidity(d, h_adc, t_fine) * 0.001f;
+
+  /* A gas reading only counts with the heater stable */
+  bool gas_ok = (b[14] & (BME680_GAS_VALID | BME680_HEAT_STAB)) ==
+                (BME680_GAS_VALID | BME680_HEAT_STAB);
+  r->gas_resistance_ohm = gas_ok ? (float)comp_gas(d, g_adc, b[14] & 0x0F)
+                                 : d->gas_baseline_ohm;
+
+  if (d->baseline_n < BME680_BASELINE_SAMPLES) {
+    if (gas_ok) {
+      d->gas_sum += r->gas_resistance_ohm;
+      d->pressure_sum += r->pressure_hpa;
+      if (++d->baseline_n == BME680_BASELINE_SAMPLES) {
+        d->gas_baseline_ohm = d->gas_sum / BME680_BASELINE_SAMPLES;
+        d->pressure_baseline_hpa = d->pressure_sum / BME680_BASELINE_SAMPLES;
+      }
+    }
+    r->gas_ratio = 1.0f;
+    r->pressure_delta_hpa = 0.0f;
+    return HAL_OK;
+  }
+
+  r->gas_ratio = d->gas_baseline_ohm > 0.0f
+                     ? r->gas_resistance_ohm / d->gas_baseline_ohm
+                     : 1.0f;
+  r->pressure_delta_hpa = r->pressure_hpa - d->pressure_baseline_hpa;
+  return HAL_OK;
+}
 
 /* -----------------------------------------------------------------------
  * HOST MODE
  * ----------------------------------------------------------------------- */
 #if HAL_HOST_MODE
 
+/* Baseline values (set during init, updated periodically) */
+static float gas_baseline_ohm = 50000.0f;      /* Typical clean air value */
+static float pressure_baseline_hpa = 1013.25f; /* Standard atmosphere */
+
 static float sim_gas_ratio = 0.98f;
 static float sim_pressure_delta = 0.0f;
 static float sim_temperature = 25.0f;
@@ -51,61 +315,30 @@ void bme680_sim_set(float gas_ratio, float pressure_delta_hpa,
  * ----------------------------------------------------------------------- */
 #else
 
-/* BME680 register addresses (key ones) */
-#define BME680_REG_CHIP_ID 0xD0
-#define BME680_REG_CTRL_MEAS 0x74
-#define BME680_REG_CTRL_HUM 0x72
-#define BME680_REG_CTRL_GAS 0x71
-#define BME680_REG_GAS_WAIT 0x64
-#define BME680_REG_RES_HEAT 0x5A
-#define BME680_CHIP_ID_VALUE 0x61
-
-static float baseline_samples[10];
-static uint8_t baseline_idx = 0;
+static bme680_t dev;
+static bool measuring = false;
 
 hal_status_t bme680_init(void) {
-  /* Verify chip ID */
-  uint8_t chip_id = 0;
-  hal_status_t status = hal_i2c_read_reg(I2C_BUS_DEFAULT, BME680_ADDR,
-                                         BME680_REG_CHIP_ID, &chip_id, 1);
-  if (status != HAL_OK)
-    return status;
-  if (chip_id != BME680_CHIP_ID_VALUE)
-    return HAL_ERROR;
-
-  /* TODO: Configure measurement parameters
-   * - Temperature oversampling: x2
-   * - Pressure oversampling: x16
-   * - Humidity oversampling: x1
-   * - Gas heater: 320°C for 150ms (standard VOC detection profile)
-   *
-   * Consider using Bosch BSEC library for accurate gas computation.
-   */
-
-  return HAL_OK;
+  measuring = false;
+  return bme680_begin(&dev, BME680_ADDR);
 }
 
+/* Non-blocking: starts a measurement and returns HAL_BUSY until it has
+ * completed (call again after BME680_MEAS_MS) */
 hal_status_t bme680_read(bme680_reading_t *r) {
-  /* TODO: Trigger forced measurement and read results
-   *
-   * Steps:
-   * 1. Set forced mode in ctrl_meas register
-   * 2. Wait for measurement complete (check status register)
-   * 3. Read temp, pressure, humidity data registers
-   * 4. Apply compensation formulas from datasheet
-   * 5. Read gas resistance data register
-   * 6. Compute gas_ratio = current / baseline
-   * 7. Compute pressure_delta = current - baseline
-   */
-
-  (void)r;
-  return HAL_OK;
+  if (!measuring) {
+    hal_status_t st = bme680_start(&dev);
+    if (st != HAL_OK)
+      return st;
+    measuring = true;
+    return HAL_BUSY;
+  }
+  hal_status_t st = bme680_collect(&dev, r);
+  if (st != HAL_BUSY)
+    measuring = false;
+  return st;
 }
 
-void bme680_reset_baseline(void) {
-  /* TODO: Take multiple readings over 2 minutes
-   * and average them to establish new baseline */
-  baseline_idx = 0;
-}
+void bme680_reset_baseline(void) { bme680_dev_reset_baseline(&dev); }
 
 #endif /* HAL_HOST_MODE */
@@ -13,10 +13,24 @@
 #ifndef BME680_H
 #define BME680_H
 
-#include "../hal/hal_platform.h"
+#include "../src/hal_platform.h"
 
 /* I2C address — adjust if needed */
 #define BME680_ADDR 0x76
+#define BME680_ADDR_ALT 0x77 /* Second sensor, SDO strapped high */
+
+/* Registers a queued transaction needs (hal_i2c_submit) */
+#define BME680_REG_CTRL_MEAS 0x74
+#define BME680_REG_DATA 0x1D /* Status + data burst        */
+#define BME680_DATA_LEN 15
+#define BME680_CTRL_MEAS_SLEEP (0x40 | 0x14)          /* osrs_t ×2, osrs_p ×16 */
+#define BME680_CTRL_MEAS_FORCED (BME680_CTRL_MEAS_SLEEP | 0x01)
+
+/* Forced-mode measurement profile */
+#define BME680_HEATER_TEMP_C 320 /* Standard VOC detection profile */
+#define BME680_HEATER_MS 150
+#define BME680_MEAS_MS 200 /* T ×2, P ×16, H ×1 + heater, with margin */
+#define BME680_BASELINE_SAMPLES 10
 
 /* Readings */
 typedef struct {
@@ -28,6 +42,45 @@ typedef struct {
   float humidity_pct;       /* Relative humidity %                */
 } bme680_reading_t;
 
+/* One sensor: its NVM calibration and its gas/pressure baselines */
+typedef struct {
+  uint8_t addr;
+
+  uint16_t par_t1;
+  int16_t par_t2;
+  int8_t par_t3;
+  uint16_t par_p1;
+  int16_t par_p2;
+  int8_t par_p3;
+  int16_t par_p4;
+  int16_t par_p5;
+  int8_t par_p6;
+  int8_t par_p7;
+  int16_t par_p8;
+  int16_t par_p9;
+  uint8_t par_p10;
+  uint16_t par_h1;
+  uint16_t par_h2;
+  int8_t par_h3;
+  int8_t par_h4;
+  int8_t par_h5;
+  uint8_t par_h6;
+  int8_t par_h7;
+  int8_t par_g1;
+  int16_t par_g2;
+  int8_t par_g3;
+  uint8_t res_heat_range;
+  int8_t res_heat_val;
+  int8_t range_sw_err;
+
+  /* Baselines: the mean of the first BME680_BASELINE_SAMPLES readings */
+  float gas_baseline_ohm;
+  float pressure_baseline_hpa;
+  float gas_sum;
+  float pressure_sum;
+  uint8_t baseline_n;
+} bme680_t;
+
 /*
  * Initialize the BME680 sensor.
  * Configures measurement parameters and takes initial baseline readings.
@@ -47,6 +100,47 @@ hal_status_t bme680_read(bme680_reading_t *reading);
  */
 void bme680_reset_baseline(void);
 
+/* -----------------------------------------------------------------------
+ * Staged access (acquire.h)
+ *
+ * A measurement is two short bus transactions with the heater cycle in
+ * between, so a caller can interleave other work instead of waiting:
+ *
+ *   bme680_start()  ── ≥ BME680_MEAS_MS ──▶  bme680_collect()
+ *
+ * Both run the I2C registers through hal_i2c in either mode (on the
+ * host, its simulated register map). A caller on the transaction queue
+ * writes BME680_CTRL_MEAS_FORCED itself and hands the burst to
+ * bme680_decode().
+ * ----------------------------------------------------------------------- */
+
+/*
+ * Check the chip id at `addr`, read its calibration and program the
+ * heater profile. Done once at init; a few register transactions.
+ */
+hal_status_t bme680_begin(bme680_t *dev, uint8_t addr);
+
+/* Trigger one forced-mode measurement (one register write) */
+hal_status_t bme680_start(bme680_t *dev);
+
+/*
+ * Read the result of the last start (one burst read). HAL_BUSY while
+ * the sensor is still measuring. Until the baseline has formed the
+ * ratio reads 1.0 and the delta 0.
+ */
+hal_status_t bme680_collect(bme680_t *dev, bme680_reading_t *reading);
+
+/*
+ * Compensate a BME680_DATA_LEN burst read from BME680_REG_DATA — the
+ * second half of bme680_collect(), for a caller that queued the read
+ * itself. Same results.
+ */
+hal_status_t bme680_decode(bme680_t *dev, const uint8_t *data,
+                           bme680_reading_t *reading);
+
+/* Baselines of `dev` are re-learned from its next readings */
+void bme680_dev_reset_baseline(bme680_t *dev);
+
 /* -----------------------------------------------------------------------
  * HOST-MODE: set simulated values
  * ----------------------------------------------------------------------- */
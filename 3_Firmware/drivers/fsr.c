@@ -3,7 +3,7 @@
  */
 
 #include "fsr.h"
-#include "../hal/hal_adc.h"
+#include "../src/hal_adc.h"
 
 /* The FSR402 has a logarithmic response.
  * Approximate conversion: bigger force → lower resistance → higher ADC.
@@ -11,6 +11,12 @@
 
 #define FSR_ADC_MAX_FORCE 3000 /* ADC value at "max swelling" */
 
+float fsr_raw_to_swelling_pct(uint16_t raw_adc) {
+  if (raw_adc > FSR_ADC_MAX_FORCE)
+    raw_adc = FSR_ADC_MAX_FORCE;
+  return (float)raw_adc / (float)FSR_ADC_MAX_FORCE * 100.0f;
+}
+
 /* -----------------------------------------------------------------------
  * HOST MODE
  * ----------------------------------------------------------------------- */
@@ -44,9 +50,7 @@ hal_status_t fsr_read(fsr_reading_t *r) {
   r->raw_adc = (uint16_t)raw;
 
   /* Normalize to percentage */
-  if (raw > FSR_ADC_MAX_FORCE)
-    raw = FSR_ADC_MAX_FORCE;
-  r->swelling_pct = (float)raw / (float)FSR_ADC_MAX_FORCE * 100.0f;
+  r->swelling_pct = fsr_raw_to_swelling_pct(r->raw_adc);
 
   /* Approximate force (FSR402 logarithmic response) */
   r->force_n = r->swelling_pct * 0.2f;
@@ -12,7 +12,7 @@
 #ifndef FSR_H
 #define FSR_H
 
-#include "../hal/hal_platform.h"
+#include "../src/hal_platform.h"
 
 /* FSR reading */
 typedef struct {
@@ -32,6 +32,9 @@ hal_status_t fsr_init(void);
  */
 hal_status_t fsr_read(fsr_reading_t *reading);
 
+/* ADC code → 0-100% swelling (both modes; staged reads in acquire.h) */
+float fsr_raw_to_swelling_pct(uint16_t raw_adc);
+
 #if HAL_HOST_MODE
 void fsr_sim_set(float swelling_pct);
 #endif
@@ -3,7 +3,43 @@
  */
 
 #include "ina219.h"
-#include "../hal/hal_i2c.h"
+#include "../src/hal_i2c.h"
+
+/* -----------------------------------------------------------------------
+ * Staged access (both modes)
+ * ----------------------------------------------------------------------- */
+float ina219_current_from_reg(const uint8_t *reg) {
+  /* Shunt voltage in 10µV steps → current = V_shunt / R_shunt */
+  int16_t raw_shunt = (int16_t)((uint16_t)reg[0] << 8 | reg[1]);
+  float shunt_v = (float)raw_shunt * 0.00001f; /* 10µV per LSB */
+  return shunt_v / (INA219_SHUNT_RESISTOR_MOHM / 1000.0f);
+}
+
+float ina219_voltage_from_reg(const uint8_t *reg) {
+  /* Bus voltage: bits [15:3] × 4mV, bit 1 = conversion ready */
+  uint16_t raw_bus = ((uint16_t)reg[0] << 8) | reg[1];
+  return (float)(raw_bus >> 3) * 0.004f;
+}
+
+hal_status_t ina219_read_current(float *current_a) {
+  uint8_t buf[2] = {0};
+  hal_status_t status = hal_i2c_read_reg(I2C_BUS_DEFAULT, INA219_ADDR,
+                                         INA219_REG_SHUNT_V, buf, 2);
+  if (status != HAL_OK)
+    return status;
+  *current_a = ina219_current_from_reg(buf);
+  return HAL_OK;
+}
+
+hal_status_t ina219_read_voltage(float *voltage_v) {
+  uint8_t buf[2] = {0};
+  hal_status_t status =
+      hal_i2c_read_reg(I2C_BUS_DEFAULT, INA219_ADDR, INA219_REG_BUS_V, buf, 2);
+  if (status != HAL_OK)
+    return status;
+  *voltage_v = ina219_voltage_from_reg(buf);
+  return HAL_OK;
+}
 
 /* -----------------------------------------------------------------------
  * HOST MODE
@@ -67,29 +103,13 @@ hal_status_t ina219_init(void) {
 }
 
 hal_status_t ina219_read(ina219_reading_t *r) {
-  uint8_t buf[2] = {0};
-
-  /* Read bus voltage register */
-  hal_status_t status =
-      hal_i2c_read_reg(I2C_BUS_DEFAULT, INA219_ADDR, INA219_REG_BUS_V, buf, 2);
+  hal_status_t status = ina219_read_voltage(&r->voltage_v);
   if (status != HAL_OK)
     return status;
-
-  /* Bus voltage: bits [15:3] × 4mV, bit 1 = conversion ready */
-  uint16_t raw_bus = ((uint16_t)buf[0] << 8) | buf[1];
-  r->voltage_v = (float)(raw_bus >> 3) * 0.004f;
-
-  /* Read shunt voltage register */
-  status = hal_i2c_read_reg(I2C_BUS_DEFAULT, INA219_ADDR, INA219_REG_SHUNT_V,
-                            buf, 2);
+  status = ina219_read_current(&r->current_a);
   if (status != HAL_OK)
     return status;
 
-  /* Shunt voltage in 10µV steps → current = V_shunt / R_shunt */
-  int16_t raw_shunt = (int16_t)((uint16_t)buf[0] << 8 | buf[1]);
-  float shunt_v = (float)raw_shunt * 0.00001f; /* 10µV per LSB */
-  r->current_a = shunt_v / (INA219_SHUNT_RESISTOR_MOHM / 1000.0f);
-
   /* Power */
   r->power_w = r->voltage_v * r->current_a;
 
@@ -12,7 +12,7 @@
 #ifndef INA219_H
 #define INA219_H
 
-#include "../hal/hal_platform.h"
+#include "../src/hal_platform.h"
 
 /* INA219 I2C address */
 #define INA219_ADDR 0x40
@@ -48,6 +48,26 @@ hal_status_t ina219_init(void);
  */
 hal_status_t ina219_read(ina219_reading_t *reading);
 
+/* -----------------------------------------------------------------------
+ * Staged access (acquire.h)
+ *
+ * One register read each, so a caller can take the current sample on
+ * its own — the trip check needs it first — and the voltage on a later
+ * pass. Both go through hal_i2c in either mode (on the host, its
+ * simulated register map).
+ * ----------------------------------------------------------------------- */
+
+/* Shunt register → current in amps */
+hal_status_t ina219_read_current(float *current_a);
+
+/* Bus register → voltage in volts */
+hal_status_t ina219_read_voltage(float *voltage_v);
+
+/* The same conversions on a register already read (2 bytes, as sent),
+ * for a caller that queued the read itself (hal_i2c_submit) */
+float ina219_current_from_reg(const uint8_t *reg);
+float ina219_voltage_from_reg(const uint8_t *reg);
+
 /* -----------------------------------------------------------------------
  * HOST-MODE: set simulated values
  * ----------------------------------------------------------------------- */
@@ -3,64 +3,56 @@
  */
 
 #include "ntc_mux.h"
-#include "../hal/hal_adc.h"
-#include "../hal/hal_gpio.h"
-#include <math.h>
+#include "../src/hal_adc.h"
+#include "../src/hal_gpio.h"
 
 /* Previous reading for dT/dt computation (compat subset channels) */
 static float prev_temps[NTC_NUM_CELLS] = {25.0f, 25.0f, 25.0f, 25.0f};
+static uint32_t prev_ms[NTC_NUM_CELLS];
 static bool first_reading = true;
 
+/* Per-channel trim from the calibration step (all zero until set) */
+static ntc_cal_t calibration;
+
 /* -----------------------------------------------------------------------
  * NTC Temperature Conversion
  *
- * Uses the simplified Steinhart-Hart equation (B-parameter model):
+ * Simplified Steinhart-Hart equation (B-parameter model):
  *   1/T = 1/T0 + (1/B) × ln(R/R0)
  *
  * The voltage divider circuit:
  *   3.3V → [10kΩ pullup] → [ADC pin] → [NTC] → GND
  *
  * So: R_ntc = R_series × ADC_raw / (ADC_MAX - ADC_raw)
+ *
+ * Evaluated offline into ntc_lut_table.h; at run time this is a table
+ * lookup and an integer interpolation (no logf on the soft-float core).
  * ----------------------------------------------------------------------- */
 
 float ntc_adc_to_temp_c(uint16_t adc_raw) {
-  if (adc_raw == 0 || adc_raw >= ADC_MAX_VALUE) {
+  int16_t dc = ntc_lut_temp_dc(adc_raw);
+  if (dc == NTC_TEMP_INVALID_DC) {
     return -999.0f; /* Error: open or short circuit */
   }
+  return (float)dc * 0.1f;
+}
 
-  /* Calculate NTC resistance from voltage divider */
-  float r_ntc =
-      NTC_R_SERIES * (float)adc_raw / (float)(ADC_MAX_VALUE - adc_raw);
-
-  /* Steinhart-Hart simplified (B-parameter equation) */
-  float steinhart = logf(r_ntc / NTC_R_NOMINAL) / NTC_BETA;
-  steinhart += 1.0f / (NTC_T_NOMINAL + 273.15f);
-  float temp_k = 1.0f / steinhart;
-  float temp_c = temp_k - 273.15f;
-
-  return temp_c;
+void ntc_mux_set_calibration(const ntc_cal_t *cal) {
+  if (cal)
+    calibration = *cal;
+  else
+    ntc_cal_init(&calibration);
 }
 
 /* -----------------------------------------------------------------------
- * HOST MODE
+ * Derived values (both modes)
+ *
+ * dT/dt divides by the time between the two samples of each channel,
+ * so it stays right whatever rate the caller reads at. A channel with
+ * no new sample since the last read keeps its earlier slope out of
+ * the maximum rather than reporting zero change over zero time.
  * ----------------------------------------------------------------------- */
-#if HAL_HOST_MODE
-
-static float sim_temps[NTC_NUM_CHANNELS] = {28.0f, 28.5f, 27.8f, 28.2f, 25.0f};
-
-hal_status_t ntc_mux_init(void) {
-  first_reading = true;
-  return HAL_OK;
-}
-
-hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
-  /* Copy simulated subset channels */
-  for (int i = 0; i < NTC_NUM_CELLS; i++) {
-    r->cell_temps_c[i] = sim_temps[i];
-  }
-  r->ambient_c = sim_temps[NTC_MUX_CH_AMBIENT];
-
-  /* Find max temperature */
+static void derive(ntc_reading_t *r, const uint32_t t_ms[NTC_NUM_CELLS]) {
   r->max_temp_c = r->cell_temps_c[0];
   for (int i = 1; i < NTC_NUM_CELLS; i++) {
     if (r->cell_temps_c[i] > r->max_temp_c) {
@@ -68,7 +60,6 @@ hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
     }
   }
 
-  /* Find max point-to-point difference */
   float min_temp = r->cell_temps_c[0];
   for (int i = 1; i < NTC_NUM_CELLS; i++) {
     if (r->cell_temps_c[i] < min_temp)
@@ -76,22 +67,52 @@ hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
   }
   r->max_delta_c = r->max_temp_c - min_temp;
 
-  /* Compute dT/dt (°C per second) — assuming 500ms between reads */
   r->dt_dt_max = 0.0f;
-  if (!first_reading) {
+  for (int i = 0; i < NTC_NUM_CELLS; i++) {
+    if (first_reading || t_ms[i] == prev_ms[i])
+      continue;
+    float dt = (r->cell_temps_c[i] - prev_temps[i]) /
+               ((float)(t_ms[i] - prev_ms[i]) * 0.001f);
+    if (dt > r->dt_dt_max)
+      r->dt_dt_max = dt;
+    prev_temps[i] = r->cell_temps_c[i];
+    prev_ms[i] = t_ms[i];
+  }
+  if (first_reading) {
     for (int i = 0; i < NTC_NUM_CELLS; i++) {
-      float dt = (r->cell_temps_c[i] - prev_temps[i]) / 0.5f;
-      if (dt > r->dt_dt_max)
-        r->dt_dt_max = dt;
+      prev_temps[i] = r->cell_temps_c[i];
+      prev_ms[i] = t_ms[i];
     }
   }
   first_reading = false;
+}
 
-  /* Save for next dT/dt computation */
+/* -----------------------------------------------------------------------
+ * HOST MODE
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+
+#include "../src/hal_timer.h"
+
+static float sim_temps[NTC_NUM_CHANNELS] = {28.0f, 28.5f, 27.8f, 28.2f, 25.0f};
+
+hal_status_t ntc_mux_init(void) {
+  first_reading = true;
+  return HAL_OK;
+}
+
+void ntc_mux_poll(void) {}
+
+hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
+  /* Simulated subset channels, sampled now */
+  uint32_t t_ms[NTC_NUM_CELLS];
   for (int i = 0; i < NTC_NUM_CELLS; i++) {
-    prev_temps[i] = r->cell_temps_c[i];
+    r->cell_temps_c[i] = sim_temps[i];
+    t_ms[i] = hal_timer_millis();
   }
+  r->ambient_c = sim_temps[NTC_MUX_CH_AMBIENT];
 
+  derive(r, t_ms);
   return HAL_OK;
 }
 
@@ -106,71 +127,45 @@ void ntc_sim_set_temps(const float temps[NTC_NUM_CHANNELS]) {
  * ----------------------------------------------------------------------- */
 #else
 
+/* Bench wiring: one CD4051, channels 0-4 */
+static const ntc_scan_slot_t bench_slots[NTC_NUM_CHANNELS] = {
+    {ADC_CHANNEL_MUX_OUT, NTC_MUX_CH_CELL1},
+    {ADC_CHANNEL_MUX_OUT, NTC_MUX_CH_CELL2},
+    {ADC_CHANNEL_MUX_OUT, NTC_MUX_CH_CELL3},
+    {ADC_CHANNEL_MUX_OUT, NTC_MUX_CH_CELL4},
+    {ADC_CHANNEL_MUX_OUT, NTC_MUX_CH_AMBIENT},
+};
+
+static ntc_scan_t scan;
+
 hal_status_t ntc_mux_init(void) {
   hal_adc_init();
   hal_gpio_init();
   first_reading = true;
-  return HAL_OK;
+  hal_status_t st =
+      ntc_scan_init(&scan, bench_slots, NTC_NUM_CHANNELS, NTC_MUX_PERIOD_MS);
+  scan.cal = &calibration;
+  return st;
 }
 
-hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
-  /* Read each configured subset thermistor channel via MUX */
-  for (uint8_t ch = 0; ch < NTC_NUM_CHANNELS; ch++) {
-    /* Set MUX channel */
-    hal_gpio_mux_select(ch);
-
-    /* Brief delay for MUX output to settle (~10µs typical)
-     * TODO: Replace with proper microsecond delay */
-    for (volatile int d = 0; d < 100; d++) {
-    }
-
-    /* Read ADC */
-    int16_t raw = hal_adc_read_raw(ADC_CHANNEL_MUX_OUT);
-    if (raw < 0) {
-      if (ch < NTC_NUM_CELLS)
-        r->cell_temps_c[ch] = -999.0f;
-      else
-        r->ambient_c = -999.0f;
-      continue;
-    }
-
-    float temp = ntc_adc_to_temp_c((uint16_t)raw);
-    if (ch < NTC_NUM_CELLS) {
-      r->cell_temps_c[ch] = temp;
-    } else {
-      r->ambient_c = temp;
-    }
-  }
-
-  /* Compute derived values (same as host mode) */
-  r->max_temp_c = r->cell_temps_c[0];
-  for (int i = 1; i < NTC_NUM_CELLS; i++) {
-    if (r->cell_temps_c[i] > r->max_temp_c) {
-      r->max_temp_c = r->cell_temps_c[i];
-    }
-  }
+void ntc_mux_poll(void) { ntc_scan_poll(&scan); }
 
-  float min_temp = r->cell_temps_c[0];
-  for (int i = 1; i < NTC_NUM_CELLS; i++) {
-    if (r->cell_temps_c[i] < min_temp)
-      min_temp = r->cell_temps_c[i];
-  }
-  r->max_delta_c = r->max_temp_c - min_temp;
+static float to_c(int16_t dc) {
+  return dc == NTC_TEMP_INVALID_DC ? -999.0f : (float)dc * 0.1f;
+}
 
-  r->dt_dt_max = 0.0f;
-  if (!first_reading) {
-    for (int i = 0; i < NTC_NUM_CELLS; i++) {
-      float dt = (r->cell_temps_c[i] - prev_temps[i]) / 0.5f;
-      if (dt > r->dt_dt_max)
-        r->dt_dt_max = dt;
-    }
-  }
-  first_reading = false;
+hal_status_t ntc_mux_read_all(ntc_reading_t *r) {
+  if (scan.sweeps == 0)
+    return HAL_BUSY; /* Nothing complete yet */
 
+  uint32_t t_ms[NTC_NUM_CELLS];
   for (int i = 0; i < NTC_NUM_CELLS; i++) {
-    prev_temps[i] = r->cell_temps_c[i];
+    r->cell_temps_c[i] = to_c(scan.latest[i].temp_dc);
+    t_ms[i] = scan.latest[i].t_ms;
   }
+  r->ambient_c = to_c(scan.latest[NTC_MUX_CH_AMBIENT].temp_dc);
 
+  derive(r, t_ms);
   return HAL_OK;
 }
 
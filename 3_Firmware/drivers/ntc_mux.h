@@ -6,17 +6,20 @@
  * in the pack-level snapshot pipeline (`main` + `anomaly_eval`).
  *
  * How it works:
- *   1. Set MUX channel select pins (S0, S1, S2) via GPIO
- *   2. Wait briefly for signal to settle
- *   3. Read the MUX output via ADC
- *   4. Convert raw ADC value to temperature using NTC curve
- *   5. Repeat for each channel
+ *   1. ntc_mux_poll(), called on every main-loop pass, runs the
+ *      background scan engine (ntc_scan.h): each channel settles on
+ *      the MUX while the previous one converts — nothing spins
+ *   2. A sweep of all channels starts every NTC_MUX_PERIOD_MS
+ *   3. ntc_mux_read_all() returns the latest completed results, with
+ *      dT/dt from the true sample timestamps
  */
 
 #ifndef NTC_MUX_H
 #define NTC_MUX_H
 
-#include "../hal/hal_platform.h"
+#include "../src/hal_platform.h"
+#include "../src/ntc_lut.h"
+#include "../src/ntc_scan.h"
 
 /* Number of thermistors */
 #define NTC_NUM_CELLS 4
@@ -29,11 +32,9 @@
 #define NTC_MUX_CH_CELL4 3
 #define NTC_MUX_CH_AMBIENT 4
 
-/* NTC thermistor parameters (10kΩ NTC, B=3950) */
-#define NTC_R_NOMINAL 10000.0f /* Resistance at 25°C */
-#define NTC_T_NOMINAL 25.0f    /* Reference temperature */
-#define NTC_BETA 3950.0f       /* B coefficient */
-#define NTC_R_SERIES 10000.0f  /* Series resistor (10kΩ pullup) */
+#define NTC_MUX_PERIOD_MS 500 /* Sweep interval (med-loop rate) */
+
+/* NTC thermistor parameters: see ntc_lut.h */
 
 /* Temperature readings */
 typedef struct {
@@ -45,22 +46,35 @@ typedef struct {
 } ntc_reading_t;
 
 /*
- * Initialize the NTC subsystem (configures MUX pins + ADC).
+ * Initialize the NTC subsystem (configures MUX pins + ADC) and start
+ * the background scan.
  */
 hal_status_t ntc_mux_init(void);
 
 /*
- * Read all thermistors through the MUX.
- * This takes ~5ms (5 channels × settling time).
+ * Advance the scan. Call on every main-loop pass; never waits.
+ */
+void ntc_mux_poll(void);
+
+/*
+ * Latest readings of all thermistors. Non-blocking: returns HAL_BUSY
+ * until the first sweep has completed. dt_dt_max is over the interval
+ * between each channel's last two samples.
  */
 hal_status_t ntc_mux_read_all(ntc_reading_t *reading);
 
 /*
- * Convert a raw ADC value to temperature in °C.
- * Uses the Steinhart-Hart simplified (B-parameter) equation.
+ * Convert a raw ADC value to temperature in °C (-999 at either rail).
+ * Table lookup (ntc_lut.h) pre-computed from the B-parameter equation.
  */
 float ntc_adc_to_temp_c(uint16_t adc_raw);
 
+/*
+ * Per-channel offsets applied to every subsequent read, indexed by MUX
+ * channel (NTC_MUX_CH_*). The table is copied; NULL clears it.
+ */
+void ntc_mux_set_calibration(const ntc_cal_t *cal);
+
 #if HAL_HOST_MODE
 void ntc_sim_set_temps(const float temps[NTC_NUM_CHANNELS]);
 #endif
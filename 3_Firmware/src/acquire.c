@@ -0,0 +1,261 @@
+/*
+ * acquire.c — Multi-Rate Sensor Acquisition
+ */
+
+#include "acquire.h"
+#include "../drivers/fsr.h"
+#include "../drivers/ina219.h"
+#include "hal_adc.h"
+#include <string.h>
+
+static const uint8_t bme_addr[ACQ_BME680_COUNT] = {BME680_ADDR,
+                                                   BME680_ADDR_ALT};
+
+hal_status_t acq_init(acq_t *a, uint32_t fast_ms, uint32_t med_ms,
+                      uint32_t now_ms) {
+  memset(a, 0, sizeof(acq_t));
+  if (hal_i2c_init(I2C_BUS_DEFAULT) != HAL_OK)
+    return HAL_ERROR;
+  (void)hal_adc_init();
+
+  /* First current sample on the first poll, ahead of the BME680s */
+  hal_i2c_set_priority(I2C_BUS_DEFAULT, INA219_ADDR, HAL_I2C_PRIO_HIGH);
+  a->ina_period_ms = fast_ms;
+  a->ina_last_ms = now_ms - fast_ms;
+
+  /* Half a period apart, so the two never measure on the same pass */
+  for (uint8_t i = 0; i < ACQ_BME680_COUNT; i++) {
+    acq_bme_t *b = &a->bme[i];
+    b->stage = bme680_begin(&b->dev, bme_addr[i]) == HAL_OK ? ACQ_BME_IDLE
+                                                            : ACQ_BME_ABSENT;
+    b->due_ms = now_ms + i * (ACQ_BME680_PERIOD_MS / ACQ_BME680_COUNT);
+  }
+
+  uint8_t n = ntc_scan_pack_layout(a->slots);
+  return ntc_scan_init(&a->scan, a->slots, n, (uint16_t)med_ms);
+}
+
+void acq_set_rates(acq_t *a, uint32_t fast_ms, uint32_t med_ms) {
+  a->ina_period_ms = fast_ms;
+  a->scan.period_ms = (uint16_t)med_ms;
+}
+
+/* ---- INA219 ----------------------------------------------------------- */
+
+static void ina_submit(acq_t *a, uint8_t reg) {
+  hal_i2c_xfer_read(&a->ina_xfer, INA219_ADDR, reg, a->ina_buf, 2);
+  a->ina_pending = hal_i2c_submit(I2C_BUS_DEFAULT, &a->ina_xfer) == HAL_OK;
+  if (!a->ina_pending)
+    a->bus_errors++;
+}
+
+/* Current first, so the trip check sees it at once; the voltage read is
+ * queued the moment the current is in */
+static void ina_step(acq_t *a, uint32_t now, uint8_t *got) {
+  hal_i2c_xfer_t *x = &a->ina_xfer;
+  if (x->status == HAL_BUSY)
+    return;
+
+  if (a->ina_pending) {
+    a->ina_pending = false;
+    if (x->status != HAL_OK) {
+      a->bus_errors++;
+    } else if (x->reg == INA219_REG_SHUNT_V) {
+      a->pack_current_a =
+          ina219_current_from_reg(a->ina_buf) * ACQ_PACK_A_PER_SHUNT_A;
+      *got |= ACQ_GOT_CURRENT;
+      ina_submit(a, INA219_REG_BUS_V);
+      return;
+    } else {
+      a->pack_voltage_v =
+          ina219_voltage_from_reg(a->ina_buf) * ACQ_PACK_V_PER_BUS_V;
+      a->ina_valid = true;
+      *got |= ACQ_GOT_VOLTAGE;
+    }
+  }
+
+  if (now - a->ina_last_ms >= a->ina_period_ms) {
+    a->ina_last_ms = now;
+    ina_submit(a, INA219_REG_SHUNT_V);
+  }
+}
+
+/* ---- BME680 ----------------------------------------------------------- */
+
+static bool bme_timed_out(acq_t *a, acq_bme_t *b, uint32_t now) {
+  if (now - b->start_ms < BME680_MEAS_MS + ACQ_BME680_TIMEOUT_MS)
+    return false;
+  a->bme_timeouts++;
+  b->stage = ACQ_BME_IDLE; /* Retried on the next cycle */
+  return true;
+}
+
+static void bme_step(acq_t *a, acq_bme_t *b, uint32_t now, uint8_t *got) {
+  switch (b->stage) {
+  case ACQ_BME_IDLE:
+    if ((int32_t)(now - b->due_ms) < 0)
+      return;
+    b->due_ms += ACQ_BME680_PERIOD_MS;
+    if ((int32_t)(now - b->due_ms) >= 0)
+      b->due_ms = now + ACQ_BME680_PERIOD_MS; /* Fell behind: no burst */
+    b->cmd = BME680_CTRL_MEAS_FORCED;
+    hal_i2c_xfer_write(&b->xfer, b->dev.addr, BME680_REG_CTRL_MEAS, &b->cmd,
+                       1);
+    if (hal_i2c_submit(I2C_BUS_DEFAULT, &b->xfer) == HAL_OK)
+      b->stage = ACQ_BME_STARTING;
+    else
+      a->bus_errors++;
+    return;
+
+  case ACQ_BME_STARTING:
+    if (b->xfer.status == HAL_BUSY)
+      return;
+    if (b->xfer.status != HAL_OK) {
+      a->bus_errors++;
+      b->stage = ACQ_BME_IDLE;
+      return;
+    }
+    b->stage = ACQ_BME_MEASURING;
+    b->start_ms = now;
+    b->read_ms = now + BME680_MEAS_MS;
+    return;
+
+  case ACQ_BME_MEASURING:
+    if ((int32_t)(now - b->read_ms) < 0)
+      return; /* Heater cycle still running */
+    hal_i2c_xfer_read(&b->xfer, b->dev.addr, BME680_REG_DATA, b->data,
+                      BME680_DATA_LEN);
+    if (hal_i2c_submit(I2C_BUS_DEFAULT, &b->xfer) == HAL_OK) {
+      b->stage = ACQ_BME_READING;
+    } else {
+      a->bus_errors++;
+      b->read_ms = now + ACQ_BME680_RETRY_MS;
+      (void)bme_timed_out(a, b, now);
+    }
+    return;
+
+  case ACQ_BME_READING: {
+    if (b->xfer.status == HAL_BUSY)
+      return;
+    if (b->xfer.status != HAL_OK) {
+      a->bus_errors++;
+      b->stage = ACQ_BME_IDLE;
+      return;
+    }
+    hal_status_t st = bme680_decode(&b->dev, b->data, &b->last);
+    if (st == HAL_OK) {
+      b->valid = true;
+      b->stage = ACQ_BME_IDLE;
+      *got |= ACQ_GOT_GAS;
+    } else if (!bme_timed_out(a, b, now)) {
+      b->stage = ACQ_BME_MEASURING; /* Not in yet: read again shortly */
+      b->read_ms = now + ACQ_BME680_RETRY_MS;
+    }
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+/* ---- ADC: NTC scan and FSR -------------------------------------------- */
+
+static void adc_poll(acq_t *a, uint8_t *got) {
+  /* Collect the FSR first, freeing the converter for the scan */
+  if (a->fsr_converting && hal_adc_ready()) {
+    int16_t raw = hal_adc_result();
+    a->fsr_converting = false;
+    if (raw >= 0) {
+      a->swelling_pct = fsr_raw_to_swelling_pct((uint16_t)raw);
+      a->fsr_valid = true;
+      *got |= ACQ_GOT_SWELLING;
+    }
+  }
+
+  uint32_t sweeps = a->scan.sweeps;
+  ntc_scan_poll(&a->scan);
+  if (a->scan.sweeps != sweeps)
+    *got |= ACQ_GOT_NTC;
+
+  /* Once per sweep, while the scan is parked */
+  if (!a->fsr_converting && !a->scan.in_sweep && !a->scan.converting &&
+      !a->scan.advance && a->scan.sweeps != a->fsr_sweeps &&
+      hal_adc_start(ADC_CHANNEL_FSR) == HAL_OK) {
+    a->fsr_converting = true;
+    a->fsr_sweeps = a->scan.sweeps;
+  }
+}
+
+uint8_t acq_poll(acq_t *a, uint32_t now_ms) {
+  uint8_t got = 0;
+
+  /* Completions and timeouts first, then new transactions */
+  hal_i2c_poll(I2C_BUS_DEFAULT);
+  ina_step(a, now_ms, &got);
+  for (uint8_t i = 0; i < ACQ_BME680_COUNT; i++)
+    bme_step(a, &a->bme[i], now_ms, &got);
+
+  adc_poll(a, &got);
+  a->fresh |= got;
+  return got;
+}
+
+/* ---- Publish ---------------------------------------------------------- */
+
+module_mask_t acq_to_snapshot(acq_t *a, sensor_snapshot_t *snap,
+                              const sensor_snapshot_t *prev) {
+  module_mask_t dirty = 0;
+
+  snap->pack_voltage_v = a->pack_voltage_v;
+  snap->pack_current_a = a->pack_current_a;
+  snap->r_internal_mohm = ACQ_R_INTERNAL_MOHM;
+
+  /* Gas and pressure; neutral until a sensor has read (or if absent) */
+  const acq_bme_t *b1 = &a->bme[0];
+  const acq_bme_t *b2 = &a->bme[1];
+  snap->gas_ratio_1 = b1->valid ? b1->last.gas_ratio : 1.0f;
+  snap->gas_ratio_2 = b2->valid ? b2->last.gas_ratio : 1.0f;
+  snap->pressure_delta_1_hpa = b1->valid ? b1->last.pressure_delta_hpa : 0.0f;
+  snap->pressure_delta_2_hpa = b2->valid ? b2->last.pressure_delta_hpa : 0.0f;
+
+  /* Ambient from whichever BME680 has read; no coolant sensors */
+  const acq_bme_t *amb = b1->valid ? b1 : b2;
+  if (amb->valid) {
+    snap->temp_ambient_c = amb->last.temperature_c;
+    snap->humidity_pct = amb->last.humidity_pct;
+  } else {
+    snap->temp_ambient_c = prev->temp_ambient_c;
+    snap->humidity_pct = prev->humidity_pct;
+  }
+  snap->coolant_inlet_c = snap->temp_ambient_c;
+  snap->coolant_outlet_c = snap->temp_ambient_c;
+  snap->isolation_mohm = ACQ_ISOLATION_MOHM;
+
+  /* Module channels: held, then overlaid with what was measured */
+  float group_v = a->pack_voltage_v / TOTAL_SERIES;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    module_data_t *md = &snap->modules[m];
+    md->ntc1_c = prev->modules[m].ntc1_c;
+    md->ntc2_c = prev->modules[m].ntc2_c;
+    md->swelling_pct = prev->modules[m].swelling_pct;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      md->group_voltages_v[g] = group_v;
+  }
+  if (a->fsr_valid)
+    snap->modules[ACQ_FSR_MODULE].swelling_pct = a->swelling_pct;
+
+  uint32_t invalid = ntc_scan_to_snapshot(&a->scan, snap);
+  snap->stale_modules = (module_mask_t)invalid;
+  snap->short_circuit = false;
+
+  if (a->fresh & ACQ_GOT_VOLTAGE)
+    dirty = MODULE_MASK_ALL; /* Every group voltage follows it */
+  if (a->fresh & ACQ_GOT_NTC)
+    for (uint8_t i = 0; i < a->scan.num_slots; i += 2)
+      dirty |= MODULE_BIT(i / 2);
+  if (a->fresh & ACQ_GOT_SWELLING)
+    dirty |= MODULE_BIT(ACQ_FSR_MODULE);
+  a->fresh = 0;
+  return dirty;
+}
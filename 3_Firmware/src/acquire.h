@@ -0,0 +1,141 @@
+/*
+ * acquire.h — Multi-Rate Sensor Acquisition
+ *
+ * Runs the on-board sensors side by side without ever waiting inside a
+ * call. acq_poll() is cheap and is called from the main loop on every
+ * pass; each sensor is a small staged job at its own native rate:
+ *
+ *   INA219   current ─▶ voltage         every fast-loop period
+ *   BME680×2 start ── heater + meas ──▶ collect   every 1 s, staggered
+ *   NTC MUX  ntc_scan pipeline          every med-loop period
+ *   FSR      start ─▶ result            once per NTC sweep
+ *
+ * The I2C jobs go through the transaction queue (hal_i2c.h): the INA219
+ * is a high-priority device, so its reads (the short-circuit trip
+ * needs them) go ahead of any BME680 transaction waiting, and a hung
+ * sensor times out there instead of holding up the loop. The ADC jobs
+ * share the one converter; the FSR conversion slots in between NTC
+ * sweeps.
+ *
+ * acq_to_snapshot() fills a back snapshot slot from the latest
+ * readings. The board measures pack current and voltage (INA219,
+ * scaled from the bench mirror channel), gas and enclosure pressure
+ * (two BME680s, which also give ambient temperature and humidity), the
+ * module NTCs and one end-plate FSR. Group voltages are not measured
+ * on this board; they are spread evenly from the pack voltage.
+ */
+
+#ifndef ACQUIRE_H
+#define ACQUIRE_H
+
+#include "../drivers/bme680.h"
+#include "anomaly_eval.h"
+#include "hal_i2c.h"
+#include "hal_platform.h"
+#include "ntc_scan.h"
+
+/*
+ * Build flag: the board publishes from these sensors when no digital
+ * twin is connected, instead of the internal sim. Off by default until
+ * the THEJAS32 I2C and ADC register code is filled in (hal_i2c.c,
+ * hal_adc.c); target builds only.
+ */
+#ifndef ACQUIRE_SENSORS
+#define ACQUIRE_SENSORS 0
+#endif
+
+#define ACQ_BME680_COUNT 2
+#define ACQ_BME680_PERIOD_MS 1000 /* Forced-mode cycle per sensor         */
+#define ACQ_BME680_TIMEOUT_MS 500 /* No new data this long after a start  */
+#define ACQ_BME680_RETRY_MS 20    /* Re-read while the result is not in   */
+
+/* Bench mirror channel → pack units (16 V / 3.2 A INA219 range) */
+#define ACQ_PACK_V_PER_BUS_V 25.0f
+#define ACQ_PACK_A_PER_SHUNT_A 125.0f
+
+#define ACQ_FSR_MODULE 0 /* Module the end-plate FSR sits on */
+
+/* Not measured on this board: the values the sim also uses */
+#define ACQ_ISOLATION_MOHM 500.0f
+#define ACQ_R_INTERNAL_MOHM 0.44f
+
+/* acq_poll() result bits */
+#define ACQ_GOT_CURRENT 0x01u  /* New pack current: run the trip check */
+#define ACQ_GOT_VOLTAGE 0x02u
+#define ACQ_GOT_GAS 0x04u      /* A BME680 reading                     */
+#define ACQ_GOT_NTC 0x08u      /* An NTC sweep completed               */
+#define ACQ_GOT_SWELLING 0x10u
+
+typedef enum {
+  ACQ_BME_ABSENT = 0, /* No chip at the address (or bad chip id) */
+  ACQ_BME_IDLE,
+  ACQ_BME_STARTING,  /* Forced-mode write queued */
+  ACQ_BME_MEASURING, /* Heater cycle running     */
+  ACQ_BME_READING,   /* Result burst queued      */
+} acq_bme_stage_t;
+
+typedef struct {
+  bme680_t dev;
+  acq_bme_stage_t stage;
+  uint32_t due_ms;   /* Next start            */
+  uint32_t start_ms; /* Start of the last one */
+  uint32_t read_ms;  /* Next result read      */
+  hal_i2c_xfer_t xfer;
+  uint8_t cmd;
+  uint8_t data[BME680_DATA_LEN];
+  bme680_reading_t last;
+  bool valid;
+} acq_bme_t;
+
+typedef struct {
+  /* INA219: current, then bus voltage queued behind it */
+  uint32_t ina_period_ms;
+  uint32_t ina_last_ms;
+  hal_i2c_xfer_t ina_xfer;
+  uint8_t ina_buf[2];
+  bool ina_pending; /* ina_xfer submitted, result not yet taken */
+  bool ina_valid;   /* Both have been read at least once       */
+  float pack_current_a;
+  float pack_voltage_v;
+
+  acq_bme_t bme[ACQ_BME680_COUNT];
+
+  ntc_scan_slot_t slots[NTC_SCAN_PACK_SLOTS];
+  ntc_scan_t scan;
+
+  /* FSR: one conversion between NTC sweeps */
+  bool fsr_converting;
+  uint32_t fsr_sweeps; /* Sweep count at the last FSR start */
+  bool fsr_valid;
+  float swelling_pct;
+
+  uint8_t fresh;        /* ACQ_GOT_* since the last acq_to_snapshot() */
+  uint32_t bus_errors;  /* Failed or refused I2C transactions         */
+  uint32_t bme_timeouts;
+} acq_t;
+
+/*
+ * Probe both BME680s, read their calibration and set up the NTC scan.
+ * A missing BME680 is skipped from then on; its gas channel reads
+ * neutral. Returns HAL_ERROR if the I2C bus or the NTC scan cannot be
+ * set up; `acq` must not be polled then.
+ */
+hal_status_t acq_init(acq_t *acq, uint32_t fast_ms, uint32_t med_ms,
+                      uint32_t now_ms);
+
+/* Follow the scheduler's fast/med periods (alert mode samples faster) */
+void acq_set_rates(acq_t *acq, uint32_t fast_ms, uint32_t med_ms);
+
+/* Advance every job; never waits. Returns the ACQ_GOT_* bits of this pass. */
+uint8_t acq_poll(acq_t *acq, uint32_t now_ms);
+
+/*
+ * Fill `snap` from the latest readings. Modules outside the scanned
+ * range, or with an invalid NTC, keep `prev`'s temperatures; the
+ * invalid ones are flagged stale. Returns the modules whose raw
+ * channels changed since the last call.
+ */
+module_mask_t acq_to_snapshot(acq_t *acq, sensor_snapshot_t *snap,
+                              const sensor_snapshot_t *prev);
+
+#endif /* ACQUIRE_H */
@@ -15,6 +15,10 @@
  */
 
 #include "anomaly_eval.h"
+#include "hal_platform.h"
+#include <float.h>
+#include <stddef.h>
+#include <string.h>
 
 /* -----------------------------------------------------------------------
  * Cascade stage thresholds (°C, core temperature)
@@ -41,8 +45,8 @@ static const char *CASCADE_NAMES[] = {
 
 void anomaly_eval_init(anomaly_thresholds_t *t) {
   /* Electrical — full pack scale */
-  t->voltage_low_v = 260.0f;       /* 104 × 2.5V = 260V cutoff         */
-  t->voltage_high_v = 380.0f;      /* 104 × 3.65V = 379.6V ≈ 380V      */
+  t->voltage_low_v = PACK_VOLTAGE_LOW_V;   /* 104 × 2.5V = 260V cutoff */
+  t->voltage_high_v = PACK_VOLTAGE_HIGH_V; /* 104 × 3.65V ≈ 380V       */
   t->group_v_deviation_mv = 15.0f; /* Tight for 8P parallel masking     */
   t->v_spread_warn_mv = 50.0f;     /* Pack-wide voltage spread warning  */
   t->v_spread_crit_mv = 150.0f;    /* Pack-wide voltage spread critical */
@@ -81,6 +85,124 @@ void anomaly_eval_init(anomaly_thresholds_t *t) {
 
   /* Mechanical (8× swelling sensors) */
   t->swelling_warning_pct = 3.0f; /* Module expanding (spec value)     */
+
+  /* Learned baselines (online_stats.h) */
+  t->baseline_z_warning = 6.0f; /* Well past noise on a smoothed level */
+}
+
+/* -----------------------------------------------------------------------
+ * Threshold updates and the compiled plan
+ * ----------------------------------------------------------------------- */
+
+_Static_assert(sizeof(anomaly_thresholds_t) ==
+                   ANOMALY_THRESHOLD_COUNT * sizeof(float),
+               "threshold ids index anomaly_thresholds_t as a float array");
+
+/* Plausible range of each field, in its own units. A field without an
+ * entry here ({0, 0}) cannot be set. */
+#define TH_ID(field) (offsetof(anomaly_thresholds_t, field) / sizeof(float))
+
+typedef struct {
+  float min, max;
+} threshold_range_t;
+
+static const threshold_range_t THRESHOLD_RANGE[ANOMALY_THRESHOLD_COUNT] = {
+    [TH_ID(voltage_low_v)] = {TOTAL_SERIES * 2.0f, TOTAL_SERIES * 3.2f},
+    [TH_ID(voltage_high_v)] = {TOTAL_SERIES * 3.3f, TOTAL_SERIES * 3.8f},
+    [TH_ID(group_v_deviation_mv)] = {2.0f, 200.0f},
+    [TH_ID(v_spread_warn_mv)] = {5.0f, 500.0f},
+    [TH_ID(v_spread_crit_mv)] = {10.0f, 1000.0f},
+    [TH_ID(current_warning_a)] = {10.0f, ANOMALY_CURRENT_CEILING_A},
+    [TH_ID(current_short_a)] = {50.0f, ANOMALY_CURRENT_CEILING_A},
+    [TH_ID(r_int_warning_mohm)] = {0.05f, 10.0f},
+    [TH_ID(temp_warning_c)] = {20.0f, 75.0f},
+    [TH_ID(temp_critical_c)] = {30.0f, 85.0f},
+    [TH_ID(dt_dt_warning)] = {0.05f, 5.0f},
+    [TH_ID(inter_module_dt_warn_c)] = {0.5f, 30.0f},
+    [TH_ID(inter_module_dt_crit_c)] = {1.0f, 50.0f},
+    [TH_ID(intra_module_dt_warn_c)] = {0.5f, 30.0f},
+    [TH_ID(intra_module_dt_crit_c)] = {1.0f, 50.0f},
+    [TH_ID(delta_t_ambient_warning)] = {2.0f, 60.0f},
+    [TH_ID(temp_emergency_c)] = {40.0f, ANOMALY_TEMP_CEILING_C},
+    [TH_ID(dt_dt_emergency)] = {0.5f, ANOMALY_DT_DT_CEILING},
+    [TH_ID(current_emergency_a)] = {50.0f, ANOMALY_CURRENT_CEILING_A},
+    [TH_ID(gas_warning_ratio)] = {0.3f, 0.95f},
+    [TH_ID(gas_critical_ratio)] = {0.1f, 0.9f},
+    [TH_ID(pressure_warning_hpa)] = {0.1f, 20.0f},
+    [TH_ID(pressure_critical_hpa)] = {0.2f, 50.0f},
+    [TH_ID(coolant_dt_min_c)] = {0.0f, 20.0f},
+    [TH_ID(swelling_warning_pct)] = {0.5f, 20.0f},
+    [TH_ID(baseline_z_warning)] = {0.0f, 20.0f}, /* 0 = off */
+};
+
+static bool threshold_in_range(uint8_t id, float v) {
+  const threshold_range_t *r = &THRESHOLD_RANGE[id];
+  return r->max > r->min && v >= r->min && v <= r->max; /* NaN fails */
+}
+
+hal_status_t anomaly_thresholds_set(anomaly_thresholds_t *t, uint8_t id,
+                                    int32_t value_milli) {
+  if (id >= ANOMALY_THRESHOLD_COUNT)
+    return HAL_ERROR;
+  float v = (float)value_milli / 1000.0f;
+  if (!threshold_in_range(id, v))
+    return HAL_ERROR;
+  memcpy((uint8_t *)t + (size_t)id * sizeof(float), &v, sizeof(float));
+  return HAL_OK;
+}
+
+hal_status_t anomaly_thresholds_check(const anomaly_thresholds_t *t) {
+  for (uint8_t id = 0; id < ANOMALY_THRESHOLD_COUNT; id++) {
+    float v;
+    memcpy(&v, (const uint8_t *)t + (size_t)id * sizeof(float), sizeof(v));
+    if (!threshold_in_range(id, v))
+      return HAL_ERROR;
+  }
+
+  bool ok = t->voltage_low_v < t->voltage_high_v &&
+            t->group_v_deviation_mv > 0.0f &&
+            t->v_spread_warn_mv < t->v_spread_crit_mv &&
+            t->current_warning_a < t->current_short_a &&
+            t->current_short_a <= t->current_emergency_a &&
+            t->r_int_warning_mohm > 0.0f &&
+            t->temp_warning_c < t->temp_critical_c &&
+            t->temp_critical_c < t->temp_emergency_c &&
+            t->dt_dt_warning < t->dt_dt_emergency &&
+            t->inter_module_dt_warn_c < t->inter_module_dt_crit_c &&
+            t->intra_module_dt_warn_c < t->intra_module_dt_crit_c &&
+            t->delta_t_ambient_warning > 0.0f &&
+            t->gas_warning_ratio > t->gas_critical_ratio &&
+            t->gas_critical_ratio >= 0.0f &&
+            t->pressure_warning_hpa < t->pressure_critical_hpa &&
+            t->swelling_warning_pct > 0.0f && t->baseline_z_warning >= 0.0f;
+  return ok ? HAL_OK : HAL_ERROR;
+}
+
+void anomaly_plan_compile(anomaly_plan_t *p, const anomaly_thresholds_t *t) {
+  p->current_short_a = t->current_short_a;
+  p->current_short_neg_a = -t->current_short_a;
+  p->current_emergency_a = t->current_emergency_a;
+  p->current_emergency_neg_a = -t->current_emergency_a;
+  p->temp_emergency_c = t->temp_emergency_c;
+  p->dt_dt_emergency = t->dt_dt_emergency;
+
+  p->group_v_deviation_v = t->group_v_deviation_mv / 1000.0f;
+  p->temp_warning_c = t->temp_warning_c;
+  p->intra_module_dt_warn_c = t->intra_module_dt_warn_c;
+  p->swelling_warning_pct = t->swelling_warning_pct;
+  p->z_warn = t->baseline_z_warning > 0.0f ? t->baseline_z_warning : FLT_MAX;
+
+  p->voltage_low_v = t->voltage_low_v;
+  p->voltage_high_v = t->voltage_high_v;
+  p->v_spread_warn_mv = t->v_spread_warn_mv;
+  p->current_warning_a = t->current_warning_a;
+  p->current_warning_neg_a = -t->current_warning_a;
+  p->r_int_warning_mohm = t->r_int_warning_mohm;
+  p->inter_module_dt_warn_c = t->inter_module_dt_warn_c;
+  p->delta_t_ambient_warning = t->delta_t_ambient_warning;
+  p->dt_dt_warning = t->dt_dt_warning;
+  p->gas_warning_ratio = t->gas_warning_ratio;
+  p->pressure_warning_hpa = t->pressure_warning_hpa;
 }
 
 /* -----------------------------------------------------------------------
@@ -120,11 +242,51 @@ const char *cascade_stage_name(uint8_t stage) {
  * Compute derived fields in snapshot
  *
  * Call this BEFORE anomaly_eval_run(). Fills in:
- * - Per-module: module_voltage, mean_group_v, v_spread_mv, delta_t_intra
+ * - Per-module: module_voltage, mean_group_v, v_spread_mv, v_min/max,
+ *   delta_t_intra
  * - Pack: v_spread_mv, temp_spread_c, hotspot, t_core_est_c
+ *
+ * Split in two: a per-module pass over raw fields (cached), and a
+ * merge over 8 cached records that builds the pack-wide values.
  * ----------------------------------------------------------------------- */
 
-void anomaly_eval_compute(sensor_snapshot_t *s, const anomaly_thresholds_t *t) {
+/* Per-module statistics from raw group voltages and NTCs */
+static void module_stats_compute(const module_data_t *mod, module_stats_t *st) {
+  float v_sum = 0.0f;
+  float v_min = 999.0f;
+  float v_max = 0.0f;
+
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    float v = mod->group_voltages_v[g];
+    v_sum += v;
+    if (v < v_min)
+      v_min = v;
+    if (v > v_max)
+      v_max = v;
+  }
+
+  st->v_min = v_min;
+  st->v_max = v_max;
+  st->module_voltage = v_sum;
+  st->mean_group_v = v_sum / GROUPS_PER_MODULE;
+  st->v_spread_mv = (v_max - v_min) * 1000.0f;
+
+  /* Per-module thermal */
+  st->delta_t_intra = mod->ntc1_c - mod->ntc2_c;
+  if (st->delta_t_intra < 0)
+    st->delta_t_intra = -st->delta_t_intra;
+  st->t_min = mod->ntc1_c < mod->ntc2_c ? mod->ntc1_c : mod->ntc2_c;
+  st->t_max = mod->ntc1_c > mod->ntc2_c ? mod->ntc1_c : mod->ntc2_c;
+}
+
+void anomaly_eval_cache_init(anomaly_eval_cache_t *cache) {
+  memset(cache, 0, sizeof(anomaly_eval_cache_t));
+}
+
+void anomaly_eval_compute_incremental(sensor_snapshot_t *s,
+                                      const anomaly_thresholds_t *t,
+                                      anomaly_eval_cache_t *cache,
+                                      module_mask_t dirty_modules) {
   (void)t; /* May use thresholds for context-dependent computations later */
 
   float global_v_min = 999.0f;
@@ -135,57 +297,46 @@ void anomaly_eval_compute(sensor_snapshot_t *s, const anomaly_thresholds_t *t) {
   float max_temp = -999.0f;
   uint8_t hot_module = 0;
 
+  module_mask_t recompute =
+      (module_mask_t)((dirty_modules | (module_mask_t)~cache->valid_mask) &
+                      MODULE_MASK_ALL);
+
   for (int m = 0; m < NUM_MODULES; m++) {
     module_data_t *mod = &s->modules[m];
-
-    /* Per-module voltage statistics */
-    float v_sum = 0.0f;
-    float v_min = 999.0f;
-    float v_max = 0.0f;
-
-    for (int g = 0; g < GROUPS_PER_MODULE; g++) {
-      float v = mod->group_voltages_v[g];
-      v_sum += v;
-      if (v < v_min)
-        v_min = v;
-      if (v > v_max)
-        v_max = v;
-      if (v < global_v_min)
-        global_v_min = v;
-      if (v > global_v_max)
-        global_v_max = v;
-    }
-
-    mod->module_voltage = v_sum;
-    mod->mean_group_v = v_sum / GROUPS_PER_MODULE;
-    mod->v_spread_mv = (v_max - v_min) * 1000.0f;
-
-    /* Per-module thermal */
-    mod->delta_t_intra = mod->ntc1_c - mod->ntc2_c;
-    if (mod->delta_t_intra < 0)
-      mod->delta_t_intra = -mod->delta_t_intra;
-
-    /* Track temps for pack-wide spread */
-    if (mod->ntc1_c < global_t_min)
-      global_t_min = mod->ntc1_c;
-    if (mod->ntc2_c < global_t_min)
-      global_t_min = mod->ntc2_c;
-    if (mod->ntc1_c > global_t_max)
-      global_t_max = mod->ntc1_c;
-    if (mod->ntc2_c > global_t_max)
-      global_t_max = mod->ntc2_c;
+    module_stats_t *st = &cache->mod[m];
+
+    if (recompute & MODULE_BIT(m))
+      module_stats_compute(mod, st);
+
+    mod->module_voltage = st->module_voltage;
+    mod->mean_group_v = st->mean_group_v;
+    mod->v_spread_mv = st->v_spread_mv;
+    mod->v_min_v = st->v_min;
+    mod->v_max_v = st->v_max;
+    mod->delta_t_intra = st->delta_t_intra;
+
+    /* Merge into pack-wide spreads */
+    if (st->v_min < global_v_min)
+      global_v_min = st->v_min;
+    if (st->v_max > global_v_max)
+      global_v_max = st->v_max;
+    if (st->t_min < global_t_min)
+      global_t_min = st->t_min;
+    if (st->t_max > global_t_max)
+      global_t_max = st->t_max;
 
     /* Track hotspot */
-    float mod_max_t = mod->ntc1_c > mod->ntc2_c ? mod->ntc1_c : mod->ntc2_c;
-    if (mod_max_t > max_temp) {
-      max_temp = mod_max_t;
+    if (st->t_max > max_temp) {
+      max_temp = st->t_max;
       hot_module = (uint8_t)(m + 1);
     }
 
+    /* Rates come from med_loop every pass, never cached */
     if (mod->max_dt_dt > max_dt_dt) {
       max_dt_dt = mod->max_dt_dt;
     }
   }
+  cache->valid_mask |= recompute;
 
   /* Pack-wide derived values */
   s->v_spread_mv = (global_v_max - global_v_min) * 1000.0f;
@@ -208,198 +359,278 @@ void anomaly_eval_compute(sensor_snapshot_t *s, const anomaly_thresholds_t *t) {
   s->coolant_delta_t = s->coolant_outlet_c - s->coolant_inlet_c;
 }
 
+void anomaly_eval_compute(sensor_snapshot_t *s, const anomaly_thresholds_t *t) {
+  anomaly_eval_cache_t scratch;
+  scratch.valid_mask = 0; /* Everything recomputed */
+  anomaly_eval_compute_incremental(s, t, &scratch, MODULE_MASK_ALL);
+}
 /* -----------------------------------------------------------------------
  * Main evaluation function — Full pack (139 channels)
  *
  * Checks each sensor domain against thresholds. Builds a bitmask
  * of active anomaly categories, identifies hotspot, and assesses
  * thermal runaway risk.
+ *
+ * Ordered cheapest and most decisive first:
+ *
+ *   1. Short circuit and the physics-limit bypass — a handful of
+ *      compares that force EMERGENCY on their own
+ *   2. Risk and cascade stage (the correlation engine tracks them in
+ *      every state)
+ *   3. One fused pass over the modules: voltage deviation, NTC limits,
+ *      intra-module ΔT, swelling and baseline drift, accumulated into
+ *      per-category module masks without branches
+ *   4. Pack-level checks, each skipped once its category is already
+ *      active — it could only set the same bit again
+ *
+ * anomaly_eval_run_trip() stops after step 2 when step 1 fired. Limits
+ * come from the compiled plan, already in the snapshot's units.
  * ----------------------------------------------------------------------- */
 
-anomaly_result_t anomaly_eval_run(const anomaly_thresholds_t *t,
-                                  const sensor_snapshot_t *s) {
+static inline float max2(float a, float b) { return a > b ? a : b; }
+static inline float min2(float a, float b) { return a < b ? a : b; }
+
+HAL_FAST_CODE
+static anomaly_result_t eval_run(const anomaly_plan_t *p,
+                                 const sensor_snapshot_t *s, bool trip) {
   anomaly_result_t result;
   result.active_mask = CAT_NONE;
   result.is_short_circuit = false;
   result.is_emergency_direct = false;
   result.hotspot_module = s->hotspot_module;
   result.anomaly_modules_mask = 0;
+  result.stale_modules_mask = s->stale_modules;
   result.risk_factor = 0.0f;
+  result.risk_q15 = 0;
   result.cascade_stage = 0;
 
-  /* === ELECTRICAL CATEGORY ===
-   * Pack voltage, per-group voltage spread, current, R_int */
+  /* === DECISIVE CHECKS === */
+  float i = s->pack_current_a;
 
-  /* Pack voltage bounds */
-  if (s->pack_voltage_v < t->voltage_low_v ||
-      s->pack_voltage_v > t->voltage_high_v) {
+  /* Short circuit detection */
+  if (s->short_circuit || i > p->current_short_a ||
+      i < p->current_short_neg_a) {
+    result.is_short_circuit = true;
     result.active_mask |= CAT_ELECTRICAL;
   }
 
-  /* Voltage spread across all 104 groups */
-  if (s->v_spread_mv > t->v_spread_warn_mv) {
+  /* Emergency current spike (spec §4.3) */
+  if (i > p->current_emergency_a || i < p->current_emergency_neg_a) {
+    result.is_emergency_direct = true;
     result.active_mask |= CAT_ELECTRICAL;
   }
 
-  /* Per-module voltage deviation check */
+  /* Emergency thermal thresholds (spec §4.3) — direct bypass */
+  float max_ntc = -999.0f;
   for (int m = 0; m < NUM_MODULES; m++) {
-    const module_data_t *mod = &s->modules[m];
-    for (int g = 0; g < GROUPS_PER_MODULE; g++) {
-      float dev_mv = (mod->group_voltages_v[g] - mod->mean_group_v) * 1000.0f;
-      if (dev_mv < 0)
-        dev_mv = -dev_mv;
-      if (dev_mv > t->group_v_deviation_mv) {
-        result.active_mask |= CAT_ELECTRICAL;
-        result.anomaly_modules_mask |= (1 << m);
-        break; /* One bad group is enough to flag this module */
-      }
-    }
+    max_ntc = max2(max_ntc, max2(s->modules[m].ntc1_c, s->modules[m].ntc2_c));
   }
-
-  /* Current check */
-  float abs_current = s->pack_current_a;
-  if (abs_current < 0)
-    abs_current = -abs_current;
-
-  if (abs_current > t->current_warning_a) {
-    result.active_mask |= CAT_ELECTRICAL;
+  if (max_ntc > p->temp_emergency_c || s->dt_dt_max > p->dt_dt_emergency) {
+    result.is_emergency_direct = true;
+    result.active_mask |= CAT_THERMAL;
   }
 
-  /* Short circuit detection */
-  if (s->short_circuit || abs_current > t->current_short_a) {
-    result.is_short_circuit = true;
-    result.active_mask |= CAT_ELECTRICAL;
-  }
+  /* === THERMAL RUNAWAY RISK ASSESSMENT ===
+   * Based on real cascade chemistry stages. Every term is >= 0, so one
+   * clamp at the end equals clamping after each. */
+  float worst_gas = min2(s->gas_ratio_1, s->gas_ratio_2);
+  float worst_pressure = max2(s->pressure_delta_1_hpa, s->pressure_delta_2_hpa);
 
-  /* Emergency current spike (spec §4.3) */
-  if (abs_current > t->current_emergency_a) {
-    result.is_emergency_direct = true;
-    result.active_mask |= CAT_ELECTRICAL;
-  }
+  result.cascade_stage = get_cascade_stage(s->t_core_est_c);
 
-  /* R_int check (group-level: cell R_int / 8) */
-  if (s->r_internal_mohm > t->r_int_warning_mohm) {
-    result.active_mask |= CAT_ELECTRICAL;
-  }
+  /* Risk factor: weighted combination of stage, dT/dt, and gas */
+  float risk = 0.0f;
 
-  /* === THERMAL CATEGORY ===
-   * 16 NTC temperatures (2 per module × 8 modules)
-   * + ambient compensation + dT/dt + inter/intra module ΔT */
+  /* Temperature contribution (linear from 60°C to 300°C) */
+  if (s->t_core_est_c > 60.0f)
+    risk += (s->t_core_est_c - 60.0f) / 240.0f;
 
-  /* Find max NTC temperature across all modules */
-  float max_ntc = -999.0f;
-  for (int m = 0; m < NUM_MODULES; m++) {
-    float ntc1 = s->modules[m].ntc1_c;
-    float ntc2 = s->modules[m].ntc2_c;
+  /* dT/dt contribution (accelerating = worse) */
+  if (s->dt_dt_max > 0.1f)
+    risk += s->dt_dt_max * 0.05f; /* 20°C/min → adds 1.0 */
 
-    /* Absolute threshold check — any NTC */
-    if (ntc1 > t->temp_warning_c || ntc2 > t->temp_warning_c) {
-      result.active_mask |= CAT_THERMAL;
-      result.anomaly_modules_mask |= (1 << m);
-    }
+  /* Gas contribution (off-gassing = worse) */
+  if (worst_gas < 0.8f)
+    risk += (0.8f - worst_gas) * 0.5f; /* 0.3 ratio → adds 0.25 */
 
-    /* Track max for ambient compensation */
-    if (ntc1 > max_ntc)
-      max_ntc = ntc1;
-    if (ntc2 > max_ntc)
-      max_ntc = ntc2;
+  /* Pressure contribution */
+  if (worst_pressure > 1.0f)
+    risk += worst_pressure * 0.02f; /* 10 hPa → adds 0.2 */
 
-    /* Intra-module ΔT check (one half hotter than other) */
-    if (s->modules[m].delta_t_intra > t->intra_module_dt_warn_c) {
-      result.active_mask |= CAT_THERMAL;
-      result.anomaly_modules_mask |= (1 << m);
-    }
-  }
+  result.risk_factor = min2(risk, 1.0f);
+  result.risk_q15 = (uint16_t)(result.risk_factor * 32768.0f + 0.5f);
 
-  /* Inter-module ΔT check (one module much hotter than others) */
-  if (s->temp_spread_c > t->inter_module_dt_warn_c) {
-    result.active_mask |= CAT_THERMAL;
+  if (trip && (result.is_short_circuit || result.is_emergency_direct)) {
+    result.active_count = anomaly_count_categories(result.active_mask);
+    return result; /* EMERGENCY whatever else is active */
   }
 
-  /* Ambient-compensated threshold */
-  float delta_t_ambient = max_ntc - s->temp_ambient_c;
-  if (delta_t_ambient >= t->delta_t_ambient_warning) {
-    result.active_mask |= CAT_THERMAL;
+  /* === PER-MODULE CHECKS ===
+   * (v - mean) is monotonic in v, so the worst group is the min or the
+   * max found by compute — two checks per module instead of a second
+   * pass over all 13 groups. Deviations stay in volts, the plan's unit. */
+  float z_warn = p->z_warn;
+  module_mask_t elec_mods = 0, therm_mods = 0, swell_mods = 0;
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_t *mod = &s->modules[m];
+    float dev = max2(mod->v_max_v - mod->mean_group_v,
+                     mod->mean_group_v - mod->v_min_v);
+    float ntc = max2(mod->ntc1_c, mod->ntc2_c);
+
+    unsigned elec = (unsigned)(dev > p->group_v_deviation_v) |
+                    (unsigned)(mod->v_dev_z > z_warn);
+    unsigned therm = (unsigned)(ntc > p->temp_warning_c) |
+                     (unsigned)(mod->delta_t_intra > p->intra_module_dt_warn_c) |
+                     (unsigned)(mod->ntc_z > z_warn);
+    unsigned swell = (unsigned)(mod->swelling_pct > p->swelling_warning_pct);
+
+    elec_mods |= (module_mask_t)((module_mask_t)elec << m);
+    therm_mods |= (module_mask_t)((module_mask_t)therm << m);
+    swell_mods |= (module_mask_t)((module_mask_t)swell << m);
   }
 
-  /* Rate of temperature change (max across all modules) */
-  if (s->dt_dt_max > t->dt_dt_warning) {
+  result.anomaly_modules_mask =
+      (module_mask_t)(elec_mods | therm_mods | swell_mods);
+  if (elec_mods)
+    result.active_mask |= CAT_ELECTRICAL;
+  if (therm_mods)
     result.active_mask |= CAT_THERMAL;
+  if (swell_mods)
+    result.active_mask |= CAT_SWELLING;
+
+  /* === ELECTRICAL CATEGORY ===
+   * Pack voltage, voltage spread across all 104 groups, current, R_int */
+  if (!(result.active_mask & CAT_ELECTRICAL) &&
+      (s->pack_voltage_v < p->voltage_low_v ||
+       s->pack_voltage_v > p->voltage_high_v ||
+       s->v_spread_mv > p->v_spread_warn_mv || i > p->current_warning_a ||
+       i < p->current_warning_neg_a ||
+       s->r_internal_mohm > p->r_int_warning_mohm)) {
+    result.active_mask |= CAT_ELECTRICAL;
   }
 
-  /* Emergency thermal thresholds (spec §4.3) — direct bypass */
-  if (max_ntc > t->temp_emergency_c || s->dt_dt_max > t->dt_dt_emergency) {
-    result.is_emergency_direct = true;
+  /* === THERMAL CATEGORY ===
+   * Inter-module ΔT, ambient compensation, rate of change */
+  if (!(result.active_mask & CAT_THERMAL) &&
+      (s->temp_spread_c > p->inter_module_dt_warn_c ||
+       max_ntc - s->temp_ambient_c >= p->delta_t_ambient_warning ||
+       s->dt_dt_max > p->dt_dt_warning)) {
     result.active_mask |= CAT_THERMAL;
   }
 
   /* === GAS CATEGORY ===
-   * Use worst-case of 2 BME680 sensors (lower ratio = more gas) */
-  float worst_gas =
-      s->gas_ratio_1 < s->gas_ratio_2 ? s->gas_ratio_1 : s->gas_ratio_2;
-
-  if (worst_gas < t->gas_warning_ratio) {
+   * Worst case of 2 BME680 sensors (lower ratio = more gas), or a ratio
+   * sagging below the sensor's learned baseline */
+  if (worst_gas < p->gas_warning_ratio || s->gas_z > z_warn) {
     result.active_mask |= CAT_GAS;
   }
 
   /* === PRESSURE CATEGORY ===
-   * Use worst-case of 2 pressure sensors (higher delta = more pressure) */
-  float worst_pressure = s->pressure_delta_1_hpa > s->pressure_delta_2_hpa
-                             ? s->pressure_delta_1_hpa
-                             : s->pressure_delta_2_hpa;
-
-  if (worst_pressure > t->pressure_warning_hpa) {
+   * Worst case of 2 pressure sensors (higher delta = more pressure) */
+  if (worst_pressure > p->pressure_warning_hpa) {
     result.active_mask |= CAT_PRESSURE;
   }
 
-  /* === SWELLING CATEGORY ===
-   * Check all 8 module swelling sensors */
-  for (int m = 0; m < NUM_MODULES; m++) {
-    if (s->modules[m].swelling_pct > t->swelling_warning_pct) {
-      result.active_mask |= CAT_SWELLING;
-      result.anomaly_modules_mask |= (1 << m);
-    }
-  }
+  /* Count total active categories */
+  result.active_count = anomaly_count_categories(result.active_mask);
 
-  /* === THERMAL RUNAWAY RISK ASSESSMENT ===
-   * Based on real cascade chemistry stages */
-  result.cascade_stage = get_cascade_stage(s->t_core_est_c);
+  return result;
+}
 
-  /* Risk factor: weighted combination of stage, dT/dt, and gas */
-  float risk = 0.0f;
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_run(const anomaly_thresholds_t *t,
+                                  const sensor_snapshot_t *s) {
+  anomaly_plan_t p;
+  anomaly_plan_compile(&p, t);
+  return eval_run(&p, s, false);
+}
 
-  /* Temperature contribution (linear from 60°C to 300°C) */
-  if (s->t_core_est_c > 60.0f) {
-    risk += (s->t_core_est_c - 60.0f) / 240.0f;
-    if (risk > 1.0f)
-      risk = 1.0f;
-  }
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_run_trip(const anomaly_thresholds_t *t,
+                                       const sensor_snapshot_t *s) {
+  anomaly_plan_t p;
+  anomaly_plan_compile(&p, t);
+  return eval_run(&p, s, true);
+}
 
-  /* dT/dt contribution (accelerating = worse) */
-  if (s->dt_dt_max > 0.1f) {
-    risk += s->dt_dt_max * 0.05f; /* 20°C/min → adds 1.0 */
-    if (risk > 1.0f)
-      risk = 1.0f;
-  }
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_run_plan(const anomaly_plan_t *p,
+                                       const sensor_snapshot_t *s) {
+  return eval_run(p, s, false);
+}
 
-  /* Gas contribution (off-gassing = worse) */
-  if (worst_gas < 0.8f) {
-    risk += (0.8f - worst_gas) * 0.5f; /* 0.3 ratio → adds 0.25 */
-    if (risk > 1.0f)
-      risk = 1.0f;
-  }
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_run_plan_trip(const anomaly_plan_t *p,
+                                            const sensor_snapshot_t *s) {
+  return eval_run(p, s, true);
+}
+/* -----------------------------------------------------------------------
+ * Batch evaluation
+ *
+ * Each snapshot is derived and evaluated while it is still in cache;
+ * one plan is shared by every pack.
+ * ----------------------------------------------------------------------- */
 
-  /* Pressure contribution */
-  if (worst_pressure > 1.0f) {
-    risk += worst_pressure * 0.02f; /* 10 hPa → adds 0.2 */
-    if (risk > 1.0f)
-      risk = 1.0f;
+void anomaly_eval_run_batch(const anomaly_thresholds_t *t,
+                            sensor_snapshot_t *snapshots,
+                            anomaly_result_t *results, uint32_t count) {
+  anomaly_plan_t p;
+  anomaly_plan_compile(&p, t);
+  for (uint32_t i = 0; i < count; i++) {
+    anomaly_eval_compute(&snapshots[i], t);
+    results[i] = eval_run(&p, &snapshots[i], false);
   }
+}
 
-  result.risk_factor = risk;
+/* -----------------------------------------------------------------------
+ * Double-buffered snapshot
+ *
+ * Index updates run with interrupts masked for a handful of
+ * instructions; slot contents are never copied or locked.
+ * ----------------------------------------------------------------------- */
 
-  /* Count total active categories */
-  result.active_count = anomaly_count_categories(result.active_mask);
+void snapshot_buffer_init(snapshot_buffer_t *sb) {
+  memset(sb->slot, 0, sizeof(sb->slot));
+  sb->front = 0;
+  sb->pinned = SNAPSHOT_NONE;
+  sb->seq = 0;
+  sb->dirty = 0;
+  sb->pinned_dirty = 0;
+}
 
-  return result;
+sensor_snapshot_t *snapshot_begin_write(snapshot_buffer_t *sb) {
+  uint32_t irq = hal_irq_save();
+  uint8_t back = (uint8_t)(sb->front ^ 1u);
+  sensor_snapshot_t *slot = (sb->pinned == back) ? 0 : &sb->slot[back];
+  hal_irq_restore(irq);
+  return slot;
+}
+
+void snapshot_publish(snapshot_buffer_t *sb, module_mask_t dirty_modules) {
+  uint32_t irq = hal_irq_save();
+  sb->front = (uint8_t)(sb->front ^ 1u);
+  sb->seq++;
+  sb->dirty |= dirty_modules;
+  hal_irq_restore(irq);
+}
+
+sensor_snapshot_t *snapshot_acquire(snapshot_buffer_t *sb, uint32_t *seq) {
+  uint32_t irq = hal_irq_save();
+  uint8_t idx = sb->front;
+  sb->pinned = idx;
+  sb->pinned_dirty |= sb->dirty;
+  sb->dirty = 0;
+  if (seq)
+    *seq = sb->seq;
+  hal_irq_restore(irq);
+  return &sb->slot[idx];
+}
+
+module_mask_t snapshot_take_dirty(snapshot_buffer_t *sb) {
+  module_mask_t d = sb->pinned_dirty;
+  sb->pinned_dirty = 0;
+  return d;
 }
+
+void snapshot_release(snapshot_buffer_t *sb) { sb->pinned = SNAPSHOT_NONE; }
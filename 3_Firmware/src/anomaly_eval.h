@@ -5,6 +5,9 @@
  * battery pack (8 modules × 13 groups × 8 cells = 832 cells) and
  * returns which anomaly categories are active.
  *
+ * Geometry comes from pack_config.h; the counts below are for the
+ * default 8-module pack and scale with the module count.
+ *
  * Architecture:
  *   - 104 group voltages (13 per module × 8 modules)
  *   - 16 NTC temperatures (2 per module × 8 modules)
@@ -18,17 +21,19 @@
 #ifndef ANOMALY_EVAL_H
 #define ANOMALY_EVAL_H
 
+#include "hal_platform.h"
+#include "pack_config.h"
 #include <stdbool.h>
 #include <stdint.h>
 
 /* -----------------------------------------------------------------------
- * Pack geometry constants
+ * Pack geometry constants (see pack_config.h)
  * ----------------------------------------------------------------------- */
 
-#define NUM_MODULES 8
-#define GROUPS_PER_MODULE 13
+#define NUM_MODULES PACK_NUM_MODULES
+#define GROUPS_PER_MODULE PACK_GROUPS_PER_MODULE
 #define TOTAL_SERIES (NUM_MODULES * GROUPS_PER_MODULE) /* 104 */
-#define CELLS_PER_GROUP 8
+#define CELLS_PER_GROUP PACK_CELLS_PER_GROUP
 
 /* -----------------------------------------------------------------------
  * Anomaly category bitmask
@@ -98,8 +103,32 @@ typedef struct {
 
   /* Mechanical thresholds (8× swelling sensors) */
   float swelling_warning_pct;    /* Swelling above this = anomaly            */
+
+  /* Drift from the learned baselines (online_stats.h), in σ; 0 = off */
+  float baseline_z_warning;
 } anomaly_thresholds_t;
 
+/* Threshold ids for anomaly_thresholds_set() (and the UART threshold
+ * frame) are field positions above: append new fields only */
+#define ANOMALY_THRESHOLD_COUNT                                                \
+  ((uint8_t)(sizeof(anomaly_thresholds_t) / sizeof(float)))
+
+/*
+ * Hardware ceilings: no threshold set may put the short-circuit trip,
+ * the current EMERGENCY bypass or the temperature and dT/dt EMERGENCY
+ * levels above these (pack contactor break rating, LFP vent onset).
+ * Build-time only; a threshold reload cannot move them.
+ */
+#ifndef ANOMALY_CURRENT_CEILING_A
+#define ANOMALY_CURRENT_CEILING_A 600.0f
+#endif
+#ifndef ANOMALY_TEMP_CEILING_C
+#define ANOMALY_TEMP_CEILING_C 90.0f
+#endif
+#ifndef ANOMALY_DT_DT_CEILING
+#define ANOMALY_DT_DT_CEILING 10.0f /* °C/min */
+#endif
+
 /* -----------------------------------------------------------------------
  * Per-module data (what the firmware processes per module)
  * ----------------------------------------------------------------------- */
@@ -115,6 +144,10 @@ typedef struct {
   float module_voltage;         /* Sum of 13 group voltages                 */
   float mean_group_v;           /* Mean of 13 group voltages                */
   float v_spread_mv;            /* Max-min voltage within module (mV)       */
+  float v_min_v;                /* Lowest / highest group voltage — the     */
+  float v_max_v;                /* groups furthest from the mean            */
+  float v_dev_z;                /* Worst group drift from baseline (σ)      */
+  float ntc_z;                  /* Worst NTC rise over baseline (σ)         */
 } module_data_t;
 
 /* -----------------------------------------------------------------------
@@ -148,6 +181,7 @@ typedef struct {
   float t_core_est_c;            /* Estimated core temp of hottest cell     */
   float dr_dt_mohm_per_s;        /* R_int rate of change (mΩ/s)             */
   float coolant_delta_t;         /* Coolant outlet - inlet (°C)             */
+  float gas_z;                   /* Worst gas drop below baseline (σ)       */
 
   /* Hotspot tracking — filled by compute step */
   uint8_t hotspot_module;        /* Module with max temp (1-based, 0=none)  */
@@ -156,8 +190,83 @@ typedef struct {
 
   /* Fast-loop flags */
   bool short_circuit;            /* Set by fast loop if current spike       */
+
+  /* Acquisition — set by the writer */
+  module_mask_t stale_modules;   /* Reused last-good data (partial cycle)   */
 } sensor_snapshot_t;
 
+/* -----------------------------------------------------------------------
+ * Double-buffered snapshot
+ *
+ * Acquisition (UART RX, fallback sim) fills the back slot and publishes
+ * it; the evaluators acquire the front slot and own it until release.
+ * Publishing flips an index — no 600-byte copy — and a writer never
+ * touches the slot the evaluator has pinned, so the loops always see
+ * one consistent 139-channel frame, even with RX in an interrupt.
+ *
+ * Derived fields (anomaly_eval_compute, med_loop rates) are written
+ * into the pinned slot by the evaluator; writers only fill raw fields.
+ *
+ * Writers also say which modules they changed. The masks accumulate
+ * until the evaluator pins a slot, so incremental compute can skip
+ * modules that no publish has touched since it last ran.
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  sensor_snapshot_t slot[2];
+  volatile uint8_t front;  /* Most recently published slot            */
+  volatile uint8_t pinned; /* Slot held by the evaluator (0xFF = none) */
+  volatile uint32_t seq;   /* Incremented on every publish             */
+  volatile module_mask_t dirty; /* Modules published since last pin */
+  module_mask_t pinned_dirty;    /* Modules changed up to the pinned slot */
+} snapshot_buffer_t;
+
+#define SNAPSHOT_NONE 0xFF
+
+/* Zero both slots and reset the publish sequence */
+void snapshot_buffer_init(snapshot_buffer_t *sb);
+
+/* Get the back slot for filling. Returns NULL if the evaluator still
+ * holds it (writer lapped the reader) — retry on the next frame. */
+sensor_snapshot_t *snapshot_begin_write(snapshot_buffer_t *sb);
+
+/* Make the back slot the new front. `dirty_modules` has bit m set for
+ * every module whose raw fields this write changed. */
+void snapshot_publish(snapshot_buffer_t *sb, module_mask_t dirty_modules);
+
+/* Pin the front slot for evaluation. *seq receives its publish number
+ * so callers can tell a fresh frame from the one they saw last time. */
+sensor_snapshot_t *snapshot_acquire(snapshot_buffer_t *sb, uint32_t *seq);
+
+/* Modules changed since the last take, up to the pinned slot; clears */
+module_mask_t snapshot_take_dirty(snapshot_buffer_t *sb);
+
+/* Release the pinned slot */
+void snapshot_release(snapshot_buffer_t *sb);
+
+/* -----------------------------------------------------------------------
+ * Incremental compute cache
+ *
+ * Per-module statistics from the last compute, so a pass only walks
+ * the 13 groups and 2 NTCs of modules whose frames changed. Clean
+ * modules are merged from the cache (and their derived fields copied
+ * back, since a double-buffered slot may not hold them).
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  float v_min, v_max; /* Group voltage extremes                    */
+  float t_min, t_max; /* NTC extremes                              */
+  float module_voltage;
+  float mean_group_v;
+  float v_spread_mv;
+  float delta_t_intra;
+} module_stats_t;
+
+typedef struct {
+  module_stats_t mod[NUM_MODULES];
+  module_mask_t valid_mask; /* Modules with cached stats         */
+} anomaly_eval_cache_t;
+
 /* -----------------------------------------------------------------------
  * Evaluation result
  * ----------------------------------------------------------------------- */
@@ -170,13 +279,56 @@ typedef struct {
 
   /* Hotspot info for dashboard */
   uint8_t hotspot_module;        /* Module with worst anomaly (1-based)     */
-  uint8_t anomaly_modules_mask;  /* Bitmask: which modules have anomalies   */
+  module_mask_t anomaly_modules_mask; /* Which modules have anomalies   */
+  module_mask_t stale_modules_mask;   /* Evaluated from reused data     */
 
   /* Thermal runaway risk assessment */
   float risk_factor;             /* 0.0 = safe, 1.0 = runaway imminent     */
+                                 /* (float evaluator; 0 from the fx one)   */
+  uint16_t risk_q15;             /* The same, Q15 (32768 = 1.0)           */
   uint8_t cascade_stage;         /* 0=Normal..6=Full_Runaway                */
 } anomaly_result_t;
 
+/* -----------------------------------------------------------------------
+ * Compiled threshold plan
+ *
+ * The limits anomaly_eval_run() checks, converted once into the units
+ * the snapshot holds, so the pass compares each reading straight
+ * against its limit: the group deviation in volts (no ×1000 per
+ * module), current limits as a signed pair (no fabsf), baseline drift
+ * at FLT_MAX when off. Laid out in the order the pass reads them.
+ *
+ * Compile after anomaly_eval_init() and again whenever a threshold
+ * changes. The fixed-point build compiles the same limits into wire
+ * units instead (anomaly_thresholds_to_fx).
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  /* Decisive */
+  float current_short_a, current_short_neg_a;
+  float current_emergency_a, current_emergency_neg_a;
+  float temp_emergency_c;
+  float dt_dt_emergency;
+
+  /* Per module */
+  float group_v_deviation_v;
+  float temp_warning_c;
+  float intra_module_dt_warn_c;
+  float swelling_warning_pct;
+  float z_warn; /* FLT_MAX when baseline drift is off */
+
+  /* Pack level */
+  float voltage_low_v, voltage_high_v;
+  float v_spread_warn_mv;
+  float current_warning_a, current_warning_neg_a;
+  float r_int_warning_mohm;
+  float inter_module_dt_warn_c;
+  float delta_t_ambient_warning;
+  float dt_dt_warning;
+  float gas_warning_ratio;
+  float pressure_warning_hpa;
+} anomaly_plan_t;
+
 /* -----------------------------------------------------------------------
  * Public API
  * ----------------------------------------------------------------------- */
@@ -184,14 +336,74 @@ typedef struct {
 /* Initialize with default thresholds for full 104S8P pack */
 void anomaly_eval_init(anomaly_thresholds_t *thresholds);
 
+/*
+ * Set threshold `id` (ANOMALY_THRESHOLD_COUNT ids) from milli-units,
+ * e.g. 55000 for 55 °C. HAL_ERROR for an unknown id or a value outside
+ * the field's plausible range (the set is left unchanged).
+ */
+hal_status_t anomaly_thresholds_set(anomaly_thresholds_t *thresholds,
+                                    uint8_t id, int32_t value_milli);
+
+/*
+ * Check a threshold set before it goes live: every field within its
+ * plausible range (trip and EMERGENCY levels under the hardware
+ * ceilings), each warning level below its critical/emergency level,
+ * the voltage window the right way round. HAL_ERROR if any check fails.
+ */
+hal_status_t anomaly_thresholds_check(const anomaly_thresholds_t *thresholds);
+
+/* Compile the per-pass limits from `thresholds` */
+void anomaly_plan_compile(anomaly_plan_t *plan,
+                          const anomaly_thresholds_t *thresholds);
+
 /* Compute derived fields in snapshot (call before anomaly_eval_run) */
 void anomaly_eval_compute(sensor_snapshot_t *snapshot,
                           const anomaly_thresholds_t *thresholds);
 
-/* Evaluate a sensor snapshot and return which categories are active */
+/* Invalidate all cached module statistics */
+void anomaly_eval_cache_init(anomaly_eval_cache_t *cache);
+
+/*
+ * Same results as anomaly_eval_compute(), but only modules in
+ * `dirty_modules` (or never cached) are recomputed from raw fields.
+ */
+void anomaly_eval_compute_incremental(sensor_snapshot_t *snapshot,
+                                      const anomaly_thresholds_t *thresholds,
+                                      anomaly_eval_cache_t *cache,
+                                      module_mask_t dirty_modules);
+
+/* Evaluate a sensor snapshot and return which categories are active.
+ * Compiles the plan on every call; loops use anomaly_eval_run_plan(). */
 anomaly_result_t anomaly_eval_run(const anomaly_thresholds_t *thresholds,
                                   const sensor_snapshot_t *snapshot);
 
+/* Same evaluation against a compiled plan */
+anomaly_result_t anomaly_eval_run_plan(const anomaly_plan_t *plan,
+                                       const sensor_snapshot_t *snapshot);
+
+/*
+ * Fast-loop trip path: as anomaly_eval_run(), but once the short-circuit
+ * or physics-limit checks have forced EMERGENCY it returns with only
+ * those categories (plus risk and cascade stage) filled in. The next
+ * med-loop pass evaluates the rest.
+ */
+anomaly_result_t anomaly_eval_run_trip(const anomaly_thresholds_t *thresholds,
+                                       const sensor_snapshot_t *snapshot);
+
+anomaly_result_t anomaly_eval_run_plan_trip(const anomaly_plan_t *plan,
+                                            const sensor_snapshot_t *snapshot);
+
+/*
+ * Batch form for gateways evaluating many packs: derives the fields of
+ * snapshots[i] and evaluates it into results[i], against one plan
+ * compiled for the whole batch. Reentrant — no state outside the
+ * arguments — so disjoint ranges may run on different threads (see
+ * fleet_eval.h).
+ */
+void anomaly_eval_run_batch(const anomaly_thresholds_t *thresholds,
+                            sensor_snapshot_t *snapshots,
+                            anomaly_result_t *results, uint32_t count);
+
 /* Count the number of set bits in a category mask */
 uint8_t anomaly_count_categories(uint8_t mask);
 
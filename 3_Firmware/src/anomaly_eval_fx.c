@@ -0,0 +1,454 @@
+/*
+ * anomaly_eval_fx.c — Fixed-Point Anomaly Evaluator (Wire Units)
+ *
+ * Check-for-check port of anomaly_eval.c. The only floats left are in
+ * the conversion helpers (run once at init, or for the float-producing
+ * inputs); the risk is left in Q15 (risk_q15) for the wire encoders.
+ */
+
+#include "anomaly_eval_fx.h"
+#include <string.h>
+
+/* Core temperature estimation, as the float path */
+#define FX_R_THERMAL_CW 3u /* °C/W for IFR32135 cylindrical */
+
+/* Cascade stage boundaries (milli-°C) — same as CASCADE_THRESHOLDS */
+static const int32_t CASCADE_THRESHOLDS_MC[] = {60000,  80000,  120000,
+                                                150000, 200000, 300000};
+#define NUM_CASCADE_THRESHOLDS_FX 6
+
+/* -----------------------------------------------------------------------
+ * Conversion helpers
+ * ----------------------------------------------------------------------- */
+
+/* Round to nearest, halves away from zero */
+static int32_t fx_round(float x) {
+  return x >= 0.0f ? (int32_t)(x + 0.5f) : -(int32_t)(-x + 0.5f);
+}
+
+/*
+ * Threshold in wire units. Values within float noise of a whole unit
+ * (0.55f × 1000 = 549.99997) snap to it; anything else is floored, or
+ * ceiled when `up` is set.
+ */
+static int32_t fx_threshold(float v, float scale, bool up) {
+  float x = v * scale;
+  int32_t n = fx_round(x);
+  float err = x - (float)n;
+  if (err < 1e-3f && err > -1e-3f)
+    return n;
+
+  int32_t f = (int32_t)x;
+  if ((float)f > x)
+    f--; /* Truncation rounded a negative value up */
+  return up ? f + 1 : f;
+}
+
+static inline int16_t fx_i16(int32_t v) {
+  if (v > INT16_MAX)
+    return INT16_MAX;
+  if (v < INT16_MIN)
+    return INT16_MIN;
+  return (int16_t)v;
+}
+
+static inline uint16_t fx_u16(int32_t v) {
+  if (v > UINT16_MAX)
+    return UINT16_MAX;
+  if (v < 0)
+    return 0;
+  return (uint16_t)v;
+}
+
+static inline uint8_t fx_u8(int32_t v) {
+  if (v > UINT8_MAX)
+    return UINT8_MAX;
+  if (v < 0)
+    return 0;
+  return (uint8_t)v;
+}
+
+void anomaly_thresholds_to_fx(anomaly_thresholds_fx_t *fx,
+                              const anomaly_thresholds_t *t) {
+  /* Electrical — "<" low bound ceils, everything else is ">" */
+  fx->voltage_low_dv = fx_u16(fx_threshold(t->voltage_low_v, 10.0f, true));
+  fx->voltage_high_dv = fx_u16(fx_threshold(t->voltage_high_v, 10.0f, false));
+  fx->group_v_deviation_x13 = fx_u16(fx_threshold(
+      t->group_v_deviation_mv, (float)GROUPS_PER_MODULE, false));
+  fx->v_spread_warn_mv = fx_u16(fx_threshold(t->v_spread_warn_mv, 1.0f, false));
+  fx->v_spread_crit_mv = fx_u16(fx_threshold(t->v_spread_crit_mv, 1.0f, false));
+  fx->current_warning_da = fx_threshold(t->current_warning_a, 10.0f, false);
+  fx->current_short_da = fx_threshold(t->current_short_a, 10.0f, false);
+  fx->r_int_warning_uohm =
+      fx_u16(fx_threshold(t->r_int_warning_mohm, 1000.0f, false));
+
+  /* Thermal — ambient compensation is ">=", so it ceils */
+  fx->temp_warning_dt = fx_i16(fx_threshold(t->temp_warning_c, 10.0f, false));
+  fx->temp_critical_dt = fx_i16(fx_threshold(t->temp_critical_c, 10.0f, false));
+  fx->dt_dt_warning_ddpm = fx_i16(fx_threshold(t->dt_dt_warning, 10.0f, false));
+  fx->inter_module_dt_warn_dt =
+      fx_i16(fx_threshold(t->inter_module_dt_warn_c, 10.0f, false));
+  fx->inter_module_dt_crit_dt =
+      fx_i16(fx_threshold(t->inter_module_dt_crit_c, 10.0f, false));
+  fx->intra_module_dt_warn_dt =
+      fx_i16(fx_threshold(t->intra_module_dt_warn_c, 10.0f, false));
+  fx->intra_module_dt_crit_dt =
+      fx_i16(fx_threshold(t->intra_module_dt_crit_c, 10.0f, false));
+  fx->delta_t_ambient_warning_dt =
+      fx_i16(fx_threshold(t->delta_t_ambient_warning, 10.0f, true));
+
+  /* Emergency */
+  fx->temp_emergency_dt =
+      fx_i16(fx_threshold(t->temp_emergency_c, 10.0f, false));
+  fx->dt_dt_emergency_ddpm =
+      fx_i16(fx_threshold(t->dt_dt_emergency, 10.0f, false));
+  fx->current_emergency_da = fx_threshold(t->current_emergency_a, 10.0f, false);
+
+  /* Gas ratios alarm when they fall below the threshold */
+  fx->gas_warning_cp = fx_u16(fx_threshold(t->gas_warning_ratio, 100.0f, true));
+  fx->gas_critical_cp =
+      fx_u16(fx_threshold(t->gas_critical_ratio, 100.0f, true));
+  fx->pressure_warning_chpa =
+      fx_i16(fx_threshold(t->pressure_warning_hpa, 100.0f, false));
+  fx->pressure_critical_chpa =
+      fx_i16(fx_threshold(t->pressure_critical_hpa, 100.0f, false));
+  fx->coolant_dt_min_dt = fx_i16(fx_threshold(t->coolant_dt_min_c, 10.0f, true));
+  fx->swelling_warning_pct =
+      fx_u8(fx_threshold(t->swelling_warning_pct, 1.0f, false));
+  fx->baseline_z_warning_dz =
+      fx_i16(fx_threshold(t->baseline_z_warning, 10.0f, false));
+}
+
+void anomaly_snapshot_to_fx_raw(sensor_snapshot_fx_t *fx,
+                                const sensor_snapshot_t *s) {
+  fx->pack_voltage_dv = fx_u16(fx_round(s->pack_voltage_v * 10.0f));
+  fx->pack_current_da = fx_i16(fx_round(s->pack_current_a * 10.0f));
+  fx->r_internal_uohm = fx_u16(fx_round(s->r_internal_mohm * 1000.0f));
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_t *mod = &s->modules[m];
+    module_data_fx_t *mfx = &fx->modules[m];
+    for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+      VPLANE_MV(&fx->vplane, m, g) =
+          fx_i16(fx_round(mod->group_voltages_v[g] * 1000.0f));
+    }
+    mfx->ntc1_dt = fx_i16(fx_round(mod->ntc1_c * 10.0f));
+    mfx->ntc2_dt = fx_i16(fx_round(mod->ntc2_c * 10.0f));
+    mfx->swelling_pct = fx_u8(fx_round(mod->swelling_pct));
+  }
+
+  fx->temp_ambient_dt = fx_i16(fx_round(s->temp_ambient_c * 10.0f));
+  fx->coolant_inlet_dt = fx_i16(fx_round(s->coolant_inlet_c * 10.0f));
+  fx->coolant_outlet_dt = fx_i16(fx_round(s->coolant_outlet_c * 10.0f));
+  fx->gas_ratio_1_cp = fx_u16(fx_round(s->gas_ratio_1 * 100.0f));
+  fx->gas_ratio_2_cp = fx_u16(fx_round(s->gas_ratio_2 * 100.0f));
+  fx->pressure_delta_1_chpa = fx_i16(fx_round(s->pressure_delta_1_hpa * 100.0f));
+  fx->pressure_delta_2_chpa = fx_i16(fx_round(s->pressure_delta_2_hpa * 100.0f));
+  fx->humidity_pct = fx_u8(fx_round(s->humidity_pct));
+  fx->isolation_dmohm = fx_u16(fx_round(s->isolation_mohm * 10.0f));
+  fx->short_circuit = s->short_circuit;
+  fx->stale_modules = s->stale_modules;
+}
+
+void anomaly_snapshot_to_fx(sensor_snapshot_fx_t *fx,
+                            const sensor_snapshot_t *s) {
+  anomaly_snapshot_to_fx_raw(fx, s);
+  for (int m = 0; m < NUM_MODULES; m++) {
+    fx->modules[m].max_dt_dt_ddpm =
+        fx_i16(fx_round(s->modules[m].max_dt_dt * 10.0f));
+    fx->modules[m].v_dev_dz = fx_i16(fx_round(s->modules[m].v_dev_z * 10.0f));
+    fx->modules[m].ntc_dz = fx_i16(fx_round(s->modules[m].ntc_z * 10.0f));
+  }
+  fx->gas_dz = fx_i16(fx_round(s->gas_z * 10.0f));
+}
+
+/* -----------------------------------------------------------------------
+ * Cascade stage
+ * ----------------------------------------------------------------------- */
+
+uint8_t get_cascade_stage_fx(int32_t core_temp_mc) {
+  for (int i = 0; i < NUM_CASCADE_THRESHOLDS_FX; i++) {
+    if (core_temp_mc <= CASCADE_THRESHOLDS_MC[i]) {
+      return (uint8_t)i;
+    }
+  }
+  return NUM_CASCADE_THRESHOLDS_FX; /* Full runaway */
+}
+
+/* -----------------------------------------------------------------------
+ * Compute derived fields
+ * ----------------------------------------------------------------------- */
+
+/* Per-module statistics: voltages from the plane scan, NTCs here */
+static void module_stats_fx_compute(const module_data_fx_t *mod,
+                                    const voltage_plane_stats_t *vs, int m,
+                                    module_stats_fx_t *st) {
+  st->v_min_mv = vs->min_mv[m];
+  st->v_max_mv = vs->max_mv[m];
+  st->module_mv = (uint32_t)vs->sum_mv[m];
+  st->v_spread_mv = (uint16_t)(vs->max_mv[m] - vs->min_mv[m]);
+
+  int32_t d = (int32_t)mod->ntc1_dt - mod->ntc2_dt;
+  st->delta_t_intra_dt = (uint16_t)(d < 0 ? -d : d);
+  st->t_min_dt = mod->ntc1_dt < mod->ntc2_dt ? mod->ntc1_dt : mod->ntc2_dt;
+  st->t_max_dt = mod->ntc1_dt > mod->ntc2_dt ? mod->ntc1_dt : mod->ntc2_dt;
+}
+
+void anomaly_eval_fx_cache_init(anomaly_eval_fx_cache_t *cache) {
+  memset(cache, 0, sizeof(anomaly_eval_fx_cache_t));
+}
+
+void anomaly_eval_fx_compute_incremental(sensor_snapshot_fx_t *s,
+                                         const anomaly_thresholds_fx_t *t,
+                                         anomaly_eval_fx_cache_t *cache,
+                                         module_mask_t dirty_modules) {
+  (void)t; /* Same signature as the float compute */
+
+  int16_t global_v_min = INT16_MAX;
+  int16_t global_v_max = 0;
+  int16_t global_t_min = INT16_MAX;
+  int16_t global_t_max = INT16_MIN;
+  int16_t max_dt_dt = 0;
+  int16_t max_temp = -9990; /* -999.0 °C, as the float path */
+  uint8_t hot_module = 0;
+
+  module_mask_t recompute =
+      (module_mask_t)((dirty_modules | (module_mask_t)~cache->valid_mask) &
+                      MODULE_MASK_ALL);
+
+  /* The plane is scanned whole: across-module lanes make eight modules
+   * cost about what one does, and a frame cycle dirties all of them */
+  voltage_plane_stats_t vs;
+  if (recompute)
+    voltage_plane_scan(&s->vplane, &vs);
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    module_data_fx_t *mod = &s->modules[m];
+    module_stats_fx_t *st = &cache->mod[m];
+
+    if (recompute & MODULE_BIT(m))
+      module_stats_fx_compute(mod, &vs, m, st);
+
+    mod->module_mv = st->module_mv;
+    mod->v_spread_mv = st->v_spread_mv;
+    mod->v_min_mv = st->v_min_mv;
+    mod->v_max_mv = st->v_max_mv;
+    mod->delta_t_intra_dt = st->delta_t_intra_dt;
+
+    if (st->v_min_mv < global_v_min)
+      global_v_min = st->v_min_mv;
+    if (st->v_max_mv > global_v_max)
+      global_v_max = st->v_max_mv;
+    if (st->t_min_dt < global_t_min)
+      global_t_min = st->t_min_dt;
+    if (st->t_max_dt > global_t_max)
+      global_t_max = st->t_max_dt;
+
+    if (st->t_max_dt > max_temp) {
+      max_temp = st->t_max_dt;
+      hot_module = (uint8_t)(m + 1);
+    }
+
+    if (mod->max_dt_dt_ddpm > max_dt_dt)
+      max_dt_dt = mod->max_dt_dt_ddpm;
+  }
+  cache->valid_mask |= recompute;
+
+  s->v_spread_mv =
+      global_v_max > global_v_min ? (uint16_t)(global_v_max - global_v_min) : 0;
+  s->temp_spread_dt = fx_i16((int32_t)global_t_max - global_t_min);
+  s->dt_dt_max_ddpm = max_dt_dt;
+  s->hotspot_module = hot_module;
+  s->hotspot_temp_dt = max_temp;
+
+  /* T_core = T_surface + (I_pack/8)² × R_int × R_thermal, in milli-°C:
+   *   (I_da/80)² × (R_uohm/1e6) × R_th × 1000 = I_da² × R_uohm × R_th / 6.4e6
+   * The 64-bit product is integer multiply, not soft-float. */
+  uint32_t i_abs = (uint32_t)(s->pack_current_da < 0 ? -s->pack_current_da
+                                                     : s->pack_current_da);
+  uint64_t heat = (uint64_t)(i_abs * i_abs) * s->r_internal_uohm *
+                  FX_R_THERMAL_CW;
+  s->t_core_est_mc = (int32_t)max_temp * 100 + (int32_t)(heat / 6400000u);
+
+  s->coolant_delta_dt =
+      fx_i16((int32_t)s->coolant_outlet_dt - s->coolant_inlet_dt);
+}
+
+void anomaly_eval_fx_compute(sensor_snapshot_fx_t *s,
+                             const anomaly_thresholds_fx_t *t) {
+  anomaly_eval_fx_cache_t scratch;
+  scratch.valid_mask = 0; /* Everything recomputed */
+  anomaly_eval_fx_compute_incremental(s, t, &scratch, MODULE_MASK_ALL);
+}
+
+/* -----------------------------------------------------------------------
+ * Main evaluation function
+ *
+ * Same order as the float path: decisive checks, risk, one fused
+ * module pass, then pack-level checks skipped once their category is
+ * already active.
+ * ----------------------------------------------------------------------- */
+
+static inline int16_t max_i16(int16_t a, int16_t b) { return a > b ? a : b; }
+
+HAL_FAST_CODE
+static anomaly_result_t eval_fx_run(const anomaly_thresholds_fx_t *t,
+                                    const sensor_snapshot_fx_t *s,
+                                    bool trip) {
+  anomaly_result_t result;
+  result.active_mask = CAT_NONE;
+  result.is_short_circuit = false;
+  result.is_emergency_direct = false;
+  result.hotspot_module = s->hotspot_module;
+  result.anomaly_modules_mask = 0;
+  result.stale_modules_mask = s->stale_modules;
+  result.risk_factor = 0.0f; /* Integer store; the risk is risk_q15 */
+  result.risk_q15 = 0;
+  result.cascade_stage = 0;
+
+  /* === DECISIVE CHECKS === */
+  int32_t abs_current = s->pack_current_da;
+  if (abs_current < 0)
+    abs_current = -abs_current;
+
+  if (s->short_circuit || abs_current > t->current_short_da) {
+    result.is_short_circuit = true;
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  if (abs_current > t->current_emergency_da) {
+    result.is_emergency_direct = true;
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  int16_t max_ntc = -9990;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    max_ntc = max_i16(max_ntc, max_i16(s->modules[m].ntc1_dt,
+                                       s->modules[m].ntc2_dt));
+  }
+  if (max_ntc > t->temp_emergency_dt ||
+      s->dt_dt_max_ddpm > t->dt_dt_emergency_ddpm) {
+    result.is_emergency_direct = true;
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* === THERMAL RUNAWAY RISK ASSESSMENT ===
+   * Same weights as the float path, with each factor folded into one
+   * exact integer ratio (e.g. 32768 / 240000 °mC = 2048 / 15000). Each
+   * term is capped well inside 32 bits, so one clamp at the end. */
+  uint16_t worst_gas = s->gas_ratio_1_cp < s->gas_ratio_2_cp
+                           ? s->gas_ratio_1_cp
+                           : s->gas_ratio_2_cp;
+  int16_t worst_pressure =
+      max_i16(s->pressure_delta_1_chpa, s->pressure_delta_2_chpa);
+
+  result.cascade_stage = get_cascade_stage_fx(s->t_core_est_mc);
+
+  uint32_t risk = 0;
+
+  /* Temperature: linear from 60 °C to 300 °C */
+  if (s->t_core_est_mc > 60000) {
+    uint32_t over = (uint32_t)(s->t_core_est_mc - 60000);
+    risk += over >= 240000u ? FX_Q15_ONE : over * 2048u / 15000u;
+  }
+
+  /* dT/dt: 0.05 per °C/min */
+  if (s->dt_dt_max_ddpm > 1)
+    risk += (uint32_t)s->dt_dt_max_ddpm * 4096u / 25u;
+
+  /* Gas: 0.5 per unit of ratio below 0.8 */
+  if (worst_gas < 80)
+    risk += (80u - worst_gas) * 4096u / 25u;
+
+  /* Pressure: 0.02 per hPa above 1 hPa */
+  if (worst_pressure > 100)
+    risk += (uint32_t)worst_pressure * 4096u / 625u;
+
+  if (risk > FX_Q15_ONE)
+    risk = FX_Q15_ONE;
+  result.risk_q15 = (uint16_t)risk;
+
+  if (trip && (result.is_short_circuit || result.is_emergency_direct)) {
+    result.active_count = anomaly_count_categories(result.active_mask);
+    return result;
+  }
+
+  /* === PER-MODULE CHECKS ===
+   * |V_g - sum/13| > dev  <=>  |13·V_g - sum| > 13·dev, and the worst
+   * group is an extreme — two compares per module, no divide */
+  int16_t z_warn =
+      t->baseline_z_warning_dz > 0 ? t->baseline_z_warning_dz : INT16_MAX;
+  module_mask_t elec_mods = 0, therm_mods = 0, swell_mods = 0;
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_fx_t *mod = &s->modules[m];
+    int16_t ntc = max_i16(mod->ntc1_dt, mod->ntc2_dt);
+
+    unsigned elec =
+        (unsigned)voltage_plane_dev_exceeds((int32_t)mod->module_mv,
+                                            mod->v_min_mv, mod->v_max_mv,
+                                            t->group_v_deviation_x13) |
+        (unsigned)(mod->v_dev_dz > z_warn);
+    unsigned therm = (unsigned)(ntc > t->temp_warning_dt) |
+                     (unsigned)(mod->delta_t_intra_dt > t->intra_module_dt_warn_dt) |
+                     (unsigned)(mod->ntc_dz > z_warn);
+    unsigned swell = (unsigned)(mod->swelling_pct > t->swelling_warning_pct);
+
+    elec_mods |= (module_mask_t)((module_mask_t)elec << m);
+    therm_mods |= (module_mask_t)((module_mask_t)therm << m);
+    swell_mods |= (module_mask_t)((module_mask_t)swell << m);
+  }
+
+  result.anomaly_modules_mask =
+      (module_mask_t)(elec_mods | therm_mods | swell_mods);
+  if (elec_mods)
+    result.active_mask |= CAT_ELECTRICAL;
+  if (therm_mods)
+    result.active_mask |= CAT_THERMAL;
+  if (swell_mods)
+    result.active_mask |= CAT_SWELLING;
+
+  /* === ELECTRICAL CATEGORY === */
+  if (!(result.active_mask & CAT_ELECTRICAL) &&
+      (s->pack_voltage_dv < t->voltage_low_dv ||
+       s->pack_voltage_dv > t->voltage_high_dv ||
+       s->v_spread_mv > t->v_spread_warn_mv ||
+       abs_current > t->current_warning_da ||
+       s->r_internal_uohm > t->r_int_warning_uohm)) {
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* === THERMAL CATEGORY === */
+  if (!(result.active_mask & CAT_THERMAL) &&
+      (s->temp_spread_dt > t->inter_module_dt_warn_dt ||
+       (int32_t)max_ntc - s->temp_ambient_dt >= t->delta_t_ambient_warning_dt ||
+       s->dt_dt_max_ddpm > t->dt_dt_warning_ddpm)) {
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* === GAS CATEGORY === */
+  if (worst_gas < t->gas_warning_cp || s->gas_dz > z_warn) {
+    result.active_mask |= CAT_GAS;
+  }
+
+  /* === PRESSURE CATEGORY === */
+  if (worst_pressure > t->pressure_warning_chpa) {
+    result.active_mask |= CAT_PRESSURE;
+  }
+
+  result.active_count = anomaly_count_categories(result.active_mask);
+
+  return result;
+}
+
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_fx_run(const anomaly_thresholds_fx_t *t,
+                                     const sensor_snapshot_fx_t *s) {
+  return eval_fx_run(t, s, false);
+}
+
+HAL_FAST_CODE
+anomaly_result_t anomaly_eval_fx_run_trip(const anomaly_thresholds_fx_t *t,
+                                          const sensor_snapshot_fx_t *s) {
+  return eval_fx_run(t, s, true);
+}
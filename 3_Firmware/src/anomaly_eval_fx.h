@@ -0,0 +1,203 @@
+/*
+ * anomaly_eval_fx.h — Fixed-Point Anomaly Evaluator (Wire Units)
+ *
+ * Integer twin of anomaly_eval for the THEJAS32, which has no FPU:
+ * every float compare in the float evaluator is a libgcc call. Here
+ * the snapshot and thresholds are kept in the units the digital twin
+ * sends them in, so decoding a frame is a plain copy and the whole
+ * compute/run path is integer compares and adds.
+ *
+ *   Voltage      pack: deci-volts (dV)     groups: millivolts (mV)
+ *   Current      deci-amps (dA)
+ *   Temperature  deci-°C (dt)              dT/dt: deci-°C/min (ddpm)
+ *   Gas ratio    ×100 (cp)                 Pressure: centi-hPa (chpa)
+ *   R_int        micro-ohms (µΩ)           Core temp: milli-°C (mc)
+ *   Risk factor  Q15 (32768 = 1.0)
+ *
+ * Results are the same anomaly_result_t the float path produces (the
+ * risk in risk_q15 only, see anomaly_risk_pct_fx()), so
+ * the correlation engine is unchanged; telemetry and the black box
+ * have _fx encoders that read this snapshot (packet_format.h). Thresholds
+ * stay configured in float (anomaly_eval_init) and are converted once.
+ *
+ * Selected at build time with ANOMALY_EVAL_FIXED_POINT=1; the float
+ * evaluator remains the reference and is checked against this one by
+ * the host tests.
+ */
+
+#ifndef ANOMALY_EVAL_FX_H
+#define ANOMALY_EVAL_FX_H
+
+#include "anomaly_eval.h"
+#include "voltage_plane.h"
+
+#ifndef ANOMALY_EVAL_FIXED_POINT
+#define ANOMALY_EVAL_FIXED_POINT 0
+#endif
+
+#define FX_Q15_ONE 32768u
+
+/* -----------------------------------------------------------------------
+ * Thresholds — same fields as anomaly_thresholds_t, in wire units
+ *
+ * Rounded so that the integer compare gives the same answer as the
+ * float compare for every integer reading: floored for ">" checks,
+ * ceiled for "<" and ">=" checks.
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  /* Electrical */
+  uint16_t voltage_low_dv;
+  uint16_t voltage_high_dv;
+  uint16_t group_v_deviation_x13; /* mV × GROUPS_PER_MODULE (no divide) */
+  uint16_t v_spread_warn_mv;
+  uint16_t v_spread_crit_mv;
+  int32_t current_warning_da;
+  int32_t current_short_da;
+  uint16_t r_int_warning_uohm;
+
+  /* Thermal */
+  int16_t temp_warning_dt;
+  int16_t temp_critical_dt;
+  int16_t dt_dt_warning_ddpm;
+  int16_t inter_module_dt_warn_dt;
+  int16_t inter_module_dt_crit_dt;
+  int16_t intra_module_dt_warn_dt;
+  int16_t intra_module_dt_crit_dt;
+  int16_t delta_t_ambient_warning_dt;
+
+  /* Emergency */
+  int16_t temp_emergency_dt;
+  int16_t dt_dt_emergency_ddpm;
+  int32_t current_emergency_da;
+
+  /* Gas / pressure / coolant / mechanical */
+  uint16_t gas_warning_cp;
+  uint16_t gas_critical_cp;
+  int16_t pressure_warning_chpa;
+  int16_t pressure_critical_chpa;
+  int16_t coolant_dt_min_dt;
+  uint8_t swelling_warning_pct;
+
+  int16_t baseline_z_warning_dz; /* σ × 10; 0 = off */
+} anomaly_thresholds_fx_t;
+
+/* -----------------------------------------------------------------------
+ * Snapshot — same layout as sensor_snapshot_t, in wire units
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  int16_t ntc1_dt;
+  int16_t ntc2_dt;
+  uint8_t swelling_pct;
+  /* Computed fields */
+  int16_t max_dt_dt_ddpm;
+  uint16_t delta_t_intra_dt;
+  uint32_t module_mv;                   /* Sum of 13 group voltages      */
+  uint16_t v_spread_mv;
+  int16_t v_min_mv;                     /* Extremes, for the deviation   */
+  int16_t v_max_mv;                     /* check in anomaly_eval_fx_run  */
+  int16_t v_dev_dz;                     /* Baseline drift, σ × 10        */
+  int16_t ntc_dz;
+} module_data_fx_t;
+
+typedef struct {
+  /* Electrical — pack level */
+  uint16_t pack_voltage_dv;
+  int16_t pack_current_da;
+  uint16_t r_internal_uohm;
+
+  /* Group voltages (v_base_mv + v_delta[g]) as one SoA plane */
+  voltage_plane_t vplane;
+  module_data_fx_t modules[NUM_MODULES];
+
+  /* Environment */
+  int16_t temp_ambient_dt;
+  int16_t coolant_inlet_dt;
+  int16_t coolant_outlet_dt;
+  uint16_t gas_ratio_1_cp;
+  uint16_t gas_ratio_2_cp;
+  int16_t pressure_delta_1_chpa;
+  int16_t pressure_delta_2_chpa;
+  uint8_t humidity_pct;
+  uint16_t isolation_dmohm;     /* MΩ × 10                               */
+
+  /* Computed fields */
+  int16_t dt_dt_max_ddpm;
+  uint16_t v_spread_mv;
+  int16_t temp_spread_dt;
+  int32_t t_core_est_mc;        /* Finer than the NTCs: I²R heating is   */
+                                /* fractions of a deci-degree            */
+  int16_t coolant_delta_dt;
+  uint8_t hotspot_module;
+  int16_t hotspot_temp_dt;
+  int16_t gas_dz;               /* Baseline drift, σ × 10                */
+
+  bool short_circuit;
+  module_mask_t stale_modules;
+} sensor_snapshot_fx_t;
+
+/* Incremental compute cache, as anomaly_eval_cache_t */
+typedef struct {
+  int16_t v_min_mv, v_max_mv;
+  int16_t t_min_dt, t_max_dt;
+  uint32_t module_mv;
+  uint16_t v_spread_mv;
+  uint16_t delta_t_intra_dt;
+} module_stats_fx_t;
+
+typedef struct {
+  module_stats_fx_t mod[NUM_MODULES];
+  module_mask_t valid_mask;
+} anomaly_eval_fx_cache_t;
+
+/* -----------------------------------------------------------------------
+ * Conversions
+ * ----------------------------------------------------------------------- */
+
+/* Convert float thresholds (anomaly_eval_init or reconfigured) */
+void anomaly_thresholds_to_fx(anomaly_thresholds_fx_t *fx,
+                              const anomaly_thresholds_t *t);
+
+/* Quantise a float snapshot to wire units (rounded to nearest): the
+ * raw fields, the short-circuit flag and the stale modules. Used for
+ * the float-producing inputs (fallback sim, on-board sensors); the
+ * twin's frames are decoded straight into wire units (input_packet.h). */
+void anomaly_snapshot_to_fx_raw(sensor_snapshot_fx_t *fx,
+                                const sensor_snapshot_t *s);
+
+/* As anomaly_snapshot_to_fx_raw(), plus the per-module dT/dt and the
+ * baseline z-scores the float slot carries */
+void anomaly_snapshot_to_fx(sensor_snapshot_fx_t *fx,
+                            const sensor_snapshot_t *s);
+
+/* -----------------------------------------------------------------------
+ * Evaluation — mirrors the float API
+ * ----------------------------------------------------------------------- */
+
+void anomaly_eval_fx_cache_init(anomaly_eval_fx_cache_t *cache);
+
+void anomaly_eval_fx_compute(sensor_snapshot_fx_t *snapshot,
+                             const anomaly_thresholds_fx_t *thresholds);
+
+void anomaly_eval_fx_compute_incremental(
+    sensor_snapshot_fx_t *snapshot, const anomaly_thresholds_fx_t *thresholds,
+    anomaly_eval_fx_cache_t *cache, module_mask_t dirty_modules);
+
+anomaly_result_t anomaly_eval_fx_run(const anomaly_thresholds_fx_t *thresholds,
+                                     const sensor_snapshot_fx_t *snapshot);
+
+/* As anomaly_eval_run_trip() */
+anomaly_result_t
+anomaly_eval_fx_run_trip(const anomaly_thresholds_fx_t *thresholds,
+                         const sensor_snapshot_fx_t *snapshot);
+
+/* Risk factor as a rounded percentage, from risk_q15 */
+static inline uint8_t anomaly_risk_pct_fx(const anomaly_result_t *r) {
+  return (uint8_t)(((uint32_t)r->risk_q15 * 100u + FX_Q15_ONE / 2u) >> 15);
+}
+
+/* Cascade stage from core temperature in milli-°C */
+uint8_t get_cascade_stage_fx(int32_t core_temp_mc);
+
+#endif /* ANOMALY_EVAL_FX_H */
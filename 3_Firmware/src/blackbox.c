@@ -0,0 +1,330 @@
+/*
+ * blackbox.c — Flash Black-Box Event Recorder
+ */
+
+#include "blackbox.h"
+#include "crc16.h"
+#include "packet_format.h"
+#include <string.h>
+
+_Static_assert(sizeof(blackbox_rec_hdr_t) == 12, "record header layout");
+_Static_assert(sizeof(blackbox_sector_hdr_t) == 16, "sector header layout");
+_Static_assert(BLACKBOX_SECTOR_RECORDS >= 1, "a record must fit a sector");
+_Static_assert(BLACKBOX_RING_RECORDS <= 255, "ring indices are 8-bit");
+_Static_assert(BLACKBOX_DUMP_MAX_FRAME <= 255, "dump frame length is 8-bit");
+
+#define RING BLACKBOX_RING_RECORDS
+#define NSECT HAL_FLASH_LOG_SECTORS
+#define SECTOR_ADDR(s)                                                         \
+  (HAL_FLASH_LOG_BASE + (uint32_t)(s) * HAL_FLASH_SECTOR_SIZE)
+
+static bool read_header(uint8_t sector, blackbox_sector_hdr_t *h) {
+  if (hal_flash_read(SECTOR_ADDR(sector), (uint8_t *)h, sizeof(*h)) != HAL_OK)
+    return false;
+  return h->magic == BLACKBOX_SECTOR_MAGIC &&
+         h->crc == crc16_block(CRC16_INIT, (const uint8_t *)h,
+                               sizeof(*h) - 2u);
+}
+
+/* -----------------------------------------------------------------------
+ * Init — find the head of the log
+ * ----------------------------------------------------------------------- */
+void blackbox_init(blackbox_t *bb) {
+  memset(bb, 0, sizeof(blackbox_t));
+  bb->log_head = NSECT - 1; /* First event then lands in sector 0 */
+  bb->next_seq = 1;
+
+  for (uint8_t s = 0; s < NSECT; s++) {
+    blackbox_sector_hdr_t h;
+    if (!read_header(s, &h))
+      continue;
+    if (!bb->have_log || (int32_t)(h.seq - (bb->next_seq - 1u)) > 0) {
+      bb->have_log = true;
+      bb->log_head = s;
+      bb->next_seq = h.seq + 1u;
+      bb->event = h.event;
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Recording
+ * ----------------------------------------------------------------------- */
+bool blackbox_note_state(blackbox_t *bb, system_state_t state) {
+  bool rise = state >= STATE_CRITICAL && state > bb->last_state;
+  bb->last_state = state;
+  if (!rise)
+    return false;
+
+  bb->post_left = BLACKBOX_POST_RECORDS;
+  bb->mark_trigger = true;
+  if (bb->capturing)
+    return false; /* Escalation inside an event: extend it */
+
+  /* Freeze what the ring holds as the pre-trigger window */
+  bb->capturing = true;
+  bb->unflushed = bb->count < BLACKBOX_PRE_RECORDS ? bb->count
+                                                   : BLACKBOX_PRE_RECORDS;
+  bb->event++;
+  bb->events++;
+  bb->event_sectors = 0;
+  bb->sector_open = false; /* Events start on a fresh sector */
+  bb->rec_off = 0;
+  return true;
+}
+
+/* Claim the next ring slot and write the record header. Returns the
+ * slot (frames follow the header), or NULL if the pass is not kept. */
+static uint8_t *record_begin(blackbox_t *bb, uint32_t t_ms,
+                             const anomaly_result_t *anomaly,
+                             system_state_t state, uint8_t risk_pct,
+                             bool stale, bool shorted) {
+  if (bb->capturing) {
+    if (bb->post_left == 0)
+      return NULL; /* Window full; waiting for the flash to catch up */
+    bb->post_left--;
+    if (bb->unflushed == RING) {
+      bb->dropped++; /* Flash behind: never overwrite the event */
+      return NULL;
+    }
+  }
+  if (bb->count == RING)
+    bb->count--; /* Oldest record (already flushed, or no event) */
+
+  uint8_t *r = bb->ring[bb->head];
+  blackbox_rec_hdr_t h;
+  h.magic = BLACKBOX_REC_MAGIC;
+  h.state = (uint8_t)state;
+  h.active_mask = anomaly->active_mask;
+  h.risk_pct = risk_pct;
+  h.flags = (bb->mark_trigger ? BLACKBOX_REC_TRIGGER : 0) |
+            (stale ? BLACKBOX_REC_STALE : 0) |
+            (shorted ? BLACKBOX_REC_SHORT : 0);
+  h.reserved = 0;
+  h.seq = bb->rec_seq++;
+  h.t_ms = t_ms;
+  bb->mark_trigger = false;
+  memcpy(r, &h, sizeof(h));
+  return r;
+}
+
+/* Seal the frames with the CRC and commit the slot */
+static void record_end(blackbox_t *bb, uint8_t *r) {
+  uint16_t off = BLACKBOX_REC_SIZE - 2;
+  uint16_t crc = crc16_block(CRC16_INIT, r, off);
+  r[off] = (uint8_t)crc;
+  r[off + 1] = (uint8_t)(crc >> 8);
+
+  bb->head = (uint8_t)((bb->head + 1u) % RING);
+  bb->count++;
+  if (bb->capturing)
+    bb->unflushed++;
+}
+
+void blackbox_record(blackbox_t *bb, uint32_t t_ms,
+                     const sensor_snapshot_t *snap,
+                     const anomaly_result_t *anomaly, system_state_t state) {
+  uint8_t *r = record_begin(bb, t_ms, anomaly, state,
+                            (uint8_t)(anomaly->risk_factor * 100.0f + 0.5f),
+                            snap->stale_modules != 0, snap->short_circuit);
+  if (!r)
+    return;
+
+  uint16_t off = sizeof(blackbox_rec_hdr_t);
+  packet_encode_input_pack((input_pack_frame_t *)(r + off), snap);
+  off += INPUT_PACK_FRAME_SIZE;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    packet_encode_input_module((input_module_frame_t *)(r + off), m, snap);
+    off += INPUT_MODULE_FRAME_SIZE;
+  }
+  record_end(bb, r);
+}
+
+void blackbox_record_fx(blackbox_t *bb, uint32_t t_ms,
+                        const sensor_snapshot_fx_t *snap,
+                        const anomaly_result_t *anomaly, system_state_t state) {
+  uint8_t *r = record_begin(bb, t_ms, anomaly, state,
+                            anomaly_risk_pct_fx(anomaly),
+                            snap->stale_modules != 0, snap->short_circuit);
+  if (!r)
+    return;
+
+  uint16_t off = sizeof(blackbox_rec_hdr_t);
+  packet_encode_input_pack_fx((input_pack_frame_t *)(r + off), snap);
+  off += INPUT_PACK_FRAME_SIZE;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    packet_encode_input_module_fx((input_module_frame_t *)(r + off), m, snap);
+    off += INPUT_MODULE_FRAME_SIZE;
+  }
+  record_end(bb, r);
+}
+
+/* -----------------------------------------------------------------------
+ * Flash writer — one command per call
+ * ----------------------------------------------------------------------- */
+static void end_capture(blackbox_t *bb) {
+  bb->capturing = false;
+  bb->sector_open = false;
+  bb->count = 0; /* Logged; the next pre-window starts from here */
+}
+
+void blackbox_poll(blackbox_t *bb) {
+  if (!bb->capturing)
+    return;
+  if (bb->unflushed == 0) {
+    if (bb->post_left == 0)
+      end_capture(bb);
+    return;
+  }
+  if (hal_flash_busy())
+    return;
+
+  /* Erase done: stamp the sector */
+  if (bb->erase_pending) {
+    blackbox_sector_hdr_t h;
+    h.magic = BLACKBOX_SECTOR_MAGIC;
+    h.seq = bb->next_seq;
+    h.event = bb->event;
+    h.rec_size = BLACKBOX_REC_SIZE;
+    h.num_modules = NUM_MODULES;
+    h.reserved = 0xFF;
+    h.crc = crc16_block(CRC16_INIT, (const uint8_t *)&h, sizeof(h) - 2u);
+    if (hal_flash_program(SECTOR_ADDR(bb->log_head), (const uint8_t *)&h,
+                          sizeof(h)) != HAL_OK) {
+      bb->flash_errors++;
+      return;
+    }
+    bb->next_seq++;
+    bb->erase_pending = false;
+    bb->sector_open = true;
+    bb->have_log = true;
+    bb->write_off = sizeof(h);
+    bb->event_sectors++;
+    return;
+  }
+
+  /* Records never straddle sectors: move on to the next one */
+  if (bb->rec_off == 0 &&
+      (!bb->sector_open ||
+       bb->write_off + BLACKBOX_REC_SIZE > HAL_FLASH_SECTOR_SIZE)) {
+    if (bb->event_sectors >= BLACKBOX_MAX_EVENT_SECTORS) {
+      bb->dropped += bb->unflushed; /* Event would crowd out the log */
+      bb->unflushed = 0;
+      bb->post_left = 0;
+      end_capture(bb);
+      return;
+    }
+    uint8_t next = (uint8_t)((bb->log_head + 1u) % NSECT);
+    if (hal_flash_erase_sector(SECTOR_ADDR(next)) != HAL_OK) {
+      bb->flash_errors++;
+      return;
+    }
+    bb->log_head = next;
+    bb->sector_open = false;
+    bb->erase_pending = true;
+    return;
+  }
+
+  /* Next piece of the oldest unflushed record, up to a page boundary */
+  const uint8_t *r = bb->ring[(bb->head + RING - bb->unflushed) % RING];
+  uint32_t addr = SECTOR_ADDR(bb->log_head) + bb->write_off;
+  uint16_t n = (uint16_t)(BLACKBOX_REC_SIZE - bb->rec_off);
+  uint16_t room = (uint16_t)(HAL_FLASH_PAGE_SIZE - addr % HAL_FLASH_PAGE_SIZE);
+  if (n > room)
+    n = room;
+  if (hal_flash_program(addr, r + bb->rec_off, n) != HAL_OK) {
+    bb->flash_errors++;
+    return;
+  }
+  bb->write_off += n;
+  bb->rec_off += n;
+  if (bb->rec_off == BLACKBOX_REC_SIZE) {
+    bb->rec_off = 0;
+    bb->unflushed--;
+    if (bb->unflushed == 0 && bb->post_left == 0)
+      end_capture(bb);
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Dump
+ * ----------------------------------------------------------------------- */
+void blackbox_dump_begin(blackbox_t *bb, uint8_t newest) {
+  bb->dumping = bb->have_log;
+  bb->dump_all = newest == 0;
+  bb->dump_event_min = (uint16_t)(bb->event - newest + 1u);
+  bb->dump_step = 0;
+  bb->dump_off = 0;
+  bb->dump_end = 0;
+  bb->dump_chunk = 0;
+  bb->dump_bytes = 0;
+}
+
+static uint8_t dump_frame(blackbox_t *bb, uint8_t *frame, uint8_t flags,
+                          uint32_t offset, uint8_t n) {
+  uint8_t len = (uint8_t)(BLACKBOX_DUMP_HEADER + n + 1u);
+  frame[0] = PACKET_SYNC_BYTE;
+  frame[1] = len;
+  frame[2] = PACKET_TYPE_BLACKBOX;
+  frame[3] = flags;
+  frame[4] = (uint8_t)bb->dump_chunk;
+  frame[5] = (uint8_t)(bb->dump_chunk >> 8);
+  frame[6] = (uint8_t)offset;
+  frame[7] = (uint8_t)(offset >> 8);
+  frame[8] = (uint8_t)(offset >> 16);
+  frame[9] = (uint8_t)(offset >> 24);
+  frame[len - 1u] = packet_checksum(frame, (uint8_t)(len - 1u));
+  bb->dump_chunk++;
+  return len;
+}
+
+uint8_t blackbox_dump_next(blackbox_t *bb, uint8_t *frame) {
+  if (!bb->dumping)
+    return 0;
+  if (hal_flash_busy())
+    return 0; /* Writer has the flash; try next pass */
+
+  while (bb->dump_step < NSECT) {
+    uint8_t sector = (uint8_t)((bb->log_head + 1u + bb->dump_step) % NSECT);
+
+    if (bb->dump_end == 0) {
+      /* Entering a sector: header, then records up to the first blank */
+      blackbox_sector_hdr_t h;
+      if (!read_header(sector, &h) || h.rec_size == 0 ||
+          (!bb->dump_all && (int16_t)(h.event - bb->dump_event_min) < 0)) {
+        bb->dump_step++;
+        continue;
+      }
+      uint16_t end = sizeof(h);
+      while (end + h.rec_size <= HAL_FLASH_SECTOR_SIZE) {
+        uint8_t magic;
+        if (hal_flash_read(SECTOR_ADDR(sector) + end, &magic, 1) != HAL_OK ||
+            magic != BLACKBOX_REC_MAGIC)
+          break;
+        end += h.rec_size;
+      }
+      bb->dump_end = end;
+      bb->dump_off = 0;
+    }
+
+    if (bb->dump_off < bb->dump_end) {
+      uint16_t n = bb->dump_end - bb->dump_off;
+      if (n > BLACKBOX_DUMP_CHUNK)
+        n = BLACKBOX_DUMP_CHUNK;
+      if (hal_flash_read(SECTOR_ADDR(sector) + bb->dump_off,
+                         frame + BLACKBOX_DUMP_HEADER, n) != HAL_OK)
+        return 0;
+      uint32_t offset =
+          (uint32_t)sector * HAL_FLASH_SECTOR_SIZE + bb->dump_off;
+      bb->dump_off += n;
+      bb->dump_bytes += n;
+      return dump_frame(bb, frame, 0, offset, (uint8_t)n);
+    }
+
+    bb->dump_end = 0;
+    bb->dump_step++;
+  }
+
+  bb->dumping = false;
+  return dump_frame(bb, frame, BLACKBOX_DUMP_END, bb->dump_bytes, 0);
+}
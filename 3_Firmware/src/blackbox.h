@@ -0,0 +1,186 @@
+/*
+ * blackbox.h — Flash Black-Box Event Recorder
+ *
+ * Keeps the last few seconds of sensor input so a relay trip can be
+ * reconstructed afterwards, not just the 5 s telemetry the dashboard
+ * happened to catch.
+ *
+ *   med_loop ──record──▶ RAM ring (BLACKBOX_RAM_BYTES)
+ *                          │  trigger: → CRITICAL / → EMERGENCY
+ *                          ▼  pre-trigger window frozen
+ *                 blackbox_poll ──▶ flash log (circular, wear-levelled)
+ *                          ▲
+ *   + BLACKBOX_POST_RECORDS post-trigger records (the med loop runs at
+ *     its 100 ms alert rate by then, so this is the burst)
+ *
+ * Record: a small header, then the snapshot as the input-link frames
+ * the twin sends (packet_encode_input_*), then a CRC-16. A dump can be
+ * fed straight back through input_rx_feed() or the twin's decoders.
+ * Until a trigger the ring just overwrites its oldest record; flash is
+ * written only for events, and a record is logged at most once (the
+ * next event's pre-window starts after the previous one's last record).
+ *
+ * Flash log: HAL_FLASH_LOG_SECTORS sectors used strictly in rotation,
+ * each starting with a header carrying a sequence number. Every event
+ * starts on a fresh sector; the oldest sector is erased when it is
+ * reused, so every sector sees the same number of erase cycles. At boot
+ * the highest valid sequence number is the head — no separate index to
+ * wear out or lose. An event spans at most half the log.
+ *
+ * Nothing here waits: blackbox_poll() issues at most one flash command
+ * per call and returns while the flash is busy.
+ */
+
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include "correlation_engine.h"
+#include "hal_flash.h"
+#include "input_packet.h"
+
+#define BLACKBOX_RAM_BYTES 4096   /* Record ring budget                  */
+#define BLACKBOX_POST_RECORDS 20  /* Recorded after a trigger            */
+#define BLACKBOX_REC_MAGIC 0xB5
+#define BLACKBOX_SECTOR_MAGIC 0x31584242u /* "BBX1" */
+#define BLACKBOX_MAX_EVENT_SECTORS (HAL_FLASH_LOG_SECTORS / 2)
+
+/* Record flags */
+#define BLACKBOX_REC_TRIGGER 0x01 /* First record after the trigger      */
+#define BLACKBOX_REC_STALE 0x02   /* Some modules reused last-good data  */
+#define BLACKBOX_REC_SHORT 0x04   /* Short-circuit flag was set          */
+
+typedef struct __attribute__((packed)) {
+  uint8_t magic;       /* BLACKBOX_REC_MAGIC                      */
+  uint8_t state;       /* system_state_t after this pass          */
+  uint8_t active_mask; /* CAT_* active                            */
+  uint8_t risk_pct;    /* Risk factor × 100                       */
+  uint8_t flags;       /* BLACKBOX_REC_*                          */
+  uint8_t reserved;
+  uint16_t seq; /* Records taken since boot (wraps)        */
+  uint32_t t_ms;
+} blackbox_rec_hdr_t;
+
+/* Stored record: header, frames, CRC-16 over both */
+#define BLACKBOX_REC_SIZE                                                      \
+  (sizeof(blackbox_rec_hdr_t) + INPUT_PACK_FRAME_SIZE +                       \
+   PACK_NUM_MODULES * INPUT_MODULE_FRAME_SIZE + 2)
+
+#define BLACKBOX_RING_RECORDS                                                  \
+  (BLACKBOX_RAM_BYTES / BLACKBOX_REC_SIZE < 8                                  \
+       ? 8                                                                     \
+       : BLACKBOX_RAM_BYTES / BLACKBOX_REC_SIZE)
+
+/* The frozen pre-window leaves this many slots free, so post-trigger
+ * records have room while the first sector erases */
+#define BLACKBOX_HEADROOM 4
+#define BLACKBOX_PRE_RECORDS (BLACKBOX_RING_RECORDS - BLACKBOX_HEADROOM)
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;      /* BLACKBOX_SECTOR_MAGIC                   */
+  uint32_t seq;        /* Sectors written since the log began     */
+  uint16_t event;      /* Event the sector belongs to             */
+  uint16_t rec_size;   /* BLACKBOX_REC_SIZE when written          */
+  uint8_t num_modules; /* PACK_NUM_MODULES when written           */
+  uint8_t reserved;
+  uint16_t crc; /* CRC-16 over the bytes above             */
+} blackbox_sector_hdr_t;
+
+#define BLACKBOX_SECTOR_RECORDS                                                \
+  ((HAL_FLASH_SECTOR_SIZE - sizeof(blackbox_sector_hdr_t)) / BLACKBOX_REC_SIZE)
+
+/* -----------------------------------------------------------------------
+ * Dump stream (PACKET_TYPE_BLACKBOX on the telemetry link)
+ *
+ *   [0xAA][LEN][0x06][flags][chunk u16][offset u32][data ≤ 64][XOR]
+ *
+ * data is the log region at `offset`, sectors sent oldest first; the
+ * final frame has BLACKBOX_DUMP_END, no data, and offset = the number of
+ * bytes sent. A receiver rebuilds the sectors by offset.
+ * ----------------------------------------------------------------------- */
+
+#define BLACKBOX_DUMP_CHUNK 64
+#define BLACKBOX_DUMP_HEADER 10 /* sync .. offset */
+#define BLACKBOX_DUMP_MAX_FRAME (BLACKBOX_DUMP_HEADER + BLACKBOX_DUMP_CHUNK + 1)
+#define BLACKBOX_DUMP_END 0x01
+
+typedef struct {
+  /* RAM ring */
+  uint8_t ring[BLACKBOX_RING_RECORDS][BLACKBOX_REC_SIZE];
+  uint8_t head;  /* Next slot to fill                          */
+  uint8_t count; /* Records held                               */
+  uint16_t rec_seq;
+
+  /* Capture */
+  bool capturing;
+  uint8_t unflushed; /* Oldest `unflushed` records go to flash  */
+  uint8_t post_left; /* Records still to take after the trigger */
+  bool mark_trigger; /* Flag the next record                    */
+  uint16_t event;    /* Current / last event id                 */
+  uint8_t event_sectors;
+  system_state_t last_state;
+
+  /* Flash writer */
+  uint8_t log_head; /* Sector of the highest seq               */
+  uint32_t next_seq;
+  bool have_log;      /* log_head is valid                      */
+  bool sector_open;   /* log_head accepts more records          */
+  bool erase_pending; /* log_head is being erased               */
+  uint16_t write_off; /* Next free byte in log_head             */
+  uint16_t rec_off;   /* Bytes of the oldest record written     */
+
+  /* Dump */
+  bool dumping;
+  uint16_t dump_event_min; /* Oldest event included           */
+  bool dump_all;
+  uint8_t dump_step;   /* Sectors visited, oldest first        */
+  uint16_t dump_off;   /* Offset in the current sector         */
+  uint16_t dump_end;   /* Used bytes of the current sector     */
+  uint16_t dump_chunk; /* Frames sent                          */
+  uint32_t dump_bytes;
+
+  /* Diagnostics */
+  uint32_t events;
+  uint32_t dropped;      /* Capture records lost to a full ring */
+  uint32_t flash_errors; /* Programs/erases refused             */
+} blackbox_t;
+
+/*
+ * Scan the flash log for its head and start an empty ring. Call after
+ * hal_flash_init().
+ */
+void blackbox_init(blackbox_t *bb);
+
+/*
+ * Track the system state; a rise to CRITICAL or EMERGENCY from any
+ * lower state freezes the ring and starts an event. Returns true when a
+ * new event started (a rise while capturing only extends the current
+ * one). Called from the med loop before recording, and from the
+ * fast-loop short-circuit path so the freeze happens at the trip.
+ */
+bool blackbox_note_state(blackbox_t *bb, system_state_t state);
+
+/* Record one pass: state, evaluation and the snapshot it was run on */
+void blackbox_record(blackbox_t *bb, uint32_t t_ms,
+                     const sensor_snapshot_t *snap,
+                     const anomaly_result_t *anomaly, system_state_t state);
+
+/* The same from the fixed-point snapshot (ANOMALY_EVAL_FIXED_POINT);
+ * the records are identical, its fields already being wire units */
+void blackbox_record_fx(blackbox_t *bb, uint32_t t_ms,
+                        const sensor_snapshot_fx_t *snap,
+                        const anomaly_result_t *anomaly, system_state_t state);
+
+/* Move captured records to flash; at most one flash command per call */
+void blackbox_poll(blackbox_t *bb);
+
+/* Start a dump of the `newest` most recent events (0 = whole log) */
+void blackbox_dump_begin(blackbox_t *bb, uint8_t newest);
+
+/*
+ * Next dump frame into `frame` (BLACKBOX_DUMP_MAX_FRAME bytes). Returns
+ * its length, or 0 if there is nothing to send on this pass — the dump
+ * is over once bb->dumping is false.
+ */
+uint8_t blackbox_dump_next(blackbox_t *bb, uint8_t *frame);
+
+#endif /* BLACKBOX_H */
@@ -0,0 +1,216 @@
+/*
+ * capture.c — Binary Input Capture Files (Host)
+ */
+
+#if !defined(TARGET_THEJAS32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L /* mmap, posix_madvise */
+#endif
+
+#include "capture.h"
+
+_Static_assert(sizeof(capture_header_t) == CAPTURE_HEADER_SIZE,
+               "header layout");
+_Static_assert(sizeof(capture_index_entry_t) == 16, "index entry layout");
+
+module_mask_t capture_decode(const capture_record_t *rec,
+                             sensor_snapshot_t *snap) {
+  module_mask_t got = 0;
+
+  input_decode_pack(snap, &rec->pack);
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    if (rec->modules[m].sync != INPUT_SYNC_BYTE)
+      continue; /* Held */
+    input_decode_module(snap, m, &rec->modules[m]);
+    got |= MODULE_BIT(m);
+  }
+  snap->stale_modules = 0;
+  return got;
+}
+
+#if HAL_HOST_MODE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ---- Reader ----------------------------------------------------------- */
+
+static hal_status_t check_header(capture_file_t *c) {
+  const capture_header_t *h = c->header;
+  if (h->magic != CAPTURE_MAGIC || h->version != CAPTURE_VERSION ||
+      h->header_size < CAPTURE_HEADER_SIZE || h->header_size > c->size ||
+      h->record_size != sizeof(capture_record_t) ||
+      h->num_modules != NUM_MODULES ||
+      h->groups_per_module != GROUPS_PER_MODULE || h->index_stride == 0)
+    return HAL_ERROR;
+
+  uint64_t room = c->size - h->header_size;
+  if (h->index_offset == 0) {
+    c->count = room / h->record_size; /* Never closed */
+    return HAL_OK;
+  }
+
+  uint64_t end = h->header_size + h->record_count * h->record_size;
+  if (h->record_count > room / h->record_size || h->index_offset < end ||
+      h->index_offset > c->size ||
+      h->index_count > (c->size - h->index_offset) /
+                           sizeof(capture_index_entry_t))
+    return HAL_ERROR;
+  c->count = h->record_count;
+  c->index = (const capture_index_entry_t *)(c->map + h->index_offset);
+  c->index_count = h->index_count;
+  return HAL_OK;
+}
+
+hal_status_t capture_open(capture_file_t *c, const char *path) {
+  memset(c, 0, sizeof(capture_file_t));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return HAL_ERROR;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < CAPTURE_HEADER_SIZE) {
+    close(fd);
+    return HAL_ERROR;
+  }
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); /* The mapping keeps the file */
+  if (map == MAP_FAILED)
+    return HAL_ERROR;
+
+  c->map = map;
+  c->size = (size_t)st.st_size;
+  c->header = (const capture_header_t *)c->map;
+  if (check_header(c) != HAL_OK) {
+    capture_close(c);
+    return HAL_ERROR;
+  }
+  c->records = (const capture_record_t *)(c->map + c->header->header_size);
+  (void)posix_madvise(map, c->size, POSIX_MADV_SEQUENTIAL);
+  return HAL_OK;
+}
+
+void capture_close(capture_file_t *c) {
+  if (c->map)
+    munmap((void *)c->map, c->size);
+  memset(c, 0, sizeof(capture_file_t));
+}
+
+/* First record in [lo, hi) at or after t_ms, hi if none */
+static uint64_t find_in(const capture_file_t *c, uint64_t lo, uint64_t hi,
+                        uint32_t t_ms) {
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (c->records[mid].t_ms < t_ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+uint64_t capture_find(const capture_file_t *c, uint32_t t_ms) {
+  if (!c->index)
+    return find_in(c, 0, c->count, t_ms);
+
+  /* Last entry before t_ms; the answer is within one stride after it */
+  uint32_t lo = 0, hi = c->index_count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (c->index[mid].t_ms < t_ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == 0)
+    return 0;
+  uint64_t first = c->index[lo - 1].record;
+  uint64_t last = first + c->header->index_stride + 1;
+  return find_in(c, first, last < c->count ? last : c->count, t_ms);
+}
+
+/* ---- Writer ----------------------------------------------------------- */
+
+hal_status_t capture_writer_open(capture_writer_t *w, const char *path) {
+  memset(w, 0, sizeof(capture_writer_t));
+  capture_header_t *h = &w->header;
+  h->magic = CAPTURE_MAGIC;
+  h->version = CAPTURE_VERSION;
+  h->header_size = CAPTURE_HEADER_SIZE;
+  h->record_size = sizeof(capture_record_t);
+  h->num_modules = NUM_MODULES;
+  h->groups_per_module = GROUPS_PER_MODULE;
+  h->index_stride = CAPTURE_INDEX_STRIDE;
+
+  w->f = fopen(path, "wb");
+  if (!w->f)
+    return HAL_ERROR;
+  if (fwrite(h, sizeof(capture_header_t), 1, w->f) != 1) {
+    fclose(w->f);
+    w->f = NULL;
+    return HAL_ERROR;
+  }
+  return HAL_OK;
+}
+
+hal_status_t capture_writer_append(capture_writer_t *w,
+                                   const capture_record_t *rec) {
+  capture_header_t *h = &w->header;
+  if (h->record_count > 0 && rec->t_ms < h->t_last_ms)
+    return HAL_ERROR;
+
+  if (h->record_count % h->index_stride == 0) {
+    if (h->index_count == w->index_cap) {
+      uint32_t cap = w->index_cap ? 2 * w->index_cap : 64;
+      void *p = realloc(w->index, cap * sizeof(capture_index_entry_t));
+      if (!p)
+        return HAL_ERROR;
+      w->index = p;
+      w->index_cap = cap;
+    }
+    capture_index_entry_t *e = &w->index[h->index_count++];
+    e->t_ms = rec->t_ms;
+    e->reserved = 0;
+    e->record = h->record_count;
+  }
+
+  if (fwrite(rec, sizeof(capture_record_t), 1, w->f) != 1)
+    return HAL_ERROR;
+  if (h->record_count == 0)
+    h->t_first_ms = rec->t_ms;
+  h->t_last_ms = rec->t_ms;
+  h->record_count++;
+  return HAL_OK;
+}
+
+hal_status_t capture_writer_close(capture_writer_t *w) {
+  capture_header_t *h = &w->header;
+  static const uint8_t pad[8];
+  hal_status_t st = HAL_OK;
+
+  /* Index on an 8-byte boundary after the last record */
+  long end = ftell(w->f);
+  size_t n = end < 0 ? 0 : (size_t)(-end & 7);
+  if (end < 0 || fwrite(pad, 1, n, w->f) != n) {
+    st = HAL_ERROR;
+  } else {
+    h->index_offset = (uint64_t)end + n;
+    if (fwrite(w->index, sizeof(capture_index_entry_t), h->index_count,
+               w->f) != h->index_count ||
+        fseek(w->f, 0, SEEK_SET) != 0 ||
+        fwrite(h, sizeof(capture_header_t), 1, w->f) != 1)
+      st = HAL_ERROR;
+  }
+
+  if (fclose(w->f) != 0)
+    st = HAL_ERROR;
+  free(w->index);
+  w->f = NULL;
+  w->index = NULL;
+  return st;
+}
+
+#endif /* HAL_HOST_MODE */
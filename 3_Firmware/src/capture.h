@@ -0,0 +1,121 @@
+/*
+ * capture.h — Binary Input Capture Files (Host)
+ *
+ * A capture is what the board was fed, one fixed-size record per twin
+ * cycle, kept in the input_packet.h wire layouts so a record is the
+ * frames exactly as they crossed the link:
+ *
+ *   header     64 B   magic "BSCP", geometry, record count, index
+ *   records    n × record_size
+ *                     t_ms │ pack frame │ module frame × NUM_MODULES
+ *   index      one { t_ms, record } entry every index_stride records
+ *
+ * A module frame whose sync byte is 0 did not arrive that cycle; the
+ * board holds the last one, and so does capture_decode(). Records are
+ * in time order. Fixed records mean record i is at a known offset, so
+ * a capture is used in place through mmap; the index keeps a time
+ * lookup inside one small table instead of a binary search touching
+ * pages all over a multi-gigabyte file.
+ *
+ * The writer patches the record count and the index into the header
+ * when it is closed. A capture that was never closed (recorder killed)
+ * still opens: the count is taken from the file size and a lookup
+ * searches the records themselves.
+ *
+ * Everything is little-endian, as both the board and the host are.
+ * t_ms is the recorder's clock (32 bits, ~49 days per file). Host
+ * only; the board firmware does not record captures.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "anomaly_eval.h"
+#include "hal_platform.h"
+#include "input_packet.h"
+
+#define CAPTURE_MAGIC 0x50435342u /* "BSCP" */
+#define CAPTURE_VERSION 1
+#define CAPTURE_HEADER_SIZE 64
+#define CAPTURE_INDEX_STRIDE 1024 /* Records per index entry */
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;     /* Records start here                      */
+  uint16_t record_size;     /* sizeof(capture_record_t)                */
+  uint8_t num_modules;      /* Pack geometry the frames were built for */
+  uint8_t groups_per_module;
+  uint32_t index_stride;
+  uint64_t record_count;    /* 0 until closed                          */
+  uint64_t index_offset;    /* File offset of the index, 0 = none      */
+  uint32_t index_count;
+  uint32_t t_first_ms;
+  uint32_t t_last_ms;
+  uint8_t reserved[20];
+} capture_header_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t t_ms;
+  uint32_t reserved;
+  input_pack_frame_t pack;
+  input_module_frame_t modules[NUM_MODULES]; /* sync 0 = not received */
+} capture_record_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t t_ms; /* Of the record below */
+  uint32_t reserved;
+  uint64_t record;
+} capture_index_entry_t;
+
+/*
+ * Fill `snap` from one record, as the board does from a twin cycle.
+ * Modules not in the record keep what `snap` already holds; returns
+ * the modules that were. dT/dt, dR/dt and the derived fields are left
+ * to the caller (history.h, anomaly_eval_compute()).
+ */
+module_mask_t capture_decode(const capture_record_t *rec,
+                             sensor_snapshot_t *snap);
+
+#if HAL_HOST_MODE
+
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct {
+  const uint8_t *map;
+  size_t size;
+  const capture_header_t *header;
+  const capture_record_t *records;
+  const capture_index_entry_t *index; /* NULL if never closed */
+  uint64_t count;
+  uint32_t index_count;
+} capture_file_t;
+
+typedef struct {
+  FILE *f;
+  capture_header_t header;
+  capture_index_entry_t *index;
+  uint32_t index_cap;
+} capture_writer_t;
+
+/* Map a capture read-only. HAL_ERROR if it cannot be mapped, is not a
+ * capture, or was recorded for another pack geometry. */
+hal_status_t capture_open(capture_file_t *cap, const char *path);
+void capture_close(capture_file_t *cap);
+
+/* First record at or after t_ms (the count if there is none) */
+uint64_t capture_find(const capture_file_t *cap, uint32_t t_ms);
+
+hal_status_t capture_writer_open(capture_writer_t *w, const char *path);
+
+/* Append one record; HAL_ERROR on a write error or if t_ms goes back */
+hal_status_t capture_writer_append(capture_writer_t *w,
+                                   const capture_record_t *rec);
+
+/* Write the index and the final header, then close */
+hal_status_t capture_writer_close(capture_writer_t *w);
+
+#endif /* HAL_HOST_MODE */
+
+#endif /* CAPTURE_H */
@@ -26,6 +26,44 @@ static const char *STATE_NAMES[] = {
     "EMERGENCY",
 };
 
+/* -----------------------------------------------------------------------
+ * Evaluation rate policy
+ * ----------------------------------------------------------------------- */
+
+static uint16_t ms_to_cycles(uint32_t window_ms, uint32_t period_ms) {
+  if (period_ms == 0)
+    return 1;
+  uint32_t cycles = (window_ms + period_ms - 1u) / period_ms;
+  if (cycles == 0u)
+    return 1;
+  if (cycles > 65535u)
+    return 65535u;
+  return (uint16_t)cycles;
+}
+
+bool correlation_alert_mode(const correlation_engine_t *engine,
+                            const anomaly_result_t *anomaly,
+                            bool short_circuit) {
+  return short_circuit || anomaly->active_count > 0 ||
+         engine->current_state != STATE_NORMAL;
+}
+
+uint32_t correlation_med_period_ms(const correlation_engine_t *engine,
+                                   const anomaly_result_t *anomaly,
+                                   bool short_circuit) {
+  return correlation_alert_mode(engine, anomaly, short_circuit)
+             ? CORR_MED_ALERT_MS
+             : CORR_MED_NORMAL_MS;
+}
+
+void correlation_engine_set_period(correlation_engine_t *engine,
+                                   uint32_t med_period_ms) {
+  engine->critical_countdown_limit =
+      ms_to_cycles(CORR_CRITICAL_HOLD_MS, med_period_ms);
+  engine->deescalation_limit =
+      ms_to_cycles(CORR_DEESCALATION_HOLD_MS, med_period_ms);
+}
+
 /* -----------------------------------------------------------------------
  * Initialize
  * ----------------------------------------------------------------------- */
@@ -33,13 +71,10 @@ static const char *STATE_NAMES[] = {
 void correlation_engine_init(correlation_engine_t *engine) {
   engine->current_state = STATE_NORMAL;
 
-  /* CRITICAL countdown: 20 cycles × 500ms = 10 seconds */
+  /* CRITICAL countdown 10 s, de-escalation 5 s at the normal period */
   engine->critical_countdown = 0;
-  engine->critical_countdown_limit = 20;
-
-  /* De-escalation: 10 cycles × 500ms = 5 seconds */
   engine->deescalation_counter = 0;
-  engine->deescalation_limit = 10;
+  correlation_engine_set_period(engine, CORR_MED_NORMAL_MS);
 
   engine->emergency_latched = false;
   engine->emergency_recovery_counter = 0;
@@ -172,6 +207,16 @@ system_state_t correlation_engine_update(correlation_engine_t *engine,
   return engine->current_state;
 }
 
+void correlation_engine_update_batch(correlation_engine_t *engines,
+                                     const anomaly_result_t *results,
+                                     system_state_t *states, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    system_state_t st = correlation_engine_update(&engines[i], &results[i]);
+    if (states)
+      states[i] = st;
+  }
+}
+
 /* -----------------------------------------------------------------------
  * Utility functions
  * ----------------------------------------------------------------------- */
@@ -31,6 +31,21 @@ typedef enum {
   STATE_EMERGENCY = 3,
 } system_state_t;
 
+/* -----------------------------------------------------------------------
+ * Evaluation rate policy
+ *
+ * The med loop (evaluate + correlate) speeds up while anything is
+ * wrong. The CRITICAL countdown and the de-escalation hold are counted
+ * in passes, so they are rescaled with the period to stay the same
+ * length in time. main.c and the host benches all take the policy from
+ * here.
+ * ----------------------------------------------------------------------- */
+
+#define CORR_MED_NORMAL_MS 500
+#define CORR_MED_ALERT_MS 100
+#define CORR_CRITICAL_HOLD_MS 10000   /* CRITICAL → EMERGENCY countdown  */
+#define CORR_DEESCALATION_HOLD_MS 5000 /* Quiet time before stepping down */
+
 /* -----------------------------------------------------------------------
  * Correlation engine context
  * ----------------------------------------------------------------------- */
@@ -53,7 +68,7 @@ typedef struct {
 
   /* Hotspot tracking (from latest anomaly result) */
   uint8_t hotspot_module;       /* Module with worst anomaly (1-based)     */
-  uint8_t anomaly_modules_mask; /* Which modules have anomalies            */
+  module_mask_t anomaly_modules_mask; /* Which modules have anomalies      */
   float risk_factor;            /* 0.0 – 1.0 from anomaly eval            */
   uint8_t cascade_stage;        /* Thermal cascade stage index             */
 
@@ -76,10 +91,32 @@ void correlation_engine_init(correlation_engine_t *engine);
 system_state_t correlation_engine_update(correlation_engine_t *engine,
                                          const anomaly_result_t *anomaly);
 
+/* Batch form: updates engines[i] with results[i] and, if states is not
+ * NULL, stores its new state in states[i]. Reentrant, like the single
+ * update. */
+void correlation_engine_update_batch(correlation_engine_t *engines,
+                                     const anomaly_result_t *results,
+                                     system_state_t *states, uint32_t count);
+
 /* Get a human-readable name for a state */
 const char *correlation_state_name(system_state_t state);
 
 /* Manually reset the engine */
 void correlation_engine_reset(correlation_engine_t *engine);
 
+/* Alert mode: a short circuit, any active category, or any state above
+ * NORMAL (after the update for this pass) */
+bool correlation_alert_mode(const correlation_engine_t *engine,
+                            const anomaly_result_t *anomaly,
+                            bool short_circuit);
+
+/* Med-loop period for the next pass: CORR_MED_ALERT_MS in alert mode */
+uint32_t correlation_med_period_ms(const correlation_engine_t *engine,
+                                   const anomaly_result_t *anomaly,
+                                   bool short_circuit);
+
+/* Hold windows in passes of `med_period_ms`, rounded up (at least 1) */
+void correlation_engine_set_period(correlation_engine_t *engine,
+                                   uint32_t med_period_ms);
+
 #endif /* CORRELATION_ENGINE_H */
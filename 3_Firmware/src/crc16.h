@@ -0,0 +1,30 @@
+/*
+ * crc16.h — CRC-16/CCITT-FALSE for the v2 link framing
+ *
+ * Poly 0x1021, init 0xFFFF, no reflection, no final XOR. Catches every
+ * 1- and 2-bit error and every burst up to 16 bits in a frame, which
+ * the v1 XOR checksum does not (a byte swap passes XOR untouched).
+ *
+ * Table-driven, one 256-entry table in flash; the streaming form lets
+ * the input parser fold each byte in as it arrives.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+#define CRC16_INIT 0xFFFFu
+#define CRC16_CHECK 0x29B1u /* crc16("123456789") */
+
+extern const uint16_t crc16_table[256];
+
+/* Fold one byte into a running CRC */
+static inline uint16_t crc16_update(uint16_t crc, uint8_t byte) {
+  return (uint16_t)((crc << 8) ^ crc16_table[(uint8_t)((crc >> 8) ^ byte)]);
+}
+
+/* CRC of a buffer, continuing from crc (CRC16_INIT to start) */
+uint16_t crc16_block(uint16_t crc, const uint8_t *data, uint16_t length);
+
+#endif /* CRC16_H */
@@ -0,0 +1,125 @@
+/*
+ * fleet_eval.c — Multi-Pack Batch Evaluation (Gateway / Fleet)
+ */
+
+#include "fleet_eval.h"
+#include <stddef.h>
+
+/* -----------------------------------------------------------------------
+ * One slice, on the calling thread
+ * ----------------------------------------------------------------------- */
+void fleet_eval_range(const fleet_batch_t *b, uint32_t first, uint32_t n) {
+  anomaly_eval_run_batch(b->thresholds, b->snapshots + first,
+                         b->results + first, n);
+  correlation_engine_update_batch(b->engines + first, b->results + first,
+                                  b->states ? b->states + first : NULL, n);
+}
+
+#if HAL_HOST_MODE
+
+#include <unistd.h>
+
+/* -----------------------------------------------------------------------
+ * Thread pool (host)
+ *
+ * Workers sleep on `work` until the generation moves, then claim
+ * FLEET_CHUNK-pack slices from an atomic cursor until the batch is
+ * exhausted. Slices are disjoint, so the only shared write is the
+ * cursor. The last worker out signals `done`.
+ * ----------------------------------------------------------------------- */
+
+static void fleet_drain(fleet_pool_t *p, const fleet_batch_t *b) {
+  for (;;) {
+    uint32_t first = atomic_fetch_add(&p->next, FLEET_CHUNK);
+    if (first >= b->count)
+      return;
+    uint32_t n = b->count - first;
+    fleet_eval_range(b, first, n < FLEET_CHUNK ? n : FLEET_CHUNK);
+  }
+}
+
+static void *fleet_worker(void *arg) {
+  fleet_pool_t *p = arg;
+  unsigned seen = 0;
+
+  pthread_mutex_lock(&p->lock);
+  for (;;) {
+    while (!p->stop && p->generation == seen)
+      pthread_cond_wait(&p->work, &p->lock);
+    if (p->stop)
+      break;
+    seen = p->generation;
+    const fleet_batch_t *b = p->batch;
+    pthread_mutex_unlock(&p->lock);
+
+    fleet_drain(p, b);
+
+    pthread_mutex_lock(&p->lock);
+    if (--p->active == 0)
+      pthread_cond_signal(&p->done);
+  }
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+hal_status_t fleet_pool_init(fleet_pool_t *p, unsigned threads) {
+  if (threads == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores > 0 ? (unsigned)cores : 1u;
+  }
+  if (threads > FLEET_MAX_THREADS + 1u)
+    threads = FLEET_MAX_THREADS + 1u;
+
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->work, NULL);
+  pthread_cond_init(&p->done, NULL);
+  p->batch = NULL;
+  atomic_init(&p->next, 0);
+  p->generation = 0;
+  p->active = 0;
+  p->stop = false;
+  p->num_workers = 0;
+
+  for (unsigned i = 0; i + 1u < threads; i++) {
+    if (pthread_create(&p->threads[i], NULL, fleet_worker, p) != 0) {
+      fleet_pool_destroy(p);
+      return HAL_ERROR;
+    }
+    p->num_workers++;
+  }
+  return HAL_OK;
+}
+
+void fleet_pool_run(fleet_pool_t *p, const fleet_batch_t *b) {
+  pthread_mutex_lock(&p->lock);
+  p->batch = b;
+  atomic_store(&p->next, 0);
+  p->active = p->num_workers;
+  p->generation++;
+  pthread_cond_broadcast(&p->work);
+  pthread_mutex_unlock(&p->lock);
+
+  fleet_drain(p, b);
+
+  pthread_mutex_lock(&p->lock);
+  while (p->active > 0)
+    pthread_cond_wait(&p->done, &p->lock);
+  pthread_mutex_unlock(&p->lock);
+}
+
+void fleet_pool_destroy(fleet_pool_t *p) {
+  pthread_mutex_lock(&p->lock);
+  p->stop = true;
+  pthread_cond_broadcast(&p->work);
+  pthread_mutex_unlock(&p->lock);
+
+  for (unsigned i = 0; i < p->num_workers; i++)
+    pthread_join(p->threads[i], NULL);
+  p->num_workers = 0;
+
+  pthread_cond_destroy(&p->done);
+  pthread_cond_destroy(&p->work);
+  pthread_mutex_destroy(&p->lock);
+}
+
+#endif /* HAL_HOST_MODE */
@@ -0,0 +1,77 @@
+/*
+ * fleet_eval.h — Multi-Pack Batch Evaluation (Gateway / Fleet)
+ *
+ * A depot gateway evaluates many packs per med-loop period. The fleet
+ * is held as parallel arrays, one per kind of record, indexed by pack:
+ *
+ *   snapshots[]  ~820 B each  written by the ingest side, read by eval
+ *   results[]     16 B each   eval → correlation
+ *   engines[]     44 B each   correlation state, persists across passes
+ *   states[]       4 B each   optional output for the caller
+ *
+ * so the correlation pass streams through ~60 B per pack and never
+ * touches the snapshots, and per-pack state shares no cache line with
+ * the bulk sensor data. Nothing is global: several fleets (or several
+ * thresholds) can be evaluated side by side.
+ *
+ * fleet_eval_range() runs one slice of a batch on the calling thread.
+ * On host builds a small pthread pool splits a batch across cores in
+ * FLEET_CHUNK-pack slices; the board firmware evaluates a single pack
+ * and does not use this module.
+ */
+
+#ifndef FLEET_EVAL_H
+#define FLEET_EVAL_H
+
+#include "correlation_engine.h"
+#include "hal_platform.h"
+
+typedef struct {
+  const anomaly_thresholds_t *thresholds; /* Shared by every pack      */
+  sensor_snapshot_t *snapshots;           /* [count]                   */
+  anomaly_result_t *results;              /* [count]                   */
+  correlation_engine_t *engines;          /* [count]                   */
+  system_state_t *states;                 /* [count], or NULL          */
+  uint32_t count;
+} fleet_batch_t;
+
+/* Evaluate and correlate packs first .. first+n-1 of a batch */
+void fleet_eval_range(const fleet_batch_t *batch, uint32_t first,
+                      uint32_t n);
+
+#if HAL_HOST_MODE
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define FLEET_MAX_THREADS 64
+#define FLEET_CHUNK 32 /* Packs claimed per grab (~26 KB of snapshots) */
+
+typedef struct {
+  pthread_t threads[FLEET_MAX_THREADS];
+  unsigned num_workers; /* Threads besides the caller                 */
+  pthread_mutex_t lock;
+  pthread_cond_t work; /* A new batch (or stop) was posted           */
+  pthread_cond_t done; /* The last worker finished the batch         */
+  const fleet_batch_t *batch;
+  atomic_uint next;    /* Next unclaimed pack                        */
+  unsigned generation; /* Batches posted                             */
+  unsigned active;     /* Workers still on the current batch         */
+  bool stop;
+} fleet_pool_t;
+
+/* Start a pool of `threads` threads in total, the caller included
+ * (0 = one per online core). Returns HAL_ERROR if a thread cannot be
+ * created; the pool is then left stopped. */
+hal_status_t fleet_pool_init(fleet_pool_t *pool, unsigned threads);
+
+/* Evaluate a whole batch, blocking until every pack is done. The
+ * calling thread works on it too. */
+void fleet_pool_run(fleet_pool_t *pool, const fleet_batch_t *batch);
+
+/* Stop and join the workers */
+void fleet_pool_destroy(fleet_pool_t *pool);
+
+#endif /* HAL_HOST_MODE */
+
+#endif /* FLEET_EVAL_H */
@@ -9,16 +9,35 @@
  * ----------------------------------------------------------------------- */
 #if HAL_HOST_MODE
 
+#include "hal_gpio.h"
+#include "hal_timer.h"
+
+#define SIM_MUX_ADDRS 8
+
 static uint16_t sim_values[ADC_NUM_CHANNELS] = {0};
+static uint16_t sim_mux[ADC_NUM_CHANNELS][SIM_MUX_ADDRS];
+static bool sim_mux_fed[ADC_NUM_CHANNELS];
+
+/* Conversion in flight: value held at the start, ready after ADC_CONVERT_US */
+static bool conv_active = false;
+static int16_t conv_value;
+static uint32_t conv_start_cyc;
 
 hal_status_t hal_adc_init(void) {
   /* Nothing to initialize on host */
+  conv_active = false;
   return HAL_OK;
 }
 
 int16_t hal_adc_read_raw(uint8_t channel) {
   if (channel >= ADC_NUM_CHANNELS)
     return HAL_ERROR;
+  if (sim_mux_fed[channel]) {
+    uint8_t addr = (uint8_t)(hal_gpio_read(GPIO_PIN_MUX_S0) |
+                             hal_gpio_read(GPIO_PIN_MUX_S1) << 1 |
+                             hal_gpio_read(GPIO_PIN_MUX_S2) << 2);
+    return (int16_t)sim_mux[channel][addr];
+  }
   return (int16_t)sim_values[channel];
 }
 
@@ -30,12 +49,45 @@ int16_t hal_adc_read_mv(uint8_t channel) {
   return (int16_t)((uint32_t)raw * ADC_VREF_MV / ADC_MAX_VALUE);
 }
 
+hal_status_t hal_adc_start(uint8_t channel) {
+  if (channel >= ADC_NUM_CHANNELS)
+    return HAL_ERROR;
+  if (conv_active)
+    return HAL_BUSY;
+  conv_value = hal_adc_read_raw(channel); /* Sample-and-hold closes now */
+  conv_start_cyc = hal_timer_cycles();
+  conv_active = true;
+  return HAL_OK;
+}
+
+bool hal_adc_ready(void) {
+  return conv_active && hal_timer_cycles() - conv_start_cyc >=
+                            ADC_CONVERT_US * HAL_TIMER_CYCLES_PER_US;
+}
+
+int16_t hal_adc_result(void) {
+  if (!conv_active)
+    return HAL_ERROR;
+  if (!hal_adc_ready())
+    return HAL_BUSY;
+  conv_active = false;
+  return conv_value;
+}
+
 void hal_adc_sim_set(uint8_t channel, uint16_t raw_value) {
   if (channel < ADC_NUM_CHANNELS) {
     sim_values[channel] = raw_value;
   }
 }
 
+void hal_adc_sim_set_mux(uint8_t channel, uint8_t mux_addr,
+                         uint16_t raw_value) {
+  if (channel < ADC_NUM_CHANNELS && mux_addr < SIM_MUX_ADDRS) {
+    sim_mux[channel][mux_addr] = raw_value;
+    sim_mux_fed[channel] = true;
+  }
+}
+
 /* -----------------------------------------------------------------------
  * TARGET MODE — Real THEJAS32 hardware
  * ----------------------------------------------------------------------- */
@@ -73,4 +125,31 @@ int16_t hal_adc_read_mv(uint8_t channel) {
   return (int16_t)((uint32_t)raw * ADC_VREF_MV / ADC_MAX_VALUE);
 }
 
+static bool conv_active = false;
+
+hal_status_t hal_adc_start(uint8_t channel) {
+  if (channel >= ADC_NUM_CHANNELS)
+    return HAL_ERROR;
+  if (conv_active)
+    return HAL_BUSY;
+  /* TODO: Select channel and set the THEJAS32 ADC start bit */
+  conv_active = true;
+  return HAL_OK;
+}
+
+bool hal_adc_ready(void) {
+  /* TODO: Poll the THEJAS32 ADC conversion-complete flag */
+  return conv_active;
+}
+
+int16_t hal_adc_result(void) {
+  if (!conv_active)
+    return HAL_ERROR;
+  if (!hal_adc_ready())
+    return HAL_BUSY;
+  conv_active = false;
+  /* TODO: Read THEJAS32 ADC data register */
+  return 0;
+}
+
 #endif /* HAL_HOST_MODE */
@@ -15,9 +15,10 @@
 #include "hal_platform.h"
 
 /* ADC channel assignments on the VSDSquadron ULTRA */
-#define ADC_CHANNEL_MUX_OUT 0 /* CD4051 MUX output (thermistors) */
-#define ADC_CHANNEL_FSR 1     /* FSR402 force sensor */
-#define ADC_NUM_CHANNELS 2
+#define ADC_CHANNEL_MUX_OUT 0  /* CD4051 MUX output (thermistors) */
+#define ADC_CHANNEL_FSR 1      /* FSR402 force sensor */
+#define ADC_CHANNEL_MUX2_OUT 2 /* Second CD4051 (pack NTCs 8-15), same S0-S2 */
+#define ADC_NUM_CHANNELS 3
 
 /* ADC resolution: 12-bit (0-4095) */
 #define ADC_MAX_VALUE 4095
@@ -45,6 +46,28 @@ int16_t hal_adc_read_raw(uint8_t channel);
  */
 int16_t hal_adc_read_mv(uint8_t channel);
 
+/* -----------------------------------------------------------------------
+ * Non-blocking conversion
+ *
+ * hal_adc_start() closes the sample-and-hold on a channel and returns.
+ * After ADC_SAMPLE_US the held value no longer depends on the pin, so
+ * the MUX may be moved on while the conversion finishes; the result is
+ * ready ADC_CONVERT_US after the start. One conversion at a time.
+ * ----------------------------------------------------------------------- */
+
+#define ADC_SAMPLE_US 2   /* Acquisition window (sample-and-hold closed) */
+#define ADC_CONVERT_US 12 /* Start to result, acquisition included       */
+
+/* Start a conversion; HAL_BUSY while the previous one is in flight */
+hal_status_t hal_adc_start(uint8_t channel);
+
+/* True once the started conversion has a result */
+bool hal_adc_ready(void);
+
+/* Collect the result: 0-4095, HAL_BUSY if not ready, HAL_ERROR if no
+ * conversion was started. Frees the converter for the next start. */
+int16_t hal_adc_result(void);
+
 /* -----------------------------------------------------------------------
  * HOST-MODE simulation helpers (only available in mock builds)
  * ----------------------------------------------------------------------- */
@@ -54,6 +77,13 @@ int16_t hal_adc_read_mv(uint8_t channel);
  * Only callable in HOST mode — ignored on real hardware.
  */
 void hal_adc_sim_set(uint8_t channel, uint16_t raw_value);
+
+/*
+ * Set the value a MUX-fed channel reads while the MUX select lines
+ * (hal_gpio_mux_select) address `mux_addr`. Once set for a channel,
+ * reads of it follow the select lines.
+ */
+void hal_adc_sim_set_mux(uint8_t channel, uint8_t mux_addr, uint16_t raw_value);
 #endif
 
 #endif /* HAL_ADC_H */
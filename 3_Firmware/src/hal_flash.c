@@ -0,0 +1,185 @@
+/*
+ * hal_flash.c — SPI NOR Flash Implementation (HOST + TARGET)
+ */
+
+#include "hal_flash.h"
+#include <string.h>
+
+#define LOG_SIZE ((uint32_t)HAL_FLASH_LOG_SECTORS * HAL_FLASH_SECTOR_SIZE)
+
+/* Only the log region is ever touched */
+static bool in_log(uint32_t addr, uint32_t len) {
+  return addr >= HAL_FLASH_LOG_BASE && len <= LOG_SIZE &&
+         addr - HAL_FLASH_LOG_BASE <= LOG_SIZE - len;
+}
+
+static bool in_one_page(uint32_t addr, uint16_t len) {
+  return len > 0 &&
+         (addr % HAL_FLASH_PAGE_SIZE) + len <= HAL_FLASH_PAGE_SIZE;
+}
+
+/* -----------------------------------------------------------------------
+ * HOST MODE — RAM image with NOR rules
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+
+#include "hal_timer.h"
+
+static uint8_t image[LOG_SIZE];
+static uint32_t erase_count[HAL_FLASH_LOG_SECTORS];
+static bool erasing = false;
+static uint32_t erase_start_ms;
+
+void hal_flash_sim_reset(void) {
+  memset(image, 0xFF, sizeof(image));
+  memset(erase_count, 0, sizeof(erase_count));
+  erasing = false;
+}
+
+hal_status_t hal_flash_init(void) {
+  static bool formatted = false;
+  if (!formatted) {
+    hal_flash_sim_reset(); /* Fresh part; later inits keep the image */
+    formatted = true;
+  }
+  return HAL_OK;
+}
+
+bool hal_flash_busy(void) {
+  if (erasing && hal_timer_millis() - erase_start_ms >= HAL_FLASH_ERASE_MS)
+    erasing = false;
+  return erasing;
+}
+
+hal_status_t hal_flash_erase_sector(uint32_t addr) {
+  if (!in_log(addr, 1))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  uint32_t sector = (addr - HAL_FLASH_LOG_BASE) / HAL_FLASH_SECTOR_SIZE;
+  memset(&image[sector * HAL_FLASH_SECTOR_SIZE], 0xFF, HAL_FLASH_SECTOR_SIZE);
+  erase_count[sector]++;
+  erasing = true;
+  erase_start_ms = hal_timer_millis();
+  return HAL_OK;
+}
+
+hal_status_t hal_flash_program(uint32_t addr, const uint8_t *data,
+                               uint16_t len) {
+  if (!in_log(addr, len) || !in_one_page(addr, len))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  uint8_t *dst = &image[addr - HAL_FLASH_LOG_BASE];
+  for (uint16_t i = 0; i < len; i++)
+    dst[i] &= data[i]; /* Programming only clears bits */
+  return HAL_OK;
+}
+
+hal_status_t hal_flash_read(uint32_t addr, uint8_t *buf, uint16_t len) {
+  if (!in_log(addr, len))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  memcpy(buf, &image[addr - HAL_FLASH_LOG_BASE], len);
+  return HAL_OK;
+}
+
+uint32_t hal_flash_sim_erase_count(uint8_t sector) {
+  return sector < HAL_FLASH_LOG_SECTORS ? erase_count[sector] : 0;
+}
+
+/* -----------------------------------------------------------------------
+ * TARGET MODE — W25Q-class flash over SPI
+ *
+ * Standard 25-series command set: every erase/program is preceded by
+ * Write Enable, and Read Status bit 0 (WIP) stays set until it ends.
+ * ----------------------------------------------------------------------- */
+#else
+
+#define CMD_WRITE_ENABLE 0x06
+#define CMD_READ_STATUS 0x05
+#define CMD_PAGE_PROGRAM 0x02
+#define CMD_SECTOR_ERASE 0x20
+#define CMD_READ_DATA 0x03
+#define CMD_JEDEC_ID 0x9F
+#define STATUS_WIP 0x01
+
+/*
+ * SPI controller integration placeholder.
+ *
+ * Map these to the THEJAS32 SPI registers the flash is wired to:
+ * assert CS, shift `tx` out while collecting into `rx` (either may be
+ * NULL), and deassert CS only when `last` is set.
+ */
+static void spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len,
+                         bool last) {
+  /* TODO: Drive the THEJAS32 SPI controller */
+  (void)tx;
+  (void)last;
+  if (rx)
+    memset(rx, 0xFF, len);
+}
+
+static void send_cmd_addr(uint8_t cmd, uint32_t addr, bool last) {
+  uint8_t hdr[4] = {cmd, (uint8_t)(addr >> 16), (uint8_t)(addr >> 8),
+                    (uint8_t)addr};
+  spi_transfer(hdr, NULL, 4, last);
+}
+
+static void write_enable(void) {
+  uint8_t cmd = CMD_WRITE_ENABLE;
+  spi_transfer(&cmd, NULL, 1, true);
+}
+
+hal_status_t hal_flash_init(void) {
+  uint8_t cmd = CMD_JEDEC_ID;
+  uint8_t id[3];
+  spi_transfer(&cmd, NULL, 1, false);
+  spi_transfer(NULL, id, 3, true);
+  (void)id; /* Any 25-series part with 4 KB sectors will do */
+  return HAL_OK;
+}
+
+bool hal_flash_busy(void) {
+  uint8_t cmd = CMD_READ_STATUS;
+  uint8_t status;
+  spi_transfer(&cmd, NULL, 1, false);
+  spi_transfer(NULL, &status, 1, true);
+  /* 0xFF is a floating bus (no part answering), not a busy part */
+  return (status & STATUS_WIP) != 0 && status != 0xFF;
+}
+
+hal_status_t hal_flash_erase_sector(uint32_t addr) {
+  if (!in_log(addr, 1))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  write_enable();
+  send_cmd_addr(CMD_SECTOR_ERASE, addr & ~(HAL_FLASH_SECTOR_SIZE - 1u), true);
+  return HAL_OK;
+}
+
+hal_status_t hal_flash_program(uint32_t addr, const uint8_t *data,
+                               uint16_t len) {
+  if (!in_log(addr, len) || !in_one_page(addr, len))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  write_enable();
+  send_cmd_addr(CMD_PAGE_PROGRAM, addr, false);
+  spi_transfer(data, NULL, len, true);
+  return HAL_OK;
+}
+
+hal_status_t hal_flash_read(uint32_t addr, uint8_t *buf, uint16_t len) {
+  if (!in_log(addr, len))
+    return HAL_ERROR;
+  if (hal_flash_busy())
+    return HAL_BUSY;
+  send_cmd_addr(CMD_READ_DATA, addr, false);
+  spi_transfer(NULL, buf, len, true);
+  return HAL_OK;
+}
+
+#endif /* HAL_HOST_MODE */
@@ -0,0 +1,60 @@
+/*
+ * hal_flash.h — External SPI NOR Flash Abstraction
+ *
+ * Used for:
+ *   - The black-box event recorder (blackbox.h)
+ *
+ * NOR semantics: an erased sector reads 0xFF, programming can only
+ * clear bits, and a program may not cross a page boundary. Erase and
+ * program return as soon as the operation has started; poll
+ * hal_flash_busy() before the next one, so a ~45 ms sector erase never
+ * holds up a loop. Reads are short and blocking.
+ *
+ * On HOST mode: a RAM image with the same rules and a per-sector erase
+ *               counter; an erase stays busy for HAL_FLASH_ERASE_MS of
+ *               the simulated clock.
+ * On TARGET mode: W25Q-class flash on the THEJAS32 SPI controller.
+ */
+
+#ifndef HAL_FLASH_H
+#define HAL_FLASH_H
+
+#include "hal_platform.h"
+
+#define HAL_FLASH_PAGE_SIZE 256
+#define HAL_FLASH_SECTOR_SIZE 4096
+#define HAL_FLASH_ERASE_MS 45 /* Typical 4 KB sector erase */
+
+/* Region reserved for the black-box log (above the firmware image) */
+#define HAL_FLASH_LOG_BASE 0x100000u
+#define HAL_FLASH_LOG_SECTORS 16 /* 64 KB */
+
+/* Detect the flash and leave it idle */
+hal_status_t hal_flash_init(void);
+
+/* True while an erase or program is in progress */
+bool hal_flash_busy(void);
+
+/* Start erasing the sector holding `addr`; HAL_BUSY if busy */
+hal_status_t hal_flash_erase_sector(uint32_t addr);
+
+/* Start programming `len` bytes at `addr`; the range must stay inside
+ * one page (HAL_ERROR otherwise). HAL_BUSY if busy. */
+hal_status_t hal_flash_program(uint32_t addr, const uint8_t *data,
+                               uint16_t len);
+
+/* Read `len` bytes; HAL_BUSY while an erase or program is in progress */
+hal_status_t hal_flash_read(uint32_t addr, uint8_t *buf, uint16_t len);
+
+/* -----------------------------------------------------------------------
+ * HOST-MODE simulation helpers
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+/* Erase cycles taken by log sector `sector` (0..HAL_FLASH_LOG_SECTORS-1) */
+uint32_t hal_flash_sim_erase_count(uint8_t sector);
+
+/* Forget the image: every sector reads erased, counters cleared */
+void hal_flash_sim_reset(void);
+#endif
+
+#endif /* HAL_FLASH_H */
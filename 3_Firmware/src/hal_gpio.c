@@ -3,6 +3,10 @@
  */
 
 #include "hal_gpio.h"
+#include "hal_timer.h"
+
+static bool g_safety_armed = false;
+static void actuators_reset(void);
 
 /* -----------------------------------------------------------------------
  * HOST MODE
@@ -14,7 +18,6 @@
 #define MAX_PINS 32
 static gpio_level_t pin_states[MAX_PINS] = {0};
 static gpio_mode_t pin_modes[MAX_PINS] = {0};
-static bool g_safety_armed = false;
 
 hal_status_t hal_gpio_init(void) {
   /* Set safe defaults */
@@ -35,6 +38,7 @@ hal_status_t hal_gpio_init(void) {
   /* Relay starts HIGH = battery disconnected (fail-safe default) */
   pin_states[GPIO_PIN_RELAY] = GPIO_HIGH;
   g_safety_armed = false;
+  actuators_reset();
 
   return HAL_OK;
 }
@@ -66,24 +70,6 @@ void hal_gpio_mux_select(uint8_t channel) {
   pin_states[GPIO_PIN_MUX_S2] = (channel & 0x04) ? GPIO_HIGH : GPIO_LOW;
 }
 
-void hal_gpio_relay_disconnect(void) {
-  pin_states[GPIO_PIN_RELAY] = GPIO_HIGH;
-  printf("[HAL] RELAY TRIGGERED — Battery DISCONNECTED\n");
-}
-
-void hal_gpio_relay_connect(void) {
-  if (!g_safety_armed) {
-    printf("[HAL] Relay connect blocked: safety not armed\n");
-    return;
-  }
-  pin_states[GPIO_PIN_RELAY] = GPIO_LOW;
-  printf("[HAL] Relay released — Battery connected\n");
-}
-
-void hal_gpio_set_safety_armed(bool armed) { g_safety_armed = armed; }
-
-bool hal_gpio_is_safety_armed(void) { return g_safety_armed; }
-
 void hal_gpio_set_status_leds(uint8_t state) {
   /* 0=NORMAL(green), 1=WARNING(yellow), 2=CRITICAL(red), 3=EMERGENCY(red blink)
    */
@@ -92,11 +78,6 @@ void hal_gpio_set_status_leds(uint8_t state) {
   pin_states[GPIO_PIN_LED_RED] = (state >= 2) ? GPIO_HIGH : GPIO_LOW;
 }
 
-void hal_gpio_buzzer_pulse(uint16_t duration_ms) {
-  (void)duration_ms;
-  printf("[HAL] Buzzer: %dms pulse\n", duration_ms);
-}
-
 /* -----------------------------------------------------------------------
  * TARGET MODE — THEJAS32 real GPIO registers
  *
@@ -110,7 +91,6 @@ void hal_gpio_buzzer_pulse(uint16_t duration_ms) {
 #else
 
 #include "../target/thejas32_regs.h"
-static bool g_safety_armed = false;
 
 /* ---- Helper: resolve pin to the correct GPIO bank ---- */
 
@@ -150,7 +130,10 @@ hal_status_t hal_gpio_init(void) {
     GPIO0_DIR_REG |= gpio0_out_mask;
     GPIO0_OUTPUT_REG |= gpio0_out_mask; /* relay HIGH = disconnected */
   }
+  if (GPIO_PIN_BUZZER < 16)
+    GPIO0_OUTPUT_REG &= ~(1u << GPIO_PIN_BUZZER); /* Buzzer quiet */
   g_safety_armed = false;
+  actuators_reset();
 
   return HAL_OK;
 }
@@ -193,21 +176,6 @@ void hal_gpio_mux_select(uint8_t channel) {
   hal_gpio_write(GPIO_PIN_MUX_S2, (channel & 0x04) ? GPIO_HIGH : GPIO_LOW);
 }
 
-void hal_gpio_relay_disconnect(void) {
-  hal_gpio_write(GPIO_PIN_RELAY, GPIO_HIGH);
-}
-
-void hal_gpio_relay_connect(void) {
-  if (!g_safety_armed) {
-    return;
-  }
-  hal_gpio_write(GPIO_PIN_RELAY, GPIO_LOW);
-}
-
-void hal_gpio_set_safety_armed(bool armed) { g_safety_armed = armed; }
-
-bool hal_gpio_is_safety_armed(void) { return g_safety_armed; }
-
 void hal_gpio_set_status_leds(uint8_t state) {
   /* Active-low: write LOW to turn ON, HIGH to turn OFF.
    * LED1=NORMAL, LED2=WARNING, LED3=CRITICAL, LED4=EMERGENCY */
@@ -222,14 +190,189 @@ void hal_gpio_set_status_leds(uint8_t state) {
     GPIO1_OUTPUT_REG &= ~(1u << LED4_BIT); /* LED4 ON = EMERGENCY */
 }
 
-void hal_gpio_buzzer_pulse(uint16_t duration_ms) {
-  hal_gpio_write(GPIO_PIN_BUZZER, GPIO_HIGH);
-  /* Busy-loop delay (~100MHz clock, ~10 cycles/iteration) */
-  volatile uint32_t count = (uint32_t)duration_ms * 10000u;
-  while (count--) {
-    __asm__ volatile("nop");
+#endif /* HAL_HOST_MODE */
+
+/* -----------------------------------------------------------------------
+ * Actuators (HOST + TARGET) — timer-driven, never blocking
+ *
+ * Only hal_gpio_write/read touch the pins, so both modes share the
+ * state machines; HOST additionally logs relay transitions.
+ * ----------------------------------------------------------------------- */
+
+#if HAL_HOST_MODE
+#define ACT_LOG(msg) printf("%s\n", msg)
+#else
+#define ACT_LOG(msg) ((void)0)
+#endif
+
+#define RELAY_DRIVE_LEVEL(st)                                                  \
+  (((st) == RELAY_OPENING || (st) == RELAY_OPEN) ? GPIO_HIGH : GPIO_LOW)
+
+static struct {
+  relay_state_t state;
+  uint32_t since_ms;      /* Entered the current state              */
+  uint32_t reconnect_ms;  /* Earliest reconnect                     */
+  bool connect_pending;
+  uint32_t faults;
+} g_relay;
+
+static const struct {
+  uint16_t on_ms;
+  uint16_t off_ms;
+  uint8_t cycles; /* 0 = until stopped */
+} k_buzzer_patterns[] = {
+    [BUZZER_OFF] = {0, 0, 0},
+    [BUZZER_PULSE] = {0, 0, 1}, /* on_ms set per pulse */
+    [BUZZER_ALARM] = {500, 500, 0},
+    [BUZZER_CHIRP] = {50, 50, 3},
+};
+
+static struct {
+  buzzer_pattern_t pattern;
+  bool on;
+  uint16_t on_ms;
+  uint32_t phase_ms; /* Start of the current on/off phase */
+  uint8_t cycles_left;
+} g_buzzer;
+
+static void actuators_reset(void) {
+  uint32_t now = hal_timer_millis();
+  g_relay.state = RELAY_OPEN; /* Pin starts HIGH (fail-safe)     */
+  g_relay.since_ms = now;
+  g_relay.reconnect_ms = now; /* Boot connect needs no dwell     */
+  g_relay.connect_pending = false;
+  g_relay.faults = 0;
+  g_buzzer.pattern = BUZZER_OFF;
+  g_buzzer.on = false;
+}
+
+static void relay_enter(relay_state_t st, uint32_t now) {
+  g_relay.state = st;
+  g_relay.since_ms = now;
+  hal_gpio_write(GPIO_PIN_RELAY, RELAY_DRIVE_LEVEL(st));
+}
+
+void hal_gpio_relay_disconnect(void) {
+  uint32_t now = hal_timer_millis();
+  ACT_LOG("[HAL] RELAY TRIGGERED — Battery DISCONNECTED");
+  g_relay.connect_pending = false;
+  g_relay.reconnect_ms = now + RELAY_MIN_OPEN_MS;
+  if (g_relay.state == RELAY_OPEN || g_relay.state == RELAY_OPENING) {
+    hal_gpio_write(GPIO_PIN_RELAY, GPIO_HIGH); /* Re-assert, no restart */
+    return;
   }
+  relay_enter(RELAY_OPENING, now);
+}
+
+void hal_gpio_relay_connect(void) {
+  if (!g_safety_armed) {
+    ACT_LOG("[HAL] Relay connect blocked: safety not armed");
+    return;
+  }
+  if (g_relay.state != RELAY_CLOSED && g_relay.state != RELAY_CLOSING)
+    g_relay.connect_pending = true;
+  hal_gpio_actuators_poll(); /* Immediate when no dwell is owed */
+}
+
+relay_state_t hal_gpio_relay_state(void) { return g_relay.state; }
+
+uint32_t hal_gpio_relay_faults(void) { return g_relay.faults; }
+
+void hal_gpio_set_safety_armed(bool armed) {
+  g_safety_armed = armed;
+  if (!armed)
+    g_relay.connect_pending = false;
+}
+
+bool hal_gpio_is_safety_armed(void) { return g_safety_armed; }
+
+static void relay_poll(uint32_t now) {
+  switch (g_relay.state) {
+  case RELAY_OPENING:
+  case RELAY_CLOSING:
+    if (now - g_relay.since_ms < RELAY_SETTLE_MS)
+      return;
+    if (hal_gpio_read(GPIO_PIN_RELAY) != RELAY_DRIVE_LEVEL(g_relay.state)) {
+      /* Driver did not take: drive again and wait another settle */
+      g_relay.faults++;
+      relay_enter(g_relay.state, now);
+      return;
+    }
+    if (g_relay.state == RELAY_OPENING) {
+      g_relay.state = RELAY_OPEN;
+    } else {
+      g_relay.state = RELAY_CLOSED;
+      ACT_LOG("[HAL] Relay released — Battery connected");
+    }
+    g_relay.since_ms = now;
+    break;
+  case RELAY_OPEN:
+    if (g_relay.connect_pending && g_safety_armed &&
+        (int32_t)(now - g_relay.reconnect_ms) >= 0) {
+      g_relay.connect_pending = false;
+      relay_enter(RELAY_CLOSING, now);
+    }
+    break;
+  case RELAY_CLOSED:
+    break;
+  }
+}
+
+void hal_gpio_buzzer_play(buzzer_pattern_t pattern) {
+  if (pattern == g_buzzer.pattern && pattern != BUZZER_PULSE)
+    return;
+  if (pattern == BUZZER_OFF) {
+    hal_gpio_buzzer_stop();
+    return;
+  }
+  g_buzzer.pattern = pattern;
+  if (pattern != BUZZER_PULSE)
+    g_buzzer.on_ms = k_buzzer_patterns[pattern].on_ms;
+  g_buzzer.cycles_left = k_buzzer_patterns[pattern].cycles;
+  g_buzzer.on = true;
+  g_buzzer.phase_ms = hal_timer_millis();
+  hal_gpio_write(GPIO_PIN_BUZZER, GPIO_HIGH);
+}
+
+void hal_gpio_buzzer_pulse(uint16_t duration_ms) {
+  if (duration_ms == 0)
+    return;
+  g_buzzer.on_ms = duration_ms;
+  hal_gpio_buzzer_play(BUZZER_PULSE);
+}
+
+void hal_gpio_buzzer_stop(void) {
+  g_buzzer.pattern = BUZZER_OFF;
+  g_buzzer.on = false;
   hal_gpio_write(GPIO_PIN_BUZZER, GPIO_LOW);
 }
 
-#endif /* HAL_HOST_MODE */
+buzzer_pattern_t hal_gpio_buzzer_pattern(void) { return g_buzzer.pattern; }
+
+static void buzzer_poll(uint32_t now) {
+  if (g_buzzer.pattern == BUZZER_OFF)
+    return;
+  /* Phases advance by their length, not to `now`, so a late poll does
+   * not stretch the pattern */
+  if (g_buzzer.on) {
+    if (now - g_buzzer.phase_ms < g_buzzer.on_ms)
+      return;
+    g_buzzer.phase_ms += g_buzzer.on_ms;
+    g_buzzer.on = false;
+    hal_gpio_write(GPIO_PIN_BUZZER, GPIO_LOW);
+    if (g_buzzer.cycles_left && --g_buzzer.cycles_left == 0)
+      g_buzzer.pattern = BUZZER_OFF;
+  } else {
+    if (now - g_buzzer.phase_ms < k_buzzer_patterns[g_buzzer.pattern].off_ms)
+      return;
+    g_buzzer.phase_ms += k_buzzer_patterns[g_buzzer.pattern].off_ms;
+    g_buzzer.on = true;
+    hal_gpio_write(GPIO_PIN_BUZZER, GPIO_HIGH);
+  }
+}
+
+void hal_gpio_actuators_poll(void) {
+  uint32_t now = hal_timer_millis();
+  relay_poll(now);
+  buzzer_poll(now);
+}
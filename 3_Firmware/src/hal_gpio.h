@@ -59,12 +59,53 @@ gpio_level_t hal_gpio_read(uint8_t pin);
 /* Set the CD4051 MUX channel (0-7) to select which thermistor to read */
 void hal_gpio_mux_select(uint8_t channel);
 
+/* -----------------------------------------------------------------------
+ * Actuators — non-blocking
+ *
+ * Every call below returns immediately; timing lives in a small state
+ * machine advanced by hal_gpio_actuators_poll(), which the main loop
+ * calls on every pass (at least once per timer tick). Buzzer patterns
+ * and relay settling therefore never hold up UART polling or the
+ * evaluation loops.
+ *
+ * Relay: a disconnect drives the coil at once and is confirmed by
+ * reading the pin back after RELAY_SETTLE_MS (re-driven if it does not
+ * read back). A connect is a request: it is carried out only once the
+ * relay has been open RELAY_MIN_OPEN_MS, so an oscillating state cannot
+ * chatter the contactor, and any disconnect cancels it.
+ * ----------------------------------------------------------------------- */
+
+#define RELAY_SETTLE_MS 20    /* Contact release + bounce, 5 V module  */
+#define RELAY_MIN_OPEN_MS 2000 /* Reconnect no sooner after a disconnect */
+
+typedef enum {
+  RELAY_CLOSED = 0, /* Battery connected                      */
+  RELAY_OPENING,    /* Disconnect driven, contacts settling   */
+  RELAY_OPEN,       /* Disconnect confirmed                   */
+  RELAY_CLOSING,    /* Connect driven, contacts settling      */
+} relay_state_t;
+
+typedef enum {
+  BUZZER_OFF = 0,
+  BUZZER_PULSE, /* One tone (hal_gpio_buzzer_pulse)           */
+  BUZZER_ALARM, /* 500 ms on / 500 ms off until stopped       */
+  BUZZER_CHIRP, /* 3 × 50 ms, acknowledgements                */
+} buzzer_pattern_t;
+
+/* Advance buzzer patterns and relay settling to the current time */
+void hal_gpio_actuators_poll(void);
+
 /* Activate the relay to disconnect the battery (EMERGENCY action) */
 void hal_gpio_relay_disconnect(void);
 
-/* Deactivate the relay (re-connect battery — only works when safety is armed) */
+/* Request a reconnect (only honoured when safety is armed) */
 void hal_gpio_relay_connect(void);
 
+relay_state_t hal_gpio_relay_state(void);
+
+/* Times the relay pin failed to read back and was re-driven */
+uint32_t hal_gpio_relay_faults(void);
+
 /* Safety arm/disarm gate for relay connect path */
 void hal_gpio_set_safety_armed(bool armed);
 bool hal_gpio_is_safety_armed(void);
@@ -75,4 +116,9 @@ void hal_gpio_set_status_leds(uint8_t state);
 /* Sound the buzzer for a specified duration in milliseconds */
 void hal_gpio_buzzer_pulse(uint16_t duration_ms);
 
+/* Start a pattern; a pattern already playing keeps its phase */
+void hal_gpio_buzzer_play(buzzer_pattern_t pattern);
+void hal_gpio_buzzer_stop(void);
+buzzer_pattern_t hal_gpio_buzzer_pattern(void);
+
 #endif /* HAL_GPIO_H */
@@ -3,8 +3,168 @@
  */
 
 #include "hal_i2c.h"
+#include "hal_timer.h"
 #include <string.h>
 
+#define I2C_MAX_ADDR 128
+#define QUEUE_MASK (HAL_I2C_QUEUE_DEPTH - 1u)
+#define TIMEOUT_CYCLES (HAL_I2C_TIMEOUT_US * HAL_TIMER_CYCLES_PER_US)
+
+_Static_assert((HAL_I2C_QUEUE_DEPTH & QUEUE_MASK) == 0 &&
+                   HAL_I2C_QUEUE_DEPTH <= 128,
+               "HAL_I2C_QUEUE_DEPTH must be a power of two up to 128");
+_Static_assert(HAL_I2C_PRIO_COUNT == 2, "priority map holds one bit");
+
+/* Port: puts one transaction on the wire (simulated or THEJAS32) */
+static void port_begin(hal_i2c_xfer_t *x);
+static void port_idle(void);
+static void port_recover(void);
+
+/* -----------------------------------------------------------------------
+ * Transaction queue (both modes)
+ *
+ * Touched from the main loop and the controller interrupt; every
+ * change runs with interrupts off.
+ * ----------------------------------------------------------------------- */
+typedef struct {
+  hal_i2c_xfer_t *slot[HAL_I2C_QUEUE_DEPTH];
+  uint8_t head;
+  uint8_t tail;
+} xfer_fifo_t;
+
+static xfer_fifo_t queue[HAL_I2C_PRIO_COUNT];
+static hal_i2c_xfer_t *volatile active; /* On the wire */
+static uint32_t active_cyc;             /* When it started */
+static bool completing;                 /* A callback is running */
+static uint32_t prio_high[I2C_MAX_ADDR / 32];
+static hal_i2c_stats_t stats;
+
+static hal_i2c_prio_t prio_of(uint8_t addr) {
+  return (prio_high[addr >> 5] >> (addr & 31)) & 1u ? HAL_I2C_PRIO_HIGH
+                                                    : HAL_I2C_PRIO_LOW;
+}
+
+/* Oldest of the highest priority waiting */
+static hal_i2c_xfer_t *queue_pop(void) {
+  for (int p = 0; p < HAL_I2C_PRIO_COUNT; p++) {
+    xfer_fifo_t *q = &queue[p];
+    if (q->head != q->tail)
+      return q->slot[q->tail++ & QUEUE_MASK];
+  }
+  return NULL;
+}
+
+static void start_next(void) {
+  hal_i2c_xfer_t *x = queue_pop();
+  active = x;
+  if (!x) {
+    port_idle();
+    return;
+  }
+  active_cyc = hal_timer_cycles();
+  port_begin(x);
+}
+
+/* End the running transaction. A callback that submits more only
+ * queues it; the next start is picked after the callback returns. */
+static void finish(hal_status_t status) {
+  hal_i2c_xfer_t *x = active;
+  active = NULL;
+  if (status == HAL_OK)
+    stats.completed++;
+  else if (status == HAL_ERROR)
+    stats.nacks++;
+  else
+    stats.timeouts++;
+
+  x->status = status;
+  if (x->done) {
+    completing = true;
+    x->done(x);
+    completing = false;
+  }
+  start_next();
+}
+
+static void xfer_fill(hal_i2c_xfer_t *x, uint8_t addr, uint8_t reg,
+                      uint8_t *buf, uint8_t len, bool write) {
+  x->addr = addr;
+  x->reg = reg;
+  x->len = len;
+  x->write = write;
+  x->buf = buf;
+  x->done = NULL;
+  x->ctx = NULL;
+  x->status = HAL_OK;
+}
+
+void hal_i2c_xfer_read(hal_i2c_xfer_t *x, uint8_t addr, uint8_t reg,
+                       uint8_t *buf, uint8_t len) {
+  xfer_fill(x, addr, reg, buf, len, false);
+}
+
+void hal_i2c_xfer_write(hal_i2c_xfer_t *x, uint8_t addr, uint8_t reg,
+                        uint8_t *buf, uint8_t len) {
+  xfer_fill(x, addr, reg, buf, len, true);
+}
+
+void hal_i2c_set_priority(uint8_t bus, uint8_t addr, hal_i2c_prio_t prio) {
+  if (bus != I2C_BUS_DEFAULT || addr >= I2C_MAX_ADDR)
+    return;
+  uint32_t bit = 1u << (addr & 31);
+  if (prio == HAL_I2C_PRIO_HIGH)
+    prio_high[addr >> 5] |= bit;
+  else
+    prio_high[addr >> 5] &= ~bit;
+}
+
+hal_status_t hal_i2c_submit(uint8_t bus, hal_i2c_xfer_t *x) {
+  if (bus != I2C_BUS_DEFAULT || x->addr >= I2C_MAX_ADDR || x->len == 0 ||
+      x->len > HAL_I2C_MAX_BURST || !x->buf) {
+    x->status = HAL_ERROR;
+    return HAL_ERROR;
+  }
+
+  uint32_t irq = hal_irq_save();
+  xfer_fifo_t *q = &queue[prio_of(x->addr)];
+  if ((uint8_t)(q->head - q->tail) >= HAL_I2C_QUEUE_DEPTH) {
+    stats.rejected++;
+    hal_irq_restore(irq);
+    return HAL_BUSY;
+  }
+  x->status = HAL_BUSY;
+  q->slot[q->head++ & QUEUE_MASK] = x;
+  if (!active && !completing)
+    start_next();
+  hal_irq_restore(irq);
+  return HAL_OK;
+}
+
+bool hal_i2c_idle(uint8_t bus) {
+  (void)bus;
+  uint32_t irq = hal_irq_save();
+  bool idle = !active && queue[0].head == queue[0].tail &&
+              queue[1].head == queue[1].tail;
+  hal_irq_restore(irq);
+  return idle;
+}
+
+void hal_i2c_get_stats(uint8_t bus, hal_i2c_stats_t *out) {
+  (void)bus;
+  uint32_t irq = hal_irq_save();
+  *out = stats;
+  hal_irq_restore(irq);
+}
+
+/* A transaction past its deadline: free the bus, then carry on */
+static void check_timeout(void) {
+  if (active && hal_timer_cycles() - active_cyc >= TIMEOUT_CYCLES) {
+    port_recover();
+    stats.recoveries++;
+    finish(HAL_TIMEOUT);
+  }
+}
+
 /* -----------------------------------------------------------------------
  * HOST MODE — Mock I2C with simulated register map
  * ----------------------------------------------------------------------- */
@@ -13,11 +173,36 @@
 /* Simple simulated register storage:
  * sim_regs[device_addr][register_addr] = byte value
  * Limited to 128 addresses × 256 registers for simplicity. */
-#define SIM_MAX_DEVICES 128
+#define SIM_MAX_DEVICES I2C_MAX_ADDR
 #define SIM_MAX_REGS 256
 
 static uint8_t sim_regs[SIM_MAX_DEVICES][SIM_MAX_REGS];
 static bool sim_device_present[SIM_MAX_DEVICES] = {false};
+static bool sim_hung[SIM_MAX_DEVICES];
+
+/* Async: the result of the transaction on the wire, delivered by the
+ * next hal_i2c_poll() as the controller interrupt would */
+static bool sim_done;
+static hal_status_t sim_result;
+
+static hal_status_t sim_access(uint8_t addr, uint8_t reg, uint8_t *buf,
+                               uint8_t length, bool write) {
+  if (addr >= SIM_MAX_DEVICES)
+    return HAL_ERROR;
+  if (sim_hung[addr])
+    return HAL_TIMEOUT;
+  if (!sim_device_present[addr])
+    return HAL_ERROR; /* NACK */
+
+  for (uint8_t i = 0; i < length; i++) {
+    uint8_t r = (uint8_t)(reg + i); /* Register pointer wraps */
+    if (write)
+      sim_regs[addr][r] = buf[i];
+    else
+      buf[i] = sim_regs[addr][r];
+  }
+  return HAL_OK;
+}
 
 hal_status_t hal_i2c_init(uint8_t bus) {
   (void)bus;
@@ -27,33 +212,19 @@ hal_status_t hal_i2c_init(uint8_t bus) {
 hal_status_t hal_i2c_write(uint8_t bus, uint8_t addr, const uint8_t *data,
                            uint8_t length) {
   (void)bus;
-  if (addr >= SIM_MAX_DEVICES)
+  uint8_t buf[HAL_I2C_MAX_BURST];
+  if (length == 0 || length > HAL_I2C_MAX_BURST + 1)
     return HAL_ERROR;
-  if (!sim_device_present[addr])
-    return HAL_ERROR; /* NACK */
 
-  /* First byte is usually the register address, rest is data */
-  if (length >= 2) {
-    uint8_t reg = data[0];
-    for (uint8_t i = 1; i < length; i++) {
-      sim_regs[addr][reg + i - 1] = data[i];
-    }
-  }
-  return HAL_OK;
+  /* First byte is the register address, the rest is data */
+  memcpy(buf, data + 1, (size_t)(length - 1));
+  return sim_access(addr, data[0], buf, (uint8_t)(length - 1), true);
 }
 
 hal_status_t hal_i2c_read_reg(uint8_t bus, uint8_t addr, uint8_t reg,
                               uint8_t *buf, uint8_t length) {
   (void)bus;
-  if (addr >= SIM_MAX_DEVICES)
-    return HAL_ERROR;
-  if (!sim_device_present[addr])
-    return HAL_ERROR; /* NACK */
-
-  for (uint8_t i = 0; i < length; i++) {
-    buf[i] = sim_regs[addr][reg + i];
-  }
-  return HAL_OK;
+  return sim_access(addr, reg, buf, length, false);
 }
 
 uint8_t hal_i2c_scan(uint8_t bus, uint8_t *found) {
@@ -67,16 +238,43 @@ uint8_t hal_i2c_scan(uint8_t bus, uint8_t *found) {
   return count;
 }
 
+static void port_begin(hal_i2c_xfer_t *x) {
+  sim_result = sim_access(x->addr, x->reg, x->buf, x->len, x->write);
+  sim_done = sim_result != HAL_TIMEOUT; /* A hung device never finishes */
+}
+
+static void port_idle(void) {}
+
+static void port_recover(void) { sim_done = false; }
+
+void hal_i2c_poll(uint8_t bus) {
+  if (bus != I2C_BUS_DEFAULT)
+    return;
+  if (active && sim_done) {
+    sim_done = false;
+    finish(sim_result);
+    return;
+  }
+  check_timeout();
+}
+
+void hal_i2c_isr(void) {}
+
 void hal_i2c_sim_set_reg(uint8_t addr, uint8_t reg, const uint8_t *data,
                          uint8_t length) {
   if (addr >= SIM_MAX_DEVICES)
     return;
   sim_device_present[addr] = true;
   for (uint8_t i = 0; i < length; i++) {
-    sim_regs[addr][reg + i] = data[i];
+    sim_regs[addr][(uint8_t)(reg + i)] = data[i];
   }
 }
 
+void hal_i2c_sim_hang(uint8_t addr, bool hung) {
+  if (addr < SIM_MAX_DEVICES)
+    sim_hung[addr] = hung;
+}
+
 /* -----------------------------------------------------------------------
  * TARGET MODE — Real THEJAS32 I2C
  * ----------------------------------------------------------------------- */
@@ -86,46 +284,152 @@ void hal_i2c_sim_set_reg(uint8_t addr, uint8_t reg, const uint8_t *data,
  * Target I2C register integration placeholder.
  *
  * The board-in-loop demo path can ingest twin-fed frames over UART.
- * For direct sensor bus acquisition, map these calls to THEJAS32 I2C
- * memory-mapped registers.
+ * For direct sensor bus acquisition, map the controller accessors
+ * below to THEJAS32 I2C memory-mapped registers.
  *
  * Typical initialization:
  *   1. Enable I2C clock in system control
  *   2. Set SCL frequency (100kHz or 400kHz)
  *   3. Enable I2C controller
  *
- * For each transaction:
- *   1. Set slave address
- *   2. Write register address
- *   3. Read/write data bytes
- *   4. Check ACK/NACK status
+ * The controller raises its interrupt once per byte (address, register
+ * or data) with the ACK/NACK status; hal_i2c_isr() moves the running
+ * transaction on by one phase each time.
  */
 
+/* ---- Controller access — TODO: THEJAS32 I2C registers ---- */
+static inline void ctl_start(void) {}        /* START / repeated START  */
+static inline void ctl_send(uint8_t b) { (void)b; } /* Shift a byte out */
+static inline void ctl_recv(bool ack) { (void)ack; } /* Shift one in    */
+static inline uint8_t ctl_data(void) { return 0; }   /* Byte shifted in */
+static inline bool ctl_nacked(void) { return false; } /* Last byte out  */
+static inline void ctl_stop(void) {}
+static inline void ctl_irq(bool on) { (void)on; }
+
+/* Nine SCL clocks with SDA released let a slave stuck mid-byte finish
+ * and let go of SDA; a STOP then resets every slave's state machine,
+ * and reinitialising the controller clears its own state.
+ * TODO: SCL/SDA as GPIO for the clocks, then hal_i2c_init(). */
+static void ctl_bus_clear(void) {}
+
+typedef enum { PH_ADDR_W, PH_REG, PH_ADDR_R, PH_READ, PH_WRITE } phase_t;
+static phase_t phase;
+static uint8_t pos;
+
 hal_status_t hal_i2c_init(uint8_t bus) {
   (void)bus;
-  /* TODO: THEJAS32 I2C init */
-  return HAL_OK;
+  /* TODO: THEJAS32 I2C init. Until the ctl_* accessors above drive the
+   * registers, say so: a bus that "works" but never moves a byte would
+   * pass for an empty one. */
+  return HAL_ERROR;
+}
+
+static void port_begin(hal_i2c_xfer_t *x) {
+  phase = PH_ADDR_W;
+  pos = 0;
+  ctl_irq(true);
+  ctl_start();
+  ctl_send((uint8_t)(x->addr << 1));
+}
+
+static void port_idle(void) { ctl_irq(false); }
+
+static void port_recover(void) {
+  ctl_irq(false);
+  ctl_bus_clear();
+}
+
+void hal_i2c_isr(void) {
+  hal_i2c_xfer_t *x = active;
+  if (!x) {
+    ctl_irq(false);
+    return;
+  }
+
+  /* Address, register and write bytes must be acknowledged */
+  if (phase != PH_READ && ctl_nacked()) {
+    ctl_stop();
+    finish(HAL_ERROR);
+    return;
+  }
+
+  switch (phase) {
+  case PH_ADDR_W:
+    phase = PH_REG;
+    ctl_send(x->reg);
+    break;
+  case PH_REG:
+    if (x->write) {
+      phase = PH_WRITE;
+      ctl_send(x->buf[pos++]);
+    } else {
+      phase = PH_ADDR_R;
+      ctl_start();
+      ctl_send((uint8_t)(x->addr << 1 | 1u));
+    }
+    break;
+  case PH_WRITE:
+    if (pos < x->len) {
+      ctl_send(x->buf[pos++]);
+    } else {
+      ctl_stop();
+      finish(HAL_OK);
+    }
+    break;
+  case PH_ADDR_R:
+    phase = PH_READ;
+    ctl_recv(x->len > 1); /* NACK the last byte */
+    break;
+  case PH_READ:
+    x->buf[pos++] = ctl_data();
+    if (pos < x->len) {
+      ctl_recv(pos + 1u < x->len);
+    } else {
+      ctl_stop();
+      finish(HAL_OK);
+    }
+    break;
+  }
+}
+
+void hal_i2c_poll(uint8_t bus) {
+  if (bus != I2C_BUS_DEFAULT)
+    return;
+  uint32_t irq = hal_irq_save();
+  check_timeout();
+  hal_irq_restore(irq);
+}
+
+/* Init-time path: queue it, then wait (bounded by the timeout) */
+static hal_status_t transfer_blocking(hal_i2c_xfer_t *x) {
+  hal_status_t status = hal_i2c_submit(I2C_BUS_DEFAULT, x);
+  if (status != HAL_OK)
+    return status;
+  while (x->status == HAL_BUSY)
+    hal_i2c_poll(I2C_BUS_DEFAULT);
+  return x->status;
 }
 
 hal_status_t hal_i2c_write(uint8_t bus, uint8_t addr, const uint8_t *data,
                            uint8_t length) {
   (void)bus;
-  (void)addr;
-  (void)data;
-  (void)length;
-  /* TODO: THEJAS32 I2C write */
-  return HAL_OK;
+  uint8_t buf[HAL_I2C_MAX_BURST];
+  hal_i2c_xfer_t x;
+  if (length < 2 || length > HAL_I2C_MAX_BURST + 1)
+    return HAL_ERROR;
+
+  /* First byte is the register address, the rest is data */
+  memcpy(buf, data + 1, (size_t)(length - 1));
+  hal_i2c_xfer_write(&x, addr, data[0], buf, (uint8_t)(length - 1));
+  return transfer_blocking(&x);
 }
 
 hal_status_t hal_i2c_read_reg(uint8_t bus, uint8_t addr, uint8_t reg,
                               uint8_t *buf, uint8_t length) {
   (void)bus;
-  (void)addr;
-  (void)reg;
-  (void)buf;
-  (void)length;
-  /* TODO: THEJAS32 I2C read */
-  return HAL_OK;
+  hal_i2c_xfer_t x;
+  hal_i2c_xfer_read(&x, addr, reg, buf, length);
+  return transfer_blocking(&x);
 }
 
 uint8_t hal_i2c_scan(uint8_t bus, uint8_t *found) {
@@ -7,6 +7,10 @@
  *
  * On HOST mode: simulated register reads/writes for testing.
  * On TARGET mode: THEJAS32 I2C peripheral access.
+ *
+ * Two ways in: the blocking calls below (init-time setup, bus scan)
+ * and an interrupt-driven transaction queue for the loops, which never
+ * waits on the bus (see "Asynchronous transactions").
  */
 
 #ifndef HAL_I2C_H
@@ -58,6 +62,96 @@ hal_status_t hal_i2c_read_reg(uint8_t bus, uint8_t addr, uint8_t reg,
  */
 uint8_t hal_i2c_scan(uint8_t bus, uint8_t *found);
 
+/* -----------------------------------------------------------------------
+ * Asynchronous transactions
+ *
+ * One transaction moves one contiguous register block — a burst:
+ *
+ *   read:  START addr+W reg  rSTART addr+R  d0 … d(len-1)  STOP
+ *   write: START addr+W reg  d0 … d(len-1)  STOP
+ *
+ * Submitted transactions wait in one FIFO per priority; each device
+ * address has a priority (HAL_I2C_PRIO_LOW unless set). A transfer
+ * cannot be cut short on the wire, so the running one always
+ * finishes, and the next one is the oldest of the highest priority
+ * waiting: an INA219 current read goes ahead of every queued BME680
+ * transaction, behind at most one already on the bus.
+ *
+ * The controller interrupt (hal_i2c_isr) runs the bytes. A transaction
+ * that takes longer than HAL_I2C_TIMEOUT_US is aborted with
+ * HAL_TIMEOUT, and the bus is recovered (nine SCL clocks with SDA
+ * released, then STOP) before the next one, so a sensor holding SDA
+ * low costs its own reading and nothing else. hal_i2c_poll() from the
+ * main loop runs that check.
+ *
+ * When a transaction ends its status is set and its callback (if any)
+ * runs — from the interrupt on the target, from hal_i2c_poll() on the
+ * host. Keep callbacks to a few instructions. The caller owns the
+ * transaction and its buffer; leave both alone while the status reads
+ * HAL_BUSY.
+ * ----------------------------------------------------------------------- */
+
+#define HAL_I2C_QUEUE_DEPTH 8    /* Waiting transactions per priority      */
+#define HAL_I2C_MAX_BURST 32     /* Bytes per transaction                  */
+#define HAL_I2C_TIMEOUT_US 5000  /* 32 B at 100 kHz is ~3.3 ms on the wire */
+
+typedef enum {
+  HAL_I2C_PRIO_HIGH = 0, /* Safety-path reads (INA219 current) */
+  HAL_I2C_PRIO_LOW,
+  HAL_I2C_PRIO_COUNT
+} hal_i2c_prio_t;
+
+typedef struct hal_i2c_xfer hal_i2c_xfer_t;
+
+/* Completion callback; x->status holds the result */
+typedef void (*hal_i2c_done_t)(hal_i2c_xfer_t *x);
+
+struct hal_i2c_xfer {
+  uint8_t addr;
+  uint8_t reg;
+  uint8_t len;    /* 1..HAL_I2C_MAX_BURST */
+  bool write;
+  uint8_t *buf;   /* Read destination or write source, len bytes */
+  hal_i2c_done_t done;
+  void *ctx;      /* For the callback */
+  volatile hal_status_t status; /* HAL_BUSY until done; HAL_ERROR = NACK */
+};
+
+typedef struct {
+  uint32_t completed;
+  uint32_t nacks;
+  uint32_t timeouts;
+  uint32_t recoveries;
+  uint32_t rejected; /* Submits refused with a full queue */
+} hal_i2c_stats_t;
+
+/* Fill in a read or write burst (status and callback cleared) */
+void hal_i2c_xfer_read(hal_i2c_xfer_t *x, uint8_t addr, uint8_t reg,
+                       uint8_t *buf, uint8_t len);
+void hal_i2c_xfer_write(hal_i2c_xfer_t *x, uint8_t addr, uint8_t reg,
+                        uint8_t *buf, uint8_t len);
+
+/* Priority of every later transaction to `addr` */
+void hal_i2c_set_priority(uint8_t bus, uint8_t addr, hal_i2c_prio_t prio);
+
+/*
+ * Queue `x` at its device's priority; it starts at once if the bus is
+ * idle. HAL_BUSY if that priority's queue is full, HAL_ERROR for a bad
+ * bus or length (x->status says the same, and no callback runs).
+ */
+hal_status_t hal_i2c_submit(uint8_t bus, hal_i2c_xfer_t *x);
+
+/* Main-loop hook: timeout and recovery; never waits */
+void hal_i2c_poll(uint8_t bus);
+
+/* No transaction running or waiting */
+bool hal_i2c_idle(uint8_t bus);
+
+void hal_i2c_get_stats(uint8_t bus, hal_i2c_stats_t *stats);
+
+/* Controller interrupt, from the trap dispatcher (target) */
+void hal_i2c_isr(void);
+
 /* -----------------------------------------------------------------------
  * HOST-MODE simulation helpers
  * ----------------------------------------------------------------------- */
@@ -69,6 +163,12 @@ uint8_t hal_i2c_scan(uint8_t bus, uint8_t *found);
  */
 void hal_i2c_sim_set_reg(uint8_t addr, uint8_t reg, const uint8_t *data,
                          uint8_t length);
+
+/*
+ * Make a device hold the bus: its transactions never complete (async
+ * ones time out) until released. A recovery does not release it.
+ */
+void hal_i2c_sim_hang(uint8_t addr, bool hung);
 #endif
 
 #endif /* HAL_I2C_H */
@@ -35,4 +35,53 @@ typedef enum {
   HAL_BUSY = -3,
 } hal_status_t;
 
+/* -----------------------------------------------------------------------
+ * Interrupt masking
+ *
+ * Short critical sections shared between the main loop and ISRs
+ * (ring-buffer indices, peripheral enable bits). On HOST there are no
+ * interrupts, so these compile to nothing.
+ * ----------------------------------------------------------------------- */
+/* Keep the compiler from moving memory accesses across this point.
+ * The core is in order, so it orders ring contents against the index
+ * that publishes them (ISR vs main loop) without a fence. */
+#define HAL_COMPILER_BARRIER() __asm__ volatile("" ::: "memory")
+
+#if HAL_HOST_MODE
+static inline uint32_t hal_irq_save(void) { return 0; }
+static inline void hal_irq_restore(uint32_t state) { (void)state; }
+static inline void hal_irq_enable_global(void) {}
+#else
+#define HAL_MSTATUS_MIE (1u << 3)
+
+/* Clear mstatus.MIE and return its previous value */
+static inline uint32_t hal_irq_save(void) {
+  uint32_t prev;
+  __asm__ volatile("csrrci %0, mstatus, 8" : "=r"(prev)::"memory");
+  return prev & HAL_MSTATUS_MIE;
+}
+
+static inline void hal_irq_restore(uint32_t state) {
+  if (state)
+    __asm__ volatile("csrsi mstatus, 8" ::: "memory");
+}
+
+static inline void hal_irq_enable_global(void) {
+  __asm__ volatile("csrsi mstatus, 8" ::: "memory");
+}
+#endif
+
+/* -----------------------------------------------------------------------
+ * Fast code
+ *
+ * Marks the per-sample hot loops (evaluator, RX parser). On the target
+ * they go to the .fast_text section, which thejas32_linker.ld places in
+ * its fast region, kept together ahead of the rest of the code.
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+#define HAL_FAST_CODE
+#else
+#define HAL_FAST_CODE __attribute__((section(".fast_text")))
+#endif
+
 #endif /* HAL_PLATFORM_H */
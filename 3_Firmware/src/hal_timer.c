@@ -0,0 +1,87 @@
+/*
+ * hal_timer.c — System Tick Timer Implementation (HOST + TARGET)
+ */
+
+#include "hal_timer.h"
+
+/* Written by the tick ISR, read by the main loop. A 32-bit aligned
+ * load is atomic on RV32, so readers need no critical section. */
+static volatile uint32_t millis = 0;
+static uint32_t tick_step_ms = 1;
+
+uint32_t hal_timer_millis(void) { return millis; }
+
+/* -----------------------------------------------------------------------
+ * HOST MODE — Simulated clock
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+
+#include <time.h>
+
+hal_status_t hal_timer_init(uint32_t tick_ms) {
+  if (tick_ms == 0)
+    return HAL_ERROR;
+  tick_step_ms = tick_ms;
+  millis = 0;
+  return HAL_OK;
+}
+
+void hal_timer_idle(void) {
+  /* "Sleep" until the next tick */
+  millis += tick_step_ms;
+}
+
+void hal_timer_isr(void) { /* No interrupts on host */ }
+
+uint32_t hal_timer_cycles(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+  return (uint32_t)(ns * HAL_TIMER_CYCLES_PER_US / 1000u);
+}
+
+void hal_timer_sim_advance(uint32_t ms) { millis += ms; }
+
+/* -----------------------------------------------------------------------
+ * TARGET MODE — THEJAS32 Timer0
+ * ----------------------------------------------------------------------- */
+#else
+
+#include "../target/thejas32_regs.h"
+
+hal_status_t hal_timer_init(uint32_t tick_ms) {
+  if (tick_ms == 0)
+    return HAL_ERROR;
+  tick_step_ms = tick_ms;
+  millis = 0;
+
+  TIMER0_CONTROL = 0; /* Stop while reprogramming */
+  TIMER0_LOAD_COUNT = (THEJAS32_SYSCLK_HZ / 1000u) * tick_ms - 1u;
+  (void)TIMER0_EOI;   /* Drop any stale interrupt */
+  TIMER0_CONTROL = TIMER_CTRL_ENABLE | TIMER_CTRL_PERIODIC;
+
+  PLIC_INTR_ENABLE |= (1u << IRQ_TIMER0);
+  __asm__ volatile("csrs mie, %0" ::"r"(MIE_MEIE));
+  hal_irq_enable_global();
+  return HAL_OK;
+}
+
+void hal_timer_isr(void) {
+  (void)TIMER0_EOI; /* Reading EOI acknowledges the tick */
+  millis += tick_step_ms;
+}
+
+uint32_t hal_timer_cycles(void) {
+  uint32_t c;
+  __asm__ volatile("csrr %0, mcycle" : "=r"(c));
+  return c;
+}
+
+void hal_timer_idle(void) {
+  /* Any enabled interrupt (tick or UART RX) ends the sleep. An IRQ
+   * that lands just before WFI is serviced first; the next tick then
+   * bounds the extra latency to one tick period. */
+  __asm__ volatile("wfi");
+}
+
+#endif /* HAL_HOST_MODE */
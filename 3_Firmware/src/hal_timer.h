@@ -0,0 +1,55 @@
+/*
+ * hal_timer.h — System Tick Timer Abstraction
+ *
+ * Used for:
+ *   - Monotonic millisecond clock driving the loop scheduler
+ *   - Waking the core from WFI on every tick
+ *   - Cycle counter for loop latency measurement
+ *
+ * On HOST mode: a simulated clock that only moves when told to, so
+ *               scenario runs stay instant and deterministic.
+ * On TARGET mode: THEJAS32 Timer0 in periodic mode, interrupt-driven.
+ */
+
+#ifndef HAL_TIMER_H
+#define HAL_TIMER_H
+
+#include "hal_platform.h"
+
+/*
+ * Start the periodic tick. Every `tick_ms` the timer interrupt
+ * advances the millisecond clock and wakes any pending idle.
+ */
+hal_status_t hal_timer_init(uint32_t tick_ms);
+
+/* Milliseconds since hal_timer_init (wraps after ~49 days) */
+uint32_t hal_timer_millis(void);
+
+/*
+ * Sleep until the next interrupt (tick, UART, ...).
+ * On HOST this advances the simulated clock by one tick instead.
+ */
+void hal_timer_idle(void);
+
+/*
+ * Free-running cycle counter (RISC-V mcycle on TARGET). Wraps after
+ * ~43 s at 100 MHz, so use it for intervals only. On HOST it is
+ * derived from CLOCK_MONOTONIC, scaled to the same cycle rate.
+ */
+#define HAL_TIMER_CYCLES_PER_US 100u
+uint32_t hal_timer_cycles(void);
+
+/*
+ * Timer interrupt service routine. Called from the trap dispatcher.
+ */
+void hal_timer_isr(void);
+
+/* -----------------------------------------------------------------------
+ * HOST-MODE simulation helpers
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+/* Move the simulated clock forward by `ms` */
+void hal_timer_sim_advance(uint32_t ms);
+#endif
+
+#endif /* HAL_TIMER_H */
@@ -6,20 +6,87 @@
 #include <stdio.h>
 #include <string.h>
 
+/* -----------------------------------------------------------------------
+ * Ring buffers (shared by HOST and TARGET)
+ *
+ * Single-producer / single-consumer. Indices are free-running 16-bit
+ * counters masked on access, so head - tail is always the fill level
+ * and neither side needs a lock:
+ *   RX: ISR produces, main loop consumes
+ *   TX: main loop produces, ISR consumes
+ * The ring arrays are plain memory, so a barrier keeps the contents on
+ * the right side of each index access: written before the head is
+ * published, read after the head is loaded and before the tail frees
+ * the slots again.
+ * ----------------------------------------------------------------------- */
+
+#define TX_MASK (UART_TX_RING_SIZE - 1u)
+#define RX_MASK (UART_RX_RING_SIZE - 1u)
+
+static volatile uint16_t tx_head = 0;
+static volatile uint16_t tx_tail = 0;
+
+static uint8_t rx_ring[UART_RX_RING_SIZE];
+static volatile uint16_t rx_head = 0;
+static volatile uint16_t rx_tail = 0;
+static volatile uint32_t rx_overflows = 0;
+
+static inline void rx_push(uint8_t b) {
+  uint16_t head = rx_head;
+  if ((uint16_t)(head - rx_tail) >= UART_RX_RING_SIZE) {
+    rx_overflows++;
+    return;
+  }
+  rx_ring[head & RX_MASK] = b;
+  HAL_COMPILER_BARRIER();
+  rx_head = (uint16_t)(head + 1u);
+}
+
+static uint16_t rx_pop_into(uint8_t *buf, uint16_t max_len) {
+  uint16_t tail = rx_tail;
+  uint16_t avail = (uint16_t)(rx_head - tail);
+  uint16_t n = avail < max_len ? avail : max_len;
+  HAL_COMPILER_BARRIER();
+  for (uint16_t i = 0; i < n; i++) {
+    buf[i] = rx_ring[(uint16_t)(tail + i) & RX_MASK];
+  }
+  HAL_COMPILER_BARRIER();
+  rx_tail = (uint16_t)(tail + n);
+  return n;
+}
+
+uint16_t hal_uart_tx_pending(void) { return (uint16_t)(tx_head - tx_tail); }
+
+uint32_t hal_uart_rx_overflow_count(void) { return rx_overflows; }
+
 /* -----------------------------------------------------------------------
  * HOST MODE — Output to stdout
  * ----------------------------------------------------------------------- */
 #if HAL_HOST_MODE
 
-hal_status_t hal_uart_init(void) { return HAL_OK; }
+hal_status_t hal_uart_init(void) {
+  tx_head = tx_tail = 0;
+  rx_head = rx_tail = 0;
+  rx_overflows = 0;
+  return HAL_OK;
+}
 
-hal_status_t hal_uart_send(const uint8_t *data, uint8_t length) {
-  /* In host mode, print raw bytes as hex for debugging */
+/* In host mode, print raw bytes as hex for debugging */
+static void host_trace(const uint8_t *data, uint16_t length) {
   printf("[UART TX %d bytes] ", length);
-  for (uint8_t i = 0; i < length; i++) {
+  for (uint16_t i = 0; i < length; i++) {
     printf("%02X ", data[i]);
   }
   printf("\n");
+}
+
+hal_status_t hal_uart_send(const uint8_t *data, uint8_t length) {
+  host_trace(data, length);
+  return HAL_OK;
+}
+
+hal_status_t hal_uart_send_async(const uint8_t *data, uint16_t length) {
+  host_trace(data, length); /* No wire on host — drained at once */
   return HAL_OK;
 }
 
@@ -29,8 +96,22 @@ hal_status_t hal_uart_print(const char *str) {
 }
 
 int hal_uart_recv_byte(void) {
-  /* In host mode, no serial input — return -1 */
-  return -1;
+  uint8_t b;
+  return rx_pop_into(&b, 1) ? (int)b : -1;
+}
+
+uint16_t hal_uart_recv_into(uint8_t *buf, uint16_t max_len) {
+  return rx_pop_into(buf, max_len);
+}
+
+void hal_uart_isr(void) { /* No interrupts on host */ }
+
+uint16_t hal_uart_sim_inject_rx(const uint8_t *data, uint16_t length) {
+  uint32_t before = rx_overflows;
+  for (uint16_t i = 0; i < length; i++) {
+    rx_push(data[i]);
+  }
+  return (uint16_t)(length - (uint16_t)(rx_overflows - before));
 }
 
 /* -----------------------------------------------------------------------
@@ -38,45 +119,150 @@ int hal_uart_recv_byte(void) {
  * ----------------------------------------------------------------------- */
 #else
 
-hal_status_t hal_uart_init(void) {
-/* THEJAS32 UART0 is already initialized by the bootloader
- * at 115200 baud, 8N1. We just ensure FIFOs are enabled. */
 #include "../target/thejas32_regs.h"
-  UART0_FCR = UART_FCR_ENABLE | UART_FCR_CLEAR;
-  UART0_IER = 0; /* Disable interrupts — we use polling */
+
+static uint8_t tx_ring[UART_TX_RING_SIZE];
+
+static inline uint16_t tx_free(void) {
+  return (uint16_t)(UART_TX_RING_SIZE - (uint16_t)(tx_head - tx_tail));
+}
+
+static void tx_copy_in(const uint8_t *data, uint16_t length) {
+  uint16_t head = tx_head;
+  for (uint16_t i = 0; i < length; i++) {
+    tx_ring[(uint16_t)(head + i) & TX_MASK] = data[i];
+  }
+  HAL_COMPILER_BARRIER();
+  tx_head = (uint16_t)(head + length); /* Publish after the copy */
+}
+
+/* Move every byte sitting in the RX FIFO into the RX ring */
+static void uart0_rx_drain(void) {
+  while (UART0_LSR & UART_LSR_DR) {
+    rx_push((uint8_t)(UART0_RBR & 0xFF));
+  }
+}
+
+/* Refill the TX FIFO from the TX ring; stop THRE interrupts when empty */
+static void uart0_tx_fill(void) {
+  if (!(UART0_LSR & UART_LSR_THRE))
+    return;
+
+  uint16_t tail = tx_tail;
+  uint16_t head = tx_head;
+  uint16_t n = 0;
+  HAL_COMPILER_BARRIER();
+  while (tail != head && n < UART_FIFO_DEPTH) {
+    UART0_THR = tx_ring[tail & TX_MASK];
+    tail++;
+    n++;
+  }
+  HAL_COMPILER_BARRIER();
+  tx_tail = tail;
+
+  if (tail == tx_head) {
+    UART0_IER &= ~UART_IER_THRI;
+  }
+}
+
+static void uart0_tx_kick(void) {
+  uint32_t irq = hal_irq_save();
+  UART0_IER |= UART_IER_THRI;
+  uart0_tx_fill();
+  hal_irq_restore(irq);
+}
+
+hal_status_t hal_uart_init(void) {
+  /* THEJAS32 UART0 is already initialized by the bootloader
+   * at 115200 baud, 8N1. Enable FIFOs and the RX interrupt; the TX
+   * interrupt is only armed while the TX ring holds data. */
+  tx_head = tx_tail = 0;
+  rx_head = rx_tail = 0;
+  rx_overflows = 0;
+
+  UART0_FCR = UART_FCR_ENABLE | UART_FCR_CLEAR | UART_FCR_RX_TRIG_8;
+  UART0_IER = UART_IER_RDI;
+
+  PLIC_INTR_ENABLE |= (1u << IRQ_UART0);
+  __asm__ volatile("csrs mie, %0" ::"r"(MIE_MEIE));
+  hal_irq_enable_global();
   return HAL_OK;
 }
 
-static void uart0_putc(uint8_t c) {
-#include "../target/thejas32_regs.h"
-  /* Wait until Transmit Holding Register is empty */
-  while (!(UART0_LSR & UART_LSR_THRE)) {
+void hal_uart_isr(void) {
+  uint32_t iir;
+  while (((iir = UART0_IIR) & UART_IIR_ID_MASK) != UART_IIR_NONE) {
+    switch (iir & UART_IIR_ID_MASK) {
+    case UART_IIR_RDA:
+    case UART_IIR_TIMEOUT:
+      uart0_rx_drain();
+      break;
+    case UART_IIR_THRE:
+      uart0_tx_fill();
+      break;
+    case UART_IIR_RLS:
+      (void)UART0_LSR; /* Reading LSR clears the line-status condition */
+      uart0_rx_drain();
+      break;
+    default:
+      return;
+    }
   }
-  UART0_THR = c;
 }
 
-hal_status_t hal_uart_send(const uint8_t *data, uint8_t length) {
-  for (uint8_t i = 0; i < length; i++) {
-    uart0_putc(data[i]);
+hal_status_t hal_uart_send_async(const uint8_t *data, uint16_t length) {
+  if (length > tx_free())
+    return HAL_BUSY;
+  tx_copy_in(data, length);
+  uart0_tx_kick();
+  return HAL_OK;
+}
+
+/* Queue bytes, waiting for ring space if needed. While waiting we push
+ * the FIFO ourselves, so this still completes with interrupts masked. */
+static void uart0_send_blocking(const uint8_t *data, uint16_t length) {
+  while (length > 0) {
+    uint16_t space = tx_free();
+    if (space == 0) {
+      uint32_t irq = hal_irq_save();
+      uart0_tx_fill();
+      hal_irq_restore(irq);
+      continue;
+    }
+    uint16_t n = length < space ? length : space;
+    tx_copy_in(data, n);
+    uart0_tx_kick();
+    data += n;
+    length -= n;
   }
+}
+
+hal_status_t hal_uart_send(const uint8_t *data, uint8_t length) {
+  uart0_send_blocking(data, length);
   return HAL_OK;
 }
 
 hal_status_t hal_uart_print(const char *str) {
+  static const uint8_t cr = '\r';
   while (*str) {
     if (*str == '\n')
-      uart0_putc('\r'); /* CRLF for terminal */
-    uart0_putc((uint8_t)*str++);
+      uart0_send_blocking(&cr, 1); /* CRLF for terminal */
+    uart0_send_blocking((const uint8_t *)str++, 1);
   }
   return HAL_OK;
 }
 
 int hal_uart_recv_byte(void) {
-#include "../target/thejas32_regs.h"
-  if (UART0_LSR & UART_LSR_DR) {
-    return (int)(UART0_RBR & 0xFF);
-  }
-  return -1; /* No data available */
+  uint8_t b;
+  return hal_uart_recv_into(&b, 1) ? (int)b : -1;
+}
+
+uint16_t hal_uart_recv_into(uint8_t *buf, uint16_t max_len) {
+  /* Pick up anything below the FIFO trigger level the ISR hasn't seen */
+  uint32_t irq = hal_irq_save();
+  uart0_rx_drain();
+  hal_irq_restore(irq);
+  return rx_pop_into(buf, max_len);
 }
 
 #endif /* HAL_HOST_MODE */
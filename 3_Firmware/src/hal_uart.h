@@ -4,9 +4,15 @@
  * Used for:
  *   - Sending telemetry packets to ESP32-C3 (or directly to laptop via USB)
  *   - Debug printing during development
+ *   - Receiving input frames from the digital twin
  *
  * On HOST mode: writes to stdout (printf).
- * On TARGET mode: uses THEJAS32 UART peripheral.
+ * On TARGET mode: uses THEJAS32 UART peripheral, interrupt-driven.
+ *
+ * Both directions go through software ring buffers. The UART ISR moves
+ * bytes between the 16-byte hardware FIFOs and the rings, so the main
+ * loop never waits on the wire and inbound bytes are not lost while a
+ * loop is busy evaluating.
  */
 
 #ifndef HAL_UART_H
@@ -18,8 +24,15 @@
 #define UART_BAUD_RATE 115200
 #define UART_TX_BUF_SIZE 64
 
+/* Ring buffer sizes (must be powers of two).
+ * TX holds a full slow-loop burst: 9 data frames (174 B) + 5 latency
+ * frames (125 B) + 2 group voltage frames (42 B) + [TEL] event. */
+#define UART_TX_RING_SIZE 512
+#define UART_RX_RING_SIZE 256
+
 /*
  * Initialize UART with the configured baud rate.
+ * On TARGET this also enables the RX interrupt.
  */
 hal_status_t hal_uart_init(void);
 
@@ -27,11 +40,19 @@ hal_status_t hal_uart_init(void);
  * Send a buffer of raw bytes over UART.
  * This is used for sending telemetry packets.
  *
+ * Queued into the TX ring; only waits if the ring is full.
+ *
  * data:   pointer to bytes to send
  * length: number of bytes
  */
 hal_status_t hal_uart_send(const uint8_t *data, uint8_t length);
 
+/*
+ * Non-blocking send: queue all `length` bytes or none of them.
+ * Returns HAL_OK if queued, HAL_BUSY if the TX ring lacks space.
+ */
+hal_status_t hal_uart_send_async(const uint8_t *data, uint16_t length);
+
 /*
  * Send a null-terminated string over UART.
  * This is used for debug messages.
@@ -44,4 +65,33 @@ hal_status_t hal_uart_print(const char *str);
  */
 int hal_uart_recv_byte(void);
 
+/*
+ * Bulk non-blocking receive: copy up to `max_len` buffered bytes into
+ * `buf`. Returns the number of bytes copied (0 if nothing pending).
+ */
+uint16_t hal_uart_recv_into(uint8_t *buf, uint16_t max_len);
+
+/* Number of bytes still waiting in the TX ring */
+uint16_t hal_uart_tx_pending(void);
+
+/* Bytes dropped because the RX ring was full (twin outran the loop) */
+uint32_t hal_uart_rx_overflow_count(void);
+
+/*
+ * UART interrupt service routine. Called from the trap dispatcher.
+ * Drains the RX FIFO into the RX ring and refills the TX FIFO.
+ */
+void hal_uart_isr(void);
+
+/* -----------------------------------------------------------------------
+ * HOST-MODE simulation helpers
+ * ----------------------------------------------------------------------- */
+#if HAL_HOST_MODE
+/*
+ * Push bytes into the RX ring as if they had arrived on the wire.
+ * Returns the number of bytes accepted.
+ */
+uint16_t hal_uart_sim_inject_rx(const uint8_t *data, uint16_t length);
+#endif
+
 #endif /* HAL_UART_H */
@@ -0,0 +1,136 @@
+/*
+ * history.c — Sensor History Ring with Windowed Rate Estimators
+ */
+
+#include "history.h"
+#include <string.h>
+
+_Static_assert((HISTORY_DEPTH & (HISTORY_DEPTH - 1)) == 0,
+               "HISTORY_DEPTH must be a power of two");
+
+#define HIST_MASK (HISTORY_DEPTH - 1u)
+
+/* -----------------------------------------------------------------------
+ * Initialize
+ * ----------------------------------------------------------------------- */
+void history_init(history_t *h) { memset(h, 0, sizeof(history_t)); }
+
+int history_add_window(history_t *h, uint8_t first_ch, uint8_t num_ch,
+                       uint32_t window_ms) {
+  if (h->num_windows >= HISTORY_MAX_WINDOWS || num_ch == 0 ||
+      first_ch + num_ch > HIST_NUM_CHANNELS)
+    return -1;
+  if (window_ms > HISTORY_REBASE_MS)
+    window_ms = HISTORY_REBASE_MS; /* Bounds the relative times */
+
+  history_window_t *w = &h->win[h->num_windows];
+  memset(w, 0, sizeof(*w));
+  w->window_ms = window_ms;
+  w->first_ch = first_ch;
+  w->num_ch = num_ch;
+  w->tail = h->head; /* Starts empty at the next sample */
+  return h->num_windows++;
+}
+
+/* -----------------------------------------------------------------------
+ * Running sums
+ * ----------------------------------------------------------------------- */
+
+/* Add (sign = 1) or remove (sign = -1) sample i from the window sums */
+static void window_apply(history_window_t *w, const history_t *h, uint16_t i,
+                         int64_t sign) {
+  uint16_t slot = i & HIST_MASK;
+  int64_t t = (int64_t)(uint32_t)(h->t_ms[slot] - w->base_ms);
+  const int32_t *row = h->v[slot];
+
+  w->st += sign * t;
+  w->stt += sign * t * t;
+  for (uint8_t c = w->first_ch; c < w->first_ch + w->num_ch; c++) {
+    w->sv[c] += sign * row[c];
+    w->stv[c] += sign * t * row[c];
+  }
+}
+
+/* Move the time base up to the oldest sample, shifting the sums in
+ * place: Σ(t−d) = Σt − nd, Σ(t−d)² = Σt² − 2dΣt + nd², Σ(t−d)v = Σtv − dΣv */
+static void window_rebase(history_window_t *w, const history_t *h) {
+  uint32_t new_base = h->t_ms[w->tail & HIST_MASK];
+  int64_t d = (int64_t)(uint32_t)(new_base - w->base_ms);
+  int64_t n = w->count;
+
+  w->stt += -2 * d * w->st + n * d * d;
+  w->st -= n * d;
+  for (uint8_t c = w->first_ch; c < w->first_ch + w->num_ch; c++)
+    w->stv[c] -= d * w->sv[c];
+  w->base_ms = new_base;
+}
+
+static void window_update(history_window_t *w, const history_t *h,
+                          uint32_t t_ms) {
+  if (w->count == 0)
+    w->base_ms = t_ms;
+
+  window_apply(w, h, (uint16_t)(h->head - 1u), 1);
+  w->count++;
+
+  /* Age out, and never keep the slot the next push overwrites */
+  while (w->count > 1 &&
+         (w->count >= HISTORY_DEPTH ||
+          t_ms - h->t_ms[w->tail & HIST_MASK] > w->window_ms)) {
+    window_apply(w, h, w->tail, -1);
+    w->tail++;
+    w->count--;
+  }
+
+  if (t_ms - w->base_ms >= HISTORY_REBASE_MS)
+    window_rebase(w, h);
+}
+
+/* -----------------------------------------------------------------------
+ * Record a sample
+ * ----------------------------------------------------------------------- */
+void history_push(history_t *h, uint32_t t_ms,
+                  const int32_t values[HIST_NUM_CHANNELS]) {
+  uint16_t slot = h->head & HIST_MASK;
+  h->t_ms[slot] = t_ms;
+  memcpy(h->v[slot], values, sizeof(h->v[slot]));
+  h->head++;
+
+  for (uint8_t i = 0; i < h->num_windows; i++)
+    window_update(&h->win[i], h, t_ms);
+}
+
+/* -----------------------------------------------------------------------
+ * Estimates
+ * ----------------------------------------------------------------------- */
+float history_slope(const history_t *h, int id, uint8_t ch) {
+  const history_window_t *w = &h->win[id];
+  if (ch < w->first_ch || ch >= w->first_ch + w->num_ch)
+    return 0.0f;
+
+  int64_t n = w->count;
+  int64_t den = n * w->stt - w->st * w->st;
+  if (n < 2 || den <= 0)
+    return 0.0f;
+  int64_t num = n * w->stv[ch] - w->st * w->sv[ch];
+  return (float)num / (float)den * 1000.0f; /* Per ms → per second */
+}
+
+int32_t history_slope_scaled(const history_t *h, int id, uint8_t ch,
+                             int32_t scale) {
+  const history_window_t *w = &h->win[id];
+  if (ch < w->first_ch || ch >= w->first_ch + w->num_ch)
+    return 0;
+
+  int64_t n = w->count;
+  int64_t den = n * w->stt - w->st * w->st;
+  if (n < 2 || den <= 0)
+    return 0;
+  int64_t num = (n * w->stv[ch] - w->st * w->sv[ch]) * scale;
+  int64_t q = (num + (num < 0 ? -den / 2 : den / 2)) / den;
+  return q > INT32_MAX ? INT32_MAX : q < INT32_MIN ? INT32_MIN : (int32_t)q;
+}
+
+uint16_t history_window_count(const history_t *h, int id) {
+  return h->win[id].count;
+}
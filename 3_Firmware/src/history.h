@@ -0,0 +1,95 @@
+/*
+ * history.h — Sensor History Ring with Windowed Rate Estimators
+ *
+ * Keeps the last HISTORY_DEPTH med-loop samples of the rate-bearing
+ * channels (both NTCs of every module, R_int, pack current, both gas
+ * and both pressure sensors) with the real time each was taken.
+ *
+ * A window fits a least-squares line to the samples of its channels
+ * that are no older than window_ms, so a rate is
+ *
+ *   slope = (n·Σtv − Σt·Σv) / (n·Σt² − (Σt)²)
+ *
+ * over real timestamps — right whatever rate the scheduler runs at, and
+ * averaged over the window instead of one noisy difference. The sums
+ * are int64 running sums: each push adds the new sample and subtracts
+ * the ones that aged out, so the cost per sample is constant in the
+ * window length. Times are kept relative to a base that is moved up
+ * every HISTORY_REBASE_MS, which keeps the sums exact and far from
+ * overflow.
+ *
+ * Values are integers in milli-units (milli-°C, µΩ, mA, gas ratio
+ * ×1000, milli-hPa), chosen by the caller.
+ *
+ * Each sample carries the time it was taken (history_push()); nothing
+ * here reads a clock.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "anomaly_eval.h"
+
+#define HISTORY_DEPTH 64           /* Samples kept (power of two)        */
+#define HISTORY_MAX_WINDOWS 4
+#define HISTORY_REBASE_MS 65536u   /* Keeps relative times under 2^17    */
+
+/* Channel layout */
+#define HIST_CH_NTC(m, i) ((uint8_t)(2 * (m) + (i))) /* i = 0 (NTC1), 1 */
+#define HIST_CH_R_INT (2 * NUM_MODULES)
+#define HIST_CH_CURRENT (HIST_CH_R_INT + 1)
+#define HIST_CH_GAS_1 (HIST_CH_R_INT + 2)
+#define HIST_CH_GAS_2 (HIST_CH_R_INT + 3)
+#define HIST_CH_PRESSURE_1 (HIST_CH_R_INT + 4)
+#define HIST_CH_PRESSURE_2 (HIST_CH_R_INT + 5)
+#define HIST_NUM_CHANNELS (HIST_CH_R_INT + 6)
+
+/* Least-squares window over channels first_ch .. first_ch+num_ch-1 */
+typedef struct {
+  uint32_t window_ms;
+  uint8_t first_ch;
+  uint8_t num_ch;
+  uint16_t tail;    /* Oldest sample in the window (free-running)  */
+  uint16_t count;   /* Samples in the window                       */
+  uint32_t base_ms; /* Sums are over t - base_ms                   */
+  int64_t st, stt;  /* Σt, Σt²                                     */
+  int64_t sv[HIST_NUM_CHANNELS];  /* Σv per channel                */
+  int64_t stv[HIST_NUM_CHANNELS]; /* Σtv per channel               */
+} history_window_t;
+
+typedef struct {
+  uint32_t t_ms[HISTORY_DEPTH];
+  int32_t v[HISTORY_DEPTH][HIST_NUM_CHANNELS]; /* One row per sample */
+  uint16_t head;                               /* Samples pushed     */
+  uint8_t num_windows;
+  history_window_t win[HISTORY_MAX_WINDOWS];
+} history_t;
+
+/* Empty the ring and drop all windows */
+void history_init(history_t *h);
+
+/* Add a window of window_ms (at most HISTORY_REBASE_MS) over num_ch
+ * channels from first_ch. A window holds at most HISTORY_DEPTH - 1
+ * samples, whatever its length.
+ * Returns its id, or -1 if the table is full or the range is invalid. */
+int history_add_window(history_t *h, uint8_t first_ch, uint8_t num_ch,
+                       uint32_t window_ms);
+
+/* Record one sample of every channel, taken at t_ms (non-decreasing),
+ * and update every window */
+void history_push(history_t *h, uint32_t t_ms,
+                  const int32_t values[HIST_NUM_CHANNELS]);
+
+/* Slope of channel ch over window id, in channel units per second.
+ * Returns 0 until the window spans two distinct timestamps. */
+float history_slope(const history_t *h, int id, uint8_t ch);
+
+/* The same slope without floats: channel units per ms × scale, rounded
+ * to nearest (scale 600 turns milli-°C into deci-°C/min) */
+int32_t history_slope_scaled(const history_t *h, int id, uint8_t ch,
+                             int32_t scale);
+
+/* Samples currently inside window id */
+uint16_t history_window_count(const history_t *h, int id);
+
+#endif /* HISTORY_H */
@@ -2,153 +2,491 @@
  * input_packet.c — Multi-frame Input Packet Parser (Full Pack)
  *
  * Parses incoming UART bytes from the digital twin into pack-level
- * and module-level frames. Accumulates until all 9 frames (1 pack +
- * 8 modules) are received, then signals the main loop to process.
+ * and module-level frames. Accumulates until all frames (1 pack +
+ * one per module) are received, then signals the main loop to process.
+ *
+ * Both framings share one state machine: v1 frames fold into the XOR
+ * checksum, v2 frames and superframes into a CRC-16, and either way
+ * payload bytes land straight in their slot.
+ *
+ * Cost is O(1) per byte on a clean line. On a bad frame the parser
+ * rewinds to the next sync byte inside the ring and replays at most
+ * one frame's worth of bytes — no memmove, no checksum recompute.
  */
 
 #include "input_packet.h"
+#include "crc16.h"
+#include "hal_platform.h"
+#include <stdbool.h>
 #include <string.h>
 
-/* -----------------------------------------------------------------------
- * XOR checksum
- * ----------------------------------------------------------------------- */
-static uint8_t compute_checksum(const uint8_t *data, uint8_t len) {
-  uint8_t csum = 0;
-  for (uint8_t i = 0; i < len; i++) {
-    csum ^= data[i];
-  }
-  return csum;
+_Static_assert(sizeof(input_pack_frame_t) == INPUT_PACK_FRAME_SIZE,
+               "pack frame layout must match INPUT_PACK_FRAME_SIZE");
+_Static_assert(sizeof(input_module_frame_t) == INPUT_MODULE_FRAME_SIZE,
+               "module frame layout must match INPUT_MODULE_FRAME_SIZE");
+_Static_assert(sizeof(input_tel_config_frame_t) == INPUT_TEL_CONFIG_FRAME_SIZE,
+               "config frame layout must match INPUT_TEL_CONFIG_FRAME_SIZE");
+_Static_assert(sizeof(input_blackbox_frame_t) == INPUT_BLACKBOX_FRAME_SIZE,
+               "black-box frame layout must match INPUT_BLACKBOX_FRAME_SIZE");
+_Static_assert(sizeof(input_threshold_frame_t) == INPUT_THRESHOLD_FRAME_SIZE,
+               "threshold frame layout must match INPUT_THRESHOLD_FRAME_SIZE");
+_Static_assert((INPUT_RX_BUF_SIZE & (INPUT_RX_BUF_SIZE - 1)) == 0 &&
+                   INPUT_RX_BUF_SIZE > INPUT_V2_MAX_FRAME_SIZE,
+               "RX ring must be a power of two larger than one frame");
+
+#define RX_MASK (INPUT_RX_BUF_SIZE - 1u)
+
+/* Expected v1 frame length per frame type (0 = unknown type) */
+static const uint8_t FRAME_LEN_BY_TYPE[] = {
+    [INPUT_TYPE_PACK] = INPUT_PACK_FRAME_SIZE,
+    [INPUT_TYPE_MODULE] = INPUT_MODULE_FRAME_SIZE,
+    [INPUT_TYPE_TEL_CONFIG] = INPUT_TEL_CONFIG_FRAME_SIZE,
+    [INPUT_TYPE_BLACKBOX] = INPUT_BLACKBOX_FRAME_SIZE,
+    [INPUT_TYPE_THRESHOLD] = INPUT_THRESHOLD_FRAME_SIZE,
+};
+#define NUM_FRAME_TYPES (sizeof(FRAME_LEN_BY_TYPE) / sizeof(FRAME_LEN_BY_TYPE[0]))
+
+/* Payload length of a known type (the v1 frame minus header and XOR) */
+static uint8_t payload_len(uint8_t type) {
+  if (type >= NUM_FRAME_TYPES || FRAME_LEN_BY_TYPE[type] == 0)
+    return 0;
+  return (uint8_t)(FRAME_LEN_BY_TYPE[type] - 4u);
 }
 
+/* Result of feeding one byte through the state machine */
+typedef enum {
+  STEP_MORE = 0, /* Byte accepted, frame still in progress   */
+  STEP_SKIP,     /* Not a sync byte while hunting — drop it  */
+  STEP_FAIL,     /* Frame rejected — resync                  */
+  STEP_FRAME,    /* Frame complete and valid                 */
+} rx_step_t;
+
 /* -----------------------------------------------------------------------
  * Initialize
  * ----------------------------------------------------------------------- */
 void input_rx_init(input_rx_state_t *rx) {
   memset(rx, 0, sizeof(input_rx_state_t));
+  rx->phase = INPUT_RX_HUNT;
 }
 
 /* -----------------------------------------------------------------------
- * Try to parse a frame from the buffer
- * Returns: 0 = no frame yet, 1 = frame parsed, 2 = full snapshot ready
+ * Bind a record to its destination slot.
+ * Header bytes are already known, so they're written from state
+ * rather than copied out of the ring.
  * ----------------------------------------------------------------------- */
-static int try_parse_frame(input_rx_state_t *rx) {
-  /* Need at least 3 bytes for sync + len + type */
-  if (rx->write_pos < 3)
-    return 0;
+static void bind_dest(input_rx_state_t *rx, uint8_t type, uint8_t *dest) {
+  rx->dest = dest;
+  dest[0] = INPUT_SYNC_BYTE;
+  dest[1] = FRAME_LEN_BY_TYPE[type];
+  dest[2] = type;
+}
 
-  /* Scan for sync byte */
-  uint8_t start = 0;
-  while (start < rx->write_pos && rx->buf[start] != INPUT_SYNC_BYTE) {
-    start++;
+/* Start decoding a record of a known type. Pack and command slots are
+ * bound now; a module slot waits for its index byte. */
+static void begin_record(input_rx_state_t *rx, uint8_t type) {
+  rx->rec_type = type;
+  rx->pos = 3;
+  rx->dest = NULL;
+  if (type == INPUT_TYPE_PACK) {
+    rx->pack_received = 0; /* Slot is being overwritten */
+    rx->got |= INPUT_GOT_PACK;
+    bind_dest(rx, type, (uint8_t *)&rx->last_pack);
+  } else if (type == INPUT_TYPE_TEL_CONFIG) {
+    rx->got |= INPUT_GOT_CONFIG;
+    bind_dest(rx, type, (uint8_t *)&rx->last_tel_config);
+  } else if (type == INPUT_TYPE_BLACKBOX) {
+    rx->got |= INPUT_GOT_BLACKBOX;
+    bind_dest(rx, type, (uint8_t *)&rx->last_blackbox);
+  } else if (type == INPUT_TYPE_THRESHOLD) {
+    rx->got |= INPUT_GOT_THRESHOLD;
+    bind_dest(rx, type, (uint8_t *)&rx->last_threshold);
   }
+}
 
-  /* Discard bytes before sync */
-  if (start > 0) {
-    uint8_t remaining = rx->write_pos - start;
-    if (remaining > 0) {
-      memmove(rx->buf, rx->buf + start, remaining);
-    }
-    rx->write_pos = remaining;
+/* Store one payload byte; the first byte of a module record selects
+ * its slot. Returns false on a bad module index. */
+HAL_FAST_CODE
+static bool store_byte(input_rx_state_t *rx, uint8_t byte) {
+  if (rx->dest == NULL) {
+    if (byte >= PACK_NUM_MODULES)
+      return false;
+    rx->modules_received &= (module_mask_t)~MODULE_BIT(byte);
+    rx->got |= INPUT_GOT_MODULE;
+    rx->got_modules |= MODULE_BIT(byte);
+    bind_dest(rx, INPUT_TYPE_MODULE, (uint8_t *)&rx->last_modules[byte]);
   }
+  rx->dest[rx->pos++] = byte;
+  return true;
+}
 
-  if (rx->write_pos < 3)
-    return 0;
+/* Fill in the v1 XOR byte of a record decoded from a v2 frame, so the
+ * slots look the same whichever framing delivered them */
+static void seal_record(input_rx_state_t *rx) {
+  uint8_t n = FRAME_LEN_BY_TYPE[rx->rec_type];
+  uint8_t csum = 0;
+  for (uint8_t i = 0; i + 1u < n; i++)
+    csum ^= rx->dest[i];
+  rx->dest[n - 1u] = csum;
+}
 
-  uint8_t frame_len = rx->buf[1];
-  uint8_t frame_type = rx->buf[2];
+/* -----------------------------------------------------------------------
+ * Advance the state machine by one byte
+ * ----------------------------------------------------------------------- */
+HAL_FAST_CODE
+static rx_step_t rx_step_v1(input_rx_state_t *rx, uint8_t byte) {
+  switch (rx->phase) {
+  case INPUT_RX_LENGTH:
+    rx->frame_len = byte;
+    rx->csum ^= byte;
+    rx->phase = INPUT_RX_TYPE;
+    return STEP_MORE;
 
-  /* Validate frame length */
-  if (frame_type == INPUT_TYPE_PACK && frame_len != INPUT_PACK_FRAME_SIZE) {
-    /* Bad length — skip this sync byte */
-    memmove(rx->buf, rx->buf + 1, rx->write_pos - 1);
-    rx->write_pos--;
-    return 0;
-  }
-  if (frame_type == INPUT_TYPE_MODULE && frame_len != INPUT_MODULE_FRAME_SIZE) {
-    memmove(rx->buf, rx->buf + 1, rx->write_pos - 1);
-    rx->write_pos--;
-    return 0;
-  }
-  if (frame_type != INPUT_TYPE_PACK && frame_type != INPUT_TYPE_MODULE) {
-    /* Unknown frame type — skip */
-    memmove(rx->buf, rx->buf + 1, rx->write_pos - 1);
-    rx->write_pos--;
-    return 0;
+  case INPUT_RX_TYPE:
+    if (payload_len(byte) == 0 || FRAME_LEN_BY_TYPE[byte] != rx->frame_len)
+      return STEP_FAIL;
+    if (byte == INPUT_TYPE_THRESHOLD)
+      return STEP_FAIL; /* Threshold edits need the CRC: v2 framing only */
+    rx->frame_type = byte;
+    rx->csum ^= byte;
+    begin_record(rx, byte);
+    rx->phase = INPUT_RX_BODY;
+    return STEP_MORE;
+
+  case INPUT_RX_BODY:
+  default:
+    if (rx->pos == rx->frame_len - 1u) {
+      /* Checksum byte */
+      if (byte != rx->csum || rx->dest == NULL)
+        return STEP_FAIL;
+      rx->dest[rx->pos] = byte;
+      return STEP_FRAME;
+    }
+    if (!store_byte(rx, byte))
+      return STEP_FAIL;
+    rx->csum ^= byte;
+    return STEP_MORE;
   }
+}
 
-  /* Wait until we have the complete frame */
-  if (rx->write_pos < frame_len)
-    return 0;
+HAL_FAST_CODE
+static rx_step_t rx_step_v2(input_rx_state_t *rx, uint8_t byte) {
+  if (rx->phase != INPUT_RX_V2_CRC_LO && rx->phase != INPUT_RX_V2_CRC_HI)
+    rx->crc = crc16_update(rx->crc, byte);
 
-  /* Validate checksum */
-  uint8_t expected = compute_checksum(rx->buf, frame_len - 1);
-  if (rx->buf[frame_len - 1] != expected) {
-    /* Checksum mismatch — skip sync */
-    memmove(rx->buf, rx->buf + 1, rx->write_pos - 1);
-    rx->write_pos--;
-    return 0;
-  }
+  switch (rx->phase) {
+  case INPUT_RX_V2_LEN_LO:
+    rx->frame_len = byte;
+    rx->phase = INPUT_RX_V2_LEN_HI;
+    return STEP_MORE;
 
-  /* Valid frame! Copy to appropriate storage */
-  int result = 1;
+  case INPUT_RX_V2_LEN_HI:
+    rx->frame_len |= (uint16_t)byte << 8;
+    if (rx->frame_len <= INPUT_V2_OVERHEAD ||
+        rx->frame_len > INPUT_V2_MAX_FRAME_SIZE)
+      return STEP_FAIL;
+    rx->remaining = (uint16_t)(rx->frame_len - INPUT_V2_OVERHEAD);
+    rx->phase = INPUT_RX_V2_TYPE;
+    return STEP_MORE;
 
-  if (frame_type == INPUT_TYPE_PACK) {
-    memcpy(&rx->last_pack, rx->buf, sizeof(input_pack_frame_t));
-    rx->pack_received = 1;
-  } else {
-    /* Module frame — extract module index */
-    input_module_frame_t mf;
-    memcpy(&mf, rx->buf, sizeof(input_module_frame_t));
-
-    if (mf.module_index < 8) {
-      memcpy(&rx->last_modules[mf.module_index], &mf,
-             sizeof(input_module_frame_t));
-      rx->modules_received |= (1 << mf.module_index);
+  case INPUT_RX_V2_TYPE:
+    if (byte != INPUT_TYPE_SUPER && payload_len(byte) != rx->remaining)
+      return STEP_FAIL;
+    rx->frame_type = byte;
+    rx->phase = INPUT_RX_V2_SEQ;
+    return STEP_MORE;
+
+  case INPUT_RX_V2_SEQ:
+    rx->seq = byte;
+    if (rx->frame_type == INPUT_TYPE_SUPER) {
+      rx->phase = INPUT_RX_V2_REC_TYPE;
+    } else {
+      begin_record(rx, rx->frame_type);
+      rx->rec_left = payload_len(rx->frame_type);
+      rx->phase = INPUT_RX_V2_BODY;
     }
+    return STEP_MORE;
+
+  case INPUT_RX_V2_REC_TYPE:
+    if (payload_len(byte) == 0 || rx->remaining < 2u)
+      return STEP_FAIL;
+    rx->rec_type = byte;
+    rx->remaining--;
+    rx->phase = INPUT_RX_V2_REC_LEN;
+    return STEP_MORE;
+
+  case INPUT_RX_V2_REC_LEN:
+    if (byte != payload_len(rx->rec_type) || byte >= rx->remaining)
+      return STEP_FAIL;
+    rx->remaining--;
+    begin_record(rx, rx->rec_type);
+    rx->rec_left = byte;
+    rx->phase = INPUT_RX_V2_BODY;
+    return STEP_MORE;
+
+  case INPUT_RX_V2_BODY:
+    if (!store_byte(rx, byte))
+      return STEP_FAIL;
+    rx->remaining--;
+    if (--rx->rec_left == 0) {
+      seal_record(rx);
+      if (rx->remaining == 0)
+        rx->phase = INPUT_RX_V2_CRC_LO;
+      else if (rx->frame_type == INPUT_TYPE_SUPER)
+        rx->phase = INPUT_RX_V2_REC_TYPE;
+      else
+        return STEP_FAIL;
+    }
+    return STEP_MORE;
+
+  case INPUT_RX_V2_CRC_LO:
+    if (byte != (uint8_t)rx->crc)
+      return STEP_FAIL;
+    rx->phase = INPUT_RX_V2_CRC_HI;
+    return STEP_MORE;
+
+  case INPUT_RX_V2_CRC_HI:
+  default:
+    return byte == (uint8_t)(rx->crc >> 8) ? STEP_FRAME : STEP_FAIL;
   }
+}
 
-  /* Consume the frame from buffer */
-  uint8_t remaining = rx->write_pos - frame_len;
-  if (remaining > 0) {
-    memmove(rx->buf, rx->buf + frame_len, remaining);
+HAL_FAST_CODE
+static rx_step_t rx_step(input_rx_state_t *rx, uint8_t byte) {
+  if (rx->phase == INPUT_RX_HUNT) {
+    rx->got = 0;
+    rx->got_modules = 0;
+    if (byte == INPUT_SYNC_BYTE) {
+      rx->csum = byte;
+      rx->phase = INPUT_RX_LENGTH;
+      return STEP_MORE;
+    }
+    if (byte == INPUT_SYNC_V2) {
+      rx->crc = crc16_update(CRC16_INIT, byte);
+      rx->phase = INPUT_RX_V2_LEN_LO;
+      return STEP_MORE;
+    }
+    return STEP_SKIP;
   }
-  rx->write_pos = remaining;
+  return rx->phase >= INPUT_RX_V2_LEN_LO ? rx_step_v2(rx, byte)
+                                         : rx_step_v1(rx, byte);
+}
 
-  /* Check if full snapshot is ready */
-  if (rx->pack_received && rx->modules_received == 0xFF) {
-    result = 2;
+/* Drop the frame in flight and rewind to the next sync byte after it */
+static void rx_resync(input_rx_state_t *rx) {
+  uint16_t t = (uint16_t)(rx->tail + 1u);
+  while (t != rx->head && rx->buf[t & RX_MASK] != INPUT_SYNC_BYTE &&
+         rx->buf[t & RX_MASK] != INPUT_SYNC_V2) {
+    t++;
   }
+  rx->tail = t;
+  rx->scan = t;
+  rx->phase = INPUT_RX_HUNT;
+  rx->dest = NULL;
+}
 
-  return result;
+/* Mark the completed frame's slots as valid for this cycle */
+static void rx_commit(input_rx_state_t *rx) {
+  bool v2 = rx->phase == INPUT_RX_V2_CRC_HI;
+  bool data = (rx->got & (INPUT_GOT_PACK | INPUT_GOT_MODULE)) != 0;
+
+  /* The partial-snapshot wait runs from the first frame after a consume,
+   * across SEQ changes, so a cycle that never completes still ends */
+  if (data && !rx->pack_received && !rx->modules_received)
+    rx->cycle_start_ms = rx->now_ms;
+
+  /* A v2 frame from a new twin cycle drops what the old one left */
+  if (v2 && data && (!rx->have_cycle_seq || rx->seq != rx->cycle_seq)) {
+    if (rx->pack_received || rx->modules_received)
+      rx->cycles_abandoned++;
+    rx->pack_received = 0;
+    rx->modules_received = 0;
+    rx->cycle_seq = rx->seq;
+    rx->have_cycle_seq = 1;
+  }
+
+  if (rx->got & INPUT_GOT_PACK)
+    rx->pack_received = 1;
+  rx->modules_received |= rx->got_modules;
+  for (uint8_t m = 0; m < PACK_NUM_MODULES; m++) {
+    if (rx->got_modules & MODULE_BIT(m))
+      rx->module_rx_ms[m] = rx->now_ms;
+  }
+  rx->frame_contents = rx->got;
+  rx->frames_ok++;
+  rx->phase = INPUT_RX_HUNT;
+  rx->dest = NULL;
 }
 
 /* -----------------------------------------------------------------------
  * Feed one byte from UART RX
  * ----------------------------------------------------------------------- */
+HAL_FAST_CODE
 int input_rx_feed(input_rx_state_t *rx, uint8_t byte) {
-  if (rx->write_pos < INPUT_RX_BUF_SIZE) {
-    rx->buf[rx->write_pos++] = byte;
-  } else {
-    /* Buffer overflow — reset */
-    rx->write_pos = 0;
-    rx->buf[rx->write_pos++] = byte;
-    return 0;
+  int result = 0;
+
+  rx->buf[rx->head & RX_MASK] = byte;
+  rx->head++;
+
+  while (rx->scan != rx->head) {
+    rx_step_t step = rx_step(rx, rx->buf[rx->scan & RX_MASK]);
+    rx->scan++;
+
+    switch (step) {
+    case STEP_SKIP:
+      rx->tail = rx->scan;
+      break;
+    case STEP_FAIL:
+      rx->frames_bad++;
+      rx_resync(rx);
+      break;
+    case STEP_FRAME:
+      rx_commit(rx);
+      rx->tail = rx->scan;
+      result = input_rx_has_full_snapshot(rx) ? 2 : 1;
+      break;
+    case STEP_MORE:
+    default:
+      break;
+    }
   }
 
-  return try_parse_frame(rx);
+  return result;
 }
 
 /* -----------------------------------------------------------------------
  * Check if a complete snapshot is available
  * ----------------------------------------------------------------------- */
 int input_rx_has_full_snapshot(const input_rx_state_t *rx) {
-  return (rx->pack_received && rx->modules_received == 0xFF) ? 1 : 0;
+  return (rx->pack_received && rx->modules_received == MODULE_MASK_ALL) ? 1 : 0;
 }
 
 /* -----------------------------------------------------------------------
  * Reset cycle tracking (call after consuming the snapshot)
  * ----------------------------------------------------------------------- */
 void input_rx_reset_cycle(input_rx_state_t *rx) {
+  for (uint8_t m = 0; m < PACK_NUM_MODULES; m++) {
+    if (rx->modules_received & MODULE_BIT(m))
+      rx->module_good_ms[m] = rx->module_rx_ms[m];
+  }
+  rx->modules_valid |= rx->modules_received;
   rx->pack_received = 0;
   rx->modules_received = 0;
 }
+
+void input_rx_set_clock(input_rx_state_t *rx, uint32_t now_ms) {
+  rx->now_ms = now_ms;
+}
+
+/* -----------------------------------------------------------------------
+ * Partial snapshot policy
+ * ----------------------------------------------------------------------- */
+/* Every module in `missing` was consumed before, at most max_age_ms ago */
+static int reusable(const input_rx_state_t *rx, module_mask_t missing,
+                    uint32_t now_ms, uint32_t max_age_ms) {
+  if (missing & (module_mask_t)~rx->modules_valid)
+    return 0;
+  for (uint8_t m = 0; m < PACK_NUM_MODULES; m++) {
+    if ((missing & MODULE_BIT(m)) &&
+        now_ms - rx->module_good_ms[m] > max_age_ms)
+      return 0;
+  }
+  return 1;
+}
+
+int input_rx_partial_ready(const input_rx_state_t *rx, uint32_t now_ms,
+                           uint32_t wait_ms, uint32_t max_age_ms,
+                           module_mask_t *stale) {
+  if (!rx->pack_received || input_rx_has_full_snapshot(rx) ||
+      now_ms - rx->cycle_start_ms < wait_ms)
+    return 0;
+
+  module_mask_t missing = (module_mask_t)(MODULE_MASK_ALL &
+                                          ~rx->modules_received);
+  if (!reusable(rx, missing, now_ms, max_age_ms))
+    return 0;
+
+  *stale = missing;
+  return 1;
+}
+
+int input_rx_subset_ready(const input_rx_state_t *rx, module_mask_t required,
+                          uint32_t now_ms, uint32_t max_age_ms,
+                          module_mask_t *held) {
+  if (!rx->pack_received || input_rx_has_full_snapshot(rx) ||
+      (rx->modules_received & required) != required)
+    return 0;
+
+  module_mask_t missing = (module_mask_t)(MODULE_MASK_ALL &
+                                          ~rx->modules_received);
+  if (!reusable(rx, missing, now_ms, max_age_ms))
+    return 0;
+
+  *held = missing;
+  return 1;
+}
+
+/* -----------------------------------------------------------------------
+ * Wire units to snapshot
+ * ----------------------------------------------------------------------- */
+
+void input_decode_pack(sensor_snapshot_t *snap,
+                       const input_pack_frame_t *frame) {
+  snap->pack_voltage_v = frame->pack_voltage_dv / 10.0f;
+  snap->pack_current_a = frame->pack_current_da / 10.0f;
+  snap->temp_ambient_c = frame->ambient_temp_dt / 10.0f;
+  snap->coolant_inlet_c = frame->coolant_inlet_dt / 10.0f;
+  snap->coolant_outlet_c = frame->coolant_outlet_dt / 10.0f;
+  snap->gas_ratio_1 = frame->gas_ratio_1_cp / 100.0f;
+  snap->gas_ratio_2 = frame->gas_ratio_2_cp / 100.0f;
+  snap->pressure_delta_1_hpa = frame->pressure_delta_1_chpa / 100.0f;
+  snap->pressure_delta_2_hpa = frame->pressure_delta_2_chpa / 100.0f;
+  snap->humidity_pct = (float)frame->humidity_pct;
+  snap->isolation_mohm = frame->isolation_mohm / 10.0f;
+
+  /* Not on the wire: R_int comes from med_loop, the short flag from
+   * the fast loop */
+  snap->r_internal_mohm = 0.44f;
+  snap->short_circuit = false;
+}
+
+void input_decode_module(sensor_snapshot_t *snap, uint8_t module_index,
+                         const input_module_frame_t *frame) {
+  module_data_t *md = &snap->modules[module_index];
+  md->ntc1_c = frame->ntc1_dt / 10.0f;
+  md->ntc2_c = frame->ntc2_dt / 10.0f;
+  md->swelling_pct = (float)frame->swelling_pct;
+
+  /* Group voltages from base + delta */
+  float base_v = frame->v_base_mv / 1000.0f;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    md->group_voltages_v[g] = base_v + frame->v_delta[g] / 1000.0f;
+}
+
+void input_decode_pack_fx(sensor_snapshot_fx_t *snap,
+                          const input_pack_frame_t *frame) {
+  snap->pack_voltage_dv = frame->pack_voltage_dv;
+  snap->pack_current_da = frame->pack_current_da;
+  snap->temp_ambient_dt = frame->ambient_temp_dt;
+  snap->coolant_inlet_dt = frame->coolant_inlet_dt;
+  snap->coolant_outlet_dt = frame->coolant_outlet_dt;
+  snap->gas_ratio_1_cp = frame->gas_ratio_1_cp;
+  snap->gas_ratio_2_cp = frame->gas_ratio_2_cp;
+  snap->pressure_delta_1_chpa = frame->pressure_delta_1_chpa;
+  snap->pressure_delta_2_chpa = frame->pressure_delta_2_chpa;
+  snap->humidity_pct = frame->humidity_pct;
+  snap->isolation_dmohm = frame->isolation_mohm;
+
+  snap->r_internal_uohm = 440; /* 0.44 mΩ, as the float decode */
+  snap->short_circuit = false;
+}
+
+void input_decode_module_fx(sensor_snapshot_fx_t *snap, uint8_t module_index,
+                            const input_module_frame_t *frame) {
+  module_data_fx_t *md = &snap->modules[module_index];
+  md->ntc1_dt = frame->ntc1_dt;
+  md->ntc2_dt = frame->ntc2_dt;
+  md->swelling_pct = frame->swelling_pct;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    VPLANE_MV(&snap->vplane, module_index, g) =
+        (int16_t)(frame->v_base_mv + frame->v_delta[g]);
+}
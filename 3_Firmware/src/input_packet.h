@@ -8,6 +8,10 @@
  *
  * Each frame: [0xBB][LEN][TYPE][payload][XOR_checksum]
  *
+ * v2 framing (sync 0xBC) carries the same payloads behind a CRC-16 and
+ * a cycle sequence number, optionally batched into one superframe.
+ * Both framings are accepted on the same link.
+ *
  * The firmware collects all 9 frames (1 pack + 8 modules) to build
  * a complete sensor_snapshot_t before running the anomaly evaluator.
  */
@@ -15,17 +19,29 @@
 #ifndef INPUT_PACKET_H
 #define INPUT_PACKET_H
 
+#include "anomaly_eval_fx.h"
+#include "pack_config.h"
 #include <stdint.h>
 
 /* Protocol constants */
 #define INPUT_SYNC_BYTE 0xBB
 #define INPUT_TYPE_PACK 0x01
 #define INPUT_TYPE_MODULE 0x02
+#define INPUT_TYPE_TEL_CONFIG 0x03
+#define INPUT_TYPE_BLACKBOX 0x04
+#define INPUT_TYPE_THRESHOLD 0x05
+#define INPUT_TYPE_SUPER 0x10 /* v2 only: batch of records */
 
-/* Frame sizes */
-#define INPUT_PACK_FRAME_SIZE 30   /* sync + len + type + 26 payload + csum */
-#define INPUT_MODULE_FRAME_SIZE 24 /* sync + len + type + 20 payload + csum */
-#define INPUT_MAX_FRAME_SIZE 30
+/* Frame sizes (must equal sizeof the packed structs below) */
+#define INPUT_PACK_FRAME_SIZE 25 /* sync + len + type + 21 payload + csum */
+#define INPUT_MODULE_FRAME_SIZE                                                \
+  (12 + PACK_GROUPS_PER_MODULE) /* 25 for 13 groups per module */
+#define INPUT_TEL_CONFIG_FRAME_SIZE 8
+#define INPUT_BLACKBOX_FRAME_SIZE 6
+#define INPUT_THRESHOLD_FRAME_SIZE 10
+#define INPUT_MAX_FRAME_SIZE                                                   \
+  (INPUT_MODULE_FRAME_SIZE > INPUT_PACK_FRAME_SIZE ? INPUT_MODULE_FRAME_SIZE  \
+                                                   : INPUT_PACK_FRAME_SIZE)
 
 /* -----------------------------------------------------------------------
  * Pack-level frame (Type 0x01) — one per cycle
@@ -34,7 +50,7 @@
  * ----------------------------------------------------------------------- */
 typedef struct __attribute__((packed)) {
   uint8_t sync;       /* 0xBB                                    */
-  uint8_t length;     /* Frame size (30)                         */
+  uint8_t length;     /* Frame size (25)                         */
   uint8_t frame_type; /* 0x01 = pack frame                       */
 
   /* Electrical */
@@ -63,17 +79,17 @@ typedef struct __attribute__((packed)) {
 } input_pack_frame_t;
 
 /* -----------------------------------------------------------------------
- * Module-level frame (Type 0x02) — sent 8 times per cycle
+ * Module-level frame (Type 0x02) — sent once per module per cycle
  *
  * Contains per-module sensor data including 13 group voltages
  * encoded efficiently as base + 13 delta bytes.
  * ----------------------------------------------------------------------- */
 typedef struct __attribute__((packed)) {
   uint8_t sync;       /* 0xBB                                    */
-  uint8_t length;     /* Frame size (24)                         */
+  uint8_t length;     /* Frame size (25)                         */
   uint8_t frame_type; /* 0x02 = module frame                     */
 
-  uint8_t module_index; /* Module number (0-7)                     */
+  uint8_t module_index; /* Module number (0..PACK_NUM_MODULES-1)   */
 
   /* NTC temperatures */
   int16_t ntc1_dt; /* NTC1 temp in deci-°C                    */
@@ -86,43 +102,279 @@ typedef struct __attribute__((packed)) {
    * V_group[g] = base_mv + delta[g] (mV)
    * base_mv = mean of all 13 group voltages in mV                       */
   uint16_t v_base_mv; /* Base voltage in mV (e.g., 3280)        */
-  int8_t v_delta[13]; /* Per-group delta from base in mV        */
+  int8_t v_delta[PACK_GROUPS_PER_MODULE]; /* Per-group delta from base, mV */
 
   /* Checksum */
   uint8_t checksum; /* XOR of all preceding bytes             */
 } input_module_frame_t;
 
+/* -----------------------------------------------------------------------
+ * Telemetry config frame (Type 0x03) — sent by the dashboard, any time
+ *
+ * Negotiates the output format: the firmware acknowledges with a
+ * [TEL] line and starts the new mode with a keyframe.
+ * ----------------------------------------------------------------------- */
+
+#define INPUT_TEL_MODE_LEGACY 0  /* Pack + module frames every cycle      */
+#define INPUT_TEL_MODE_COMPACT 1 /* Keyframe/delta frames (Type 0x04)     */
+
+#define INPUT_TEL_FLAG_ASCII 0x01 /* Keep the human-readable [TEL] line   */
+#define INPUT_TEL_FLAG_KEY 0x02   /* Send a keyframe next cycle           */
+#define INPUT_TEL_FLAG_V2 0x04    /* Batch output into CRC-16 superframes */
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xBB                                    */
+  uint8_t length;     /* Frame size (8)                          */
+  uint8_t frame_type; /* 0x03 = telemetry config                 */
+
+  uint8_t mode;         /* INPUT_TEL_MODE_*                        */
+  uint8_t flags;        /* INPUT_TEL_FLAG_*                        */
+  uint8_t key_interval; /* Compact cycles per keyframe (0=default) */
+  uint8_t period_100ms; /* Telemetry period cap ×100 ms (0=none)   */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes             */
+} input_tel_config_frame_t;
+
+/* -----------------------------------------------------------------------
+ * Black-box command frame (Type 0x04) — sent by the dashboard, any time
+ *
+ * STATUS answers with a [BBX] line; DUMP streams the flash log back as
+ * PACKET_TYPE_BLACKBOX frames (blackbox.h).
+ * ----------------------------------------------------------------------- */
+
+#define INPUT_BLACKBOX_OP_STATUS 0
+#define INPUT_BLACKBOX_OP_DUMP 1 /* arg: newest events to send, 0 = all */
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xBB                                    */
+  uint8_t length;     /* Frame size (6)                          */
+  uint8_t frame_type; /* 0x04 = black-box command                */
+
+  uint8_t op;  /* INPUT_BLACKBOX_OP_*                     */
+  uint8_t arg; /* Op argument                             */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes             */
+} input_blackbox_frame_t;
+
+/* -----------------------------------------------------------------------
+ * Threshold frame (Type 0x05) — sent by the dashboard, any time
+ *
+ * Edits a staged copy of the thresholds one value at a time; APPLY
+ * checks the whole set and, if it passes, makes it live without a
+ * reboot. SET refuses a value outside the field's plausible range, and
+ * APPLY is refused unless the pack is NORMAL. Accepted in v2 framing
+ * only; a v1 threshold frame is dropped as corrupt. Every frame is
+ * answered with a [THR] line.
+ * ----------------------------------------------------------------------- */
+
+#define INPUT_THRESHOLD_OP_SET 0      /* Stage param = value              */
+#define INPUT_THRESHOLD_OP_APPLY 1    /* Check and apply the staged set   */
+#define INPUT_THRESHOLD_OP_DEFAULTS 2 /* Stage the built-in defaults      */
+#define INPUT_THRESHOLD_OP_REVERT 3   /* Drop staged edits (live set)     */
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xBB                                    */
+  uint8_t length;     /* Frame size (10)                         */
+  uint8_t frame_type; /* 0x05 = threshold                        */
+
+  uint8_t op;          /* INPUT_THRESHOLD_OP_*                    */
+  uint8_t param;       /* Field position in anomaly_thresholds_t  */
+  int32_t value_milli; /* New value × 1000 (SET only)             */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes             */
+} input_threshold_frame_t;
+
+/* -----------------------------------------------------------------------
+ * v2 framing
+ *
+ *   [0xBC][LEN_LO][LEN_HI][TYPE][SEQ][payload][CRC_LO][CRC_HI]
+ *
+ * LEN is the whole frame, CRC is CRC-16/CCITT-FALSE over everything
+ * before it. For types 0x01-0x03 the payload is the v1 frame's payload
+ * (everything between TYPE and the XOR byte). A superframe (0x10)
+ * carries a run of [TYPE][PLEN][payload] records instead, so a whole
+ * twin cycle is one sync scan and one CRC.
+ *
+ * SEQ numbers twin cycles: every frame of a cycle carries the same SEQ,
+ * and a pack or module frame with a different SEQ starts a new cycle,
+ * so a snapshot never mixes frames of two cycles. The pre-emptive
+ * current trip fires when the frame carrying the pack validates, so a
+ * twin that wants it earliest sends the pack as its own v2 frame ahead
+ * of a module superframe.
+ * ----------------------------------------------------------------------- */
+
+#define INPUT_SYNC_V2 0xBC
+#define INPUT_V2_OVERHEAD 7 /* sync + len16 + type + seq + crc16 */
+#define INPUT_V2_RECORD(frame_size) (2 + (frame_size)-4) /* type+plen+payload */
+#define INPUT_V2_MAX_FRAME_SIZE                                                \
+  (INPUT_V2_OVERHEAD + INPUT_V2_RECORD(INPUT_PACK_FRAME_SIZE) +               \
+   PACK_NUM_MODULES * INPUT_V2_RECORD(INPUT_MODULE_FRAME_SIZE) +              \
+   INPUT_V2_RECORD(INPUT_TEL_CONFIG_FRAME_SIZE) +                             \
+   INPUT_V2_RECORD(INPUT_BLACKBOX_FRAME_SIZE) +                             \
+   INPUT_V2_RECORD(INPUT_THRESHOLD_FRAME_SIZE))
+
+/* What a completed frame carried (input_rx_state_t.frame_contents) */
+#define INPUT_GOT_PACK 0x01
+#define INPUT_GOT_MODULE 0x02
+#define INPUT_GOT_CONFIG 0x04
+#define INPUT_GOT_BLACKBOX 0x08
+#define INPUT_GOT_THRESHOLD 0x10
+
+/* -----------------------------------------------------------------------
+ * Partial snapshot policy
+ *
+ * A cycle that is still missing modules INPUT_PARTIAL_WAIT_MS after its
+ * first frame may be evaluated anyway, reusing the last consumed data of
+ * each missing module if it is no older than INPUT_STALE_MAX_AGE_MS.
+ * The pack frame is never reused: it carries the current the trip and
+ * the evaluator act on. Both stay below EXTERNAL_INPUT_TIMEOUT_MS so a
+ * lossy link degrades to stale modules rather than to the sim.
+ * ----------------------------------------------------------------------- */
+
+#define INPUT_PARTIAL_WAIT_MS 250
+#define INPUT_STALE_MAX_AGE_MS 1500
+
 /* -----------------------------------------------------------------------
  * Receiver state machine
+ *
+ * Streaming parser: each byte advances the state machine once, folds
+ * into a running XOR checksum and is stored straight into its final
+ * slot (last_pack or last_modules[idx]) — no staging copy. The raw
+ * bytes of the frame in flight are also kept in a small ring indexed
+ * by head/tail so that, when a frame fails, hunting resumes at the next
+ * sync byte inside it without moving any memory.
+ *
+ * A slot's received bit is cleared as soon as a frame for it starts and
+ * only set again once its checksum validates, so a frame that fails
+ * mid-way never counts towards a full snapshot.
  * ----------------------------------------------------------------------- */
 
-#define INPUT_RX_BUF_SIZE 64
+/* Power of two holding the largest v2 frame (256 for 8 modules) */
+#define INPUT_RX_BUF_SIZE                                                      \
+  (INPUT_V2_MAX_FRAME_SIZE < 256    ? 256                                      \
+   : INPUT_V2_MAX_FRAME_SIZE < 512  ? 512                                      \
+   : INPUT_V2_MAX_FRAME_SIZE < 1024 ? 1024                                     \
+                                    : 2048)
+
+typedef enum {
+  INPUT_RX_HUNT = 0,    /* Waiting for sync byte                   */
+  INPUT_RX_LENGTH,      /* v1: expecting length byte               */
+  INPUT_RX_TYPE,        /* v1: expecting frame type                */
+  INPUT_RX_BODY,        /* v1: payload bytes, then checksum        */
+  INPUT_RX_V2_LEN_LO,   /* v2 header                               */
+  INPUT_RX_V2_LEN_HI,
+  INPUT_RX_V2_TYPE,
+  INPUT_RX_V2_SEQ,
+  INPUT_RX_V2_REC_TYPE, /* Superframe record header                */
+  INPUT_RX_V2_REC_LEN,
+  INPUT_RX_V2_BODY,     /* Record payload                          */
+  INPUT_RX_V2_CRC_LO,
+  INPUT_RX_V2_CRC_HI,
+} input_rx_phase_t;
 
 typedef struct {
+  /* Raw byte ring for resynchronisation */
   uint8_t buf[INPUT_RX_BUF_SIZE];
-  uint8_t write_pos;
+  uint16_t head; /* Next write position (free-running)     */
+  uint16_t tail; /* Start of the frame in flight           */
+  uint16_t scan; /* Next byte to run through the parser    */
+
+  /* Parser state for the frame in flight */
+  uint8_t phase;      /* input_rx_phase_t                        */
+  uint8_t frame_type; /* INPUT_TYPE_* in flight / last completed */
+  uint16_t frame_len; /* Expected total length                   */
+  uint8_t pos;        /* v1: bytes consumed; v2: offset in slot  */
+  uint8_t csum;       /* Running XOR of bytes consumed so far    */
+  uint8_t *dest;      /* Slot being decoded into (NULL = none)   */
+  uint16_t crc;       /* v2: running CRC-16                      */
+  uint16_t remaining; /* v2: payload bytes left before the CRC   */
+  uint8_t rec_type;   /* v2: record in flight                    */
+  uint8_t rec_left;   /* v2: bytes left in the record            */
+  uint8_t seq;        /* v2: SEQ of the frame in flight          */
+  uint8_t got;        /* INPUT_GOT_* decoded in this frame       */
+  module_mask_t got_modules;
 
   /* Assembled snapshot tracking */
-  uint8_t pack_received;    /* 1 if pack frame received this cycle     */
-  uint8_t modules_received; /* Bitmask of which modules received       */
+  uint8_t pack_received;          /* 1 if pack frame received this cycle */
+  module_mask_t modules_received; /* Bitmask of which modules received   */
+  uint8_t frame_contents;         /* INPUT_GOT_* of the last good frame  */
+  uint8_t cycle_seq;              /* v2: SEQ of the cycle being built    */
+  uint8_t have_cycle_seq;
+
+  /* Frame ages (input_rx_set_clock supplies the time) */
+  uint32_t now_ms;
+  uint32_t cycle_start_ms;                 /* First frame of this cycle  */
+  uint32_t module_rx_ms[PACK_NUM_MODULES]; /* Frame now in the slot      */
+  uint32_t module_good_ms[PACK_NUM_MODULES]; /* Data last consumed       */
+  module_mask_t modules_valid;             /* Consumed at least once     */
 
   /* Last valid frames */
   input_pack_frame_t last_pack;
-  input_module_frame_t last_modules[8];
+  input_module_frame_t last_modules[PACK_NUM_MODULES];
+  input_tel_config_frame_t last_tel_config; /* Read on its frame only */
+  input_blackbox_frame_t last_blackbox;     /* Read on its frame only */
+  input_threshold_frame_t last_threshold;   /* Read on its frame only */
+
+  /* Diagnostics */
+  uint32_t frames_ok;
+  uint32_t frames_bad;
+  uint32_t cycles_abandoned; /* v2: new SEQ before a cycle completed */
 } input_rx_state_t;
 
 /* Initialize the RX state */
 void input_rx_init(input_rx_state_t *rx);
 
 /* Feed one byte from UART RX.
- * Returns 1 if a complete valid frame was parsed (could be pack or module).
+ * Returns 1 if a complete valid frame was parsed (frame_contents tells
+ * what it carried).
  * Returns 2 if ALL 9 frames (1 pack + 8 modules) are now available. */
 int input_rx_feed(input_rx_state_t *rx, uint8_t byte);
 
 /* Check if a complete snapshot is available (pack + all 8 modules) */
 int input_rx_has_full_snapshot(const input_rx_state_t *rx);
 
-/* Reset the received-frame tracking for next cycle */
+/* Reset the received-frame tracking for next cycle. The modules received
+ * this cycle become the last-good data the partial policy may reuse. */
 void input_rx_reset_cycle(input_rx_state_t *rx);
 
+/* Set the time stamped on frames fed from now on */
+void input_rx_set_clock(input_rx_state_t *rx, uint32_t now_ms);
+
+/* Partial snapshot policy: returns 1 if the incomplete cycle should be
+ * evaluated now — its pack frame is in, it has waited wait_ms, and every
+ * missing module was consumed before and is at most max_age_ms old.
+ * *stale receives the missing modules, whose last-good data the caller
+ * reuses. Returns 0 otherwise (including when the cycle is complete). */
+int input_rx_partial_ready(const input_rx_state_t *rx, uint32_t now_ms,
+                           uint32_t wait_ms, uint32_t max_age_ms,
+                           module_mask_t *stale);
+
+/* Rate-request policy (PACKET_TYPE_RATE): the sender refreshes only the
+ * `required` (boosted) modules every cycle. Returns 1 once the pack
+ * frame and all of those are in and every other missing module is at
+ * most max_age_ms old; *held receives them. Unlike stale modules they
+ * are on schedule, so the caller reuses their data without flagging it.
+ * Returns 0 otherwise (including when the cycle is complete). */
+int input_rx_subset_ready(const input_rx_state_t *rx, module_mask_t required,
+                          uint32_t now_ms, uint32_t max_age_ms,
+                          module_mask_t *held);
+
+/* Frames back to snapshot units — the inverse of packet_encode_input_*.
+ * The pack decode also resets the fields the board derives itself
+ * (R_int, the short flag); the module decode leaves dT/dt alone. */
+void input_decode_pack(sensor_snapshot_t *snap,
+                       const input_pack_frame_t *frame);
+void input_decode_module(sensor_snapshot_t *snap, uint8_t module_index,
+                         const input_module_frame_t *frame);
+
+/* The same into the fixed-point snapshot: the wire units are kept, so
+ * this is a copy (group voltages rebuilt as v_base_mv + v_delta) */
+void input_decode_pack_fx(sensor_snapshot_fx_t *snap,
+                          const input_pack_frame_t *frame);
+void input_decode_module_fx(sensor_snapshot_fx_t *snap, uint8_t module_index,
+                            const input_module_frame_t *frame);
+
 #endif /* INPUT_PACKET_H */
@@ -0,0 +1,126 @@
+/*
+ * latency_stats.c — Per-Stage Execution Latency Histograms
+ */
+
+#include "latency_stats.h"
+#include <string.h>
+
+#define LAT_EXACT_BUCKETS 8u /* 0..7 µs, one bucket each */
+#define LAT_SUB_BITS 2u      /* 4 buckets per octave     */
+
+/* -----------------------------------------------------------------------
+ * Bucket mapping
+ * ----------------------------------------------------------------------- */
+static uint8_t bucket_of(uint32_t us) {
+  if (us < LAT_EXACT_BUCKETS)
+    return (uint8_t)us;
+
+  uint32_t octave = 31u - (uint32_t)__builtin_clz(us); /* >= 3 */
+  uint32_t sub = (us >> (octave - LAT_SUB_BITS)) & ((1u << LAT_SUB_BITS) - 1u);
+  uint32_t b = LAT_EXACT_BUCKETS + ((octave - 3u) << LAT_SUB_BITS) + sub;
+  return (uint8_t)(b < LAT_HIST_BUCKETS ? b : LAT_HIST_BUCKETS - 1u);
+}
+
+/* Largest value that maps to bucket b */
+static uint32_t bucket_upper_us(uint8_t b) {
+  if (b < LAT_EXACT_BUCKETS)
+    return b;
+
+  uint32_t rel = (uint32_t)b - LAT_EXACT_BUCKETS;
+  uint32_t octave = 3u + (rel >> LAT_SUB_BITS);
+  uint32_t sub = rel & ((1u << LAT_SUB_BITS) - 1u);
+  uint32_t width = 1u << (octave - LAT_SUB_BITS);
+  return (1u << octave) + (sub + 1u) * width - 1u;
+}
+
+/* -----------------------------------------------------------------------
+ * Recording
+ * ----------------------------------------------------------------------- */
+static void stage_clear(lat_stage_stats_t *st) {
+  uint32_t budget = st->budget_us;
+  memset(st, 0, sizeof(lat_stage_stats_t));
+  st->min_us = UINT32_MAX;
+  st->budget_us = budget;
+}
+
+void latency_stats_init(latency_stats_t *ls) {
+  memset(ls, 0, sizeof(latency_stats_t));
+  latency_stats_reset_window(ls);
+}
+
+void latency_stats_set_budget(latency_stats_t *ls, lat_stage_t stage,
+                              uint32_t budget_us) {
+  if (stage < LAT_NUM_STAGES)
+    ls->stage[stage].budget_us = budget_us;
+}
+
+void latency_stats_record(latency_stats_t *ls, lat_stage_t stage,
+                          uint32_t us) {
+  if (stage >= LAT_NUM_STAGES)
+    return;
+
+  lat_stage_stats_t *st = &ls->stage[stage];
+  st->count++;
+  st->sum_us += us;
+  if (us < st->min_us)
+    st->min_us = us;
+  if (us > st->max_us)
+    st->max_us = us;
+  if (st->budget_us && us > st->budget_us)
+    st->overruns++;
+
+  uint8_t b = bucket_of(us);
+  if (st->hist[b] < UINT16_MAX)
+    st->hist[b]++;
+}
+
+void latency_stats_reset_window(latency_stats_t *ls) {
+  for (int s = 0; s < LAT_NUM_STAGES; s++) {
+    stage_clear(&ls->stage[s]);
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Summaries
+ * ----------------------------------------------------------------------- */
+uint32_t latency_stats_mean_us(const lat_stage_stats_t *st) {
+  return st->count ? st->sum_us / st->count : 0;
+}
+
+uint32_t latency_stats_percentile_us(const lat_stage_stats_t *st,
+                                     uint16_t permille) {
+  if (st->count == 0)
+    return 0;
+
+  /* Rank of the requested sample, 1-based, rounded up */
+  uint32_t rank = (uint32_t)(((uint64_t)st->count * permille + 999u) / 1000u);
+  if (rank == 0)
+    rank = 1;
+
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < LAT_HIST_BUCKETS; b++) {
+    seen += st->hist[b];
+    if (seen >= rank) {
+      uint32_t upper = bucket_upper_us(b);
+      return upper < st->max_us ? upper : st->max_us;
+    }
+  }
+  return st->max_us;
+}
+
+const char *latency_stage_name(lat_stage_t stage) {
+  switch (stage) {
+  case LAT_FAST_LOOP:
+    return "fast";
+  case LAT_MED_LOOP:
+    return "med";
+  case LAT_EVAL_COMPUTE:
+    return "compute";
+  case LAT_EVAL_RUN:
+    return "eval";
+  case LAT_SLOW_LOOP:
+    return "slow";
+  default:
+    return "?";
+  }
+}
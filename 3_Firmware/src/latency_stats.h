@@ -0,0 +1,79 @@
+/*
+ * latency_stats.h — Per-Stage Execution Latency Histograms
+ *
+ * Records how long each loop stage takes so the 20 ms alert-mode
+ * budget and the sensor-to-relay path can be checked on the board.
+ *
+ * Each stage keeps min/max/sum and a log-linear histogram in µs:
+ * values below 8 µs get exact buckets, above that every power of two
+ * is split into 4 buckets, so a percentile read from the histogram
+ * is within 25% of the true value. Samples over a stage's budget are
+ * counted as overruns.
+ *
+ * Stats cover a reporting window: the slow loop emits them as
+ * telemetry (PACKET_TYPE_LATENCY) and then starts a new window.
+ *
+ * Samples arrive already in µs: the caller reads the cycle counter
+ * and converts.
+ */
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+typedef enum {
+  LAT_FAST_LOOP = 0,
+  LAT_MED_LOOP,
+  LAT_EVAL_COMPUTE, /* anomaly_eval_compute() */
+  LAT_EVAL_RUN,     /* anomaly_eval_run()     */
+  LAT_SLOW_LOOP,
+  LAT_NUM_STAGES,
+} lat_stage_t;
+
+/* 8 exact buckets + 4 per octave for 2^3 .. 2^16 µs (~131 ms) */
+#define LAT_HIST_BUCKETS 64
+
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint32_t sum_us;
+  uint32_t overruns;  /* Samples above budget_us             */
+  uint32_t budget_us; /* 0 = no budget, never overruns       */
+  uint16_t hist[LAT_HIST_BUCKETS];
+} lat_stage_stats_t;
+
+typedef struct {
+  lat_stage_stats_t stage[LAT_NUM_STAGES];
+} latency_stats_t;
+
+/* Clear all stages and budgets */
+void latency_stats_init(latency_stats_t *ls);
+
+/* Set the per-sample budget for a stage (µs, 0 disables) */
+void latency_stats_set_budget(latency_stats_t *ls, lat_stage_t stage,
+                              uint32_t budget_us);
+
+/* Record one sample */
+void latency_stats_record(latency_stats_t *ls, lat_stage_t stage,
+                          uint32_t us);
+
+/* Mean over the window (0 if no samples) */
+uint32_t latency_stats_mean_us(const lat_stage_stats_t *st);
+
+/*
+ * Percentile from the histogram, e.g. permille = 990 for p99.
+ * Returns the upper edge of the bucket holding that rank, capped at
+ * max_us (0 if no samples).
+ */
+uint32_t latency_stats_percentile_us(const lat_stage_stats_t *st,
+                                     uint16_t permille);
+
+/* Start a new window; budgets are kept */
+void latency_stats_reset_window(latency_stats_t *ls);
+
+/* Short stage name for logs */
+const char *latency_stage_name(lat_stage_t stage);
+
+#endif /* LATENCY_STATS_H */
@@ -0,0 +1,210 @@
+/*
+ * log_event.c — Binary Log Events
+ */
+
+#include "log_event.h"
+#include "anomaly_eval.h"
+#include "correlation_engine.h"
+#include "hal_uart.h"
+#include <string.h>
+
+#if LOG_EVENT_TEXT
+#include <stdio.h>
+#endif
+
+#define LOG_MASK (LOG_EVENT_RING_SIZE - 1u)
+
+_Static_assert((LOG_EVENT_RING_SIZE & LOG_MASK) == 0,
+               "LOG_EVENT_RING_SIZE must be a power of two");
+_Static_assert(sizeof(log_tel_args_t) <= LOG_EVENT_MAX_ARGS &&
+                   sizeof(log_bbx_status_args_t) <= LOG_EVENT_MAX_ARGS,
+               "log event arguments exceed LOG_EVENT_MAX_ARGS");
+
+void log_event_init(log_event_t *log) {
+  memset(log, 0, sizeof(log_event_t));
+  log->text = LOG_EVENT_TEXT;
+}
+
+uint16_t log_event_pending(const log_event_t *log) {
+  return (uint16_t)(log->head - log->tail);
+}
+
+bool log_event_emit(log_event_t *log, uint8_t event, uint32_t t_ms,
+                    const void *args, uint8_t len) {
+  uint8_t seq = log->seq++;
+  if (len > LOG_EVENT_MAX_ARGS) {
+    log->dropped++;
+    return false;
+  }
+
+  uint8_t frame[LOG_EVENT_MAX_FRAME];
+  uint8_t flen = (uint8_t)(LOG_EVENT_HEADER + len + 1);
+  frame[0] = PACKET_SYNC_BYTE;
+  frame[1] = flen;
+  frame[2] = PACKET_TYPE_LOG;
+  frame[3] = seq;
+  frame[4] = event;
+  memcpy(&frame[5], &t_ms, sizeof(t_ms)); /* RV32 and host: LE */
+  if (len)
+    memcpy(&frame[LOG_EVENT_HEADER], args, len);
+  frame[flen - 1] = packet_checksum(frame, (uint8_t)(flen - 1));
+
+#if LOG_EVENT_TEXT
+  if (log->text) {
+    char line[200];
+    if (log_event_format(line, sizeof(line), frame) > 0)
+      (void)hal_uart_print(line);
+    log->emitted++;
+    return true;
+  }
+#endif
+
+  if (LOG_EVENT_RING_SIZE - log_event_pending(log) < flen) {
+    log->dropped++; /* The SEQ gap shows it */
+    return false;
+  }
+  for (uint8_t i = 0; i < flen; i++)
+    log->ring[(uint16_t)(log->head + i) & LOG_MASK] = frame[i];
+  log->head = (uint16_t)(log->head + flen);
+  log->emitted++;
+  return true;
+}
+
+uint8_t log_event_flush(log_event_t *log) {
+  uint8_t sent = 0;
+  while (log_event_pending(log) > 0) {
+    uint8_t frame[LOG_EVENT_MAX_FRAME];
+    uint8_t flen = log->ring[(uint16_t)(log->tail + 1) & LOG_MASK];
+    for (uint8_t i = 0; i < flen; i++)
+      frame[i] = log->ring[(uint16_t)(log->tail + i) & LOG_MASK];
+    if (hal_uart_send_async(frame, flen) != HAL_OK)
+      break; /* Retried on the next pass */
+    log->tail = (uint16_t)(log->tail + flen);
+    sent++;
+  }
+  return sent;
+}
+
+/* -----------------------------------------------------------------------
+ * Text formatting (host builds; serial_reader.py mirrors it)
+ * ----------------------------------------------------------------------- */
+#if LOG_EVENT_TEXT
+int log_event_format(char *buf, size_t size, const uint8_t *frame) {
+  if (frame[0] != PACKET_SYNC_BYTE || frame[2] != PACKET_TYPE_LOG ||
+      frame[1] < LOG_EVENT_HEADER + 1)
+    return 0;
+  uint8_t len = (uint8_t)(frame[1] - LOG_EVENT_HEADER - 1);
+  const uint8_t *args = &frame[LOG_EVENT_HEADER];
+  uint32_t t_ms;
+  memcpy(&t_ms, &frame[5], sizeof(t_ms));
+
+  int n = 0;
+  switch (frame[4]) {
+  case LOG_EV_STATE: {
+    log_state_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size,
+                 "[STATE] %s -> %s (cats=%d, hotspot=M%d, risk=%d%%)%s\r\n",
+                 correlation_state_name((system_state_t)a.from),
+                 correlation_state_name((system_state_t)a.to), a.cats,
+                 a.hotspot, a.risk_pct, a.direct ? " [DIRECT]" : "");
+    break;
+  }
+  case LOG_EV_TEL: {
+    log_tel_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size,
+                 "[TEL] t=%lums V=%d I=%d Tmax=%.1f dT/dt=%.2f "
+                 "gas=[%.2f,%.2f] dP=[%.1f,%.1f] state=%s cats=%d "
+                 "hot=M%d risk=%d%% stg=%s\r\n",
+                 (unsigned long)t_ms, a.pack_v, a.pack_a, a.tmax_dc / 10.0,
+                 (double)a.dt_dt_c / 100.0, a.gas_c[0] / 100.0,
+                 a.gas_c[1] / 100.0, a.dp_dhpa[0] / 10.0, a.dp_dhpa[1] / 10.0,
+                 correlation_state_name((system_state_t)a.state), a.cats,
+                 a.hotspot, a.risk_pct, cascade_stage_name(a.stage));
+    break;
+  }
+  case LOG_EV_TRIP: {
+    log_trip_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size, "[TRIP] I=%dA — relay opened pre-emptively\r\n",
+                 a.current_a);
+    break;
+  }
+  case LOG_EV_RATE: {
+    log_rate_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size, "[RATE] %d/%d modules at the alert rate\r\n",
+                 a.boosted, a.modules);
+    break;
+  }
+  case LOG_EV_TEL_CONFIG: {
+    log_tel_config_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size,
+                 "[TEL] mode=%s key=%u ascii=%d v2=%d period=%lums\r\n",
+                 a.mode ? "compact" : "legacy", (unsigned)a.key_interval,
+                 a.ascii, a.v2, (unsigned long)a.period_ms);
+    break;
+  }
+  case LOG_EV_BBX_EVENT: {
+    log_bbx_event_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size,
+                 "[BBX] Event %u: %u pre-trigger records frozen\r\n",
+                 (unsigned)a.event, (unsigned)a.records);
+    break;
+  }
+  case LOG_EV_BBX_DUMP: {
+    log_bbx_dump_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size, "[BBX] Dump %s (events=%u)\r\n",
+                 a.started ? "started" : "skipped, log empty",
+                 (unsigned)a.events);
+    break;
+  }
+  case LOG_EV_BBX_STATUS: {
+    log_bbx_status_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size,
+                 "[BBX] events=%lu last=%u sector=%u capturing=%d "
+                 "dropped=%lu errors=%lu\r\n",
+                 (unsigned long)a.events, (unsigned)a.last,
+                 (unsigned)a.sector, a.capturing, (unsigned long)a.dropped,
+                 (unsigned long)a.errors);
+    break;
+  }
+  case LOG_EV_THRESHOLD: {
+    static const char *const OPS[] = {"set", "apply", "defaults", "revert"};
+    log_threshold_args_t a;
+    if (len != sizeof(a))
+      return 0;
+    memcpy(&a, args, sizeof(a));
+    n = snprintf(buf, size, "[THR] %s param=%u value=%ld %s (plan %u)\r\n",
+                 a.op < 4 ? OPS[a.op] : "?", (unsigned)a.param,
+                 (long)a.value_milli, a.ok ? "ok" : "rejected",
+                 (unsigned)a.plan);
+    break;
+  }
+  default:
+    return 0;
+  }
+  return n > 0 && (size_t)n < size ? n : 0;
+}
+#endif
@@ -0,0 +1,193 @@
+/*
+ * log_event.h — Binary Log Events
+ *
+ * The [STATE], [TEL], [RATE], [TRIP] and [BBX] debug lines used to be
+ * built with snprintf (floats included) inside the loops and pushed out
+ * as text. Call sites now hand over an event id and its raw arguments;
+ * the record is framed at once, queued in a RAM ring and sent when the
+ * UART TX ring has room. The dashboard (serial_reader.py) turns it back
+ * into the same line. The loops no longer format text, and a [TEL] line
+ * shrinks from ~130 B of text to a 33 B frame.
+ *
+ *   [0xAA][LEN][0x08][SEQ][EVENT][t_ms u32][args ≤ LOG_EVENT_MAX_ARGS][XOR]
+ *
+ * SEQ counts every event, sent or not, so the receiver sees what the
+ * ring dropped. Arguments are the packed log_*_args_t structs below;
+ * floats are sent as fixed-point integers at the precision the text
+ * line printed them.
+ *
+ * With LOG_EVENT_TEXT (host builds) an event is formatted and printed
+ * where it is emitted instead, so the host simulation still reads as
+ * text. log_event_format() is the reference for the decoder.
+ */
+
+#ifndef LOG_EVENT_H
+#define LOG_EVENT_H
+
+#include "hal_platform.h"
+#include "packet_format.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LOG_EVENT_TEXT
+#define LOG_EVENT_TEXT HAL_HOST_MODE
+#endif
+
+#define LOG_EVENT_RING_SIZE 256 /* Power of two; 7 [TEL] frames       */
+#define LOG_EVENT_HEADER 9      /* sync .. t_ms                       */
+#define LOG_EVENT_MAX_ARGS 24
+#define LOG_EVENT_MAX_FRAME (LOG_EVENT_HEADER + LOG_EVENT_MAX_ARGS + 1)
+
+/* Event ids — append only, the dashboard keys its formats on them */
+typedef enum {
+  LOG_EV_STATE = 1,      /* log_state_args_t                         */
+  LOG_EV_TEL = 2,        /* log_tel_args_t                           */
+  LOG_EV_TRIP = 3,       /* log_trip_args_t                          */
+  LOG_EV_RATE = 4,       /* log_rate_args_t                          */
+  LOG_EV_TEL_CONFIG = 5, /* log_tel_config_args_t                    */
+  LOG_EV_BBX_EVENT = 6,  /* log_bbx_event_args_t                     */
+  LOG_EV_BBX_DUMP = 7,   /* log_bbx_dump_args_t                      */
+  LOG_EV_BBX_STATUS = 8, /* log_bbx_status_args_t                    */
+  LOG_EV_THRESHOLD = 9,  /* log_threshold_args_t                     */
+} log_event_id_t;
+
+/* "[STATE] WARNING -> CRITICAL (cats=2, hotspot=M3, risk=45%) [DIRECT]" */
+typedef struct __attribute__((packed)) {
+  uint8_t from;     /* system_state_t                          */
+  uint8_t to;       /* system_state_t                          */
+  uint8_t cats;     /* active_count                            */
+  uint8_t hotspot;  /* 1-based module, 0 = none                */
+  uint8_t risk_pct; /* risk_factor × 100                       */
+  uint8_t direct;   /* is_emergency_direct                     */
+} log_state_args_t;
+
+/* "[TEL] t=...ms V=.. I=.. Tmax=.. dT/dt=.. gas=[..] dP=[..] ..." */
+typedef struct __attribute__((packed)) {
+  int16_t pack_v;      /* V                                       */
+  int16_t pack_a;      /* A                                       */
+  int16_t tmax_dc;     /* 0.1 °C                                  */
+  int32_t dt_dt_c;     /* 0.01 °C/s (a runaway passes 327 °C/s)   */
+  int16_t gas_c[2];    /* 0.01                                    */
+  int16_t dp_dhpa[2];  /* 0.1 hPa                                 */
+  uint8_t state;       /* system_state_t                          */
+  uint8_t cats;        /* active_count                            */
+  uint8_t hotspot;     /* 1-based module                          */
+  uint8_t risk_pct;    /* risk_factor × 100                       */
+  uint8_t stage;       /* cascade_stage                           */
+} log_tel_args_t;
+
+/* "[TRIP] I=400A — relay opened pre-emptively" */
+typedef struct __attribute__((packed)) {
+  int16_t current_a;
+} log_trip_args_t;
+
+/* "[RATE] 3/8 modules at the alert rate" */
+typedef struct __attribute__((packed)) {
+  uint8_t boosted;
+  uint8_t modules;
+} log_rate_args_t;
+
+/* "[TEL] mode=compact key=10 ascii=1 v2=0 period=500ms" */
+typedef struct __attribute__((packed)) {
+  uint8_t mode; /* INPUT_TEL_MODE_*                        */
+  uint8_t key_interval;
+  uint8_t ascii;
+  uint8_t v2;
+  uint32_t period_ms;
+} log_tel_config_args_t;
+
+/* "[BBX] Event 2: 13 pre-trigger records frozen" */
+typedef struct __attribute__((packed)) {
+  uint16_t event;
+  uint16_t records;
+} log_bbx_event_args_t;
+
+/* "[BBX] Dump started (events=0)" */
+typedef struct __attribute__((packed)) {
+  uint8_t started;
+  uint16_t events;
+} log_bbx_dump_args_t;
+
+/* "[BBX] events=3 last=3 sector=5 capturing=0 dropped=0 errors=0" */
+typedef struct __attribute__((packed)) {
+  uint32_t events;
+  uint16_t last;
+  uint16_t sector;
+  uint8_t capturing;
+  uint32_t dropped;
+  uint32_t errors;
+} log_bbx_status_args_t;
+
+/* "[THR] set param=8 value=55000 ok (plan 2)" */
+typedef struct __attribute__((packed)) {
+  uint8_t op;          /* INPUT_THRESHOLD_OP_*                    */
+  uint8_t param;
+  int32_t value_milli;
+  uint8_t ok;          /* 0: unknown param, or the set failed its */
+                       /* check (APPLY)                           */
+  uint16_t plan;       /* Threshold sets applied since boot       */
+} log_threshold_args_t;
+
+typedef struct {
+  uint8_t ring[LOG_EVENT_RING_SIZE]; /* Whole frames, back to back */
+  uint16_t head;     /* Free-running write index                   */
+  uint16_t tail;     /* Free-running read index                    */
+  uint8_t seq;       /* Next event's SEQ                           */
+  bool text;         /* Print at emit (LOG_EVENT_TEXT builds only) */
+  uint32_t emitted;
+  uint32_t dropped;  /* Ring full, or arguments too long           */
+} log_event_t;
+
+void log_event_init(log_event_t *log);
+
+/*
+ * Frame one event and queue it (or print it, in text mode). Never
+ * waits; returns false if the event was dropped.
+ */
+bool log_event_emit(log_event_t *log, uint8_t event, uint32_t t_ms,
+                    const void *args, uint8_t len);
+
+/*
+ * Move queued frames into the UART TX ring while it has room for the
+ * next whole frame. Returns the number of frames sent.
+ */
+uint8_t log_event_flush(log_event_t *log);
+
+/* Frames waiting in the ring, in bytes */
+uint16_t log_event_pending(const log_event_t *log);
+
+/* Round and saturate a reading to a fixed-point argument */
+static inline int16_t log_event_q(float x, float scale) {
+  float v = x * scale;
+  if (v >= 32767.0f)
+    return 32767;
+  if (v <= -32768.0f)
+    return -32768;
+  return (int16_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+/* As log_event_q for an integer reading, x / div rounded */
+static inline int16_t log_event_qi(int32_t x, int32_t div) {
+  int32_t v = (x + (x < 0 ? -div / 2 : div / 2)) / div;
+  return (int16_t)(v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline int32_t log_event_q32(float x, float scale) {
+  float v = x * scale;
+  if (v >= 2147483520.0f)
+    return 2147483647;
+  if (v <= -2147483648.0f)
+    return -2147483647 - 1;
+  return (int32_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+#if LOG_EVENT_TEXT
+/*
+ * Format one frame as its text line (with "\r\n"). Returns the length
+ * written, or 0 for a frame that is malformed or of an unknown event.
+ */
+int log_event_format(char *buf, size_t size, const uint8_t *frame);
+#endif
+
+#endif /* LOG_EVENT_H */
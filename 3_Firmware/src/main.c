@@ -24,50 +24,116 @@
 #include <string.h>
 
 /* HAL layer */
+#include "hal_flash.h"
 #include "hal_gpio.h"
 #include "hal_platform.h"
+#include "hal_timer.h"
 #include "hal_uart.h"
 
 /* Core intelligence */
 #include "anomaly_eval.h"
+#include "anomaly_eval_fx.h"
+#include "blackbox.h"
 #include "correlation_engine.h"
+#include "history.h"
+#include "latency_stats.h"
+#include "log_event.h"
+#include "module_rate.h"
+#include "online_stats.h"
 
 /* Application */
+#include "acquire.h"
 #include "input_packet.h"
 #include "packet_format.h"
+#include "safety_trip.h"
+#include "scheduler.h"
 
 /* -----------------------------------------------------------------------
  * Loop timing configuration
  * ----------------------------------------------------------------------- */
 #define FAST_LOOP_NORMAL_MS 100
-#define MED_LOOP_NORMAL_MS 500
+#define MED_LOOP_NORMAL_MS CORR_MED_NORMAL_MS /* correlation_engine.h */
 #define SLOW_LOOP_NORMAL_MS 5000
 
 #define FAST_LOOP_ALERT_MS 20
-#define MED_LOOP_ALERT_MS 100
+#define MED_LOOP_ALERT_MS CORR_MED_ALERT_MS
 #define SLOW_LOOP_ALERT_MS 1000
 #define SLOW_LOOP_EXTERNAL_MS 1000
 
-/* Correlation timing windows */
-#define CRITICAL_HOLD_MS 10000
-#define DEESCALATION_HOLD_MS 5000
+/* Rate estimation windows (least-squares over real sample times) */
+#define HIST_DT_WINDOW_MS 3000 /* dT/dt: 6 samples normal, 30 alert */
+#define HIST_DR_WINDOW_MS 2000 /* dR/dt                             */
 
-#define SCHED_TICK_MS 10
+#define SCHED_TICK_MS 10 /* Hardware tick; every loop period is a multiple */
 #define SIM_DURATION_S 215
+/* Sim scenarios are written for the 104S: pack voltages scale with the
+ * series count, and the faults address modules 1..6 */
+#define SIM_PACK_V(v) ((v) * ((float)TOTAL_SERIES / 104.0f))
+_Static_assert(NUM_MODULES >= 7, "simulated scenarios need 7+ modules");
+#define BOOT_LED_STEP_MS 50
 
 /* -----------------------------------------------------------------------
  * Global state
  * ----------------------------------------------------------------------- */
 
-static sensor_snapshot_t g_snapshot;
+/* Acquisition publishes into g_snapbuf; the loops evaluate g_snap, the
+ * slot pinned for the current scheduler pass. */
+static snapshot_buffer_t g_snapbuf;
+static sensor_snapshot_t *g_snap = &g_snapbuf.slot[0];
+static uint32_t g_snap_seq; /* Publish number of the pinned slot */
 static anomaly_result_t g_anomaly;
 static anomaly_thresholds_t g_thresholds;
+static anomaly_plan_t g_plan; /* g_thresholds compiled for the loops */
+static uint16_t g_plan_count; /* Threshold sets applied since boot */
+static anomaly_eval_cache_t g_eval_cache;
+
+#if ANOMALY_EVAL_FIXED_POINT
+/* Wire-unit twin of each snapshot slot. Input frames decode straight
+ * into it; the evaluator, baselines, rates, telemetry and black box all
+ * run on it. The float slot is only scratch for the float-producing
+ * writers (fallback sim, on-board sensors). */
+static sensor_snapshot_fx_t g_snap_fx[2];
+static anomaly_thresholds_fx_t g_thresholds_fx;
+static anomaly_eval_fx_cache_t g_eval_fx_cache;
+
+static sensor_snapshot_fx_t *snapshot_fx_of(const sensor_snapshot_t *slot) {
+  return &g_snap_fx[slot - g_snapbuf.slot];
+}
+#endif
+
+/* Short-circuit flag of the pinned snapshot */
+static bool snapshot_short_circuit(void) {
+#if ANOMALY_EVAL_FIXED_POINT
+  return snapshot_fx_of(g_snap)->short_circuit;
+#else
+  return g_snap->short_circuit;
+#endif
+}
+
+/* Risk percentage for the logs, from the evaluator that produced it */
+static uint8_t anomaly_risk_pct(void) {
+#if ANOMALY_EVAL_FIXED_POINT
+  return anomaly_risk_pct_fx(&g_anomaly);
+#else
+  return (uint8_t)(g_anomaly.risk_factor * 100);
+#endif
+}
 
 static correlation_engine_t g_corr;
-static float g_prev_r_int_mohm = 0.0f;
+static safety_trip_t g_trip;
+
+/* Rates computed by med_loop, carried into each newly written slot */
+#if ANOMALY_EVAL_FIXED_POINT
+static int16_t g_module_dt_dt_ddpm[NUM_MODULES];
+#else
+static float g_dr_dt_mohm_per_s = 0.0f;
+static float g_module_dt_dt[NUM_MODULES];
+#endif
 
-/* NTC history for dT/dt computation (per module, 2 NTCs each) */
-static float g_prev_ntc[NUM_MODULES][2]; /* [module][ntc_index] */
+/* Med-loop sample history: dT/dt over every NTC, dR/dt over R_int */
+static history_t g_history;
+static int g_hist_dt;
+static int g_hist_dr;
 
 /* External input state */
 static input_rx_state_t g_input_rx;
@@ -75,63 +141,96 @@ static uint8_t g_external_input_active = 0;
 static uint32_t g_last_external_ms = 0;
 #define EXTERNAL_INPUT_TIMEOUT_MS 2000
 
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+/* On-board sensors, the fallback input without a twin */
+static acq_t g_acq;
+static bool g_acq_ok = false; /* acq_init() succeeded */
+#endif
+
 /* Core temperature estimation constant */
 #define R_THERMAL_CW 3.0f /* °C/W for IFR32135 cylindrical */
 
+/* Learned per-channel baselines, fed once per published frame */
+static online_stats_t g_stats;
+static uint32_t g_stats_seq;
+
+/* Per-stage execution time, reported every slow loop */
+static latency_stats_t g_latency;
+
+/* Black-box recorder (ring + flash log writer) */
+static blackbox_t g_blackbox;
+
+/* Debug lines as binary events (text on the host) */
+static log_event_t g_log;
+
+/* Per-module rates: suspects at the alert period, the rest at normal */
+static module_rate_t g_rate;
+static module_cadence_t g_cad_acquire; /* Module channels into the snapshot */
+static module_cadence_t g_cad_rates;   /* dT/dt slopes                      */
+static module_cadence_t g_cad_tel;     /* Module detail frames              */
+
+/* Telemetry output format, negotiated by the dashboard with a config
+ * frame (INPUT_TYPE_TEL_CONFIG). Legacy frames + [TEL] line by default. */
+static uint8_t g_tel_mode = INPUT_TEL_MODE_LEGACY;
+static bool g_tel_ascii = true;
+static uint32_t g_tel_period_ms = 0; /* Slow loop cap, 0 = none */
+static packet_compact_enc_t g_tel_compact;
+static packet_group_stream_t g_tel_groups; /* Flagged modules' groups */
+static bool g_tel_v2 = false;              /* Superframe output        */
+static packet_super_t g_tel_super;         /* Superframe being filled  */
+static uint8_t g_tel_cycle_seq = 0;
+
 /* Timing */
 static uint32_t g_uptime_ms = 0;
 static uint32_t g_fast_loop_ms = FAST_LOOP_NORMAL_MS;
 static uint32_t g_med_loop_ms = MED_LOOP_NORMAL_MS;
 static uint32_t g_slow_loop_ms = SLOW_LOOP_NORMAL_MS;
-static uint32_t g_next_fast_ms = 0;
-static uint32_t g_next_med_ms = 0;
-static uint32_t g_next_slow_ms = 0;
+static uint32_t g_slow_normal_ms = SLOW_LOOP_NORMAL_MS; /* Healthy modules */
+static uint32_t g_demo_start_ms = 0; /* Scenario clock origin */
 static bool g_startup_self_check_passed = false;
 
-/* -----------------------------------------------------------------------
- * Scheduler helpers
- * ----------------------------------------------------------------------- */
+/* Loop tasks, highest priority first: safety trip before evaluation
+ * before telemetry */
+static sched_t g_sched;
+static int g_task_fast = -1;
+static int g_task_med = -1;
+static int g_task_slow = -1;
 
-static uint16_t ms_to_cycles(uint32_t window_ms, uint32_t period_ms) {
-  if (period_ms == 0)
-    return 1;
-  uint32_t cycles = (window_ms + period_ms - 1u) / period_ms;
-  if (cycles == 0u)
-    return 1;
-  if (cycles > 65535u)
-    return 65535u;
-  return (uint16_t)cycles;
+/* Queue a debug event stamped with the loop clock; a full ring drops it */
+static void log_emit(uint8_t event, const void *args, uint8_t len) {
+  (void)log_event_emit(&g_log, event, g_uptime_ms, args, len);
 }
 
-static void correlation_sync_timing_limits(void) {
-  g_corr.critical_countdown_limit =
-      ms_to_cycles(CRITICAL_HOLD_MS, g_med_loop_ms);
-  g_corr.deescalation_limit = ms_to_cycles(DEESCALATION_HOLD_MS, g_med_loop_ms);
-}
+/* -----------------------------------------------------------------------
+ * Scheduler helpers
+ * ----------------------------------------------------------------------- */
 
 static void scheduler_reset(void) {
   g_fast_loop_ms = FAST_LOOP_NORMAL_MS;
   g_med_loop_ms = MED_LOOP_NORMAL_MS;
   g_slow_loop_ms = SLOW_LOOP_NORMAL_MS;
-  g_next_fast_ms = g_uptime_ms;
-  g_next_med_ms = g_uptime_ms;
-  g_next_slow_ms = g_uptime_ms;
-  correlation_sync_timing_limits();
-}
-
-static bool scheduler_is_alert_mode(void) {
-  return g_snapshot.short_circuit || (g_anomaly.active_count > 0) ||
-         (g_corr.current_state != STATE_NORMAL);
+  g_slow_normal_ms = SLOW_LOOP_NORMAL_MS;
+  sched_set_period(&g_sched, g_task_fast, g_fast_loop_ms, g_uptime_ms);
+  sched_set_period(&g_sched, g_task_med, g_med_loop_ms, g_uptime_ms);
+  sched_set_period(&g_sched, g_task_slow, g_slow_loop_ms, g_uptime_ms);
+  sched_reset(&g_sched, g_uptime_ms);
+  correlation_engine_set_period(&g_corr, g_med_loop_ms);
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+  acq_set_rates(&g_acq, g_fast_loop_ms, g_med_loop_ms);
+#endif
 }
 
+/* Med period and alert test from the correlation engine's policy; the
+ * fast and slow loops follow the same alert decision */
 static void scheduler_apply_sampling_rates(void) {
+  bool short_circuit = snapshot_short_circuit();
   uint32_t target_fast = FAST_LOOP_NORMAL_MS;
-  uint32_t target_med = MED_LOOP_NORMAL_MS;
+  uint32_t target_med =
+      correlation_med_period_ms(&g_corr, &g_anomaly, short_circuit);
   uint32_t target_slow = SLOW_LOOP_NORMAL_MS;
 
-  if (scheduler_is_alert_mode()) {
+  if (correlation_alert_mode(&g_corr, &g_anomaly, short_circuit)) {
     target_fast = FAST_LOOP_ALERT_MS;
-    target_med = MED_LOOP_ALERT_MS;
     target_slow = SLOW_LOOP_ALERT_MS;
   }
 
@@ -139,16 +238,48 @@ static void scheduler_apply_sampling_rates(void) {
     target_slow = SLOW_LOOP_EXTERNAL_MS;
   }
 
+  if (g_tel_period_ms && target_slow > g_tel_period_ms) {
+    target_slow = g_tel_period_ms;
+  }
+
+  /* What the slow loop would run at without the alert */
+  g_slow_normal_ms = SLOW_LOOP_NORMAL_MS;
+  if (g_external_input_active && g_slow_normal_ms > SLOW_LOOP_EXTERNAL_MS)
+    g_slow_normal_ms = SLOW_LOOP_EXTERNAL_MS;
+  if (g_tel_period_ms && g_slow_normal_ms > g_tel_period_ms)
+    g_slow_normal_ms = g_tel_period_ms;
+
+  bool med_changed = g_med_loop_ms != target_med;
   g_fast_loop_ms = target_fast;
   g_med_loop_ms = target_med;
   g_slow_loop_ms = target_slow;
+  if (med_changed)
+    correlation_engine_set_period(&g_corr, g_med_loop_ms);
+
+  /* Shorter periods pull pending deadlines in immediately */
+  sched_set_period(&g_sched, g_task_fast, g_fast_loop_ms, g_uptime_ms);
+  sched_set_period(&g_sched, g_task_med, g_med_loop_ms, g_uptime_ms);
+  sched_set_period(&g_sched, g_task_slow, g_slow_loop_ms, g_uptime_ms);
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+  acq_set_rates(&g_acq, g_fast_loop_ms, g_med_loop_ms);
+#endif
+}
 
-  if (g_next_fast_ms > (g_uptime_ms + g_fast_loop_ms))
-    g_next_fast_ms = g_uptime_ms + g_fast_loop_ms;
-  if (g_next_med_ms > (g_uptime_ms + g_med_loop_ms))
-    g_next_med_ms = g_uptime_ms + g_med_loop_ms;
-  if (g_next_slow_ms > (g_uptime_ms + g_slow_loop_ms))
-    g_next_slow_ms = g_uptime_ms + g_slow_loop_ms;
+/* -----------------------------------------------------------------------
+ * Thresholds — compiled once per change, never per pass
+ * ----------------------------------------------------------------------- */
+
+/* Make g_thresholds live: the float plan (or wire-unit limits), the
+ * pre-emptive trip level, and fresh caches for the next pass */
+static void thresholds_compile(void) {
+  anomaly_plan_compile(&g_plan, &g_thresholds);
+  anomaly_eval_cache_init(&g_eval_cache);
+#if ANOMALY_EVAL_FIXED_POINT
+  anomaly_thresholds_to_fx(&g_thresholds_fx, &g_thresholds);
+  anomaly_eval_fx_cache_init(&g_eval_fx_cache);
+#endif
+  safety_trip_set_limit(&g_trip, &g_thresholds);
+  g_plan_count++;
 }
 
 /* -----------------------------------------------------------------------
@@ -160,19 +291,23 @@ static bool startup_self_check(void) {
     return false;
   }
 
-  if (!(g_thresholds.temp_warning_c < g_thresholds.temp_critical_c &&
-        g_thresholds.gas_warning_ratio > g_thresholds.gas_critical_ratio &&
-        g_thresholds.pressure_warning_hpa <
-            g_thresholds.pressure_critical_hpa &&
-        g_thresholds.current_warning_a < g_thresholds.current_short_a)) {
+  if (anomaly_thresholds_check(&g_thresholds) != HAL_OK) {
     hal_uart_print("[SAFE] Self-check FAIL: threshold ordering\r\n");
     return false;
   }
 
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+  /* Built to publish the on-board sensors: no bus, no arming */
+  if (!g_acq_ok) {
+    hal_uart_print("[SAFE] Self-check FAIL: sensor acquisition\r\n");
+    return false;
+  }
+#endif
+
   /* Quick functional test */
   sensor_snapshot_t probe;
   memset(&probe, 0, sizeof(probe));
-  probe.pack_voltage_v = 332.8f;
+  probe.pack_voltage_v = SIM_PACK_V(332.8f);
   probe.pack_current_a = 60.0f;
   probe.r_internal_mohm = 0.44f;
 
@@ -207,11 +342,11 @@ static bool startup_self_check(void) {
 }
 
 /* -----------------------------------------------------------------------
- * Simulated sensor injection (Full Pack — 8 modules × 13 groups)
+ * Simulated sensor injection (Full Pack — NUM_MODULES × GROUPS_PER_MODULE)
  *
  * Same 7 scenarios as before, adapted for 104S8P scale.
  *
- *   Scenario 1 (  0- 30s): Normal Operation — all 8 modules steady
+ *   Scenario 1 (  0- 30s): Normal Operation — all modules steady
  *   Scenario 2 ( 30- 70s): Thermal Anomaly — Module 3 heats up
  *   Scenario 3 ( 70-100s): Gas Anomaly — electrolyte off-gassing
  *   Scenario 4 (100-150s): Multi-Fault — thermal + gas + pressure
@@ -224,13 +359,14 @@ static void sim_inject_data(sensor_snapshot_t *snap, uint32_t t_ms) {
   float t_s = (float)t_ms / 1000.0f;
 
   /* Default safe values for full pack */
-  snap->pack_voltage_v = 332.8f;
+  snap->pack_voltage_v = SIM_PACK_V(332.8f);
   snap->pack_current_a = 60.0f;  /* 0.5C = 60A */
   snap->r_internal_mohm = 0.44f; /* Group R_int = 3.5mΩ/8 */
 
+  /* 2.4°C gradient end to end (0.3°C/module on the 8-module pack) */
   for (int m = 0; m < NUM_MODULES; m++) {
-    snap->modules[m].ntc1_c = 28.0f + (float)m * 0.3f;
-    snap->modules[m].ntc2_c = 28.2f + (float)m * 0.3f;
+    snap->modules[m].ntc1_c = 28.0f + (float)m * (2.4f / NUM_MODULES);
+    snap->modules[m].ntc2_c = 28.2f + (float)m * (2.4f / NUM_MODULES);
     snap->modules[m].swelling_pct = 0.5f;
     snap->modules[m].max_dt_dt = 0.0f;
     for (int g = 0; g < GROUPS_PER_MODULE; g++) {
@@ -308,7 +444,7 @@ static void sim_inject_data(sensor_snapshot_t *snap, uint32_t t_ms) {
     }
 
     /* Voltage drops under fault */
-    snap->pack_voltage_v = 332.8f - progress * 15.0f;
+    snap->pack_voltage_v = SIM_PACK_V(332.8f - progress * 15.0f);
     snap->pack_current_a = 60.0f + progress * 40.0f;
 
     /* Adjacent modules 4 & 6 warm via thermal coupling */
@@ -320,7 +456,7 @@ static void sim_inject_data(sensor_snapshot_t *snap, uint32_t t_ms) {
 
   /* ---- Scenario 5: Short Circuit (150-165s) ---- */
   if (t_s < 165.0f) {
-    snap->pack_voltage_v = 280.0f;
+    snap->pack_voltage_v = SIM_PACK_V(280.0f);
     snap->pack_current_a = 400.0f;
     snap->short_circuit = true;
 
@@ -342,7 +478,7 @@ static void sim_inject_data(sensor_snapshot_t *snap, uint32_t t_ms) {
   if (t_s < 185.0f) {
     float progress = (t_s - 165.0f) / 20.0f;
 
-    snap->pack_voltage_v = 280.0f + progress * 52.8f;
+    snap->pack_voltage_v = SIM_PACK_V(280.0f + progress * 52.8f);
     snap->pack_current_a = 400.0f - progress * 340.0f;
     snap->short_circuit = false;
 
@@ -377,108 +513,521 @@ static void sim_inject_data(sensor_snapshot_t *snap, uint32_t t_ms) {
   snap->temp_ambient_c = 38.0f;
 }
 
+#if !HAL_HOST_MODE
+/* -----------------------------------------------------------------------
+ * Apply a telemetry config frame from the dashboard
+ * ----------------------------------------------------------------------- */
+static void apply_telemetry_config(const input_tel_config_frame_t *cf) {
+  uint8_t mode = cf->mode == INPUT_TEL_MODE_COMPACT ? INPUT_TEL_MODE_COMPACT
+                                                    : INPUT_TEL_MODE_LEGACY;
+
+  /* Every (re)negotiation starts the compact stream from a keyframe */
+  if (mode == INPUT_TEL_MODE_COMPACT &&
+      (g_tel_mode != mode || cf->key_interval != 0))
+    packet_compact_init(&g_tel_compact, cf->key_interval);
+  if (cf->flags & INPUT_TEL_FLAG_KEY)
+    packet_compact_request_key(&g_tel_compact);
+
+  g_tel_mode = mode;
+  g_tel_ascii = (cf->flags & INPUT_TEL_FLAG_ASCII) != 0;
+  g_tel_period_ms = (uint32_t)cf->period_100ms * 100u; /* Next med_loop */
+  g_tel_v2 = (cf->flags & INPUT_TEL_FLAG_V2) != 0;     /* Next slow_loop */
+
+  log_tel_config_args_t ev = {mode, g_tel_compact.key_interval,
+                               g_tel_ascii ? 1 : 0, g_tel_v2 ? 1 : 0,
+                               g_tel_period_ms};
+  log_emit(LOG_EV_TEL_CONFIG, &ev, sizeof(ev));
+}
+
+/* -----------------------------------------------------------------------
+ * Threshold frames from the dashboard: edits go to a staged copy, and
+ * APPLY swaps it in only if the whole set passes its check. The loops
+ * pick it up on their next pass; the state machine is not reset.
+ * ----------------------------------------------------------------------- */
+static anomaly_thresholds_t g_thresholds_staged;
+
+static void apply_threshold_command(const input_threshold_frame_t *cf) {
+  bool ok = true;
+  switch (cf->op) {
+  case INPUT_THRESHOLD_OP_SET:
+    ok = anomaly_thresholds_set(&g_thresholds_staged, cf->param,
+                                cf->value_milli) == HAL_OK;
+    break;
+  case INPUT_THRESHOLD_OP_APPLY:
+    /* Never re-tune the limits of an alarm that is already raised */
+    ok = g_corr.current_state == STATE_NORMAL &&
+         anomaly_thresholds_check(&g_thresholds_staged) == HAL_OK;
+    if (ok) {
+      g_thresholds = g_thresholds_staged;
+      thresholds_compile();
+    }
+    break;
+  case INPUT_THRESHOLD_OP_DEFAULTS:
+    anomaly_eval_init(&g_thresholds_staged);
+    break;
+  case INPUT_THRESHOLD_OP_REVERT:
+    g_thresholds_staged = g_thresholds;
+    break;
+  default:
+    ok = false;
+    break;
+  }
+
+  log_threshold_args_t ev = {cf->op, cf->param, cf->value_milli, ok ? 1 : 0,
+                             g_plan_count};
+  log_emit(LOG_EV_THRESHOLD, &ev, sizeof(ev));
+}
+#endif
+
+/* Module m keeps the raw channels of the previous publish */
+#if ANOMALY_EVAL_FIXED_POINT
+static void hold_module_data_fx(sensor_snapshot_fx_t *fx,
+                                const sensor_snapshot_fx_t *prev, int m) {
+  const module_data_fx_t *pm = &prev->modules[m];
+  fx->modules[m].ntc1_dt = pm->ntc1_dt;
+  fx->modules[m].ntc2_dt = pm->ntc2_dt;
+  fx->modules[m].swelling_pct = pm->swelling_pct;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    VPLANE_MV(&fx->vplane, m, g) = VPLANE_MV(&prev->vplane, m, g);
+}
+#else
+static void hold_module_data(sensor_snapshot_t *snap,
+                             const sensor_snapshot_t *prev, int m) {
+  const module_data_t *pm = &prev->modules[m];
+  snap->modules[m].ntc1_c = pm->ntc1_c;
+  snap->modules[m].ntc2_c = pm->ntc2_c;
+  snap->modules[m].swelling_pct = pm->swelling_pct;
+  memcpy(snap->modules[m].group_voltages_v, pm->group_voltages_v,
+         sizeof(pm->group_voltages_v));
+}
+#endif
+
 /* -----------------------------------------------------------------------
  * Apply external input frames to snapshot
+ *
+ * Modules in `reuse` keep the raw data of the previous publish (`prev`,
+ * the front slot): their RX slot may hold a frame that failed mid-way,
+ * or the sender is refreshing them at the slow rate. Only `stale` (a
+ * subset) is flagged as degraded.
  * ----------------------------------------------------------------------- */
 static void apply_external_input(sensor_snapshot_t *snap,
-                                 const input_rx_state_t *rx) {
-  const input_pack_frame_t *pf = &rx->last_pack;
-
-  snap->pack_voltage_v = pf->pack_voltage_dv / 10.0f;
-  snap->pack_current_a = pf->pack_current_da / 10.0f;
-  snap->temp_ambient_c = pf->ambient_temp_dt / 10.0f;
-  snap->coolant_inlet_c = pf->coolant_inlet_dt / 10.0f;
-  snap->coolant_outlet_c = pf->coolant_outlet_dt / 10.0f;
-  snap->gas_ratio_1 = pf->gas_ratio_1_cp / 100.0f;
-  snap->gas_ratio_2 = pf->gas_ratio_2_cp / 100.0f;
-  snap->pressure_delta_1_hpa = pf->pressure_delta_1_chpa / 100.0f;
-  snap->pressure_delta_2_hpa = pf->pressure_delta_2_chpa / 100.0f;
-  snap->humidity_pct = (float)pf->humidity_pct;
-  snap->isolation_mohm = pf->isolation_mohm / 10.0f;
+                                 const input_rx_state_t *rx,
+                                 module_mask_t reuse, module_mask_t stale,
+                                 const sensor_snapshot_t *prev) {
+#if ANOMALY_EVAL_FIXED_POINT
+  /* Same frames, no conversion: the fixed-point twin is in wire units */
+  sensor_snapshot_fx_t *fx = snapshot_fx_of(snap);
+  const sensor_snapshot_fx_t *pfx = snapshot_fx_of(prev);
+  input_decode_pack_fx(fx, &rx->last_pack);
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    if (reuse & MODULE_BIT(m))
+      hold_module_data_fx(fx, pfx, m);
+    else
+      input_decode_module_fx(fx, m, &rx->last_modules[m]);
+  }
+  fx->stale_modules = stale;
+#else
+  input_decode_pack(snap, &rx->last_pack);
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    if (reuse & MODULE_BIT(m))
+      hold_module_data(snap, prev, m);
+    else
+      input_decode_module(snap, m, &rx->last_modules[m]);
+  }
+  snap->stale_modules = stale;
+#endif
+}
 
-  for (int m = 0; m < NUM_MODULES; m++) {
-    const input_module_frame_t *mf = &rx->last_modules[m];
+/* -----------------------------------------------------------------------
+ * Snapshot hand-off
+ *
+ * Writers start from the rates med_loop last computed (the sim may
+ * override dT/dt); the evaluator pins the newest slot once per pass.
+ * ----------------------------------------------------------------------- */
+static sensor_snapshot_t *snapshot_write_begin(void) {
+  sensor_snapshot_t *back = snapshot_begin_write(&g_snapbuf);
+  if (back) {
+#if ANOMALY_EVAL_FIXED_POINT
+    sensor_snapshot_fx_t *fx = snapshot_fx_of(back);
+    fx->stale_modules = 0;
+    for (int m = 0; m < NUM_MODULES; m++) {
+      fx->modules[m].max_dt_dt_ddpm = g_module_dt_dt_ddpm[m];
+    }
+#else
+    back->dr_dt_mohm_per_s = g_dr_dt_mohm_per_s;
+    back->stale_modules = 0;
+    for (int m = 0; m < NUM_MODULES; m++) {
+      back->modules[m].max_dt_dt = g_module_dt_dt[m];
+    }
+#endif
+  }
+  return back;
+}
 
-    snap->modules[m].ntc1_c = mf->ntc1_dt / 10.0f;
-    snap->modules[m].ntc2_c = mf->ntc2_dt / 10.0f;
-    snap->modules[m].swelling_pct = (float)mf->swelling_pct;
+#if !HAL_HOST_MODE
+/* Publish the cycle the RX parser assembled, reusing the previous data
+ * of the `reuse` modules (`stale` ones flagged). Returns false if the
+ * evaluator still holds the back slot — the frames are kept and the
+ * next pass retries. */
+static bool publish_external_input(module_mask_t reuse, module_mask_t stale) {
+  const sensor_snapshot_t *prev = &g_snapbuf.slot[g_snapbuf.front];
+  sensor_snapshot_t *back = snapshot_write_begin();
+  if (!back)
+    return false;
+  apply_external_input(back, &g_input_rx, reuse, stale, prev);
+  snapshot_publish(&g_snapbuf, g_input_rx.modules_received);
+  input_rx_reset_cycle(&g_input_rx);
+  g_external_input_active = 1;
+  g_last_external_ms = g_uptime_ms;
+  return true;
+}
+#endif
 
-    /* Decode group voltages from base + delta */
-    float base_v = mf->v_base_mv / 1000.0f;
-    for (int g = 0; g < GROUPS_PER_MODULE; g++) {
-      snap->modules[m].group_voltages_v[g] = base_v + mf->v_delta[g] / 1000.0f;
+/* A short-circuit trip already opened the relay; make the fast loop
+ * run its full correlation pass on this scheduler pass */
+static void on_safety_trip(float current_a) {
+  sched_trigger(&g_sched, g_task_fast, g_uptime_ms);
+  log_trip_args_t ev = {log_event_q(current_a, 1.0f)};
+  log_emit(LOG_EV_TRIP, &ev, sizeof(ev));
+}
+
+static void snapshot_publish_sim(uint32_t t_ms) {
+  const sensor_snapshot_t *prev = &g_snapbuf.slot[g_snapbuf.front];
+  sensor_snapshot_t *back = snapshot_write_begin();
+  if (back) {
+    sim_inject_data(back, t_ms);
+    /* Module channels at each module's own rate; pack channels (the
+     * trip current among them) every pass */
+    module_mask_t due =
+        module_cadence_due(&g_cad_acquire, &g_rate, g_uptime_ms,
+                           MED_LOOP_NORMAL_MS, MED_LOOP_ALERT_MS);
+#if ANOMALY_EVAL_FIXED_POINT
+    /* The sim sets dT/dt itself; held modules come from the twin, which
+     * an external cycle may have written last */
+    sensor_snapshot_fx_t *fx = snapshot_fx_of(back);
+    anomaly_snapshot_to_fx(fx, back);
+    for (int m = 0; m < NUM_MODULES; m++) {
+      if (!(due & MODULE_BIT(m)))
+        hold_module_data_fx(fx, snapshot_fx_of(prev), m);
+    }
+#else
+    for (int m = 0; m < NUM_MODULES; m++) {
+      if (!(due & MODULE_BIT(m)))
+        hold_module_data(back, prev, m);
     }
+#endif
+    /* Treat each sim sample like an INA219 reading */
+    if (safety_trip_check_a(&g_trip, back->pack_current_a))
+      on_safety_trip(back->pack_current_a);
+    snapshot_publish(&g_snapbuf, due);
   }
+}
 
-  /* R_int and dT/dt are computed by med_loop, defaults: */
-  snap->r_internal_mohm = 0.44f;
-  snap->short_circuit = false;
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+/* Publish the on-board sensors once they have something new. A held
+ * back slot keeps the readings for the next pass. */
+static void snapshot_publish_acquired(void) {
+  if (!g_acq_ok || !g_acq.fresh)
+    return;
+  const sensor_snapshot_t *prev = &g_snapbuf.slot[g_snapbuf.front];
+  sensor_snapshot_t *back = snapshot_write_begin();
+  if (!back)
+    return;
+  module_mask_t dirty = acq_to_snapshot(&g_acq, back, prev);
+#if ANOMALY_EVAL_FIXED_POINT
+  anomaly_snapshot_to_fx_raw(snapshot_fx_of(back), back); /* Keeps dT/dt */
+#endif
+  snapshot_publish(&g_snapbuf, dirty);
+}
+#endif
+
+static void snapshot_pin(void) {
+  g_snap = snapshot_acquire(&g_snapbuf, &g_snap_seq);
+}
+
+/* -----------------------------------------------------------------------
+ * Latency instrumentation
+ * ----------------------------------------------------------------------- */
+static inline uint32_t lat_start(void) { return hal_timer_cycles(); }
+
+static void lat_stop(lat_stage_t stage, uint32_t t0) {
+  uint32_t cycles = hal_timer_cycles() - t0;
+  latency_stats_record(&g_latency, stage, cycles / HAL_TIMER_CYCLES_PER_US);
+}
+
+static void latency_init_budgets(void) {
+  latency_stats_init(&g_latency);
+  /* A loop must finish within its tightest (alert-mode) period */
+  latency_stats_set_budget(&g_latency, LAT_FAST_LOOP,
+                           FAST_LOOP_ALERT_MS * 1000u);
+  latency_stats_set_budget(&g_latency, LAT_MED_LOOP,
+                           MED_LOOP_ALERT_MS * 1000u);
+  latency_stats_set_budget(&g_latency, LAT_SLOW_LOOP,
+                           SLOW_LOOP_ALERT_MS * 1000u);
+}
+
+/* Baseline z-scores into the pinned slot. A frame is fed once, and
+ * only while the pack is NORMAL; modules that reused last-good data
+ * are not fed at all. */
+static void baseline_update(module_mask_t dirty) {
+  bool learn = g_corr.current_state == STATE_NORMAL;
+#if ANOMALY_EVAL_FIXED_POINT
+  sensor_snapshot_fx_t *fx = snapshot_fx_of(g_snap);
+  if (g_snap_seq == g_stats_seq) {
+    online_stats_export_fx(&g_stats, fx);
+    return;
+  }
+  g_stats_seq = g_snap_seq;
+  online_stats_update_fx(&g_stats, fx,
+                         (module_mask_t)(dirty & ~fx->stale_modules), learn);
+#else
+  if (g_snap_seq == g_stats_seq) {
+    online_stats_export(&g_stats, g_snap);
+    return;
+  }
+  g_stats_seq = g_snap_seq;
+  online_stats_update(&g_stats, g_snap,
+                      (module_mask_t)(dirty & ~g_snap->stale_modules), learn);
+#endif
+}
+
+/* Derived fields + category evaluation on the pinned snapshot. Only
+ * modules published since the previous evaluation are recomputed; a
+ * second pass on the same slot (fast-loop trip) just re-merges. On the
+ * trip path the evaluation stops once EMERGENCY is decided. */
+static void evaluate_snapshot(bool trip) {
+  module_mask_t dirty = snapshot_take_dirty(&g_snapbuf);
+  baseline_update(dirty);
+
+#if ANOMALY_EVAL_FIXED_POINT
+  sensor_snapshot_fx_t *fx = snapshot_fx_of(g_snap);
+  uint32_t t0 = lat_start();
+  anomaly_eval_fx_compute_incremental(fx, &g_thresholds_fx, &g_eval_fx_cache,
+                                      dirty);
+  lat_stop(LAT_EVAL_COMPUTE, t0);
+
+  t0 = lat_start();
+  g_anomaly = trip ? anomaly_eval_fx_run_trip(&g_thresholds_fx, fx)
+                   : anomaly_eval_fx_run(&g_thresholds_fx, fx);
+  lat_stop(LAT_EVAL_RUN, t0);
+#else
+  uint32_t t0 = lat_start();
+  anomaly_eval_compute_incremental(g_snap, &g_thresholds, &g_eval_cache,
+                                   dirty);
+  lat_stop(LAT_EVAL_COMPUTE, t0);
+
+  t0 = lat_start();
+  g_anomaly = trip ? anomaly_eval_run_plan_trip(&g_plan, g_snap)
+                   : anomaly_eval_run_plan(&g_plan, g_snap);
+  lat_stop(LAT_EVAL_RUN, t0);
+#endif
+}
+
+/* -----------------------------------------------------------------------
+ * Per-module rates and the request back to the input sender
+ * ----------------------------------------------------------------------- */
+static void rate_request_send(void) {
+  telemetry_rate_frame_t pkt;
+  packet_encode_rate(&pkt, g_rate.boosted, MED_LOOP_ALERT_MS,
+                     MED_LOOP_NORMAL_MS);
+  (void)hal_uart_send_async((const uint8_t *)&pkt, sizeof(pkt));
+}
+
+static void rate_update(system_state_t state) {
+  if (!module_rate_update(&g_rate, &g_anomaly, state, snapshot_short_circuit(),
+                          g_uptime_ms))
+    return;
+  int n = 0;
+  for (int m = 0; m < NUM_MODULES; m++)
+    n += (g_rate.boosted & MODULE_BIT(m)) ? 1 : 0;
+  log_rate_args_t ev = {(uint8_t)n, NUM_MODULES};
+  log_emit(LOG_EV_RATE, &ev, sizeof(ev));
+  rate_request_send(); /* Refused: the slow loop resends it */
 }
 
+/* -----------------------------------------------------------------------
+ * Black-box recorder
+ * ----------------------------------------------------------------------- */
+static void blackbox_note(system_state_t state) {
+  if (!blackbox_note_state(&g_blackbox, state))
+    return;
+  log_bbx_event_args_t ev = {g_blackbox.event, g_blackbox.unflushed};
+  log_emit(LOG_EV_BBX_EVENT, &ev, sizeof(ev));
+}
+
+#if !HAL_HOST_MODE
+static void apply_blackbox_command(const input_blackbox_frame_t *cmd) {
+  if (cmd->op == INPUT_BLACKBOX_OP_DUMP) {
+    blackbox_dump_begin(&g_blackbox, cmd->arg);
+    log_bbx_dump_args_t ev = {g_blackbox.dumping ? 1 : 0, cmd->arg};
+    log_emit(LOG_EV_BBX_DUMP, &ev, sizeof(ev));
+  } else {
+    log_bbx_status_args_t ev = {g_blackbox.events,   g_blackbox.event,
+                                g_blackbox.log_head, g_blackbox.capturing,
+                                g_blackbox.dropped,  g_blackbox.flash_errors};
+    log_emit(LOG_EV_BBX_STATUS, &ev, sizeof(ev));
+  }
+}
+
+/* Dump frames go out as the TX ring accepts them; a refused frame is
+ * kept and offered again next pass */
+static void blackbox_send_dump(void) {
+  static uint8_t frame[BLACKBOX_DUMP_MAX_FRAME];
+  static uint8_t len = 0;
+  for (int i = 0; i < 4; i++) {
+    if (len == 0)
+      len = blackbox_dump_next(&g_blackbox, frame);
+    if (len == 0 || hal_uart_send_async(frame, len) != HAL_OK)
+      return;
+    len = 0;
+  }
+}
+#endif
+
 /* -----------------------------------------------------------------------
  * FAST LOOP — Short-circuit detection (100ms / 10Hz)
  * ----------------------------------------------------------------------- */
 static void fast_loop(void) {
-  float abs_i = g_snapshot.pack_current_a;
-  if (abs_i < 0)
-    abs_i = -abs_i;
-
-  if (abs_i > 350.0f) {
-    g_snapshot.short_circuit = true;
-    anomaly_eval_compute(&g_snapshot, &g_thresholds);
-    g_anomaly = anomaly_eval_run(&g_thresholds, &g_snapshot);
+  uint32_t t0 = lat_start();
+#if ANOMALY_EVAL_FIXED_POINT
+  sensor_snapshot_fx_t *fx = snapshot_fx_of(g_snap);
+  int32_t i = fx->pack_current_da;
+  bool over = i > g_thresholds_fx.current_short_da ||
+              i < -g_thresholds_fx.current_short_da;
+#else
+  float i = g_snap->pack_current_a;
+  bool over = i > g_plan.current_short_a || i < g_plan.current_short_neg_a;
+#endif
+
+  /* Periodic backstop; a pre-emptive trip lands here on the same pass */
+  bool tripped = safety_trip_take_pending(&g_trip);
+  if (tripped || over) {
+#if ANOMALY_EVAL_FIXED_POINT
+    fx->short_circuit = true;
+#else
+    g_snap->short_circuit = true;
+#endif
+    evaluate_snapshot(true);
     correlation_engine_update(&g_corr, &g_anomaly);
+    blackbox_note(g_corr.current_state); /* Freeze at the trip itself */
+    rate_update(g_corr.current_state);
     scheduler_apply_sampling_rates();
 
     if (g_corr.current_state == STATE_EMERGENCY) {
       hal_gpio_set_status_leds(3);
 #if !HAL_HOST_MODE
       hal_gpio_relay_disconnect();
-      hal_gpio_buzzer_pulse(1000);
+      hal_gpio_buzzer_play(BUZZER_ALARM);
 #endif
     }
   }
+
+  lat_stop(LAT_FAST_LOOP, t0);
+}
+
+/* -----------------------------------------------------------------------
+ * Sample history — one row per med-loop pass, in milli-units
+ * ----------------------------------------------------------------------- */
+#if !ANOMALY_EVAL_FIXED_POINT
+static int32_t milli(float v) {
+  return (int32_t)(v * 1000.0f + (v < 0.0f ? -0.5f : 0.5f));
+}
+#endif
+
+static void history_reset(void) {
+  history_init(&g_history);
+  g_hist_dt = history_add_window(&g_history, HIST_CH_NTC(0, 0),
+                                 2 * NUM_MODULES, HIST_DT_WINDOW_MS);
+  g_hist_dr = history_add_window(&g_history, HIST_CH_R_INT, 1,
+                                 HIST_DR_WINDOW_MS);
+}
+
+static void history_sample(void) {
+  int32_t row[HIST_NUM_CHANNELS];
+#if ANOMALY_EVAL_FIXED_POINT
+  const sensor_snapshot_fx_t *fx = snapshot_fx_of(g_snap);
+  for (int m = 0; m < NUM_MODULES; m++) {
+    row[HIST_CH_NTC(m, 0)] = fx->modules[m].ntc1_dt * 100;
+    row[HIST_CH_NTC(m, 1)] = fx->modules[m].ntc2_dt * 100;
+  }
+  row[HIST_CH_R_INT] = fx->r_internal_uohm;
+  row[HIST_CH_CURRENT] = fx->pack_current_da * 100;
+  row[HIST_CH_GAS_1] = fx->gas_ratio_1_cp * 10;
+  row[HIST_CH_GAS_2] = fx->gas_ratio_2_cp * 10;
+  row[HIST_CH_PRESSURE_1] = fx->pressure_delta_1_chpa * 10;
+  row[HIST_CH_PRESSURE_2] = fx->pressure_delta_2_chpa * 10;
+#else
+  for (int m = 0; m < NUM_MODULES; m++) {
+    row[HIST_CH_NTC(m, 0)] = milli(g_snap->modules[m].ntc1_c);
+    row[HIST_CH_NTC(m, 1)] = milli(g_snap->modules[m].ntc2_c);
+  }
+  row[HIST_CH_R_INT] = milli(g_snap->r_internal_mohm);
+  row[HIST_CH_CURRENT] = milli(g_snap->pack_current_a);
+  row[HIST_CH_GAS_1] = milli(g_snap->gas_ratio_1);
+  row[HIST_CH_GAS_2] = milli(g_snap->gas_ratio_2);
+  row[HIST_CH_PRESSURE_1] = milli(g_snap->pressure_delta_1_hpa);
+  row[HIST_CH_PRESSURE_2] = milli(g_snap->pressure_delta_2_hpa);
+#endif
+  history_push(&g_history, g_uptime_ms, row);
 }
 
 /* -----------------------------------------------------------------------
  * MED LOOP — Full evaluation + correlation (500ms / 2Hz)
  * ----------------------------------------------------------------------- */
 static void med_loop(void) {
-  /* Compute dR/dt */
-  if (g_prev_r_int_mohm > 0.0f) {
-    float dt_s = (float)g_med_loop_ms / 1000.0f;
-    if (dt_s > 0.0f) {
-      g_snapshot.dr_dt_mohm_per_s =
-          (g_snapshot.r_internal_mohm - g_prev_r_int_mohm) / dt_s;
-    }
+  uint32_t t0 = lat_start();
+
+  /* Rates over the sample history, at the times samples were taken */
+  history_sample();
+#if !ANOMALY_EVAL_FIXED_POINT
+  /* dR/dt is reported only in the float build */
+  if (history_window_count(&g_history, g_hist_dr) >= 2) {
+    g_dr_dt_mohm_per_s =
+        history_slope(&g_history, g_hist_dr, HIST_CH_R_INT) / 1000.0f;
   }
-  g_prev_r_int_mohm = g_snapshot.r_internal_mohm;
+  g_snap->dr_dt_mohm_per_s = g_dr_dt_mohm_per_s;
+#endif
 
-  /* Compute per-module dT/dt from NTC history */
-  float dt_s = (float)g_med_loop_ms / 1000.0f;
-  for (int m = 0; m < NUM_MODULES; m++) {
-    if (dt_s > 0.0f) {
-      float d1 =
-          (g_snapshot.modules[m].ntc1_c - g_prev_ntc[m][0]) / dt_s * 60.0f;
-      float d2 =
-          (g_snapshot.modules[m].ntc2_c - g_prev_ntc[m][1]) / dt_s * 60.0f;
+  if (history_window_count(&g_history, g_hist_dt) >= 2) {
+    module_mask_t due = module_cadence_due(&g_cad_rates, &g_rate, g_uptime_ms,
+                                           MED_LOOP_NORMAL_MS,
+                                           MED_LOOP_ALERT_MS);
+    for (int m = 0; m < NUM_MODULES; m++) {
+      if (!(due & MODULE_BIT(m)))
+        continue; /* Healthy module: slope kept until its next turn */
+#if ANOMALY_EVAL_FIXED_POINT
+      /* milli-°C/s × 600 → deci-°C/min */
+      int32_t d1 = history_slope_scaled(&g_history, g_hist_dt,
+                                        HIST_CH_NTC(m, 0), 600);
+      int32_t d2 = history_slope_scaled(&g_history, g_hist_dt,
+                                        HIST_CH_NTC(m, 1), 600);
+      if (d1 < 0)
+        d1 = -d1;
+      if (d2 < 0)
+        d2 = -d2;
+      int32_t d = d1 > d2 ? d1 : d2;
+      g_module_dt_dt_ddpm[m] = (int16_t)(d > INT16_MAX ? INT16_MAX : d);
+      snapshot_fx_of(g_snap)->modules[m].max_dt_dt_ddpm =
+          g_module_dt_dt_ddpm[m];
+#else
+      /* milli-°C/s → °C/min */
+      float d1 = history_slope(&g_history, g_hist_dt, HIST_CH_NTC(m, 0)) *
+                 (60.0f / 1000.0f);
+      float d2 = history_slope(&g_history, g_hist_dt, HIST_CH_NTC(m, 1)) *
+                 (60.0f / 1000.0f);
       if (d1 < 0)
         d1 = -d1;
       if (d2 < 0)
         d2 = -d2;
-      g_snapshot.modules[m].max_dt_dt = d1 > d2 ? d1 : d2;
+      g_module_dt_dt[m] = d1 > d2 ? d1 : d2;
+      g_snap->modules[m].max_dt_dt = g_module_dt_dt[m];
+#endif
     }
-    g_prev_ntc[m][0] = g_snapshot.modules[m].ntc1_c;
-    g_prev_ntc[m][1] = g_snapshot.modules[m].ntc2_c;
   }
 
-  /* Compute derived fields (voltage stats, temp stats, hotspot, core temp) */
-  anomaly_eval_compute(&g_snapshot, &g_thresholds);
-
-  /* Evaluate anomaly categories */
-  g_anomaly = anomaly_eval_run(&g_thresholds, &g_snapshot);
-
-  correlation_sync_timing_limits();
+  /* Compute derived fields (voltage stats, temp stats, hotspot, core temp)
+   * and evaluate anomaly categories */
+  evaluate_snapshot(false);
 
   /* Update correlation engine */
   system_state_t prev_state = g_corr.current_state;
@@ -487,65 +1036,204 @@ static void med_loop(void) {
 
   /* Log state transitions */
   if (new_state != prev_state) {
-    char buf[120];
-    snprintf(buf, sizeof(buf),
-             "[STATE] %s -> %s (cats=%d, hotspot=M%d, risk=%d%%)%s\r\n",
-             correlation_state_name(prev_state),
-             correlation_state_name(new_state), g_anomaly.active_count,
-             g_anomaly.hotspot_module, (int)(g_anomaly.risk_factor * 100),
-             g_anomaly.is_emergency_direct ? " [DIRECT]" : "");
-    hal_uart_print(buf);
+    log_state_args_t ev = {(uint8_t)prev_state,
+                           (uint8_t)new_state,
+                           g_anomaly.active_count,
+                           g_anomaly.hotspot_module,
+                           anomaly_risk_pct(),
+                           g_anomaly.is_emergency_direct ? 1 : 0};
+    log_emit(LOG_EV_STATE, &ev, sizeof(ev));
   }
 
+  rate_update(new_state);
+
+  /* One record per pass; a rise to CRITICAL/EMERGENCY starts an event */
+  blackbox_note(new_state);
+#if ANOMALY_EVAL_FIXED_POINT
+  blackbox_record_fx(&g_blackbox, g_uptime_ms, snapshot_fx_of(g_snap),
+                     &g_anomaly, new_state);
+#else
+  blackbox_record(&g_blackbox, g_uptime_ms, g_snap, &g_anomaly, new_state);
+#endif
+
   /* Update status LEDs */
   hal_gpio_set_status_leds((uint8_t)new_state);
 
   /* EMERGENCY actions */
   if (new_state == STATE_EMERGENCY) {
 #if !HAL_HOST_MODE
+    /* Both return at once; the alarm keeps its phase across passes */
     hal_gpio_relay_disconnect();
-    hal_gpio_buzzer_pulse(500);
+    hal_gpio_buzzer_play(BUZZER_ALARM);
 #else
     if (new_state != prev_state) {
       printf("[HAL] RELAY TRIGGERED — Battery DISCONNECTED\n");
     }
 #endif
+  } else if (prev_state == STATE_EMERGENCY) {
+    hal_gpio_buzzer_stop(); /* Latch released */
   }
 
   scheduler_apply_sampling_rates();
+
+  lat_stop(LAT_MED_LOOP, t0);
+}
+
+/* -----------------------------------------------------------------------
+ * Telemetry output — v1 frames straight to the TX ring, or batched into
+ * v2 superframes (one per ring write) when negotiated
+ * ----------------------------------------------------------------------- */
+static hal_status_t tel_flush(void) {
+  uint16_t len = packet_super_finish(&g_tel_super);
+  hal_status_t st = len ? hal_uart_send_async(g_tel_super.buf, len) : HAL_OK;
+  packet_super_begin(&g_tel_super, g_tel_super.seq); /* Same cycle */
+  return st;
+}
+
+static hal_status_t tel_send(const void *frame, uint8_t len) {
+  if (!g_tel_v2)
+    return hal_uart_send_async((const uint8_t *)frame, len);
+  if (packet_super_add(&g_tel_super, (const uint8_t *)frame))
+    return HAL_OK;
+  hal_status_t st = tel_flush();
+  (void)packet_super_add(&g_tel_super, (const uint8_t *)frame);
+  return st;
 }
 
 /* -----------------------------------------------------------------------
  * SLOW LOOP — Multi-frame telemetry output (5s / 0.2Hz)
  * ----------------------------------------------------------------------- */
 static void slow_loop(void) {
-  /* Send pack summary frame */
-  telemetry_pack_frame_t pack_pkt;
-  packet_encode_pack(&pack_pkt, g_uptime_ms, &g_snapshot, &g_anomaly,
-                     g_corr.current_state);
-  hal_uart_send((const uint8_t *)&pack_pkt, sizeof(pack_pkt));
+  uint32_t t0 = lat_start();
 
-  /* Send 8 module detail frames */
-  for (int m = 0; m < NUM_MODULES; m++) {
-    telemetry_module_frame_t mod_pkt;
-    packet_encode_module(&mod_pkt, (uint8_t)m, &g_snapshot);
-    hal_uart_send((const uint8_t *)&mod_pkt, sizeof(mod_pkt));
-  }
-
-  /* Human-readable debug line */
-  char buf[200];
-  snprintf(buf, sizeof(buf),
-           "[TEL] t=%lums V=%.0f I=%.0f Tmax=%.1f dT/dt=%.2f "
-           "gas=[%.2f,%.2f] dP=[%.1f,%.1f] state=%s cats=%d "
-           "hot=M%d risk=%d%% stg=%s\r\n",
-           (unsigned long)g_uptime_ms, g_snapshot.pack_voltage_v,
-           g_snapshot.pack_current_a, g_snapshot.hotspot_temp_c,
-           g_snapshot.dt_dt_max, g_snapshot.gas_ratio_1, g_snapshot.gas_ratio_2,
-           g_snapshot.pressure_delta_1_hpa, g_snapshot.pressure_delta_2_hpa,
-           correlation_state_name(g_corr.current_state), g_anomaly.active_count,
-           g_anomaly.hotspot_module, (int)(g_anomaly.risk_factor * 100),
-           cascade_stage_name(g_anomaly.cascade_stage));
-  hal_uart_print(buf);
+  /* Frames are queued into the TX ring and drained by the UART ISR.
+   * If the ring is still full from the previous burst, the frame is
+   * dropped rather than stalling the loop — the next cycle resends. */
+
+  bool send_latency = true;
+  bool lost = false; /* A frame of this cycle was refused */
+  module_mask_t grp_sent = 0;
+#if ANOMALY_EVAL_FIXED_POINT
+  const sensor_snapshot_fx_t *fx = snapshot_fx_of(g_snap);
+#endif
+
+  packet_super_begin(&g_tel_super, g_tel_cycle_seq++);
+
+  if (g_tel_mode == INPUT_TEL_MODE_COMPACT) {
+    /* Changed fields only; a dropped frame forces the next keyframe.
+     * Latency windows ride along with keyframes. */
+    uint8_t frame[PACKET_COMPACT_MAX_SIZE];
+    uint8_t len;
+#if ANOMALY_EVAL_FIXED_POINT
+    packet_compact_begin_fx(&g_tel_compact, g_uptime_ms, fx, &g_anomaly,
+                            g_corr.current_state);
+#else
+    packet_compact_begin(&g_tel_compact, g_uptime_ms, g_snap, &g_anomaly,
+                         g_corr.current_state);
+#endif
+    while ((len = packet_compact_next(&g_tel_compact, frame)) > 0) {
+      if (tel_send(frame, len) != HAL_OK)
+        lost = true;
+    }
+    send_latency = g_tel_compact.key;
+  } else {
+    /* Send pack summary frame */
+    telemetry_pack_frame_t pack_pkt;
+#if ANOMALY_EVAL_FIXED_POINT
+    packet_encode_pack_fx(&pack_pkt, g_uptime_ms, fx, &g_anomaly,
+                          g_corr.current_state);
+#else
+    packet_encode_pack(&pack_pkt, g_uptime_ms, g_snap, &g_anomaly,
+                       g_corr.current_state);
+#endif
+    (void)tel_send(&pack_pkt, sizeof(pack_pkt));
+
+    /* Detail frames at each module's own rate */
+    module_mask_t due = module_cadence_due(&g_cad_tel, &g_rate, g_uptime_ms,
+                                           g_slow_normal_ms, g_slow_loop_ms);
+    for (int m = 0; m < NUM_MODULES; m++) {
+      if (!(due & MODULE_BIT(m)))
+        continue;
+      telemetry_module_frame_t mod_pkt;
+#if ANOMALY_EVAL_FIXED_POINT
+      packet_encode_module_fx(&mod_pkt, (uint8_t)m, fx);
+#else
+      packet_encode_module(&mod_pkt, (uint8_t)m, g_snap);
+#endif
+      (void)tel_send(&mod_pkt, sizeof(mod_pkt));
+    }
+  }
+
+  /* Group voltages of flagged modules, on change and rate limited. A
+   * frame the TX ring refuses is retried next cycle. */
+  telemetry_group_frame_t grp[PACKET_GROUPS_MAX_PER_CYCLE];
+#if ANOMALY_EVAL_FIXED_POINT
+  uint8_t n_grp = packet_groups_poll_fx(&g_tel_groups, g_uptime_ms, fx,
+                                        g_anomaly.anomaly_modules_mask, grp);
+#else
+  uint8_t n_grp = packet_groups_poll(&g_tel_groups, g_uptime_ms, g_snap,
+                                     g_anomaly.anomaly_modules_mask, grp);
+#endif
+  for (uint8_t i = 0; i < n_grp; i++) {
+    grp_sent |= MODULE_BIT(grp[i].module_index);
+    if (tel_send(&grp[i], sizeof(grp[i])) != HAL_OK)
+      lost = true;
+  }
+
+  /* Send per-stage latency frames, then open a new window */
+  if (send_latency) {
+    for (int st = 0; st < LAT_NUM_STAGES; st++) {
+      telemetry_latency_frame_t lat_pkt;
+      packet_encode_latency(&lat_pkt, (uint8_t)st, &g_latency.stage[st]);
+      (void)tel_send(&lat_pkt, sizeof(lat_pkt));
+    }
+    latency_stats_reset_window(&g_latency);
+  }
+
+  /* A refused superframe may have held any frame of the cycle, so the
+   * stateful streams recover as if all of them were lost */
+  if (tel_flush() != HAL_OK)
+    lost = true;
+  if (lost) {
+    packet_compact_request_key(&g_tel_compact);
+    g_tel_groups.pending |= grp_sent;
+  }
+
+  /* Refresh the rate request for a sender that missed it */
+  if (g_external_input_active)
+    rate_request_send();
+
+  /* [TEL] debug line (optional — a 33 B event per cycle) */
+  if (g_tel_ascii) {
+    log_tel_args_t ev = {
+#if ANOMALY_EVAL_FIXED_POINT
+        log_event_qi(fx->pack_voltage_dv, 10),
+        log_event_qi(fx->pack_current_da, 10),
+        fx->hotspot_temp_dt,
+        (int32_t)fx->dt_dt_max_ddpm * 10,
+        {log_event_qi(fx->gas_ratio_1_cp, 1),
+         log_event_qi(fx->gas_ratio_2_cp, 1)},
+        {log_event_qi(fx->pressure_delta_1_chpa, 10),
+         log_event_qi(fx->pressure_delta_2_chpa, 10)},
+#else
+        log_event_q(g_snap->pack_voltage_v, 1.0f),
+        log_event_q(g_snap->pack_current_a, 1.0f),
+        log_event_q(g_snap->hotspot_temp_c, 10.0f),
+        log_event_q32(g_snap->dt_dt_max, 100.0f),
+        {log_event_q(g_snap->gas_ratio_1, 100.0f),
+         log_event_q(g_snap->gas_ratio_2, 100.0f)},
+        {log_event_q(g_snap->pressure_delta_1_hpa, 10.0f),
+         log_event_q(g_snap->pressure_delta_2_hpa, 10.0f)},
+#endif
+        (uint8_t)g_corr.current_state,
+        g_anomaly.active_count,
+        g_anomaly.hotspot_module,
+        anomaly_risk_pct(),
+        g_anomaly.cascade_stage};
+    log_emit(LOG_EV_TEL, &ev, sizeof(ev));
+  }
+
+  lat_stop(LAT_SLOW_LOOP, t0);
 }
 
 /* -----------------------------------------------------------------------
@@ -554,23 +1242,77 @@ static void slow_loop(void) {
 static void system_init(void) {
   hal_gpio_init();
   hal_uart_init();
+  hal_timer_init(SCHED_TICK_MS);
   anomaly_eval_init(&g_thresholds);
+  online_stats_init(&g_stats);
+#if ANOMALY_EVAL_FIXED_POINT
+  memset(g_snap_fx, 0, sizeof(g_snap_fx));
+#endif
+  safety_trip_init(&g_trip, &g_thresholds);
+  g_plan_count = 0;
+  thresholds_compile();
+#if !HAL_HOST_MODE
+  g_thresholds_staged = g_thresholds;
+#endif
   correlation_engine_init(&g_corr);
   memset(&g_anomaly, 0, sizeof(g_anomaly));
-  memset(&g_snapshot, 0, sizeof(g_snapshot));
-  memset(g_prev_ntc, 0, sizeof(g_prev_ntc));
+  snapshot_buffer_init(&g_snapbuf);
+  g_snap = &g_snapbuf.slot[0];
+#if ANOMALY_EVAL_FIXED_POINT
+  memset(g_module_dt_dt_ddpm, 0, sizeof(g_module_dt_dt_ddpm));
+#else
+  g_dr_dt_mohm_per_s = 0.0f;
+  memset(g_module_dt_dt, 0, sizeof(g_module_dt_dt));
+#endif
+  history_reset();
+  latency_init_budgets();
+  packet_compact_init(&g_tel_compact, 0);
+  packet_groups_init(&g_tel_groups, 0);
+  (void)hal_flash_init();
+  blackbox_init(&g_blackbox);
+  log_event_init(&g_log);
+  module_rate_init(&g_rate);
+  module_cadence_init(&g_cad_acquire);
+  module_cadence_init(&g_cad_rates);
+  module_cadence_init(&g_cad_tel);
+
+  g_uptime_ms = hal_timer_millis();
+#if !HAL_HOST_MODE && ACQUIRE_SENSORS
+  g_acq_ok = acq_init(&g_acq, FAST_LOOP_NORMAL_MS, MED_LOOP_NORMAL_MS,
+                      g_uptime_ms) == HAL_OK;
+  if (!g_acq_ok)
+    hal_uart_print("[ACQ] Sensor bus or NTC scan setup failed\r\n");
+#endif
+  sched_init(&g_sched);
+  g_task_fast =
+      sched_add(&g_sched, fast_loop, FAST_LOOP_NORMAL_MS, 0, g_uptime_ms);
+  g_task_med =
+      sched_add(&g_sched, med_loop, MED_LOOP_NORMAL_MS, 1, g_uptime_ms);
+  g_task_slow =
+      sched_add(&g_sched, slow_loop, SLOW_LOOP_NORMAL_MS, 2, g_uptime_ms);
   scheduler_reset();
   hal_gpio_set_safety_armed(false);
 
   hal_uart_print("====================================================\r\n");
   hal_uart_print("  EV Battery Intelligence — Firmware v2.0 (Full Pack)\r\n");
-  hal_uart_print("  104S8P | 832 Cells | 139 Sensor Channels\r\n");
+  {
+    /* Per group: 1 voltage; per module: 2 NTCs + swelling; 11 pack-level */
+    char banner[64];
+    snprintf(banner, sizeof(banner),
+             "  %dS%dP | %d Cells | %d Sensor Channels\r\n", TOTAL_SERIES,
+             CELLS_PER_GROUP, TOTAL_SERIES * CELLS_PER_GROUP,
+             TOTAL_SERIES + 3 * NUM_MODULES + 11);
+    hal_uart_print(banner);
+  }
   hal_uart_print("  Thermal Runaway Prevention System\r\n");
 #if HAL_HOST_MODE
   hal_uart_print("  Mode: HOST SIMULATION\r\n");
 #else
   hal_uart_print("  Mode: BOARD (VSDSquadron ULTRA / THEJAS32)\r\n");
   hal_uart_print("  Demo: Digital Twin → Correlation Engine → UART\r\n");
+#if ACQUIRE_SENSORS
+  hal_uart_print("  Fallback: on-board sensors (INA219, 2x BME680, NTC)\r\n");
+#endif
 #endif
   hal_uart_print(
       "====================================================\r\n\r\n");
@@ -594,34 +1336,28 @@ int main(void) {
   /* ---- HOST: Run through all scenarios instantly ---- */
   uint32_t total_ms = SIM_DURATION_S * 1000;
 
-  printf("Running %ds full-pack simulation (7 scenarios, 8 modules)...\n\n",
-         SIM_DURATION_S);
+  printf("Running %ds full-pack simulation (7 scenarios, %d modules)...\n\n",
+         SIM_DURATION_S, NUM_MODULES);
 
-  g_uptime_ms = 0;
+  g_uptime_ms = hal_timer_millis();
+  g_demo_start_ms = g_uptime_ms;
   scheduler_reset();
 
-  /* Initialize NTC history */
-  sim_inject_data(&g_snapshot, 0);
-  for (int m = 0; m < NUM_MODULES; m++) {
-    g_prev_ntc[m][0] = g_snapshot.modules[m].ntc1_c;
-    g_prev_ntc[m][1] = g_snapshot.modules[m].ntc2_c;
-  }
-
-  for (; g_uptime_ms <= total_ms; g_uptime_ms += SCHED_TICK_MS) {
-    sim_inject_data(&g_snapshot, g_uptime_ms);
-
-    if (g_uptime_ms >= g_next_fast_ms) {
-      fast_loop();
-      g_next_fast_ms = g_uptime_ms + g_fast_loop_ms;
-    }
-    if (g_uptime_ms >= g_next_med_ms) {
-      med_loop();
-      g_next_med_ms = g_uptime_ms + g_med_loop_ms;
-    }
-    if (g_uptime_ms >= g_next_slow_ms) {
-      slow_loop();
-      g_next_slow_ms = g_uptime_ms + g_slow_loop_ms;
-    }
+  /* Seed the sample history */
+  snapshot_publish_sim(0);
+  snapshot_pin();
+  history_sample();
+  snapshot_release(&g_snapbuf);
+
+  while ((g_uptime_ms = hal_timer_millis()) - g_demo_start_ms <= total_ms) {
+    snapshot_publish_sim(g_uptime_ms - g_demo_start_ms);
+    snapshot_pin();
+    (void)sched_run_due(&g_sched, g_uptime_ms);
+    snapshot_release(&g_snapbuf);
+    hal_gpio_actuators_poll();
+    blackbox_poll(&g_blackbox);
+
+    hal_timer_idle(); /* Host: advance the simulated clock one tick */
   }
 
   printf("\nSimulation complete. Final state: %s\n",
@@ -636,80 +1372,148 @@ int main(void) {
   }
 
   /* Boot LED sequence */
-  hal_gpio_set_status_leds(0);
-  for (volatile uint32_t d = 0; d < 500000; d++) {
-  }
-  hal_gpio_set_status_leds(1);
-  for (volatile uint32_t d = 0; d < 500000; d++) {
-  }
-  hal_gpio_set_status_leds(2);
-  for (volatile uint32_t d = 0; d < 500000; d++) {
+  for (uint8_t led = 0; led < 3; led++) {
+    hal_gpio_set_status_leds(led);
+    uint32_t t0 = hal_timer_millis();
+    while (hal_timer_millis() - t0 < BOOT_LED_STEP_MS) {
+      hal_timer_idle();
+    }
   }
   hal_gpio_set_status_leds(0);
 
   hal_uart_print("Starting full-pack demo loop...\r\n\r\n");
   input_rx_init(&g_input_rx);
 
-  /* Initialize NTC history */
-  sim_inject_data(&g_snapshot, 0);
-  for (int m = 0; m < NUM_MODULES; m++) {
-    g_prev_ntc[m][0] = g_snapshot.modules[m].ntc1_c;
-    g_prev_ntc[m][1] = g_snapshot.modules[m].ntc2_c;
-  }
+  g_uptime_ms = hal_timer_millis();
+  g_demo_start_ms = g_uptime_ms;
+  scheduler_reset();
+
+  /* Seed the sample history */
+  snapshot_publish_sim(0);
+  snapshot_pin();
+  history_sample();
+  snapshot_release(&g_snapbuf);
 
   while (1) {
-    /* Poll UART RX for multi-frame input from digital twin */
+    g_uptime_ms = hal_timer_millis();
+
+#if ACQUIRE_SENSORS
+    /* Sensor jobs, one bus transaction per pass. The measured current
+     * trips the relay whatever the input source. */
+    if (g_acq_ok && (acq_poll(&g_acq, g_uptime_ms) & ACQ_GOT_CURRENT) &&
+        safety_trip_check_a(&g_trip, g_acq.pack_current_a))
+      on_safety_trip(g_acq.pack_current_a);
+#endif
+
+    /* Drain the UART RX ring (filled by the ISR) into the frame parser */
     {
-      int b;
-      while ((b = hal_uart_recv_byte()) >= 0) {
-        int rx_result = input_rx_feed(&g_input_rx, (uint8_t)b);
-        if (rx_result == 2) {
-          /* Complete snapshot received — apply to g_snapshot */
-          apply_external_input(&g_snapshot, &g_input_rx);
-          input_rx_reset_cycle(&g_input_rx);
-          g_external_input_active = 1;
-          g_last_external_ms = g_uptime_ms;
+      uint8_t rx_chunk[32];
+      uint16_t n;
+      input_rx_set_clock(&g_input_rx, g_uptime_ms);
+      while ((n = hal_uart_recv_into(rx_chunk, sizeof(rx_chunk))) > 0) {
+        for (uint16_t i = 0; i < n; i++) {
+          int rx_result = input_rx_feed(&g_input_rx, rx_chunk[i]);
+
+          /* Trip on the frame that carries the pack spike, before the
+           * remaining module frames arrive */
+          if (rx_result && (g_input_rx.frame_contents & INPUT_GOT_PACK) &&
+              safety_trip_check_da(&g_trip,
+                                   g_input_rx.last_pack.pack_current_da)) {
+            on_safety_trip(g_input_rx.last_pack.pack_current_da / 10.0f);
+          }
+
+          if (rx_result && (g_input_rx.frame_contents & INPUT_GOT_CONFIG))
+            apply_telemetry_config(&g_input_rx.last_tel_config);
+
+          if (rx_result && (g_input_rx.frame_contents & INPUT_GOT_BLACKBOX))
+            apply_blackbox_command(&g_input_rx.last_blackbox);
+
+          if (rx_result && (g_input_rx.frame_contents & INPUT_GOT_THRESHOLD))
+            apply_threshold_command(&g_input_rx.last_threshold);
+
+          /* Complete snapshot received — fill and publish the back slot */
+          module_mask_t held;
+          if (rx_result == 2)
+            (void)publish_external_input(0, 0);
+          else if (rx_result && g_rate.boosted &&
+                   input_rx_subset_ready(&g_input_rx, g_rate.boosted,
+                                         g_uptime_ms, INPUT_STALE_MAX_AGE_MS,
+                                         &held))
+            (void)publish_external_input(held, 0); /* Per rate request */
         }
       }
+
+      /* A cycle still short of modules after the wait goes out with the
+       * missing ones' last-good data, flagged stale, instead of stalling
+       * until the input timeout. Only once external input is live, so
+       * reused data is never the sim's. */
+      module_mask_t stale;
+      if (g_external_input_active &&
+          input_rx_partial_ready(&g_input_rx, g_uptime_ms,
+                                 INPUT_PARTIAL_WAIT_MS,
+                                 INPUT_STALE_MAX_AGE_MS, &stale))
+        (void)publish_external_input(stale, stale);
     }
 
-    /* Use external input or fall back to internal sim */
+    /* Use external input or fall back to the sensors (or internal sim) */
     if (g_external_input_active &&
         (g_uptime_ms - g_last_external_ms) < EXTERNAL_INPUT_TIMEOUT_MS) {
-      /* External data already in g_snapshot */
+      /* External data already published */
     } else {
+#if ACQUIRE_SENSORS
+      if (g_external_input_active) {
+        g_external_input_active = 0;
+        hal_uart_print("[EXT] Input timeout — reverting to sensors\r\n");
+      }
+      snapshot_publish_acquired();
+#else
       if (g_external_input_active) {
         g_external_input_active = 0;
         hal_uart_print("[EXT] Input timeout — reverting to sim\r\n");
       }
-      sim_inject_data(&g_snapshot, g_uptime_ms);
-    }
-
-    /* Run scheduler */
-    if (g_uptime_ms >= g_next_fast_ms) {
-      fast_loop();
-      g_next_fast_ms = g_uptime_ms + g_fast_loop_ms;
-    }
-    if (g_uptime_ms >= g_next_med_ms) {
-      med_loop();
-      g_next_med_ms = g_uptime_ms + g_med_loop_ms;
-    }
-    if (g_uptime_ms >= g_next_slow_ms) {
-      slow_loop();
-      g_next_slow_ms = g_uptime_ms + g_slow_loop_ms;
+      snapshot_publish_sim(g_uptime_ms - g_demo_start_ms);
+#endif
     }
 
-    g_uptime_ms += SCHED_TICK_MS;
-
-    if (g_uptime_ms > (uint32_t)(SIM_DURATION_S * 1000)) {
-      g_uptime_ms = 0;
+    /* Run scheduler on one consistent snapshot */
+    snapshot_pin();
+    (void)sched_run_due(&g_sched, g_uptime_ms);
+    snapshot_release(&g_snapbuf);
+
+    /* Buzzer phases and relay settling; every tick wakes this loop */
+    hal_gpio_actuators_poll();
+
+    /* Flash log writes and any dump in progress, one step per pass */
+    blackbox_poll(&g_blackbox);
+    blackbox_send_dump();
+
+    /* Debug events queued by the loops, as the TX ring frees up */
+    (void)log_event_flush(&g_log);
+
+#if !ACQUIRE_SENSORS
+    /* The demo loop restarts only the simulated pack: while real data
+     * is coming in its clock is held, so a latched alarm or trip raised
+     * by that data is never cleared behind the operator's back, nor
+     * the moment the input times out */
+    if (g_external_input_active) {
+      g_demo_start_ms = g_uptime_ms;
+    } else if (g_uptime_ms - g_demo_start_ms >
+               (uint32_t)(SIM_DURATION_S * 1000)) {
+      g_demo_start_ms = g_uptime_ms;
       correlation_engine_reset(&g_corr);
+      hal_gpio_buzzer_stop();
+      safety_trip_clear(&g_trip);
       memset(&g_anomaly, 0, sizeof(g_anomaly));
+      module_rate_init(&g_rate);
       scheduler_reset();
       hal_uart_print("\r\n--- Restarting full-pack demo ---\r\n\r\n");
     }
+#endif
 
-    for (volatile uint32_t d = 0; d < 10000; d++) {
+    /* Sleep until the next tick or UART byte; deadlines come from the
+     * timer, so loop load no longer stretches real time */
+    if (sched_ms_until_next(&g_sched, hal_timer_millis()) > 0) {
+      hal_timer_idle();
     }
   }
 #endif
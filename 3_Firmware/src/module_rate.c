@@ -0,0 +1,60 @@
+/*
+ * module_rate.c — Per-Module Adaptive Sampling
+ */
+
+#include "module_rate.h"
+#include <string.h>
+
+void module_rate_init(module_rate_t *r) { memset(r, 0, sizeof(module_rate_t)); }
+
+bool module_rate_update(module_rate_t *r, const anomaly_result_t *anomaly,
+                        system_state_t state, bool short_circuit,
+                        uint32_t now_ms) {
+  module_mask_t suspects;
+  if (short_circuit || state >= STATE_CRITICAL) {
+    suspects = MODULE_MASK_ALL; /* Pack-level: no module to single out */
+  } else {
+    suspects = anomaly->anomaly_modules_mask;
+    /* hotspot_module is 1-based; a pack-level warning (gas, pressure)
+     * has no module of its own, the hottest one is the best guess */
+    if (anomaly->active_count > 0 && anomaly->hotspot_module > 0 &&
+        anomaly->hotspot_module <= PACK_NUM_MODULES)
+      suspects |= MODULE_BIT(anomaly->hotspot_module - 1);
+  }
+
+  module_mask_t boosted = 0;
+  for (uint8_t m = 0; m < PACK_NUM_MODULES; m++) {
+    if (suspects & MODULE_BIT(m)) {
+      r->flagged_ms[m] = now_ms;
+      boosted |= MODULE_BIT(m);
+    } else if ((r->boosted & MODULE_BIT(m)) &&
+               now_ms - r->flagged_ms[m] < MODULE_RATE_HOLD_MS) {
+      boosted |= MODULE_BIT(m);
+    }
+  }
+
+  r->flagged = suspects;
+  bool changed = boosted != r->boosted;
+  r->boosted = boosted;
+  return changed;
+}
+
+void module_cadence_init(module_cadence_t *c) {
+  memset(c, 0, sizeof(module_cadence_t));
+}
+
+module_mask_t module_cadence_due(module_cadence_t *c, const module_rate_t *r,
+                                 uint32_t now_ms, uint32_t normal_ms,
+                                 uint32_t alert_ms) {
+  module_mask_t due = 0;
+  for (uint8_t m = 0; m < PACK_NUM_MODULES; m++) {
+    module_mask_t bit = MODULE_BIT(m);
+    uint32_t period = (r->boosted & bit) ? alert_ms : normal_ms;
+    if (!(c->seen & bit) || now_ms - c->last_ms[m] >= period) {
+      c->last_ms[m] = now_ms;
+      due |= bit;
+    }
+  }
+  c->seen |= due;
+  return due;
+}
@@ -0,0 +1,62 @@
+/*
+ * module_rate.h — Per-Module Adaptive Sampling
+ *
+ * The loop periods (main.c) carry the whole pack to the alert rate as
+ * soon as anything is flagged. Inside those loops each module keeps its
+ * own cadence: the suspects — modules in anomaly_modules_mask, plus the
+ * hotspot — are acquired, differentiated and reported every alert
+ * period; the healthy ones stay at the normal period. Only a
+ * pack-level alarm (short circuit, CRITICAL or above) boosts them all.
+ *
+ * A boost outlives its flag by MODULE_RATE_HOLD_MS so a module flickering
+ * across a threshold does not flap between rates.
+ *
+ * The boosted set goes back up the link (PACKET_TYPE_RATE) so the twin
+ * or a front-end can send only those modules' frames at the fast rate.
+ */
+
+#ifndef MODULE_RATE_H
+#define MODULE_RATE_H
+
+#include "anomaly_eval.h"
+#include "correlation_engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MODULE_RATE_HOLD_MS 5000 /* Boost kept after the flag clears */
+
+typedef struct {
+  module_mask_t boosted;                   /* At the alert rate        */
+  module_mask_t flagged;                   /* Suspects on last update  */
+  uint32_t flagged_ms[PACK_NUM_MODULES];   /* Last time flagged        */
+} module_rate_t;
+
+/* When each module was last serviced by one consumer (acquisition,
+ * dT/dt, telemetry each keep their own) */
+typedef struct {
+  uint32_t last_ms[PACK_NUM_MODULES];
+  module_mask_t seen; /* Serviced at least once */
+} module_cadence_t;
+
+void module_rate_init(module_rate_t *r);
+
+/*
+ * Update the boosted set from one evaluation. Returns true when it
+ * changed (the caller re-sends the rate request).
+ */
+bool module_rate_update(module_rate_t *r, const anomaly_result_t *anomaly,
+                        system_state_t state, bool short_circuit,
+                        uint32_t now_ms);
+
+void module_cadence_init(module_cadence_t *c);
+
+/*
+ * Modules due at now_ms: boosted ones every alert_ms, the rest every
+ * normal_ms, anything never serviced at once. The returned modules are
+ * marked serviced.
+ */
+module_mask_t module_cadence_due(module_cadence_t *c, const module_rate_t *r,
+                                 uint32_t now_ms, uint32_t normal_ms,
+                                 uint32_t alert_ms);
+
+#endif /* MODULE_RATE_H */
@@ -0,0 +1,73 @@
+/*
+ * ntc_lut.c — Table-Based NTC Conversion
+ */
+
+#include "ntc_lut.h"
+#include "ntc_lut_table.h"
+#include <string.h>
+
+/* The table must come from the parameters in ntc_lut.h */
+_Static_assert(NTC_LUT_GEN_R_NOMINAL == (long)NTC_R_NOMINAL &&
+                   NTC_LUT_GEN_T_NOMINAL == (long)NTC_T_NOMINAL &&
+                   NTC_LUT_GEN_BETA == (long)NTC_BETA &&
+                   NTC_LUT_GEN_R_SERIES == (long)NTC_R_SERIES &&
+                   NTC_LUT_GEN_ADC_MAX == NTC_ADC_MAX &&
+                   NTC_LUT_GEN_SHIFT == NTC_LUT_SHIFT,
+               "ntc_lut_table.h is stale: run target/gen_ntc_table.py");
+_Static_assert(sizeof(ntc_lut_table) / sizeof(ntc_lut_table[0]) ==
+                   NTC_LUT_ENTRIES,
+               "NTC table size");
+
+#define NTC_LUT_STEP (1 << NTC_LUT_SHIFT)
+
+/* -----------------------------------------------------------------------
+ * Conversion
+ * ----------------------------------------------------------------------- */
+int16_t ntc_lut_temp_dc(uint16_t adc_raw) {
+  if (adc_raw == 0 || adc_raw >= NTC_ADC_MAX)
+    return NTC_TEMP_INVALID_DC; /* Open or short circuit */
+
+  uint16_t k = adc_raw >> NTC_LUT_SHIFT;
+  int32_t frac = adc_raw & (NTC_LUT_STEP - 1);
+  int32_t lo = ntc_lut_table[k];
+  int32_t d = ntc_lut_table[k + 1] - lo; /* ≤ 0: NTC falls as T rises */
+
+  /* Round to nearest, symmetric for either sign of d */
+  int32_t num = d * frac;
+  int32_t step = num >= 0 ? (num + NTC_LUT_STEP / 2) / NTC_LUT_STEP
+                          : -((-num + NTC_LUT_STEP / 2) / NTC_LUT_STEP);
+  return (int16_t)(lo + step);
+}
+
+/* -----------------------------------------------------------------------
+ * Calibration
+ * ----------------------------------------------------------------------- */
+void ntc_cal_init(ntc_cal_t *cal) { memset(cal, 0, sizeof(ntc_cal_t)); }
+
+bool ntc_cal_capture(ntc_cal_t *cal, uint8_t sensor, const uint16_t *adc,
+                     uint16_t n, int16_t reference_dc) {
+  if (sensor >= NTC_CAL_MAX_SENSORS || n == 0)
+    return false;
+
+  int32_t sum = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    int16_t t = ntc_lut_temp_dc(adc[i]);
+    if (t == NTC_TEMP_INVALID_DC)
+      return false;
+    sum += t;
+  }
+
+  /* Rounded mean, then the trim that brings it onto the reference */
+  int32_t mean = (sum >= 0 ? sum + n / 2 : sum - n / 2) / n;
+  int32_t offset = reference_dc - mean;
+  if (offset > NTC_CAL_MAX_OFFSET_DC || offset < -NTC_CAL_MAX_OFFSET_DC)
+    return false;
+  cal->offset_dc[sensor] = (int16_t)offset;
+  return true;
+}
+
+int16_t ntc_cal_apply(const ntc_cal_t *cal, uint8_t sensor, int16_t temp_dc) {
+  if (temp_dc == NTC_TEMP_INVALID_DC || sensor >= NTC_CAL_MAX_SENSORS)
+    return temp_dc;
+  return (int16_t)(temp_dc + cal->offset_dc[sensor]);
+}
@@ -0,0 +1,76 @@
+/*
+ * ntc_lut.h — Table-Based NTC Conversion (12-bit ADC → deci-°C)
+ *
+ * The B-parameter equation costs a divide, a logf and two reciprocals
+ * per sample — all soft-float on the THEJAS32. This converts with one
+ * table lookup and an integer interpolation instead:
+ *
+ *   T(adc) = table[adc >> 4] + (table[(adc >> 4) + 1] - table[adc >> 4])
+ *                              × (adc & 15) / 16
+ *
+ * The 257-entry table (514 B of flash) is generated from the
+ * parameters below by target/gen_ntc_table.py, which the target build
+ * runs; the checked-in ntc_lut_table.h records the parameters it was
+ * made from and ntc_lut.c refuses to build if they no longer match.
+ *
+ * Accuracy against the equation: ≤ 0.1 °C from −20 to 100 °C (one
+ * wire LSB), ≤ 0.25 °C from −40 to 150 °C.
+ *
+ * Results are in deci-°C, the unit of the input frames and of the
+ * fixed-point evaluator.
+ */
+
+#ifndef NTC_LUT_H
+#define NTC_LUT_H
+
+#include "pack_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* NTC thermistor parameters (10kΩ NTC, B=3950) */
+#define NTC_R_NOMINAL 10000.0f /* Resistance at 25°C */
+#define NTC_T_NOMINAL 25.0f    /* Reference temperature */
+#define NTC_BETA 3950.0f       /* B coefficient */
+#define NTC_R_SERIES 10000.0f  /* Series resistor (10kΩ pullup) */
+
+/* Divider: 3.3V → [R_SERIES] → [ADC pin] → [NTC] → GND, 12-bit ADC */
+#define NTC_ADC_MAX 4095
+
+#define NTC_LUT_SHIFT 4 /* ADC codes per entry = 16 */
+#define NTC_LUT_ENTRIES ((4096 >> NTC_LUT_SHIFT) + 1)
+
+#define NTC_TEMP_INVALID_DC (-9990) /* Open or shorted sensor (-999.0 °C) */
+
+/* Convert a raw ADC code; NTC_TEMP_INVALID_DC at either rail */
+int16_t ntc_lut_temp_dc(uint16_t adc_raw);
+
+/* -----------------------------------------------------------------------
+ * Per-sensor calibration (6_Validation/Calibration_Method.md, step 2)
+ *
+ * With the pack soaked at a known temperature (thermal chamber or the
+ * ambient reference at equilibrium), capture a run of steady raw codes
+ * from each sensor; its offset is the reference minus the mean of its
+ * converted samples. Offsets are applied after the table lookup.
+ * ----------------------------------------------------------------------- */
+
+#define NTC_CAL_MAX_SENSORS (2 * PACK_NUM_MODULES + 1) /* + ambient */
+#define NTC_CAL_MAX_OFFSET_DC 50 /* A larger error is a fault, not a trim */
+
+typedef struct {
+  int16_t offset_dc[NTC_CAL_MAX_SENSORS];
+} ntc_cal_t;
+
+/* All offsets zero */
+void ntc_cal_init(ntc_cal_t *cal);
+
+/* Derive the offset of `sensor` from n steady samples taken at
+ * reference_dc. Returns false (offset unchanged) for an unknown sensor,
+ * no samples, a sample at a rail, or an offset beyond
+ * NTC_CAL_MAX_OFFSET_DC. */
+bool ntc_cal_capture(ntc_cal_t *cal, uint8_t sensor, const uint16_t *adc,
+                     uint16_t n, int16_t reference_dc);
+
+/* Apply the offset of `sensor`; invalid readings pass through */
+int16_t ntc_cal_apply(const ntc_cal_t *cal, uint8_t sensor, int16_t temp_dc);
+
+#endif /* NTC_LUT_H */
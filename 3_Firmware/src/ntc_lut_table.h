@@ -0,0 +1,43 @@
+/*
+ * ntc_lut_table.h — NTC ADC → deci-°C Table (generated)
+ *
+ * Generated by target/gen_ntc_table.py from ntc_lut.h; do not edit.
+ * Entry k is the temperature at ADC code 16·k (the rails clamped
+ * to codes 1 and 4094). Included by ntc_lut.c only.
+ */
+
+#define NTC_LUT_GEN_R_NOMINAL 10000
+#define NTC_LUT_GEN_T_NOMINAL 25
+#define NTC_LUT_GEN_BETA 3950
+#define NTC_LUT_GEN_R_SERIES 10000
+#define NTC_LUT_GEN_ADC_MAX 4095
+#define NTC_LUT_GEN_SHIFT 4
+
+static const int16_t ntc_lut_table[257] = {
+    5279, 2393, 1968, 1750, 1607, 1501, 1418, 1350, 1293, 1244,
+    1200, 1162, 1127, 1096, 1067, 1041, 1016, 993, 972, 951,
+    933, 915, 898, 881, 866, 851, 837, 824, 811, 798,
+    786, 774, 763, 752, 742, 732, 722, 712, 703, 694,
+    685, 676, 668, 659, 651, 644, 636, 628, 621, 614,
+    607, 600, 593, 586, 580, 573, 567, 561, 554, 548,
+    542, 537, 531, 525, 520, 514, 509, 503, 498, 493,
+    487, 482, 477, 472, 467, 462, 457, 453, 448, 443,
+    439, 434, 429, 425, 420, 416, 412, 407, 403, 399,
+    394, 390, 386, 382, 378, 374, 369, 365, 361, 357,
+    353, 350, 346, 342, 338, 334, 330, 326, 323, 319,
+    315, 311, 308, 304, 300, 296, 293, 289, 286, 282,
+    278, 275, 271, 268, 264, 260, 257, 253, 250, 246,
+    243, 239, 236, 232, 229, 225, 222, 219, 215, 212,
+    208, 205, 201, 198, 194, 191, 187, 184, 181, 177,
+    174, 170, 167, 163, 160, 156, 153, 150, 146, 143,
+    139, 136, 132, 129, 125, 122, 118, 115, 111, 108,
+    104, 100, 97, 93, 90, 86, 82, 79, 75, 71,
+    68, 64, 60, 56, 53, 49, 45, 41, 37, 33,
+    29, 25, 22, 17, 13, 9, 5, 1, -3, -7,
+    -12, -16, -20, -25, -29, -34, -38, -43, -47, -52,
+    -57, -62, -67, -72, -77, -82, -87, -92, -98, -103,
+    -109, -114, -120, -126, -132, -138, -145, -151, -158, -165,
+    -172, -179, -186, -194, -202, -210, -219, -228, -237, -246,
+    -257, -267, -278, -290, -303, -317, -331, -347, -365, -384,
+    -406, -432, -462, -500, -552, -636, -900,
+};
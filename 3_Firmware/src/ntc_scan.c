@@ -0,0 +1,129 @@
+/*
+ * ntc_scan.c — Background NTC MUX Scan Engine
+ */
+
+#include "ntc_scan.h"
+#include "hal_adc.h"
+#include "hal_gpio.h"
+#include "hal_timer.h"
+#include <string.h>
+
+#define SETTLE_CYCLES (NTC_SCAN_SETTLE_US * HAL_TIMER_CYCLES_PER_US)
+#define SAMPLE_CYCLES (ADC_SAMPLE_US * HAL_TIMER_CYCLES_PER_US)
+
+static void select_slot(ntc_scan_t *s, uint8_t slot) {
+  hal_gpio_mux_select(s->slots[slot].mux_addr);
+  s->sel = slot;
+  s->sel_cyc = hal_timer_cycles();
+}
+
+hal_status_t ntc_scan_init(ntc_scan_t *s, const ntc_scan_slot_t *slots,
+                           uint8_t num_slots, uint16_t period_ms) {
+  if (num_slots == 0 || num_slots > NTC_SCAN_MAX_SLOTS)
+    return HAL_ERROR;
+
+  memset(s, 0, sizeof(ntc_scan_t));
+  s->slots = slots;
+  s->num_slots = num_slots;
+  s->period_ms = period_ms;
+  for (uint8_t i = 0; i < num_slots; i++)
+    s->latest[i].temp_dc = NTC_TEMP_INVALID_DC;
+
+  /* Due at once */
+  s->sweep_ms = hal_timer_millis() - period_ms;
+  select_slot(s, 0);
+  return HAL_OK;
+}
+
+void ntc_scan_set_callback(ntc_scan_t *s, ntc_scan_cb_t cb, void *ctx) {
+  s->on_sample = cb;
+  s->cb_ctx = ctx;
+}
+
+static void deliver(ntc_scan_t *s, int16_t raw) {
+  ntc_sample_t *out = &s->latest[s->conv];
+  out->t_ms = s->conv_ms;
+  if (raw < 0) {
+    out->raw = 0;
+    out->temp_dc = NTC_TEMP_INVALID_DC;
+  } else {
+    out->raw = (uint16_t)raw;
+    out->temp_dc = ntc_lut_temp_dc(out->raw);
+    if (s->cal)
+      out->temp_dc = ntc_cal_apply(s->cal, s->conv, out->temp_dc);
+  }
+
+  if (s->conv + 1u == s->num_slots) {
+    s->in_sweep = false;
+    s->sweeps++;
+  }
+  if (s->on_sample)
+    s->on_sample(s->cb_ctx, s->conv, out);
+}
+
+void ntc_scan_poll(ntc_scan_t *s) {
+  uint32_t now = hal_timer_cycles();
+
+  /* Hold capacitor has the input: move the MUX on, so the next channel
+   * settles while this one converts. After the last slot it parks on
+   * slot 0 for the next sweep. A result is only collected once the
+   * MUX has moved, so the order holds however late this poll runs. */
+  if (s->advance && now - s->conv_cyc >= SAMPLE_CYCLES) {
+    s->advance = false;
+    select_slot(s, (uint8_t)((s->conv + 1u) % s->num_slots));
+  }
+
+  if (s->converting && !s->advance && hal_adc_ready()) {
+    s->converting = false;
+    deliver(s, hal_adc_result());
+  }
+
+  if (!s->in_sweep && !s->converting && !s->advance &&
+      hal_timer_millis() - s->sweep_ms >= s->period_ms) {
+    s->in_sweep = true;
+    s->sweep_ms = hal_timer_millis();
+  }
+
+  if (s->in_sweep && !s->converting && !s->advance &&
+      now - s->sel_cyc >= SETTLE_CYCLES) {
+    if (hal_adc_start(s->slots[s->sel].adc_channel) == HAL_OK) {
+      s->converting = true;
+      s->advance = true;
+      s->conv = s->sel;
+      s->conv_cyc = hal_timer_cycles();
+      s->conv_ms = hal_timer_millis();
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Pack layout
+ * ----------------------------------------------------------------------- */
+uint8_t ntc_scan_pack_layout(ntc_scan_slot_t *slots) {
+  for (uint8_t i = 0; i < NTC_SCAN_PACK_SLOTS; i++) {
+    slots[i].adc_channel = i < NTC_SCAN_BANK_SIZE ? ADC_CHANNEL_MUX_OUT
+                                                  : ADC_CHANNEL_MUX2_OUT;
+    slots[i].mux_addr = i % NTC_SCAN_BANK_SIZE;
+  }
+  return NTC_SCAN_PACK_SLOTS;
+}
+
+uint32_t ntc_scan_to_snapshot(const ntc_scan_t *s, sensor_snapshot_t *snap) {
+  uint32_t invalid = 0;
+  uint8_t n = s->num_slots < NTC_SCAN_PACK_SLOTS ? s->num_slots
+                                                 : NTC_SCAN_PACK_SLOTS;
+  for (uint8_t i = 0; i < n; i++) {
+    int16_t dc = s->latest[i].temp_dc;
+    uint8_t m = i / 2;
+    if (dc == NTC_TEMP_INVALID_DC) {
+      invalid |= 1u << m;
+      continue;
+    }
+    float c = (float)dc * 0.1f;
+    if (i & 1)
+      snap->modules[m].ntc2_c = c;
+    else
+      snap->modules[m].ntc1_c = c;
+  }
+  return invalid;
+}
@@ -0,0 +1,116 @@
+/*
+ * ntc_scan.h — Background NTC MUX Scan Engine
+ *
+ * Scans a list of MUX-fed NTC channels without ever waiting inside a
+ * call. ntc_scan_poll() is cheap and is called from the main loop on
+ * every pass; it advances a small pipeline:
+ *
+ *   select ch k ─ settle ─ start ADC ─ (S/H closed) ─ select ch k+1
+ *                                     └── convert k ──┘  ├ settle k+1
+ *                                          result k ─────┘
+ *
+ * so channel k+1 settles while channel k converts, and a sweep of N
+ * channels costs about N × max(settle, conversion) of wall time and
+ * almost none of CPU time. Between sweeps the MUX is parked on the
+ * first channel, already settled for the next one.
+ *
+ * A sweep starts every period_ms (or as soon as the previous one ends,
+ * if that is later). Each result is converted (ntc_lut), calibrated,
+ * stamped with the millisecond it was sampled, stored per slot and
+ * handed to the optional completion callback.
+ *
+ * Settle time: a CD4051 switch (~125 Ω) into the ADC hold capacitor
+ * through the divider's 5 kΩ source impedance needs a few µs; 10 µs
+ * leaves margin. Timing uses hal_timer_cycles(), so it is exact to the
+ * cycle rather than to a calibrated spin loop.
+ */
+
+#ifndef NTC_SCAN_H
+#define NTC_SCAN_H
+
+#include "anomaly_eval.h"
+#include "hal_platform.h"
+#include "ntc_lut.h"
+
+#define NTC_SCAN_MAX_SLOTS 32
+#define NTC_SCAN_SETTLE_US 10 /* MUX switch to stable ADC input      */
+#define NTC_SCAN_BANK_SIZE 8  /* CD4051 channels per ADC input       */
+
+/* One scanned thermistor: which ADC input, which MUX address */
+typedef struct {
+  uint8_t adc_channel;
+  uint8_t mux_addr;
+} ntc_scan_slot_t;
+
+typedef struct {
+  int16_t temp_dc; /* Calibrated; NTC_TEMP_INVALID_DC on a rail or ADC error */
+  uint16_t raw;    /* ADC code (0 on ADC error)                             */
+  uint32_t t_ms;   /* hal_timer_millis() when the input was sampled         */
+} ntc_sample_t;
+
+/* Called from ntc_scan_poll() as each conversion completes */
+typedef void (*ntc_scan_cb_t)(void *ctx, uint8_t slot,
+                              const ntc_sample_t *sample);
+
+typedef struct {
+  const ntc_scan_slot_t *slots;
+  uint8_t num_slots;
+  uint16_t period_ms;
+  const ntc_cal_t *cal; /* Offsets by slot index, or NULL */
+  ntc_scan_cb_t on_sample;
+  void *cb_ctx;
+
+  ntc_sample_t latest[NTC_SCAN_MAX_SLOTS];
+  uint32_t sweeps; /* Completed sweeps */
+
+  /* Pipeline */
+  bool in_sweep;
+  uint8_t sel;       /* Slot the MUX is on                       */
+  uint32_t sel_cyc;  /* When it was switched there               */
+  bool converting;
+  bool advance;      /* MUX still to move on for this conversion */
+  uint8_t conv;      /* Slot being converted                     */
+  uint32_t conv_cyc; /* Conversion start                         */
+  uint32_t conv_ms;
+  uint32_t sweep_ms; /* Start of the current/last sweep          */
+} ntc_scan_t;
+
+/*
+ * Set up a scan over `slots` (copied by reference — must outlive the
+ * scan) and select the first channel. The first sweep starts at the
+ * next poll. Returns HAL_ERROR for an empty or oversized list.
+ */
+hal_status_t ntc_scan_init(ntc_scan_t *scan, const ntc_scan_slot_t *slots,
+                           uint8_t num_slots, uint16_t period_ms);
+
+/* Completion callback (NULL to remove) */
+void ntc_scan_set_callback(ntc_scan_t *scan, ntc_scan_cb_t cb, void *ctx);
+
+/* Advance the pipeline; never waits */
+void ntc_scan_poll(ntc_scan_t *scan);
+
+/* -----------------------------------------------------------------------
+ * Pack layout
+ *
+ * The two NTCs of module m are slots 2m and 2m+1. Slots fill CD4051
+ * banks of eight in order: bank 0 on ADC_CHANNEL_MUX_OUT, bank 1 on
+ * ADC_CHANNEL_MUX2_OUT, sharing the S0-S2 select lines. That covers 16
+ * NTCs (the 8-module pack); larger profiles take module temperatures
+ * from the twin-fed frames, so only their first 8 modules are scanned.
+ * ----------------------------------------------------------------------- */
+
+#define NTC_SCAN_PACK_SLOTS                                                    \
+  (2 * PACK_NUM_MODULES < 2 * NTC_SCAN_BANK_SIZE ? 2 * PACK_NUM_MODULES       \
+                                                 : 2 * NTC_SCAN_BANK_SIZE)
+
+/* Fill NTC_SCAN_PACK_SLOTS slots; returns the count */
+uint8_t ntc_scan_pack_layout(ntc_scan_slot_t *slots);
+
+/*
+ * Copy the latest pack-layout readings into snap->modules[].ntc1_c /
+ * ntc2_c. Invalid readings leave the field untouched; the return value
+ * has bit m set for each module with an invalid reading.
+ */
+uint32_t ntc_scan_to_snapshot(const ntc_scan_t *scan, sensor_snapshot_t *snap);
+
+#endif /* NTC_SCAN_H */
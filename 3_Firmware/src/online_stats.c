@@ -0,0 +1,183 @@
+/*
+ * online_stats.c — Learned Per-Channel Baselines (Welford + EWMA)
+ */
+
+#include "online_stats.h"
+#include <math.h>
+#include <string.h>
+
+/* -----------------------------------------------------------------------
+ * One channel
+ *
+ * Returns z² carrying the sign of the drift, so callers can take the
+ * worst channel of a module with compares and a single sqrtf.
+ * ----------------------------------------------------------------------- */
+static float channel_feed(ostats_channel_t *c, float x, float sd_floor,
+                          bool learn) {
+  if (c->n == 0) {
+    c->mean = x;
+    c->ewma = x;
+    c->var = 0.0f;
+    c->n = learn ? 1 : 0;
+    return 0.0f;
+  }
+
+  c->ewma += OSTATS_EWMA_ALPHA * (x - c->ewma);
+
+  float d = c->ewma - c->mean;
+  float var = c->var > sd_floor * sd_floor ? c->var : sd_floor * sd_floor;
+  float z2 = d * d / var;
+
+  /* Welford step in variance form: var += (d0·(x - mean') - var) / n.
+   * With n held at OSTATS_BASELINE_N it is an exponential window. */
+  if (learn &&
+      (c->n < OSTATS_MIN_N || z2 < OSTATS_LEARN_Z * OSTATS_LEARN_Z)) {
+    if (c->n < OSTATS_BASELINE_N)
+      c->n++;
+    float d0 = x - c->mean;
+    c->mean += d0 / (float)c->n;
+    c->var += (d0 * (x - c->mean) - c->var) / (float)c->n;
+  }
+
+  if (c->n < OSTATS_MIN_N)
+    return 0.0f; /* Baseline still forming */
+  return d < 0.0f ? -z2 : z2;
+}
+
+/* -----------------------------------------------------------------------
+ * Public API
+ * ----------------------------------------------------------------------- */
+void online_stats_init(online_stats_t *st) {
+  memset(st, 0, sizeof(online_stats_t));
+}
+
+/* One module's channels: group offsets from the module mean (mV) and
+ * NTC offsets from the pack mean (°C) */
+static void feed_module(online_stats_t *st, int m,
+                        const float dev_mv[GROUPS_PER_MODULE], float ntc1,
+                        float ntc2, bool learn) {
+  float worst = 0.0f;
+  ostats_channel_t *grp = &st->group[m * GROUPS_PER_MODULE];
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    float z2 = channel_feed(&grp[g], dev_mv[g], OSTATS_V_SD_FLOOR_MV, learn);
+    if (z2 < 0.0f)
+      z2 = -z2;
+    if (z2 > worst)
+      worst = z2;
+  }
+  st->v_dev_z[m] = sqrtf(worst);
+
+  worst = 0.0f;
+  float z2 = channel_feed(&st->ntc[2 * m], ntc1, OSTATS_NTC_SD_FLOOR_C, learn);
+  if (z2 > worst)
+    worst = z2;
+  z2 = channel_feed(&st->ntc[2 * m + 1], ntc2, OSTATS_NTC_SD_FLOOR_C, learn);
+  if (z2 > worst)
+    worst = z2;
+  st->ntc_z[m] = sqrtf(worst);
+}
+
+/* Gas: a falling ratio is the alarm direction */
+static void feed_gas(online_stats_t *st, float ratio_1, float ratio_2,
+                     bool learn) {
+  float worst = 0.0f;
+  float z2 = -channel_feed(&st->gas[0], ratio_1, OSTATS_GAS_SD_FLOOR, learn);
+  if (z2 > worst)
+    worst = z2;
+  z2 = -channel_feed(&st->gas[1], ratio_2, OSTATS_GAS_SD_FLOOR, learn);
+  if (z2 > worst)
+    worst = z2;
+  st->gas_z = sqrtf(worst);
+}
+
+void online_stats_update(online_stats_t *st, sensor_snapshot_t *s,
+                         module_mask_t modules, bool learn) {
+  float ntc_mean = 0.0f;
+  for (int m = 0; m < NUM_MODULES; m++)
+    ntc_mean += s->modules[m].ntc1_c + s->modules[m].ntc2_c;
+  ntc_mean /= (float)(2 * NUM_MODULES);
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    if (!(modules & MODULE_BIT(m)))
+      continue;
+    const module_data_t *mod = &s->modules[m];
+
+    /* Own mean: the stats run before anomaly_eval_compute */
+    float v_mean = 0.0f;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      v_mean += mod->group_voltages_v[g];
+    v_mean /= (float)GROUPS_PER_MODULE;
+
+    float dev_mv[GROUPS_PER_MODULE];
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      dev_mv[g] = (mod->group_voltages_v[g] - v_mean) * 1000.0f;
+    feed_module(st, m, dev_mv, mod->ntc1_c - ntc_mean, mod->ntc2_c - ntc_mean,
+                learn);
+  }
+  feed_gas(st, s->gas_ratio_1, s->gas_ratio_2, learn);
+
+  online_stats_export(st, s);
+}
+
+void online_stats_export(const online_stats_t *st, sensor_snapshot_t *s) {
+  for (int m = 0; m < NUM_MODULES; m++) {
+    s->modules[m].v_dev_z = st->v_dev_z[m];
+    s->modules[m].ntc_z = st->ntc_z[m];
+  }
+  s->gas_z = st->gas_z;
+}
+
+/* -----------------------------------------------------------------------
+ * Fixed-point snapshot
+ *
+ * Offsets are taken in integers, scaled by the number of readings in
+ * the mean, and converted once per channel; the channels themselves
+ * are the float ones above.
+ * ----------------------------------------------------------------------- */
+
+void online_stats_update_fx(online_stats_t *st, sensor_snapshot_fx_t *s,
+                            module_mask_t modules, bool learn) {
+  int32_t ntc_sum = 0;
+  for (int m = 0; m < NUM_MODULES; m++)
+    ntc_sum += s->modules[m].ntc1_dt + s->modules[m].ntc2_dt;
+  const float ntc_scale = 1.0f / (10.0f * (float)(2 * NUM_MODULES));
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    if (!(modules & MODULE_BIT(m)))
+      continue;
+    const module_data_fx_t *mod = &s->modules[m];
+
+    int32_t v_sum = 0;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      v_sum += VPLANE_MV(&s->vplane, m, g);
+
+    float dev_mv[GROUPS_PER_MODULE];
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      dev_mv[g] = (float)(GROUPS_PER_MODULE * VPLANE_MV(&s->vplane, m, g) -
+                          v_sum) /
+                  (float)GROUPS_PER_MODULE;
+    feed_module(st, m, dev_mv,
+                (float)(2 * NUM_MODULES * mod->ntc1_dt - ntc_sum) * ntc_scale,
+                (float)(2 * NUM_MODULES * mod->ntc2_dt - ntc_sum) * ntc_scale,
+                learn);
+  }
+  feed_gas(st, (float)s->gas_ratio_1_cp / 100.0f,
+           (float)s->gas_ratio_2_cp / 100.0f, learn);
+
+  online_stats_export_fx(st, s);
+}
+
+/* z in σ × 10, rounded; z is never negative */
+static int16_t z_to_dz(float z) {
+  float v = z * 10.0f + 0.5f;
+  return v >= 32767.0f ? 32767 : (int16_t)v;
+}
+
+void online_stats_export_fx(const online_stats_t *st,
+                            sensor_snapshot_fx_t *s) {
+  for (int m = 0; m < NUM_MODULES; m++) {
+    s->modules[m].v_dev_dz = z_to_dz(st->v_dev_z[m]);
+    s->modules[m].ntc_dz = z_to_dz(st->ntc_z[m]);
+  }
+  s->gas_dz = z_to_dz(st->gas_z);
+}
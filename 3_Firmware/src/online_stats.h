@@ -0,0 +1,97 @@
+/*
+ * online_stats.h — Learned Per-Channel Baselines (Welford + EWMA)
+ *
+ * The fixed thresholds in anomaly_eval_init() are the same for every
+ * pack. This learns what normal looks like for this one: a running
+ * mean and variance per group voltage, per NTC and per gas channel,
+ * and how far each channel's recent level has drifted from it, in
+ * standard deviations. A quiet group that starts creeping off its
+ * usual offset is then flagged against its own spread, not the 15 mV
+ * the noisiest pack needs.
+ *
+ * Per channel, O(1) per sample, no history:
+ *
+ *   baseline  Welford mean / variance. The count saturates at
+ *             OSTATS_BASELINE_N; past that the same update forgets
+ *             exponentially, so ageing and seasons are followed.
+ *   recent    EWMA of the reading (OSTATS_EWMA_ALPHA), which keeps a
+ *             single noisy sample from counting as drift.
+ *   z         (recent - baseline mean) / baseline sd, with the sd
+ *             floored at OSTATS_*_SD_FLOOR (about two wire LSBs).
+ *
+ * Channels are chosen so that normal operation does not move them:
+ *
+ *   group voltage  offset from its module's mean (mV) — charge and
+ *                  load move every group together
+ *   NTC            offset from the pack's mean NTC (°C) — only a
+ *                  module running hotter than the rest counts
+ *   gas            the BME680 ratio itself — the learned baseline
+ *                  takes over from bme680_reset_baseline()
+ *
+ * Baselines only learn while the caller says so (NORMAL state) and
+ * while the channel is within OSTATS_LEARN_Z, so a fault that
+ * develops slowly is not learned as the new normal. The EWMA always
+ * follows the input.
+ *
+ * Outputs are written to the snapshot's computed fields: v_dev_z and
+ * ntc_z per module (worst channel), gas_z for the pack, or their σ × 10
+ * twins in the fixed-point snapshot. Voltage is
+ * two-sided; NTC counts only hotter and gas only lower readings.
+ * They are checked against baseline_z_warning by the evaluators.
+ */
+
+#ifndef ONLINE_STATS_H
+#define ONLINE_STATS_H
+
+#include "anomaly_eval_fx.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define OSTATS_EWMA_ALPHA 0.1f  /* Recent level: ~10 samples           */
+#define OSTATS_BASELINE_N 2048  /* Baseline memory (~17 min at 2 Hz)   */
+#define OSTATS_MIN_N 60         /* No z output until this many samples */
+#define OSTATS_LEARN_Z 3.0f     /* Channel stops learning beyond this  */
+
+#define OSTATS_V_SD_FLOOR_MV 1.5f
+#define OSTATS_NTC_SD_FLOOR_C 0.2f
+#define OSTATS_GAS_SD_FLOOR 0.02f
+
+typedef struct {
+  float mean;  /* Baseline                                  */
+  float var;   /* Baseline variance                         */
+  float ewma;  /* Recent level                              */
+  uint16_t n;  /* Baseline samples, saturates at _BASELINE_N */
+} ostats_channel_t;
+
+typedef struct {
+  ostats_channel_t group[TOTAL_SERIES];
+  ostats_channel_t ntc[2 * NUM_MODULES];
+  ostats_channel_t gas[2];
+  /* Last outputs, re-exported for modules not fed on a pass */
+  float v_dev_z[NUM_MODULES];
+  float ntc_z[NUM_MODULES];
+  float gas_z;
+} online_stats_t;
+
+/* Forget everything; baselines are relearned from the next sample */
+void online_stats_init(online_stats_t *st);
+
+/*
+ * Feed one published frame: the raw fields of `modules` (those with new
+ * data) and the pack-level gas channels. Baselines learn only when
+ * `learn` is set. Writes the z outputs into `s`.
+ */
+void online_stats_update(online_stats_t *st, sensor_snapshot_t *s,
+                         module_mask_t modules, bool learn);
+
+/* Write the last z outputs into `s` without feeding it (a slot that was
+ * already fed, or re-evaluated off the fast-loop trip path) */
+void online_stats_export(const online_stats_t *st, sensor_snapshot_t *s);
+
+/* The same on the fixed-point snapshot; the z outputs are written as
+ * σ × 10 (v_dev_dz, ntc_dz, gas_dz) */
+void online_stats_update_fx(online_stats_t *st, sensor_snapshot_fx_t *s,
+                            module_mask_t modules, bool learn);
+void online_stats_export_fx(const online_stats_t *st, sensor_snapshot_fx_t *s);
+
+#endif /* ONLINE_STATS_H */
@@ -0,0 +1,99 @@
+/*
+ * pack_config.h — Compile-Time Pack Geometry
+ *
+ * Everything sized by the pack (snapshot arrays, module masks, RX
+ * slots, telemetry mask bytes) is derived from the three numbers
+ * below, so a larger pack is a rebuild, not a code change, and every
+ * buffer stays statically sized.
+ *
+ * Selection, first match wins:
+ *   1. -DPACK_CONFIG_HEADER='"my_pack.h"' or -include my_pack.h — a
+ *      header (hand-written or generated from the pack BOM) defining
+ *      PACK_NUM_MODULES etc.
+ *   2. -DPACK_PROFILE=PACK_PROFILE_BUS_16M (or _STORAGE_24M)
+ *   3. Default: Tata Nexon EV Max, 104S8P in 8 modules
+ *
+ * The bus and storage profiles reuse the 13S8P module; only the module
+ * count and pack voltage window change.
+ */
+
+#ifndef PACK_CONFIG_H
+#define PACK_CONFIG_H
+
+#include <stdint.h>
+
+#define PACK_PROFILE_EV_8M 0      /* 104S8P, 8 × 13S8P   */
+#define PACK_PROFILE_BUS_16M 1    /* 208S8P, 16 × 13S8P  */
+#define PACK_PROFILE_STORAGE_24M 2 /* 312S8P, 24 × 13S8P  */
+
+#ifdef PACK_CONFIG_HEADER
+#include PACK_CONFIG_HEADER
+#endif
+
+#ifndef PACK_PROFILE
+#define PACK_PROFILE PACK_PROFILE_EV_8M
+#endif
+
+#ifndef PACK_NUM_MODULES
+#if PACK_PROFILE == PACK_PROFILE_EV_8M
+#define PACK_NUM_MODULES 8
+#define PACK_VOLTAGE_LOW_V 260.0f  /* 104 × 2.5V                 */
+#define PACK_VOLTAGE_HIGH_V 380.0f /* 104 × 3.65V = 379.6V ≈ 380V */
+#elif PACK_PROFILE == PACK_PROFILE_BUS_16M
+#define PACK_NUM_MODULES 16
+#define PACK_VOLTAGE_LOW_V 520.0f  /* 208 × 2.5V                 */
+#define PACK_VOLTAGE_HIGH_V 760.0f /* 208 × 3.65V = 759.2V        */
+#elif PACK_PROFILE == PACK_PROFILE_STORAGE_24M
+#define PACK_NUM_MODULES 24
+#define PACK_VOLTAGE_LOW_V 780.0f   /* 312 × 2.5V                */
+#define PACK_VOLTAGE_HIGH_V 1140.0f /* 312 × 3.65V = 1138.8V      */
+#else
+#error "Unknown PACK_PROFILE"
+#endif
+#endif
+
+#ifndef PACK_GROUPS_PER_MODULE
+#define PACK_GROUPS_PER_MODULE 13
+#endif
+
+#ifndef PACK_CELLS_PER_GROUP
+#define PACK_CELLS_PER_GROUP 8
+#endif
+
+/* LFP cell window, for custom headers that only give the geometry */
+#ifndef PACK_VOLTAGE_LOW_V
+#define PACK_VOLTAGE_LOW_V                                                     \
+  (2.5f * (float)(PACK_NUM_MODULES * PACK_GROUPS_PER_MODULE))
+#endif
+#ifndef PACK_VOLTAGE_HIGH_V
+#define PACK_VOLTAGE_HIGH_V                                                    \
+  (3.65f * (float)(PACK_NUM_MODULES * PACK_GROUPS_PER_MODULE))
+#endif
+
+#if PACK_NUM_MODULES < 1 || PACK_NUM_MODULES > 32
+#error "PACK_NUM_MODULES must be 1..32 (module masks are at most 32 bits)"
+#endif
+#if PACK_GROUPS_PER_MODULE < 1 || PACK_GROUPS_PER_MODULE > 32
+#error "PACK_GROUPS_PER_MODULE must be 1..32 (input frame length is 8-bit)"
+#endif
+
+/* -----------------------------------------------------------------------
+ * Module bitmask — the narrowest integer with one bit per module
+ * ----------------------------------------------------------------------- */
+
+#if PACK_NUM_MODULES <= 8
+typedef uint8_t module_mask_t;
+#elif PACK_NUM_MODULES <= 16
+typedef uint16_t module_mask_t;
+#else
+typedef uint32_t module_mask_t;
+#endif
+
+#define MODULE_BIT(m) ((module_mask_t)((module_mask_t)1u << (m)))
+#define MODULE_MASK_ALL                                                        \
+  ((module_mask_t)(0xFFFFFFFFu >> (32 - PACK_NUM_MODULES)))
+
+/* Bytes a module mask takes on the wire (little-endian) */
+#define PACK_MODULE_MASK_BYTES ((PACK_NUM_MODULES + 7) / 8)
+
+#endif /* PACK_CONFIG_H */
@@ -2,10 +2,15 @@
  * packet_format.c — UART Telemetry Packet Encoder (Full Pack)
  *
  * Encodes the full-pack sensor snapshot + anomaly results into
- * multi-frame telemetry packets for the dashboard.
+ * multi-frame telemetry packets for the dashboard, plus the opt-in
+ * compact keyframe/delta stream (Type 0x04) and its reference decoder,
+ * and the on-change group voltage frames for flagged modules. Each
+ * snapshot encoder has an _fx twin taking the fixed-point snapshot.
  */
 
 #include "packet_format.h"
+#include "crc16.h"
+#include <stddef.h>
 #include <string.h>
 
 /* -----------------------------------------------------------------------
@@ -47,21 +52,118 @@ static inline uint16_t clamp_u16(float v) {
   return (uint16_t)v;
 }
 
+/* Round to nearest before clamping (wire units, not truncation) */
+static inline float rnd(float v) { return v + (v < 0.0f ? -0.5f : 0.5f); }
+
+/* -----------------------------------------------------------------------
+ * Input-link frames from a snapshot
+ * ----------------------------------------------------------------------- */
+void packet_encode_input_pack(input_pack_frame_t *f,
+                              const sensor_snapshot_t *s) {
+  f->sync = INPUT_SYNC_BYTE;
+  f->length = INPUT_PACK_FRAME_SIZE;
+  f->frame_type = INPUT_TYPE_PACK;
+  f->pack_voltage_dv = clamp_u16(rnd(s->pack_voltage_v * 10.0f));
+  f->pack_current_da = clamp_i16(rnd(s->pack_current_a * 10.0f));
+  f->ambient_temp_dt = clamp_i16(rnd(s->temp_ambient_c * 10.0f));
+  f->coolant_inlet_dt = clamp_i16(rnd(s->coolant_inlet_c * 10.0f));
+  f->coolant_outlet_dt = clamp_i16(rnd(s->coolant_outlet_c * 10.0f));
+  f->gas_ratio_1_cp = clamp_u16(rnd(s->gas_ratio_1 * 100.0f));
+  f->gas_ratio_2_cp = clamp_u16(rnd(s->gas_ratio_2 * 100.0f));
+  f->pressure_delta_1_chpa = clamp_i16(rnd(s->pressure_delta_1_hpa * 100.0f));
+  f->pressure_delta_2_chpa = clamp_i16(rnd(s->pressure_delta_2_hpa * 100.0f));
+  f->humidity_pct = clamp_u8(rnd(s->humidity_pct));
+  f->isolation_mohm = clamp_u16(rnd(s->isolation_mohm * 10.0f));
+  f->checksum = packet_checksum((const uint8_t *)f, INPUT_PACK_FRAME_SIZE - 1);
+}
+
+/* Base = mean group voltage; deltas saturate at ±127 mV */
+static void input_module_end(input_module_frame_t *f,
+                             const int32_t mv[GROUPS_PER_MODULE]) {
+  int32_t sum = 0;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    sum += mv[g];
+  int32_t base = (sum + GROUPS_PER_MODULE / 2) / GROUPS_PER_MODULE;
+  f->v_base_mv = (uint16_t)base;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    int32_t d = mv[g] - base;
+    f->v_delta[g] = (int8_t)(d > 127 ? 127 : d < -127 ? -127 : d);
+  }
+  f->checksum =
+      packet_checksum((const uint8_t *)f, INPUT_MODULE_FRAME_SIZE - 1);
+}
+
+void packet_encode_input_module(input_module_frame_t *f, uint8_t m,
+                                const sensor_snapshot_t *s) {
+  const module_data_t *mod = &s->modules[m];
+
+  f->sync = INPUT_SYNC_BYTE;
+  f->length = INPUT_MODULE_FRAME_SIZE;
+  f->frame_type = INPUT_TYPE_MODULE;
+  f->module_index = m;
+  f->ntc1_dt = clamp_i16(rnd(mod->ntc1_c * 10.0f));
+  f->ntc2_dt = clamp_i16(rnd(mod->ntc2_c * 10.0f));
+  f->swelling_pct = clamp_u8(rnd(mod->swelling_pct));
+
+  int32_t mv[GROUPS_PER_MODULE];
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    mv[g] = clamp_u16(rnd(mod->group_voltages_v[g] * 1000.0f));
+  input_module_end(f, mv);
+}
+
 /* -----------------------------------------------------------------------
  * Encode pack summary frame
  * ----------------------------------------------------------------------- */
 
-uint8_t packet_encode_pack(telemetry_pack_frame_t *pkt, uint32_t timestamp_ms,
-                           const sensor_snapshot_t *sensors,
-                           const anomaly_result_t *anomaly,
-                           system_state_t state) {
+/* Header and timestamp; the caller fills the sensor fields */
+static void pack_frame_begin(telemetry_pack_frame_t *pkt,
+                             uint32_t timestamp_ms) {
   memset(pkt, 0, sizeof(telemetry_pack_frame_t));
-
   pkt->sync = PACKET_SYNC_BYTE;
   pkt->length = PACKET_PACK_SIZE;
   pkt->frame_type = PACKET_TYPE_PACK;
-
   pkt->timestamp_ms = timestamp_ms;
+}
+
+/* State, evaluation and checksum; the risk comes in already scaled,
+ * from the float or the Q15 result */
+static uint8_t pack_frame_end(telemetry_pack_frame_t *pkt,
+                              const anomaly_result_t *anomaly,
+                              system_state_t state, uint8_t risk_pct) {
+  /* System state */
+  pkt->system_state = (uint8_t)state;
+  pkt->anomaly_mask = anomaly->active_mask;
+  pkt->anomaly_count = anomaly->active_count;
+  for (uint8_t i = 0; i < PACK_MODULE_MASK_BYTES; i++)
+    pkt->anomaly_modules[i] =
+        (uint8_t)(anomaly->anomaly_modules_mask >> (8 * i));
+
+  /* Hotspot */
+  pkt->hotspot_module = anomaly->hotspot_module;
+
+  /* Risk */
+  pkt->risk_factor_pct = risk_pct;
+  pkt->cascade_stage = anomaly->cascade_stage;
+
+  /* Flags */
+  pkt->flags = 0;
+  if (anomaly->is_emergency_direct)
+    pkt->flags |= PACKET_FLAG_EMERGENCY_DIRECT;
+  if (anomaly->stale_modules_mask)
+    pkt->flags |= PACKET_FLAG_STALE;
+
+  /* Checksum */
+  uint8_t csum_len = PACKET_PACK_SIZE - 1;
+  pkt->checksum = packet_checksum((const uint8_t *)pkt, csum_len);
+
+  return PACKET_PACK_SIZE;
+}
+
+uint8_t packet_encode_pack(telemetry_pack_frame_t *pkt, uint32_t timestamp_ms,
+                           const sensor_snapshot_t *sensors,
+                           const anomaly_result_t *anomaly,
+                           system_state_t state) {
+  pack_frame_begin(pkt, timestamp_ms);
 
   /* Electrical */
   pkt->pack_voltage_dv = clamp_u16(sensors->pack_voltage_v * 10.0f);
@@ -92,49 +194,43 @@ uint8_t packet_encode_pack(telemetry_pack_frame_t *pkt, uint32_t timestamp_ms,
   pkt->v_spread_dmv = clamp_u16(sensors->v_spread_mv * 10.0f);
   pkt->temp_spread_dt = clamp_u8(sensors->temp_spread_c * 10.0f);
 
-  /* System state */
-  pkt->system_state = (uint8_t)state;
-  pkt->anomaly_mask = anomaly->active_mask;
-  pkt->anomaly_count = anomaly->active_count;
-  pkt->anomaly_modules = anomaly->anomaly_modules_mask;
+  return pack_frame_end(pkt, anomaly, state,
+                        clamp_u8(anomaly->risk_factor * 100.0f));
+}
 
-  /* Hotspot */
-  pkt->hotspot_module = anomaly->hotspot_module;
+/* -----------------------------------------------------------------------
+ * Encode module detail frame
+ * ----------------------------------------------------------------------- */
 
-  /* Risk */
-  pkt->risk_factor_pct = clamp_u8(anomaly->risk_factor * 100.0f);
-  pkt->cascade_stage = anomaly->cascade_stage;
+static void module_frame_begin(telemetry_module_frame_t *pkt,
+                               uint8_t module_index) {
+  memset(pkt, 0, sizeof(telemetry_module_frame_t));
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_MODULE_SIZE;
+  pkt->frame_type = PACKET_TYPE_MODULE;
+  pkt->module_index = module_index;
+}
 
-  /* Flags */
-  pkt->flags = 0;
-  if (anomaly->is_emergency_direct)
-    pkt->flags |= 0x01;
+static uint8_t module_frame_end(telemetry_module_frame_t *pkt) {
+  pkt->reserved = 0;
 
   /* Checksum */
-  uint8_t csum_len = PACKET_PACK_SIZE - 1;
+  uint8_t csum_len = PACKET_MODULE_SIZE - 1;
   pkt->checksum = packet_checksum((const uint8_t *)pkt, csum_len);
 
-  return PACKET_PACK_SIZE;
+  return PACKET_MODULE_SIZE;
 }
 
-/* -----------------------------------------------------------------------
- * Encode module detail frame
- * ----------------------------------------------------------------------- */
-
 uint8_t packet_encode_module(telemetry_module_frame_t *pkt,
                              uint8_t module_index,
                              const sensor_snapshot_t *sensors) {
-  memset(pkt, 0, sizeof(telemetry_module_frame_t));
-
-  if (module_index >= NUM_MODULES)
+  if (module_index >= NUM_MODULES) {
+    memset(pkt, 0, sizeof(telemetry_module_frame_t));
     return 0;
+  }
 
   const module_data_t *mod = &sensors->modules[module_index];
-
-  pkt->sync = PACKET_SYNC_BYTE;
-  pkt->length = PACKET_MODULE_SIZE;
-  pkt->frame_type = PACKET_TYPE_MODULE;
-  pkt->module_index = module_index;
+  module_frame_begin(pkt, module_index);
 
   /* NTC temps */
   pkt->ntc1_dt = clamp_i16(mod->ntc1_c * 10.0f);
@@ -156,13 +252,694 @@ uint8_t packet_encode_module(telemetry_module_frame_t *pkt,
   pkt->module_voltage_dv = clamp_u16(mod->module_voltage * 10.0f);
   pkt->v_spread_mv = clamp_u16(mod->v_spread_mv);
 
-  pkt->reserved = 0;
+  return module_frame_end(pkt);
+}
+
+/* -----------------------------------------------------------------------
+ * Encode loop latency frame
+ * ----------------------------------------------------------------------- */
+
+uint8_t packet_encode_latency(telemetry_latency_frame_t *pkt, uint8_t stage,
+                              const lat_stage_stats_t *st) {
+  memset(pkt, 0, sizeof(telemetry_latency_frame_t));
+
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_LATENCY_SIZE;
+  pkt->frame_type = PACKET_TYPE_LATENCY;
+  pkt->stage = stage;
+
+  pkt->count = st->count > 65535u ? 65535u : (uint16_t)st->count;
+  pkt->overruns = st->overruns > 65535u ? 65535u : (uint16_t)st->overruns;
+
+  if (st->count > 0) {
+    pkt->min_us = st->min_us;
+    pkt->mean_us = latency_stats_mean_us(st);
+    pkt->p99_us = latency_stats_percentile_us(st, 990);
+    pkt->max_us = st->max_us;
+  }
 
   /* Checksum */
-  uint8_t csum_len = PACKET_MODULE_SIZE - 1;
+  uint8_t csum_len = PACKET_LATENCY_SIZE - 1;
   pkt->checksum = packet_checksum((const uint8_t *)pkt, csum_len);
 
-  return PACKET_MODULE_SIZE;
+  return PACKET_LATENCY_SIZE;
+}
+
+/* -----------------------------------------------------------------------
+ * Encode group voltage frame
+ * ----------------------------------------------------------------------- */
+
+_Static_assert(sizeof(telemetry_group_frame_t) == PACKET_GROUPS_SIZE,
+               "group frame layout must match PACKET_GROUPS_SIZE");
+
+/* Base and deltas from the quantised group voltages, then checksum */
+static uint8_t groups_frame_end(telemetry_group_frame_t *pkt,
+                                const int32_t mv[GROUPS_PER_MODULE]) {
+  int32_t sum = 0;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    sum += mv[g];
+  int32_t base = (sum + GROUPS_PER_MODULE / 2) / GROUPS_PER_MODULE;
+  pkt->v_base_mv = (uint16_t)base;
+
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    int32_t d = mv[g] - base;
+    if (d > 127 || d < -128) {
+      d = d > 0 ? 127 : -128;
+      pkt->flags |= PACKET_GROUPS_FLAG_CLIPPED;
+    }
+    pkt->v_delta[g] = (int8_t)d;
+  }
+
+  /* Checksum */
+  uint8_t csum_len = PACKET_GROUPS_SIZE - 1;
+  pkt->checksum = packet_checksum((const uint8_t *)pkt, csum_len);
+
+  return PACKET_GROUPS_SIZE;
+}
+
+static void groups_frame_begin(telemetry_group_frame_t *pkt,
+                               uint8_t module_index) {
+  memset(pkt, 0, sizeof(telemetry_group_frame_t));
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_GROUPS_SIZE;
+  pkt->frame_type = PACKET_TYPE_GROUPS;
+  pkt->module_index = module_index;
+}
+
+uint8_t packet_encode_groups(telemetry_group_frame_t *pkt,
+                             uint8_t module_index,
+                             const sensor_snapshot_t *sensors) {
+  if (module_index >= NUM_MODULES) {
+    memset(pkt, 0, sizeof(telemetry_group_frame_t));
+    return 0;
+  }
+
+  const module_data_t *mod = &sensors->modules[module_index];
+  groups_frame_begin(pkt, module_index);
+
+  /* Quantise once, then take the base from the integers so the deltas
+   * are centred on what the receiver reconstructs */
+  int32_t mv[GROUPS_PER_MODULE];
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    float v = mod->group_voltages_v[g] * 1000.0f;
+    mv[g] = v > 65535.0f ? 65535 : (v < 0.0f ? 0 : (int32_t)(v + 0.5f));
+  }
+  return groups_frame_end(pkt, mv);
+}
+
+/* -----------------------------------------------------------------------
+ * Encode rate request frame
+ * ----------------------------------------------------------------------- */
+
+_Static_assert(sizeof(telemetry_rate_frame_t) == PACKET_RATE_SIZE,
+               "rate frame layout must match PACKET_RATE_SIZE");
+
+uint8_t packet_encode_rate(telemetry_rate_frame_t *pkt, module_mask_t boosted,
+                           uint16_t fast_ms, uint16_t slow_ms) {
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_RATE_SIZE;
+  pkt->frame_type = PACKET_TYPE_RATE;
+  for (uint8_t i = 0; i < PACK_MODULE_MASK_BYTES; i++)
+    pkt->boosted[i] = (uint8_t)(boosted >> (8 * i));
+  pkt->fast_ms = fast_ms;
+  pkt->slow_ms = slow_ms;
+  pkt->checksum = packet_checksum((const uint8_t *)pkt, PACKET_RATE_SIZE - 1);
+  return PACKET_RATE_SIZE;
+}
+
+/* -----------------------------------------------------------------------
+ * Fixed-point snapshot — the same frames from the wire-unit fields
+ *
+ * The float encoders truncate; here the values are already integers in
+ * (or a power of ten from) the frame units, so only the clamps and unit
+ * shifts remain.
+ * ----------------------------------------------------------------------- */
+
+static inline int16_t clampi_i16(int32_t v) {
+  return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+static inline uint8_t clampi_u8(int32_t v) {
+  return v > UINT8_MAX ? UINT8_MAX : v < 0 ? 0 : (uint8_t)v;
+}
+
+static inline uint16_t clampi_u16(int32_t v) {
+  return v > UINT16_MAX ? UINT16_MAX : v < 0 ? 0 : (uint16_t)v;
+}
+
+uint8_t packet_encode_pack_fx(telemetry_pack_frame_t *pkt,
+                              uint32_t timestamp_ms,
+                              const sensor_snapshot_fx_t *sensors,
+                              const anomaly_result_t *anomaly,
+                              system_state_t state) {
+  pack_frame_begin(pkt, timestamp_ms);
+
+  /* Electrical */
+  pkt->pack_voltage_dv = sensors->pack_voltage_dv;
+  pkt->pack_current_da = sensors->pack_current_da;
+  pkt->r_int_cmohm = (uint16_t)(sensors->r_internal_uohm / 10u);
+
+  /* Thermal summary; deci-°C/min to centi */
+  pkt->max_temp_dt = sensors->hotspot_temp_dt;
+  pkt->ambient_temp_dt = sensors->temp_ambient_dt;
+  pkt->core_temp_est_dt = clampi_i16(sensors->t_core_est_mc / 100);
+  pkt->dt_dt_max_cdpm = clampi_u8(sensors->dt_dt_max_ddpm * 10);
+
+  /* Gas & pressure */
+  pkt->gas_ratio_1_cp = clampi_u8(sensors->gas_ratio_1_cp);
+  pkt->gas_ratio_2_cp = clampi_u8(sensors->gas_ratio_2_cp);
+  pkt->pressure_delta_1_chpa = sensors->pressure_delta_1_chpa;
+  pkt->pressure_delta_2_chpa = sensors->pressure_delta_2_chpa;
+
+  /* Pack health */
+  pkt->v_spread_dmv = clampi_u16((int32_t)sensors->v_spread_mv * 10);
+  pkt->temp_spread_dt = clampi_u8(sensors->temp_spread_dt);
+
+  return pack_frame_end(pkt, anomaly, state, anomaly_risk_pct_fx(anomaly));
+}
+
+uint8_t packet_encode_module_fx(telemetry_module_frame_t *pkt,
+                                uint8_t module_index,
+                                const sensor_snapshot_fx_t *sensors) {
+  if (module_index >= NUM_MODULES) {
+    memset(pkt, 0, sizeof(telemetry_module_frame_t));
+    return 0;
+  }
+
+  const module_data_fx_t *mod = &sensors->modules[module_index];
+  module_frame_begin(pkt, module_index);
+  pkt->ntc1_dt = mod->ntc1_dt;
+  pkt->ntc2_dt = mod->ntc2_dt;
+  pkt->swelling_pct = mod->swelling_pct;
+  pkt->delta_t_intra_dt = clampi_u8(mod->delta_t_intra_dt);
+  pkt->max_dt_dt_cdpm = clampi_u8(mod->max_dt_dt_ddpm * 10);
+  pkt->module_voltage_dv = clampi_u16((int32_t)(mod->module_mv / 100u));
+  pkt->v_spread_mv = mod->v_spread_mv;
+  return module_frame_end(pkt);
+}
+
+uint8_t packet_encode_groups_fx(telemetry_group_frame_t *pkt,
+                                uint8_t module_index,
+                                const sensor_snapshot_fx_t *sensors) {
+  if (module_index >= NUM_MODULES) {
+    memset(pkt, 0, sizeof(telemetry_group_frame_t));
+    return 0;
+  }
+
+  groups_frame_begin(pkt, module_index);
+  int32_t mv[GROUPS_PER_MODULE];
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    mv[g] = clampi_u16(VPLANE_MV(&sensors->vplane, module_index, g));
+  return groups_frame_end(pkt, mv);
+}
+
+void packet_encode_input_pack_fx(input_pack_frame_t *f,
+                                 const sensor_snapshot_fx_t *s) {
+  f->sync = INPUT_SYNC_BYTE;
+  f->length = INPUT_PACK_FRAME_SIZE;
+  f->frame_type = INPUT_TYPE_PACK;
+  f->pack_voltage_dv = s->pack_voltage_dv;
+  f->pack_current_da = s->pack_current_da;
+  f->ambient_temp_dt = s->temp_ambient_dt;
+  f->coolant_inlet_dt = s->coolant_inlet_dt;
+  f->coolant_outlet_dt = s->coolant_outlet_dt;
+  f->gas_ratio_1_cp = s->gas_ratio_1_cp;
+  f->gas_ratio_2_cp = s->gas_ratio_2_cp;
+  f->pressure_delta_1_chpa = s->pressure_delta_1_chpa;
+  f->pressure_delta_2_chpa = s->pressure_delta_2_chpa;
+  f->humidity_pct = s->humidity_pct;
+  f->isolation_mohm = s->isolation_dmohm;
+  f->checksum = packet_checksum((const uint8_t *)f, INPUT_PACK_FRAME_SIZE - 1);
+}
+
+void packet_encode_input_module_fx(input_module_frame_t *f, uint8_t m,
+                                   const sensor_snapshot_fx_t *s) {
+  const module_data_fx_t *mod = &s->modules[m];
+
+  f->sync = INPUT_SYNC_BYTE;
+  f->length = INPUT_MODULE_FRAME_SIZE;
+  f->frame_type = INPUT_TYPE_MODULE;
+  f->module_index = m;
+  f->ntc1_dt = mod->ntc1_dt;
+  f->ntc2_dt = mod->ntc2_dt;
+  f->swelling_pct = mod->swelling_pct;
+
+  int32_t mv[GROUPS_PER_MODULE];
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    mv[g] = clampi_u16(VPLANE_MV(&s->vplane, m, g));
+  input_module_end(f, mv);
+}
+
+/* -----------------------------------------------------------------------
+ * Group voltage streaming
+ * ----------------------------------------------------------------------- */
+
+void packet_groups_init(packet_group_stream_t *gs, uint16_t min_interval_ms) {
+  memset(gs, 0, sizeof(packet_group_stream_t));
+  gs->min_interval_ms =
+      min_interval_ms ? min_interval_ms : PACKET_GROUPS_MIN_INTERVAL_MS;
+}
+
+/* One poll over either snapshot form (the other is NULL) */
+static uint8_t groups_poll(packet_group_stream_t *gs, uint32_t now_ms,
+                           const sensor_snapshot_t *sensors,
+                           const sensor_snapshot_fx_t *sensors_fx,
+                           module_mask_t flagged,
+                           telemetry_group_frame_t *out) {
+  /* New anomalies jump the rate limit; cleared ones stop streaming */
+  gs->pending = (module_mask_t)((gs->pending | (flagged & ~gs->flagged)) &
+                                flagged);
+  gs->flagged = flagged;
+
+  uint8_t n = 0;
+  uint8_t start = gs->cursor;
+  for (uint8_t i = 0; i < NUM_MODULES && n < PACKET_GROUPS_MAX_PER_CYCLE;
+       i++) {
+    uint8_t m = (uint8_t)((start + i) % NUM_MODULES);
+    module_mask_t bit = MODULE_BIT(m);
+    if (!(flagged & bit))
+      continue;
+
+    bool onset = (gs->pending & bit) != 0;
+    if (!onset && (now_ms - gs->last_ms[m]) < gs->min_interval_ms)
+      continue;
+
+    if (sensors)
+      (void)packet_encode_groups(&out[n], m, sensors);
+    else
+      (void)packet_encode_groups_fx(&out[n], m, sensors_fx);
+    if (!onset && (gs->sent & bit) &&
+        memcmp(&out[n], &gs->last[m], sizeof(telemetry_group_frame_t)) == 0)
+      continue; /* Unchanged */
+
+    gs->last[m] = out[n];
+    gs->last_ms[m] = now_ms;
+    gs->sent |= bit;
+    gs->pending &= (module_mask_t)~bit;
+    gs->cursor = (uint8_t)((m + 1) % NUM_MODULES);
+    n++;
+  }
+  return n;
+}
+
+uint8_t packet_groups_poll(
+    packet_group_stream_t *gs, uint32_t now_ms,
+    const sensor_snapshot_t *sensors, module_mask_t flagged,
+    telemetry_group_frame_t out[PACKET_GROUPS_MAX_PER_CYCLE]) {
+  return groups_poll(gs, now_ms, sensors, NULL, flagged, out);
+}
+
+uint8_t packet_groups_poll_fx(
+    packet_group_stream_t *gs, uint32_t now_ms,
+    const sensor_snapshot_fx_t *sensors, module_mask_t flagged,
+    telemetry_group_frame_t out[PACKET_GROUPS_MAX_PER_CYCLE]) {
+  return groups_poll(gs, now_ms, NULL, sensors, flagged, out);
+}
+
+/* -----------------------------------------------------------------------
+ * Compact telemetry — field tables
+ *
+ * Each field is read out of (and written back into) the legacy frame as
+ * little-endian bytes, so the compact stream reproduces the legacy
+ * frames bit for bit and new geometry (wider anomaly_modules) follows.
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t offset;
+  uint8_t size;
+  uint8_t is_signed;
+} compact_field_t;
+
+#define PACK_FIELD(f, sgn)                                                     \
+  {offsetof(telemetry_pack_frame_t, f),                                        \
+   sizeof(((const telemetry_pack_frame_t *)0)->f), sgn}
+#define MODULE_FIELD(f, sgn)                                                   \
+  {offsetof(telemetry_module_frame_t, f),                                      \
+   sizeof(((const telemetry_module_frame_t *)0)->f), sgn}
+
+static const compact_field_t PACK_FIELDS[PACKET_COMPACT_PACK_FIELDS] = {
+    PACK_FIELD(timestamp_ms, 0),
+    PACK_FIELD(pack_voltage_dv, 0),
+    PACK_FIELD(pack_current_da, 1),
+    PACK_FIELD(r_int_cmohm, 0),
+    PACK_FIELD(max_temp_dt, 1),
+    PACK_FIELD(ambient_temp_dt, 1),
+    PACK_FIELD(core_temp_est_dt, 1),
+    PACK_FIELD(dt_dt_max_cdpm, 0),
+    PACK_FIELD(gas_ratio_1_cp, 0),
+    PACK_FIELD(gas_ratio_2_cp, 0),
+    PACK_FIELD(pressure_delta_1_chpa, 1),
+    PACK_FIELD(pressure_delta_2_chpa, 1),
+    PACK_FIELD(v_spread_dmv, 0),
+    PACK_FIELD(temp_spread_dt, 0),
+    PACK_FIELD(system_state, 0),
+    PACK_FIELD(anomaly_mask, 0),
+    PACK_FIELD(anomaly_count, 0),
+    PACK_FIELD(anomaly_modules, 0),
+    PACK_FIELD(hotspot_module, 0),
+    PACK_FIELD(risk_factor_pct, 0),
+    PACK_FIELD(cascade_stage, 0),
+    PACK_FIELD(flags, 0),
+};
+
+static const compact_field_t MODULE_FIELDS[PACKET_COMPACT_MODULE_FIELDS] = {
+    MODULE_FIELD(ntc1_dt, 1),
+    MODULE_FIELD(ntc2_dt, 1),
+    MODULE_FIELD(swelling_pct, 0),
+    MODULE_FIELD(delta_t_intra_dt, 0),
+    MODULE_FIELD(max_dt_dt_cdpm, 0),
+    MODULE_FIELD(module_voltage_dv, 0),
+    MODULE_FIELD(v_spread_mv, 0),
+};
+
+_Static_assert(PACKET_COMPACT_MAX_SIZE >= PACKET_COMPACT_HEADER + 1 + 5 +
+                                              5 * PACKET_COMPACT_PACK_FIELDS +
+                                              1,
+               "compact frame must hold a worst-case pack block");
+
+static uint32_t field_load(const uint8_t *frame, const compact_field_t *f) {
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < f->size; i++)
+    v |= (uint32_t)frame[f->offset + i] << (8 * i);
+  if (f->is_signed && f->size < 4) {
+    uint32_t sign = 1u << (8 * f->size - 1);
+    v = (v ^ sign) - sign;
+  }
+  return v;
+}
+
+static void field_store(uint8_t *frame, const compact_field_t *f, uint32_t v) {
+  for (uint8_t i = 0; i < f->size; i++)
+    frame[f->offset + i] = (uint8_t)(v >> (8 * i));
+}
+
+/* Block b covers fields [block_first(b), block_first(b) + block_count(b)) */
+static uint16_t block_first(uint8_t b) {
+  return b == 0 ? 0
+                : (uint16_t)(PACKET_COMPACT_PACK_FIELDS +
+                             (b - 1) * PACKET_COMPACT_MODULE_FIELDS);
+}
+
+static uint8_t block_count(uint8_t b) {
+  return b == 0 ? PACKET_COMPACT_PACK_FIELDS : PACKET_COMPACT_MODULE_FIELDS;
+}
+
+/* -----------------------------------------------------------------------
+ * Compact telemetry — varints
+ * ----------------------------------------------------------------------- */
+
+static uint8_t varint_put(uint8_t *p, uint32_t v) {
+  uint8_t n = 0;
+  while (v >= 0x80u) {
+    p[n++] = (uint8_t)(v | 0x80u);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+/* Returns bytes consumed, 0 if truncated or longer than 5 bytes */
+static uint8_t varint_get(const uint8_t *p, const uint8_t *end, uint32_t *v) {
+  uint32_t r = 0;
+  for (uint8_t n = 0; n < 5 && p + n < end; n++) {
+    r |= (uint32_t)(p[n] & 0x7Fu) << (7 * n);
+    if (!(p[n] & 0x80u)) {
+      *v = r;
+      return (uint8_t)(n + 1);
+    }
+  }
+  return 0;
+}
+
+static inline uint32_t zigzag(uint32_t d) {
+  return (d << 1) ^ (uint32_t)-(int32_t)(d >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t z) {
+  return (z >> 1) ^ (uint32_t)-(int32_t)(z & 1u);
+}
+
+/* -----------------------------------------------------------------------
+ * Compact telemetry — encoder
+ * ----------------------------------------------------------------------- */
+
+void packet_compact_init(packet_compact_enc_t *enc, uint8_t key_interval) {
+  memset(enc, 0, sizeof(packet_compact_enc_t));
+  enc->key_interval = key_interval ? key_interval : PACKET_COMPACT_KEY_INTERVAL;
+  enc->key_pending = true;
+}
+
+void packet_compact_request_key(packet_compact_enc_t *enc) {
+  enc->key_pending = true;
+}
+
+/* Capture a cycle from either snapshot form (the other is NULL) */
+static void compact_begin(packet_compact_enc_t *enc, uint32_t timestamp_ms,
+                          const sensor_snapshot_t *sensors,
+                          const sensor_snapshot_fx_t *sensors_fx,
+                          const anomaly_result_t *anomaly,
+                          system_state_t state) {
+  telemetry_pack_frame_t pack;
+  if (sensors)
+    (void)packet_encode_pack(&pack, timestamp_ms, sensors, anomaly, state);
+  else
+    (void)packet_encode_pack_fx(&pack, timestamp_ms, sensors_fx, anomaly,
+                                state);
+  for (uint8_t f = 0; f < PACKET_COMPACT_PACK_FIELDS; f++)
+    enc->field[f] = field_load((const uint8_t *)&pack, &PACK_FIELDS[f]);
+
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    telemetry_module_frame_t mod;
+    if (sensors)
+      (void)packet_encode_module(&mod, m, sensors);
+    else
+      (void)packet_encode_module_fx(&mod, m, sensors_fx);
+    uint32_t *dst = &enc->field[block_first((uint8_t)(m + 1))];
+    for (uint8_t f = 0; f < PACKET_COMPACT_MODULE_FIELDS; f++)
+      dst[f] = field_load((const uint8_t *)&mod, &MODULE_FIELDS[f]);
+  }
+
+  enc->key = enc->key_pending || enc->since_key + 1u >= enc->key_interval;
+  enc->key_pending = false;
+  enc->since_key = enc->key ? 0 : (uint8_t)(enc->since_key + 1u);
+  enc->next_block = 0;
+}
+
+void packet_compact_begin(packet_compact_enc_t *enc, uint32_t timestamp_ms,
+                          const sensor_snapshot_t *sensors,
+                          const anomaly_result_t *anomaly,
+                          system_state_t state) {
+  compact_begin(enc, timestamp_ms, sensors, NULL, anomaly, state);
+}
+
+void packet_compact_begin_fx(packet_compact_enc_t *enc, uint32_t timestamp_ms,
+                             const sensor_snapshot_fx_t *sensors,
+                             const anomaly_result_t *anomaly,
+                             system_state_t state) {
+  compact_begin(enc, timestamp_ms, NULL, sensors, anomaly, state);
+}
+
+/* Serialise block b into out; returns its size, 0 if unchanged */
+static uint8_t compact_block(const packet_compact_enc_t *enc, uint8_t b,
+                             uint8_t *out) {
+  const uint16_t first = block_first(b);
+  const uint8_t count = block_count(b);
+  uint32_t bitmap = 0;
+
+  for (uint8_t f = 0; f < count; f++) {
+    if (enc->key || enc->field[first + f] != enc->sent[first + f])
+      bitmap |= 1u << f;
+  }
+  if (bitmap == 0)
+    return 0;
+
+  uint8_t n = 0;
+  out[n++] = b;
+  n += varint_put(&out[n], bitmap);
+  for (uint8_t f = 0; f < count; f++) {
+    if (!(bitmap & (1u << f)))
+      continue;
+    uint32_t base = enc->key ? 0 : enc->sent[first + f];
+    n += varint_put(&out[n], zigzag(enc->field[first + f] - base));
+  }
+  return n;
+}
+
+uint8_t packet_compact_next(packet_compact_enc_t *enc, uint8_t *buf) {
+  uint8_t n = PACKET_COMPACT_HEADER;
+  uint8_t block[PACKET_COMPACT_MAX_SIZE];
+
+  while (enc->next_block < PACKET_COMPACT_BLOCKS) {
+    uint8_t b = enc->next_block;
+    uint8_t len = compact_block(enc, b, block);
+    if (n + len + 1u > PACKET_COMPACT_MAX_SIZE)
+      break; /* Next frame */
+    memcpy(&buf[n], block, len);
+    n = (uint8_t)(n + len);
+    memcpy(&enc->sent[block_first(b)], &enc->field[block_first(b)],
+           block_count(b) * sizeof(uint32_t));
+    enc->next_block++;
+  }
+
+  if (n == PACKET_COMPACT_HEADER)
+    return 0;
+
+  buf[0] = PACKET_SYNC_BYTE;
+  buf[1] = (uint8_t)(n + 1u);
+  buf[2] = PACKET_TYPE_COMPACT;
+  buf[3] = enc->seq++;
+  buf[4] = enc->key ? PACKET_COMPACT_FLAG_KEY : 0;
+  buf[n] = packet_checksum(buf, n);
+  return (uint8_t)(n + 1u);
+}
+
+/* -----------------------------------------------------------------------
+ * Compact telemetry — decoder
+ * ----------------------------------------------------------------------- */
+
+void packet_compact_dec_init(packet_compact_dec_t *dec) {
+  memset(dec, 0, sizeof(packet_compact_dec_t));
+}
+
+int packet_compact_decode(packet_compact_dec_t *dec, const uint8_t *frame,
+                          uint8_t length) {
+  if (length < PACKET_COMPACT_HEADER + 1u || frame[0] != PACKET_SYNC_BYTE ||
+      frame[1] != length || frame[2] != PACKET_TYPE_COMPACT ||
+      frame[length - 1u] != packet_checksum(frame, (uint8_t)(length - 1u)))
+    return -1;
+
+  uint8_t seq = frame[3];
+  bool key = (frame[4] & PACKET_COMPACT_FLAG_KEY) != 0;
+  if (dec->have_seq && seq != (uint8_t)(dec->seq + 1u)) {
+    memset(dec->valid, 0, sizeof(dec->valid));
+    dec->gaps++;
+  }
+  dec->seq = seq;
+  dec->have_seq = true;
+
+  const uint8_t *p = &frame[PACKET_COMPACT_HEADER];
+  const uint8_t *end = &frame[length - 1u];
+  while (p < end) {
+    uint8_t b = *p++;
+    uint32_t bitmap;
+    uint8_t k;
+    if (b >= PACKET_COMPACT_BLOCKS || !(k = varint_get(p, end, &bitmap)))
+      return -1;
+    p += k;
+
+    const uint16_t first = block_first(b);
+    const uint8_t count = block_count(b);
+    if (bitmap >> count)
+      return -1;
+    bool apply = key || dec->valid[b];
+
+    for (uint8_t f = 0; f < count; f++) {
+      if (!(bitmap & (1u << f)))
+        continue;
+      uint32_t z;
+      if (!(k = varint_get(p, end, &z)))
+        return -1;
+      p += k;
+      if (apply)
+        dec->field[first + f] = (key ? 0 : dec->field[first + f]) + unzigzag(z);
+    }
+    if (key)
+      dec->valid[b] = 1;
+  }
+  return 0;
+}
+
+int packet_compact_pack_frame(const packet_compact_dec_t *dec,
+                              telemetry_pack_frame_t *pkt) {
+  if (!dec->valid[0])
+    return -1;
+  memset(pkt, 0, sizeof(telemetry_pack_frame_t));
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_PACK_SIZE;
+  pkt->frame_type = PACKET_TYPE_PACK;
+  for (uint8_t f = 0; f < PACKET_COMPACT_PACK_FIELDS; f++)
+    field_store((uint8_t *)pkt, &PACK_FIELDS[f], dec->field[f]);
+  pkt->checksum = packet_checksum((const uint8_t *)pkt, PACKET_PACK_SIZE - 1);
+  return 0;
+}
+
+int packet_compact_module_frame(const packet_compact_dec_t *dec,
+                                uint8_t module_index,
+                                telemetry_module_frame_t *pkt) {
+  if (module_index >= NUM_MODULES || !dec->valid[module_index + 1])
+    return -1;
+  memset(pkt, 0, sizeof(telemetry_module_frame_t));
+  pkt->sync = PACKET_SYNC_BYTE;
+  pkt->length = PACKET_MODULE_SIZE;
+  pkt->frame_type = PACKET_TYPE_MODULE;
+  pkt->module_index = module_index;
+  const uint32_t *src = &dec->field[block_first((uint8_t)(module_index + 1))];
+  for (uint8_t f = 0; f < PACKET_COMPACT_MODULE_FIELDS; f++)
+    field_store((uint8_t *)pkt, &MODULE_FIELDS[f], src[f]);
+  pkt->checksum =
+      packet_checksum((const uint8_t *)pkt, PACKET_MODULE_SIZE - 1);
+  return 0;
+}
+
+/* -----------------------------------------------------------------------
+ * v2 superframe
+ * ----------------------------------------------------------------------- */
+
+void packet_super_begin(packet_super_t *sf, uint8_t seq) {
+  sf->buf[0] = PACKET_SYNC_V2;
+  sf->buf[3] = PACKET_TYPE_SUPER;
+  sf->buf[4] = seq;
+  sf->len = PACKET_V2_HEADER;
+  sf->seq = seq;
+  sf->count = 0;
+}
+
+bool packet_super_add(packet_super_t *sf, const uint8_t *frame) {
+  if (frame[1] < 4u)
+    return false;
+  uint8_t plen = (uint8_t)(frame[1] - 4u);
+  if (sf->len + 2u + plen + 2u > PACKET_V2_MAX_SIZE)
+    return false;
+
+  sf->buf[sf->len++] = frame[2];
+  sf->buf[sf->len++] = plen;
+  memcpy(&sf->buf[sf->len], &frame[3], plen);
+  sf->len = (uint16_t)(sf->len + plen);
+  sf->count++;
+  return true;
+}
+
+uint16_t packet_super_finish(packet_super_t *sf) {
+  if (sf->count == 0)
+    return 0;
+  uint16_t n = (uint16_t)(sf->len + 2u);
+  sf->buf[1] = (uint8_t)n;
+  sf->buf[2] = (uint8_t)(n >> 8);
+  uint16_t crc = crc16_block(CRC16_INIT, sf->buf, sf->len);
+  sf->buf[sf->len] = (uint8_t)crc;
+  sf->buf[sf->len + 1u] = (uint8_t)(crc >> 8);
+  return n;
+}
+
+int packet_super_validate(const uint8_t *frame, uint16_t length) {
+  if (length < PACKET_V2_OVERHEAD || frame[0] != PACKET_SYNC_V2 ||
+      frame[3] != PACKET_TYPE_SUPER ||
+      (uint16_t)(frame[1] | (frame[2] << 8)) != length)
+    return -1;
+
+  uint16_t end = (uint16_t)(length - 2u);
+  uint16_t crc = crc16_block(CRC16_INIT, frame, end);
+  if (frame[end] != (uint8_t)crc || frame[end + 1u] != (uint8_t)(crc >> 8))
+    return -1;
+
+  /* Records must tile the body exactly */
+  int count = 0;
+  uint16_t p = PACKET_V2_HEADER;
+  while (p + 2u <= end) {
+    p = (uint16_t)(p + 2u + frame[p + 1u]);
+    count++;
+  }
+  return p == end ? count : -1;
 }
 
 /* -----------------------------------------------------------------------
@@ -4,27 +4,52 @@
  * Multi-frame output telemetry from VSDSquadron ULTRA to dashboard.
  * Mirrors the input protocol structure:
  *   Frame 0x01: Pack summary (state, V/I, gas, pressure, risk, hotspot)
- *   Frame 0x02: Module detail (×8: NTCs, swelling, dT/dt, V spread)
+ *   Frame 0x02: Module detail (per module: NTCs, swelling, dT/dt, V spread)
+ *   Frame 0x03: Loop latency (×5 stages: count, min/mean/p99/max µs)
+ *   Frame 0x04: Compact pack + module fields (keyframe or delta, opt-in)
+ *   Frame 0x05: Group voltages of a flagged module (on change, limited)
  *
  * Each frame: [0xAA][LEN][TYPE][payload][XOR_checksum]
+ *
+ * Optionally (negotiated, see INPUT_TEL_FLAG_V2) the frames of a cycle
+ * are batched into CRC-16 superframes with a cycle sequence number.
  */
 
 #ifndef PACKET_FORMAT_H
 #define PACKET_FORMAT_H
 
-#include "anomaly_eval.h"
+#include "anomaly_eval_fx.h"
 #include "correlation_engine.h"
+#include "input_packet.h"
+#include "latency_stats.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Packet framing */
 #define PACKET_SYNC_BYTE 0xAA
 #define PACKET_TYPE_PACK 0x01
 #define PACKET_TYPE_MODULE 0x02
+#define PACKET_TYPE_LATENCY 0x03
+#define PACKET_TYPE_COMPACT 0x04
+#define PACKET_TYPE_GROUPS 0x05
+#define PACKET_TYPE_BLACKBOX 0x06 /* Flash log dump (blackbox.h) */
+#define PACKET_TYPE_RATE 0x07     /* Per-module rate request          */
+#define PACKET_TYPE_LOG 0x08      /* Binary log event (log_event.h)   */
 
 /* Frame sizes */
-#define PACKET_PACK_SIZE 38   /* Pack summary frame */
-#define PACKET_MODULE_SIZE 17 /* Per-module detail frame */
-#define PACKET_MAX_SIZE 38    /* Largest frame */
+#define PACKET_PACK_SIZE                                                       \
+  (37 + PACK_MODULE_MASK_BYTES) /* Pack summary frame (38 for 8 modules) */
+#define PACKET_MODULE_SIZE 17   /* Per-module detail frame */
+#define PACKET_LATENCY_SIZE 25  /* Per-stage latency frame */
+#define PACKET_GROUPS_SIZE                                                     \
+  (8 + GROUPS_PER_MODULE) /* Group voltage frame (21 for 13 groups) */
+#define PACKET_RATE_SIZE                                                       \
+  (8 + PACK_MODULE_MASK_BYTES) /* Rate request frame (9 for 8 modules) */
+#define PACKET_MAX_SIZE PACKET_PACK_SIZE /* Largest frame */
+
+/* Pack frame flags */
+#define PACKET_FLAG_EMERGENCY_DIRECT 0x01 /* Physics-limit bypass fired   */
+#define PACKET_FLAG_STALE 0x02 /* Some modules reused last-good data      */
 
 /* -----------------------------------------------------------------------
  * Pack summary output frame (Type 0x01)
@@ -62,7 +87,7 @@ typedef struct __attribute__((packed)) {
   uint8_t system_state;    /* 0=NORMAL..3=EMERGENCY                   */
   uint8_t anomaly_mask;    /* Active category bitmask (CAT_*)         */
   uint8_t anomaly_count;   /* Number of active categories             */
-  uint8_t anomaly_modules; /* Which modules have anomalies (bitmask)  */
+  uint8_t anomaly_modules[PACK_MODULE_MASK_BYTES]; /* Module bitmask, LE */
 
   /* Hotspot */
   uint8_t hotspot_module; /* Module with worst anomaly (1-based)     */
@@ -72,7 +97,7 @@ typedef struct __attribute__((packed)) {
   uint8_t cascade_stage;   /* 0=Normal..6=Runaway                     */
 
   /* Flags */
-  uint8_t flags; /* bit0: emergency_direct                  */
+  uint8_t flags; /* PACKET_FLAG_*                           */
 
   /* Checksum */
   uint8_t checksum; /* XOR of all preceding bytes              */
@@ -86,7 +111,7 @@ typedef struct __attribute__((packed)) {
   uint8_t length;     /* Frame size (20)                         */
   uint8_t frame_type; /* 0x02                                    */
 
-  uint8_t module_index; /* Module number (0-7)                     */
+  uint8_t module_index; /* Module number (0..NUM_MODULES-1)        */
 
   /* NTC temperatures */
   int16_t ntc1_dt; /* NTC1 temp deci-°C                       */
@@ -110,6 +135,167 @@ typedef struct __attribute__((packed)) {
   uint8_t checksum; /* XOR of all preceding bytes              */
 } telemetry_module_frame_t;
 
+/* -----------------------------------------------------------------------
+ * Loop latency output frame (Type 0x03)
+ * ----------------------------------------------------------------------- */
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xAA                                    */
+  uint8_t length;     /* Frame size (25)                         */
+  uint8_t frame_type; /* 0x03                                    */
+
+  uint8_t stage; /* lat_stage_t (0=fast..4=slow)            */
+
+  uint16_t count;    /* Samples in this window (saturating)     */
+  uint16_t overruns; /* Samples over budget (saturating)        */
+
+  uint32_t min_us;  /* Fastest sample                          */
+  uint32_t mean_us; /* Window mean                             */
+  uint32_t p99_us;  /* 99th percentile (histogram, ≤25% high)  */
+  uint32_t max_us;  /* Slowest sample                          */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes              */
+} telemetry_latency_frame_t;
+
+/* -----------------------------------------------------------------------
+ * Group voltage output frame (Type 0x05)
+ *
+ * Same base + int8 delta encoding as the input module frame. Sent only
+ * for modules in anomaly_modules_mask: when a module is first flagged,
+ * then whenever its voltages change, at most once per min_interval_ms
+ * per module and PACKET_GROUPS_MAX_PER_CYCLE frames per slow loop.
+ * ----------------------------------------------------------------------- */
+
+#define PACKET_GROUPS_MAX_PER_CYCLE 2
+#define PACKET_GROUPS_MIN_INTERVAL_MS 1000
+#define PACKET_GROUPS_FLAG_CLIPPED 0x01 /* A delta saturated at ±127 mV */
+
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xAA                                    */
+  uint8_t length;     /* Frame size (21)                         */
+  uint8_t frame_type; /* 0x05                                    */
+
+  uint8_t module_index; /* Module number (0..NUM_MODULES-1)        */
+
+  /* Group voltages: base + per-group delta, in mV */
+  uint16_t v_base_mv;                 /* Mean group voltage, rounded      */
+  int8_t v_delta[GROUPS_PER_MODULE]; /* V_g - base, saturated           */
+
+  uint8_t flags; /* PACKET_GROUPS_FLAG_*                    */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes              */
+} telemetry_group_frame_t;
+
+/* On-change streaming state, one per link */
+typedef struct {
+  telemetry_group_frame_t last[NUM_MODULES]; /* Last frame sent        */
+  uint32_t last_ms[NUM_MODULES];             /* When it was sent       */
+  module_mask_t sent;     /* Modules with a valid last[] entry           */
+  module_mask_t flagged;  /* anomaly_modules_mask seen last poll         */
+  module_mask_t pending;  /* Newly flagged, not yet sent                 */
+  uint16_t min_interval_ms;
+  uint8_t cursor;         /* Round-robin start, so no module starves     */
+} packet_group_stream_t;
+
+/* -----------------------------------------------------------------------
+ * Rate request frame (Type 0x07) — module_rate.h
+ *
+ * Tells the sender of the input link which modules to refresh every
+ * fast_ms; the rest are wanted every slow_ms. Sent whenever the boosted
+ * set changes and again each slow loop, so a lost frame heals. An empty
+ * mask lifts the request: every module in every cycle, as before.
+ * ----------------------------------------------------------------------- */
+typedef struct __attribute__((packed)) {
+  uint8_t sync;       /* 0xAA                                    */
+  uint8_t length;     /* Frame size (9 for 8 modules)            */
+  uint8_t frame_type; /* 0x07                                    */
+
+  uint8_t boosted[PACK_MODULE_MASK_BYTES]; /* Module bitmask, LE  */
+  uint16_t fast_ms; /* Period wanted for boosted modules       */
+  uint16_t slow_ms; /* Period wanted for the rest              */
+
+  /* Checksum */
+  uint8_t checksum; /* XOR of all preceding bytes              */
+} telemetry_rate_frame_t;
+
+/* -----------------------------------------------------------------------
+ * Compact frame (Type 0x04) — enabled by the dashboard with a config
+ * frame on the input link (INPUT_TYPE_TEL_CONFIG)
+ *
+ * The pack and module frames above are flattened into field blocks:
+ * block 0 holds the 22 pack fields, block 1+m the 7 fields of module m,
+ * in struct order (reserved bytes dropped). Every key_interval cycles,
+ * or on request, a keyframe carries every field as an absolute value;
+ * the cycles in between carry only blocks that changed, as a bitmap of
+ * changed fields followed by their differences. Bitmaps are LEB128
+ * varints, values zigzag LEB128 varints.
+ *
+ *   [0xAA][LEN][0x04][SEQ][FLAGS] { [BLOCK][BITMAP][VALUE...] }* [XOR]
+ *
+ * FLAGS bit0 marks a keyframe. SEQ counts compact frames, so a receiver
+ * that sees a gap ignores deltas until the next keyframe. A cycle may
+ * span several frames; a block never straddles two.
+ * ----------------------------------------------------------------------- */
+
+#define PACKET_COMPACT_MAX_SIZE 128 /* Fits the worst-case pack block    */
+#define PACKET_COMPACT_HEADER 5     /* sync + len + type + seq + flags   */
+#define PACKET_COMPACT_FLAG_KEY 0x01
+#define PACKET_COMPACT_KEY_INTERVAL 10 /* Default cycles per keyframe    */
+
+#define PACKET_COMPACT_PACK_FIELDS 22
+#define PACKET_COMPACT_MODULE_FIELDS 7
+#define PACKET_COMPACT_BLOCKS (1 + NUM_MODULES)
+#define PACKET_COMPACT_FIELDS                                                  \
+  (PACKET_COMPACT_PACK_FIELDS + NUM_MODULES * PACKET_COMPACT_MODULE_FIELDS)
+
+/* Encoder — one per link. Fields hold the raw wire values of the legacy
+ * frames (sign-extended), so compact and legacy decode identically. */
+typedef struct {
+  uint32_t field[PACKET_COMPACT_FIELDS]; /* This cycle                    */
+  uint32_t sent[PACKET_COMPACT_FIELDS];  /* As the receiver last saw them */
+  uint8_t key_interval; /* Cycles between keyframes                       */
+  uint8_t since_key;    /* Cycles since the last keyframe                 */
+  uint8_t seq;          /* Next frame sequence number                     */
+  uint8_t next_block;   /* Block cursor within the cycle                  */
+  bool key;             /* This cycle is a keyframe                       */
+  bool key_pending;     /* Keyframe requested for the next cycle          */
+} packet_compact_enc_t;
+
+/* Decoder — reference implementation for the host tools and tests */
+typedef struct {
+  uint32_t field[PACKET_COMPACT_FIELDS];
+  uint8_t valid[PACKET_COMPACT_BLOCKS]; /* Block has a keyframe baseline  */
+  uint8_t seq;                          /* Last sequence number seen      */
+  bool have_seq;
+  uint32_t gaps;                        /* Sequence gaps detected         */
+} packet_compact_dec_t;
+
+/* -----------------------------------------------------------------------
+ * v2 superframe (Type 0x10) — a telemetry cycle behind one CRC
+ *
+ *   [0xAB][LEN_LO][LEN_HI][0x10][SEQ] { [TYPE][PLEN][payload] }* [CRC16]
+ *
+ * Same layout as the input side's v2 framing: each record is a v1
+ * frame without its sync, length and XOR bytes, LEN is the whole frame
+ * and the CRC is CRC-16/CCITT-FALSE (little-endian) over everything
+ * before it. SEQ counts slow-loop cycles; a cycle that does not fit in
+ * one superframe continues in the next with the same SEQ.
+ * ----------------------------------------------------------------------- */
+
+#define PACKET_SYNC_V2 0xAB
+#define PACKET_TYPE_SUPER 0x10
+#define PACKET_V2_HEADER 5   /* sync + len16 + type + seq */
+#define PACKET_V2_OVERHEAD 7 /* header + crc16            */
+#define PACKET_V2_MAX_SIZE 256
+
+typedef struct {
+  uint8_t buf[PACKET_V2_MAX_SIZE];
+  uint16_t len;  /* Bytes used, header included             */
+  uint8_t seq;   /* Cycle sequence number                   */
+  uint8_t count; /* Records batched                         */
+} packet_super_t;
+
 /* For backward compat (old code references PACKET_MAX_SIZE for the packet) */
 typedef telemetry_pack_frame_t telemetry_packet_t;
 
@@ -128,6 +314,111 @@ uint8_t packet_encode_module(telemetry_module_frame_t *pkt,
                              uint8_t module_index,
                              const sensor_snapshot_t *sensors);
 
+/* Encode one loop latency frame. Returns frame size. */
+uint8_t packet_encode_latency(telemetry_latency_frame_t *pkt, uint8_t stage,
+                              const lat_stage_stats_t *st);
+
+/* Encode one group voltage frame. Returns frame size. */
+uint8_t packet_encode_groups(telemetry_group_frame_t *pkt,
+                             uint8_t module_index,
+                             const sensor_snapshot_t *sensors);
+
+/* Encode a rate request frame. Returns frame size. */
+uint8_t packet_encode_rate(telemetry_rate_frame_t *pkt, module_mask_t boosted,
+                           uint16_t fast_ms, uint16_t slow_ms);
+
+/* Group voltage streaming: min_interval_ms between frames for the same
+ * module (0 = PACKET_GROUPS_MIN_INTERVAL_MS). */
+void packet_groups_init(packet_group_stream_t *gs, uint16_t min_interval_ms);
+
+/* Select and encode this cycle's group frames for the flagged modules.
+ * Returns the number written to out (≤ PACKET_GROUPS_MAX_PER_CYCLE). */
+uint8_t packet_groups_poll(
+    packet_group_stream_t *gs, uint32_t now_ms,
+    const sensor_snapshot_t *sensors, module_mask_t flagged,
+    telemetry_group_frame_t out[PACKET_GROUPS_MAX_PER_CYCLE]);
+
+/* Compact telemetry: init with key_interval cycles per keyframe
+ * (0 = PACKET_COMPACT_KEY_INTERVAL); the first cycle is a keyframe. */
+void packet_compact_init(packet_compact_enc_t *enc, uint8_t key_interval);
+
+/* Make the next cycle a keyframe (mode change, dropped frame) */
+void packet_compact_request_key(packet_compact_enc_t *enc);
+
+/* Capture one telemetry cycle. Quantises exactly as the legacy frames. */
+void packet_compact_begin(packet_compact_enc_t *enc, uint32_t timestamp_ms,
+                          const sensor_snapshot_t *sensors,
+                          const anomaly_result_t *anomaly,
+                          system_state_t state);
+
+/* Emit the next frame of the cycle into buf (PACKET_COMPACT_MAX_SIZE
+ * bytes). Returns the frame size, or 0 once the cycle is complete. */
+uint8_t packet_compact_next(packet_compact_enc_t *enc, uint8_t *buf);
+
+void packet_compact_dec_init(packet_compact_dec_t *dec);
+
+/* Apply one compact frame. Returns 0 if it decoded, -1 if malformed. */
+int packet_compact_decode(packet_compact_dec_t *dec, const uint8_t *frame,
+                          uint8_t length);
+
+/* Rebuild legacy frames from decoded fields. Return 0, or -1 if the
+ * block has not seen a keyframe since the last gap. */
+int packet_compact_pack_frame(const packet_compact_dec_t *dec,
+                              telemetry_pack_frame_t *pkt);
+int packet_compact_module_frame(const packet_compact_dec_t *dec,
+                                uint8_t module_index,
+                                telemetry_module_frame_t *pkt);
+
+/* Superframe: start an empty one for cycle seq */
+void packet_super_begin(packet_super_t *sf, uint8_t seq);
+
+/* Batch one v1 frame (any type, length from its header). Returns false
+ * if it does not fit — finish and send, begin again, then retry. */
+bool packet_super_add(packet_super_t *sf, const uint8_t *frame);
+
+/* Write LEN and CRC. Returns the frame size, or 0 if nothing was added. */
+uint16_t packet_super_finish(packet_super_t *sf);
+
+/* Validate a superframe. Returns its record count, or -1 if malformed. */
+int packet_super_validate(const uint8_t *frame, uint16_t length);
+
+/* Input-link frames (input_packet.h) rebuilt from a snapshot, as the
+ * twin would have sent them — the black-box record format, replayable
+ * through input_rx_feed(). Values are rounded to the wire units. */
+void packet_encode_input_pack(input_pack_frame_t *frame,
+                              const sensor_snapshot_t *sensors);
+void packet_encode_input_module(input_module_frame_t *frame,
+                                uint8_t module_index,
+                                const sensor_snapshot_t *sensors);
+
+/* The snapshot encoders again, from the fixed-point snapshot whose
+ * fields are already wire units (ANOMALY_EVAL_FIXED_POINT builds). Same
+ * frames, with exact values where the float encoders truncate. */
+uint8_t packet_encode_pack_fx(telemetry_pack_frame_t *pkt,
+                              uint32_t timestamp_ms,
+                              const sensor_snapshot_fx_t *sensors,
+                              const anomaly_result_t *anomaly,
+                              system_state_t state);
+uint8_t packet_encode_module_fx(telemetry_module_frame_t *pkt,
+                                uint8_t module_index,
+                                const sensor_snapshot_fx_t *sensors);
+uint8_t packet_encode_groups_fx(telemetry_group_frame_t *pkt,
+                                uint8_t module_index,
+                                const sensor_snapshot_fx_t *sensors);
+uint8_t packet_groups_poll_fx(
+    packet_group_stream_t *gs, uint32_t now_ms,
+    const sensor_snapshot_fx_t *sensors, module_mask_t flagged,
+    telemetry_group_frame_t out[PACKET_GROUPS_MAX_PER_CYCLE]);
+void packet_compact_begin_fx(packet_compact_enc_t *enc, uint32_t timestamp_ms,
+                             const sensor_snapshot_fx_t *sensors,
+                             const anomaly_result_t *anomaly,
+                             system_state_t state);
+void packet_encode_input_pack_fx(input_pack_frame_t *frame,
+                                 const sensor_snapshot_fx_t *sensors);
+void packet_encode_input_module_fx(input_module_frame_t *frame,
+                                   uint8_t module_index,
+                                   const sensor_snapshot_fx_t *sensors);
+
 /* Compute XOR checksum over a buffer */
 uint8_t packet_checksum(const uint8_t *data, uint8_t length);
 
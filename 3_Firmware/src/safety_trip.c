@@ -0,0 +1,51 @@
+/*
+ * safety_trip.c — Pre-emptive Short-Circuit Trip
+ */
+
+#include "safety_trip.h"
+#include "hal_gpio.h"
+#include <string.h>
+
+void safety_trip_init(safety_trip_t *t, const anomaly_thresholds_t *th) {
+  memset(t, 0, sizeof(safety_trip_t));
+  safety_trip_set_limit(t, th);
+}
+
+void safety_trip_set_limit(safety_trip_t *t, const anomaly_thresholds_t *th) {
+  t->short_a = th->current_short_a;
+  t->short_da = (int32_t)(th->current_short_a * 10.0f);
+}
+
+/* Relay first, bookkeeping after */
+static bool trip_fire(safety_trip_t *t) {
+  if (t->tripped)
+    return false;
+
+  hal_gpio_relay_disconnect();
+  hal_gpio_set_status_leds(3);
+  t->tripped = true;
+  t->pending_eval = true;
+  t->trip_count++;
+  return true;
+}
+
+bool safety_trip_check_da(safety_trip_t *t, int16_t current_da) {
+  int32_t mag = current_da < 0 ? -(int32_t)current_da : current_da;
+  return (mag > t->short_da) ? trip_fire(t) : false;
+}
+
+bool safety_trip_check_a(safety_trip_t *t, float current_a) {
+  float mag = current_a < 0.0f ? -current_a : current_a;
+  return (mag > t->short_a) ? trip_fire(t) : false;
+}
+
+bool safety_trip_take_pending(safety_trip_t *t) {
+  bool pending = t->pending_eval;
+  t->pending_eval = false;
+  return pending;
+}
+
+void safety_trip_clear(safety_trip_t *t) {
+  t->tripped = false;
+  t->pending_eval = false;
+}
@@ -0,0 +1,51 @@
+/*
+ * safety_trip.h — Pre-emptive Short-Circuit Trip
+ *
+ * The fast loop only sees pack current every 100 ms (20 ms in alert)
+ * and runs a full evaluation before it acts. This path compares each
+ * current sample against current_short_a the moment it is decoded —
+ * pack input frame, INA219 or ADC reading — and opens the relay from
+ * that context. The full anomaly/correlation pass follows on the next
+ * scheduler pass via safety_trip_take_pending().
+ *
+ * The frame path compares integers in wire units (deci-amps), so the
+ * trip costs a few instructions even without an FPU.
+ */
+
+#ifndef SAFETY_TRIP_H
+#define SAFETY_TRIP_H
+
+#include "anomaly_eval.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  int32_t short_da;  /* |I| above this trips, deci-amps          */
+  float short_a;     /* Same threshold in amps (sensor samples)  */
+  bool tripped;      /* Relay opened; latched until clear        */
+  bool pending_eval; /* Correlation pass not yet run for a trip  */
+  uint32_t trip_count;
+} safety_trip_t;
+
+/* Load the trip level from current_short_a */
+void safety_trip_init(safety_trip_t *t, const anomaly_thresholds_t *th);
+
+/* Follow a new current_short_a; a trip already latched stays latched */
+void safety_trip_set_limit(safety_trip_t *t, const anomaly_thresholds_t *th);
+
+/*
+ * Check a decoded pack current in deci-amps (input_pack_frame_t).
+ * Opens the relay if over the limit. Returns true only for a new trip.
+ */
+bool safety_trip_check_da(safety_trip_t *t, int16_t current_da);
+
+/* Same check for a sensor sample in amps (INA219, ADC) */
+bool safety_trip_check_a(safety_trip_t *t, float current_a);
+
+/* True once per trip: the caller owes a full evaluation */
+bool safety_trip_take_pending(safety_trip_t *t);
+
+/* Re-arm after recovery (does not reconnect the relay) */
+void safety_trip_clear(safety_trip_t *t);
+
+#endif /* SAFETY_TRIP_H */
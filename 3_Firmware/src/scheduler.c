@@ -0,0 +1,109 @@
+/*
+ * scheduler.c — Periodic Deadline Scheduler
+ *
+ * All time comparisons use signed 32-bit differences, so the schedule
+ * keeps working across the millisecond counter wrap.
+ */
+
+#include "scheduler.h"
+#include <string.h>
+
+/* True if `deadline` is at or before `now` (wrap-safe) */
+static inline bool time_reached(uint32_t now, uint32_t deadline) {
+  return (int32_t)(now - deadline) >= 0;
+}
+
+/* -----------------------------------------------------------------------
+ * Setup
+ * ----------------------------------------------------------------------- */
+void sched_init(sched_t *s) { memset(s, 0, sizeof(sched_t)); }
+
+int sched_add(sched_t *s, sched_task_fn_t fn, uint32_t period_ms,
+              uint8_t priority, uint32_t now_ms) {
+  if (s->count >= SCHED_MAX_TASKS || fn == NULL || period_ms == 0)
+    return -1;
+
+  uint8_t id = s->count;
+  sched_task_t *t = &s->tasks[id];
+  t->fn = fn;
+  t->period_ms = period_ms;
+  t->next_ms = now_ms;
+  t->priority = priority;
+  t->runs = 0;
+  t->missed = 0;
+
+  /* Insertion into the priority order; equal priorities keep
+   * registration order */
+  uint8_t pos = s->count;
+  while (pos > 0 && s->tasks[s->order[pos - 1]].priority > priority) {
+    s->order[pos] = s->order[pos - 1];
+    pos--;
+  }
+  s->order[pos] = id;
+  s->count++;
+  return id;
+}
+
+void sched_set_period(sched_t *s, int id, uint32_t period_ms, uint32_t now_ms) {
+  if (id < 0 || id >= s->count || period_ms == 0)
+    return;
+
+  sched_task_t *t = &s->tasks[id];
+  t->period_ms = period_ms;
+  if ((int32_t)(t->next_ms - (now_ms + period_ms)) > 0)
+    t->next_ms = now_ms + period_ms;
+}
+
+void sched_trigger(sched_t *s, int id, uint32_t now_ms) {
+  if (id < 0 || id >= s->count)
+    return;
+  s->tasks[id].next_ms = now_ms;
+}
+
+void sched_reset(sched_t *s, uint32_t now_ms) {
+  for (uint8_t i = 0; i < s->count; i++) {
+    s->tasks[i].next_ms = now_ms;
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Dispatch
+ * ----------------------------------------------------------------------- */
+uint8_t sched_run_due(sched_t *s, uint32_t now_ms) {
+  uint8_t ran = 0;
+
+  for (uint8_t i = 0; i < s->count; i++) {
+    sched_task_t *t = &s->tasks[s->order[i]];
+    if (!time_reached(now_ms, t->next_ms))
+      continue;
+
+    t->next_ms += t->period_ms;
+    if (time_reached(now_ms, t->next_ms)) {
+      /* More than a period late — drop the backlog, realign to now */
+      uint32_t behind = now_ms - t->next_ms;
+      t->missed += behind / t->period_ms + 1u;
+      t->next_ms = now_ms + t->period_ms;
+    }
+
+    t->fn();
+    t->runs++;
+    ran++;
+  }
+
+  return ran;
+}
+
+uint32_t sched_ms_until_next(const sched_t *s, uint32_t now_ms) {
+  uint32_t best = UINT32_MAX;
+
+  for (uint8_t i = 0; i < s->count; i++) {
+    const sched_task_t *t = &s->tasks[i];
+    if (time_reached(now_ms, t->next_ms))
+      return 0;
+    uint32_t wait = t->next_ms - now_ms;
+    if (wait < best)
+      best = wait;
+  }
+
+  return best;
+}
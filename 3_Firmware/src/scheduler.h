@@ -0,0 +1,78 @@
+/*
+ * scheduler.h — Periodic Deadline Scheduler
+ *
+ * Runs the fast/med/slow loops off the monotonic millisecond clock.
+ * Each task has a period and a priority; when several are due in the
+ * same pass they run highest priority first.
+ *
+ * Deadlines advance by whole periods from the previous deadline, not
+ * from the time the task actually ran, so a late pass does not push
+ * every later release back. A task that falls more than a full period
+ * behind skips the missed releases (counted in `missed`) instead of
+ * running back-to-back to catch up.
+ *
+ * Every call takes the current time from the caller; the scheduler
+ * never reads a clock, so main.c feeds it hal_timer_millis().
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*sched_task_fn_t)(void);
+
+typedef struct {
+  sched_task_fn_t fn;
+  uint32_t period_ms;
+  uint32_t next_ms;  /* Absolute deadline of the next release      */
+  uint8_t priority;  /* 0 = highest                                */
+  uint32_t runs;     /* Completed releases                         */
+  uint32_t missed;   /* Releases skipped because we fell behind    */
+} sched_task_t;
+
+typedef struct {
+  sched_task_t tasks[SCHED_MAX_TASKS];
+  uint8_t order[SCHED_MAX_TASKS]; /* Task ids sorted by priority */
+  uint8_t count;
+} sched_t;
+
+/* Remove all tasks */
+void sched_init(sched_t *s);
+
+/*
+ * Register a task, first due at `now_ms`.
+ * Returns the task id, or -1 if the table is full or the period is 0.
+ */
+int sched_add(sched_t *s, sched_task_fn_t fn, uint32_t period_ms,
+              uint8_t priority, uint32_t now_ms);
+
+/*
+ * Change a task's period. If the new period would make the pending
+ * deadline later than `now_ms + period_ms`, the deadline is pulled in
+ * so a switch to alert rates takes effect immediately.
+ */
+void sched_set_period(sched_t *s, int id, uint32_t period_ms, uint32_t now_ms);
+
+/* Make one task due at `now_ms` (event-driven release); its grid
+ * restarts from there */
+void sched_trigger(sched_t *s, int id, uint32_t now_ms);
+
+/* Make every task due at `now_ms` */
+void sched_reset(sched_t *s, uint32_t now_ms);
+
+/*
+ * Run every task whose deadline has passed, in priority order.
+ * Due-ness is re-checked just before each task, so a task may
+ * reschedule another (e.g. alert mode) within the same pass.
+ * Returns the number of tasks run.
+ */
+uint8_t sched_run_due(sched_t *s, uint32_t now_ms);
+
+/* Milliseconds until the earliest deadline (0 if something is due) */
+uint32_t sched_ms_until_next(const sched_t *s, uint32_t now_ms);
+
+#endif /* SCHEDULER_H */
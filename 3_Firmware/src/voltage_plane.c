@@ -0,0 +1,37 @@
+/*
+ * voltage_plane.c — Pack Voltage Plane Scan
+ */
+
+#include "voltage_plane.h"
+
+void voltage_plane_scan(const voltage_plane_t *p, voltage_plane_stats_t *st) {
+  int32_t sum[NUM_MODULES];
+  int16_t lo[NUM_MODULES];
+  int16_t hi[NUM_MODULES];
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    sum[m] = 0;
+    lo[m] = INT16_MAX;
+    hi[m] = INT16_MIN;
+  }
+
+  /* Hot loop: every lane does the same add/min/max — keep it free of
+   * branches and early exits so it stays vectorisable */
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    const int16_t *row = p->mv[g];
+    for (int m = 0; m < NUM_MODULES; m++) {
+      int16_t v = row[m];
+      sum[m] += v;
+      lo[m] = v < lo[m] ? v : lo[m];
+      hi[m] = v > hi[m] ? v : hi[m];
+    }
+  }
+
+  for (int m = 0; m < NUM_MODULES; m++) {
+    st->sum_mv[m] = sum[m];
+    st->mean_mv[m] = (int16_t)((sum[m] + GROUPS_PER_MODULE / 2) /
+                               GROUPS_PER_MODULE);
+    st->min_mv[m] = lo[m];
+    st->max_mv[m] = hi[m];
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * voltage_plane.h — Pack Voltage Plane (Structure-of-Arrays)
+ *
+ * All 104 group voltages as one contiguous block of int16 millivolts,
+ * stored group-major: mv[g][m] is group g of module m. The modules of
+ * one group sit side by side, so the scan's inner loop runs across
+ * modules with no stride, no early exit and no branch — the shape the
+ * compiler turns into SIMD min/max/add (SSE/NEON on host, and the
+ * RISC-V P or V extension if a future core has one).
+ *
+ * One fused pass gives per-module sum, min and max. The deviation
+ * check needs nothing more: the group furthest from the module mean is
+ * always the min or the max, so
+ *
+ *   any |13·V_g - sum| > 13·dev   <=>   max(13·max - sum, sum - 13·min) > 13·dev
+ *
+ * which replaces the second per-group pass with two compares.
+ *
+ * The fixed-point evaluator keeps its snapshot voltages in this form
+ * (sensor_snapshot_fx_t.vplane).
+ */
+
+#ifndef VOLTAGE_PLANE_H
+#define VOLTAGE_PLANE_H
+
+#include "anomaly_eval.h"
+
+typedef struct {
+  int16_t mv[GROUPS_PER_MODULE][NUM_MODULES];
+} voltage_plane_t;
+
+typedef struct {
+  int32_t sum_mv[NUM_MODULES];  /* Exact: 13 × module mean            */
+  int16_t mean_mv[NUM_MODULES]; /* sum / 13, rounded to nearest       */
+  int16_t min_mv[NUM_MODULES];
+  int16_t max_mv[NUM_MODULES];
+} voltage_plane_stats_t;
+
+/* Group voltage of module m, group g */
+#define VPLANE_MV(plane, m, g) ((plane)->mv[(g)][(m)])
+
+/*
+ * True if some group of a module deviates from the module mean by more
+ * than `dev_x13_mv` / GROUPS_PER_MODULE millivolts, from the module's
+ * extremes alone.
+ */
+static inline bool voltage_plane_dev_exceeds(int32_t sum_mv, int32_t min_mv,
+                                             int32_t max_mv,
+                                             int32_t dev_x13_mv) {
+  /* Both compares, no branch: this sits in per-module loops */
+  return (max_mv * GROUPS_PER_MODULE - sum_mv > dev_x13_mv) |
+         (sum_mv - min_mv * GROUPS_PER_MODULE > dev_x13_mv);
+}
+
+/* One pass over the plane: sums, extremes and means */
+void voltage_plane_scan(const voltage_plane_t *plane,
+                        voltage_plane_stats_t *stats);
+
+#endif /* VOLTAGE_PLANE_H */
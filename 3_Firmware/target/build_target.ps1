@@ -1,7 +1,14 @@
 param(
     [string]$ToolPrefix = "",
     [string]$BuildDir = "3_Firmware\\build",
-    [switch]$Clean
+    [switch]$Clean,
+    [switch]$FixedPoint,
+    [switch]$Sensors,
+    [switch]$Footprint,
+    [ValidateSet("EV_8M", "BUS_16M", "STORAGE_24M")]
+    [string]$PackProfile = "EV_8M",
+    [string]$PackConfigHeader = "",
+    [double]$BudgetScale = 0
 )
 
 $ErrorActionPreference = "Stop"
@@ -17,6 +24,7 @@ if (-not $ToolPrefix) {
 $cc = "${ToolPrefix}gcc"
 $objcopy = "${ToolPrefix}objcopy"
 $sizeTool = "${ToolPrefix}size"
+$readelf = "${ToolPrefix}readelf"
 
 function Assert-Tool([string]$name) {
     if (-not (Get-Command $name -ErrorAction SilentlyContinue)) {
@@ -27,6 +35,7 @@ function Assert-Tool([string]$name) {
 Assert-Tool $cc
 Assert-Tool $objcopy
 Assert-Tool $sizeTool
+Assert-Tool $readelf
 
 $repoRoot = (Get-Location).Path
 if (-not (Test-Path "3_Firmware\\src\\main.c")) {
@@ -37,19 +46,67 @@ if ($Clean -and (Test-Path $BuildDir)) {
     Remove-Item -Recurse -Force $BuildDir
 }
 New-Item -ItemType Directory -Force -Path $BuildDir | Out-Null
+# Call graphs for the stack report; a stale one would skew it
+Get-ChildItem -Path $BuildDir -Filter *.ci | Remove-Item -Force
+
+# Regenerate the NTC table if its parameters in ntc_lut.h changed
+$python = if (Get-Command python -ErrorAction SilentlyContinue) { "python" } else { "python3" }
+& $python "3_Firmware\\target\\gen_ntc_table.py"
+if ($LASTEXITCODE -ne 0) {
+    throw "NTC table generation failed"
+}
 
 $sources = @(
     "3_Firmware\\target\\startup.S",
     "3_Firmware\\target\\syscalls.c",
+    "3_Firmware\\target\\trap.c",
     "3_Firmware\\src\\main.c",
     "3_Firmware\\src\\anomaly_eval.c",
+    "3_Firmware\\src\\anomaly_eval_fx.c",
+    "3_Firmware\\src\\blackbox.c",
     "3_Firmware\\src\\correlation_engine.c",
+    "3_Firmware\\src\\crc16.c",
+    "3_Firmware\\src\\hal_flash.c",
     "3_Firmware\\src\\hal_gpio.c",
+    "3_Firmware\\src\\hal_i2c.c",
+    "3_Firmware\\src\\hal_timer.c",
+    "3_Firmware\\src\\history.c",
     "3_Firmware\\src\\hal_uart.c",
     "3_Firmware\\src\\input_packet.c",
-    "3_Firmware\\src\\packet_format.c"
+    "3_Firmware\\src\\latency_stats.c",
+    "3_Firmware\\src\\log_event.c",
+    "3_Firmware\\src\\module_rate.c",
+    "3_Firmware\\src\\ntc_lut.c",
+    "3_Firmware\\src\\online_stats.c",
+    "3_Firmware\\src\\packet_format.c",
+    "3_Firmware\\src\\safety_trip.c",
+    "3_Firmware\\src\\scheduler.c",
+    "3_Firmware\\src\\voltage_plane.c"
 )
 
+if ($Sensors) {
+    # On-board sensor acquisition (src/acquire.h) and its drivers
+    $sources += @(
+        "3_Firmware\\src\\acquire.c",
+        "3_Firmware\\src\\hal_adc.c",
+        "3_Firmware\\src\\ntc_scan.c",
+        "3_Firmware\\drivers\\bme680.c",
+        "3_Firmware\\drivers\\fsr.c",
+        "3_Firmware\\drivers\\ina219.c"
+    )
+}
+
+# Zicsr (csrr/csrw/csrs, used by startup.S and the HALs) is its own
+# extension since GCC 12 / binutils 2.38, which reject those instructions
+# under plain rv32imac. Older toolchains do not know the suffix.
+$march = "rv32imac_zicsr"
+$probe = Join-Path $BuildDir "march_probe.o"
+"" | & $cc "-march=$march" "-mabi=ilp32" -x c -c - -o $probe 2>$null
+if ($LASTEXITCODE -ne 0) {
+    $march = "rv32imac"
+}
+Remove-Item -Force -ErrorAction SilentlyContinue $probe
+
 $includes = @(
     "-I3_Firmware\\src",
     "-I3_Firmware\\target"
@@ -65,20 +122,54 @@ $cflags = @(
     "-Wall",
     "-Wextra",
     "-Wno-unused-parameter",
-    "-march=rv32imac",
+    "-fcallgraph-info=su",
+    "-march=$march",
     "-mabi=ilp32"
 )
 
+if ($FixedPoint) {
+    # Integer evaluator in wire units (no soft-float on the eval path)
+    $cflags += "-DANOMALY_EVAL_FIXED_POINT=1"
+}
+
+if ($Footprint) {
+    # Whole-program LTO; the objects keep their code (fat) so the budget
+    # report can trace each symbol back to the one that defined it
+    $cflags += "-flto"
+    $cflags += "-ffat-lto-objects"
+}
+
+if ($Sensors) {
+    # Publish from the sensors instead of the sim when no twin is connected
+    $cflags += "-DACQUIRE_SENSORS=1"
+}
+
+# Pack geometry (src/pack_config.h); a custom header wins over the profile
+if ($PackConfigHeader) {
+    # Force-included, so pack_config.h sees its PACK_* defines first
+    $cflags += "-include"
+    $cflags += $PackConfigHeader
+} else {
+    $cflags += "-DPACK_PROFILE=PACK_PROFILE_$PackProfile"
+}
+
 $ldflags = @(
     "-nostartfiles",
     "-Wl,--gc-sections",
     "-Wl,-Map=$BuildDir\\user.map",
     "-T3_Firmware\\target\\thejas32_linker.ld",
-    "-march=rv32imac",
+    "-march=$march",
     "-mabi=ilp32",
     "-lm"
 )
 
+if ($Footprint) {
+    # LTO call graphs land next to the map (user.ltrans*.ci)
+    $ldflags += "-dumpdir"
+    $ldflags += "$BuildDir\\user."
+    $ldflags += "-Wl,--print-memory-usage"
+}
+
 $objects = @()
 foreach ($src in $sources) {
     $obj = Join-Path $BuildDir (([System.IO.Path]::GetFileNameWithoutExtension($src)) + ".o")
@@ -99,6 +190,26 @@ Write-Host "[OBJCOPY] $bin"
 Write-Host "[SIZE]"
 & $sizeTool $elf
 
+# Per-object RAM/image/stack budgets (size_report.py); the larger pack
+# profiles scale the RAM budgets with their module count
+if ($BudgetScale -le 0) {
+    $BudgetScale = @{ "EV_8M" = 1; "BUS_16M" = 2; "STORAGE_24M" = 3 }[$PackProfile]
+}
+$reportArgs = @(
+    "3_Firmware\\target\\size_report.py",
+    "$BuildDir\\user.map",
+    "--readelf", $readelf,
+    "--scale", $BudgetScale
+)
+if ($Footprint) {
+    $reportArgs += "--strict"
+}
+Write-Host "[BUDGET]"
+& $python @reportArgs
+if ($LASTEXITCODE -ne 0) {
+    throw "Footprint budget exceeded (see the report above)"
+}
+
 Write-Host ""
 Write-Host "Build complete:"
 Write-Host "  ELF: $elf"
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""
+NTC Table Generator
+===================
+
+Writes 3_Firmware/src/ntc_lut_table.h: the ADC code -> deci-degC table
+used by ntc_lut.c, computed with the B-parameter equation from the
+NTC_* parameters in 3_Firmware/src/ntc_lut.h.
+
+Usage:
+  python 3_Firmware/target/gen_ntc_table.py           # (re)write the table
+  python 3_Firmware/target/gen_ntc_table.py --check   # fail if out of date
+"""
+
+import argparse
+import math
+import re
+import sys
+from pathlib import Path
+
+SRC = Path(__file__).resolve().parent.parent / "src"
+HEADER = SRC / "ntc_lut.h"
+TABLE = SRC / "ntc_lut_table.h"
+
+PARAMS = ("NTC_R_NOMINAL", "NTC_T_NOMINAL", "NTC_BETA", "NTC_R_SERIES",
+          "NTC_ADC_MAX", "NTC_LUT_SHIFT")
+
+
+def read_params(text):
+    params = {}
+    for name in PARAMS:
+        m = re.search(r"#define\s+%s\s+([0-9.]+)f?" % name, text)
+        if not m:
+            raise SystemExit("ntc_lut.h: %s not found" % name)
+        params[name] = float(m.group(1))
+    return params
+
+
+def temp_c(adc, p):
+    r_ntc = p["NTC_R_SERIES"] * adc / (p["NTC_ADC_MAX"] - adc)
+    inv_t = (math.log(r_ntc / p["NTC_R_NOMINAL"]) / p["NTC_BETA"] +
+             1.0 / (p["NTC_T_NOMINAL"] + 273.15))
+    return 1.0 / inv_t - 273.15
+
+
+def render(p):
+    step = 1 << int(p["NTC_LUT_SHIFT"])
+    adc_max = int(p["NTC_ADC_MAX"])
+    entries = 4096 // step + 1
+    values = []
+    for k in range(entries):
+        adc = min(max(k * step, 1), adc_max - 1)  # Rails clamp inward
+        dc = int(round(temp_c(adc, p) * 10.0))
+        values.append(max(-32767, min(32767, dc)))
+
+    rows = []
+    for i in range(0, entries, 10):
+        rows.append("    " + ", ".join("%d" % v for v in values[i:i + 10]) +
+                    ",")
+
+    return "\n".join([
+        "/*",
+        " * ntc_lut_table.h — NTC ADC → deci-°C Table "
+        "(generated)",
+        " *",
+        " * Generated by target/gen_ntc_table.py from ntc_lut.h; do not "
+        "edit.",
+        " * Entry k is the temperature at ADC code %d·k (the rails "
+        "clamped" % step,
+        " * to codes 1 and %d). Included by ntc_lut.c only." % (adc_max - 1),
+        " */",
+        "",
+        "#define NTC_LUT_GEN_R_NOMINAL %d" % p["NTC_R_NOMINAL"],
+        "#define NTC_LUT_GEN_T_NOMINAL %d" % p["NTC_T_NOMINAL"],
+        "#define NTC_LUT_GEN_BETA %d" % p["NTC_BETA"],
+        "#define NTC_LUT_GEN_R_SERIES %d" % p["NTC_R_SERIES"],
+        "#define NTC_LUT_GEN_ADC_MAX %d" % adc_max,
+        "#define NTC_LUT_GEN_SHIFT %d" % p["NTC_LUT_SHIFT"],
+        "",
+        "static const int16_t ntc_lut_table[%d] = {" % entries,
+        *rows,
+        "};",
+        "",
+    ])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("--check", action="store_true",
+                    help="exit 1 if the table does not match ntc_lut.h")
+    args = ap.parse_args()
+
+    text = render(read_params(HEADER.read_text(encoding="utf-8")))
+    current = TABLE.read_text(encoding="utf-8") if TABLE.exists() else ""
+    if args.check:
+        if current != text:
+            print("ntc_lut_table.h is out of date; run gen_ntc_table.py")
+            return 1
+        return 0
+    if current != text:
+        TABLE.write_text(text, encoding="utf-8", newline="\n")
+        print("[GEN] %s" % TABLE)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,408 @@
+#!/usr/bin/env python3
+"""
+Footprint Budget Report
+=======================
+
+Reads the linker map of a target build (user.map) and the call graphs
+the compiler wrote next to it (-fcallgraph-info=su, *.ci), and prints
+per object: the code, fast code, constants, initialised data and bss it
+puts in the image, and the deepest stack its functions can reach with
+everything they call. Each is checked against BUDGETS below, and the
+whole image against the SRAM and stack sizes in thejas32_linker.ld.
+
+THEJAS32 loads and runs everything from SRAM, so "image" (what
+upload.py sends: code + const + data) and "ram" (data + bss) both come
+out of the same 256 KB, together with the heap and the stack.
+
+With LTO the map lists the link-time partitions instead of the objects;
+pass --readelf and each of their sections is traced back, by symbol, to
+the (fat) object that defined it.
+
+Usage:
+  python 3_Firmware/target/size_report.py 3_Firmware/build/user.map
+  python 3_Firmware/target/size_report.py 3_Firmware/build/user.map \\
+      --readelf riscv64-unknown-elf-readelf --scale 2 --strict
+
+Exit status 1 with --strict when a budget is exceeded.
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+LINKER_SCRIPT = Path(__file__).resolve().parent / "thejas32_linker.ld"
+
+# Per object, default pack profile (EV_8M): image, ram, stack bytes.
+# --scale multiplies the ram budgets for the bigger profiles. Raise a
+# budget in the same change that needs it, with the reason.
+BUDGETS = {
+    "startup":            (256,    0,     0),
+    "syscalls":           (1024,   64,    128),
+    "trap":               (1024,   64,    128),
+    "main":               (24576,  24576, 3072),
+    "anomaly_eval":       (6144,   64,    512),
+    "anomaly_eval_fx":    (6144,   64,    512),
+    "blackbox":           (3072,   512,   384),
+    "correlation_engine": (1536,   0,     128),
+    "crc16":              (768,    0,     64),
+    "hal_flash":          (1024,   64,    128),
+    "hal_gpio":           (1024,   64,    128),
+    "hal_i2c":            (3072,   512,   256),
+    "hal_timer":          (768,    64,    128),
+    "history":            (3072,   0,     256),
+    "hal_uart":           (1536,   1024,  128),
+    "input_packet":       (3072,   64,    256),
+    "latency_stats":      (1536,   0,     256),
+    "log_event":          (3072,   64,    512),
+    "module_rate":        (1536,   0,     128),
+    "ntc_lut":            (2560,   0,     64),
+    "online_stats":       (2048,   0,     256),
+    "packet_format":      (4096,   0,     384),
+    "safety_trip":        (512,    0,     64),
+    "scheduler":          (1024,   64,    128),
+    "voltage_plane":      (2048,   0,     256),
+    # -Sensors
+    "acquire":            (3072,   0,     384),
+    "hal_adc":            (768,    64,    128),
+    "ntc_scan":           (2048,   0,     256),
+    "bme680":             (4096,   128,   384),
+    "fsr":                (512,    0,     64),
+    "ina219":             (768,    0,     128),
+}
+
+# Whole image
+FAST_TEXT_BUDGET = 8192   # Hot loops (HAL_FAST_CODE) kept this compact
+SRAM_MARGIN = 16384       # SRAM left for growth after heap and stack
+TRAP_FRAME_BYTES = 64     # trap_entry (startup.S) saves 16 registers
+STACK_ROOTS = ("main", "trap_handler")
+
+KIND = {
+    ".init": "code", ".text": "code", ".fini": "code",
+    ".fast_text": "fast",
+    ".rodata": "const", ".srodata": "const", ".preinit_array": "const",
+    ".init_array": "const", ".fini_array": "const", ".ctors": "const",
+    ".dtors": "const",
+    ".data": "data", ".sdata": "data",
+    ".bss": "bss", ".sbss": "bss",
+}
+COLUMNS = ("code", "fast", "const", "data", "bss")
+
+OUT_RE = re.compile(r"^(\.\S+)(?:\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?\s*$")
+IN_RE = re.compile(r"^ (\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+SYM_RE = re.compile(r"^\s+0x([0-9a-f]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+SUFFIX_RE = re.compile(r"\.(lto_priv|constprop|isra|part|cold)\.\d+$")
+
+
+def object_name(path):
+    """'build\\main.o' -> 'main'; 'x/libc.a(memcpy.o)' -> 'libc.a'"""
+    base = re.split(r"[\\/]", path.strip())[-1]
+    m = re.match(r"([^()]+\.a)\(", base)
+    if m:
+        return m.group(1)
+    return base[:-2] if base.endswith(".o") else base
+
+
+def is_ltrans(path):
+    return ".ltrans" in path
+
+
+def strip_suffix(name):
+    while True:
+        new = SUFFIX_RE.sub("", name)
+        if new == name:
+            return name
+        name = new
+
+
+# ---- Map ---------------------------------------------------------------
+
+def parse_map(text):
+    """Input sections as (kind, section, addr, size, file, [(addr, sym)])"""
+    start = text.find("Linker script and memory map")
+    lines = text[start:].splitlines() if start >= 0 else []
+    out_kind = None
+    pending = None  # Input section name on a line of its own
+    sections = []
+    for line in lines:
+        if not line.strip():
+            continue
+        if not line.startswith(" "):
+            m = OUT_RE.match(line)
+            out_kind = KIND.get(m.group(1)) if m else None
+            pending = None
+            continue
+        if out_kind is None:
+            continue
+        m = IN_RE.match(line)
+        if m:
+            name = m.group(1) or pending
+            pending = None
+            if not name or name.startswith("*"):
+                continue  # *fill* and script patterns
+            size = int(m.group(3), 16)
+            if size:
+                sections.append([out_kind, name, int(m.group(2), 16), size,
+                                 m.group(4).strip(), []])
+            continue
+        m = SYM_RE.match(line)
+        if m:
+            if sections and "=" not in line:
+                sections[-1][5].append((int(m.group(1), 16), m.group(2)))
+            continue
+        token = line.split()[0]
+        pending = token if token.startswith(".") or token == "COMMON" else None
+    return sections
+
+
+def elf_symbols(readelf, path):
+    """Defined functions and objects: [(addr, size, name)]"""
+    try:
+        out = subprocess.run([readelf, "-sW", str(path)], capture_output=True,
+                             text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError):
+        return []
+    syms = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 8 and parts[3] in ("FUNC", "OBJECT") and \
+                parts[6] != "UND":
+            syms.append((int(parts[1], 16), int(parts[2], 0), parts[7]))
+    return syms
+
+
+def load_symbols(readelf, files):
+    """name -> [(object, size)] from the fat objects' symbol tables"""
+    table = {}
+    for f in files:
+        for _, size, name in elf_symbols(readelf, f):
+            table.setdefault(name, []).append((object_name(f), size))
+    return table
+
+
+def owner(symbols, name, size):
+    cands = symbols.get(strip_suffix(name))
+    if not cands:
+        return "(lto)"
+    for obj, sz in cands:  # Same-named statics: the one of that size
+        if sz == size:
+            return obj
+    return cands[0][0]
+
+
+def attribute(sections, symbols, image_syms):
+    """object -> {kind: bytes}"""
+    usage = {}
+
+    def add(obj, kind, size):
+        usage.setdefault(obj, dict.fromkeys(COLUMNS, 0))[kind] += size
+
+    for kind, name, addr, size, path, listed in sections:
+        if not is_ltrans(path):
+            add(object_name(path), kind, size)
+            continue
+        # LTO partition: split at the symbols in the section (from the
+        # image, or those the map lists), the head going to the first
+        found = {a: n for a, _, n in image_syms if addr <= a < addr + size}
+        found.update((a, n) for a, n in listed if a not in found)
+        syms = sorted(found.items())
+        if not syms:
+            add(owner(symbols, name.split(".", 2)[-1], size), kind, size)
+            continue
+        bounds = [a for a, _ in syms[1:]] + [addr + size]
+        head = addr
+        for (a, sym), end in zip(syms, bounds):
+            add(owner(symbols, sym, end - a), kind, end - head)
+            head = end
+    return usage
+
+
+# ---- Call graph --------------------------------------------------------
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+FRAME_RE = re.compile(r"(\d+) bytes \(([\w,]+)\)")
+
+
+def parse_callgraphs(files):
+    """(frames, edges, source file of each function, unbounded ones)"""
+    frames, edges, source, unbounded = {}, {}, {}, set()
+    for f in files:
+        for line in Path(f).read_text(errors="replace").splitlines():
+            m = NODE_RE.search(line)
+            if m:
+                title, label = m.group(1), m.group(2).split("\\n")
+                fm = FRAME_RE.search(m.group(2))
+                if fm:  # Defined here (externals have no frame)
+                    frames[title] = int(fm.group(1))
+                    if len(label) > 1:
+                        source[title] = label[1].rsplit(":", 2)[0]
+                    if "dynamic" in fm.group(2) and \
+                            "bounded" not in fm.group(2):
+                        unbounded.add(title)
+                continue
+            m = EDGE_RE.search(line)
+            if m:
+                edges.setdefault(m.group(1), set()).add(m.group(2))
+    return frames, edges, source, unbounded
+
+
+def stack_depths(frames, edges):
+    """Worst stack from each function; recursion is cut and reported"""
+    depth, recursive = {}, set()
+    active = set()
+
+    def visit(fn):
+        if fn in depth:
+            return depth[fn]
+        if fn in active:
+            recursive.add(fn)
+            return 0
+        active.add(fn)
+        worst = max((visit(c) for c in edges.get(fn, ())), default=0)
+        active.discard(fn)
+        depth[fn] = frames.get(fn, 0) + worst
+        return depth[fn]
+
+    sys.setrecursionlimit(10000)
+    for fn in list(frames):
+        visit(fn)
+    return depth, recursive
+
+
+def find_root(depth, name):
+    for fn, d in depth.items():
+        if fn == name or fn.endswith(":" + name):
+            return d
+    return 0
+
+
+# ---- Report ------------------------------------------------------------
+
+def linker_limits(path):
+    text = path.read_text(encoding="utf-8")
+
+    def size(pattern):
+        m = re.search(pattern, text)
+        if not m:
+            raise SystemExit("%s: %s not found" % (path.name, pattern))
+        n, unit = int(m.group(1)), m.group(2)
+        return n * {"": 1, "K": 1024, "M": 1024 * 1024}[unit]
+
+    return (size(r"ram\s*\([^)]*\)\s*:\s*ORIGIN\s*=\s*\w+,\s*"
+                 r"LENGTH\s*=\s*(\d+)([KM]?)"),
+            size(r"__stack_size\s*=\s*(\d+)([KM]?)"),
+            size(r"__heap_size\s*=\s*(\d+)([KM]?)"))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    ap.add_argument("map", help="linker map (user.map)")
+    ap.add_argument("--ci-dir", help="where the *.ci files are "
+                    "(default: the map's directory)")
+    ap.add_argument("--readelf", help="readelf of the toolchain (LTO)")
+    ap.add_argument("--scale", type=float, default=1.0,
+                    help="ram budget multiplier for the pack profile")
+    ap.add_argument("--strict", action="store_true",
+                    help="exit 1 when a budget is exceeded")
+    args = ap.parse_args()
+
+    map_path = Path(args.map)
+    text = map_path.read_text(encoding="utf-8", errors="replace")
+    sections = parse_map(text)
+    if not sections:
+        raise SystemExit("%s: no allocated sections found" % map_path)
+
+    symbols, image_syms = {}, []
+    if any(is_ltrans(s[4]) for s in sections):
+        if not args.readelf:
+            print("note: LTO map; pass --readelf to attribute it by object")
+        else:
+            loaded = re.findall(r"^LOAD (\S+\.o)\s*$", text, re.M)
+            symbols = load_symbols(args.readelf, [f for f in loaded
+                                                  if not is_ltrans(f)])
+            image_syms = elf_symbols(args.readelf,
+                                     map_path.with_suffix(".elf"))
+    usage = attribute(sections, symbols, image_syms)
+
+    ci_dir = Path(args.ci_dir) if args.ci_dir else map_path.parent
+    frames, edges, source, unbounded = parse_callgraphs(
+        sorted(ci_dir.glob("*.ci")))
+    depth, recursive = stack_depths(frames, edges)
+    obj_stack = {}
+    for fn, src in source.items():
+        obj = Path(re.split(r"[\\/]", src)[-1]).stem
+        obj_stack[obj] = max(obj_stack.get(obj, 0), depth.get(fn, 0))
+
+    over = []
+    print("%-20s %7s %6s %6s %6s %7s %7s %7s %6s" %
+          (("object",) + COLUMNS + ("image", "ram", "stack")))
+    total = dict.fromkeys(COLUMNS, 0)
+    for obj in sorted(usage, key=lambda o: -sum(usage[o].values())):
+        u = usage[obj]
+        for k in COLUMNS:
+            total[k] += u[k]
+        image = u["code"] + u["fast"] + u["const"] + u["data"]
+        ram = u["data"] + u["bss"]
+        stack = obj_stack.get(obj, 0)
+        flag = ""
+        budget = BUDGETS.get(obj)
+        if budget:
+            lim = (budget[0], int(budget[1] * args.scale), budget[2])
+            for what, val, cap in zip(("image", "ram", "stack"),
+                                      (image, ram, stack), lim):
+                if val > cap:
+                    over.append("%s %s %d > %d" % (obj, what, val, cap))
+                    flag = "  OVER"
+        elif not obj.endswith(".a") and obj != "(lto)":
+            flag = "  (no budget)"
+        print("%-20s %7d %6d %6d %6d %7d %7d %7d %6s%s" %
+              (obj, u["code"], u["fast"], u["const"], u["data"], u["bss"],
+               image, ram, stack or "", flag))
+
+    image = total["code"] + total["fast"] + total["const"] + total["data"]
+    print("%-20s %7d %6d %6d %6d %7d %7d %7d" %
+          ("total", total["code"], total["fast"], total["const"],
+           total["data"], total["bss"], image, total["data"] + total["bss"]))
+
+    sram, stack_size, heap_size = linker_limits(LINKER_SCRIPT)
+    used = image + total["bss"] + heap_size + stack_size
+    worst = {r: find_root(depth, r) for r in STACK_ROOTS}
+    stack_need = sum(worst.values()) + TRAP_FRAME_BYTES
+    print("\nSRAM   %d of %d (image %d + bss %d + heap %d + stack %d), "
+          "%d free" % (used, sram, image, total["bss"], heap_size,
+                       stack_size, sram - used))
+    print("stack  %d of %d (%s + trap frame %d)" %
+          (stack_need, stack_size,
+           " + ".join("%s %d" % kv for kv in worst.items()),
+           TRAP_FRAME_BYTES))
+    if recursive:
+        print("       recursion, not counted: %s" %
+              ", ".join(sorted(recursive)))
+    if unbounded:
+        print("       unbounded frames: %s" % ", ".join(sorted(unbounded)))
+    if not frames:
+        print("       no call graphs in %s (-fcallgraph-info=su)" % ci_dir)
+
+    if total["fast"] > FAST_TEXT_BUDGET:
+        over.append("fast_text %d > %d" % (total["fast"], FAST_TEXT_BUDGET))
+    if used > sram - SRAM_MARGIN:
+        over.append("SRAM %d > %d (%d kept free)" %
+                    (used, sram - SRAM_MARGIN, SRAM_MARGIN))
+    if stack_need > stack_size:
+        over.append("stack %d > %d" % (stack_need, stack_size))
+    if recursive or unbounded:
+        over.append("stack depth not bounded")
+
+    if over:
+        print("\nOver budget:")
+        for line in over:
+            print("  " + line)
+        return 1 if args.strict else 0
+    print("\nAll budgets met")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
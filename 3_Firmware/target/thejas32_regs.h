@@ -21,7 +21,9 @@
  *   0x1000_0100 — 0x1000_01FF   UART0
  *   0x1000_0200 — 0x1000_02FF   UART1
  *   0x1000_0300 — 0x1000_03FF   UART2
+ *   0x1000_0A00 — 0x1000_0A3F   Timers 0-2
  *   0x1008_0000 — 0x101C_0000   GPIO
+ *   0x2001_0000 — 0x2001_00FF   Interrupt controller
  * ----------------------------------------------------------------------- */
 
 /* Helper macro for volatile register access */
@@ -61,6 +63,20 @@
 /* UART FIFO Control Register bits */
 #define UART_FCR_ENABLE (1 << 0) /* FIFO Enable */
 #define UART_FCR_CLEAR (0x06)    /* Clear both FIFOs */
+#define UART_FCR_RX_TRIG_8 (0x80) /* RX interrupt at 8 bytes in FIFO */
+#define UART_FIFO_DEPTH 16
+
+/* UART Interrupt Enable Register bits */
+#define UART_IER_RDI (1 << 0)  /* Received data available / timeout */
+#define UART_IER_THRI (1 << 1) /* Transmit holding register empty */
+
+/* UART Interrupt Identification Register (IIR[3:0]) */
+#define UART_IIR_NONE 0x01     /* No interrupt pending */
+#define UART_IIR_THRE 0x02     /* THR empty */
+#define UART_IIR_RDA 0x04      /* Received data available */
+#define UART_IIR_RLS 0x06      /* Receiver line status (overrun etc.) */
+#define UART_IIR_TIMEOUT 0x0C  /* Character timeout (FIFO not empty) */
+#define UART_IIR_ID_MASK 0x0F
 
 /* Convenience macros for UART0 */
 #define UART0_THR REG32(UART0_BASE + UART_THR)
@@ -71,6 +87,63 @@
 #define UART0_DLL REG32(UART0_BASE + UART_DLL)
 #define UART0_DLH REG32(UART0_BASE + UART_DLH)
 #define UART0_IER REG32(UART0_BASE + UART_IER)
+#define UART0_IIR REG32(UART0_BASE + UART_IIR)
+
+/* -----------------------------------------------------------------------
+ * Interrupt Controller (PLIC-style, VEGA ET1031)
+ *
+ * External peripheral interrupts are routed through the platform
+ * interrupt controller into mip.MEIP. Offsets follow the VEGA SDK
+ * interrupt driver — verify against the THEJAS32 TRM on new boards.
+ * ----------------------------------------------------------------------- */
+#define PLIC_BASE 0x20010000
+#define PLIC_INTR_ENABLE REG32(PLIC_BASE + 0x0000) /* 1 bit per source */
+#define PLIC_INTR_STATUS REG32(PLIC_BASE + 0x0004) /* Pending sources  */
+#define PLIC_CLAIM REG32(PLIC_BASE + 0x0008)       /* Claim/complete   */
+
+/* Interrupt source IDs */
+#define IRQ_UART0 0
+#define IRQ_I2C0 5
+#define IRQ_TIMER0 7
+
+/* Machine-level interrupt enable bits (mie CSR) */
+#define MIE_MTIE (1u << 7)  /* Machine timer interrupt    */
+#define MIE_MEIE (1u << 11) /* Machine external interrupt */
+
+/* mcause values (interrupt bit set) */
+#define MCAUSE_INT_FLAG 0x80000000u
+#define MCAUSE_MTI 7u  /* Machine timer interrupt    */
+#define MCAUSE_MEI 11u /* Machine external interrupt */
+
+/* -----------------------------------------------------------------------
+ * Timers (VEGA ET1031 general-purpose down-counters)
+ *
+ * Each timer reloads from LOAD_COUNT on underflow and raises its
+ * interrupt line; reading EOI clears it. Counters run from the system
+ * clock. Offsets follow the VEGA SDK timer driver — verify against
+ * the THEJAS32 TRM on new boards.
+ * ----------------------------------------------------------------------- */
+#define THEJAS32_SYSCLK_HZ 100000000u
+
+#define TIMER0_BASE 0x10000A00
+
+#define TIMER_LOAD_COUNT 0x00 /* Reload value                 */
+#define TIMER_CURRENT 0x04    /* Current count (read)         */
+#define TIMER_CONTROL 0x08    /* Enable / mode / int mask     */
+#define TIMER_EOI 0x0C        /* Read to clear the interrupt  */
+#define TIMER_INT_STATUS 0x10 /* Interrupt pending            */
+
+/* Timer Control Register bits */
+#define TIMER_CTRL_ENABLE (1 << 0)   /* Start counting            */
+#define TIMER_CTRL_PERIODIC (1 << 1) /* Reload from LOAD_COUNT    */
+#define TIMER_CTRL_INT_MASK (1 << 2) /* 1 = interrupt masked      */
+
+/* Convenience macros for Timer0 */
+#define TIMER0_LOAD_COUNT REG32(TIMER0_BASE + TIMER_LOAD_COUNT)
+#define TIMER0_CURRENT REG32(TIMER0_BASE + TIMER_CURRENT)
+#define TIMER0_CONTROL REG32(TIMER0_BASE + TIMER_CONTROL)
+#define TIMER0_EOI REG32(TIMER0_BASE + TIMER_EOI)
+#define TIMER0_INT_STATUS REG32(TIMER0_BASE + TIMER_INT_STATUS)
 
 /* -----------------------------------------------------------------------
  * GPIO Registers
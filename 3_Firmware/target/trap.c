@@ -0,0 +1,51 @@
+/*
+ * trap.c — Machine-mode trap dispatcher for bare-metal THEJAS32
+ *
+ * startup.S points mtvec at trap_entry, which saves the caller-saved
+ * registers and calls trap_handler() with mcause. We only expect
+ * interrupts here. A synchronous exception opens the relay and then
+ * parks the core: nothing sensible can be resumed, and a stopped
+ * board must leave the pack disconnected, not still connected with
+ * the safety loops dead.
+ */
+#include <stdint.h>
+
+#include "hal_gpio.h"
+#include "hal_i2c.h"
+#include "hal_timer.h"
+#include "hal_uart.h"
+#include "thejas32_regs.h"
+
+static void trap_external(void) {
+  uint32_t pending = PLIC_INTR_STATUS;
+
+  if (pending & (1u << IRQ_UART0)) {
+    hal_uart_isr();
+  }
+  if (pending & (1u << IRQ_TIMER0)) {
+    hal_timer_isr();
+  }
+  if (pending & (1u << IRQ_I2C0)) {
+    hal_i2c_isr();
+  }
+
+  /* Signal completion to the interrupt controller */
+  PLIC_CLAIM = pending;
+}
+
+void trap_handler(uint32_t mcause) {
+  if (mcause & MCAUSE_INT_FLAG) {
+    uint32_t code = mcause & ~MCAUSE_INT_FLAG;
+    if (code == MCAUSE_MEI) {
+      trap_external();
+    }
+    return;
+  }
+
+  /* Synchronous exception — fail safe, then stop. Interrupts stay
+   * masked (the trap cleared mstatus.MIE), so the pin stays put. */
+  hal_gpio_relay_disconnect();
+  while (1) {
+    __asm__ volatile("nop");
+  }
+}
@@ -0,0 +1,504 @@
+/*
+ * bench_eval.c — anomaly_eval_run() Microbenchmark
+ *
+ * Times the reordered evaluator against the one it replaced (kept
+ * below, verbatim, as ref_eval_run) on the cases that matter:
+ *
+ *   nominal       typical pass, nothing active
+ *   hot module    one module over its NTC limit (WARNING)
+ *   multi-fault   every category active on most modules
+ *   short / temp  decided cases, full run and the fast-loop trip path
+ *
+ * Before timing, every case and a sweep of randomised snapshots are
+ * checked field for field against the reference; a mismatch fails the
+ * run. The timed path is the one the loops run, anomaly_eval_run_plan()
+ * on a plan compiled once. Reports ns per call and, on x86, TSC ticks
+ * per call.
+ *
+ * Compile:
+ *   cd 3_Firmware
+ *   gcc -Wall -Wextra -O2 -o bench_eval tests/bench_eval.c \
+ *       src/anomaly_eval.c -I src -lm
+ *
+ * Run:
+ *   ./bench_eval [calls]    (default 200000 per case)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "anomaly_eval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+/* -----------------------------------------------------------------------
+ * Reference: anomaly_eval_run() before the reorder
+ * ----------------------------------------------------------------------- */
+
+static anomaly_result_t ref_eval_run(const anomaly_thresholds_t *t,
+                                     const sensor_snapshot_t *s) {
+  anomaly_result_t result;
+  result.active_mask = CAT_NONE;
+  result.is_short_circuit = false;
+  result.is_emergency_direct = false;
+  result.hotspot_module = s->hotspot_module;
+  result.anomaly_modules_mask = 0;
+  result.stale_modules_mask = s->stale_modules;
+  result.risk_factor = 0.0f;
+  result.cascade_stage = 0;
+
+  /* === ELECTRICAL CATEGORY ===
+   * Pack voltage, per-group voltage spread, current, R_int */
+
+  /* Pack voltage bounds */
+  if (s->pack_voltage_v < t->voltage_low_v ||
+      s->pack_voltage_v > t->voltage_high_v) {
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* Voltage spread across all 104 groups */
+  if (s->v_spread_mv > t->v_spread_warn_mv) {
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* Per-module voltage deviation check. (v - mean) is monotonic in v,
+   * so the worst group is the min or the max found by compute — two
+   * checks per module instead of a second pass over all 13 groups. */
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_t *mod = &s->modules[m];
+    float dev_hi = (mod->v_max_v - mod->mean_group_v) * 1000.0f;
+    float dev_lo = (mod->v_min_v - mod->mean_group_v) * 1000.0f;
+    if (dev_hi < 0)
+      dev_hi = -dev_hi;
+    if (dev_lo < 0)
+      dev_lo = -dev_lo;
+    if (dev_hi > t->group_v_deviation_mv || dev_lo > t->group_v_deviation_mv) {
+      result.active_mask |= CAT_ELECTRICAL;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+
+    /* A group drifting from its own learned offset */
+    if (t->baseline_z_warning > 0.0f && mod->v_dev_z > t->baseline_z_warning) {
+      result.active_mask |= CAT_ELECTRICAL;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+  }
+
+  /* Current check */
+  float abs_current = s->pack_current_a;
+  if (abs_current < 0)
+    abs_current = -abs_current;
+
+  if (abs_current > t->current_warning_a) {
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* Short circuit detection */
+  if (s->short_circuit || abs_current > t->current_short_a) {
+    result.is_short_circuit = true;
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* Emergency current spike (spec §4.3) */
+  if (abs_current > t->current_emergency_a) {
+    result.is_emergency_direct = true;
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* R_int check (group-level: cell R_int / 8) */
+  if (s->r_internal_mohm > t->r_int_warning_mohm) {
+    result.active_mask |= CAT_ELECTRICAL;
+  }
+
+  /* === THERMAL CATEGORY ===
+   * 16 NTC temperatures (2 per module × 8 modules)
+   * + ambient compensation + dT/dt + inter/intra module ΔT */
+
+  /* Find max NTC temperature across all modules */
+  float max_ntc = -999.0f;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    float ntc1 = s->modules[m].ntc1_c;
+    float ntc2 = s->modules[m].ntc2_c;
+
+    /* Absolute threshold check — any NTC */
+    if (ntc1 > t->temp_warning_c || ntc2 > t->temp_warning_c) {
+      result.active_mask |= CAT_THERMAL;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+
+    /* Track max for ambient compensation */
+    if (ntc1 > max_ntc)
+      max_ntc = ntc1;
+    if (ntc2 > max_ntc)
+      max_ntc = ntc2;
+
+    /* Intra-module ΔT check (one half hotter than other) */
+    if (s->modules[m].delta_t_intra > t->intra_module_dt_warn_c) {
+      result.active_mask |= CAT_THERMAL;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+
+    /* Running hotter than the pack, by its own history */
+    if (t->baseline_z_warning > 0.0f &&
+        s->modules[m].ntc_z > t->baseline_z_warning) {
+      result.active_mask |= CAT_THERMAL;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+  }
+
+  /* Inter-module ΔT check (one module much hotter than others) */
+  if (s->temp_spread_c > t->inter_module_dt_warn_c) {
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* Ambient-compensated threshold */
+  float delta_t_ambient = max_ntc - s->temp_ambient_c;
+  if (delta_t_ambient >= t->delta_t_ambient_warning) {
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* Rate of temperature change (max across all modules) */
+  if (s->dt_dt_max > t->dt_dt_warning) {
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* Emergency thermal thresholds (spec §4.3) — direct bypass */
+  if (max_ntc > t->temp_emergency_c || s->dt_dt_max > t->dt_dt_emergency) {
+    result.is_emergency_direct = true;
+    result.active_mask |= CAT_THERMAL;
+  }
+
+  /* === GAS CATEGORY ===
+   * Use worst-case of 2 BME680 sensors (lower ratio = more gas) */
+  float worst_gas =
+      s->gas_ratio_1 < s->gas_ratio_2 ? s->gas_ratio_1 : s->gas_ratio_2;
+
+  if (worst_gas < t->gas_warning_ratio) {
+    result.active_mask |= CAT_GAS;
+  }
+
+  /* Ratio sagging below the sensor's learned baseline */
+  if (t->baseline_z_warning > 0.0f && s->gas_z > t->baseline_z_warning) {
+    result.active_mask |= CAT_GAS;
+  }
+
+  /* === PRESSURE CATEGORY ===
+   * Use worst-case of 2 pressure sensors (higher delta = more pressure) */
+  float worst_pressure = s->pressure_delta_1_hpa > s->pressure_delta_2_hpa
+                             ? s->pressure_delta_1_hpa
+                             : s->pressure_delta_2_hpa;
+
+  if (worst_pressure > t->pressure_warning_hpa) {
+    result.active_mask |= CAT_PRESSURE;
+  }
+
+  /* === SWELLING CATEGORY ===
+   * Check all 8 module swelling sensors */
+  for (int m = 0; m < NUM_MODULES; m++) {
+    if (s->modules[m].swelling_pct > t->swelling_warning_pct) {
+      result.active_mask |= CAT_SWELLING;
+      result.anomaly_modules_mask |= MODULE_BIT(m);
+    }
+  }
+
+  /* === THERMAL RUNAWAY RISK ASSESSMENT ===
+   * Based on real cascade chemistry stages */
+  result.cascade_stage = get_cascade_stage(s->t_core_est_c);
+
+  /* Risk factor: weighted combination of stage, dT/dt, and gas */
+  float risk = 0.0f;
+
+  /* Temperature contribution (linear from 60°C to 300°C) */
+  if (s->t_core_est_c > 60.0f) {
+    risk += (s->t_core_est_c - 60.0f) / 240.0f;
+    if (risk > 1.0f)
+      risk = 1.0f;
+  }
+
+  /* dT/dt contribution (accelerating = worse) */
+  if (s->dt_dt_max > 0.1f) {
+    risk += s->dt_dt_max * 0.05f; /* 20°C/min → adds 1.0 */
+    if (risk > 1.0f)
+      risk = 1.0f;
+  }
+
+  /* Gas contribution (off-gassing = worse) */
+  if (worst_gas < 0.8f) {
+    risk += (0.8f - worst_gas) * 0.5f; /* 0.3 ratio → adds 0.25 */
+    if (risk > 1.0f)
+      risk = 1.0f;
+  }
+
+  /* Pressure contribution */
+  if (worst_pressure > 1.0f) {
+    risk += worst_pressure * 0.02f; /* 10 hPa → adds 0.2 */
+    if (risk > 1.0f)
+      risk = 1.0f;
+  }
+
+  result.risk_factor = risk;
+
+  /* Count total active categories */
+  result.active_count = anomaly_count_categories(result.active_mask);
+
+  return result;
+}
+
+/* -----------------------------------------------------------------------
+ * Cases
+ * ----------------------------------------------------------------------- */
+
+static sensor_snapshot_t make_nominal(void) {
+  sensor_snapshot_t s;
+  memset(&s, 0, sizeof(s));
+  s.pack_voltage_v = 3.2f * (float)TOTAL_SERIES;
+  s.pack_current_a = 60.0f;
+  s.r_internal_mohm = 0.44f;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    s.modules[m].ntc1_c = 28.0f + (float)m * (2.4f / NUM_MODULES);
+    s.modules[m].ntc2_c = 28.2f + (float)m * (2.4f / NUM_MODULES);
+    s.modules[m].swelling_pct = 0.5f;
+    s.modules[m].max_dt_dt = 0.01f;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      s.modules[m].group_voltages_v[g] = 3.20f + 0.001f * (float)(g % 3);
+  }
+  s.temp_ambient_c = 25.0f;
+  s.coolant_inlet_c = 25.0f;
+  s.coolant_outlet_c = 27.0f;
+  s.gas_ratio_1 = 0.98f;
+  s.gas_ratio_2 = 0.97f;
+  s.pressure_delta_1_hpa = 0.1f;
+  s.pressure_delta_2_hpa = 0.1f;
+  s.humidity_pct = 50.0f;
+  s.isolation_mohm = 500.0f;
+  return s;
+}
+
+typedef enum { CASE_NOMINAL, CASE_HOT, CASE_MULTI, CASE_SHORT, CASE_TEMP,
+               CASE_COUNT } bench_case_t;
+
+static const char *const case_names[CASE_COUNT] = {
+    "nominal", "hot module", "multi-fault", "short circuit", "emergency temp"};
+
+static sensor_snapshot_t make_case(bench_case_t c,
+                                   const anomaly_thresholds_t *t) {
+  sensor_snapshot_t s = make_nominal();
+  switch (c) {
+  case CASE_HOT:
+    s.modules[2].ntc1_c = 58.0f;
+    break;
+  case CASE_MULTI:
+    for (int m = 0; m < NUM_MODULES; m++) {
+      s.modules[m].group_voltages_v[m % GROUPS_PER_MODULE] = 3.10f;
+      s.modules[m].ntc1_c = 57.0f + (float)m * 0.1f;
+      s.modules[m].swelling_pct = 4.0f;
+      s.modules[m].max_dt_dt = 1.0f;
+    }
+    s.gas_ratio_1 = 0.5f;
+    s.pressure_delta_2_hpa = 3.0f;
+    break;
+  case CASE_SHORT:
+    s.short_circuit = true;
+    s.pack_current_a = 400.0f;
+    break;
+  case CASE_TEMP:
+    s.modules[5].ntc2_c = 85.0f;
+    break;
+  default:
+    break;
+  }
+  anomaly_eval_compute(&s, t);
+  return s;
+}
+
+/* Deterministic perturbations of the nominal pack around every limit */
+static uint32_t g_rng = 12345u;
+static float rnd(float lo, float hi) {
+  g_rng = g_rng * 1664525u + 1013904223u;
+  return lo + (hi - lo) * (float)(g_rng >> 8) * (1.0f / 16777216.0f);
+}
+
+static sensor_snapshot_t make_random(const anomaly_thresholds_t *t) {
+  sensor_snapshot_t s = make_nominal();
+  s.pack_voltage_v = rnd(250.0f, 390.0f) * (float)TOTAL_SERIES / 104.0f;
+  s.pack_current_a = rnd(-520.0f, 520.0f);
+  s.r_internal_mohm = rnd(0.3f, 0.7f);
+  for (int m = 0; m < NUM_MODULES; m++) {
+    module_data_t *mod = &s.modules[m];
+    mod->ntc1_c = rnd(20.0f, 60.0f);
+    mod->ntc2_c = mod->ntc1_c + rnd(-4.0f, 4.0f);
+    if (rnd(0.0f, 1.0f) < 0.02f)
+      mod->ntc1_c = rnd(75.0f, 90.0f);
+    mod->swelling_pct = rnd(0.0f, 3.5f);
+    mod->max_dt_dt = rnd(0.0f, 0.6f);
+    mod->v_dev_z = rnd(0.0f, 7.0f);
+    mod->ntc_z = rnd(0.0f, 7.0f);
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      mod->group_voltages_v[g] = 3.2f + rnd(-0.012f, 0.012f);
+  }
+  s.temp_ambient_c = rnd(15.0f, 40.0f);
+  s.gas_ratio_1 = rnd(0.6f, 1.0f);
+  s.gas_ratio_2 = rnd(0.6f, 1.0f);
+  s.pressure_delta_1_hpa = rnd(0.0f, 2.5f);
+  s.pressure_delta_2_hpa = rnd(0.0f, 2.5f);
+  s.gas_z = rnd(0.0f, 7.0f);
+  s.short_circuit = rnd(0.0f, 1.0f) < 0.01f;
+  anomaly_eval_compute(&s, t);
+  return s;
+}
+
+static bool same_result(const anomaly_result_t *a, const anomaly_result_t *b) {
+  return a->active_mask == b->active_mask &&
+         a->active_count == b->active_count &&
+         a->is_short_circuit == b->is_short_circuit &&
+         a->is_emergency_direct == b->is_emergency_direct &&
+         a->hotspot_module == b->hotspot_module &&
+         a->anomaly_modules_mask == b->anomaly_modules_mask &&
+         a->stale_modules_mask == b->stale_modules_mask &&
+         a->risk_factor == b->risk_factor &&
+         a->cascade_stage == b->cascade_stage;
+}
+
+/* -----------------------------------------------------------------------
+ * Timing
+ * ----------------------------------------------------------------------- */
+
+typedef anomaly_result_t (*eval_fn_t)(const anomaly_thresholds_t *,
+                                      const sensor_snapshot_t *);
+
+typedef struct {
+  double ns;
+  double ticks; /* TSC ticks, 0 without a TSC */
+} timing_t;
+
+static volatile uint8_t g_sink;
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t now_ticks(void) {
+#if HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* The loops evaluate against a plan compiled once per threshold change */
+static anomaly_plan_t g_plan;
+
+static anomaly_result_t plan_run(const anomaly_thresholds_t *t,
+                                 const sensor_snapshot_t *s) {
+  (void)t;
+  return anomaly_eval_run_plan(&g_plan, s);
+}
+
+static anomaly_result_t plan_run_trip(const anomaly_thresholds_t *t,
+                                      const sensor_snapshot_t *s) {
+  (void)t;
+  return anomaly_eval_run_plan_trip(&g_plan, s);
+}
+
+/* Best of several batches: the least disturbed run is the honest one */
+#define BATCHES 8
+
+static timing_t time_fn(eval_fn_t fn, const anomaly_thresholds_t *t,
+                        const sensor_snapshot_t *s, int calls) {
+  timing_t best = {1e30, 1e30};
+  int per_batch = calls / BATCHES > 0 ? calls / BATCHES : 1;
+  for (int b = 0; b < BATCHES; b++) {
+    uint8_t acc = 0;
+    uint64_t n0 = now_ns(), k0 = now_ticks();
+    for (int i = 0; i < per_batch; i++) {
+      anomaly_result_t r = fn(t, s);
+      acc ^= r.active_mask;
+    }
+    uint64_t k1 = now_ticks(), n1 = now_ns();
+    g_sink ^= acc;
+    double ns = (double)(n1 - n0) / per_batch;
+    double ticks = (double)(k1 - k0) / per_batch;
+    if (ns < best.ns)
+      best.ns = ns;
+    if (ticks < best.ticks)
+      best.ticks = ticks;
+  }
+  return best;
+}
+
+static void print_timing(const char *label, timing_t ref, timing_t now) {
+  printf("  %-16s %8.1f ns -> %8.1f ns  (%5.2fx)", label, ref.ns, now.ns,
+         ref.ns / now.ns);
+  if (HAVE_TSC)
+    printf("   %7.0f -> %7.0f ticks", ref.ticks, now.ticks);
+  printf("\n");
+}
+
+/* -----------------------------------------------------------------------
+ * Main
+ * ----------------------------------------------------------------------- */
+
+#define SWEEP 100000
+
+int main(int argc, char **argv) {
+  int calls = argc > 1 ? atoi(argv[1]) : 200000;
+  if (calls < BATCHES)
+    calls = BATCHES;
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  anomaly_plan_compile(&g_plan, &t);
+
+  printf("Evaluator benchmark: %d modules x %d groups, %d calls per case\n",
+         NUM_MODULES, GROUPS_PER_MODULE, calls);
+
+  /* Same answers first */
+  int bad = 0;
+  for (int i = 0; i < SWEEP; i++) {
+    sensor_snapshot_t s = make_random(&t);
+    anomaly_result_t a = ref_eval_run(&t, &s);
+    anomaly_result_t b = anomaly_eval_run(&t, &s);
+    anomaly_result_t c = plan_run(&t, &s);
+    if (!same_result(&a, &b) || !same_result(&a, &c))
+      bad++;
+  }
+  for (int c = 0; c < CASE_COUNT; c++) {
+    sensor_snapshot_t s = make_case((bench_case_t)c, &t);
+    anomaly_result_t a = ref_eval_run(&t, &s);
+    anomaly_result_t b = anomaly_eval_run(&t, &s);
+    anomaly_result_t p = plan_run(&t, &s);
+    if (!same_result(&a, &b) || !same_result(&a, &p)) {
+      printf("  MISMATCH on %s\n", case_names[c]);
+      bad++;
+    }
+  }
+  printf("  Equivalence: %d random + %d cases, %d mismatches\n\n", SWEEP,
+         CASE_COUNT, bad);
+  if (bad)
+    return 1;
+
+  printf("  case             reference      reordered\n");
+  for (int c = 0; c < CASE_COUNT; c++) {
+    sensor_snapshot_t s = make_case((bench_case_t)c, &t);
+    timing_t ref = time_fn(ref_eval_run, &t, &s, calls);
+    timing_t now = time_fn(plan_run, &t, &s, calls);
+    print_timing(case_names[c], ref, now);
+    if (c == CASE_SHORT || c == CASE_TEMP) {
+      timing_t trip = time_fn(plan_run_trip, &t, &s, calls);
+      print_timing("  trip path", ref, trip);
+    }
+  }
+  return 0;
+}
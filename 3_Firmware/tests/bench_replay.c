@@ -0,0 +1,560 @@
+/*
+ * bench_replay.c — Host Replay + Throughput Benchmark
+ *
+ * Streams the recorded traces in 5_Data through the path a twin cycle
+ * takes on the board, with null I/O (no UART, no stdio in the loop):
+ *
+ *   input frames → input_rx_feed() → anomaly_eval_compute()
+ *     → anomaly_eval_run() → correlation_engine_update()
+ *     → packet_encode_pack()
+ *
+ * Each trace row is held until the next one (the twin resends every
+ * cycle) and sampled at the med-loop rate main.c uses: 500 ms, 100 ms
+ * once anything is active. Reports snapshots/sec, ns per stage and, per
+ * scenario, how long the correlation engine took to reach the expected
+ * state.
+ *
+ *   Raw_Data_Sample.csv       104S pack trace; its scenarios are the
+ *                             T1-T8 rows of Fault_Test_Data.csv, which
+ *                             holds outcomes only (no samples)
+ *   logs/sim_transition_log   Bench-scale twin log (4S model of
+ *                             tests/correlation_sim.py) with the state
+ *                             expected at every row
+ *
+ * Compile:
+ *   cd 3_Firmware
+ *   gcc -Wall -Wextra -O2 -o bench_replay tests/bench_replay.c \
+ *       src/anomaly_eval.c src/correlation_engine.c src/input_packet.c \
+ *       src/packet_format.c src/crc16.c src/latency_stats.c \
+ *       src/voltage_plane.c -I src -lm
+ *
+ * Run:
+ *   ./bench_replay [data_dir] [repeats]    (default ../5_Data, 200)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "anomaly_eval.h"
+#include "correlation_engine.h"
+#include "input_packet.h"
+#include "packet_format.h"
+
+/* -----------------------------------------------------------------------
+ * Replay parameters
+ * ----------------------------------------------------------------------- */
+
+#define TRACE_TAIL_MS 15000 /* Hold the last row this long */
+
+#define MAX_ROWS 256
+#define MAX_COLS 16
+#define MAX_SCENARIOS 16
+#define LINE_LEN 512
+
+/* 4S bench model of correlation_sim.py: its voltage-low and
+ * current-warning limits map onto this pack's */
+#define TWIN_MODEL_VLOW_V 12.0f
+#define TWIN_MODEL_IWARN_A 8.0f
+
+/* Pack traces log only the hottest NTC: it goes on one module, and the
+ * rest of the pack stays within half the 5 °C inter-module warning
+ * spread of it, so a hotspot is judged on its own limits */
+#define TRACE_HOT_MODULE (NUM_MODULES > 2 ? 2 : 0)
+#define TRACE_PACK_SPREAD_C 2.5f
+
+typedef enum {
+  ST_FEED = 0, /* Frame bytes through the parser + snapshot fill */
+  ST_COMPUTE,
+  ST_RUN,
+  ST_CORR,
+  ST_ENCODE,
+  ST_COUNT
+} bench_stage_t;
+
+static const char *const stage_names[ST_COUNT] = {
+    "input_rx_feed", "anomaly_eval_compute", "anomaly_eval_run",
+    "correlation_update", "packet_encode_pack"};
+
+/* -----------------------------------------------------------------------
+ * Trace rows
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint32_t t_ms;
+  float voltage_v;
+  float current_a;
+  float temp_max_c;
+  float ambient_c;
+  float gas_1, gas_2;
+  float pressure_1_hpa, pressure_2_hpa;
+  float dt_dt_max;
+  float swelling_pct;
+  int expected; /* system_state_t, or -1 */
+} trace_row_t;
+
+typedef struct {
+  char id[8];
+  char name[48];
+  uint32_t start_ms;
+  int expected; /* system_state_t */
+} scenario_t;
+
+typedef struct {
+  trace_row_t rows[MAX_ROWS];
+  int num_rows;
+  scenario_t scen[MAX_SCENARIOS];
+  int num_scen;
+} trace_t;
+
+typedef struct {
+  const char *file;
+  float v_scale; /* Trace volts → this pack */
+  float i_scale; /* Trace amps → this pack (0 = model scaling) */
+  const char *outcomes; /* Outcome table naming the scenarios, or NULL */
+} trace_desc_t;
+
+/* Raw_Data_Sample scenario starts, by Fault_Test_Data test_id */
+static const struct {
+  const char *id;
+  uint32_t start_ms;
+} raw_scenarios[] = {
+    {"T1", 0},      {"T2", 30000},  {"T3", 70000},  {"T4", 100000},
+    {"T5", 120000}, {"T6", 150000}, {"T7", 170000}, {"T8", 185000},
+};
+
+/* -----------------------------------------------------------------------
+ * CSV helpers
+ * ----------------------------------------------------------------------- */
+
+static int split_csv(char *line, char *fields[MAX_COLS]) {
+  int n = 0;
+  line[strcspn(line, "\r\n")] = '\0';
+  if ((uint8_t)line[0] == 0xEF && (uint8_t)line[1] == 0xBB &&
+      (uint8_t)line[2] == 0xBF)
+    line += 3; /* UTF-8 BOM */
+  char *p = line;
+  while (n < MAX_COLS) {
+    fields[n++] = p;
+    p = strchr(p, ',');
+    if (!p)
+      break;
+    *p++ = '\0';
+  }
+  return n;
+}
+
+static int column(char *hdr[], int n, const char *a, const char *b) {
+  for (int i = 0; i < n; i++) {
+    if (strcmp(hdr[i], a) == 0 || (b && strcmp(hdr[i], b) == 0))
+      return i;
+  }
+  return -1;
+}
+
+static int state_from_name(const char *s) {
+  static const char *const names[] = {"NORMAL", "WARNING", "CRITICAL",
+                                      "EMERGENCY"};
+  for (int i = 0; i < 4; i++) {
+    size_t len = strlen(names[i]);
+    /* "EMERGENCY_latched", "WARNING_then_NORMAL": the first state */
+    if (strncmp(s, names[i], len) == 0 && (s[len] == '\0' || s[len] == '_'))
+      return i;
+  }
+  return -1;
+}
+
+static float field_or(char *f[], int n, int col, float dflt) {
+  return (col >= 0 && col < n && f[col][0]) ? strtof(f[col], NULL) : dflt;
+}
+
+/* -----------------------------------------------------------------------
+ * Load a time-series trace (any column order; aliases cover both logs)
+ * ----------------------------------------------------------------------- */
+static int load_trace(const char *path, trace_t *tr) {
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return -1;
+
+  char line[LINE_LEN];
+  char *hdr[MAX_COLS], *f[MAX_COLS];
+  char hdr_line[LINE_LEN];
+  if (!fgets(hdr_line, sizeof(hdr_line), fp)) {
+    fclose(fp);
+    return -1;
+  }
+  int nh = split_csv(hdr_line, hdr);
+  int c_t = column(hdr, nh, "timestamp_ms", "t_ms");
+  int c_v = column(hdr, nh, "pack_voltage_v", "voltage_v");
+  int c_i = column(hdr, nh, "pack_current_a", "current_a");
+  int c_temp = column(hdr, nh, "temp_max_c", "temp_c");
+  int c_amb = column(hdr, nh, "ambient_c", NULL);
+  int c_g1 = column(hdr, nh, "gas_ratio_1", "gas_ratio");
+  int c_g2 = column(hdr, nh, "gas_ratio_2", "gas_ratio");
+  int c_p1 = column(hdr, nh, "pressure_delta_1_hpa", "pressure_delta_hpa");
+  int c_p2 = column(hdr, nh, "pressure_delta_2_hpa", "pressure_delta_hpa");
+  int c_dt = column(hdr, nh, "dt_dt_max_c_per_min", "dt_dt_max");
+  int c_sw = column(hdr, nh, "swelling_pct", NULL);
+  int c_st = column(hdr, nh, "state", NULL);
+  if (c_t < 0 || c_v < 0 || c_i < 0 || c_temp < 0) {
+    fclose(fp);
+    return -2; /* Not a sample trace */
+  }
+
+  tr->num_rows = 0;
+  while (tr->num_rows < MAX_ROWS && fgets(line, sizeof(line), fp)) {
+    int n = split_csv(line, f);
+    if (n <= c_temp)
+      continue;
+    trace_row_t *r = &tr->rows[tr->num_rows++];
+    r->t_ms = (uint32_t)strtoul(f[c_t], NULL, 10);
+    r->voltage_v = field_or(f, n, c_v, 0.0f);
+    r->current_a = field_or(f, n, c_i, 0.0f);
+    r->temp_max_c = field_or(f, n, c_temp, 28.0f);
+    r->ambient_c = field_or(f, n, c_amb, 30.0f);
+    r->gas_1 = field_or(f, n, c_g1, 1.0f);
+    r->gas_2 = field_or(f, n, c_g2, 1.0f);
+    r->pressure_1_hpa = field_or(f, n, c_p1, 0.0f);
+    r->pressure_2_hpa = field_or(f, n, c_p2, 0.0f);
+    r->dt_dt_max = field_or(f, n, c_dt, 0.0f);
+    r->swelling_pct = field_or(f, n, c_sw, 0.0f);
+    r->expected = (c_st >= 0 && c_st < n) ? state_from_name(f[c_st]) : -1;
+  }
+  fclose(fp);
+  return tr->num_rows > 0 ? 0 : -2;
+}
+
+/* Scenarios named by an outcome table (test_id, scenario, expected_state) */
+static int load_outcomes(const char *path, trace_t *tr) {
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return -1;
+
+  char line[LINE_LEN];
+  char *hdr[MAX_COLS], *f[MAX_COLS];
+  if (!fgets(line, sizeof(line), fp)) {
+    fclose(fp);
+    return -1;
+  }
+  int nh = split_csv(line, hdr);
+  int c_id = column(hdr, nh, "test_id", NULL);
+  int c_name = column(hdr, nh, "scenario", NULL);
+  int c_exp = column(hdr, nh, "expected_state", NULL);
+  if (c_id < 0 || c_name < 0 || c_exp < 0) {
+    fclose(fp);
+    return -2;
+  }
+
+  tr->num_scen = 0;
+  while (tr->num_scen < MAX_SCENARIOS && fgets(line, sizeof(line), fp)) {
+    int n = split_csv(line, f);
+    if (n <= c_exp)
+      continue;
+    for (size_t k = 0; k < sizeof(raw_scenarios) / sizeof(raw_scenarios[0]);
+         k++) {
+      if (strcmp(f[c_id], raw_scenarios[k].id) != 0)
+        continue;
+      scenario_t *s = &tr->scen[tr->num_scen++];
+      snprintf(s->id, sizeof(s->id), "%s", f[c_id]);
+      snprintf(s->name, sizeof(s->name), "%s", f[c_name]);
+      s->start_ms = raw_scenarios[k].start_ms;
+      s->expected = state_from_name(f[c_exp]);
+    }
+  }
+  fclose(fp);
+  return 0;
+}
+
+/* A log with a state column: every row is a scenario */
+static void scenarios_from_rows(trace_t *tr) {
+  tr->num_scen = 0;
+  for (int i = 0; i < tr->num_rows && tr->num_scen < MAX_SCENARIOS; i++) {
+    if (tr->rows[i].expected < 0)
+      continue;
+    scenario_t *s = &tr->scen[tr->num_scen++];
+    snprintf(s->id, sizeof(s->id), "R%d", i + 1);
+    snprintf(s->name, sizeof(s->name), "t=%lus",
+             (unsigned long)(tr->rows[i].t_ms / 1000u));
+    s->start_ms = tr->rows[i].t_ms;
+    s->expected = tr->rows[i].expected;
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Trace row → twin input frames (v1, as serial_bridge.py sends them)
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t bytes[INPUT_PACK_FRAME_SIZE +
+                PACK_NUM_MODULES * INPUT_MODULE_FRAME_SIZE];
+  uint16_t len;
+} cycle_frames_t;
+
+static int16_t deci(float v) {
+  return (int16_t)(v * 10.0f + (v < 0.0f ? -0.5f : 0.5f));
+}
+
+static uint16_t centi(float v) {
+  return v <= 0.0f ? 0u : (uint16_t)(v * 100.0f + 0.5f);
+}
+
+static void encode_cycle(const trace_row_t *r, float v_scale, float i_scale,
+                         cycle_frames_t *out) {
+  input_pack_frame_t pf;
+  memset(&pf, 0, sizeof(pf));
+  pf.sync = INPUT_SYNC_BYTE;
+  pf.length = INPUT_PACK_FRAME_SIZE;
+  pf.frame_type = INPUT_TYPE_PACK;
+  pf.pack_voltage_dv = (uint16_t)deci(r->voltage_v * v_scale);
+  pf.pack_current_da = deci(r->current_a * i_scale);
+  pf.ambient_temp_dt = deci(r->ambient_c);
+  pf.coolant_inlet_dt = 250;
+  pf.coolant_outlet_dt = 270;
+  pf.gas_ratio_1_cp = centi(r->gas_1);
+  pf.gas_ratio_2_cp = centi(r->gas_2);
+  pf.pressure_delta_1_chpa = (int16_t)(r->pressure_1_hpa * 100.0f);
+  pf.pressure_delta_2_chpa = (int16_t)(r->pressure_2_hpa * 100.0f);
+  pf.humidity_pct = 50;
+  pf.isolation_mohm = 5000;
+  pf.checksum = packet_checksum((const uint8_t *)&pf, sizeof(pf) - 1);
+  memcpy(out->bytes, &pf, sizeof(pf));
+  out->len = sizeof(pf);
+
+  uint16_t group_mv =
+      (uint16_t)(r->voltage_v * v_scale * 1000.0f / (float)TOTAL_SERIES);
+  for (int m = 0; m < NUM_MODULES; m++) {
+    input_module_frame_t mf;
+    memset(&mf, 0, sizeof(mf));
+    mf.sync = INPUT_SYNC_BYTE;
+    mf.length = INPUT_MODULE_FRAME_SIZE;
+    mf.frame_type = INPUT_TYPE_MODULE;
+    mf.module_index = (uint8_t)m;
+
+    /* The sim's gradient, pulled up behind the hot module, which also
+     * carries the swelling */
+    float base = 28.0f + (float)m * (2.4f / NUM_MODULES);
+    if (base < r->temp_max_c - TRACE_PACK_SPREAD_C)
+      base = r->temp_max_c - TRACE_PACK_SPREAD_C;
+    if (base > r->temp_max_c)
+      base = r->temp_max_c;
+    mf.ntc1_dt = deci(m == TRACE_HOT_MODULE ? r->temp_max_c : base);
+    mf.ntc2_dt =
+        deci(m == TRACE_HOT_MODULE ? r->temp_max_c - 0.5f : base);
+    mf.swelling_pct =
+        (uint8_t)(m == TRACE_HOT_MODULE ? r->swelling_pct + 0.5f : 0.0f);
+    mf.v_base_mv = group_mv;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      mf.v_delta[g] = (int8_t)(2 * (g % 3));
+    mf.checksum = packet_checksum((const uint8_t *)&mf, sizeof(mf) - 1);
+    memcpy(out->bytes + out->len, &mf, sizeof(mf));
+    out->len += sizeof(mf);
+  }
+}
+
+/* Completed RX cycle → snapshot, the conversion main.c applies */
+static void snapshot_from_rx(sensor_snapshot_t *s, const input_rx_state_t *rx,
+                             float dt_dt_max) {
+  input_decode_pack(s, &rx->last_pack);
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    input_decode_module(s, m, &rx->last_modules[m]);
+    /* The traces log dT/dt; written the way sim_inject_data() does */
+    s->modules[m].max_dt_dt = m == TRACE_HOT_MODULE ? dt_dt_max : 0.0f;
+  }
+  s->dr_dt_mohm_per_s = 0.0f;
+  s->stale_modules = 0;
+}
+
+/* -----------------------------------------------------------------------
+ * Replay
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint64_t ns[ST_COUNT];
+  uint64_t snapshots;
+  uint32_t frames_bad;
+  int32_t latency_ms[MAX_SCENARIOS]; /* -1 = not reached */
+  uint8_t last_state[MAX_SCENARIOS];  /* State when the scenario ended */
+} replay_result_t;
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static volatile uint8_t g_sink; /* Keeps the encoded frames live */
+
+static void replay(const trace_t *tr, float v_scale, float i_scale,
+                   replay_result_t *res) {
+  static input_rx_state_t rx;
+  static sensor_snapshot_t snap;
+  static cycle_frames_t cf;
+  anomaly_thresholds_t th;
+  anomaly_result_t an;
+  correlation_engine_t corr;
+  telemetry_pack_frame_t pkt;
+
+  anomaly_eval_init(&th);
+  correlation_engine_init(&corr);
+  input_rx_init(&rx);
+  memset(&snap, 0, sizeof(snap));
+  memset(&an, 0, sizeof(an));
+
+  uint32_t end_ms = tr->rows[tr->num_rows - 1].t_ms + TRACE_TAIL_MS;
+  uint32_t period = CORR_MED_NORMAL_MS;
+  int row = -1;
+  for (int s = 0; s < tr->num_scen; s++)
+    res->latency_ms[s] = -1;
+
+  for (uint32_t t = 0; t < end_ms; t += period) {
+    while (row + 1 < tr->num_rows && tr->rows[row + 1].t_ms <= t) {
+      row++;
+      encode_cycle(&tr->rows[row], v_scale, i_scale, &cf);
+    }
+    if (row < 0)
+      continue;
+
+    correlation_engine_set_period(&corr, period);
+
+    uint64_t t0 = now_ns();
+    int full = 0;
+    for (uint16_t i = 0; i < cf.len; i++) {
+      if (input_rx_feed(&rx, cf.bytes[i]) == 2)
+        full = 1;
+    }
+    if (full) {
+      snapshot_from_rx(&snap, &rx, tr->rows[row].dt_dt_max);
+      input_rx_reset_cycle(&rx);
+    }
+    /* The fast loop's short-circuit rule */
+    float abs_i = snap.pack_current_a < 0 ? -snap.pack_current_a
+                                          : snap.pack_current_a;
+    snap.short_circuit = abs_i > th.current_short_a;
+    uint64_t t1 = now_ns();
+
+    anomaly_eval_compute(&snap, &th);
+    uint64_t t2 = now_ns();
+    an = anomaly_eval_run(&th, &snap);
+    uint64_t t3 = now_ns();
+    system_state_t st = correlation_engine_update(&corr, &an);
+    uint64_t t4 = now_ns();
+    g_sink ^= packet_encode_pack(&pkt, t, &snap, &an, st);
+    g_sink ^= pkt.checksum;
+    uint64_t t5 = now_ns();
+
+    res->ns[ST_FEED] += t1 - t0;
+    res->ns[ST_COMPUTE] += t2 - t1;
+    res->ns[ST_RUN] += t3 - t2;
+    res->ns[ST_CORR] += t4 - t3;
+    res->ns[ST_ENCODE] += t5 - t4;
+    res->snapshots++;
+
+    /* Detection latency: first pass in the scenario at its state */
+    for (int s = 0; s < tr->num_scen; s++) {
+      const scenario_t *sc = &tr->scen[s];
+      uint32_t next = s + 1 < tr->num_scen ? tr->scen[s + 1].start_ms : end_ms;
+      if (t < sc->start_ms || t >= next)
+        continue;
+      res->last_state[s] = (uint8_t)st;
+      if (res->latency_ms[s] < 0 && (int)st == sc->expected)
+        res->latency_ms[s] = (int32_t)(t - sc->start_ms);
+    }
+
+    /* Sampling rate for the next pass, by the firmware's policy */
+    period = correlation_med_period_ms(&corr, &an, snap.short_circuit);
+  }
+  res->frames_bad += rx.frames_bad;
+}
+
+/* -----------------------------------------------------------------------
+ * Report
+ * ----------------------------------------------------------------------- */
+static int run_trace(const char *dir, const trace_desc_t *d, int repeats) {
+  static trace_t tr;
+  char path[512];
+
+  snprintf(path, sizeof(path), "%s/%s", dir, d->file);
+  int rc = load_trace(path, &tr);
+  if (rc != 0) {
+    printf("%s: %s\n", d->file,
+           rc == -1 ? "cannot open" : "no sample columns, skipped");
+    return rc == -1 ? 1 : 0;
+  }
+  if (d->outcomes) {
+    snprintf(path, sizeof(path), "%s/%s", dir, d->outcomes);
+    if (load_outcomes(path, &tr) != 0) {
+      printf("%s: cannot read outcomes %s\n", d->file, d->outcomes);
+      return 1;
+    }
+  } else {
+    scenarios_from_rows(&tr);
+  }
+
+  anomaly_thresholds_t th;
+  anomaly_eval_init(&th);
+  float i_scale =
+      d->i_scale > 0.0f ? d->i_scale : th.current_warning_a / TWIN_MODEL_IWARN_A;
+
+  replay_result_t res;
+  memset(&res, 0, sizeof(res));
+  replay(&tr, d->v_scale, i_scale, &res);
+  replay_result_t first = res;
+  for (int k = 1; k < repeats; k++)
+    replay(&tr, d->v_scale, i_scale, &res);
+
+  uint64_t total = 0;
+  for (int s = 0; s < ST_COUNT; s++)
+    total += res.ns[s];
+
+  printf("\n=== %s (%d rows, %llu snapshots, %d repeats) ===\n", d->file,
+         tr.num_rows, (unsigned long long)first.snapshots, repeats);
+  printf("  %-22s %10s\n", "stage", "ns/snap");
+  for (int s = 0; s < ST_COUNT; s++) {
+    printf("  %-22s %10.1f\n", stage_names[s],
+           (double)res.ns[s] / (double)res.snapshots);
+  }
+  printf("  %-22s %10.1f   (%.0f snapshots/s)\n", "total",
+         (double)total / (double)res.snapshots,
+         total ? (double)res.snapshots * 1e9 / (double)total : 0.0);
+  if (res.frames_bad)
+    printf("  frames_bad=%lu\n", (unsigned long)res.frames_bad);
+
+  printf("  %-4s %-28s %-10s %s\n", "id", "scenario", "expect", "latency");
+  for (int s = 0; s < tr.num_scen; s++) {
+    const scenario_t *sc = &tr.scen[s];
+    printf("  %-4s %-28s %-10s ", sc->id, sc->name,
+           sc->expected >= 0
+               ? correlation_state_name((system_state_t)sc->expected)
+               : "?");
+    if (first.latency_ms[s] >= 0)
+      printf("%ld ms\n", (long)first.latency_ms[s]);
+    else
+      printf("not reached (%s)\n",
+             correlation_state_name((system_state_t)first.last_state[s]));
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  const char *dir = argc > 1 ? argv[1] : "../5_Data";
+  int repeats = argc > 2 ? atoi(argv[2]) : 200;
+  if (repeats < 1)
+    repeats = 1;
+
+  const trace_desc_t traces[] = {
+      {"Raw_Data_Sample.csv", (float)TOTAL_SERIES / 104.0f, 1.0f,
+       "Fault_Test_Data.csv"},
+      {"logs/sim_transition_log.csv", PACK_VOLTAGE_LOW_V / TWIN_MODEL_VLOW_V,
+       0.0f, NULL},
+  };
+
+  printf("Replay benchmark: %d modules × %d groups, null I/O\n", NUM_MODULES,
+         GROUPS_PER_MODULE);
+  int failed = 0;
+  for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+    failed |= run_trace(dir, &traces[i], repeats);
+  return failed;
+}
@@ -0,0 +1,685 @@
+/*
+ * bench_soak.c — Host Fault-Injection Stress + Soak Benchmark
+ *
+ * Drives the correlation engine through a long, seeded stream of
+ * synthetic pack snapshots: drive-cycle current, sensor noise and
+ * random fault episodes, sampled at the med-loop rate main.c uses
+ * (500 ms, 100 ms once anything is active, with the CRITICAL and
+ * de-escalation holds recomputed on every rate change). Each cycle
+ * takes the board's med-loop path:
+ *
+ *   anomaly_eval_compute() → anomaly_eval_run_plan()
+ *     → correlation_engine_update()
+ *
+ * Every episode is a nominal stretch, then a fault, then recovery
+ * until both engines are back at NORMAL:
+ *
+ *   nominal ──▶ 1-5 categories (staggered ramps) or a direct
+ *               EMERGENCY (short circuit, runaway) ──▶ clear ──▶ NORMAL
+ *
+ * A second, shadow engine sees the same faults without the noise. It
+ * gives the state each episode should reach and the moment the fault
+ * first crossed a threshold, so what is measured is what noise, the
+ * sampling rate and the holds add on top:
+ *
+ *   latency      first threshold crossing (noise-free) → the engine
+ *                at the state the shadow reached, per target state
+ *   missed       episodes where the engine never got there
+ *   false alarm  NORMAL left during a nominal stretch
+ *   false trip   EMERGENCY in an episode (or stretch) whose shadow
+ *                never reached it
+ *   recovery     fault cleared → engine back at NORMAL (latch
+ *                release plus de-escalation)
+ *
+ * Rates are per hour of simulated nominal time. The same seed gives
+ * the same results (apart from the timings). Baseline drift (the z
+ * scores) and the fast-loop trip check are not modelled: the short
+ * circuit flag is set from the sampled current, as in bench_replay.c.
+ *
+ * Compile:
+ *   cd 3_Firmware
+ *   gcc -Wall -Wextra -O2 -o bench_soak tests/bench_soak.c \
+ *       src/anomaly_eval.c src/correlation_engine.c -I src -lm
+ *
+ * Run:
+ *   ./bench_soak [episodes] [seed] [json|-] [id=value ...]
+ *                                      (default 5000, 1, no JSON file)
+ *
+ *   json     results as one JSON object, to the file or "-" (stdout)
+ *   id=value override threshold `id` (anomaly_thresholds_set() ids,
+ *            physical units), e.g. 10=0.8 for a 0.8 °C/min dT/dt warning
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "anomaly_eval.h"
+#include "correlation_engine.h"
+
+/* -----------------------------------------------------------------------
+ * Soak parameters
+ * ----------------------------------------------------------------------- */
+
+#define NOMINAL_MIN_MS 5000
+#define NOMINAL_MAX_MS 60000
+#define FAULT_MIN_MS 5000
+#define FAULT_MAX_MS 30000
+#define ONSET_STAGGER_MS 8000 /* Spread of category onsets in a fault */
+#define RECOVER_CAP_MS 120000 /* Give up on an episode after this     */
+
+/* Noise: the inrush spike is the one source meant to reach a limit */
+#define NOISE_V 0.004f  /* Group voltage, V       */
+#define NOISE_I 3.0f    /* Pack current, A        */
+#define NOISE_T 0.3f    /* NTC, °C                */
+#define NOISE_DTDT 0.15f /* dT/dt, °C/min         */
+#define NOISE_GAS 0.02f
+#define NOISE_P 0.3f    /* Pressure delta, hPa    */
+#define NOISE_SWELL 0.3f /* %                      */
+#define INRUSH_P 0.0002f /* Per cycle             */
+
+#define MAX_CATS 5
+#define LAT_MAX 65536 /* Latency samples kept per target state */
+
+/* -----------------------------------------------------------------------
+ * PRNG (xorshift64*) and noise
+ * ----------------------------------------------------------------------- */
+
+static uint64_t g_rng;
+
+static uint32_t rng_u32(void) {
+  g_rng ^= g_rng >> 12;
+  g_rng ^= g_rng << 25;
+  g_rng ^= g_rng >> 27;
+  return (uint32_t)((g_rng * 2685821657736338717ull) >> 32);
+}
+
+/* [0, 1) */
+static float rng_unit(void) { return (float)(rng_u32() >> 8) / 16777216.0f; }
+
+static float rng_range(float lo, float hi) {
+  return lo + (hi - lo) * rng_unit();
+}
+
+static uint32_t rng_ms(uint32_t lo, uint32_t hi) {
+  return lo + rng_u32() % (hi - lo + 1u);
+}
+
+/* Zero mean, standard deviation `sd`, bounded at ±3.5 sd */
+static float noise(float sd) {
+  float u = rng_unit() + rng_unit() + rng_unit() + rng_unit() - 2.0f;
+  return u * sd * 1.7320508f;
+}
+
+/* -----------------------------------------------------------------------
+ * Faults
+ * ----------------------------------------------------------------------- */
+
+typedef enum {
+  F_GROUP_SAG = 0, /* Electrical: one group drops below its module    */
+  F_OVERCURRENT,   /* Electrical: sustained current over the warning  */
+  F_HEAT_RATE,     /* Thermal: one module rising faster than warning  */
+  F_HOT_MODULE,    /* Thermal: one module well above the rest         */
+  F_GAS,           /* Gas: a BME680 ratio falling                     */
+  F_PRESSURE,      /* Pressure: enclosure delta rising                */
+  F_SWELLING,      /* Swelling: one end plate pushing out             */
+  F_SHORT,         /* Direct: current spike past the short limit      */
+  F_RUNAWAY,       /* Direct: NTC and dT/dt past the physics limits   */
+  F_COUNT
+} fault_kind_t;
+
+static const char *const fault_names[F_COUNT] = {
+    "group_sag", "overcurrent", "heat_rate", "hot_module", "gas",
+    "pressure",  "swelling",    "short",     "runaway"};
+
+typedef struct {
+  fault_kind_t kind;
+  uint8_t module;
+  uint8_t group;
+  uint8_t sensor;    /* Gas/pressure: 0, 1 or 2 = both */
+  uint32_t onset_ms; /* From the start of the fault    */
+  uint32_t ramp_ms;
+  float level;       /* Full fault size                */
+} fault_t;
+
+typedef struct {
+  uint32_t nominal_ms;
+  uint32_t fault_ms;
+  uint8_t num_faults;
+  fault_t f[MAX_CATS];
+} episode_t;
+
+/* One fault per category: sag or overcurrent, heat rate or hot module */
+static fault_kind_t pick_kind(int cat) {
+  int alt = rng_u32() & 1u;
+  switch (cat) {
+  case 0: return alt ? F_OVERCURRENT : F_GROUP_SAG;
+  case 1: return alt ? F_HOT_MODULE : F_HEAT_RATE;
+  case 2: return F_GAS;
+  case 3: return F_PRESSURE;
+  default: return F_SWELLING;
+  }
+}
+
+static void make_fault(fault_t *f, fault_kind_t kind, uint32_t onset) {
+  f->kind = kind;
+  f->module = (uint8_t)(rng_u32() % NUM_MODULES);
+  f->group = (uint8_t)(rng_u32() % GROUPS_PER_MODULE);
+  f->sensor = (uint8_t)(rng_u32() % 3u);
+  f->onset_ms = onset;
+  f->ramp_ms = rng_ms(500, 8000);
+
+  /* Sizes from just past the warning limit to well past it */
+  switch (kind) {
+  case F_GROUP_SAG: f->level = rng_range(0.018f, 0.045f); break;
+  case F_OVERCURRENT: f->level = rng_range(190.0f, 300.0f); break;
+  case F_HEAT_RATE: f->level = rng_range(0.7f, 4.5f); break;
+  case F_HOT_MODULE: f->level = rng_range(27.0f, 45.0f); break;
+  case F_GAS: f->level = rng_range(0.45f, 0.67f); break;
+  case F_PRESSURE: f->level = rng_range(2.3f, 4.8f); break;
+  case F_SWELLING: f->level = rng_range(3.5f, 9.0f); break;
+  case F_SHORT:
+    f->level = rng_range(380.0f, 700.0f);
+    f->ramp_ms = rng_ms(100, 2000); /* Here: how long the spike lasts */
+    break;
+  case F_RUNAWAY: f->level = rng_range(6.0f, 30.0f); break;
+  default: break;
+  }
+}
+
+/* 1 category 35 %, 2: 30 %, 3-5: 20 %, direct EMERGENCY 15 % */
+static void make_episode(episode_t *ep) {
+  memset(ep, 0, sizeof(*ep));
+  ep->nominal_ms = rng_ms(NOMINAL_MIN_MS, NOMINAL_MAX_MS);
+  ep->fault_ms = rng_ms(FAULT_MIN_MS, FAULT_MAX_MS);
+
+  uint32_t r = rng_u32() % 100u;
+  if (r >= 85u) {
+    make_fault(&ep->f[0], (rng_u32() & 1u) ? F_SHORT : F_RUNAWAY,
+               rng_ms(0, ONSET_STAGGER_MS));
+    ep->num_faults = 1;
+    return;
+  }
+
+  int n = r < 35u ? 1 : r < 65u ? 2 : 3 + (int)(rng_u32() % 3u);
+  int cats[MAX_CATS] = {0, 1, 2, 3, 4};
+  for (int i = MAX_CATS - 1; i > 0; i--) { /* Shuffle, take the first n */
+    int j = (int)(rng_u32() % (uint32_t)(i + 1));
+    int tmp = cats[i];
+    cats[i] = cats[j];
+    cats[j] = tmp;
+  }
+  for (int i = 0; i < n; i++)
+    make_fault(&ep->f[i], pick_kind(cats[i]),
+               i == 0 ? 0 : rng_ms(0, ONSET_STAGGER_MS));
+  ep->num_faults = (uint8_t)n;
+}
+
+/* -----------------------------------------------------------------------
+ * Snapshots
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  float current_a; /* Drive cycle: eases towards a new target */
+  float target_a;
+  uint32_t next_target_ms;
+  float ambient_c;
+} drive_t;
+
+static void drive_step(drive_t *d, uint32_t t, uint32_t period) {
+  if (t >= d->next_target_ms) {
+    d->target_a = rng_range(-100.0f, 170.0f);
+    d->next_target_ms = t + rng_ms(2000, 20000);
+    d->ambient_c = rng_range(20.0f, 32.0f);
+  }
+  float k = (float)period / 4000.0f; /* ~4 s time constant */
+  d->current_a += (d->target_a - d->current_a) * (k > 1.0f ? 1.0f : k);
+}
+
+static void make_nominal(sensor_snapshot_t *s, const drive_t *d) {
+  memset(s, 0, sizeof(*s));
+  s->pack_voltage_v = 3.2f * (float)TOTAL_SERIES;
+  s->pack_current_a = d->current_a;
+  s->r_internal_mohm = 0.44f;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    module_data_t *md = &s->modules[m];
+    md->ntc1_c = d->ambient_c + 3.0f + (float)m * (2.4f / NUM_MODULES);
+    md->ntc2_c = md->ntc1_c + 0.2f;
+    md->swelling_pct = 0.5f;
+    md->max_dt_dt = 0.0f;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      md->group_voltages_v[g] = 3.20f + 0.001f * (float)(g % 3);
+  }
+  s->temp_ambient_c = d->ambient_c;
+  s->coolant_inlet_c = d->ambient_c;
+  s->coolant_outlet_c = d->ambient_c + 2.0f;
+  s->gas_ratio_1 = 0.97f;
+  s->gas_ratio_2 = 0.97f;
+  s->humidity_pct = 50.0f;
+  s->isolation_mohm = 500.0f;
+}
+
+/* Overlay fault `f`, `t` ms into the fault. Gas falls, the rest rise. */
+static void apply_fault(sensor_snapshot_t *s, const fault_t *f, uint32_t t) {
+  if (t < f->onset_ms)
+    return;
+  uint32_t in = t - f->onset_ms;
+  float x = in >= f->ramp_ms ? 1.0f : (float)in / (float)f->ramp_ms;
+  module_data_t *md = &s->modules[f->module];
+
+  switch (f->kind) {
+  case F_GROUP_SAG:
+    md->group_voltages_v[f->group] -= x * f->level;
+    break;
+  case F_OVERCURRENT:
+    s->pack_current_a += x * (f->level - s->pack_current_a);
+    break;
+  case F_HEAT_RATE: /* Rate only: a few °C over a fault is not a hotspot */
+    md->max_dt_dt = f->level;
+    md->ntc1_c += f->level * (float)in / 60000.0f;
+    md->ntc2_c += f->level * (float)in / 90000.0f;
+    break;
+  case F_HOT_MODULE:
+    md->ntc1_c += x * f->level;
+    md->ntc2_c += x * f->level;
+    break;
+  case F_GAS:
+    if (f->sensor != 1)
+      s->gas_ratio_1 += x * (f->level - s->gas_ratio_1);
+    if (f->sensor != 0)
+      s->gas_ratio_2 += x * (f->level - s->gas_ratio_2);
+    break;
+  case F_PRESSURE:
+    if (f->sensor != 1)
+      s->pressure_delta_1_hpa += x * f->level;
+    if (f->sensor != 0)
+      s->pressure_delta_2_hpa += x * f->level;
+    break;
+  case F_SWELLING:
+    md->swelling_pct += x * f->level;
+    break;
+  case F_SHORT:
+    if (in < f->ramp_ms)
+      s->pack_current_a = f->level;
+    break;
+  case F_RUNAWAY:
+    md->max_dt_dt = f->level;
+    md->ntc1_c += x * (60.0f + f->level);
+    md->ntc2_c += x * 20.0f;
+    break;
+  default:
+    break;
+  }
+}
+
+static void add_noise(sensor_snapshot_t *s, float current_short_a) {
+  if (s->pack_current_a < current_short_a && rng_unit() < INRUSH_P)
+    s->pack_current_a = rng_range(170.0f, 200.0f); /* One-sample inrush */
+  else
+    s->pack_current_a += noise(NOISE_I);
+  for (int m = 0; m < NUM_MODULES; m++) {
+    module_data_t *md = &s->modules[m];
+    md->ntc1_c += noise(NOISE_T);
+    md->ntc2_c += noise(NOISE_T);
+    md->swelling_pct += noise(NOISE_SWELL);
+    float r = md->max_dt_dt + noise(NOISE_DTDT);
+    md->max_dt_dt = r < 0.0f ? -r : r;
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      md->group_voltages_v[g] += noise(NOISE_V);
+  }
+  s->gas_ratio_1 += noise(NOISE_GAS);
+  s->gas_ratio_2 += noise(NOISE_GAS);
+  s->pressure_delta_1_hpa += noise(NOISE_P);
+  s->pressure_delta_2_hpa += noise(NOISE_P);
+}
+
+/* The fast loop's short-circuit rule */
+static void set_short_flag(sensor_snapshot_t *s, float current_short_a) {
+  float abs_i = s->pack_current_a < 0 ? -s->pack_current_a : s->pack_current_a;
+  s->short_circuit = abs_i > current_short_a;
+}
+
+/* -----------------------------------------------------------------------
+ * Soak
+ * ----------------------------------------------------------------------- */
+
+typedef enum { PH_NOMINAL = 0, PH_FAULT, PH_RECOVER } phase_t;
+
+typedef struct {
+  uint32_t n;
+  uint32_t *ms; /* First LAT_MAX samples */
+} dist_t;
+
+typedef struct {
+  uint64_t cycles;
+  uint64_t eval_ns; /* Compute + run + update of the noisy path */
+  uint64_t wall_ns;
+  uint64_t sim_ms;
+  uint64_t nominal_ms;
+  uint64_t alert_ms; /* Time at the 100 ms rate */
+
+  uint32_t episodes[STATE_EMERGENCY + 1]; /* By shadow (target) state */
+  uint32_t missed[STATE_EMERGENCY + 1];
+  dist_t latency[STATE_EMERGENCY + 1];
+  dist_t recovery;
+  uint32_t stuck; /* Not back at NORMAL within RECOVER_CAP_MS */
+
+  uint32_t false_alarms;
+  uint32_t false_trips;
+  uint32_t kind_episodes[F_COUNT];
+  uint32_t kind_missed[F_COUNT];
+} soak_result_t;
+
+static void dist_add(dist_t *d, uint32_t ms) {
+  if (d->n < LAT_MAX)
+    d->ms[d->n] = ms;
+  d->n++;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint32_t dist_pct(const dist_t *d, int pct) {
+  uint32_t n = d->n < LAT_MAX ? d->n : LAT_MAX;
+  if (n == 0)
+    return 0;
+  uint32_t i = (uint32_t)(((uint64_t)(n - 1) * (uint32_t)pct + 50u) / 100u);
+  return d->ms[i];
+}
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Per-episode tracking, from the start of the fault */
+typedef struct {
+  system_state_t target; /* Highest shadow state */
+  int64_t onset_ms;      /* First noise-free crossing, -1 = none */
+  int64_t reached_ms[STATE_EMERGENCY + 1];
+  int64_t normal_ms;     /* Engine back at NORMAL after the clear */
+  bool tripped;          /* Engine reached EMERGENCY */
+} episode_track_t;
+
+static void close_episode(soak_result_t *res, const episode_t *ep,
+                          const episode_track_t *tr, uint64_t clear_ms) {
+  system_state_t tg = tr->target;
+  res->episodes[tg]++;
+  for (int i = 0; i < ep->num_faults; i++)
+    res->kind_episodes[ep->f[i].kind]++;
+
+  if (tg != STATE_NORMAL) {
+    if (tr->reached_ms[tg] >= 0 && tr->onset_ms >= 0) {
+      int64_t lat = tr->reached_ms[tg] - tr->onset_ms;
+      dist_add(&res->latency[tg], lat > 0 ? (uint32_t)lat : 0u);
+    } else {
+      res->missed[tg]++;
+      for (int i = 0; i < ep->num_faults; i++)
+        res->kind_missed[ep->f[i].kind]++;
+    }
+  }
+  if (tr->tripped && tg != STATE_EMERGENCY)
+    res->false_trips++;
+  if (tr->normal_ms >= 0)
+    dist_add(&res->recovery, (uint32_t)(tr->normal_ms - (int64_t)clear_ms));
+  else
+    res->stuck++;
+}
+
+static void soak(uint32_t episodes, const anomaly_thresholds_t *th,
+                 soak_result_t *res) {
+  static sensor_snapshot_t clean, noisy;
+  anomaly_plan_t plan;
+  correlation_engine_t corr, shadow;
+  drive_t drive = {0.0f, 60.0f, 0, 25.0f};
+  episode_t ep;
+  episode_track_t tr;
+
+  anomaly_plan_compile(&plan, th);
+  correlation_engine_init(&corr);
+  correlation_engine_init(&shadow);
+
+  uint32_t period = CORR_MED_NORMAL_MS;
+  correlation_engine_set_period(&corr, period);
+  correlation_engine_set_period(&shadow, period);
+
+  phase_t ph = PH_NOMINAL;
+  uint64_t t = 0, phase_start = 0;
+  uint32_t done = 0;
+  system_state_t last = STATE_NORMAL;
+  make_episode(&ep);
+
+  uint64_t w0 = now_ns();
+  while (done < episodes) {
+    drive_step(&drive, (uint32_t)t, period);
+    make_nominal(&clean, &drive);
+    uint32_t in = (uint32_t)(t - phase_start);
+    if (ph == PH_FAULT)
+      for (int i = 0; i < ep.num_faults; i++)
+        apply_fault(&clean, &ep.f[i], in);
+    noisy = clean;
+    add_noise(&noisy, th->current_short_a);
+    set_short_flag(&clean, th->current_short_a);
+    set_short_flag(&noisy, th->current_short_a);
+
+    /* Shadow: the same pipeline on the noise-free signal */
+    anomaly_eval_compute(&clean, th);
+    anomaly_result_t ideal = anomaly_eval_run_plan(&plan, &clean);
+    system_state_t want = correlation_engine_update(&shadow, &ideal);
+
+    uint64_t t0 = now_ns();
+    anomaly_eval_compute(&noisy, th);
+    anomaly_result_t an = anomaly_eval_run_plan(&plan, &noisy);
+    system_state_t st = correlation_engine_update(&corr, &an);
+    res->eval_ns += now_ns() - t0;
+    res->cycles++;
+
+    if (ph == PH_NOMINAL) {
+      if (last == STATE_NORMAL && st != STATE_NORMAL && want == STATE_NORMAL)
+        res->false_alarms++;
+      if (last != STATE_EMERGENCY && st == STATE_EMERGENCY &&
+          want != STATE_EMERGENCY)
+        res->false_trips++;
+    } else {
+      if (want > tr.target)
+        tr.target = want;
+      if (tr.onset_ms < 0 &&
+          (ideal.active_count > 0 || ideal.is_short_circuit ||
+           ideal.is_emergency_direct))
+        tr.onset_ms = (int64_t)t;
+      for (int s = STATE_WARNING; s <= STATE_EMERGENCY; s++)
+        if (tr.reached_ms[s] < 0 && (int)st >= s)
+          tr.reached_ms[s] = (int64_t)t;
+      if (st == STATE_EMERGENCY)
+        tr.tripped = true;
+      if (ph == PH_RECOVER && tr.normal_ms < 0 && st == STATE_NORMAL)
+        tr.normal_ms = (int64_t)t;
+    }
+    last = st;
+
+    /* Sampling rate for the next pass, by the firmware's policy */
+    uint32_t next = correlation_med_period_ms(&corr, &an, noisy.short_circuit);
+    if (next != period) {
+      correlation_engine_set_period(&corr, next);
+      correlation_engine_set_period(&shadow, next);
+    }
+    if (period == CORR_MED_ALERT_MS)
+      res->alert_ms += period;
+    if (ph == PH_NOMINAL)
+      res->nominal_ms += period;
+    t += period;
+    period = next;
+
+    /* Phase changes */
+    in = (uint32_t)(t - phase_start);
+    if (ph == PH_NOMINAL && in >= ep.nominal_ms) {
+      ph = PH_FAULT;
+      phase_start = t;
+      memset(&tr, 0, sizeof(tr));
+      tr.target = STATE_NORMAL;
+      tr.onset_ms = -1;
+      tr.normal_ms = -1;
+      for (int s = 0; s <= STATE_EMERGENCY; s++)
+        tr.reached_ms[s] = -1;
+    } else if (ph == PH_FAULT && in >= ep.fault_ms) {
+      ph = PH_RECOVER;
+      phase_start = t;
+    } else if (ph == PH_RECOVER &&
+               ((st == STATE_NORMAL && want == STATE_NORMAL) ||
+                in >= RECOVER_CAP_MS)) {
+      close_episode(res, &ep, &tr, phase_start);
+      done++;
+      make_episode(&ep);
+      ph = PH_NOMINAL;
+      phase_start = t;
+    }
+  }
+  res->wall_ns = now_ns() - w0;
+  res->sim_ms = t;
+}
+
+/* -----------------------------------------------------------------------
+ * Report
+ * ----------------------------------------------------------------------- */
+
+static double per_hour(uint32_t n, uint64_t ms) {
+  return ms ? (double)n * 3600000.0 / (double)ms : 0.0;
+}
+
+static void print_dist(const char *name, dist_t *d) {
+  uint32_t n = d->n < LAT_MAX ? d->n : LAT_MAX;
+  qsort(d->ms, n, sizeof(uint32_t), cmp_u32);
+  printf("  %-22s n=%-7lu p50=%-6lu p90=%-6lu p99=%-6lu max=%lu ms\n", name,
+         (unsigned long)d->n, (unsigned long)dist_pct(d, 50),
+         (unsigned long)dist_pct(d, 90), (unsigned long)dist_pct(d, 99),
+         (unsigned long)dist_pct(d, 100));
+}
+
+static void json_dist(FILE *f, const dist_t *d) {
+  fprintf(f, "{\"n\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}",
+          (unsigned long)d->n, (unsigned long)dist_pct(d, 50),
+          (unsigned long)dist_pct(d, 90), (unsigned long)dist_pct(d, 99),
+          (unsigned long)dist_pct(d, 100));
+}
+
+/* Dists must be sorted (print_dist) first */
+static void write_json(FILE *f, const soak_result_t *r, unsigned long seed) {
+  fprintf(f, "{\"bench\":\"soak\",\"seed\":%lu,\"modules\":%d,", seed,
+          NUM_MODULES);
+  fprintf(f, "\"cycles\":%llu,\"sim_h\":%.3f,\"nominal_h\":%.3f,",
+          (unsigned long long)r->cycles, (double)r->sim_ms / 3600000.0,
+          (double)r->nominal_ms / 3600000.0);
+  fprintf(f, "\"evals_per_s\":%.0f,\"ns_per_eval\":%.1f,\"alert_frac\":%.4f,",
+          r->eval_ns ? (double)r->cycles * 1e9 / (double)r->eval_ns : 0.0,
+          r->cycles ? (double)r->eval_ns / (double)r->cycles : 0.0,
+          r->sim_ms ? (double)r->alert_ms / (double)r->sim_ms : 0.0);
+  fprintf(f, "\"targets\":{");
+  for (int s = STATE_NORMAL; s <= STATE_EMERGENCY; s++) {
+    fprintf(f, "%s\"%s\":{\"episodes\":%lu,\"missed\":%lu,\"latency_ms\":",
+            s ? "," : "", correlation_state_name((system_state_t)s),
+            (unsigned long)r->episodes[s], (unsigned long)r->missed[s]);
+    json_dist(f, &r->latency[s]);
+    fprintf(f, "}");
+  }
+  fprintf(f, "},\"faults\":{");
+  for (int k = 0; k < F_COUNT; k++)
+    fprintf(f, "%s\"%s\":{\"episodes\":%lu,\"missed\":%lu}", k ? "," : "",
+            fault_names[k], (unsigned long)r->kind_episodes[k],
+            (unsigned long)r->kind_missed[k]);
+  fprintf(f, "},\"false_alarms\":%lu,\"false_alarms_per_h\":%.3f,",
+          (unsigned long)r->false_alarms,
+          per_hour(r->false_alarms, r->nominal_ms));
+  fprintf(f, "\"false_trips\":%lu,\"false_trips_per_h\":%.3f,",
+          (unsigned long)r->false_trips,
+          per_hour(r->false_trips, r->nominal_ms));
+  fprintf(f, "\"stuck\":%lu,\"recovery_ms\":", (unsigned long)r->stuck);
+  json_dist(f, &r->recovery);
+  fprintf(f, "}\n");
+}
+
+int main(int argc, char **argv) {
+  long n = argc > 1 ? atol(argv[1]) : 5000;
+  unsigned long seed = argc > 2 ? strtoul(argv[2], NULL, 0) : 1ul;
+  const char *json = argc > 3 ? argv[3] : NULL;
+  if (n < 1)
+    n = 1;
+
+  anomaly_thresholds_t th;
+  anomaly_eval_init(&th);
+  for (int i = 4; i < argc; i++) {
+    char *eq = strchr(argv[i], '=');
+    long id = strtol(argv[i], NULL, 0);
+    double v = eq ? strtod(eq + 1, NULL) : 0.0;
+    if (!eq || anomaly_thresholds_set(&th, (uint8_t)id,
+                                      (int32_t)(v * 1000.0)) != HAL_OK) {
+      fprintf(stderr, "bad threshold override '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+  if (anomaly_thresholds_check(&th) != HAL_OK) {
+    fprintf(stderr, "threshold overrides are inconsistent\n");
+    return 1;
+  }
+
+  static soak_result_t res;
+  static uint32_t lat_buf[STATE_EMERGENCY + 2][LAT_MAX];
+  memset(&res, 0, sizeof(res));
+  for (int s = 0; s <= STATE_EMERGENCY; s++)
+    res.latency[s].ms = lat_buf[s];
+  res.recovery.ms = lat_buf[STATE_EMERGENCY + 1];
+
+  g_rng = seed * 0x9E3779B97F4A7C15ull + 1u; /* Never zero */
+  printf("Soak benchmark: %d modules × %d groups, %ld episodes, seed %lu\n",
+         NUM_MODULES, GROUPS_PER_MODULE, n, seed);
+  soak((uint32_t)n, &th, &res);
+
+  printf("  %llu cycles, %.1f h simulated (%.1f h nominal, %.1f %% at the"
+         " alert rate)\n",
+         (unsigned long long)res.cycles, (double)res.sim_ms / 3600000.0,
+         (double)res.nominal_ms / 3600000.0,
+         res.sim_ms ? 100.0 * (double)res.alert_ms / (double)res.sim_ms : 0.0);
+  printf("  %.1f ns/eval (%.0f evals/s), %.2f s wall\n\n",
+         (double)res.eval_ns / (double)res.cycles,
+         res.eval_ns ? (double)res.cycles * 1e9 / (double)res.eval_ns : 0.0,
+         (double)res.wall_ns / 1e9);
+
+  printf("  %-10s %9s %7s\n", "target", "episodes", "missed");
+  for (int s = STATE_NORMAL; s <= STATE_EMERGENCY; s++)
+    printf("  %-10s %9lu %7lu\n", correlation_state_name((system_state_t)s),
+           (unsigned long)res.episodes[s], (unsigned long)res.missed[s]);
+  printf("\n  Detection latency (first crossing → engine at target):\n");
+  for (int s = STATE_WARNING; s <= STATE_EMERGENCY; s++)
+    print_dist(correlation_state_name((system_state_t)s), &res.latency[s]);
+  print_dist("recovery", &res.recovery);
+
+  printf("\n  %-12s %9s %7s\n", "fault", "episodes", "missed");
+  for (int k = 0; k < F_COUNT; k++)
+    printf("  %-12s %9lu %7lu\n", fault_names[k],
+           (unsigned long)res.kind_episodes[k],
+           (unsigned long)res.kind_missed[k]);
+  printf("\n  false alarms %lu (%.2f/h), false trips %lu (%.3f/h), "
+         "stuck %lu\n",
+         (unsigned long)res.false_alarms,
+         per_hour(res.false_alarms, res.nominal_ms),
+         (unsigned long)res.false_trips,
+         per_hour(res.false_trips, res.nominal_ms), (unsigned long)res.stuck);
+
+  if (json) {
+    FILE *f = strcmp(json, "-") == 0 ? stdout : fopen(json, "w");
+    if (!f) {
+      fprintf(stderr, "cannot write %s\n", json);
+      return 1;
+    }
+    write_json(f, &res, seed);
+    if (f != stdout)
+      fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,417 @@
+/*
+ * capture_eval.c — Host Backtest over Binary Input Captures
+ *
+ * Re-runs the board's med-loop detection over recorded captures
+ * (capture.h), many files at once, to see what a threshold change
+ * would have done over weeks of drive cycles:
+ *
+ *   mmap ─▶ capture_decode() ─▶ history.h dT/dt, dR/dt
+ *     ─▶ anomaly_eval_compute() ─▶ anomaly_eval_run_plan()
+ *     ─▶ correlation_engine_update()
+ *
+ * Each file is replayed as the board would have seen it: every record
+ * is decoded in time order (missing module frames hold, and nothing is
+ * evaluated before every module has arrived once), and the snapshot is
+ * sampled at the med-loop rate main.c uses (500 ms, 100 ms once
+ * anything is active, holds recomputed on every rate change). The
+ * dT/dt and dR/dt windows are main.c's; the rates of every module are
+ * refreshed on every pass, the short-circuit flag is set from the
+ * sampled current (as bench_replay.c), and module staleness and the
+ * baseline-drift z scores are not modelled.
+ *
+ * Files are handed out one at a time to a pool of worker threads; each
+ * file is replayed once per threshold set: the defaults, and, with -t,
+ * a candidate set with the overrides applied. Records are read in
+ * place from the mapping, so a file costs no more memory than the
+ * pages being read.
+ *
+ * Output is one CSV row per file and set on stdout:
+ *
+ *   file,set,records,hours,evals,warning,critical,emergency,
+ *   warning_s,critical_s,emergency_s,first_emergency_s
+ *
+ * (state entries, time in each state, first EMERGENCY from the start
+ * of the file, -1 if none), then totals and throughput on stderr.
+ *
+ * Compile:
+ *   cd 3_Firmware
+ *   gcc -Wall -Wextra -O2 -o capture_eval tests/capture_eval.c \
+ *       src/capture.c src/anomaly_eval.c src/correlation_engine.c \
+ *       src/history.c src/input_packet.c src/crc16.c -I src -lm -pthread
+ *
+ * Run:
+ *   ./capture_eval [-j threads] [-s from_ms] [-e to_ms]
+ *                  [-t id=value ...] file.cap ...
+ *
+ *   -j  worker threads (default: one per core)
+ *   -s  -e  only records within [from_ms, to_ms) of the recorder clock
+ *   -t  candidate override of threshold `id` (anomaly_thresholds_set()
+ *       ids, physical units), e.g. -t 10=0.8 for a 0.8 °C/min dT/dt
+ *       warning; repeatable
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "anomaly_eval.h"
+#include "capture.h"
+#include "correlation_engine.h"
+#include "history.h"
+
+/* -----------------------------------------------------------------------
+ * Replay parameters
+ * ----------------------------------------------------------------------- */
+
+#define HIST_DT_WINDOW_MS 3000 /* Same windows as main.c */
+#define HIST_DR_WINDOW_MS 2000
+
+#define MAX_THREADS 64
+#define SET_BASE 0
+#define SET_CANDIDATE 1
+#define MAX_SETS 2
+
+static const char *const set_names[MAX_SETS] = {"base", "candidate"};
+
+typedef struct {
+  anomaly_thresholds_t th;
+  anomaly_plan_t plan;
+} threshold_set_t;
+
+typedef struct {
+  uint64_t evals;
+  uint64_t ms[STATE_EMERGENCY + 1];      /* Time in each state     */
+  uint32_t entries[STATE_EMERGENCY + 1]; /* Rises into each state  */
+  int64_t first_emergency_ms;            /* From file start, -1    */
+} run_result_t;
+
+typedef struct {
+  const char *path;
+  bool ok;
+  uint64_t records;
+  uint64_t span_ms;
+  run_result_t run[MAX_SETS];
+} file_job_t;
+
+typedef struct {
+  file_job_t *jobs;
+  unsigned num_jobs;
+  atomic_uint next;
+  const threshold_set_t *sets;
+  unsigned num_sets;
+  uint32_t from_ms, to_ms;
+} backtest_t;
+
+static inline uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* -----------------------------------------------------------------------
+ * One file, one threshold set
+ * ----------------------------------------------------------------------- */
+
+static int32_t milli(float v) {
+  return (int32_t)(v * 1000.0f + (v < 0.0f ? -0.5f : 0.5f));
+}
+
+/* history_sample() and the rate half of med_loop() in main.c */
+static void update_rates(history_t *h, int win_dt, int win_dr, uint32_t t,
+                         sensor_snapshot_t *s) {
+  int32_t row[HIST_NUM_CHANNELS];
+  for (int m = 0; m < NUM_MODULES; m++) {
+    row[HIST_CH_NTC(m, 0)] = milli(s->modules[m].ntc1_c);
+    row[HIST_CH_NTC(m, 1)] = milli(s->modules[m].ntc2_c);
+  }
+  row[HIST_CH_R_INT] = milli(s->r_internal_mohm);
+  row[HIST_CH_CURRENT] = milli(s->pack_current_a);
+  row[HIST_CH_GAS_1] = milli(s->gas_ratio_1);
+  row[HIST_CH_GAS_2] = milli(s->gas_ratio_2);
+  row[HIST_CH_PRESSURE_1] = milli(s->pressure_delta_1_hpa);
+  row[HIST_CH_PRESSURE_2] = milli(s->pressure_delta_2_hpa);
+  history_push(h, t, row);
+
+  if (history_window_count(h, win_dr) >= 2)
+    s->dr_dt_mohm_per_s = history_slope(h, win_dr, HIST_CH_R_INT) / 1000.0f;
+  if (history_window_count(h, win_dt) < 2)
+    return;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    /* milli-°C/s → °C/min */
+    float d1 = history_slope(h, win_dt, HIST_CH_NTC(m, 0)) * (60.0f / 1000.0f);
+    float d2 = history_slope(h, win_dt, HIST_CH_NTC(m, 1)) * (60.0f / 1000.0f);
+    if (d1 < 0)
+      d1 = -d1;
+    if (d2 < 0)
+      d2 = -d2;
+    s->modules[m].max_dt_dt = d1 > d2 ? d1 : d2;
+  }
+}
+
+static void replay(const capture_file_t *c, uint64_t first, uint64_t end,
+                   const threshold_set_t *set, run_result_t *r) {
+  sensor_snapshot_t snap;
+  history_t hist;
+  correlation_engine_t corr;
+
+  memset(&snap, 0, sizeof(snap));
+  history_init(&hist);
+  int win_dt = history_add_window(&hist, HIST_CH_NTC(0, 0), 2 * NUM_MODULES,
+                                  HIST_DT_WINDOW_MS);
+  int win_dr = history_add_window(&hist, HIST_CH_R_INT, 1, HIST_DR_WINDOW_MS);
+  correlation_engine_init(&corr);
+
+  uint32_t period = CORR_MED_NORMAL_MS;
+  memset(r, 0, sizeof(run_result_t));
+  r->first_emergency_ms = -1;
+
+  /* The board runs on its own until a cycle has brought every module */
+  module_mask_t seen = 0;
+  uint64_t next = first;
+  while (next < end && seen != MODULE_MASK_ALL)
+    seen |= capture_decode(&c->records[next++], &snap);
+  if (seen != MODULE_MASK_ALL)
+    return;
+
+  const uint32_t t0 = c->records[first].t_ms;
+  const uint32_t t_end = c->records[end - 1].t_ms;
+  system_state_t last = STATE_NORMAL;
+
+  for (uint32_t t = c->records[next - 1].t_ms;; t += period) {
+    /* Every cycle the board would have received by now */
+    while (next < end && c->records[next].t_ms <= t)
+      (void)capture_decode(&c->records[next++], &snap);
+
+    update_rates(&hist, win_dt, win_dr, t, &snap);
+    float i = snap.pack_current_a;
+    snap.short_circuit =
+        i > set->plan.current_short_a || i < set->plan.current_short_neg_a;
+    anomaly_eval_compute(&snap, &set->th);
+    anomaly_result_t an = anomaly_eval_run_plan(&set->plan, &snap);
+    system_state_t st = correlation_engine_update(&corr, &an);
+
+    r->evals++;
+    if (st > last)
+      r->entries[st]++;
+    if (st == STATE_EMERGENCY && r->first_emergency_ms < 0)
+      r->first_emergency_ms = (int64_t)(t - t0);
+    last = st;
+
+    /* Sampling rate for the next pass, by the firmware's policy */
+    uint32_t rate = correlation_med_period_ms(&corr, &an, snap.short_circuit);
+    r->ms[st] += rate; /* Until the next pass */
+    if (rate != period)
+      correlation_engine_set_period(&corr, rate);
+    if (t >= t_end)
+      break;
+    period = rate;
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Worker pool: one file per grab
+ * ----------------------------------------------------------------------- */
+
+static void run_job(const backtest_t *b, file_job_t *job) {
+  capture_file_t cap;
+  if (capture_open(&cap, job->path) != HAL_OK)
+    return;
+
+  uint64_t first = capture_find(&cap, b->from_ms);
+  uint64_t end = b->to_ms ? capture_find(&cap, b->to_ms) : cap.count;
+  if (first < end) {
+    job->records = end - first;
+    job->span_ms = cap.records[end - 1].t_ms - cap.records[first].t_ms;
+    for (unsigned s = 0; s < b->num_sets; s++)
+      replay(&cap, first, end, &b->sets[s], &job->run[s]);
+  }
+  job->ok = true;
+  capture_close(&cap);
+}
+
+static void *worker(void *arg) {
+  backtest_t *b = arg;
+  for (;;) {
+    unsigned i = atomic_fetch_add(&b->next, 1u);
+    if (i >= b->num_jobs)
+      return NULL;
+    run_job(b, &b->jobs[i]);
+  }
+}
+
+/* -----------------------------------------------------------------------
+ * Report
+ * ----------------------------------------------------------------------- */
+
+static void print_row(const char *path, const char *set, uint64_t records,
+                      uint64_t span_ms, const run_result_t *r) {
+  printf("%s,%s,%llu,%.3f,%llu,%lu,%lu,%lu,%.1f,%.1f,%.1f,%.1f\n", path, set,
+         (unsigned long long)records, (double)span_ms / 3600000.0,
+         (unsigned long long)r->evals, (unsigned long)r->entries[STATE_WARNING],
+         (unsigned long)r->entries[STATE_CRITICAL],
+         (unsigned long)r->entries[STATE_EMERGENCY],
+         (double)r->ms[STATE_WARNING] / 1000.0,
+         (double)r->ms[STATE_CRITICAL] / 1000.0,
+         (double)r->ms[STATE_EMERGENCY] / 1000.0,
+         r->first_emergency_ms < 0 ? -1.0
+                                   : (double)r->first_emergency_ms / 1000.0);
+}
+
+static void add_run(run_result_t *sum, const run_result_t *r) {
+  sum->evals += r->evals;
+  for (int s = STATE_NORMAL; s <= STATE_EMERGENCY; s++) {
+    sum->ms[s] += r->ms[s];
+    sum->entries[s] += r->entries[s];
+  }
+}
+
+static bool run_differs(const run_result_t *a, const run_result_t *b) {
+  if (a->first_emergency_ms != b->first_emergency_ms)
+    return true;
+  for (int s = STATE_WARNING; s <= STATE_EMERGENCY; s++)
+    if (a->entries[s] != b->entries[s] || a->ms[s] != b->ms[s])
+      return true;
+  return false;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: capture_eval [-j threads] [-s from_ms] "
+                  "[-e to_ms] [-t id=value ...] file.cap ...\n");
+}
+
+int main(int argc, char **argv) {
+  static threshold_set_t sets[MAX_SETS];
+  unsigned threads = 0, num_sets = 1;
+  uint32_t from_ms = 0, to_ms = 0;
+
+  anomaly_eval_init(&sets[SET_BASE].th);
+  sets[SET_CANDIDATE].th = sets[SET_BASE].th;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "j:s:e:t:")) != -1) {
+    switch (opt) {
+    case 'j':
+      threads = (unsigned)strtoul(optarg, NULL, 0);
+      break;
+    case 's':
+      from_ms = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 'e':
+      to_ms = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 't': {
+      char *eq = strchr(optarg, '=');
+      long id = strtol(optarg, NULL, 0);
+      double v = eq ? strtod(eq + 1, NULL) : 0.0;
+      if (!eq || anomaly_thresholds_set(&sets[SET_CANDIDATE].th, (uint8_t)id,
+                                        (int32_t)(v * 1000.0)) != HAL_OK) {
+        fprintf(stderr, "bad threshold override '%s'\n", optarg);
+        return 1;
+      }
+      num_sets = 2;
+      break;
+    }
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    usage();
+    return 1;
+  }
+  if (anomaly_thresholds_check(&sets[SET_CANDIDATE].th) != HAL_OK) {
+    fprintf(stderr, "threshold overrides are inconsistent\n");
+    return 1;
+  }
+  for (unsigned s = 0; s < num_sets; s++)
+    anomaly_plan_compile(&sets[s].plan, &sets[s].th);
+
+  backtest_t b = {0};
+  b.num_jobs = (unsigned)(argc - optind);
+  b.jobs = calloc(b.num_jobs, sizeof(file_job_t));
+  if (!b.jobs)
+    return 1;
+  for (unsigned i = 0; i < b.num_jobs; i++)
+    b.jobs[i].path = argv[optind + (int)i];
+  b.sets = sets;
+  b.num_sets = num_sets;
+  b.from_ms = from_ms;
+  b.to_ms = to_ms;
+
+  if (threads == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores > 0 ? (unsigned)cores : 1u;
+  }
+  if (threads > MAX_THREADS)
+    threads = MAX_THREADS;
+  if (threads > b.num_jobs)
+    threads = b.num_jobs;
+
+  /* The calling thread is worker 0 */
+  pthread_t tid[MAX_THREADS];
+  unsigned started = 1;
+  uint64_t t_start = now_ns();
+  for (; started < threads; started++)
+    if (pthread_create(&tid[started], NULL, worker, &b) != 0)
+      break;
+  worker(&b);
+  for (unsigned i = 1; i < started; i++)
+    pthread_join(tid[i], NULL);
+  uint64_t wall_ns = now_ns() - t_start;
+
+  printf("file,set,records,hours,evals,warning,critical,emergency,"
+         "warning_s,critical_s,emergency_s,first_emergency_s\n");
+  run_result_t sum[MAX_SETS];
+  memset(sum, 0, sizeof(sum));
+  uint64_t records = 0, span_ms = 0;
+  unsigned failed = 0, changed = 0, emergency_files[MAX_SETS] = {0};
+  for (unsigned i = 0; i < b.num_jobs; i++) {
+    const file_job_t *j = &b.jobs[i];
+    if (!j->ok) {
+      fprintf(stderr, "%s: not a readable capture for this pack\n", j->path);
+      failed++;
+      continue;
+    }
+    records += j->records;
+    span_ms += j->span_ms;
+    for (unsigned s = 0; s < num_sets; s++) {
+      print_row(j->path, set_names[s], j->records, j->span_ms, &j->run[s]);
+      add_run(&sum[s], &j->run[s]);
+      if (j->run[s].first_emergency_ms >= 0)
+        emergency_files[s]++;
+    }
+    if (num_sets > 1 && run_differs(&j->run[SET_BASE], &j->run[SET_CANDIDATE]))
+      changed++;
+  }
+
+  fprintf(stderr, "\n%u files (%u unreadable), %llu records, %.1f h of data\n",
+          b.num_jobs - failed, failed, (unsigned long long)records,
+          (double)span_ms / 3600000.0);
+  fprintf(stderr, "  %-10s %7s %8s %9s %12s %12s %6s\n", "set", "warning",
+          "critical", "emergency", "critical_s", "emergency_s", "files");
+  for (unsigned s = 0; s < num_sets; s++)
+    fprintf(stderr, "  %-10s %7lu %8lu %9lu %12.1f %12.1f %6u\n",
+            set_names[s], (unsigned long)sum[s].entries[STATE_WARNING],
+            (unsigned long)sum[s].entries[STATE_CRITICAL],
+            (unsigned long)sum[s].entries[STATE_EMERGENCY],
+            (double)sum[s].ms[STATE_CRITICAL] / 1000.0,
+            (double)sum[s].ms[STATE_EMERGENCY] / 1000.0, emergency_files[s]);
+  if (num_sets > 1)
+    fprintf(stderr, "  candidate changes the outcome of %u files\n", changed);
+
+  uint64_t evals = sum[SET_BASE].evals + sum[SET_CANDIDATE].evals;
+  double secs = (double)wall_ns / 1e9;
+  fprintf(stderr, "  %u threads, %.2f s wall, %.0f records/s, %.0f evals/s\n",
+          started, secs, secs > 0 ? (double)(records * num_sets) / secs : 0.0,
+          secs > 0 ? (double)evals / secs : 0.0);
+
+  free(b.jobs);
+  return failed ? 1 : 0;
+}
@@ -7,21 +7,52 @@
  * Compile:
  *   cd 3_Firmware
  *   gcc -Wall -Wextra -o test_runner tests/test_main.c \
- *       src/anomaly_eval.c src/correlation_engine.c \
- *       src/packet_format.c -I src -lm
+ *       src/anomaly_eval.c src/anomaly_eval_fx.c src/correlation_engine.c \
+ *       src/crc16.c src/fleet_eval.c src/history.c src/packet_format.c \
+ *       src/input_packet.c src/scheduler.c src/latency_stats.c src/ntc_lut.c \
+ *       src/ntc_scan.c src/safety_trip.c src/hal_adc.c src/hal_gpio.c \
+ *       src/hal_timer.c src/voltage_plane.c src/hal_flash.c src/blackbox.c \
+ *       src/module_rate.c src/online_stats.c src/log_event.c src/hal_uart.c \
+ *       src/acquire.c src/hal_i2c.c src/capture.c drivers/bme680.c \
+ *       drivers/fsr.c drivers/ina219.c -I src -lm -pthread
  *
  * Run:
  *   ./test_runner
  */
 
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "../drivers/fsr.h"
+#include "../drivers/ina219.h"
+#include "acquire.h"
 #include "anomaly_eval.h"
+#include "anomaly_eval_fx.h"
+#include "blackbox.h"
+#include "capture.h"
 #include "correlation_engine.h"
+#include "crc16.h"
+#include "fleet_eval.h"
+#include "hal_adc.h"
+#include "hal_gpio.h"
+#include "hal_i2c.h"
+#include "hal_timer.h"
+#include "history.h"
+#include "input_packet.h"
+#include "latency_stats.h"
+#include "log_event.h"
+#include "module_rate.h"
+#include "ntc_lut.h"
+#include "online_stats.h"
+#include "ntc_scan.h"
 #include "packet_format.h"
+#include "safety_trip.h"
+#include "scheduler.h"
+#include "voltage_plane.h"
 
 /* -----------------------------------------------------------------------
  * Test counters
@@ -52,14 +83,15 @@ static sensor_snapshot_t make_normal_snapshot(void) {
   memset(&s, 0, sizeof(s));
 
   /* Electrical — full pack */
-  s.pack_voltage_v = 332.8f; /* 104 × 3.2V */
+  s.pack_voltage_v = 3.2f * (float)TOTAL_SERIES; /* 104 × 3.2V */
   s.pack_current_a = 60.0f;  /* 0.5C = 60A */
   s.r_internal_mohm = 0.44f; /* 3.5mΩ/8 cells */
 
-  /* 8 modules, each with 13 groups */
+  /* NUM_MODULES modules, each with GROUPS_PER_MODULE groups */
+  /* 2.4°C gradient end to end (0.3°C/module on the 8-module pack) */
   for (int m = 0; m < NUM_MODULES; m++) {
-    s.modules[m].ntc1_c = 28.0f + (float)m * 0.3f;
-    s.modules[m].ntc2_c = 28.2f + (float)m * 0.3f;
+    s.modules[m].ntc1_c = 28.0f + (float)m * (2.4f / NUM_MODULES);
+    s.modules[m].ntc2_c = 28.2f + (float)m * (2.4f / NUM_MODULES);
     s.modules[m].swelling_pct = 0.5f;
     s.modules[m].max_dt_dt = 0.01f;
     for (int g = 0; g < GROUPS_PER_MODULE; g++) {
@@ -313,6 +345,17 @@ static void test_escalation_sequence(void) {
   }
   TEST_ASSERT(state == STATE_NORMAL,
               "Phase 5: returns to NORMAL after nominal recovery window");
+
+  /* Rate policy: alert period while anything is wrong, holds in time */
+  uint32_t calm = correlation_med_period_ms(&engine, &result, false);
+  uint32_t shorted = correlation_med_period_ms(&engine, &result, true);
+  correlation_engine_set_period(&engine, shorted);
+  TEST_ASSERT(calm == CORR_MED_NORMAL_MS && shorted == CORR_MED_ALERT_MS &&
+                  engine.critical_countdown_limit ==
+                      CORR_CRITICAL_HOLD_MS / CORR_MED_ALERT_MS &&
+                  engine.deescalation_limit ==
+                      CORR_DEESCALATION_HOLD_MS / CORR_MED_ALERT_MS,
+              "Alert period and holds rescaled to the same time");
 }
 
 /* -----------------------------------------------------------------------
@@ -337,7 +380,7 @@ static void test_packet_format(void) {
               "Pack frame size correct");
   TEST_ASSERT(pkt.sync == PACKET_SYNC_BYTE, "Sync byte is 0xAA");
   TEST_ASSERT(pkt.frame_type == PACKET_TYPE_PACK, "Frame type is PACK");
-  TEST_ASSERT(pkt.pack_voltage_dv == 3328,
+  TEST_ASSERT(pkt.pack_voltage_dv == TOTAL_SERIES * 32,
               "Pack voltage encoded correctly (332.8V → 3328)");
   TEST_ASSERT(pkt.system_state == STATE_NORMAL, "System state = NORMAL");
   TEST_ASSERT(pkt.cascade_stage == 0, "Cascade stage = 0 (Normal)");
@@ -648,10 +691,2657 @@ static void test_core_temp_estimation(void) {
               "Core-surface delta > 5°C at extreme current (500A)");
 }
 
+/* -----------------------------------------------------------------------
+ * Test 18: Streaming input parser — resync on noise and bad frames
+ * ----------------------------------------------------------------------- */
+
+static uint8_t xor_bytes(const uint8_t *p, int n) {
+  uint8_t c = 0;
+  for (int i = 0; i < n; i++)
+    c ^= p[i];
+  return c;
+}
+
+static void make_input_pack(input_pack_frame_t *pf, int16_t current_da) {
+  memset(pf, 0, sizeof(*pf));
+  pf->sync = INPUT_SYNC_BYTE;
+  pf->length = INPUT_PACK_FRAME_SIZE;
+  pf->frame_type = INPUT_TYPE_PACK;
+  pf->pack_voltage_dv = TOTAL_SERIES * 32; /* 3.2 V per group */
+  pf->pack_current_da = current_da;
+  pf->ambient_temp_dt = 250;
+  pf->gas_ratio_1_cp = 98;
+  pf->gas_ratio_2_cp = 97;
+  pf->checksum = xor_bytes((const uint8_t *)pf, INPUT_PACK_FRAME_SIZE - 1);
+}
+
+static void make_input_module(input_module_frame_t *mf, uint8_t idx) {
+  memset(mf, 0, sizeof(*mf));
+  mf->sync = INPUT_SYNC_BYTE;
+  mf->length = INPUT_MODULE_FRAME_SIZE;
+  mf->frame_type = INPUT_TYPE_MODULE;
+  mf->module_index = idx;
+  mf->ntc1_dt = (int16_t)(280 + idx);
+  mf->ntc2_dt = (int16_t)(282 + idx);
+  mf->v_base_mv = 3200;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    mf->v_delta[g] = (int8_t)(g - 6);
+  mf->checksum = xor_bytes((const uint8_t *)mf, INPUT_MODULE_FRAME_SIZE - 1);
+}
+
+static int feed_bytes(input_rx_state_t *rx, const void *data, int n) {
+  const uint8_t *p = (const uint8_t *)data;
+  int last = 0;
+  for (int i = 0; i < n; i++) {
+    int r = input_rx_feed(rx, p[i]);
+    if (r > last)
+      last = r;
+  }
+  return last;
+}
+
+static void test_input_parser(void) {
+  printf("\n--- Test 18: Streaming Input Frame Parser ---\n");
+
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+
+  input_pack_frame_t pf;
+  input_module_frame_t mf;
+
+  /* Line noise, including stray sync bytes, before the first frame */
+  const uint8_t noise[] = {0x00, 0xBB, 0x07, 0xBB, 0xBB, 0x02, 0x55};
+  feed_bytes(&rx, noise, sizeof(noise));
+
+  make_input_pack(&pf, 1234);
+  int r = feed_bytes(&rx, &pf, sizeof(pf));
+  TEST_ASSERT(r == 1 && rx.pack_received, "Pack frame parsed after noise");
+  TEST_ASSERT(rx.last_pack.pack_current_da == 1234,
+              "Pack frame decoded in place");
+
+  /* All modules but the last valid, the last one corrupted */
+  const uint8_t last = NUM_MODULES - 1;
+  for (uint8_t m = 0; m < last; m++) {
+    make_input_module(&mf, m);
+    r = feed_bytes(&rx, &mf, sizeof(mf));
+  }
+  make_input_module(&mf, last);
+  mf.ntc1_dt ^= 0x10; /* Break the checksum */
+  r = feed_bytes(&rx, &mf, sizeof(mf));
+  TEST_ASSERT(r == 0 && !input_rx_has_full_snapshot(&rx),
+              "Corrupted module frame is rejected");
+  TEST_ASSERT((rx.modules_received & MODULE_BIT(last)) == 0,
+              "Corrupted slot not marked received");
+
+  /* Retransmitted last module completes the snapshot */
+  make_input_module(&mf, last);
+  r = feed_bytes(&rx, &mf, sizeof(mf));
+  TEST_ASSERT(r == 2, "Full snapshot signalled after retransmit");
+  TEST_ASSERT(rx.last_modules[last].ntc1_dt == 280 + last &&
+                  rx.last_modules[last].v_delta[12] == 6,
+              "Module 7 decoded into its slot");
+
+  /* Sync byte hidden inside a truncated frame is recovered */
+  input_rx_reset_cycle(&rx);
+  make_input_pack(&pf, -500);
+  uint8_t burst[8 + sizeof(pf)];
+  memcpy(burst, &pf, 8); /* Truncated frame start */
+  memcpy(burst + 8, &pf, sizeof(pf));
+  r = feed_bytes(&rx, burst, sizeof(burst));
+  TEST_ASSERT(r == 1 && rx.last_pack.pack_current_da == -500,
+              "Parser resyncs onto frame that starts inside a bad one");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 19: Double-buffered snapshot — writer never tears the pinned slot
+ * ----------------------------------------------------------------------- */
+static void test_snapshot_buffer(void) {
+  printf("\n--- Test 19: Double-Buffered Snapshot ---\n");
+
+  static snapshot_buffer_t sb;
+  snapshot_buffer_init(&sb);
+
+  sensor_snapshot_t *w = snapshot_begin_write(&sb);
+  w->pack_current_a = 60.0f;
+  w->modules[7].ntc1_c = 30.0f;
+  snapshot_publish(&sb, MODULE_MASK_ALL);
+
+  uint32_t seq = 0;
+  sensor_snapshot_t *r = snapshot_acquire(&sb, &seq);
+  TEST_ASSERT(r == w && seq == 1, "Reader pins the published slot");
+
+  /* A new frame lands while the evaluator holds the slot */
+  w = snapshot_begin_write(&sb);
+  TEST_ASSERT(w != NULL && w != r, "Writer fills the other slot");
+  w->pack_current_a = 400.0f;
+  w->modules[7].ntc1_c = 90.0f;
+  snapshot_publish(&sb, MODULE_MASK_ALL);
+  TEST_ASSERT(r->pack_current_a == 60.0f && r->modules[7].ntc1_c == 30.0f,
+              "Pinned slot untouched by publish");
+
+  /* Writer laps the reader: the only free slot is the pinned one */
+  TEST_ASSERT(snapshot_begin_write(&sb) == NULL,
+              "Writer refused the slot the reader holds");
+
+  snapshot_release(&sb);
+  r = snapshot_acquire(&sb, &seq);
+  TEST_ASSERT(r->pack_current_a == 400.0f && r->modules[7].ntc1_c == 90.0f &&
+                  seq == 2,
+              "Next acquire sees the newest frame, both fields together");
+  snapshot_release(&sb);
+}
+
+/* -----------------------------------------------------------------------
+ * Test 20: Deadline scheduler — priority order, rate switch, overrun
+ * ----------------------------------------------------------------------- */
+static char sched_trace[16];
+static int sched_trace_len = 0;
+
+static void sched_task_a(void) { sched_trace[sched_trace_len++] = 'F'; }
+static void sched_task_b(void) { sched_trace[sched_trace_len++] = 'M'; }
+static void sched_task_c(void) { sched_trace[sched_trace_len++] = 'S'; }
+
+static void test_scheduler(void) {
+  printf("\n--- Test 20: Deadline Scheduler ---\n");
+
+  sched_t s;
+  sched_init(&s);
+  /* Registered out of priority order on purpose */
+  int slow = sched_add(&s, sched_task_c, 5000, 2, 0);
+  int fast = sched_add(&s, sched_task_a, 100, 0, 0);
+  int med = sched_add(&s, sched_task_b, 500, 1, 0);
+  TEST_ASSERT(slow >= 0 && fast >= 0 && med >= 0, "Three tasks registered");
+
+  sched_trace_len = 0;
+  uint8_t ran = sched_run_due(&s, 0);
+  TEST_ASSERT(ran == 3 && memcmp(sched_trace, "FMS", 3) == 0,
+              "All due tasks run highest priority first");
+  TEST_ASSERT(sched_ms_until_next(&s, 0) == 100, "Next deadline is fast loop");
+
+  /* Alert switch at t=10 pulls the fast deadline from 100 to 30 */
+  sched_set_period(&s, fast, 20, 10);
+  TEST_ASSERT(s.tasks[fast].next_ms == 30, "Shorter period pulls deadline in");
+
+  /* A late pass (t=37) runs once and keeps the 20 ms grid */
+  sched_trace_len = 0;
+  ran = sched_run_due(&s, 37);
+  TEST_ASSERT(ran == 1 && s.tasks[fast].next_ms == 50,
+              "Late release keeps its grid (no drift)");
+
+  /* Stalled for 10 periods: one run, backlog dropped, counted */
+  ran = sched_run_due(&s, 250);
+  TEST_ASSERT(ran == 1 && s.tasks[fast].next_ms == 270,
+              "Overrun realigns instead of bursting");
+  TEST_ASSERT(s.tasks[fast].missed == 10, "Skipped releases counted");
+
+  /* Deadlines straddling the 32-bit wrap */
+  sched_reset(&s, 0xFFFFFFF0u);
+  sched_trace_len = 0;
+  (void)sched_run_due(&s, 0xFFFFFFF0u);
+  TEST_ASSERT(sched_ms_until_next(&s, 0xFFFFFFF0u) == 20,
+              "Wait computed across counter wrap");
+  ran = sched_run_due(&s, 0x00000004u);
+  TEST_ASSERT(ran == 1 && sched_trace[sched_trace_len - 1] == 'F',
+              "Fast task fires after counter wrap");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 21: Latency histograms and the 0x03 telemetry frame
+ * ----------------------------------------------------------------------- */
+static void test_latency_stats(void) {
+  printf("\n--- Test 21: Loop Latency Statistics ---\n");
+
+  static latency_stats_t ls;
+  latency_stats_init(&ls);
+  latency_stats_set_budget(&ls, LAT_FAST_LOOP, 20000);
+
+  /* 99 fast passes at 1-99 µs... */
+  for (uint32_t us = 1; us <= 99; us++)
+    latency_stats_record(&ls, LAT_FAST_LOOP, us);
+  /* ...and one 25 ms outlier that blows the 20 ms budget */
+  latency_stats_record(&ls, LAT_FAST_LOOP, 25000);
+
+  const lat_stage_stats_t *st = &ls.stage[LAT_FAST_LOOP];
+  TEST_ASSERT(st->count == 100 && st->min_us == 1 && st->max_us == 25000,
+              "Count/min/max tracked");
+  TEST_ASSERT(latency_stats_mean_us(st) == (4950 + 25000) / 100,
+              "Mean over window");
+  TEST_ASSERT(st->overruns == 1, "Budget overrun counted");
+
+  uint32_t p50 = latency_stats_percentile_us(st, 500);
+  TEST_ASSERT(p50 >= 50 && p50 <= 63, "p50 within one log-linear bucket");
+  uint32_t p99 = latency_stats_percentile_us(st, 990);
+  TEST_ASSERT(p99 >= 99 && p99 <= 127, "p99 excludes the single outlier");
+  TEST_ASSERT(latency_stats_percentile_us(st, 1000) == 25000,
+              "p100 capped at the observed max");
+
+  telemetry_latency_frame_t pkt;
+  uint8_t len = packet_encode_latency(&pkt, LAT_FAST_LOOP, st);
+  TEST_ASSERT(len == PACKET_LATENCY_SIZE && sizeof(pkt) == PACKET_LATENCY_SIZE,
+              "Latency frame is 25 bytes");
+  TEST_ASSERT(pkt.frame_type == PACKET_TYPE_LATENCY && pkt.p99_us == p99 &&
+                  pkt.overruns == 1,
+              "Latency frame carries p99 and overruns");
+  uint8_t csum =
+      packet_checksum((const uint8_t *)&pkt, PACKET_LATENCY_SIZE - 1);
+  TEST_ASSERT(pkt.checksum == csum, "Latency frame checksum valid");
+
+  latency_stats_reset_window(&ls);
+  TEST_ASSERT(st->count == 0 && st->budget_us == 20000 &&
+                  latency_stats_percentile_us(st, 990) == 0,
+              "Window reset keeps the budget");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 22: Pre-emptive short-circuit trip on the decoded sample
+ * ----------------------------------------------------------------------- */
+static void test_safety_trip(void) {
+  printf("\n--- Test 22: Pre-emptive Short-Circuit Trip ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  safety_trip_t trip;
+  safety_trip_init(&trip, &t);
+
+  TEST_ASSERT(!safety_trip_check_da(&trip, 3500) && !trip.tripped,
+              "350.0 A exactly does not trip (strictly above)");
+  TEST_ASSERT(safety_trip_check_da(&trip, -3501) && trip.tripped,
+              "Reverse-current spike trips from deci-amp frame value");
+  TEST_ASSERT(!safety_trip_check_da(&trip, 4000) && trip.trip_count == 1,
+              "Latched: repeat samples do not re-fire");
+
+  TEST_ASSERT(safety_trip_take_pending(&trip) &&
+                  !safety_trip_take_pending(&trip),
+              "Full evaluation owed exactly once per trip");
+
+  safety_trip_clear(&trip);
+  TEST_ASSERT(!safety_trip_check_a(&trip, 349.9f) && !trip.tripped,
+              "Sensor sample below limit ignored after clear");
+  TEST_ASSERT(safety_trip_check_a(&trip, 400.0f) && trip.trip_count == 2,
+              "Sensor sample path trips too");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 23: Incremental compute matches a full recompute
+ * ----------------------------------------------------------------------- */
+static bool derived_equal(const sensor_snapshot_t *a,
+                          const sensor_snapshot_t *b) {
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_t *ma = &a->modules[m];
+    const module_data_t *mb = &b->modules[m];
+    if (ma->module_voltage != mb->module_voltage ||
+        ma->v_spread_mv != mb->v_spread_mv ||
+        ma->delta_t_intra != mb->delta_t_intra)
+      return false;
+  }
+  return a->v_spread_mv == b->v_spread_mv &&
+         a->temp_spread_c == b->temp_spread_c &&
+         a->hotspot_module == b->hotspot_module &&
+         a->hotspot_temp_c == b->hotspot_temp_c &&
+         a->dt_dt_max == b->dt_dt_max && a->t_core_est_c == b->t_core_est_c;
+}
+
+static void test_incremental_compute(void) {
+  printf("\n--- Test 23: Incremental Anomaly Compute ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  anomaly_eval_cache_t cache;
+  anomaly_eval_cache_init(&cache);
+
+  sensor_snapshot_t inc = make_normal_snapshot();
+  anomaly_eval_compute_incremental(&inc, &t, &cache, 0);
+  sensor_snapshot_t full = make_normal_snapshot();
+  compute_snapshot(&full);
+  TEST_ASSERT(derived_equal(&inc, &full) && cache.valid_mask == MODULE_MASK_ALL,
+              "Cold cache computes every module");
+
+  /* Module 6 heats up and one group sags; only its frame is dirty */
+  inc.modules[5].ntc1_c = full.modules[5].ntc1_c = 61.0f;
+  inc.modules[5].group_voltages_v[7] = full.modules[5].group_voltages_v[7] =
+      3.05f;
+  anomaly_eval_compute_incremental(&inc, &t, &cache, 1u << 5);
+  compute_snapshot(&full);
+  TEST_ASSERT(derived_equal(&inc, &full) && inc.hotspot_module == 6,
+              "One dirty module gives full-recompute results");
+
+  /* Fresh slot with no derived fields: clean modules come from cache */
+  sensor_snapshot_t slot = inc;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    slot.modules[m].module_voltage = 0.0f;
+    slot.modules[m].v_spread_mv = 0.0f;
+  }
+  anomaly_eval_compute_incremental(&slot, &t, &cache, 0);
+  TEST_ASSERT(derived_equal(&slot, &full),
+              "Clean modules' derived fields restored from cache");
+
+  /* dT/dt is not cached: a rate update needs no dirty bit */
+  inc.modules[2].max_dt_dt = full.modules[2].max_dt_dt = 1.5f;
+  anomaly_eval_compute_incremental(&inc, &t, &cache, 0);
+  compute_snapshot(&full);
+  TEST_ASSERT(inc.dt_dt_max == 1.5f && derived_equal(&inc, &full),
+              "Pack dT/dt max tracks rates without recompute");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 24: Fixed-point evaluator matches the float path
+ * ----------------------------------------------------------------------- */
+
+/* Float snapshot from wire units, as apply_external_input decodes */
+static void fx_to_float(const sensor_snapshot_fx_t *fx, sensor_snapshot_t *s) {
+  memset(s, 0, sizeof(*s));
+  s->pack_voltage_v = fx->pack_voltage_dv / 10.0f;
+  s->pack_current_a = fx->pack_current_da / 10.0f;
+  s->r_internal_mohm = fx->r_internal_uohm / 1000.0f;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    const module_data_fx_t *mfx = &fx->modules[m];
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      s->modules[m].group_voltages_v[g] = VPLANE_MV(&fx->vplane, m, g) / 1000.0f;
+    s->modules[m].ntc1_c = mfx->ntc1_dt / 10.0f;
+    s->modules[m].ntc2_c = mfx->ntc2_dt / 10.0f;
+    s->modules[m].swelling_pct = (float)mfx->swelling_pct;
+    s->modules[m].max_dt_dt = mfx->max_dt_dt_ddpm / 10.0f;
+  }
+  s->temp_ambient_c = fx->temp_ambient_dt / 10.0f;
+  s->coolant_inlet_c = fx->coolant_inlet_dt / 10.0f;
+  s->coolant_outlet_c = fx->coolant_outlet_dt / 10.0f;
+  s->gas_ratio_1 = fx->gas_ratio_1_cp / 100.0f;
+  s->gas_ratio_2 = fx->gas_ratio_2_cp / 100.0f;
+  s->pressure_delta_1_hpa = fx->pressure_delta_1_chpa / 100.0f;
+  s->pressure_delta_2_hpa = fx->pressure_delta_2_chpa / 100.0f;
+  s->humidity_pct = (float)fx->humidity_pct;
+  s->isolation_mohm = fx->isolation_dmohm / 10.0f;
+  s->short_circuit = fx->short_circuit;
+}
+
+/* Both evaluators on the same wire data; true if every output agrees */
+static bool fx_matches_float(const anomaly_thresholds_t *t,
+                             const sensor_snapshot_fx_t *in) {
+  anomaly_thresholds_fx_t tfx;
+  anomaly_thresholds_to_fx(&tfx, t);
+
+  sensor_snapshot_fx_t fx = *in;
+  sensor_snapshot_t s;
+  fx_to_float(&fx, &s);
+
+  anomaly_eval_compute(&s, t);
+  anomaly_result_t rf = anomaly_eval_run(t, &s);
+  anomaly_eval_fx_compute(&fx, &tfx);
+  anomaly_result_t rx = anomaly_eval_fx_run(&tfx, &fx);
+
+  return rf.active_mask == rx.active_mask &&
+         rf.anomaly_modules_mask == rx.anomaly_modules_mask &&
+         rf.is_short_circuit == rx.is_short_circuit &&
+         rf.is_emergency_direct == rx.is_emergency_direct &&
+         rf.hotspot_module == rx.hotspot_module &&
+         rf.cascade_stage == rx.cascade_stage &&
+         abs((int)rf.risk_q15 - (int)rx.risk_q15) < 66 && /* 0.002 */
+         fabsf(s.v_spread_mv - (float)fx.v_spread_mv) < 0.01f;
+}
+
+static sensor_snapshot_fx_t make_normal_fx(void) {
+  sensor_snapshot_t s = make_normal_snapshot();
+  sensor_snapshot_fx_t fx;
+  memset(&fx, 0, sizeof(fx));
+  anomaly_snapshot_to_fx(&fx, &s);
+  return fx;
+}
+
+static uint32_t fx_rng = 12345u;
+static int32_t fx_rand(int32_t lo, int32_t hi) {
+  fx_rng = fx_rng * 1664525u + 1013904223u;
+  return lo + (int32_t)((fx_rng >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+static void test_fixed_point_equivalence(void) {
+  printf("\n--- Test 24: Fixed-Point Evaluator Equivalence ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  anomaly_thresholds_fx_t tfx;
+  anomaly_thresholds_to_fx(&tfx, &t);
+
+  TEST_ASSERT(tfx.voltage_low_dv == (uint16_t)(PACK_VOLTAGE_LOW_V * 10.0f) &&
+                  tfx.group_v_deviation_x13 == 15 * GROUPS_PER_MODULE &&
+                  tfx.r_int_warning_uohm == 550 && tfx.gas_warning_cp == 70 &&
+                  tfx.dt_dt_warning_ddpm == 5 &&
+                  tfx.delta_t_ambient_warning_dt == 200,
+              "Default thresholds convert exactly to wire units");
+
+  sensor_snapshot_fx_t fx = make_normal_fx();
+  TEST_ASSERT(fx_matches_float(&t, &fx), "Normal pack: paths agree");
+
+  fx = make_normal_fx();
+  fx.modules[2].ntc1_dt = 635;
+  fx.modules[2].ntc2_dt = 568;
+  fx.modules[2].max_dt_dt_ddpm = 3;
+  VPLANE_MV(&fx.vplane, 4, 6) = 3170; /* 30 mV sag in one group */
+  TEST_ASSERT(fx_matches_float(&t, &fx), "Thermal hotspot + sag: paths agree");
+
+  fx = make_normal_fx();
+  fx.pack_voltage_dv = 2800;
+  fx.pack_current_da = 4000;
+  fx.short_circuit = true;
+  fx.modules[4].ntc1_dt = 950;
+  fx.modules[4].max_dt_dt_ddpm = 30;
+  fx.modules[4].swelling_pct = 12;
+  fx.gas_ratio_1_cp = 20;
+  fx.pressure_delta_1_chpa = 800;
+  TEST_ASSERT(fx_matches_float(&t, &fx), "Short circuit + runaway: paths agree");
+
+  /* Random packs against thresholds half a wire step off the grid, so
+   * no reading lands exactly on a threshold and both must agree */
+  anomaly_thresholds_t th = t;
+  th.voltage_low_v += 0.05f;
+  th.voltage_high_v += 0.05f;
+  th.group_v_deviation_mv = 195.5f / GROUPS_PER_MODULE;
+  th.v_spread_warn_mv += 0.5f;
+  th.current_warning_a += 0.05f;
+  th.current_short_a += 0.05f;
+  th.current_emergency_a += 0.05f;
+  th.r_int_warning_mohm += 0.0005f;
+  th.temp_warning_c += 0.05f;
+  th.temp_emergency_c += 0.05f;
+  th.dt_dt_warning += 0.05f;
+  th.dt_dt_emergency += 0.05f;
+  th.inter_module_dt_warn_c += 0.05f;
+  th.intra_module_dt_warn_c += 0.05f;
+  th.delta_t_ambient_warning += 0.05f;
+  th.gas_warning_ratio += 0.005f;
+  th.pressure_warning_hpa += 0.005f;
+  th.swelling_warning_pct += 0.5f;
+
+  int mismatches = 0;
+  for (int n = 0; n < 2000; n++) {
+    memset(&fx, 0, sizeof(fx));
+    fx.pack_voltage_dv = (uint16_t)fx_rand(2500, 3900);
+    fx.pack_current_da = (int16_t)fx_rand(-6000, 6000);
+    fx.r_internal_uohm = (uint16_t)fx_rand(300, 700);
+    for (int m = 0; m < NUM_MODULES; m++) {
+      int32_t base = fx_rand(3150, 3250);
+      for (int g = 0; g < GROUPS_PER_MODULE; g++)
+        VPLANE_MV(&fx.vplane, m, g) = (int16_t)(base + fx_rand(-25, 25));
+      fx.modules[m].ntc1_dt = (int16_t)fx_rand(250, 650);
+      fx.modules[m].ntc2_dt = (int16_t)(fx.modules[m].ntc1_dt + fx_rand(-40, 40));
+      fx.modules[m].swelling_pct = (uint8_t)fx_rand(0, 5);
+      fx.modules[m].max_dt_dt_ddpm = (int16_t)fx_rand(0, 8);
+    }
+    if (fx_rand(0, 9) == 0)
+      fx.modules[fx_rand(0, 7)].ntc1_dt = (int16_t)fx_rand(700, 1800);
+    fx.temp_ambient_dt = (int16_t)fx_rand(200, 400);
+    fx.coolant_inlet_dt = (int16_t)fx_rand(200, 300);
+    fx.coolant_outlet_dt = (int16_t)fx_rand(200, 350);
+    fx.gas_ratio_1_cp = (uint16_t)fx_rand(20, 100);
+    fx.gas_ratio_2_cp = (uint16_t)fx_rand(20, 100);
+    fx.pressure_delta_1_chpa = (int16_t)fx_rand(-50, 600);
+    fx.pressure_delta_2_chpa = (int16_t)fx_rand(-50, 600);
+    fx.short_circuit = fx_rand(0, 19) == 0;
+
+    if (!fx_matches_float(&th, &fx))
+      mismatches++;
+  }
+  printf("    Random packs: %d mismatches in 2000\n", mismatches);
+  TEST_ASSERT(mismatches == 0, "2000 random packs: paths agree exactly");
+
+  /* Incremental fixed-point compute matches a full one */
+  anomaly_eval_fx_cache_t cache;
+  anomaly_eval_fx_cache_init(&cache);
+  sensor_snapshot_fx_t inc = make_normal_fx();
+  anomaly_eval_fx_compute_incremental(&inc, &tfx, &cache, 0);
+  inc.modules[6].ntc2_dt = 612;
+  anomaly_eval_fx_compute_incremental(&inc, &tfx, &cache, 1u << 6);
+  sensor_snapshot_fx_t full = inc;
+  anomaly_eval_fx_compute(&full, &tfx);
+  TEST_ASSERT(inc.hotspot_module == 7 && inc.hotspot_temp_dt == 612 &&
+                  inc.temp_spread_dt == full.temp_spread_dt &&
+                  inc.t_core_est_mc == full.t_core_est_mc,
+              "Incremental fixed-point compute tracks one dirty module");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 25: Voltage plane fused scan
+ * ----------------------------------------------------------------------- */
+static void test_voltage_plane(void) {
+  printf("\n--- Test 25: Voltage Plane Fused Scan ---\n");
+
+  voltage_plane_t p;
+  voltage_plane_stats_t st;
+  const int32_t dev_x13 = 15 * GROUPS_PER_MODULE;
+
+  int bad = 0;
+  for (int n = 0; n < 500; n++) {
+    for (int m = 0; m < NUM_MODULES; m++)
+      for (int g = 0; g < GROUPS_PER_MODULE; g++)
+        VPLANE_MV(&p, m, g) = (int16_t)fx_rand(3170, 3230);
+    voltage_plane_scan(&p, &st);
+
+    /* Two-pass reference: stats, then every group against the mean */
+    for (int m = 0; m < NUM_MODULES; m++) {
+      int32_t sum = 0, lo = INT16_MAX, hi = INT16_MIN;
+      for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+        int32_t v = VPLANE_MV(&p, m, g);
+        sum += v;
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+      }
+      bool dev = false;
+      for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+        int32_t d = VPLANE_MV(&p, m, g) * GROUPS_PER_MODULE - sum;
+        if ((d < 0 ? -d : d) > dev_x13)
+          dev = true;
+      }
+      if (st.sum_mv[m] != sum || st.min_mv[m] != lo || st.max_mv[m] != hi ||
+          voltage_plane_dev_exceeds(st.sum_mv[m], st.min_mv[m], st.max_mv[m],
+                                    dev_x13) != dev)
+        bad++;
+    }
+  }
+  TEST_ASSERT(bad == 0, "Fused scan matches two-pass reference (500 packs)");
+
+  for (int m = 0; m < NUM_MODULES; m++)
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      VPLANE_MV(&p, m, g) = 3200;
+  VPLANE_MV(&p, 5, 12) = 3182; /* 18 mV low; 16.6 mV below the mean */
+  voltage_plane_scan(&p, &st);
+  module_mask_t dev_mask = 0;
+  for (int m = 0; m < NUM_MODULES; m++)
+    if (voltage_plane_dev_exceeds(st.sum_mv[m], st.min_mv[m], st.max_mv[m],
+                                  dev_x13))
+      dev_mask |= MODULE_BIT(m);
+  TEST_ASSERT(dev_mask == (1u << 5) && st.mean_mv[5] == 3199 &&
+                  st.mean_mv[0] == 3200,
+              "Single sagging group flags only its module");
+
+  /* Float path uses the same extremes argument */
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  sensor_snapshot_t s = make_normal_snapshot();
+  s.modules[1].group_voltages_v[0] = 3.22f;
+  compute_snapshot(&s);
+  anomaly_result_t r = anomaly_eval_run(&t, &s);
+  TEST_ASSERT((r.anomaly_modules_mask & 0x02) && (r.active_mask & CAT_ELECTRICAL),
+              "Float evaluator flags a +20 mV group from module extremes");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 26: Pack geometry and module masks
+ *
+ * Rebuild with -DPACK_PROFILE=PACK_PROFILE_BUS_16M (or _STORAGE_24M) to
+ * run the whole suite against the larger packs.
+ * ----------------------------------------------------------------------- */
+static void test_pack_geometry(void) {
+  printf("\n--- Test 26: Pack Geometry (%d modules) ---\n", NUM_MODULES);
+
+  int bits = 0;
+  for (int m = 0; m < 32; m++)
+    bits += (int)((MODULE_MASK_ALL >> m) & 1u);
+  TEST_ASSERT(bits == NUM_MODULES && sizeof(module_mask_t) * 8 >= NUM_MODULES,
+              "Module mask type holds one bit per module");
+
+  /* Anomaly in the last module survives the telemetry frame */
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  sensor_snapshot_t s = make_normal_snapshot();
+  s.modules[NUM_MODULES - 1].swelling_pct = 9.0f;
+  compute_snapshot(&s);
+  anomaly_result_t r = anomaly_eval_run(&t, &s);
+  TEST_ASSERT(r.anomaly_modules_mask == MODULE_BIT(NUM_MODULES - 1),
+              "Last module flagged in the result mask");
+
+  telemetry_pack_frame_t pkt;
+  uint8_t size = packet_encode_pack(&pkt, 0, &s, &r, STATE_WARNING);
+  uint32_t wire = 0;
+  for (int i = 0; i < PACK_MODULE_MASK_BYTES; i++)
+    wire |= (uint32_t)pkt.anomaly_modules[i] << (8 * i);
+  TEST_ASSERT(size == PACKET_PACK_SIZE && wire == r.anomaly_modules_mask &&
+                  packet_validate_pack(&pkt) == 0,
+              "Module mask encoded little-endian in the pack frame");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 27: Compact keyframe/delta telemetry
+ * ----------------------------------------------------------------------- */
+
+/* Encode one cycle; decode each frame unless it is the drop_frame-th.
+ * Returns the bytes put on the wire. */
+static int compact_cycle(packet_compact_enc_t *enc, packet_compact_dec_t *dec,
+                         uint32_t t_ms, const sensor_snapshot_t *s,
+                         const anomaly_result_t *r, int drop_frame) {
+  uint8_t frame[PACKET_COMPACT_MAX_SIZE];
+  uint8_t len;
+  int bytes = 0;
+  packet_compact_begin(enc, t_ms, s, r, STATE_NORMAL);
+  for (int i = 0; (len = packet_compact_next(enc, frame)) > 0; i++) {
+    bytes += len;
+    if (i != drop_frame && packet_compact_decode(dec, frame, len) != 0)
+      return -1;
+  }
+  return bytes;
+}
+
+/* Decoded stream reproduces the legacy frames byte for byte */
+static bool compact_matches_legacy(const packet_compact_dec_t *dec,
+                                   uint32_t t_ms, const sensor_snapshot_t *s,
+                                   const anomaly_result_t *r) {
+  telemetry_pack_frame_t a, b;
+  packet_encode_pack(&a, t_ms, s, r, STATE_NORMAL);
+  if (packet_compact_pack_frame(dec, &b) != 0 || memcmp(&a, &b, sizeof(a)))
+    return false;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    telemetry_module_frame_t ma, mb;
+    packet_encode_module(&ma, m, s);
+    if (packet_compact_module_frame(dec, m, &mb) != 0 ||
+        memcmp(&ma, &mb, sizeof(ma)))
+      return false;
+  }
+  return true;
+}
+
+static void test_compact_telemetry(void) {
+  printf("\n--- Test 27: Compact Keyframe/Delta Telemetry ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  packet_compact_enc_t enc;
+  packet_compact_dec_t dec;
+  packet_compact_init(&enc, 4);
+  packet_compact_dec_init(&dec);
+
+  const int legacy_bytes = PACKET_PACK_SIZE + NUM_MODULES * PACKET_MODULE_SIZE;
+  int key_bytes = 0, delta_bytes = 0, bad = 0;
+  for (int c = 0; c < 12; c++) {
+    /* Slow drift on one module, current wandering both ways */
+    sensor_snapshot_t s = make_normal_snapshot();
+    s.pack_current_a = 60.0f + (float)((c * 7) % 5) - 2.0f;
+    s.modules[3].ntc1_c += 0.1f * (float)c;
+    compute_snapshot(&s);
+    anomaly_result_t r = anomaly_eval_run(&t, &s);
+
+    uint32_t t_ms = 5000u * (uint32_t)c;
+    int n = compact_cycle(&enc, &dec, t_ms, &s, &r, -1);
+    if (n < 0 || !compact_matches_legacy(&dec, t_ms, &s, &r))
+      bad++;
+    if (c == 0)
+      key_bytes = n;
+    else if (c == 1)
+      delta_bytes = n;
+  }
+  TEST_ASSERT(bad == 0, "Decoded compact stream equals the legacy frames");
+  TEST_ASSERT(key_bytes < legacy_bytes && delta_bytes * 4 < legacy_bytes,
+              "Keyframe smaller than legacy, delta under a quarter of it");
+
+  /* A dropped frame invalidates the stream until the next keyframe */
+  packet_compact_init(&enc, 4);
+  packet_compact_dec_init(&dec);
+  sensor_snapshot_t s = make_normal_snapshot();
+  compute_snapshot(&s);
+  anomaly_result_t r = anomaly_eval_run(&t, &s);
+  compact_cycle(&enc, &dec, 0, &s, &r, -1);
+  s.pack_voltage_v -= 1.0f;
+  compact_cycle(&enc, &dec, 5000, &s, &r, 0); /* Lost */
+  compact_cycle(&enc, &dec, 10000, &s, &r, -1);
+  telemetry_pack_frame_t pf;
+  TEST_ASSERT(dec.gaps == 1 && packet_compact_pack_frame(&dec, &pf) != 0,
+              "Sequence gap detected, deltas ignored");
+  packet_compact_request_key(&enc);
+  compact_cycle(&enc, &dec, 15000, &s, &r, -1);
+  TEST_ASSERT(compact_matches_legacy(&dec, 15000, &s, &r),
+              "Requested keyframe resynchronises the receiver");
+
+  /* Negotiation frame on the input link */
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+  input_tel_config_frame_t cf = {INPUT_SYNC_BYTE,
+                                 INPUT_TEL_CONFIG_FRAME_SIZE,
+                                 INPUT_TYPE_TEL_CONFIG,
+                                 INPUT_TEL_MODE_COMPACT,
+                                 INPUT_TEL_FLAG_KEY,
+                                 20,
+                                 10,
+                                 0};
+  cf.checksum = xor_bytes((const uint8_t *)&cf, sizeof(cf) - 1);
+  int res = feed_bytes(&rx, &cf, sizeof(cf));
+  TEST_ASSERT(res == 1 && rx.frame_type == INPUT_TYPE_TEL_CONFIG &&
+                  rx.last_tel_config.key_interval == 20 &&
+                  rx.modules_received == 0 && !rx.pack_received,
+              "Telemetry config frame parsed without touching the snapshot");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 28: Group voltage frames for flagged modules
+ * ----------------------------------------------------------------------- */
+static void test_group_voltage_stream(void) {
+  printf("\n--- Test 28: Group Voltage Streaming ---\n");
+
+  sensor_snapshot_t s = make_normal_snapshot();
+  for (int g = 0; g < GROUPS_PER_MODULE; g++)
+    s.modules[2].group_voltages_v[g] = 3.150f + 0.004f * (float)g;
+  s.modules[2].group_voltages_v[5] = 3.420f; /* Far above the base */
+
+  telemetry_group_frame_t gf;
+  uint8_t size = packet_encode_groups(&gf, 2, &s);
+  int bad = 0;
+  for (int g = 0; g < GROUPS_PER_MODULE; g++) {
+    if (g == 5)
+      continue;
+    float v = (float)(gf.v_base_mv + gf.v_delta[g]) / 1000.0f;
+    if (fabsf(v - s.modules[2].group_voltages_v[g]) > 0.0005f)
+      bad++;
+  }
+  TEST_ASSERT(size == PACKET_GROUPS_SIZE && size == sizeof(gf) &&
+                  gf.checksum == packet_checksum((const uint8_t *)&gf,
+                                                 PACKET_GROUPS_SIZE - 1),
+              "Group frame sized and checksummed");
+  TEST_ASSERT(bad == 0 && gf.v_delta[5] == 127 &&
+                  (gf.flags & PACKET_GROUPS_FLAG_CLIPPED),
+              "Groups round-trip to 1 mV; outlier saturates and is flagged");
+
+  packet_group_stream_t gs;
+  telemetry_group_frame_t out[PACKET_GROUPS_MAX_PER_CYCLE];
+  packet_groups_init(&gs, 1000);
+  s = make_normal_snapshot();
+
+  TEST_ASSERT(packet_groups_poll(&gs, 0, &s, 0, out) == 0,
+              "Nothing streamed without an anomaly");
+  TEST_ASSERT(packet_groups_poll(&gs, 100, &s, MODULE_BIT(1), out) == 1 &&
+                  out[0].module_index == 1,
+              "Newly flagged module sent at once");
+  TEST_ASSERT(packet_groups_poll(&gs, 5000, &s, MODULE_BIT(1), out) == 0,
+              "Unchanged groups not resent");
+  s.modules[1].group_voltages_v[0] = 3.18f;
+  TEST_ASSERT(packet_groups_poll(&gs, 5500, &s, MODULE_BIT(1), out) == 1,
+              "Changed groups resent");
+  s.modules[1].group_voltages_v[0] = 3.17f;
+  TEST_ASSERT(packet_groups_poll(&gs, 6000, &s, MODULE_BIT(1), out) == 0,
+              "Changes inside the interval wait");
+
+  module_mask_t three = MODULE_BIT(0) | MODULE_BIT(3) | MODULE_BIT(4);
+  uint8_t a = packet_groups_poll(&gs, 6100, &s, three, out);
+  uint8_t b = packet_groups_poll(&gs, 6200, &s, three, out);
+  TEST_ASSERT(a == PACKET_GROUPS_MAX_PER_CYCLE && b == 3 - a &&
+                  out[0].module_index == 0,
+              "Per-cycle cap defers, never drops, an onset");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 29: CRC-16 v2 framing, cycle sequence and superframes
+ * ----------------------------------------------------------------------- */
+
+/* Wrap v1 frames as one v2 frame: a single frame if n == 1 and type is
+ * not INPUT_TYPE_SUPER, else a superframe of records */
+static uint16_t make_v2(uint8_t *out, uint8_t type, uint8_t seq,
+                        const uint8_t *const *frames, int n) {
+  uint16_t len = 5;
+  for (int i = 0; i < n; i++) {
+    uint8_t plen = (uint8_t)(frames[i][1] - 4);
+    if (type == INPUT_TYPE_SUPER) {
+      out[len++] = frames[i][2];
+      out[len++] = plen;
+    }
+    memcpy(&out[len], &frames[i][3], plen);
+    len = (uint16_t)(len + plen);
+  }
+  len = (uint16_t)(len + 2);
+  out[0] = INPUT_SYNC_V2;
+  out[1] = (uint8_t)len;
+  out[2] = (uint8_t)(len >> 8);
+  out[3] = type;
+  out[4] = seq;
+  uint16_t crc = crc16_block(CRC16_INIT, out, (uint16_t)(len - 2));
+  out[len - 2] = (uint8_t)crc;
+  out[len - 1] = (uint8_t)(crc >> 8);
+  return len;
+}
+
+static void test_v2_framing(void) {
+  printf("\n--- Test 29: CRC-16 v2 Framing and Superframes ---\n");
+
+  TEST_ASSERT(crc16_block(CRC16_INIT, (const uint8_t *)"123456789", 9) ==
+                  CRC16_CHECK,
+              "CRC-16/CCITT-FALSE check value");
+
+  input_pack_frame_t pf;
+  input_module_frame_t mods[NUM_MODULES];
+  const uint8_t *frames[NUM_MODULES];
+  make_input_pack(&pf, 777);
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    make_input_module(&mods[m], m);
+    frames[m] = (const uint8_t *)&mods[m];
+  }
+
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+  static uint8_t buf[INPUT_V2_MAX_FRAME_SIZE];
+
+  /* Pack as its own v2 frame, then all modules in one superframe */
+  const uint8_t *pp = (const uint8_t *)&pf;
+  uint16_t n = make_v2(buf, INPUT_TYPE_PACK, 5, &pp, 1);
+  int r = feed_bytes(&rx, buf, n);
+  TEST_ASSERT(r == 1 && (rx.frame_contents & INPUT_GOT_PACK) &&
+                  memcmp(&rx.last_pack, &pf, sizeof(pf)) == 0,
+              "Single v2 pack frame decodes to the v1 slot bytes");
+  n = make_v2(buf, INPUT_TYPE_SUPER, 5, frames, NUM_MODULES);
+  r = feed_bytes(&rx, buf, n);
+  TEST_ASSERT(r == 2 && rx.frames_ok == 2 &&
+                  memcmp(&rx.last_modules[NUM_MODULES - 1],
+                         &mods[NUM_MODULES - 1], sizeof(mods[0])) == 0,
+              "Module superframe completes the snapshot in one frame");
+
+  /* Half a cycle, then a frame from the next cycle: never mixed */
+  input_rx_reset_cycle(&rx);
+  n = make_v2(buf, INPUT_TYPE_PACK, 6, &pp, 1);
+  feed_bytes(&rx, buf, n);
+  n = make_v2(buf, INPUT_TYPE_SUPER, 6, frames, NUM_MODULES / 2);
+  feed_bytes(&rx, buf, n);
+  n = make_v2(buf, INPUT_TYPE_SUPER, 7, frames + NUM_MODULES / 2,
+              NUM_MODULES - NUM_MODULES / 2);
+  r = feed_bytes(&rx, buf, n);
+  TEST_ASSERT(r == 1 && !rx.pack_received && rx.cycles_abandoned == 1 &&
+                  rx.cycle_seq == 7,
+              "New SEQ drops the old cycle's frames");
+
+  /* Two bytes swapped: XOR still matches, the CRC does not */
+  n = make_v2(buf, INPUT_TYPE_PACK, 8, &pp, 1);
+  uint8_t sw = buf[5];
+  buf[5] = buf[6];
+  buf[6] = sw;
+  uint32_t bad = rx.frames_bad;
+  r = feed_bytes(&rx, buf, n);
+  input_pack_frame_t swapped = pf;
+  uint8_t *sp = (uint8_t *)&swapped;
+  sw = sp[3];
+  sp[3] = sp[4];
+  sp[4] = sw;
+  TEST_ASSERT(buf[5] != buf[6] &&
+                  xor_bytes(sp, INPUT_PACK_FRAME_SIZE - 1) == pf.checksum &&
+                  r == 0 && rx.frames_bad == bad + 1,
+              "Byte swap caught by CRC-16 (missed by XOR)");
+
+  /* A corrupted superframe is dropped whole and the next frame parses */
+  input_rx_init(&rx);
+  n = make_v2(buf, INPUT_TYPE_SUPER, 9, frames, NUM_MODULES);
+  buf[n / 2] ^= 0x04;
+  r = feed_bytes(&rx, buf, n);
+  TEST_ASSERT(r == 0 && rx.modules_received != MODULE_MASK_ALL,
+              "Corrupted superframe rejected");
+  n = make_v2(buf, INPUT_TYPE_PACK, 9, &pp, 1);
+  r = feed_bytes(&rx, buf, n);
+  feed_bytes(&rx, &pf, sizeof(pf)); /* v1 still accepted alongside */
+  TEST_ASSERT(r == 1 && rx.frames_ok == 2, "Parser resyncs after it");
+
+  /* Output side: a legacy cycle batched into superframes (one for 8
+   * modules, split with the same SEQ on larger packs) */
+  sensor_snapshot_t s = make_normal_snapshot();
+  anomaly_thresholds_t th;
+  anomaly_eval_init(&th);
+  anomaly_eval_compute(&s, &th);
+  anomaly_result_t ar = anomaly_eval_run(&th, &s);
+  telemetry_pack_frame_t tp;
+  telemetry_module_frame_t tm;
+  packet_encode_pack(&tp, 1000, &s, &ar, STATE_NORMAL);
+
+  packet_super_t sf;
+  int records = 0, frames_out = 0, ok = 1;
+  packet_super_begin(&sf, 42);
+  ok &= packet_super_add(&sf, (const uint8_t *)&tp);
+  records++;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    packet_encode_module(&tm, m, &s);
+    if (!packet_super_add(&sf, (const uint8_t *)&tm)) {
+      uint16_t len = packet_super_finish(&sf);
+      ok &= packet_super_validate(sf.buf, len) > 0 && sf.buf[4] == 42;
+      frames_out++;
+      packet_super_begin(&sf, sf.seq);
+      ok &= packet_super_add(&sf, (const uint8_t *)&tm);
+    }
+    records++;
+  }
+  uint16_t len = packet_super_finish(&sf);
+  frames_out++;
+  int last_count = packet_super_validate(sf.buf, len);
+  ok &= memcmp(&sf.buf[len - 2 - (PACKET_MODULE_SIZE - 4)], &tm.module_index,
+               PACKET_MODULE_SIZE - 4) == 0;
+  TEST_ASSERT(ok && last_count > 0 && last_count <= records &&
+                  len <= PACKET_V2_MAX_SIZE &&
+                  (NUM_MODULES > 8 || frames_out == 1),
+              "Output superframe seals with a valid CRC");
+  sf.buf[7] ^= 0x01;
+  TEST_ASSERT(packet_super_validate(sf.buf, len) == -1,
+              "Output superframe corruption detected");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 30: Partial snapshots and per-module staleness
+ * ----------------------------------------------------------------------- */
+
+/* Feed a pack frame and every module frame except those in skip */
+static int feed_cycle(input_rx_state_t *rx, uint32_t now_ms,
+                      module_mask_t skip) {
+  input_pack_frame_t pf;
+  input_module_frame_t mf;
+  input_rx_set_clock(rx, now_ms);
+  make_input_pack(&pf, 100);
+  int r = feed_bytes(rx, &pf, sizeof(pf));
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    if (skip & MODULE_BIT(m))
+      continue;
+    make_input_module(&mf, m);
+    r = feed_bytes(rx, &mf, sizeof(mf));
+  }
+  return r;
+}
+
+static void test_partial_snapshot(void) {
+  printf("\n--- Test 30: Partial Snapshots and Staleness ---\n");
+
+  const module_mask_t lossy = MODULE_BIT(NUM_MODULES - 1);
+  input_rx_state_t rx;
+  module_mask_t stale = 0;
+  input_rx_init(&rx);
+
+  TEST_ASSERT(feed_cycle(&rx, 0, lossy) == 1 &&
+                  !input_rx_partial_ready(&rx, 1000, INPUT_PARTIAL_WAIT_MS,
+                                          INPUT_STALE_MAX_AGE_MS, &stale),
+              "Never-received module is not reused");
+
+  input_rx_init(&rx);
+  feed_cycle(&rx, 0, 0);
+  input_rx_reset_cycle(&rx); /* Consumed: every module has last-good data */
+
+  /* Next cycle loses the last module's frame */
+  feed_cycle(&rx, 1000, lossy);
+  TEST_ASSERT(!input_rx_partial_ready(&rx, 1000 + INPUT_PARTIAL_WAIT_MS - 1,
+                                      INPUT_PARTIAL_WAIT_MS,
+                                      INPUT_STALE_MAX_AGE_MS, &stale),
+              "Partial cycle waits for its stragglers");
+  TEST_ASSERT(input_rx_partial_ready(&rx, 1000 + INPUT_PARTIAL_WAIT_MS,
+                                     INPUT_PARTIAL_WAIT_MS,
+                                     INPUT_STALE_MAX_AGE_MS, &stale) &&
+                  stale == lossy,
+              "After the wait, the missing module is reused and marked stale");
+  input_rx_reset_cycle(&rx);
+  TEST_ASSERT(rx.module_good_ms[0] == 1000 &&
+                  rx.module_good_ms[NUM_MODULES - 1] == 0,
+              "Reused module keeps the age of its last good frame");
+
+  /* The same module still missing past the age limit */
+  feed_cycle(&rx, INPUT_STALE_MAX_AGE_MS, lossy);
+  TEST_ASSERT(!input_rx_partial_ready(&rx, INPUT_STALE_MAX_AGE_MS + 300,
+                                      INPUT_PARTIAL_WAIT_MS,
+                                      INPUT_STALE_MAX_AGE_MS, &stale),
+              "Data older than the age limit is not reused");
+
+  /* No pack frame, no partial snapshot */
+  input_rx_reset_cycle(&rx);
+  input_module_frame_t mf;
+  make_input_module(&mf, 0);
+  input_rx_set_clock(&rx, 2000);
+  feed_bytes(&rx, &mf, sizeof(mf));
+  TEST_ASSERT(!input_rx_partial_ready(&rx, 2400, INPUT_PARTIAL_WAIT_MS,
+                                      INPUT_STALE_MAX_AGE_MS, &stale),
+              "Pack frame is never reused");
+
+  /* Staleness reaches the result and the pack frame on both paths */
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  sensor_snapshot_t s = make_normal_snapshot();
+  s.stale_modules = lossy;
+  anomaly_eval_compute(&s, &t);
+  anomaly_result_t r = anomaly_eval_run(&t, &s);
+  telemetry_pack_frame_t pkt;
+  packet_encode_pack(&pkt, 0, &s, &r, STATE_NORMAL);
+  anomaly_thresholds_fx_t tfx;
+  anomaly_thresholds_to_fx(&tfx, &t);
+  sensor_snapshot_fx_t fx;
+  anomaly_snapshot_to_fx(&fx, &s);
+  anomaly_eval_fx_compute(&fx, &tfx);
+  anomaly_result_t rfx = anomaly_eval_fx_run(&tfx, &fx);
+  TEST_ASSERT(r.stale_modules_mask == lossy &&
+                  rfx.stale_modules_mask == lossy &&
+                  (pkt.flags & PACKET_FLAG_STALE),
+              "Stale modules flagged in the result and telemetry");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 31: Sample history and windowed least-squares rates
+ * ----------------------------------------------------------------------- */
+
+static history_t g_test_hist; /* ~6 KB: keep it off the stack */
+
+static void hist_push_one(history_t *h, uint32_t t_ms, uint8_t ch, int32_t v) {
+  int32_t row[HIST_NUM_CHANNELS] = {0};
+  row[ch] = v;
+  history_push(h, t_ms, row);
+}
+
+static void test_history_rates(void) {
+  printf("\n--- Test 31: History Ring and Least-Squares Rates ---\n");
+
+  history_t *h = &g_test_hist;
+  const uint8_t ch = HIST_CH_NTC(2, 0);
+  history_init(h);
+  int w = history_add_window(h, HIST_CH_NTC(0, 0), 2 * NUM_MODULES, 3000);
+  int wr = history_add_window(h, HIST_CH_R_INT, 1, 2000);
+  TEST_ASSERT(w == 0 && wr == 1 &&
+                  history_add_window(h, HIST_CH_R_INT, 7, 1000) == -1,
+              "Windows registered; out-of-range channels rejected");
+
+  /* 1 °C/s ramp sampled at 500 ms, then at 100 ms (scheduler in alert),
+   * with jitter: the slope uses the real sample times */
+  uint32_t t = 0;
+  float worst = 0.0f;
+  for (int i = 0; i < 80; i++) {
+    t += (i < 40 ? 500u : 100u) + (uint32_t)(i % 3) * 7u;
+    hist_push_one(h, t, ch, (int32_t)(28000 + t)); /* milli-°C */
+    if (i > 0) {
+      float err = fabsf(history_slope(h, w, ch) - 1000.0f);
+      if (err > worst)
+        worst = err;
+    }
+  }
+  TEST_ASSERT(worst < 0.5f, "Ramp slope exact across a rate switch");
+  TEST_ASSERT(history_window_count(h, w) <= 31 &&
+                  history_window_count(h, w) >= 29,
+              "Window holds the last 3 s of samples");
+
+  /* Slope change: the estimate follows within one window */
+  uint32_t t_change = t;
+  int32_t v = (int32_t)(28000 + t);
+  float before = 0.0f, after = 0.0f;
+  for (int i = 0; i < 40; i++) {
+    t += 100;
+    v -= 50; /* −0.5 °C/s */
+    hist_push_one(h, t, ch, v);
+    if (t - t_change == 1500)
+      before = history_slope(h, w, ch);
+    after = history_slope(h, w, ch);
+  }
+  TEST_ASSERT(before < 500.0f && fabsf(after + 500.0f) < 0.5f,
+              "New slope reached once the old samples age out");
+
+  /* Noise: ±0.1 °C on a flat signal stays far below the 0.5 °C/min
+   * warning, where a difference of two 500 ms samples reaches 24 °C/min */
+  history_init(h);
+  w = history_add_window(h, HIST_CH_NTC(0, 0), 2 * NUM_MODULES, 3000);
+  float worst_min = 0.0f;
+  t = 0;
+  for (int i = 0; i < 40; i++) {
+    t += 100;
+    hist_push_one(h, t, ch, 30000 + ((i * 7) % 3 - 1) * 100);
+    float r = fabsf(history_slope(h, w, ch)) * 60.0f / 1000.0f;
+    if (i >= 30 && r > worst_min)
+      worst_min = r;
+  }
+  TEST_ASSERT(worst_min < 0.5f, "Sensor noise does not trip the rate warning");
+
+  /* Hours of samples: rebasing keeps the sums exact, ring stays bounded */
+  history_init(h);
+  wr = history_add_window(h, HIST_CH_R_INT, 1, 60000);
+  t = 0;
+  for (int i = 0; i < 20000; i++) {
+    t += 500;
+    hist_push_one(h, t, HIST_CH_R_INT, 440 + (int32_t)(t / 1000u)); /* µΩ */
+  }
+  TEST_ASSERT(fabsf(history_slope(h, wr, HIST_CH_R_INT) - 1.0f) < 1e-3f &&
+                  history_window_count(h, wr) == HISTORY_DEPTH - 1,
+              "Long run: slope stays exact, window capped by the ring");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 32: Multi-pack batch evaluation and the host thread pool
+ * ----------------------------------------------------------------------- */
+
+#define FLEET_TEST_PACKS 1000
+
+static sensor_snapshot_t g_fleet_snaps[FLEET_TEST_PACKS];
+static anomaly_result_t g_fleet_results[FLEET_TEST_PACKS];
+static correlation_engine_t g_fleet_engines[FLEET_TEST_PACKS];
+static correlation_engine_t g_fleet_ref[FLEET_TEST_PACKS];
+static system_state_t g_fleet_states[FLEET_TEST_PACKS];
+
+/* Pack i, pass k: a mix of healthy, hot, gassing and shorted packs */
+static void fleet_make_snapshot(sensor_snapshot_t *s, uint32_t i, int k) {
+  *s = make_normal_snapshot();
+  switch ((i * 7u + (uint32_t)k) % 5u) {
+  case 1:
+    s->modules[i % NUM_MODULES].ntc1_c = 62.0f;
+    break;
+  case 2:
+    s->modules[i % NUM_MODULES].ntc1_c = 62.0f;
+    s->gas_ratio_1 = 0.5f;
+    break;
+  case 3:
+    s->pack_current_a = 400.0f;
+    s->short_circuit = true;
+    break;
+  default:
+    break;
+  }
+}
+
+static void test_fleet_batch(void) {
+  printf("\n--- Test 32: Multi-Pack Batch Evaluation ---\n");
+
+  anomaly_thresholds_t th;
+  anomaly_eval_init(&th);
+  for (uint32_t i = 0; i < FLEET_TEST_PACKS; i++) {
+    correlation_engine_init(&g_fleet_engines[i]);
+    correlation_engine_init(&g_fleet_ref[i]);
+  }
+
+  fleet_batch_t batch = {&th,
+                         g_fleet_snaps,
+                         g_fleet_results,
+                         g_fleet_engines,
+                         g_fleet_states,
+                         FLEET_TEST_PACKS};
+  fleet_pool_t pool;
+  bool pool_ok = fleet_pool_init(&pool, 4) == HAL_OK;
+  TEST_ASSERT(pool_ok && pool.num_workers == 3,
+              "Pool of 4 threads: 3 workers plus the caller");
+
+  /* Several passes: engine state carries over, packs change fault */
+  bool results_match = true, states_match = true;
+  for (int k = 0; k < 6; k++) {
+    for (uint32_t i = 0; i < FLEET_TEST_PACKS; i++)
+      fleet_make_snapshot(&g_fleet_snaps[i], i, k);
+    if (pool_ok)
+      fleet_pool_run(&pool, &batch);
+
+    for (uint32_t i = 0; i < FLEET_TEST_PACKS; i++) {
+      sensor_snapshot_t s;
+      fleet_make_snapshot(&s, i, k);
+      anomaly_eval_compute(&s, &th);
+      anomaly_result_t r = anomaly_eval_run(&th, &s);
+      system_state_t st = correlation_engine_update(&g_fleet_ref[i], &r);
+      if (r.active_mask != g_fleet_results[i].active_mask ||
+          r.is_short_circuit != g_fleet_results[i].is_short_circuit ||
+          r.hotspot_module != g_fleet_results[i].hotspot_module)
+        results_match = false;
+      if (st != g_fleet_states[i] ||
+          g_fleet_ref[i].critical_countdown !=
+              g_fleet_engines[i].critical_countdown)
+        states_match = false;
+    }
+  }
+  if (pool_ok)
+    fleet_pool_destroy(&pool);
+  TEST_ASSERT(results_match, "Pooled batch results equal per-pack calls");
+  TEST_ASSERT(states_match, "Per-pack engines evolve as if run alone");
+
+  /* A partial slice on the calling thread touches only its range */
+  g_fleet_states[9] = (system_state_t)0xFF;
+  fleet_make_snapshot(&g_fleet_snaps[3], 3, 6);
+  fleet_eval_range(&batch, 3, 1);
+  TEST_ASSERT(g_fleet_states[9] == (system_state_t)0xFF &&
+                  g_fleet_engines[3].total_evaluations == 7,
+              "fleet_eval_range updates only its slice");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 33: Non-blocking buzzer patterns and relay settling
+ * ----------------------------------------------------------------------- */
+
+/* Advance the simulated clock in 10 ms ticks, polling like main.c */
+static void act_run(uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t += 10) {
+    hal_timer_sim_advance(10);
+    hal_gpio_actuators_poll();
+  }
+}
+
+static void test_actuators(void) {
+  printf("\n--- Test 33: Non-Blocking Buzzer and Relay ---\n");
+
+  hal_gpio_init();
+  hal_gpio_buzzer_pulse(100);
+  TEST_ASSERT(hal_gpio_read(GPIO_PIN_BUZZER) == GPIO_HIGH &&
+                  hal_gpio_buzzer_pattern() == BUZZER_PULSE,
+              "Pulse returns at once with the buzzer on");
+  act_run(90);
+  bool on_at_90 = hal_gpio_read(GPIO_PIN_BUZZER) == GPIO_HIGH;
+  act_run(10);
+  TEST_ASSERT(on_at_90 && hal_gpio_read(GPIO_PIN_BUZZER) == GPIO_LOW &&
+                  hal_gpio_buzzer_pattern() == BUZZER_OFF,
+              "Pulse ends after its duration");
+
+  /* Alarm: 500/500 ms; replaying it every pass keeps the phase */
+  hal_gpio_buzzer_play(BUZZER_ALARM);
+  int edges = 0;
+  gpio_level_t last = hal_gpio_read(GPIO_PIN_BUZZER);
+  for (int i = 0; i < 500; i++) { /* 5 s, a med-loop pass per tick */
+    act_run(10);
+    hal_gpio_buzzer_play(BUZZER_ALARM);
+    if (hal_gpio_read(GPIO_PIN_BUZZER) != last) {
+      edges++;
+      last = hal_gpio_read(GPIO_PIN_BUZZER);
+    }
+  }
+  TEST_ASSERT(edges == 10, "Alarm toggles every 500 ms while replayed");
+  hal_gpio_buzzer_stop();
+  TEST_ASSERT(hal_gpio_read(GPIO_PIN_BUZZER) == GPIO_LOW &&
+                  hal_gpio_buzzer_pattern() == BUZZER_OFF,
+              "Stop silences the alarm");
+
+  hal_gpio_buzzer_play(BUZZER_CHIRP);
+  act_run(290);
+  TEST_ASSERT(hal_gpio_buzzer_pattern() == BUZZER_OFF,
+              "Chirp ends after three beeps");
+
+  /* Relay: boot connect, disconnect, debounced reconnect */
+  hal_gpio_set_safety_armed(false);
+  hal_gpio_relay_connect();
+  TEST_ASSERT(hal_gpio_relay_state() == RELAY_OPEN,
+              "Connect blocked while safety is not armed");
+
+  hal_gpio_set_safety_armed(true);
+  hal_gpio_relay_connect();
+  act_run(RELAY_SETTLE_MS);
+  TEST_ASSERT(hal_gpio_relay_state() == RELAY_CLOSED &&
+                  hal_gpio_read(GPIO_PIN_RELAY) == GPIO_LOW,
+              "Boot connect closes after the settle time");
+
+  hal_gpio_relay_disconnect();
+  TEST_ASSERT(hal_gpio_read(GPIO_PIN_RELAY) == GPIO_HIGH &&
+                  hal_gpio_relay_state() == RELAY_OPENING,
+              "Disconnect drives the coil at once");
+  /* Driver does not take: read-back fails and the pin is re-driven */
+  hal_gpio_write(GPIO_PIN_RELAY, GPIO_LOW);
+  act_run(RELAY_SETTLE_MS);
+  TEST_ASSERT(hal_gpio_relay_faults() == 1 &&
+                  hal_gpio_read(GPIO_PIN_RELAY) == GPIO_HIGH,
+              "Failed read-back counted and re-driven");
+  act_run(RELAY_SETTLE_MS);
+  TEST_ASSERT(hal_gpio_relay_state() == RELAY_OPEN, "Disconnect confirmed");
+
+  hal_gpio_relay_connect();
+  act_run(RELAY_MIN_OPEN_MS / 2);
+  bool held = hal_gpio_relay_state() == RELAY_OPEN;
+  hal_gpio_relay_disconnect(); /* State flickers back: cancels */
+  act_run(RELAY_MIN_OPEN_MS + 100);
+  TEST_ASSERT(held && hal_gpio_relay_state() == RELAY_OPEN,
+              "Reconnect held for the dwell and cancelled by a disconnect");
+
+  hal_gpio_relay_connect();
+  act_run(RELAY_SETTLE_MS);
+  TEST_ASSERT(hal_gpio_relay_state() == RELAY_CLOSED,
+              "Reconnect once the relay has been open long enough");
+  hal_gpio_init();
+}
+
+/* -----------------------------------------------------------------------
+ * Test 34: NTC lookup table against the B-parameter equation
+ * ----------------------------------------------------------------------- */
+
+/* The per-sample conversion the table replaces */
+static double ntc_reference_c(uint16_t adc) {
+  double r = NTC_R_SERIES * adc / (double)(NTC_ADC_MAX - adc);
+  double inv_t =
+      log(r / NTC_R_NOMINAL) / NTC_BETA + 1.0 / (NTC_T_NOMINAL + 273.15);
+  return 1.0 / inv_t - 273.15;
+}
+
+static void test_ntc_lut(void) {
+  printf("\n--- Test 34: NTC Lookup Table ---\n");
+
+  double err_core = 0.0, err_wide = 0.0;
+  bool monotonic = true;
+  int16_t prev = INT16_MAX;
+  for (uint16_t adc = 1; adc < NTC_ADC_MAX; adc++) {
+    int16_t dc = ntc_lut_temp_dc(adc);
+    double ref = ntc_reference_c(adc);
+    double err = fabs(dc / 10.0 - ref);
+    if (ref >= -20.0 && ref <= 100.0 && err > err_core)
+      err_core = err;
+    if (ref >= -40.0 && ref <= 150.0 && err > err_wide)
+      err_wide = err;
+    if (dc > prev)
+      monotonic = false;
+    prev = dc;
+  }
+  printf("  max error: %.3f °C (-20..100), %.3f °C (-40..150)\n", err_core,
+         err_wide);
+  TEST_ASSERT(err_core <= 0.15, "Within 0.15 °C of the equation, -20..100 °C");
+  TEST_ASSERT(err_wide <= 0.30, "Within 0.3 °C of the equation, -40..150 °C");
+  TEST_ASSERT(monotonic, "Temperature never rises with the ADC code");
+  TEST_ASSERT(ntc_lut_temp_dc(2048) == 250, "Mid-scale reads 25.0 °C");
+  TEST_ASSERT(ntc_lut_temp_dc(0) == NTC_TEMP_INVALID_DC &&
+                  ntc_lut_temp_dc(NTC_ADC_MAX) == NTC_TEMP_INVALID_DC,
+              "Either rail reads as an invalid sensor");
+
+  /* Calibration: a sensor reading 0.6 °C high at a 25.0 °C soak */
+  ntc_cal_t cal;
+  ntc_cal_init(&cal);
+  uint16_t samples[8];
+  for (int i = 0; i < 8; i++)
+    samples[i] = 1990 + (uint16_t)(i & 1); /* ~25.6 °C, 1 LSB of noise */
+  int16_t mean_dc = ntc_lut_temp_dc(1990);
+  bool ok = ntc_cal_capture(&cal, 3, samples, 8, 250);
+  TEST_ASSERT(ok && ntc_cal_apply(&cal, 3, mean_dc) >= 249 &&
+                  ntc_cal_apply(&cal, 3, mean_dc) <= 251 &&
+                  ntc_cal_apply(&cal, 2, mean_dc) == mean_dc,
+              "Captured offset trims that sensor onto the reference only");
+
+  samples[5] = 0;
+  TEST_ASSERT(!ntc_cal_capture(&cal, 4, samples, 8, 250) &&
+                  cal.offset_dc[4] == 0,
+              "Capture rejected when a sample is at a rail");
+  samples[5] = 1990;
+  TEST_ASSERT(!ntc_cal_capture(&cal, 4, samples, 8, 350),
+              "Capture rejected when the offset is beyond a trim");
+  TEST_ASSERT(ntc_cal_apply(&cal, 3, NTC_TEMP_INVALID_DC) ==
+                  NTC_TEMP_INVALID_DC,
+              "Invalid readings pass through calibration");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 35: Pipelined NTC MUX scan
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t order[NTC_SCAN_MAX_SLOTS];
+  uint8_t mux_at[NTC_SCAN_MAX_SLOTS]; /* MUX address seen at completion */
+  uint8_t count;
+} scan_log_t;
+
+static void scan_log_sample(void *ctx, uint8_t slot, const ntc_sample_t *smp) {
+  scan_log_t *log = ctx;
+  (void)smp;
+  if (log->count < NTC_SCAN_MAX_SLOTS) {
+    log->order[log->count] = slot;
+    log->mux_at[log->count] = (uint8_t)(hal_gpio_read(GPIO_PIN_MUX_S0) |
+                                        hal_gpio_read(GPIO_PIN_MUX_S1) << 1 |
+                                        hal_gpio_read(GPIO_PIN_MUX_S2) << 2);
+    log->count++;
+  }
+}
+
+/* Poll until `sweeps` sweeps are done; returns the polls taken */
+static uint32_t scan_until(ntc_scan_t *scan, uint32_t sweeps) {
+  uint32_t polls = 0;
+  while (scan->sweeps < sweeps && polls < 10000000u) {
+    ntc_scan_poll(scan);
+    polls++;
+  }
+  return polls;
+}
+
+static uint16_t scan_code(uint8_t slot) { return (uint16_t)(1400 + 40 * slot); }
+
+static void test_ntc_scan(void) {
+  printf("\n--- Test 35: Pipelined NTC MUX Scan ---\n");
+
+  hal_gpio_init();
+  hal_adc_init();
+  ntc_scan_slot_t slots[NTC_SCAN_PACK_SLOTS];
+  uint8_t n = ntc_scan_pack_layout(slots);
+  for (uint8_t i = 0; i < n; i++)
+    hal_adc_sim_set_mux(slots[i].adc_channel, slots[i].mux_addr, scan_code(i));
+
+  ntc_scan_t scan;
+  scan_log_t log = {0};
+  TEST_ASSERT(ntc_scan_init(&scan, slots, 0, 100) == HAL_ERROR &&
+                  ntc_scan_init(&scan, slots, n, 100) == HAL_OK,
+              "Scan rejects an empty slot list");
+  ntc_scan_set_callback(&scan, scan_log_sample, &log);
+
+  uint32_t t0 = hal_timer_millis();
+  uint32_t polls = scan_until(&scan, 1);
+  bool in_order = log.count == n;
+  bool pipelined = true, values = true;
+  for (uint8_t i = 0; i < log.count; i++) {
+    in_order = in_order && log.order[i] == i;
+    /* The next channel was already selected while this one converted */
+    pipelined = pipelined && log.mux_at[i] == slots[(i + 1) % n].mux_addr;
+    values = values &&
+             scan.latest[i].temp_dc == ntc_lut_temp_dc(scan_code(i)) &&
+             scan.latest[i].t_ms == t0;
+  }
+  printf("  %u slots in %u polls\n", (unsigned)n, (unsigned)polls);
+  TEST_ASSERT(in_order && polls > n,
+              "A sweep completes in order over many polls");
+  TEST_ASSERT(pipelined, "MUX moves on before each conversion completes");
+  TEST_ASSERT(values, "Each slot converted and stamped with its sample time");
+
+  for (int i = 0; i < 20000; i++)
+    ntc_scan_poll(&scan);
+  TEST_ASSERT(scan.sweeps == 1, "No new sweep before the period");
+
+  hal_adc_sim_set_mux(slots[7].adc_channel, slots[7].mux_addr, 0); /* Open */
+  hal_adc_sim_set_mux(slots[n - 1].adc_channel, slots[n - 1].mux_addr, 2048);
+  hal_timer_sim_advance(100);
+  scan_until(&scan, 2);
+  sensor_snapshot_t snap = make_normal_snapshot();
+  float before = snap.modules[3].ntc2_c;
+  uint32_t invalid = ntc_scan_to_snapshot(&scan, &snap);
+  TEST_ASSERT(scan.sweeps == 2 && scan.latest[n - 1].t_ms == t0 + 100 &&
+                  fabsf(snap.modules[(n - 1) / 2].ntc2_c - 25.0f) < 0.05f,
+              "Next sweep after the period delivers new readings");
+  TEST_ASSERT(invalid == 1u << 3 && snap.modules[3].ntc2_c == before &&
+                  fabsf(snap.modules[3].ntc1_c -
+                        ntc_lut_temp_dc(scan_code(6)) * 0.1f) < 0.01f,
+              "Open sensor flagged and left out of the snapshot");
+
+  /* A poll delayed between its two cycle reads: it reads the clock
+   * inside the sample window, but by the time it asks the ADC the
+   * conversion is done. Stand in for the stale first read by moving
+   * the conversion start up to now. */
+  hal_timer_sim_advance(100);
+  for (int i = 0; i < 1000000 && !scan.converting; i++)
+    ntc_scan_poll(&scan);
+  uint8_t first = scan.conv;
+  log.count = 0;
+  uint32_t start = scan.conv_cyc;
+  while (hal_timer_cycles() - start <
+         4u * ADC_CONVERT_US * HAL_TIMER_CYCLES_PER_US)
+    ;
+  scan.conv_cyc = hal_timer_cycles();
+  ntc_scan_poll(&scan);
+  bool held = log.count == 0 && scan.sel == first;
+  start = hal_timer_cycles();
+  while (hal_timer_cycles() - start <
+         2u * ADC_SAMPLE_US * HAL_TIMER_CYCLES_PER_US)
+    ;
+  ntc_scan_poll(&scan);
+  TEST_ASSERT(held && log.count == 1 && log.order[0] == first &&
+                  log.mux_at[0] == slots[(first + 1) % n].mux_addr,
+              "A late poll moves the MUX on before delivering the result");
+  hal_gpio_init();
+}
+
+/* -----------------------------------------------------------------------
+ * Test 36: Flash black-box recorder
+ * ----------------------------------------------------------------------- */
+
+/* One med-loop pass, then 100 ms of writer polls */
+static void bbx_pass(blackbox_t *bb, const sensor_snapshot_t *snap,
+                     system_state_t state) {
+  anomaly_result_t a;
+  memset(&a, 0, sizeof(a));
+  a.risk_factor = (float)state * 0.25f;
+  blackbox_note_state(bb, state);
+  blackbox_record(bb, hal_timer_millis(), snap, &a, state);
+  for (int i = 0; i < 10; i++) {
+    hal_timer_sim_advance(10);
+    blackbox_poll(bb);
+  }
+}
+
+static uint8_t g_bbx_image[HAL_FLASH_LOG_SECTORS * HAL_FLASH_SECTOR_SIZE];
+
+/* Rebuild the log from a dump stream; false on a malformed frame */
+static bool bbx_dump(blackbox_t *bb, uint8_t newest, uint32_t *bytes) {
+  uint8_t frame[BLACKBOX_DUMP_MAX_FRAME];
+  uint16_t chunk = 0;
+  uint32_t got = 0;
+  bool ok = true;
+  memset(g_bbx_image, 0xFF, sizeof(g_bbx_image));
+  blackbox_dump_begin(bb, newest);
+  while (bb->dumping && ok) {
+    uint8_t len = blackbox_dump_next(bb, frame);
+    if (len == 0) {
+      hal_timer_sim_advance(10);
+      continue;
+    }
+    uint32_t off = frame[6] | frame[7] << 8 | (uint32_t)frame[8] << 16 |
+                   (uint32_t)frame[9] << 24;
+    ok = frame[0] == PACKET_SYNC_BYTE && frame[1] == len &&
+         frame[2] == PACKET_TYPE_BLACKBOX &&
+         (frame[4] | frame[5] << 8) == chunk++ &&
+         packet_checksum(frame, len - 1) == frame[len - 1];
+    if (frame[3] & BLACKBOX_DUMP_END) {
+      ok = ok && len == BLACKBOX_DUMP_HEADER + 1 && off == got;
+    } else {
+      uint8_t n = len - BLACKBOX_DUMP_HEADER - 1;
+      ok = ok && n <= BLACKBOX_DUMP_CHUNK && off + n <= sizeof(g_bbx_image);
+      if (ok)
+        memcpy(g_bbx_image + off, frame + BLACKBOX_DUMP_HEADER, n);
+      got += n;
+    }
+  }
+  *bytes = got;
+  return ok;
+}
+
+/* Records in the rebuilt log, sectors in sequence order; returns the
+ * count with a valid CRC, and the header of the first one */
+static int bbx_scan(blackbox_rec_hdr_t *first, int *triggers,
+                    bool *consecutive) {
+  int n = 0;
+  uint16_t prev_seq = 0;
+  uint32_t want = UINT32_MAX;
+  *triggers = 0;
+  *consecutive = true;
+  for (int s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+    blackbox_sector_hdr_t h;
+    memcpy(&h, g_bbx_image + s * HAL_FLASH_SECTOR_SIZE, sizeof(h));
+    if (h.magic == BLACKBOX_SECTOR_MAGIC && h.seq < want)
+      want = h.seq;
+  }
+  for (uint32_t found = 1; found; want++) {
+    found = 0;
+    for (int s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+      const uint8_t *sec = g_bbx_image + s * HAL_FLASH_SECTOR_SIZE;
+      blackbox_sector_hdr_t h;
+      memcpy(&h, sec, sizeof(h));
+      if (h.magic != BLACKBOX_SECTOR_MAGIC || h.seq != want)
+        continue;
+      found = 1;
+      for (uint16_t off = sizeof(h);
+           off + BLACKBOX_REC_SIZE <= HAL_FLASH_SECTOR_SIZE &&
+           sec[off] == BLACKBOX_REC_MAGIC;
+           off += BLACKBOX_REC_SIZE) {
+        const uint8_t *r = sec + off;
+        uint16_t crc = crc16_block(CRC16_INIT, r, BLACKBOX_REC_SIZE - 2);
+        if ((r[BLACKBOX_REC_SIZE - 2] | r[BLACKBOX_REC_SIZE - 1] << 8) != crc)
+          continue;
+        blackbox_rec_hdr_t rh;
+        memcpy(&rh, r, sizeof(rh));
+        if (n == 0)
+          *first = rh;
+        else if (rh.seq != (uint16_t)(prev_seq + 1))
+          *consecutive = false;
+        prev_seq = rh.seq;
+        if (rh.flags & BLACKBOX_REC_TRIGGER)
+          (*triggers)++;
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+static void test_blackbox(void) {
+  printf("\n--- Test 36: Flash Black-Box Recorder ---\n");
+
+  hal_flash_sim_reset();
+  blackbox_t bb;
+  blackbox_init(&bb);
+  TEST_ASSERT(!bb.have_log && !bb.capturing, "Blank flash: empty log");
+
+  sensor_snapshot_t snap = make_normal_snapshot();
+  snap.pack_voltage_v = 379.96f;
+  snap.modules[2].ntc1_c = 31.24f;
+  for (int i = 0; i < 30; i++)
+    bbx_pass(&bb, &snap, STATE_NORMAL);
+  uint32_t erases = 0;
+  for (uint8_t s = 0; s < HAL_FLASH_LOG_SECTORS; s++)
+    erases += hal_flash_sim_erase_count(s);
+  TEST_ASSERT(bb.count == BLACKBOX_RING_RECORDS && erases == 0,
+              "Ring overwrites in RAM until a trigger");
+
+  /* Event: rise to CRITICAL, escalation inside it only extends it */
+  bbx_pass(&bb, &snap, STATE_WARNING);
+  bbx_pass(&bb, &snap, STATE_CRITICAL);
+  bool captured = bb.capturing && bb.events == 1;
+  for (int i = 0; i < 5; i++)
+    bbx_pass(&bb, &snap, STATE_CRITICAL);
+  bbx_pass(&bb, &snap, STATE_EMERGENCY);
+  for (int i = 0; i < 40 && bb.capturing; i++)
+    bbx_pass(&bb, &snap, STATE_EMERGENCY);
+  printf("  %u B records, %u pre-trigger, event used %u sectors\n",
+         (unsigned)BLACKBOX_REC_SIZE, (unsigned)BLACKBOX_PRE_RECORDS,
+         (unsigned)bb.event_sectors);
+  TEST_ASSERT(captured && !bb.capturing && bb.events == 1 &&
+                  bb.dropped == 0 && bb.flash_errors == 0,
+              "Trigger captures; escalation extends the same event");
+
+  uint32_t bytes;
+  TEST_ASSERT(bbx_dump(&bb, 0, &bytes) && bytes > 0,
+              "Dump frames are well-formed and the stream ends cleanly");
+  blackbox_rec_hdr_t first;
+  int triggers;
+  bool consecutive;
+  int n = bbx_scan(&first, &triggers, &consecutive);
+  /* Pre-window, the CRITICAL pass and 5 more, then 20 from the
+   * EMERGENCY pass on */
+  int expect = BLACKBOX_PRE_RECORDS + 6 + BLACKBOX_POST_RECORDS;
+  TEST_ASSERT(n == expect && consecutive &&
+                  first.seq == 31 - BLACKBOX_PRE_RECORDS &&
+                  first.state == STATE_NORMAL && triggers == 2,
+              "Frozen pre-window and post-trigger records read back intact");
+
+  /* A stored record is the input-link frames: replay one */
+  const uint8_t *rec = g_bbx_image + sizeof(blackbox_sector_hdr_t);
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+  int r = feed_bytes(&rx, rec + sizeof(blackbox_rec_hdr_t),
+                     INPUT_PACK_FRAME_SIZE +
+                         NUM_MODULES * INPUT_MODULE_FRAME_SIZE);
+  TEST_ASSERT(r == 2 && rx.last_pack.pack_voltage_dv == 3800 &&
+                  rx.last_modules[2].ntc1_dt == 312,
+              "Records replay through the input parser");
+
+  /* Reboot: head and event id recovered from the sector headers */
+  blackbox_t bb2;
+  blackbox_init(&bb2);
+  TEST_ASSERT(bb2.have_log && bb2.log_head == bb.log_head &&
+                  bb2.event == 1 && bb2.next_seq == bb.next_seq,
+              "Log head recovered after re-init");
+
+  /* Back-to-back events: each pre-window starts after the last event */
+  for (int e = 0; e < 40; e++) {
+    for (int i = 0; i < 5; i++)
+      bbx_pass(&bb2, &snap, STATE_NORMAL);
+    for (int i = 0; i < 25; i++)
+      bbx_pass(&bb2, &snap, STATE_CRITICAL);
+  }
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (uint8_t s = 0; s < HAL_FLASH_LOG_SECTORS; s++) {
+    uint32_t c = hal_flash_sim_erase_count(s);
+    lo = c < lo ? c : lo;
+    hi = c > hi ? c : hi;
+  }
+  printf("  41 events: erase counts %u..%u per sector\n", (unsigned)lo,
+         (unsigned)hi);
+  TEST_ASSERT(bb2.events == 40 && bb2.event == 41 && hi - lo <= 1,
+              "Rotation spreads erases evenly over the log");
+
+  TEST_ASSERT(bbx_dump(&bb2, 1, &bytes), "Newest-event dump well-formed");
+  n = bbx_scan(&first, &triggers, &consecutive);
+  /* Pre-window: the newest of the 5 CRITICAL passes after the previous
+   * capture closed and the 5 NORMAL ones */
+  int pre = BLACKBOX_PRE_RECORDS < 10 ? BLACKBOX_PRE_RECORDS : 10;
+  TEST_ASSERT(n == pre + BLACKBOX_POST_RECORDS && triggers == 1 &&
+                  first.state == (pre > 5 ? STATE_CRITICAL : STATE_NORMAL),
+              "Dump of the newest event only; no record logged twice");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 37: Per-module adaptive sampling and the rate request
+ * ----------------------------------------------------------------------- */
+static void test_module_rate(void) {
+  printf("\n--- Test 37: Per-Module Adaptive Sampling ---\n");
+
+  module_rate_t rate;
+  module_cadence_t cad;
+  module_rate_init(&rate);
+  module_cadence_init(&cad);
+  anomaly_result_t a;
+  memset(&a, 0, sizeof(a));
+
+  TEST_ASSERT(module_cadence_due(&cad, &rate, 0, 500, 100) == MODULE_MASK_ALL,
+              "Every module is due on its first turn");
+
+  /* Module 3 flagged, hotspot module 6 (1-based 7) */
+  a.active_count = 1;
+  a.anomaly_modules_mask = MODULE_BIT(3);
+  a.hotspot_module = 7;
+  bool changed = module_rate_update(&rate, &a, STATE_WARNING, false, 0);
+  module_mask_t suspects = MODULE_BIT(3) | MODULE_BIT(6);
+  TEST_ASSERT(changed && rate.boosted == suspects,
+              "Flagged modules and the hotspot are boosted");
+
+  /* One second at a 100 ms med loop */
+  int boosted_turns = 0, healthy_turns = 0;
+  for (uint32_t t = 100; t <= 1000; t += 100) {
+    module_mask_t due = module_cadence_due(&cad, &rate, t, 500, 100);
+    boosted_turns += (due & MODULE_BIT(3)) ? 1 : 0;
+    healthy_turns += (due & MODULE_BIT(0)) ? 1 : 0;
+  }
+  TEST_ASSERT(boosted_turns == 10 && healthy_turns == 2,
+              "Suspects serviced every alert period, the rest every normal");
+
+  /* Flag clears: boost held, then released */
+  memset(&a, 0, sizeof(a));
+  changed = module_rate_update(&rate, &a, STATE_WARNING, false, 1000);
+  bool held = !changed && rate.boosted == suspects;
+  changed = module_rate_update(&rate, &a, STATE_NORMAL, false,
+                               MODULE_RATE_HOLD_MS);
+  TEST_ASSERT(held && changed && rate.boosted == 0,
+              "Boost outlives its flag by the hold time");
+
+  TEST_ASSERT(module_rate_update(&rate, &a, STATE_CRITICAL, false, 6000) &&
+                  rate.boosted == MODULE_MASK_ALL,
+              "CRITICAL boosts the whole pack");
+  module_rate_init(&rate);
+  TEST_ASSERT(module_rate_update(&rate, &a, STATE_NORMAL, true, 0) &&
+                  rate.boosted == MODULE_MASK_ALL,
+              "Short circuit boosts the whole pack");
+
+  /* Back-channel frame */
+  telemetry_rate_frame_t rf;
+  uint8_t len = packet_encode_rate(&rf, suspects, 100, 500);
+  TEST_ASSERT(len == PACKET_RATE_SIZE && rf.frame_type == PACKET_TYPE_RATE &&
+                  rf.boosted[0] == 0x48 && rf.fast_ms == 100 &&
+                  rf.slow_ms == 500 &&
+                  rf.checksum == packet_checksum((const uint8_t *)&rf,
+                                                 PACKET_RATE_SIZE - 1),
+              "Rate request frame encodes the boosted mask");
+
+  /* Sender honouring it: pack + boosted modules complete a cycle */
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+  input_pack_frame_t pf;
+  input_module_frame_t mf;
+  input_rx_set_clock(&rx, 0);
+  make_input_pack(&pf, 600);
+  feed_bytes(&rx, &pf, sizeof(pf));
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    make_input_module(&mf, m);
+    feed_bytes(&rx, &mf, sizeof(mf));
+  }
+  input_rx_reset_cycle(&rx);
+
+  module_mask_t out;
+  input_rx_set_clock(&rx, 100);
+  make_input_pack(&pf, 610);
+  feed_bytes(&rx, &pf, sizeof(pf));
+  make_input_module(&mf, 3);
+  feed_bytes(&rx, &mf, sizeof(mf));
+  bool early = input_rx_subset_ready(&rx, suspects, 100, 1500, &out);
+  make_input_module(&mf, 6);
+  feed_bytes(&rx, &mf, sizeof(mf));
+  module_mask_t others = (module_mask_t)(MODULE_MASK_ALL & ~suspects);
+  TEST_ASSERT(!early &&
+                  input_rx_subset_ready(&rx, suspects, 100, 1500, &out) &&
+                  out == others,
+              "Cycle completes on the boosted modules, others held");
+  TEST_ASSERT(!input_rx_subset_ready(&rx, suspects, 2000, 1500, &out),
+              "Held modules older than the limit block the cycle");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 38: Learned baselines (Welford + EWMA z-scores)
+ * ----------------------------------------------------------------------- */
+
+/* Normal pack with ±1 mV of repeatable group noise */
+static void ostats_sample(sensor_snapshot_t *s, int i) {
+  *s = make_normal_snapshot();
+  for (int m = 0; m < NUM_MODULES; m++)
+    for (int g = 0; g < GROUPS_PER_MODULE; g++)
+      s->modules[m].group_voltages_v[g] += 0.001f * (float)((i + m + g) % 3 - 1);
+}
+
+static void test_online_stats(void) {
+  printf("\n--- Test 38: Learned Baselines ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  static online_stats_t st;
+  online_stats_init(&st);
+  sensor_snapshot_t s;
+
+  /* Warm-up: an offset before the baseline forms is not reported */
+  ostats_sample(&s, 0);
+  online_stats_update(&st, &s, MODULE_MASK_ALL, true);
+  TEST_ASSERT(s.modules[0].v_dev_z == 0.0f && s.gas_z == 0.0f,
+              "No z-scores while the baseline forms");
+
+  int i = 1;
+  for (; i < 300; i++) {
+    ostats_sample(&s, i);
+    online_stats_update(&st, &s, MODULE_MASK_ALL, true);
+  }
+  float worst = 0.0f;
+  for (int m = 0; m < NUM_MODULES; m++) {
+    if (s.modules[m].v_dev_z > worst)
+      worst = s.modules[m].v_dev_z;
+    if (s.modules[m].ntc_z > worst)
+      worst = s.modules[m].ntc_z;
+  }
+  TEST_ASSERT(worst < 2.0f && s.gas_z < 2.0f,
+              "Learned normal pack sits inside its own noise");
+
+  /* Module 2 group 5 steps +12 mV: inside the 15 mV fixed limit */
+  ostats_channel_t *ch = &st.group[2 * GROUPS_PER_MODULE + 5];
+  for (int k = 0; k < 60; k++, i++) {
+    ostats_sample(&s, i);
+    s.modules[2].group_voltages_v[5] += 0.012f;
+    online_stats_update(&st, &s, MODULE_MASK_ALL, true);
+  }
+  compute_snapshot(&s);
+  anomaly_result_t r = anomaly_eval_run(&t, &s);
+  TEST_ASSERT(s.modules[2].v_dev_z > t.baseline_z_warning &&
+                  r.active_mask == CAT_ELECTRICAL &&
+                  r.anomaly_modules_mask == MODULE_BIT(2),
+              "Drift within the fixed limit flags the module by z-score");
+  TEST_ASSERT(ch->mean < 2.0f, "A drifting channel is not learned as normal");
+
+  anomaly_thresholds_t off = t;
+  off.baseline_z_warning = 0.0f;
+  r = anomaly_eval_run(&off, &s);
+  TEST_ASSERT(r.active_mask == CAT_NONE, "z checks off leave fixed limits only");
+
+  /* Fixed-point evaluator sees the same z-scores */
+  anomaly_thresholds_fx_t tfx;
+  sensor_snapshot_fx_t fx;
+  anomaly_thresholds_to_fx(&tfx, &t);
+  anomaly_snapshot_to_fx(&fx, &s);
+  anomaly_eval_fx_compute(&fx, &tfx);
+  anomaly_result_t rfx = anomaly_eval_fx_run(&tfx, &fx);
+  TEST_ASSERT(tfx.baseline_z_warning_dz == 60 &&
+                  rfx.active_mask == CAT_ELECTRICAL &&
+                  rfx.anomaly_modules_mask == MODULE_BIT(2),
+              "Fixed-point path flags the same drift");
+
+  /* Gas is one-sided: a rising ratio is fine, a sag is not. Not
+   * learning here (the pack would not be NORMAL by now). */
+  online_stats_init(&st);
+  for (i = 0; i < 300; i++) {
+    ostats_sample(&s, i);
+    online_stats_update(&st, &s, MODULE_MASK_ALL, true);
+  }
+  for (int k = 0; k < 40; k++) {
+    ostats_sample(&s, i);
+    s.gas_ratio_1 = 1.05f;
+    online_stats_update(&st, &s, 0, false);
+  }
+  bool rise_ok = s.gas_z == 0.0f;
+  for (int k = 0; k < 40; k++) {
+    ostats_sample(&s, i);
+    s.gas_ratio_2 = 0.80f; /* Above the 0.70 fixed warning */
+    online_stats_update(&st, &s, 0, false);
+  }
+  compute_snapshot(&s);
+  r = anomaly_eval_run(&t, &s);
+  TEST_ASSERT(rise_ok && s.gas_z > t.baseline_z_warning &&
+                  (r.active_mask & CAT_GAS),
+              "Gas sagging below its baseline flags CAT_GAS");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 39: Decisive-first evaluation and the trip path
+ * ----------------------------------------------------------------------- */
+
+static void test_eval_trip_path(void) {
+  printf("\n--- Test 39: Trip-Path Evaluation ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+
+  /* Short circuit with a swollen, hot module 4 and gas */
+  sensor_snapshot_t s = make_normal_snapshot();
+  s.short_circuit = true;
+  s.modules[4].swelling_pct = 5.0f;
+  s.modules[4].ntc1_c = 58.0f;
+  s.gas_ratio_1 = 0.5f;
+  compute_snapshot(&s);
+
+  anomaly_result_t full = anomaly_eval_run(&t, &s);
+  anomaly_result_t trip = anomaly_eval_run_trip(&t, &s);
+  TEST_ASSERT(full.active_mask == (CAT_ELECTRICAL | CAT_THERMAL | CAT_GAS |
+                                   CAT_SWELLING) &&
+                  full.anomaly_modules_mask == MODULE_BIT(4),
+              "Full run still reports every category when decided");
+  TEST_ASSERT(trip.is_short_circuit && trip.active_mask == CAT_ELECTRICAL &&
+                  trip.anomaly_modules_mask == 0 &&
+                  trip.risk_factor == full.risk_factor &&
+                  trip.cascade_stage == full.cascade_stage,
+              "Trip path stops after the decisive checks, risk kept");
+
+  /* Not decided: the trip path is the full evaluation */
+  s.short_circuit = false;
+  full = anomaly_eval_run(&t, &s);
+  trip = anomaly_eval_run_trip(&t, &s);
+  TEST_ASSERT(trip.active_mask == full.active_mask &&
+                  trip.anomaly_modules_mask == full.anomaly_modules_mask,
+              "Undecided trip path equals the full run");
+
+  /* Fixed-point trip path decides the same way */
+  s.modules[4].ntc2_c = 85.0f;
+  compute_snapshot(&s);
+  anomaly_thresholds_fx_t tfx;
+  sensor_snapshot_fx_t fx;
+  anomaly_thresholds_to_fx(&tfx, &t);
+  anomaly_snapshot_to_fx(&fx, &s);
+  anomaly_eval_fx_compute(&fx, &tfx);
+  trip = anomaly_eval_run_trip(&t, &s);
+  anomaly_result_t trip_fx = anomaly_eval_fx_run_trip(&tfx, &fx);
+  TEST_ASSERT(trip.is_emergency_direct && trip_fx.is_emergency_direct &&
+                  trip_fx.active_mask == trip.active_mask &&
+                  trip.active_mask == CAT_THERMAL,
+              "Fixed-point trip path matches on an over-temperature");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 40: Binary Log Events
+ * ----------------------------------------------------------------------- */
+static void test_log_events(void) {
+  printf("\n--- Test 40: Binary Log Events ---\n");
+
+  log_event_t log;
+  log_event_init(&log);
+  log.text = false; /* Queue frames as the target does */
+
+  log_state_args_t st = {STATE_WARNING, STATE_CRITICAL, 2, 3, 45, 1};
+  TEST_ASSERT(log_event_emit(&log, LOG_EV_STATE, 123456u, &st, sizeof(st)),
+              "State event queued");
+  const uint8_t *f = log.ring;
+  uint32_t t_ms;
+  memcpy(&t_ms, &f[5], sizeof(t_ms));
+  TEST_ASSERT(log_event_pending(&log) == LOG_EVENT_HEADER + sizeof(st) + 1 &&
+                  f[0] == PACKET_SYNC_BYTE &&
+                  f[1] == LOG_EVENT_HEADER + sizeof(st) + 1 &&
+                  f[2] == PACKET_TYPE_LOG && f[3] == 0 &&
+                  f[4] == LOG_EV_STATE && t_ms == 123456u &&
+                  f[f[1] - 1] == packet_checksum(f, (uint8_t)(f[1] - 1)),
+              "Frame: header, timestamp, raw arguments, XOR");
+
+  char line[200];
+  log_event_format(line, sizeof(line), f);
+  TEST_ASSERT(strcmp(line, "[STATE] WARNING -> CRITICAL (cats=2, "
+                           "hotspot=M3, risk=45%) [DIRECT]\r\n") == 0,
+              "State frame formats as the old text line");
+
+  /* Fixed-point arguments print at the old precision */
+  log_tel_args_t tel = {log_event_q(396.4f, 1.0f),
+                        log_event_q(-120.0f, 1.0f),
+                        log_event_q(41.26f, 10.0f),
+                        log_event_q32(-0.125f, 100.0f),
+                        {log_event_q(0.98f, 100.0f), log_event_q(1.0f, 100.0f)},
+                        {log_event_q(0.0f, 10.0f), log_event_q(2.5f, 10.0f)},
+                        STATE_NORMAL,
+                        0,
+                        1,
+                        5,
+                        1};
+  log_event_init(&log);
+  log.text = false;
+  (void)log_event_emit(&log, LOG_EV_TEL, 1500u, &tel, sizeof(tel));
+  log_event_format(line, sizeof(line), log.ring);
+  TEST_ASSERT(log_event_pending(&log) == 33 &&
+                  strcmp(line, "[TEL] t=1500ms V=396 I=-120 Tmax=41.3 "
+                               "dT/dt=-0.13 gas=[0.98,1.00] dP=[0.0,2.5] "
+                               "state=NORMAL cats=0 hot=M1 risk=5% "
+                               "stg=Elevated\r\n") == 0,
+              "[TEL] is a 33 B frame with the old line's fields");
+  TEST_ASSERT(log_event_q(1e6f, 1.0f) == 32767 &&
+                  log_event_q(-1e6f, 1.0f) == -32768 &&
+                  log_event_q32(722.6f, 100.0f) == 72260,
+              "Fixed-point arguments saturate; dT/dt keeps a runaway's slope");
+
+  /* A full ring drops the newest event; SEQ still counts it */
+  int queued = 1;
+  while (log_event_emit(&log, LOG_EV_TEL, 1500u, &tel, sizeof(tel)))
+    queued++;
+  TEST_ASSERT(queued == LOG_EVENT_RING_SIZE / 33 && log.dropped == 1 &&
+                  log.seq == queued + 1,
+              "Full ring drops the event and leaves a SEQ gap");
+  uint8_t big[LOG_EVENT_MAX_ARGS + 1] = {0};
+  TEST_ASSERT(!log_event_emit(&log, LOG_EV_TEL, 0, big, sizeof(big)),
+              "Oversized arguments are refused");
+
+  int sent = log_event_flush(&log);
+  TEST_ASSERT(sent == queued && log_event_pending(&log) == 0,
+              "Flush moves every queued frame to the UART");
+  TEST_ASSERT(log_event_format(line, sizeof(line), big) == 0,
+              "Non-log bytes do not format");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 41: Multi-Rate Sensor Acquisition
+ * ----------------------------------------------------------------------- */
+
+static void acq_le16(uint8_t *b, int v) {
+  b[0] = (uint8_t)(v & 0xFF);
+  b[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+/* Chip id and a typical NVM calibration image */
+static void acq_sim_bme680_cal(uint8_t addr) {
+  uint8_t id = 0x61, c1[23] = {0}, c2[14] = {0}, c3[5] = {0};
+  acq_le16(&c1[0], 26500); /* par_t2 */
+  c1[2] = 3;               /* par_t3 */
+  acq_le16(&c1[4], 36000); /* par_p1 */
+  acq_le16(&c1[6], -10400);
+  c1[8] = 88;
+  acq_le16(&c1[10], 7000);
+  acq_le16(&c1[12], -100);
+  c1[14] = 40; /* par_p7 */
+  c1[15] = 30; /* par_p6 */
+  acq_le16(&c1[18], -3000);
+  acq_le16(&c1[20], -1700);
+  c1[22] = 30;
+  c2[0] = 1000 >> 4; /* par_h2 = 1000, par_h1 = 700 */
+  c2[1] = (uint8_t)((1000 & 0xF) << 4 | (700 & 0xF));
+  c2[2] = 700 >> 4;
+  c2[4] = 45;
+  c2[5] = 20;
+  c2[6] = 120;
+  c2[7] = (uint8_t)-100;
+  acq_le16(&c2[8], 26200); /* par_t1 */
+  acq_le16(&c2[10], -1000);
+  c2[12] = (uint8_t)-30;
+  c2[13] = 18;
+  c3[0] = 40;
+  c3[2] = 0x10;
+  hal_i2c_sim_set_reg(addr, 0xD0, &id, 1);
+  hal_i2c_sim_set_reg(addr, 0x8A, c1, sizeof(c1));
+  hal_i2c_sim_set_reg(addr, 0xE1, c2, sizeof(c2));
+  hal_i2c_sim_set_reg(addr, 0x00, c3, sizeof(c3));
+}
+
+/* Result registers of a forced measurement; status 0 = still measuring */
+static void acq_sim_bme680_data(uint8_t addr, uint8_t status, uint32_t p_adc,
+                                uint16_t g_adc) {
+  const uint32_t t_adc = 500000; /* ≈ 25.5 °C with the image above */
+  const uint16_t h_adc = 25000;
+  uint8_t b[15] = {0};
+  b[0] = status;
+  b[2] = (uint8_t)(p_adc >> 12);
+  b[3] = (uint8_t)(p_adc >> 4);
+  b[4] = (uint8_t)((p_adc & 0xF) << 4);
+  b[5] = (uint8_t)(t_adc >> 12);
+  b[6] = (uint8_t)(t_adc >> 4);
+  b[7] = (uint8_t)((t_adc & 0xF) << 4);
+  b[8] = (uint8_t)(h_adc >> 8);
+  b[9] = (uint8_t)h_adc;
+  b[13] = (uint8_t)(g_adc >> 2);
+  b[14] = (uint8_t)((g_adc & 3) << 6 | 0x30 | 4); /* Valid, stable, range 4 */
+  hal_i2c_sim_set_reg(addr, 0x1D, b, sizeof(b));
+}
+
+/* The sim's register map is byte-wide, so the shunt register's low byte
+ * is the bus register's high byte: set the shunt's high byte and the
+ * bus voltage */
+static void acq_sim_ina219(uint8_t shunt_hi, uint16_t bus_raw) {
+  uint8_t b[3] = {shunt_hi, (uint8_t)(bus_raw >> 8), (uint8_t)bus_raw};
+  hal_i2c_sim_set_reg(INA219_ADDR, INA219_REG_SHUNT_V, b, 3);
+}
+
+typedef struct {
+  uint32_t current, gas, ntc, swelling;
+} acq_counts_t;
+
+/* `ms` of main-loop passes, 10 ms apart; each pass spins until the ADC
+ * jobs and the bus are idle again (their timing is in real cycles) */
+static void acq_run(acq_t *acq, uint32_t ms, acq_counts_t *n) {
+  for (uint32_t t = 0; t < ms; t += 10) {
+    hal_timer_sim_advance(10);
+    uint32_t polls = 0;
+    uint8_t got;
+    do {
+      got = acq_poll(acq, hal_timer_millis());
+      n->current += (got & ACQ_GOT_CURRENT) != 0;
+      n->gas += (got & ACQ_GOT_GAS) != 0;
+      n->ntc += (got & ACQ_GOT_NTC) != 0;
+      n->swelling += (got & ACQ_GOT_SWELLING) != 0;
+    } while (++polls < 10000000u &&
+             (polls < 3 || acq->scan.in_sweep || acq->scan.converting ||
+              acq->scan.advance || acq->fsr_converting ||
+              !hal_i2c_idle(I2C_BUS_DEFAULT)));
+  }
+}
+
+static void test_acquire(void) {
+  printf("\n--- Test 41: Multi-Rate Sensor Acquisition ---\n");
+
+  static acq_t acq;
+  hal_gpio_init();
+  hal_adc_init();
+  ntc_scan_slot_t slots[NTC_SCAN_PACK_SLOTS];
+  uint8_t n = ntc_scan_pack_layout(slots);
+  for (uint8_t i = 0; i < n; i++)
+    hal_adc_sim_set_mux(slots[i].adc_channel, slots[i].mux_addr, scan_code(i));
+  hal_adc_sim_set(ADC_CHANNEL_FSR, 1500);
+  acq_sim_ina219(0x12, 3325 << 3); /* 0x1267: 0.471 A; 13.3 V */
+  const float amps = 0x1267 * 0.00001f / 0.1f * ACQ_PACK_A_PER_SHUNT_A;
+  acq_sim_bme680_cal(BME680_ADDR);
+  acq_sim_bme680_data(BME680_ADDR, 0x80, 400000, 400);
+
+  uint32_t t0 = hal_timer_millis();
+  TEST_ASSERT(acq_init(&acq, 100, 500, t0) == HAL_OK &&
+                  acq.bme[0].stage == ACQ_BME_IDLE &&
+                  acq.bme[1].stage == ACQ_BME_ABSENT,
+              "BME680 probed; the missing second sensor is skipped");
+
+  /* Everything is due at once. The sim bus finishes one transaction
+   * per poll: current, BME680 start, then the voltage queued behind
+   * the current goes ahead of anything else waiting */
+  uint8_t g1 = acq_poll(&acq, t0);
+  acq_bme_stage_t s1 = acq.bme[0].stage;
+  uint8_t g2 = acq_poll(&acq, t0);
+  (void)acq_poll(&acq, t0);
+  acq_bme_stage_t s3 = acq.bme[0].stage;
+  uint8_t g4 = acq_poll(&acq, t0);
+  TEST_ASSERT(g1 == 0 && s1 == ACQ_BME_STARTING &&
+                  (g2 & ACQ_GOT_CURRENT) && s3 == ACQ_BME_MEASURING &&
+                  (g4 & ACQ_GOT_VOLTAGE),
+              "Current, then the BME680 start, then the voltage");
+  TEST_ASSERT(fabsf(acq.pack_current_a - amps) < 0.01f &&
+                  fabsf(acq.pack_voltage_v - 332.5f) < 0.01f,
+              "Mirror channel scaled to pack units");
+
+  /* Each job at its own rate; the BME680 baseline forms over 10 s */
+  acq_counts_t cnt = {0};
+  acq_run(&acq, 12000, &cnt);
+  printf("  12 s: %u current, %u gas, %u NTC sweeps, %u FSR\n",
+         (unsigned)cnt.current, (unsigned)cnt.gas, (unsigned)cnt.ntc,
+         (unsigned)cnt.swelling);
+  TEST_ASSERT(cnt.current >= 119 && cnt.current <= 121 && cnt.gas >= 11 &&
+                  cnt.gas <= 12 && cnt.ntc >= 23 && cnt.ntc <= 25 &&
+                  cnt.swelling == cnt.ntc && acq.bus_errors == 0,
+              "INA219 at 10 Hz, BME680 at 1 Hz, NTC sweep and FSR at 2 Hz");
+
+  sensor_snapshot_t prev = make_normal_snapshot();
+  sensor_snapshot_t snap = prev;
+  module_mask_t dirty = acq_to_snapshot(&acq, &snap, &prev);
+  bool ntc_ok = true;
+  for (uint8_t i = 0; i < n; i++) {
+    float c = (i & 1) ? snap.modules[i / 2].ntc2_c : snap.modules[i / 2].ntc1_c;
+    ntc_ok = ntc_ok && fabsf(c - ntc_lut_temp_dc(scan_code(i)) * 0.1f) < 0.01f;
+  }
+  printf("  BME680: %.2f C, %.1f hPa, %.1f %%RH, %.0f ohm\n",
+         acq.bme[0].last.temperature_c, acq.bme[0].last.pressure_hpa,
+         acq.bme[0].last.humidity_pct, acq.bme[0].last.gas_resistance_ohm);
+  TEST_ASSERT(dirty == MODULE_MASK_ALL && ntc_ok &&
+                  snap.stale_modules == 0 &&
+                  fabsf(snap.pack_current_a - amps) < 0.01f &&
+                  fabsf(snap.modules[0].group_voltages_v[0] -
+                        332.5f / TOTAL_SERIES) < 0.001f &&
+                  fabsf(snap.modules[ACQ_FSR_MODULE].swelling_pct -
+                        fsr_raw_to_swelling_pct(1500)) < 0.01f,
+              "Snapshot carries current, voltage, NTCs and swelling");
+  TEST_ASSERT(fabsf(snap.temp_ambient_c - 25.53f) < 0.01f &&
+                  acq.bme[0].dev.baseline_n == BME680_BASELINE_SAMPLES &&
+                  fabsf(snap.gas_ratio_1 - 1.0f) < 0.001f &&
+                  fabsf(snap.pressure_delta_1_hpa) < 0.01f &&
+                  snap.gas_ratio_2 == 1.0f && snap.pressure_delta_2_hpa == 0.0f,
+              "Compensated BME680 reading at its baseline; absent one neutral");
+  TEST_ASSERT(acq_to_snapshot(&acq, &snap, &prev) == 0,
+              "Nothing new, nothing dirty");
+
+  /* Electrolyte vapour: gas resistance falls, enclosure pressure rises */
+  acq_sim_bme680_data(BME680_ADDR, 0x80, 399000, 600);
+  acq_run(&acq, 1500, &cnt);
+  (void)acq_to_snapshot(&acq, &snap, &prev);
+  TEST_ASSERT(snap.gas_ratio_1 < 0.9f && snap.pressure_delta_1_hpa > 0.5f,
+              "Gas ratio drops and pressure delta rises against baseline");
+
+  /* No new data after the heater cycle: a timeout, no stale reading */
+  acq_sim_bme680_data(BME680_ADDR, 0x00, 399000, 600);
+  uint32_t gas = cnt.gas;
+  acq_run(&acq, 2000, &cnt);
+  TEST_ASSERT(cnt.gas == gas && acq.bme_timeouts >= 1 &&
+                  acq.bme[0].stage != ACQ_BME_ABSENT,
+              "Missing result times out and the sensor is retried");
+
+  /* Alert rates speed the INA219 up; a short trips on its first sample */
+  acq_set_rates(&acq, 20, 100);
+  uint32_t cur = cnt.current;
+  acq_run(&acq, 1000, &cnt);
+  TEST_ASSERT(cnt.current - cur >= 49 && cnt.current - cur <= 51,
+              "INA219 follows the fast-loop alert period");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  safety_trip_t trip;
+  safety_trip_init(&trip, &t);
+  acq_sim_ina219(0x7D, 3325 << 3); /* 0x7D67: 401 A */
+  hal_timer_sim_advance(20);
+  (void)acq_poll(&acq, hal_timer_millis()); /* Read queued */
+  uint8_t got = acq_poll(&acq, hal_timer_millis());
+  TEST_ASSERT((got & ACQ_GOT_CURRENT) &&
+                  safety_trip_check_a(&trip, acq.pack_current_a),
+              "Short-circuit current trips on the pass its read completes");
+  hal_gpio_init();
+}
+
+/* -----------------------------------------------------------------------
+ * Test 42: Queued I2C Transactions
+ * ----------------------------------------------------------------------- */
+
+typedef struct {
+  uint8_t order[8];
+  uint8_t count;
+} i2c_log_t;
+
+static void i2c_log_done(hal_i2c_xfer_t *x) {
+  i2c_log_t *log = (i2c_log_t *)x->ctx;
+  if (log->count < sizeof(log->order))
+    log->order[log->count++] = x->reg;
+}
+
+static void i2c_submit_logged(hal_i2c_xfer_t *x, i2c_log_t *log) {
+  x->done = i2c_log_done;
+  x->ctx = log;
+  (void)hal_i2c_submit(I2C_BUS_DEFAULT, x);
+}
+
+/* Poll until the bus is idle (bounded; timeouts run in real cycles) */
+static void i2c_drain(void) {
+  for (uint32_t i = 0; i < 100000000u && !hal_i2c_idle(I2C_BUS_DEFAULT); i++)
+    hal_i2c_poll(I2C_BUS_DEFAULT);
+}
+
+static void test_i2c_queue(void) {
+  printf("\n--- Test 42: Queued I2C Transactions ---\n");
+
+  const uint8_t slow = 0x50, fast = 0x41, absent = 0x51;
+  uint8_t regs[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  hal_i2c_sim_set_reg(slow, 0x10, regs, sizeof(regs));
+  hal_i2c_sim_set_reg(fast, 0x01, regs, 2);
+  hal_i2c_set_priority(I2C_BUS_DEFAULT, fast, HAL_I2C_PRIO_HIGH);
+  hal_i2c_stats_t st0, st;
+  i2c_drain(); /* Anything an earlier test left on the bus */
+  hal_i2c_get_stats(I2C_BUS_DEFAULT, &st0);
+
+  /* Two slow transactions, then a fast one: it overtakes the waiting
+   * one but not the one already on the bus */
+  uint8_t burst[8], wr[2] = {0xAA, 0xBB}, cur[2];
+  hal_i2c_xfer_t a, b, c;
+  i2c_log_t log = {{0}, 0};
+  hal_i2c_xfer_read(&a, slow, 0x10, burst, sizeof(burst));
+  hal_i2c_xfer_write(&b, slow, 0x20, wr, sizeof(wr));
+  hal_i2c_xfer_read(&c, fast, 0x01, cur, sizeof(cur));
+  i2c_submit_logged(&a, &log);
+  i2c_submit_logged(&b, &log);
+  i2c_submit_logged(&c, &log);
+  TEST_ASSERT(a.status == HAL_BUSY && b.status == HAL_BUSY &&
+                  c.status == HAL_BUSY && log.count == 0 &&
+                  !hal_i2c_idle(I2C_BUS_DEFAULT),
+              "Submits return at once; nothing completes inside them");
+  i2c_drain();
+  TEST_ASSERT(log.count == 3 && log.order[0] == 0x10 &&
+                  log.order[1] == 0x01 && log.order[2] == 0x20,
+              "High-priority device goes ahead of the waiting transaction");
+  uint8_t back[2];
+  TEST_ASSERT(a.status == HAL_OK && memcmp(burst, regs, sizeof(regs)) == 0 &&
+                  b.status == HAL_OK &&
+                  hal_i2c_read_reg(I2C_BUS_DEFAULT, slow, 0x20, back, 2) ==
+                      HAL_OK &&
+                  back[0] == 0xAA && back[1] == 0xBB,
+              "Burst read returns the register block; burst write lands");
+
+  /* A missing device NACKs; bad lengths never reach the queue */
+  hal_i2c_xfer_t n;
+  hal_i2c_xfer_read(&n, absent, 0x00, cur, 2);
+  (void)hal_i2c_submit(I2C_BUS_DEFAULT, &n);
+  i2c_drain();
+  hal_i2c_xfer_t bad;
+  hal_i2c_xfer_read(&bad, slow, 0x00, burst, 0);
+  hal_i2c_get_stats(I2C_BUS_DEFAULT, &st);
+  TEST_ASSERT(n.status == HAL_ERROR && st.nacks == st0.nacks + 1 &&
+                  hal_i2c_submit(I2C_BUS_DEFAULT, &bad) == HAL_ERROR,
+              "NACK reported; empty transaction refused");
+
+  /* A hung sensor: its transaction times out, the bus is recovered and
+   * the fast read queued behind it still completes */
+  hal_i2c_sim_hang(slow, true);
+  hal_i2c_xfer_read(&a, slow, 0x10, burst, sizeof(burst));
+  hal_i2c_xfer_read(&c, fast, 0x01, cur, sizeof(cur));
+  (void)hal_i2c_submit(I2C_BUS_DEFAULT, &a);
+  (void)hal_i2c_submit(I2C_BUS_DEFAULT, &c);
+  uint32_t t0 = hal_timer_cycles();
+  i2c_drain();
+  uint32_t us = (hal_timer_cycles() - t0) / HAL_TIMER_CYCLES_PER_US;
+  hal_i2c_get_stats(I2C_BUS_DEFAULT, &st);
+  printf("  Hung transaction released after %u us\n", (unsigned)us);
+  TEST_ASSERT(a.status == HAL_TIMEOUT && c.status == HAL_OK &&
+                  st.timeouts == st0.timeouts + 1 &&
+                  st.recoveries == st0.recoveries + 1 &&
+                  us >= HAL_I2C_TIMEOUT_US,
+              "Hung transaction times out, bus recovered, queue moves on");
+  hal_i2c_sim_hang(slow, false);
+
+  /* Full queue: the caller is told, nothing is lost silently */
+  hal_i2c_xfer_t q[HAL_I2C_QUEUE_DEPTH + 2];
+  hal_status_t last = HAL_OK;
+  for (int i = 0; i < HAL_I2C_QUEUE_DEPTH + 2; i++) {
+    hal_i2c_xfer_read(&q[i], slow, 0x10, burst, 1);
+    last = hal_i2c_submit(I2C_BUS_DEFAULT, &q[i]);
+  }
+  i2c_drain();
+  hal_i2c_get_stats(I2C_BUS_DEFAULT, &st);
+  TEST_ASSERT(last == HAL_BUSY && st.rejected == st0.rejected + 1 &&
+                  q[HAL_I2C_QUEUE_DEPTH].status == HAL_OK,
+              "One on the bus plus a full queue; the next submit is refused");
+  hal_i2c_set_priority(I2C_BUS_DEFAULT, fast, HAL_I2C_PRIO_LOW);
+}
+
 /* -----------------------------------------------------------------------
  * Main
  * ----------------------------------------------------------------------- */
 
+/* -----------------------------------------------------------------------
+ * Test 43: Compiled Threshold Plan and Threshold Reload
+ * ----------------------------------------------------------------------- */
+static bool results_equal(const anomaly_result_t *a,
+                          const anomaly_result_t *b) {
+  return a->active_mask == b->active_mask &&
+         a->active_count == b->active_count &&
+         a->is_short_circuit == b->is_short_circuit &&
+         a->is_emergency_direct == b->is_emergency_direct &&
+         a->anomaly_modules_mask == b->anomaly_modules_mask &&
+         a->cascade_stage == b->cascade_stage &&
+         a->risk_factor == b->risk_factor && a->risk_q15 == b->risk_q15;
+}
+
+static void test_threshold_plan(void) {
+  printf("\n--- Test 43: Compiled Threshold Plan ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  anomaly_plan_t plan;
+  anomaly_plan_compile(&plan, &t);
+  TEST_ASSERT(fabsf(plan.group_v_deviation_v - 0.015f) < 1e-7f &&
+                  plan.current_short_neg_a == -350.0f,
+              "Limits compiled to snapshot units (V deviation, ± current)");
+
+  /* Plan and per-call paths agree, faults in every direction */
+  int same = 0;
+  const int cases = 6;
+  for (int k = 0; k < cases; k++) {
+    sensor_snapshot_t s = make_normal_snapshot();
+    if (k == 1)
+      s.pack_current_a = -400.0f; /* Reverse short */
+    if (k == 2)
+      s.modules[4].group_voltages_v[7] = 3.180f; /* 18 mV low */
+    if (k == 3) {
+      s.modules[1].ntc1_c = 58.0f;
+      s.gas_ratio_2 = 0.5f;
+    }
+    if (k == 4)
+      s.pack_current_a = -190.0f; /* Discharge over the warning */
+    if (k == 5)
+      s.modules[6].ntc2_c = 85.0f; /* Emergency bypass */
+    anomaly_eval_compute(&s, &t);
+    anomaly_result_t a = anomaly_eval_run(&t, &s);
+    anomaly_result_t b = anomaly_eval_run_plan(&plan, &s);
+    anomaly_result_t c = anomaly_eval_run_trip(&t, &s);
+    anomaly_result_t d = anomaly_eval_run_plan_trip(&plan, &s);
+    same += results_equal(&a, &b) && results_equal(&c, &d);
+    if (k == 1)
+      TEST_ASSERT(b.is_short_circuit, "Negative current past the limit trips");
+    if (k == 2)
+      TEST_ASSERT(b.anomaly_modules_mask == MODULE_BIT(4),
+                  "Low group flagged against the volt-unit deviation");
+  }
+  TEST_ASSERT(same == cases, "Compiled plan gives the same results");
+
+  /* Staged edits: ids are field positions, values in milli-units */
+  anomaly_thresholds_t staged = t;
+  TEST_ASSERT(anomaly_thresholds_set(&staged, 8, 25000) == HAL_OK &&
+                  staged.temp_warning_c == 25.0f,
+              "Threshold set by id from milli-units");
+  TEST_ASSERT(anomaly_thresholds_set(&staged, ANOMALY_THRESHOLD_COUNT, 1) ==
+                  HAL_ERROR,
+              "Unknown threshold id rejected");
+  TEST_ASSERT(anomaly_thresholds_check(&t) == HAL_OK &&
+                  anomaly_thresholds_check(&staged) == HAL_OK,
+              "Default and edited sets pass the check");
+
+  anomaly_thresholds_t bad = staged;
+  (void)anomaly_thresholds_set(&bad, 8, 70000); /* Above critical */
+  TEST_ASSERT(anomaly_thresholds_check(&bad) == HAL_ERROR,
+              "Warning above critical fails the check");
+
+  /* Plausibility ranges: trip and EMERGENCY levels capped in hardware */
+  bad = staged;
+  TEST_ASSERT(anomaly_thresholds_set(&bad, 6, 2000000000) == HAL_ERROR &&
+                  anomaly_thresholds_set(&bad, 18, 2000000000) == HAL_ERROR &&
+                  anomaly_thresholds_set(&bad, 16, 200000) == HAL_ERROR &&
+                  anomaly_thresholds_set(&bad, 8, -5000) == HAL_ERROR &&
+                  bad.current_short_a == staged.current_short_a &&
+                  bad.temp_emergency_c == staged.temp_emergency_c,
+              "Out-of-range values rejected, set unchanged");
+  bad.current_emergency_a = ANOMALY_CURRENT_CEILING_A + 1.0f;
+  TEST_ASSERT(anomaly_thresholds_check(&bad) == HAL_ERROR,
+              "Emergency current past the ceiling fails the check");
+  bad = staged;
+  bad.dt_dt_emergency = NAN;
+  TEST_ASSERT(anomaly_thresholds_check(&bad) == HAL_ERROR,
+              "NaN threshold fails the check");
+
+  /* Recompiled plan takes effect on the next evaluation */
+  sensor_snapshot_t s = make_normal_snapshot();
+  anomaly_eval_compute(&s, &staged);
+  anomaly_plan_compile(&plan, &staged);
+  anomaly_result_t r = anomaly_eval_run_plan(&plan, &s);
+  TEST_ASSERT(r.active_mask & CAT_THERMAL,
+              "Lowered warning level applies without a restart");
+
+  /* Drift check off compiles to a limit nothing exceeds */
+  staged.baseline_z_warning = 0.0f;
+  anomaly_plan_compile(&plan, &staged);
+  TEST_ASSERT(plan.z_warn == FLT_MAX, "Baseline drift off compiles to FLT_MAX");
+
+  /* A new trip level keeps a trip latched */
+  safety_trip_t trip;
+  safety_trip_init(&trip, &t);
+  (void)safety_trip_check_a(&trip, 400.0f);
+  anomaly_thresholds_t raised = t;
+  raised.current_short_a = 450.0f;
+  safety_trip_set_limit(&trip, &raised);
+  TEST_ASSERT(trip.tripped && trip.short_da == 4500,
+              "Trip level follows the reload, latch kept");
+
+  /* Threshold frame on the input link */
+  input_rx_state_t rx;
+  input_rx_init(&rx);
+  input_threshold_frame_t tf = {INPUT_SYNC_BYTE,
+                                INPUT_THRESHOLD_FRAME_SIZE,
+                                INPUT_TYPE_THRESHOLD,
+                                INPUT_THRESHOLD_OP_SET,
+                                8,
+                                -12500,
+                                0};
+  tf.checksum = xor_bytes((const uint8_t *)&tf, sizeof(tf) - 1);
+  int res = feed_bytes(&rx, &tf, sizeof(tf));
+  TEST_ASSERT(res == 0 && !(rx.frame_contents & INPUT_GOT_THRESHOLD),
+              "v1 threshold frame dropped (no CRC)");
+
+  uint8_t v2[INPUT_THRESHOLD_FRAME_SIZE + INPUT_V2_OVERHEAD];
+  const uint8_t *one[] = {(const uint8_t *)&tf};
+  uint16_t n = make_v2(v2, INPUT_TYPE_THRESHOLD, 1, one, 1);
+  res = feed_bytes(&rx, v2, n);
+  TEST_ASSERT(res == 1 && (rx.frame_contents & INPUT_GOT_THRESHOLD) &&
+                  rx.last_threshold.param == 8 &&
+                  rx.last_threshold.value_milli == -12500 &&
+                  rx.modules_received == 0 && !rx.pack_received,
+              "v2 threshold frame parsed without touching the snapshot");
+}
+
+/* -----------------------------------------------------------------------
+ * Test 44: Binary Input Captures
+ * ----------------------------------------------------------------------- */
+static void make_capture_record(capture_record_t *rec, uint32_t t_ms,
+                                int16_t current_da, module_mask_t skip) {
+  memset(rec, 0, sizeof(*rec));
+  rec->t_ms = t_ms;
+  make_input_pack(&rec->pack, current_da);
+  for (uint8_t m = 0; m < NUM_MODULES; m++)
+    if (!(skip & MODULE_BIT(m)))
+      make_input_module(&rec->modules[m], m);
+}
+
+static void test_capture_files(void) {
+  printf("\n--- Test 44: Binary Input Captures ---\n");
+
+  const char *path = "test_capture.tmp";
+  const uint32_t n = 3 * CAPTURE_INDEX_STRIDE - 72;
+  capture_writer_t w;
+  capture_record_t rec;
+  bool ok = capture_writer_open(&w, path) == HAL_OK;
+  for (uint32_t i = 0; i < n && ok; i++) {
+    make_capture_record(&rec, i * 100u, (int16_t)(i % 1000),
+                        (i & 1) ? MODULE_BIT(1) : 0);
+    ok = capture_writer_append(&w, &rec) == HAL_OK;
+  }
+  make_capture_record(&rec, 50, 0, 0);
+  TEST_ASSERT(ok && capture_writer_append(&w, &rec) == HAL_ERROR,
+              "Records appended; one going back in time refused");
+
+  /* Recorder killed: no index yet, count from the file size */
+  fflush(w.f);
+  capture_file_t cap;
+  TEST_ASSERT(capture_open(&cap, path) == HAL_OK && cap.count == n &&
+                  !cap.index && capture_find(&cap, 150000) == 1500,
+              "Unclosed capture opens and searches without an index");
+  capture_close(&cap);
+
+  TEST_ASSERT(capture_writer_close(&w) == HAL_OK &&
+                  capture_open(&cap, path) == HAL_OK,
+              "Closed capture maps");
+  TEST_ASSERT(cap.count == n && cap.index_count == 3 &&
+                  cap.header->t_last_ms == (n - 1) * 100u &&
+                  cap.header->record_size == sizeof(capture_record_t),
+              "Header carries count, index and time span");
+  TEST_ASSERT(capture_find(&cap, 0) == 0 &&
+                  capture_find(&cap, 150000) == 1500 &&
+                  capture_find(&cap, 150050) == 1501 &&
+                  capture_find(&cap, 102400) == 1024 &&
+                  capture_find(&cap, n * 100u) == n,
+              "Time lookup through the index");
+
+  /* Decode as the board does; a module missing from a record holds */
+  sensor_snapshot_t s;
+  memset(&s, 0, sizeof(s));
+  module_mask_t got0 = capture_decode(&cap.records[10], &s);
+  float held = s.modules[1].ntc1_c;
+  module_mask_t got1 = capture_decode(&cap.records[11], &s);
+  TEST_ASSERT(got0 == MODULE_MASK_ALL &&
+                  got1 == (MODULE_MASK_ALL & ~MODULE_BIT(1)) &&
+                  fabsf(held - 28.1f) < 1e-4f &&
+                  s.modules[1].ntc1_c == held,
+              "Missing module frame holds the last one");
+  TEST_ASSERT(fabsf(s.pack_current_a - 1.1f) < 1e-4f &&
+                  fabsf(s.modules[3].group_voltages_v[0] - 3.194f) < 1e-5f &&
+                  fabsf(s.gas_ratio_2 - 0.97f) < 1e-5f,
+              "Wire units decoded as apply_external_input()");
+  capture_close(&cap);
+
+  /* Not a capture */
+  FILE *f = fopen(path, "wb");
+  static const uint8_t junk[CAPTURE_HEADER_SIZE] = {'B', 'S', 'C', 'X'};
+  if (f) {
+    fwrite(junk, 1, sizeof(junk), f);
+    fclose(f);
+  }
+  TEST_ASSERT(capture_open(&cap, path) == HAL_ERROR && !cap.map,
+              "Bad magic rejected");
+  remove(path);
+}
+
+/* -----------------------------------------------------------------------
+ * Test 45: Fixed-point build — telemetry, rates and baselines in wire
+ * units, against the float path on the same data
+ * ----------------------------------------------------------------------- */
+static int near1(int32_t a, int32_t b) { return a - b <= 1 && b - a <= 1; }
+
+static void test_fixed_point_outputs(void) {
+  printf("\n--- Test 45: Fixed-Point Telemetry and Rates ---\n");
+
+  anomaly_thresholds_t t;
+  anomaly_eval_init(&t);
+  anomaly_thresholds_fx_t tfx;
+  anomaly_thresholds_to_fx(&tfx, &t);
+
+  sensor_snapshot_fx_t fx = make_normal_fx();
+  fx.modules[3].ntc1_dt = 487;
+  fx.modules[3].max_dt_dt_ddpm = 23;
+  VPLANE_MV(&fx.vplane, 5, 9) = 3141;
+  fx.pack_current_da = -1234;
+  fx.pressure_delta_2_chpa = -37;
+  sensor_snapshot_t s;
+  fx_to_float(&fx, &s);
+  anomaly_eval_compute(&s, &t);
+  anomaly_eval_fx_compute(&fx, &tfx);
+  anomaly_result_t r = anomaly_eval_fx_run(&tfx, &fx);
+  r.risk_factor = r.risk_q15 / 32768.0f; /* For the float encoders */
+
+  /* Input and group frames carry wire units: identical bytes */
+  input_pack_frame_t ip, ipx;
+  packet_encode_input_pack(&ip, &s);
+  packet_encode_input_pack_fx(&ipx, &fx);
+  int same = memcmp(&ip, &ipx, sizeof(ip)) == 0;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    input_module_frame_t im, imx;
+    telemetry_group_frame_t g, gx;
+    packet_encode_input_module(&im, m, &s);
+    packet_encode_input_module_fx(&imx, m, &fx);
+    packet_encode_groups(&g, m, &s);
+    packet_encode_groups_fx(&gx, m, &fx);
+    same += memcmp(&im, &imx, sizeof(im)) == 0 &&
+            memcmp(&g, &gx, sizeof(g)) == 0;
+  }
+  TEST_ASSERT(same == NUM_MODULES + 1,
+              "Input, black-box and group frames identical from wire units");
+
+  /* Summary frames: the float encoders truncate, so within one LSB */
+  telemetry_pack_frame_t pk, pkx;
+  packet_encode_pack(&pk, 5000, &s, &r, STATE_WARNING);
+  packet_encode_pack_fx(&pkx, 5000, &fx, &r, STATE_WARNING);
+  TEST_ASSERT(near1(pk.pack_voltage_dv, pkx.pack_voltage_dv) &&
+                  near1(pk.pack_current_da, pkx.pack_current_da) &&
+                  near1(pk.r_int_cmohm, pkx.r_int_cmohm) &&
+                  near1(pk.max_temp_dt, pkx.max_temp_dt) &&
+                  near1(pk.core_temp_est_dt, pkx.core_temp_est_dt) &&
+                  near1(pk.dt_dt_max_cdpm, pkx.dt_dt_max_cdpm) &&
+                  pkx.dt_dt_max_cdpm == 230 &&
+                  near1(pk.pressure_delta_2_chpa, pkx.pressure_delta_2_chpa) &&
+                  near1(pk.v_spread_dmv, pkx.v_spread_dmv) &&
+                  pk.system_state == pkx.system_state &&
+                  pk.flags == pkx.flags &&
+                  pk.hotspot_module == pkx.hotspot_module,
+              "Pack frame from the fixed-point snapshot matches");
+  TEST_ASSERT(r.risk_q15 > 0 &&
+                  pkx.risk_factor_pct == anomaly_risk_pct_fx(&r) &&
+                  near1(pk.risk_factor_pct, pkx.risk_factor_pct),
+              "Risk encoded from Q15 without a float");
+  int mods = 0;
+  for (uint8_t m = 0; m < NUM_MODULES; m++) {
+    telemetry_module_frame_t md, mdx;
+    packet_encode_module(&md, m, &s);
+    packet_encode_module_fx(&mdx, m, &fx);
+    mods += near1(md.ntc1_dt, mdx.ntc1_dt) &&
+            near1(md.delta_t_intra_dt, mdx.delta_t_intra_dt) &&
+            near1(md.max_dt_dt_cdpm, mdx.max_dt_dt_cdpm) &&
+            near1(md.module_voltage_dv, mdx.module_voltage_dv) &&
+            near1(md.v_spread_mv, mdx.v_spread_mv);
+  }
+  TEST_ASSERT(mods == NUM_MODULES, "Module frames match");
+
+  /* Black box: the same record bytes from either snapshot */
+  static blackbox_t bb, bbx;
+  hal_flash_sim_reset();
+  blackbox_init(&bb);
+  blackbox_init(&bbx);
+  blackbox_record(&bb, 7000, &s, &r, STATE_WARNING);
+  blackbox_record_fx(&bbx, 7000, &fx, &r, STATE_WARNING);
+  TEST_ASSERT(memcmp(bb.ring[0], bbx.ring[0], BLACKBOX_REC_SIZE) == 0,
+              "Black-box record identical from the fixed-point snapshot");
+
+  /* dT/dt straight to deci-°C/min from the integer history */
+  history_t *h = &g_test_hist;
+  history_init(h);
+  int w = history_add_window(h, HIST_CH_NTC(0, 0), 2 * NUM_MODULES, 3000);
+  for (uint32_t k = 0; k < 7; k++)
+    hist_push_one(h, k * 500u + (k & 1) * 13u, HIST_CH_NTC(0, 1),
+                  -(int32_t)(k * 41u));
+  float ref = history_slope(h, w, HIST_CH_NTC(0, 1)) * 0.6f;
+  int32_t ddpm = history_slope_scaled(h, w, HIST_CH_NTC(0, 1), 600);
+  TEST_ASSERT(ddpm == (int32_t)(ref - 0.5f) &&
+                  history_slope_scaled(h, w, HIST_CH_NTC(0, 0), 600) == 0,
+              "Integer slope agrees with the float one, rounded");
+
+  /* Baselines fed from wire units: the same σ × 10 z-scores */
+  static online_stats_t st, stx;
+  online_stats_init(&st);
+  online_stats_init(&stx);
+  int i = 0;
+  for (; i < 360; i++) {
+    ostats_sample(&s, i);
+    if (i >= 300)
+      s.modules[2].group_voltages_v[5] += 0.012f;
+    anomaly_snapshot_to_fx_raw(&fx, &s);
+    online_stats_update(&st, &s, MODULE_MASK_ALL, true);
+    online_stats_update_fx(&stx, &fx, MODULE_MASK_ALL, true);
+  }
+  int zs = 0;
+  for (int m = 0; m < NUM_MODULES; m++)
+    zs += near1(fx.modules[m].v_dev_dz,
+                (int32_t)(s.modules[m].v_dev_z * 10.0f + 0.5f)) &&
+          near1(fx.modules[m].ntc_dz,
+                (int32_t)(s.modules[m].ntc_z * 10.0f + 0.5f));
+  anomaly_eval_fx_compute(&fx, &tfx);
+  r = anomaly_eval_fx_run(&tfx, &fx);
+  TEST_ASSERT(zs == NUM_MODULES && fx.modules[2].v_dev_dz > 60 &&
+                  r.anomaly_modules_mask == MODULE_BIT(2),
+              "Fixed-point baselines give the float z-scores");
+}
+
 int main(void) {
   printf("====================================================\n");
   printf("  EV Battery Intelligence — C Firmware Test Runner\n");
@@ -676,6 +3366,34 @@ int main(void) {
   test_cascade_stages();
   test_hotspot_tracking();
   test_core_temp_estimation();
+  test_input_parser();
+  test_snapshot_buffer();
+  test_scheduler();
+  test_latency_stats();
+  test_safety_trip();
+  test_incremental_compute();
+  test_fixed_point_equivalence();
+  test_voltage_plane();
+  test_pack_geometry();
+  test_compact_telemetry();
+  test_group_voltage_stream();
+  test_v2_framing();
+  test_partial_snapshot();
+  test_history_rates();
+  test_fleet_batch();
+  test_actuators();
+  test_ntc_lut();
+  test_ntc_scan();
+  test_blackbox();
+  test_module_rate();
+  test_online_stats();
+  test_eval_trip_path();
+  test_log_events();
+  test_acquire();
+  test_i2c_queue();
+  test_threshold_plan();
+  test_capture_files();
+  test_fixed_point_outputs();
 
   printf("\n====================================================\n");
   printf("  Results: %d/%d passed", tests_passed, tests_run);
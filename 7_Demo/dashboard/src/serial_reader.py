@@ -6,14 +6,29 @@ Reads multi-frame telemetry from the VSDSquadron ULTRA output.
 Protocol:
   Frame 0x01 (Pack):   40 bytes — Pack summary + anomaly + risk
   Frame 0x02 (Module): 20 bytes × 8 — Per-module NTC, swelling, voltage
+  Frame 0x03 (Latency): 25 bytes × 5 — Per-loop-stage execution time (µs)
 
 Each frame: [0xAA][LEN][TYPE][payload][XOR_checksum]
+
+Negotiated v2 output batches a cycle's frames into CRC-16 superframes:
+  [0xAB][LEN_LO][LEN_HI][0x10][SEQ] {[TYPE][PLEN][payload]}* [CRC16_LE]
+
+Frame 0x07 (Rate) asks the input sender to refresh only the listed
+modules at the fast period (module_rate.h); see rate_request.
+
+On request the black-box flash log is streamed as Frame 0x06 chunks
+(see blackbox.h); parse_blackbox_log() turns the image into records.
+
+Debug lines ([STATE], [TEL], [RATE], [TRIP], [BBX]) arrive as Frame 0x08
+binary events (log_event.h); decode_log_frame() rebuilds the text and
+SerialReader collects it in log_lines.
 """
 
 import struct
 import time
+from collections import deque
 from dataclasses import dataclass, field
-from typing import List, Optional
+from typing import Dict, List, Optional, Tuple
 
 try:
     import serial
@@ -26,19 +41,275 @@ except ImportError:
 SYNC_BYTE = 0xAA
 PACK_FRAME_TYPE = 0x01
 MODULE_FRAME_TYPE = 0x02
-PACK_FRAME_SIZE = 38
+LATENCY_FRAME_TYPE = 0x03
+PACK_FRAME_SIZE = 38      # 8-module pack; 37 + one mask byte per 8 modules
+PACK_FRAME_SIZE_MAX = 41  # 32 modules (pack_config.h limit)
 MODULE_FRAME_SIZE = 17
+LATENCY_FRAME_SIZE = 25
+PACK_FLAG_EMERGENCY = 0x01  # Physics-limit bypass fired
+PACK_FLAG_STALE = 0x02      # Some modules evaluated from last-good data
+
+# Group voltage frames for flagged modules: 8 + one byte per group
+GROUPS_FRAME_TYPE = 0x05
+GROUPS_FRAME_MIN = 9
+GROUPS_FRAME_MAX = 40
+GROUPS_FLAG_CLIPPED = 0x01
+
+# Per-module rate request: mask bytes + fast_ms(u16) + slow_ms(u16)
+RATE_FRAME_TYPE = 0x07
+RATE_FRAME_MIN = 9
+RATE_FRAME_MAX = 12
+
+# Binary log events: seq + event + t_ms(u32) + packed arguments
+LOG_FRAME_TYPE = 0x08
+LOG_FRAME_HEADER = 9
+LOG_FRAME_MIN = LOG_FRAME_HEADER + 1
+LOG_FRAME_MAX = LOG_FRAME_HEADER + 24 + 1
+LOG_LINES_KEPT = 200
+
+# Compact keyframe/delta frames (opt-in, see packet_format.h)
+COMPACT_FRAME_TYPE = 0x04
+COMPACT_FRAME_MIN = 6
+COMPACT_FRAME_MAX = 128
+COMPACT_HEADER = 5
+COMPACT_FLAG_KEY = 0x01
+# Signedness of the fields in each block, in legacy frame order
+COMPACT_PACK_SIGNED = (False, False, True, False, True, True, True, False,
+                       False, False, True, True, False, False, False, False,
+                       False, False, False, False, False, False)
+COMPACT_MODULE_SIGNED = (True, True, False, False, False, False, False)
+
+# v2 superframes (opt-in): CRC-16/CCITT-FALSE, cycle sequence number
+SYNC_V2 = 0xAB
+SUPER_FRAME_TYPE = 0x10
+V2_HEADER = 5
+V2_OVERHEAD = 7
+V2_MAX_SIZE = 256
+
+
+def _crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), as crc16.c."""
+    for b in data:
+        crc = (crc << 8 & 0xFFFF) ^ _CRC16_TABLE[(crc >> 8) ^ b]
+    return crc
+
+
+def _crc16_table():
+    table = []
+    for i in range(256):
+        c = i << 8
+        for _ in range(8):
+            c = ((c << 1) ^ 0x1021) if c & 0x8000 else (c << 1)
+        table.append(c & 0xFFFF)
+    return table
+
+
+_CRC16_TABLE = _crc16_table()
+
+# Black-box log dump (blackbox.h)
+BLACKBOX_FRAME_TYPE = 0x06
+BLACKBOX_DUMP_HEADER = 10
+BLACKBOX_FRAME_MIN = BLACKBOX_DUMP_HEADER + 1
+BLACKBOX_FRAME_MAX = BLACKBOX_DUMP_HEADER + 64 + 1
+BLACKBOX_DUMP_END = 0x01
+BLACKBOX_SECTOR_SIZE = 4096
+BLACKBOX_SECTOR_MAGIC = 0x31584242
+BLACKBOX_SECTOR_HDR = struct.Struct('<IIHHBBH')
+BLACKBOX_REC_MAGIC = 0xB5
+BLACKBOX_REC_HDR = struct.Struct('<BBBBBBHI')
+BLACKBOX_REC_TRIGGER = 0x01
+BLACKBOX_REC_STALE = 0x02
+BLACKBOX_REC_SHORT = 0x04
+INPUT_PACK_FRAME = struct.Struct('<BBBHhhhhHHhhBHB')
+BLACKBOX_OP_STATUS = 0
+BLACKBOX_OP_DUMP = 1
+
+
+def parse_blackbox_log(image: Dict[int, bytes]) -> List[dict]:
+    """Records of a dumped black-box log, oldest first.
+
+    `image` maps log offsets to the bytes received there. Each sector
+    starts with a CRC-checked header; records are the input-link frames
+    the twin sends, so values come back in wire units.
+    """
+    flat = bytearray()
+    for off in sorted(image):
+        if off > len(flat):
+            flat.extend(b'\xff' * (off - len(flat)))
+        flat[off:off + len(image[off])] = image[off]
+
+    sectors = []
+    for base in range(0, len(flat), BLACKBOX_SECTOR_SIZE):
+        raw = bytes(flat[base:base + BLACKBOX_SECTOR_HDR.size])
+        if len(raw) < BLACKBOX_SECTOR_HDR.size:
+            break
+        magic, seq, event, rec_size, n_mod, _, crc = \
+            BLACKBOX_SECTOR_HDR.unpack(raw)
+        if magic != BLACKBOX_SECTOR_MAGIC or _crc16(raw[:-2]) != crc:
+            continue
+        sectors.append((seq, base, event, rec_size, n_mod))
+
+    records = []
+    for seq, base, event, rec_size, n_mod in sorted(sectors):
+        if n_mod == 0:
+            continue
+        mod_size = (rec_size - BLACKBOX_REC_HDR.size -
+                    INPUT_PACK_FRAME.size - 2) // n_mod
+        n_groups = mod_size - 12
+        mod_fmt = struct.Struct('<BBBBhhBH%dbB' % n_groups)
+        end = base + BLACKBOX_SECTOR_SIZE
+        pos = base + BLACKBOX_SECTOR_HDR.size
+        while pos + rec_size <= min(end, len(flat)):
+            rec = bytes(flat[pos:pos + rec_size])
+            pos += rec_size
+            if rec[0] != BLACKBOX_REC_MAGIC:
+                break
+            crc = rec[-2] | (rec[-1] << 8)
+            if _crc16(rec[:-2]) != crc:
+                continue  # Torn by a reset mid-write
+            hdr = BLACKBOX_REC_HDR.unpack_from(rec)
+            pk = INPUT_PACK_FRAME.unpack_from(rec, BLACKBOX_REC_HDR.size)
+            mods = []
+            off = BLACKBOX_REC_HDR.size + INPUT_PACK_FRAME.size
+            for _ in range(n_mod):
+                mv = mod_fmt.unpack_from(rec, off)
+                off += mod_size
+                mods.append({
+                    'module_index': mv[3],
+                    'ntc1_c': mv[4] / 10.0,
+                    'ntc2_c': mv[5] / 10.0,
+                    'swelling_pct': mv[6],
+                    'group_mv': [mv[7] + d for d in mv[8:8 + n_groups]],
+                })
+            records.append({
+                'event': event,
+                'seq': hdr[6],
+                'timestamp_ms': hdr[7],
+                'system_state': STATE_NAMES.get(hdr[1], "UNKNOWN"),
+                'anomaly_mask': hdr[2],
+                'risk_pct': hdr[3],
+                'trigger': bool(hdr[4] & BLACKBOX_REC_TRIGGER),
+                'stale_modules': bool(hdr[4] & BLACKBOX_REC_STALE),
+                'short_circuit': bool(hdr[4] & BLACKBOX_REC_SHORT),
+                'voltage_v': pk[3] / 10.0,
+                'current_a': pk[4] / 10.0,
+                'temp_ambient_c': pk[5] / 10.0,
+                'gas_ratio_1': pk[8] / 100.0,
+                'gas_ratio_2': pk[9] / 100.0,
+                'pressure_delta_1_hpa': pk[10] / 100.0,
+                'pressure_delta_2_hpa': pk[11] / 100.0,
+                'modules': mods,
+            })
+    return records
+
+# Telemetry config frame (input link, sync 0xBB) that negotiates the mode
+INPUT_SYNC_BYTE = 0xBB
+TEL_CONFIG_FRAME_TYPE = 0x03
+TEL_MODE_LEGACY = 0
+TEL_MODE_COMPACT = 1
+TEL_FLAG_ASCII = 0x01
+TEL_FLAG_KEY = 0x02
+TEL_FLAG_V2 = 0x04
+BLACKBOX_CMD_FRAME_TYPE = 0x04
+THRESHOLD_FRAME_TYPE = 0x05
+THRESHOLD_OP_SET = 0
+THRESHOLD_OP_APPLY = 1
+THRESHOLD_OP_DEFAULTS = 2
+THRESHOLD_OP_REVERT = 3
+THRESHOLD_OP_NAMES = ["set", "apply", "defaults", "revert"]
+# Threshold frames go out in input v2 framing only (the firmware drops
+# them without a CRC): [0xBC][len16][type][seq][op][param][i32][crc16]
+INPUT_SYNC_V2 = 0xBC
+INPUT_V2_OVERHEAD = 7
+
+# Threshold ids: field positions in anomaly_thresholds_t (anomaly_eval.h)
+THRESHOLD_IDS = {name: i for i, name in enumerate([
+    'voltage_low_v', 'voltage_high_v', 'group_v_deviation_mv',
+    'v_spread_warn_mv', 'v_spread_crit_mv', 'current_warning_a',
+    'current_short_a', 'r_int_warning_mohm', 'temp_warning_c',
+    'temp_critical_c', 'dt_dt_warning', 'inter_module_dt_warn_c',
+    'inter_module_dt_crit_c', 'intra_module_dt_warn_c',
+    'intra_module_dt_crit_c', 'delta_t_ambient_warning', 'temp_emergency_c',
+    'dt_dt_emergency', 'current_emergency_a', 'gas_warning_ratio',
+    'gas_critical_ratio', 'pressure_warning_hpa', 'pressure_critical_hpa',
+    'coolant_dt_min_c', 'swelling_warning_pct', 'baseline_z_warning',
+])}
+
+FRAME_SIZES = {
+    PACK_FRAME_TYPE: PACK_FRAME_SIZE,
+    MODULE_FRAME_TYPE: MODULE_FRAME_SIZE,
+    LATENCY_FRAME_TYPE: LATENCY_FRAME_SIZE,
+}
 
 NUM_MODULES = 8
 
 # State names
 STATE_NAMES = {0: "NORMAL", 1: "WARNING", 2: "CRITICAL", 3: "EMERGENCY"}
 
+# Latency stage names (lat_stage_t order in latency_stats.h)
+LATENCY_STAGE_NAMES = ["fast", "med", "compute", "eval", "slow"]
+
 # Cascade stage names
 CASCADE_NAMES = ["Normal", "Elevated", "SEI_Decomp", "Separator",
                  "Electrolyte", "Cathode", "RUNAWAY"]
 
 
+# Log events (log_event_id_t): argument layout and the line it prints,
+# as log_event_format() in log_event.c
+def _state_line(t, a):
+    return ("[STATE] %s -> %s (cats=%d, hotspot=M%d, risk=%d%%)%s" %
+            (STATE_NAMES.get(a[0], "UNKNOWN"), STATE_NAMES.get(a[1], "UNKNOWN"),
+             a[2], a[3], a[4], " [DIRECT]" if a[5] else ""))
+
+
+def _tel_line(t, a):
+    stage = CASCADE_NAMES[a[12]] if a[12] < len(CASCADE_NAMES) else "UNKNOWN"
+    return ("[TEL] t=%dms V=%d I=%d Tmax=%.1f dT/dt=%.2f gas=[%.2f,%.2f] "
+            "dP=[%.1f,%.1f] state=%s cats=%d hot=M%d risk=%d%% stg=%s" %
+            (t, a[0], a[1], a[2] / 10, a[3] / 100, a[4] / 100, a[5] / 100,
+             a[6] / 10, a[7] / 10, STATE_NAMES.get(a[8], "UNKNOWN"), a[9],
+             a[10], a[11], stage))
+
+
+LOG_EVENTS = {
+    1: (struct.Struct('<BBBBBB'), _state_line),
+    2: (struct.Struct('<hhhihhhhBBBBB'), _tel_line),
+    3: (struct.Struct('<h'), lambda t, a:
+        "[TRIP] I=%dA — relay opened pre-emptively" % a),
+    4: (struct.Struct('<BB'), lambda t, a:
+        "[RATE] %d/%d modules at the alert rate" % a),
+    5: (struct.Struct('<BBBBI'), lambda t, a:
+        "[TEL] mode=%s key=%d ascii=%d v2=%d period=%dms" %
+        ((("compact" if a[0] else "legacy"),) + a[1:])),
+    6: (struct.Struct('<HH'), lambda t, a:
+        "[BBX] Event %d: %d pre-trigger records frozen" % a),
+    7: (struct.Struct('<BH'), lambda t, a:
+        "[BBX] Dump %s (events=%d)" %
+        ("started" if a[0] else "skipped, log empty", a[1])),
+    8: (struct.Struct('<IHHBII'), lambda t, a:
+        "[BBX] events=%d last=%d sector=%d capturing=%d dropped=%d "
+        "errors=%d" % a),
+    9: (struct.Struct('<BBiBH'), lambda t, a:
+        "[THR] %s param=%d value=%d %s (plan %d)" %
+        (THRESHOLD_OP_NAMES[a[0]] if a[0] < 4 else "?", a[1], a[2],
+         "ok" if a[3] else "rejected", a[4])),
+}
+
+
+def decode_log_frame(data: bytes) -> Optional[Tuple[int, int, str]]:
+    """Decode a validated Frame 0x08 into (seq, t_ms, line).
+
+    None for an unknown event id or an argument size that does not match
+    it (firmware newer than this table).
+    """
+    seq, event, t_ms = struct.unpack_from('<BBI', data, 3)
+    spec = LOG_EVENTS.get(event)
+    args = data[LOG_FRAME_HEADER:-1]
+    if spec is None or len(args) != spec[0].size:
+        return None
+    return seq, t_ms, spec[1](t_ms, spec[0].unpack(args))
+
+
 def active_categories(mask):
     """Return list of active category names from bitmask."""
     cats = []
@@ -111,10 +382,14 @@ class BoardReading:
     risk_pct: int = 0
     cascade_stage: int = 0
     emergency_direct: bool = False
+    stale_modules: bool = False  # Board reused last-good module data
 
     # Per-module data
     module_data: List[dict] = field(default_factory=list)
 
+    # Loop latency by stage name: count, overruns, min/mean/p99/max µs
+    loop_latency: Dict[str, dict] = field(default_factory=dict)
+
     def module_ntc_values(self) -> List[float]:
         """Flatten all module NTC temperatures as [m1_ntc1, m1_ntc2, ...]."""
         vals: List[float] = []
@@ -169,8 +444,32 @@ class SerialReader:
         # Latest parsed data
         self._pack_frame = None
         self._module_frames = {}
+        self._latency_frames = {}
+        self._group_frames = {}
         self._last_reading = None
 
+        # Compact stream state: block -> raw field values
+        self._compact_fields = {}
+        self._compact_valid = set()
+        self._compact_seq = None
+
+        # Black-box dump in progress: offset -> bytes; the finished log
+        self._bbx_chunks = {}
+        self._bbx_next_chunk = 0
+        self.blackbox_records = None
+
+        # Latest rate request: boosted module indices and the two periods
+        self.rate_request = None
+
+        # Decoded log events, oldest first; events lost on the board
+        # (gaps in the event sequence)
+        self.log_lines = deque(maxlen=LOG_LINES_KEPT)
+        self.log_lost = 0
+        self._log_seq = None
+
+        # Sequence number of the last threshold frame sent
+        self._threshold_seq = 0
+
     def open(self):
         """Open serial port."""
         if not HAS_SERIAL:
@@ -192,6 +491,107 @@ class SerialReader:
                 pass
             self.ser = None
 
+    def request_telemetry_mode(self, compact: bool = True,
+                               ascii_line: bool = False,
+                               key_interval: int = 0,
+                               period_ms: int = 0,
+                               v2: bool = False) -> bool:
+        """Ask the firmware for compact (or legacy) telemetry.
+
+        key_interval is cycles per keyframe (0 = firmware default);
+        period_ms caps the telemetry period in 100 ms steps (0 = none);
+        v2 batches the output into CRC-16 superframes.
+        """
+        if not self.ser or not self.ser.is_open:
+            return False
+        frame = bytearray([
+            INPUT_SYNC_BYTE, 8, TEL_CONFIG_FRAME_TYPE,
+            TEL_MODE_COMPACT if compact else TEL_MODE_LEGACY,
+            (TEL_FLAG_ASCII if ascii_line else 0) | TEL_FLAG_KEY |
+            (TEL_FLAG_V2 if v2 else 0),
+            min(max(key_interval, 0), 255),
+            min(max(period_ms // 100, 0), 255),
+        ])
+        csum = 0
+        for b in frame:
+            csum ^= b
+        frame.append(csum)
+        try:
+            self.ser.write(bytes(frame))
+        except Exception:
+            return False
+        return True
+
+    def _send_input_frame(self, frame: bytearray) -> bool:
+        if not self.ser or not self.ser.is_open:
+            return False
+        csum = 0
+        for b in frame:
+            csum ^= b
+        frame.append(csum)
+        try:
+            self.ser.write(bytes(frame))
+        except Exception:
+            return False
+        return True
+
+    def request_blackbox_dump(self, newest_events: int = 0) -> bool:
+        """Ask for the black-box log (newest_events, 0 = all of it).
+
+        The frames arrive interleaved with telemetry; once the last one
+        is in, blackbox_records holds the decoded log.
+        """
+        self._bbx_chunks = {}
+        self._bbx_next_chunk = 0
+        self.blackbox_records = None
+        return self._send_input_frame(bytearray([
+            INPUT_SYNC_BYTE, 6, BLACKBOX_CMD_FRAME_TYPE, BLACKBOX_OP_DUMP,
+            min(max(newest_events, 0), 255)]))
+
+    def request_blackbox_status(self) -> bool:
+        """Ask for the firmware's one-line [BBX] recorder status."""
+        return self._send_input_frame(bytearray([
+            INPUT_SYNC_BYTE, 6, BLACKBOX_CMD_FRAME_TYPE, BLACKBOX_OP_STATUS,
+            0]))
+
+    def _send_threshold(self, op: int, param: int = 0,
+                        value_milli: int = 0) -> bool:
+        if not self.ser or not self.ser.is_open:
+            return False
+        payload = struct.pack('<BBi', op, param, value_milli)
+        self._threshold_seq = (self._threshold_seq + 1) & 0xFF
+        frame = struct.pack('<BHBB', INPUT_SYNC_V2,
+                            INPUT_V2_OVERHEAD + len(payload),
+                            THRESHOLD_FRAME_TYPE, self._threshold_seq)
+        frame += payload
+        frame += struct.pack('<H', _crc16(frame))
+        try:
+            self.ser.write(frame)
+        except Exception:
+            return False
+        return True
+
+    def set_thresholds(self, apply: bool = True, **values: float) -> bool:
+        """Stage threshold values by name (anomaly_thresholds_t fields,
+        physical units) and, unless apply is False, make them live.
+
+        The firmware refuses a value outside its plausible range, checks
+        the whole set on apply and keeps the old one if it fails or the
+        pack is not NORMAL; each frame is answered with a [THR] log line.
+        An unknown name raises KeyError before anything is sent.
+        """
+        frames = [(THRESHOLD_IDS[name], int(round(v * 1000)))
+                  for name, v in values.items()]
+        for param, milli in frames:
+            if not self._send_threshold(THRESHOLD_OP_SET, param, milli):
+                return False
+        return self._send_threshold(THRESHOLD_OP_APPLY) if apply else True
+
+    def reset_thresholds(self) -> bool:
+        """Stage and apply the firmware's built-in thresholds."""
+        return (self._send_threshold(THRESHOLD_OP_DEFAULTS) and
+                self._send_threshold(THRESHOLD_OP_APPLY))
+
     def read_text_line(self) -> Optional[str]:
         """Read a text line from the serial port."""
         if not self.ser or not self.ser.is_open:
@@ -205,6 +605,12 @@ class SerialReader:
             pass
         return None
 
+    def pop_log_lines(self) -> List[str]:
+        """Return the log lines decoded since the last call."""
+        lines = list(self.log_lines)
+        self.log_lines.clear()
+        return lines
+
     def read_latest_packet(self) -> Optional[BoardReading]:
         """Read and decode multi-frame telemetry.
 
@@ -238,10 +644,10 @@ class SerialReader:
         changed = False
 
         while len(self._buf) >= 3:
-            # Find sync byte
-            try:
-                sync_idx = self._buf.index(SYNC_BYTE)
-            except ValueError:
+            # Find the first sync byte of either framing
+            sync_idx = next((i for i, b in enumerate(self._buf)
+                             if b == SYNC_BYTE or b == SYNC_V2), None)
+            if sync_idx is None:
                 self._buf.clear()
                 break
 
@@ -249,20 +655,22 @@ class SerialReader:
             if sync_idx > 0:
                 del self._buf[:sync_idx]
 
+            if self._buf[0] == SYNC_V2:
+                result = self._parse_superframe()
+                if result is None:
+                    break
+                changed |= result
+                continue
+
             if len(self._buf) < 3:
                 break
 
             frame_len = self._buf[1]
             frame_type = self._buf[2]
 
-            # Validate frame type and length
-            if frame_type == PACK_FRAME_TYPE and frame_len != PACK_FRAME_SIZE:
-                del self._buf[0]
-                continue
-            elif frame_type == MODULE_FRAME_TYPE and frame_len != MODULE_FRAME_SIZE:
-                del self._buf[0]
-                continue
-            elif frame_type not in (PACK_FRAME_TYPE, MODULE_FRAME_TYPE):
+            # Validate frame type and length (the pack frame grows with
+            # the module mask of larger pack profiles)
+            if not self._valid_frame_len(frame_type, frame_len):
                 del self._buf[0]
                 continue
 
@@ -279,23 +687,107 @@ class SerialReader:
                 del self._buf[0]
                 continue
 
-            # Parse the frame
-            if frame_type == PACK_FRAME_TYPE:
-                self._pack_frame = self._decode_pack_frame(frame_data)
-                changed = True
-            elif frame_type == MODULE_FRAME_TYPE:
-                mod = self._decode_module_frame(frame_data)
-                if mod:
-                    self._module_frames[mod.module_index] = mod
-                    changed = True
+            changed |= self._dispatch_frame(frame_type, frame_data)
 
             # Consume frame
             del self._buf[:frame_len]
 
         return changed
 
+    @staticmethod
+    def _valid_frame_len(frame_type: int, frame_len: int) -> bool:
+        if frame_type == PACK_FRAME_TYPE:
+            return PACK_FRAME_SIZE <= frame_len <= PACK_FRAME_SIZE_MAX
+        if frame_type == COMPACT_FRAME_TYPE:
+            return COMPACT_FRAME_MIN <= frame_len <= COMPACT_FRAME_MAX
+        if frame_type == GROUPS_FRAME_TYPE:
+            return GROUPS_FRAME_MIN <= frame_len <= GROUPS_FRAME_MAX
+        if frame_type == BLACKBOX_FRAME_TYPE:
+            return BLACKBOX_FRAME_MIN <= frame_len <= BLACKBOX_FRAME_MAX
+        if frame_type == RATE_FRAME_TYPE:
+            return RATE_FRAME_MIN <= frame_len <= RATE_FRAME_MAX
+        if frame_type == LOG_FRAME_TYPE:
+            return LOG_FRAME_MIN <= frame_len <= LOG_FRAME_MAX
+        return FRAME_SIZES.get(frame_type) == frame_len
+
+    def _parse_superframe(self) -> Optional[bool]:
+        """Decode the v2 superframe at the head of the buffer.
+
+        Returns None to wait for more bytes, else whether it carried new
+        data. Each record is rebuilt as a v1 frame for the decoders below
+        (the XOR byte is not checked — the CRC already was).
+        """
+        if len(self._buf) < V2_HEADER:
+            return None
+        frame_len = self._buf[1] | (self._buf[2] << 8)
+        if (self._buf[3] != SUPER_FRAME_TYPE or
+                not V2_OVERHEAD < frame_len <= V2_MAX_SIZE):
+            del self._buf[0]
+            return False
+        if len(self._buf) < frame_len:
+            return None
+
+        frame = bytes(self._buf[:frame_len])
+        crc = _crc16(frame[:-2])
+        if frame[-2] != (crc & 0xFF) or frame[-1] != (crc >> 8):
+            del self._buf[0]
+            return False
+        del self._buf[:frame_len]
+
+        changed = False
+        pos, end = V2_HEADER, frame_len - 2
+        while pos + 2 <= end:
+            rec_type, plen = frame[pos], frame[pos + 1]
+            payload = frame[pos + 2:pos + 2 + plen]
+            pos += 2 + plen
+            if pos > end or not self._valid_frame_len(rec_type, plen + 4):
+                break
+            v1 = bytes([SYNC_BYTE, plen + 4, rec_type]) + payload + b'\0'
+            changed |= self._dispatch_frame(rec_type, v1)
+        return changed
+
+    def _dispatch_frame(self, frame_type: int, frame_data: bytes) -> bool:
+        """Hand one validated v1 frame to its decoder."""
+        if frame_type == PACK_FRAME_TYPE:
+            self._pack_frame = self._decode_pack_frame(frame_data)
+            return True
+        if frame_type == MODULE_FRAME_TYPE:
+            mod = self._decode_module_frame(frame_data)
+            if mod:
+                self._module_frames[mod.module_index] = mod
+                return True
+        elif frame_type == LATENCY_FRAME_TYPE:
+            lat = self._decode_latency_frame(frame_data)
+            if lat:
+                self._latency_frames[lat['stage']] = lat
+                return True
+        elif frame_type == COMPACT_FRAME_TYPE:
+            return self._decode_compact_frame(frame_data)
+        elif frame_type == GROUPS_FRAME_TYPE:
+            grp = self._decode_groups_frame(frame_data)
+            if grp:
+                self._group_frames[grp['module_index']] = grp
+                return True
+        elif frame_type == BLACKBOX_FRAME_TYPE:
+            self._decode_blackbox_frame(frame_data)
+        elif frame_type == RATE_FRAME_TYPE:
+            self.rate_request = self._decode_rate_frame(frame_data)
+        elif frame_type == LOG_FRAME_TYPE:
+            self._decode_log_frame(frame_data)
+        return False
+
+    def _decode_log_frame(self, data: bytes) -> None:
+        """Append one log event's line; count events the board dropped."""
+        seq = data[3]
+        if self._log_seq is not None:
+            self.log_lost += (seq - self._log_seq - 1) & 0xFF
+        self._log_seq = seq
+        ev = decode_log_frame(data)
+        if ev:
+            self.log_lines.append(ev[2])
+
     def _decode_pack_frame(self, data: bytes) -> dict:
-        """Decode a 40-byte pack summary frame."""
+        """Decode a pack summary frame (38 bytes for 8 modules)."""
         # Skip sync (1), length (1), type (1) = 3-byte header
         payload = data[3:-1]  # Exclude checksum
 
@@ -303,14 +795,27 @@ class SerialReader:
         # maxT(i16) + ambT(i16) + coreT(i16) + dtdt(u8) +
         # gas1(u8) + gas2(u8) + p1(i16) + p2(i16) +
         # vspread(u16) + tspread(u8) +
-        # state(u8) + mask(u8) + count(u8) + anom_mods(u8) +
+        # state(u8) + mask(u8) + count(u8) +
+        # anom_mods(u8 × ceil(modules/8), little-endian) +
         # hotspot(u8) + risk(u8) + cascade(u8) + flags(u8)
-        fmt = '<IHhHhhh B BB hh HB BBBB BBBB'
+        head_fmt = '<IHhHhhh B BB hh HB BBB'
+        tail_fmt = '<BBBB'
+        head_len = struct.calcsize(head_fmt)
+        mask_len = len(payload) - head_len - struct.calcsize(tail_fmt)
+        if mask_len < 1:
+            return None
         try:
-            vals = struct.unpack(fmt, payload)
+            head = struct.unpack_from(head_fmt, payload)
+            tail = struct.unpack_from(tail_fmt, payload, head_len + mask_len)
         except struct.error:
             return None
+        anom_mods = int.from_bytes(
+            payload[head_len:head_len + mask_len], 'little')
+        return self._pack_dict(head + (anom_mods,) + tail)
 
+    @staticmethod
+    def _pack_dict(vals) -> dict:
+        """Pack summary fields, in frame order, as a dict."""
         return {
             'timestamp_ms': vals[0],
             'pack_voltage_dv': vals[1],
@@ -347,7 +852,11 @@ class SerialReader:
             vals = struct.unpack(fmt, payload)
         except struct.error:
             return None
+        return self._module_reading(vals)
 
+    @staticmethod
+    def _module_reading(vals) -> ModuleReading:
+        """Module detail fields, in frame order, as a ModuleReading."""
         mod = ModuleReading()
         mod.module_index = vals[0]
         mod.ntc1_c = vals[1] / 10.0
@@ -360,6 +869,143 @@ class SerialReader:
 
         return mod
 
+    def _decode_compact_frame(self, data: bytes) -> bool:
+        """Apply a compact keyframe/delta frame. Returns True if new data.
+
+        Block 0 carries the pack fields, block 1+m module m. A sequence
+        gap drops every baseline until the next keyframe.
+        """
+        seq, key = data[3], bool(data[4] & COMPACT_FLAG_KEY)
+        if self._compact_seq is not None and seq != (self._compact_seq + 1) & 0xFF:
+            self._compact_valid.clear()
+        self._compact_seq = seq
+
+        def varint(pos):
+            v, shift = 0, 0
+            while pos < end and shift < 35:
+                b = data[pos]
+                v |= (b & 0x7F) << shift
+                pos += 1
+                if not b & 0x80:
+                    return v, pos
+                shift += 7
+            raise ValueError("truncated varint")
+
+        end = len(data) - 1
+        pos = COMPACT_HEADER
+        updated = []
+        try:
+            while pos < end:
+                block = data[pos]
+                bitmap, pos = varint(pos + 1)
+                signed = COMPACT_PACK_SIGNED if block == 0 else COMPACT_MODULE_SIGNED
+                if bitmap >> len(signed):
+                    return False
+                fields = self._compact_fields.setdefault(block, [0] * len(signed))
+                apply = key or block in self._compact_valid
+                for f in range(len(signed)):
+                    if not bitmap & (1 << f):
+                        continue
+                    z, pos = varint(pos)
+                    d = (z >> 1) ^ -(z & 1)
+                    if apply:
+                        base = 0 if key else fields[f]
+                        fields[f] = (base + d) & 0xFFFFFFFF
+                if key:
+                    self._compact_valid.add(block)
+                if apply:
+                    updated.append(block)
+        except ValueError:
+            return False
+
+        for block in updated:
+            signed = COMPACT_PACK_SIGNED if block == 0 else COMPACT_MODULE_SIGNED
+            vals = [v - (1 << 32) if s and v & 0x80000000 else v
+                    for v, s in zip(self._compact_fields[block], signed)]
+            if block == 0:
+                self._pack_frame = self._pack_dict(vals)
+            else:
+                self._module_frames[block - 1] = self._module_reading(
+                    [block - 1] + vals)
+        return bool(updated)
+
+    def _decode_groups_frame(self, data: bytes) -> Optional[dict]:
+        """Decode a group voltage frame (21 bytes for 13 groups)."""
+        payload = data[3:-1]
+
+        # module_idx(u8) + base_mv(u16) + delta(i8 × groups) + flags(u8)
+        n_groups = len(payload) - 4
+        try:
+            vals = struct.unpack('<BH%dbB' % n_groups, payload)
+        except struct.error:
+            return None
+
+        base = vals[1]
+        return {
+            'module_index': vals[0],
+            'group_mv': [base + d for d in vals[2:2 + n_groups]],
+            'clipped': bool(vals[-1] & GROUPS_FLAG_CLIPPED),
+        }
+
+    def _decode_blackbox_frame(self, data: bytes) -> None:
+        """Collect one dump chunk; decode the log after the end frame.
+
+        A missed chunk (sequence gap) or a byte count that disagrees
+        with the end frame drops the dump — request it again.
+        """
+        flags, chunk, offset = struct.unpack_from('<BHI', data, 3)
+        if chunk != self._bbx_next_chunk:
+            self._bbx_chunks = {}
+            self._bbx_next_chunk = 0
+            return
+        self._bbx_next_chunk += 1
+        if not flags & BLACKBOX_DUMP_END:
+            self._bbx_chunks[offset] = data[BLACKBOX_DUMP_HEADER:-1]
+            return
+        received = sum(len(c) for c in self._bbx_chunks.values())
+        if received == offset:
+            self.blackbox_records = parse_blackbox_log(self._bbx_chunks)
+        self._bbx_chunks = {}
+        self._bbx_next_chunk = 0
+
+    @staticmethod
+    def _decode_rate_frame(data: bytes) -> dict:
+        """Decode a rate request (9 bytes for 8 modules)."""
+        payload = data[3:-1]
+        mask = int.from_bytes(payload[:-4], 'little')
+        fast_ms, slow_ms = struct.unpack('<HH', payload[-4:])
+        return {
+            'boosted': [m for m in range(8 * (len(payload) - 4))
+                        if mask >> m & 1],
+            'fast_ms': fast_ms,
+            'slow_ms': slow_ms,
+        }
+
+    def _decode_latency_frame(self, data: bytes) -> Optional[dict]:
+        """Decode a 25-byte loop latency frame."""
+        payload = data[3:-1]
+
+        # stage(u8) + count(u16) + overruns(u16) +
+        # min(u32) + mean(u32) + p99(u32) + max(u32), all µs
+        fmt = '<B HH IIII'
+        try:
+            vals = struct.unpack(fmt, payload)
+        except struct.error:
+            return None
+
+        if vals[0] >= len(LATENCY_STAGE_NAMES):
+            return None
+
+        return {
+            'stage': LATENCY_STAGE_NAMES[vals[0]],
+            'count': vals[1],
+            'overruns': vals[2],
+            'min_us': vals[3],
+            'mean_us': vals[4],
+            'p99_us': vals[5],
+            'max_us': vals[6],
+        }
+
     def _build_reading(self) -> BoardReading:
         """Build a BoardReading from the latest pack + module frames."""
         r = BoardReading()
@@ -387,15 +1033,25 @@ class SerialReader:
             r.hotspot_module = pf['hotspot_module']
             r.risk_pct = pf['risk_factor_pct']
             r.cascade_stage = pf['cascade_stage']
-            r.emergency_direct = bool(pf['flags'] & 0x01)
+            r.emergency_direct = bool(pf['flags'] & PACK_FLAG_EMERGENCY)
+            r.stale_modules = bool(pf['flags'] & PACK_FLAG_STALE)
 
-        # Add module data
+        # Add module data (larger packs report more than NUM_MODULES)
         r.module_data = []
-        for i in range(NUM_MODULES):
+        num_modules = max([NUM_MODULES] +
+                          [i + 1 for i in self._module_frames])
+        for i in range(num_modules):
             if i in self._module_frames:
-                r.module_data.append(self._module_frames[i].to_dict())
+                md = self._module_frames[i].to_dict()
             else:
-                r.module_data.append(ModuleReading(module_index=i).to_dict())
+                md = ModuleReading(module_index=i).to_dict()
+            # Last group voltages streamed while the module was flagged
+            if i in self._group_frames:
+                md['group_mv'] = self._group_frames[i]['group_mv']
+                md['group_mv_clipped'] = self._group_frames[i]['clipped']
+            r.module_data.append(md)
+
+        r.loop_latency = dict(self._latency_frames)
 
         self._last_reading = r
         return r
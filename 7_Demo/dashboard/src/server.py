@@ -199,7 +199,9 @@ def board_reading_to_dict(r):
         "cascade_stage": getattr(r, 'cascade_stage', 0),
         "categories": cats,
         "emergency_direct": getattr(r, 'emergency_direct', False),
+        "stale_modules": getattr(r, 'stale_modules', False),
         "modules": getattr(r, 'module_data', []),
+        "loop_latency": getattr(r, 'loop_latency', {}),
     }
     module_temps = r.module_ntc_values() if hasattr(r, "module_ntc_values") else _flatten_module_temps(d["modules"])
     d["module_ntc_points"] = module_temps
@@ -451,16 +453,17 @@ def serial_data_thread(expected_epoch):
 # Twin Bridge Mode — Digital Twin → Board → Dashboard
 # ---------------------------------------------------------------------------
 
-def encode_twin_input_packet(snapshot):
+def encode_twin_input_packet(snapshot, modules=None):
     """Encode a digital twin snapshot into multi-frame binary for the board.
 
     Uses the SerialBridge from the digital twin to produce 9 frames
-    (1 pack + 8 module frames) containing all 139 sensor channels.
+    (1 pack + 8 module frames) containing all 139 sensor channels, or
+    the pack frame plus only `modules` when given.
     """
     try:
         from digital_twin.serial_bridge import SerialBridge
         bridge = SerialBridge.__new__(SerialBridge)
-        return bridge.encode_all_frames(snapshot)
+        return bridge.encode_all_frames(snapshot, modules)
     except ImportError:
         # Fallback: import from path
         import importlib.util
@@ -470,11 +473,30 @@ def encode_twin_input_packet(snapshot):
             mod = importlib.util.module_from_spec(spec)
             spec.loader.exec_module(mod)
             bridge = mod.SerialBridge.__new__(mod.SerialBridge)
-            return bridge.encode_all_frames(snapshot)
+            return bridge.encode_all_frames(snapshot, modules)
         # Last resort: return empty (board will use internal sim)
         return b''
 
 
+def bridge_modules_due(rate_request, sent_at, num_modules, now):
+    """Modules to send this pass under the board's rate request.
+
+    The board names the modules it wants every fast_ms; the rest go
+    every slow_ms. Without a request, or with nothing boosted, every
+    module goes every pass. `sent_at` maps module -> last send time.
+    """
+    if not rate_request or not rate_request.get('boosted'):
+        return None
+    boosted = set(rate_request['boosted'])
+    due = []
+    for m in range(num_modules):
+        period_s = (rate_request['fast_ms'] if m in boosted
+                    else rate_request['slow_ms']) / 1000.0
+        if now - sent_at.get(m, 0.0) >= period_s:
+            due.append(m)
+    return due
+
+
 def twin_bridge_data_thread(expected_epoch):
     """Bridge: Digital Twin → Serial → Board → Dashboard."""
     global latest_reading, is_running, serial_port, board_connected, twin_source_url
@@ -483,6 +505,7 @@ def twin_bridge_data_thread(expected_epoch):
     prev_state = None
     bridge_seq = 0
     last_await_emit_at = 0.0
+    module_sent_at = {}
 
     while is_running and expected_epoch == stream_epoch:
         # Find serial port
@@ -516,11 +539,20 @@ def twin_bridge_data_thread(expected_epoch):
                     twin_data = None
 
                 if twin_data:
-                    # 2. Encode as 0xBB input packet and send to board
-                    input_pkt = encode_twin_input_packet(twin_data)
+                    # 2. Encode as 0xBB input packet and send to board —
+                    #    the pack every pass, modules as the board asks
+                    now = time.perf_counter()
+                    num_modules = len(twin_data.get("modules", [])) or 8
+                    modules = bridge_modules_due(reader.rate_request,
+                                                 module_sent_at,
+                                                 num_modules, now)
+                    input_pkt = encode_twin_input_packet(twin_data, modules)
                     if reader.ser and reader.ser.is_open:
                         try:
                             reader.ser.write(input_pkt)
+                            for m in (modules if modules is not None
+                                      else range(num_modules)):
+                                module_sent_at[m] = now
                             bridge_seq += 1
                             input_seq = bridge_seq
                             input_sent_at = time.perf_counter()
@@ -0,0 +1,95 @@
+"""
+Battery Pack Digital Twin — Input Capture Writer
+==================================================
+Records the input frames sent to the board as a binary capture file,
+the format 3_Firmware/src/capture.h defines and tests/capture_eval.c
+replays:
+
+  header   64 B: magic "BSCP", geometry, record count, index
+  records  [t_ms u32][reserved u32][pack frame][module frame × 8]
+  index    [t_ms u32][reserved u32][record u64] every 1024 records
+
+Frames are stored exactly as sent (v1 layout, XOR checksum). A module
+not sent in a cycle is stored as zeros; the replay holds its last
+frame, as the board does. If the recorder is killed before close(),
+the file still replays: the header then has no index and the record
+count comes from the file size.
+"""
+
+import struct
+import time
+from typing import Dict, Optional
+
+from digital_twin.config import NUM_MODULES, GROUPS_PER_MODULE
+
+CAPTURE_MAGIC = b'BSCP'
+CAPTURE_VERSION = 1
+CAPTURE_HEADER_SIZE = 64
+CAPTURE_INDEX_STRIDE = 1024
+
+PACK_FRAME_SIZE = 25
+MODULE_FRAME_SIZE = 12 + GROUPS_PER_MODULE
+RECORD_SIZE = 8 + PACK_FRAME_SIZE + NUM_MODULES * MODULE_FRAME_SIZE
+
+# magic, version, header_size, record_size, num_modules,
+# groups_per_module, index_stride, record_count, index_offset,
+# index_count, t_first_ms, t_last_ms, reserved
+_HEADER = struct.Struct('<4sHHHBBIQQIII20x')
+
+
+class CaptureWriter:
+    """Appends one record per input cycle to a capture file."""
+
+    def __init__(self, path: str):
+        self._f = open(path, 'wb')
+        self._t0 = time.monotonic()
+        self._count = 0
+        self._t_first = 0
+        self._t_last = 0
+        self._index = []
+        self._f.write(self._header(0, 0))
+
+    def _header(self, index_offset: int, index_count: int) -> bytes:
+        return _HEADER.pack(CAPTURE_MAGIC, CAPTURE_VERSION,
+                            CAPTURE_HEADER_SIZE, RECORD_SIZE, NUM_MODULES,
+                            GROUPS_PER_MODULE, CAPTURE_INDEX_STRIDE,
+                            self._count, index_offset, index_count,
+                            self._t_first, self._t_last)
+
+    def append(self, pack_frame: bytes, module_frames: Dict[int, bytes],
+               t_ms: Optional[int] = None):
+        """Record one cycle: the pack frame and the module frames sent.
+
+        t_ms defaults to milliseconds since the writer was opened.
+        """
+        if t_ms is None:
+            t_ms = int((time.monotonic() - self._t0) * 1000)
+        t_ms = max(t_ms, self._t_last) & 0xFFFFFFFF  # Never backwards
+
+        if self._count % CAPTURE_INDEX_STRIDE == 0:
+            self._index.append((t_ms, self._count))
+        if self._count == 0:
+            self._t_first = t_ms
+        self._t_last = t_ms
+
+        rec = bytearray(struct.pack('<II', t_ms, 0))
+        rec += pack_frame[:PACK_FRAME_SIZE]
+        for m in range(NUM_MODULES):
+            frame = module_frames.get(m, b'')[:MODULE_FRAME_SIZE]
+            rec += frame.ljust(MODULE_FRAME_SIZE, b'\x00')
+        self._f.write(rec)
+        self._count += 1
+
+    def close(self):
+        """Write the index and the final header."""
+        if self._f is None:
+            return
+        end = self._f.tell()
+        pad = -end & 7  # Index on an 8-byte boundary
+        self._f.write(b'\x00' * pad)
+        for t_ms, record in self._index:
+            self._f.write(struct.pack('<IIQ', t_ms, 0, record))
+        self._f.seek(0)
+        self._f.write(self._header(end + pad, len(self._index)))
+        self._f.close()
+        self._f = None
@@ -24,7 +24,7 @@ from digital_twin.dashboard.app import init_dashboard, run_dashboard
 class DigitalTwinSimulator:
     """Main simulator orchestrator with thread-safe pack access."""
 
-    def __init__(self, use_serial=False, serial_port=None):
+    def __init__(self, use_serial=False, serial_port=None, capture=None):
         self.pack = BatteryPack()
         self.fault_engine = FaultInjectionEngine(self.pack)
         self.lock = threading.Lock()   # Protects pack state
@@ -33,7 +33,8 @@ class DigitalTwinSimulator:
         if use_serial:
             try:
                 from digital_twin.serial_bridge import SerialBridge
-                self.serial_bridge = SerialBridge(port=serial_port)
+                self.serial_bridge = SerialBridge(port=serial_port,
+                                                  capture=capture)
                 print(f"[Serial] Bridge initialized on {self.serial_bridge.port}")
             except Exception as e:
                 print(f"[Serial] Could not initialize: {e}")
@@ -106,11 +107,14 @@ def main():
                         help='Run without serial bridge')
     parser.add_argument('--port', type=str, default=None,
                         help='Serial port (e.g., COM3)')
+    parser.add_argument('--capture', type=str, default=None,
+                        help='Record the frames sent to a binary capture file')
     args = parser.parse_args()
 
     sim = DigitalTwinSimulator(
         use_serial=not args.no_serial,
         serial_port=args.port,
+        capture=args.capture,
     )
 
     def signal_handler(sig, frame):
@@ -10,6 +10,14 @@ Multi-frame protocol:
 
 Each frame: [0xBB][LEN][TYPE][payload][XOR_checksum]
 Total: 1 pack frame + 8 module frames = 9 frames per cycle
+
+framing='v2' sends the same payloads behind a CRC-16 and a cycle
+sequence number: the pack as its own v2 frame (so the board's current
+trip still fires before the modules arrive), then one module superframe.
+  [0xBC][LEN_LO][LEN_HI][TYPE][SEQ][payload or records][CRC16_LE]
+
+With capture=path, every cycle sent is also recorded as a binary
+capture (capture.py) for offline backtests on the host.
 """
 
 import struct
@@ -18,16 +26,21 @@ import serial.tools.list_ports
 import threading
 import queue
 import time
-from typing import Dict, Optional
+from typing import Dict, Iterable, Optional
 
+from digital_twin.capture import CaptureWriter
 from digital_twin.config import SERIAL_BAUD_RATE, NUM_MODULES, GROUPS_PER_MODULE
 
 # Protocol constants
 INPUT_SYNC = 0xBB
 PACK_FRAME_TYPE = 0x01
 MODULE_FRAME_TYPE = 0x02
-PACK_FRAME_SIZE = 30
-MODULE_FRAME_SIZE = 24
+PACK_FRAME_SIZE = 25    # must match sizeof(input_pack_frame_t)
+MODULE_FRAME_SIZE = 25  # must match sizeof(input_module_frame_t)
+
+# v2 framing (see input_packet.h)
+INPUT_SYNC_V2 = 0xBC
+SUPER_FRAME_TYPE = 0x10
 
 
 def _xor_checksum(data: bytes) -> int:
@@ -38,16 +51,38 @@ def _xor_checksum(data: bytes) -> int:
     return csum
 
 
+def _crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), as crc16.c."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        crc &= 0xFFFF
+    return crc
+
+
+def _v2_frame(frame_type: int, seq: int, body: bytes) -> bytes:
+    """Wrap a payload (or superframe records) in v2 framing."""
+    length = 7 + len(body)
+    head = struct.pack('<BHBB', INPUT_SYNC_V2, length, frame_type, seq & 0xFF)
+    crc = _crc16(head + body)
+    return head + body + struct.pack('<H', crc)
+
+
 class SerialBridge:
     """Encodes pack snapshot → multi-frame binary → serial port."""
 
-    def __init__(self, port: Optional[str] = None, baud: int = SERIAL_BAUD_RATE):
+    def __init__(self, port: Optional[str] = None, baud: int = SERIAL_BAUD_RATE,
+                 framing: str = 'v1', capture: Optional[str] = None):
         self.port = port or self._auto_detect_port()
         self.baud = baud
+        self.framing = framing  # 'v1' (XOR frames) or 'v2' (CRC-16)
+        self._seq = 0
         self.is_connected = False
         self._serial = None
         self._send_queue = queue.Queue(maxsize=10)
         self._thread = None
+        self._capture = CaptureWriter(capture) if capture else None
 
         if self.port:
             self._connect()
@@ -86,19 +121,42 @@ class SerialBridge:
             except queue.Full:
                 pass
 
-    def encode_all_frames(self, snapshot: Dict) -> bytes:
+    def encode_all_frames(self, snapshot: Dict,
+                          modules: Optional[Iterable[int]] = None) -> bytes:
         """Encode full 139-channel snapshot into 9 binary frames.
 
-        Returns concatenated bytes: 1 pack frame + 8 module frames.
+        Returns concatenated bytes: 1 pack frame + 8 module frames, or
+        with v2 framing one pack frame + one module superframe. With
+        `modules`, only those modules' frames follow the pack frame (the
+        board's rate request, see module_rate.h).
         """
+        if modules is None:
+            modules = range(NUM_MODULES)
+        if self.framing == 'v2':
+            return self.encode_v2_frames(snapshot, modules)
         frames = bytearray()
         frames.extend(self._encode_pack_frame(snapshot))
-        for m_idx in range(NUM_MODULES):
+        for m_idx in modules:
             frames.extend(self._encode_module_frame(snapshot, m_idx))
         return bytes(frames)
 
+    def encode_v2_frames(self, snapshot: Dict,
+                         modules: Optional[Iterable[int]] = None) -> bytes:
+        """Encode one cycle as v2 frames sharing a sequence number."""
+        if modules is None:
+            modules = range(NUM_MODULES)
+        seq = self._seq
+        self._seq = (self._seq + 1) & 0xFF
+        pack = self._encode_pack_frame(snapshot)
+        records = bytearray()
+        for m_idx in modules:
+            mod = self._encode_module_frame(snapshot, m_idx)
+            records += bytes([MODULE_FRAME_TYPE, len(mod) - 4]) + mod[3:-1]
+        return (_v2_frame(PACK_FRAME_TYPE, seq, pack[3:-1]) +
+                _v2_frame(SUPER_FRAME_TYPE, seq, bytes(records)))
+
     def _encode_pack_frame(self, snapshot: Dict) -> bytes:
-        """Encode pack-level data into a 30-byte frame."""
+        """Encode pack-level data into a 25-byte frame."""
         # Pack voltage in deci-volts
         pack_v_dv = int(snapshot.get('pack_voltage', 332.8) * 10)
         # Pack current in deci-amps
@@ -120,13 +178,12 @@ class SerialBridge:
         # Isolation (MΩ × 10)
         iso_mohm = int(snapshot.get('isolation_mohm', 500.0) * 10)
 
-        payload = struct.pack('<HhhhhhHHhhBH',
+        payload = struct.pack('<HhhhhHHhhBH',
             pack_v_dv,       # uint16 pack voltage deci-V
             pack_i_da,       # int16  pack current deci-A
             ambient_dt,      # int16  ambient temp deci-°C
             coolant_in_dt,   # int16  coolant inlet deci-°C
             coolant_out_dt,  # int16  coolant outlet deci-°C
-            0,               # int16  reserved
             gas1_cp,         # uint16 gas ratio 1 ×100
             gas2_cp,         # uint16 gas ratio 2 ×100
             p1_chpa,         # int16  pressure Δ1 centi-hPa
@@ -142,7 +199,7 @@ class SerialBridge:
         return frame_no_csum + struct.pack('B', csum)
 
     def _encode_module_frame(self, snapshot: Dict, module_idx: int) -> bytes:
-        """Encode per-module data into a 24-byte frame."""
+        """Encode per-module data into a 25-byte frame."""
         modules = snapshot.get('modules', [])
         if module_idx < len(modules):
             mdata = modules[module_idx]
@@ -207,6 +264,8 @@ class SerialBridge:
                 frames = self.encode_all_frames(snapshot)
                 if self._serial and self._serial.is_open:
                     self._serial.write(frames)
+                    if self._capture:
+                        self._record(snapshot)
             except queue.Empty:
                 continue
             except Exception as e:
@@ -214,9 +273,19 @@ class SerialBridge:
                 self.is_connected = False
                 break
 
+    def _record(self, snapshot: Dict):
+        """Append the cycle just sent to the capture file."""
+        modules = {m: self._encode_module_frame(snapshot, m)
+                   for m in range(NUM_MODULES)}
+        self._capture.append(self._encode_pack_frame(snapshot), modules)
+
     def close(self):
         """Close serial connection."""
         self.is_connected = False
+        if self._thread:
+            self._thread.join(timeout=2.0)  # No record after the close
+        if self._capture:
+            self._capture.close()
         if self._serial:
             try:
                 self._serial.close()